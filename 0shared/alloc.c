@@ -0,0 +1,52 @@
+/*--------------------------------------------------------------------*/
+/* alloc.c                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "alloc.h"
+
+/*--------------------------------------------------------------------*/
+
+void *Alloc_malloc(Alloc_T oAAlloc, size_t ulSize) {
+   if(oAAlloc == NULL)
+      return malloc(ulSize);
+   return (*oAAlloc->pfAlloc)(oAAlloc->pvState, ulSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Alloc_calloc(Alloc_T oAAlloc, size_t ulCount, size_t ulSize) {
+   void *pvBlock;
+
+   if(oAAlloc == NULL)
+      return calloc(ulCount, ulSize);
+   if(ulSize != 0 && ulCount > (size_t) -1 / ulSize)
+      return NULL;
+   pvBlock = (*oAAlloc->pfAlloc)(oAAlloc->pvState, ulCount * ulSize);
+   if(pvBlock != NULL)
+      memset(pvBlock, 0, ulCount * ulSize);
+   return pvBlock;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Alloc_realloc(Alloc_T oAAlloc, void *pvBlock, size_t ulOldSize,
+                    size_t ulNewSize) {
+   if(oAAlloc == NULL)
+      return realloc(pvBlock, ulNewSize);
+   return (*oAAlloc->pfRealloc)(oAAlloc->pvState, pvBlock, ulOldSize,
+                                ulNewSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Alloc_free(Alloc_T oAAlloc, void *pvBlock, size_t ulSize) {
+   if(pvBlock == NULL)
+      return;
+   if(oAAlloc == NULL)
+      free(pvBlock);
+   else
+      (*oAAlloc->pfFree)(oAAlloc->pvState, pvBlock, ulSize);
+}
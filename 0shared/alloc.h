@@ -0,0 +1,54 @@
+/*--------------------------------------------------------------------*/
+/* alloc.h                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef ALLOC_INCLUDED
+#define ALLOC_INCLUDED
+
+#include <stddef.h>
+
+/*
+  An allocator is a table of functions that hand out and take back
+  memory, with state passed to each of them. Blocks are given back
+  with the size they were requested at, so an allocator need not
+  record sizes itself. A NULL Alloc_T stands for malloc, realloc and
+  free.
+*/
+struct Alloc {
+   /* Returns a new block of ulSize bytes, or NULL */
+   void *(*pfAlloc)(void *pvState, size_t ulSize);
+
+   /* Resizes pvBlock from ulOldSize to ulNewSize bytes, keeping its
+      contents, and returns it (perhaps moved), or NULL leaving it */
+   void *(*pfRealloc)(void *pvState, void *pvBlock, size_t ulOldSize,
+                      size_t ulNewSize);
+
+   /* Takes back pvBlock of ulSize bytes */
+   void (*pfFree)(void *pvState, void *pvBlock, size_t ulSize);
+
+   /* Passed to each function */
+   void *pvState;
+};
+
+/* An Alloc_T is an allocator, or NULL for the C library's */
+typedef const struct Alloc *Alloc_T;
+
+/* Returns a new block of ulSize bytes from oAAlloc, or NULL if there
+   is not enough memory. */
+void *Alloc_malloc(Alloc_T oAAlloc, size_t ulSize);
+
+/* Returns a new zeroed block of ulCount elements of ulSize bytes from
+   oAAlloc, or NULL if there is not enough memory. */
+void *Alloc_calloc(Alloc_T oAAlloc, size_t ulCount, size_t ulSize);
+
+/* Resizes pvBlock, from oAAlloc, from ulOldSize to ulNewSize bytes,
+   as realloc would. */
+void *Alloc_realloc(Alloc_T oAAlloc, void *pvBlock, size_t ulOldSize,
+                    size_t ulNewSize);
+
+/* Gives pvBlock, ulSize bytes from oAAlloc, back to it. pvBlock may
+   be NULL. */
+void Alloc_free(Alloc_T oAAlloc, void *pvBlock, size_t ulSize);
+
+#endif
@@ -4,8 +4,10 @@
 /*--------------------------------------------------------------------*/
 
 #include "dynarray.h"
+#include "alloc.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -30,6 +32,9 @@ struct DynArray
 
    /* The array that underlies the DynArray. */
    const void **ppvArray;
+
+   /* The allocator that the DynArray and its array came from. */
+   Alloc_T oAAlloc;
 };
 
 /*--------------------------------------------------------------------*/
@@ -66,7 +71,9 @@ static int DynArray_grow(DynArray_T oDynArray)
    uNewLength = GROWTH_FACTOR * oDynArray->uPhysLength;
 
    ppvNewArray = (const void**)
-      realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
+      Alloc_realloc(oDynArray->oAAlloc, oDynArray->ppvArray,
+                    sizeof(void*) * oDynArray->uPhysLength,
+                    sizeof(void*) * uNewLength);
    if (ppvNewArray == NULL)
       return 0;
 
@@ -78,10 +85,18 @@ static int DynArray_grow(DynArray_T oDynArray)
 /*--------------------------------------------------------------------*/
 
 DynArray_T DynArray_new(size_t uLength)
+{
+   return DynArray_newWith(uLength, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+DynArray_T DynArray_newWith(size_t uLength, Alloc_T oAAlloc)
 {
    DynArray_T oDynArray;
 
-   oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
+   oDynArray = (struct DynArray*)
+      Alloc_malloc(oAAlloc, sizeof(struct DynArray));
    if (oDynArray == NULL)
       return NULL;
 
@@ -91,11 +106,12 @@ DynArray_T DynArray_new(size_t uLength)
    else
       oDynArray->uPhysLength = MIN_PHYS_LENGTH;
 
-   oDynArray->ppvArray =
-      (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
+   oDynArray->oAAlloc = oAAlloc;
+   oDynArray->ppvArray = (const void**)
+      Alloc_calloc(oAAlloc, oDynArray->uPhysLength, sizeof(void*));
    if (oDynArray->ppvArray == NULL)
    {
-      free(oDynArray);
+      Alloc_free(oAAlloc, oDynArray, sizeof(struct DynArray));
       return NULL;
    }
 
@@ -109,8 +125,9 @@ void DynArray_free(DynArray_T oDynArray)
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   free(oDynArray->ppvArray);
-   free(oDynArray);
+   Alloc_free(oDynArray->oAAlloc, oDynArray->ppvArray,
+              sizeof(void*) * oDynArray->uPhysLength);
+   Alloc_free(oDynArray->oAAlloc, oDynArray, sizeof(struct DynArray));
 }
 
 /*--------------------------------------------------------------------*/
@@ -223,6 +240,83 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
 
 /*--------------------------------------------------------------------*/
 
+int DynArray_reserve(DynArray_T oDynArray, size_t uLength)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   while (oDynArray->uPhysLength < uLength)
+      if (! DynArray_grow(oDynArray))
+         return 0;
+
+   assert(DynArray_isValid(oDynArray));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_merge(DynArray_T oDest, DynArray_T oSource,
+                   int (*pfCompare)(const void *pvElement1,
+                                    const void *pvElement2))
+{
+   size_t uDest;
+   size_t uSource;
+   size_t u;
+   size_t uLow;
+   size_t uHigh;
+   size_t uMid;
+
+   assert(oDest != NULL);
+   assert(oSource != NULL);
+   assert(oDest != oSource);
+   assert(pfCompare != NULL);
+   assert(DynArray_isValid(oDest));
+   assert(DynArray_isValid(oSource));
+
+   if (! DynArray_reserve(oDest, oDest->uLength + oSource->uLength))
+      return 0;
+
+   /* Fill oDest from the back, so that no element is overwritten
+      before it is moved.  Each source element is placed by a binary
+      search of the dest elements not yet moved, which then move in
+      one block, so that a few source elements merged into many dest
+      elements cost few comparisons. */
+   uDest = oDest->uLength;
+   uSource = oSource->uLength;
+   u = uDest + uSource;
+   while (uSource > 0)
+   {
+      uSource--;
+      uLow = 0;
+      uHigh = uDest;
+      while (uLow < uHigh)
+      {
+         uMid = uLow + (uHigh - uLow) / 2;
+         if ((*pfCompare)(oDest->ppvArray[uMid],
+                          oSource->ppvArray[uSource]) > 0)
+            uHigh = uMid;
+         else
+            uLow = uMid + 1;
+      }
+      u -= uDest - uLow;
+      memmove(&oDest->ppvArray[u], &oDest->ppvArray[uLow],
+              (uDest - uLow) * sizeof(void*));
+      uDest = uLow;
+      oDest->ppvArray[--u] = oSource->ppvArray[uSource];
+   }
+
+   oDest->uLength += oSource->uLength;
+   oSource->uLength = 0;
+
+   assert(DynArray_isValid(oDest));
+   assert(DynArray_isValid(oSource));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
 void DynArray_toArray(DynArray_T oDynArray, void **ppvArray)
 {
    size_t u;
@@ -7,6 +7,7 @@
 #define DYNARRAY_INCLUDED
 
 #include <stddef.h>
+#include "alloc.h"
 
 /* A DynArray_T object is an array whose length can expand
    dynamically. */
@@ -22,6 +23,14 @@ DynArray_T DynArray_new(size_t uLength);
 
 /*--------------------------------------------------------------------*/
 
+/* Return a new DynArray_T object whose length is uLength, taking its
+   memory from oAAlloc (NULL for malloc), or NULL if insufficient
+   memory is available. */
+
+DynArray_T DynArray_newWith(size_t uLength, Alloc_T oAAlloc);
+
+/*--------------------------------------------------------------------*/
+
 /* Free oDynArray. */
 
 void DynArray_free(DynArray_T oDynArray);
@@ -71,6 +80,28 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex);
 
 /*--------------------------------------------------------------------*/
 
+/* Make room in oDynArray for at least uLength elements, so that adding
+   elements up to that length needs no memory.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+int DynArray_reserve(DynArray_T oDynArray, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Merge the elements of oSource into oDest, leaving oSource empty.
+   Both must be sorted as determined by *pfCompare, which is as for
+   DynArray_sort, and oDest stays so; an element of oSource goes after
+   any equal elements of oDest.  Return 1 (TRUE) if successful, or 0
+   (FALSE), leaving both unchanged, if insufficient memory is
+   available, which cannot happen if oDest has room for both (see
+   DynArray_reserve). */
+
+int DynArray_merge(DynArray_T oDest, DynArray_T oSource,
+                   int (*pfCompare)(const void *pvElement1,
+                                    const void *pvElement2));
+
+/*--------------------------------------------------------------------*/
+
 /* Fill ppvArray with the elements of oDynArray.  ppvArray must point
    to an area of memory that is large enough to hold all elements of
    oDynArray. */
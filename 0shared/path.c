@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "alloc.h"
 #include "dynarray.h"
 #include "path.h"
 
@@ -19,21 +20,25 @@ struct path {
    size_t ulLength;
    /* The ordered collection of component strings in the path */
    DynArray_T oDComponents;
+   /* The allocator that the path's memory came from */
+   Alloc_T oAAlloc;
 };
 
 /*
-  Frees pcStr. This wrapper is used to match the requirements of the
-  callback function pointer passed to DynArray_map. pvExtra is unused.
+  Frees pcStr back to allocator pvExtra. This wrapper is used to match
+  the requirements of the callback function pointer passed to
+  DynArray_map.
 */
 static void Path_freeString(char *pcStr, void *pvExtra) {
    /* pcStr may be NULL, as this is a no-op to free.
-      pvExtra may be NULL, as it is unused. */
-   free(pcStr);
+      pvExtra may be NULL, for malloc. */
+   if(pcStr != NULL)
+      Alloc_free((Alloc_T) pvExtra, pcStr, strlen(pcStr) + 1);
 }
 
 /*
   Sets *poDComponents to be an ordered collection of component strings
-  in pcPath, or NULL if an error occurs.
+  in pcPath, allocated from oAAlloc, or NULL if an error occurs.
   Returns one of the following statuses:
   * SUCCESS if no error occurrs
   * BAD_PATH if pcPath is the empty string,
@@ -41,7 +46,8 @@ static void Path_freeString(char *pcStr, void *pvExtra) {
              or contains consecutive '/' delimiters
   * MEMORY_ERROR if memory could not be allocated to complete request
 */
-static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
+static int Path_split(const char *pcPath, Alloc_T oAAlloc,
+                      DynArray_T *poDComponents) {
    const char *pcStart = pcPath;
    const char *pcEnd = pcPath;
    char *pcCopy;
@@ -56,7 +62,7 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
       return BAD_PATH;
    }
 
-   oDSubstrings = DynArray_new(0);
+   oDSubstrings = DynArray_newWith(0, oAAlloc);
    if(oDSubstrings == NULL) {
       *poDComponents = NULL;
       return MEMORY_ERROR;
@@ -68,7 +74,8 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
       /* component can't start with delimiter */
       if(*pcEnd == '/') {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeString,
+                      oAAlloc);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return BAD_PATH;
@@ -81,16 +88,19 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
       /* final component can't end with slash */
       if(*pcEnd == '\0' && *(pcEnd-1) == '/') {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeString,
+                      oAAlloc);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return BAD_PATH;
       }
 
-      pcCopy = calloc((size_t)(pcEnd-pcStart+1), sizeof(char));
+      pcCopy = Alloc_calloc(oAAlloc, (size_t)(pcEnd-pcStart+1),
+                            sizeof(char));
       if(pcCopy == NULL) {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeString,
+                      oAAlloc);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return MEMORY_ERROR;
@@ -98,7 +108,8 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
 
       if( DynArray_add(oDSubstrings, pcCopy) == 0) {
          DynArray_map(oDSubstrings,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeString,
+                      oAAlloc);
          DynArray_free(oDSubstrings);
          *poDComponents = NULL;
          return MEMORY_ERROR;
@@ -119,20 +130,26 @@ static int Path_split(const char *pcPath, DynArray_T *poDComponents) {
 
 
 int Path_new(const char *pcPath, Path_T *poPResult) {
+   return Path_newWith(pcPath, NULL, poPResult);
+}
+
+int Path_newWith(const char *pcPath, Alloc_T oAAlloc,
+                 Path_T *poPResult) {
    struct path *psNew;
    int iSplitResult;
 
    assert(pcPath != NULL);
    assert(poPResult != NULL);
 
-   psNew = calloc(1, sizeof(struct path));
+   psNew = Alloc_calloc(oAAlloc, 1, sizeof(struct path));
    if(psNew == NULL) {
       *poPResult = NULL;
       return MEMORY_ERROR;
    }
+   psNew->oAAlloc = oAAlloc;
 
    /* instantiate and fill list of components */
-   iSplitResult = Path_split(pcPath, &psNew->oDComponents);
+   iSplitResult = Path_split(pcPath, oAAlloc, &psNew->oDComponents);
    if(iSplitResult != SUCCESS) {
       Path_free(psNew);
       *poPResult = NULL;
@@ -140,7 +157,7 @@ int Path_new(const char *pcPath, Path_T *poPResult) {
    }
 
    psNew->ulLength = strlen(pcPath);
-   psNew->pcPath = malloc(psNew->ulLength+1);
+   psNew->pcPath = Alloc_malloc(oAAlloc, psNew->ulLength+1);
    if(psNew->pcPath == NULL) {
       Path_free(psNew);
       *poPResult = NULL;
@@ -154,6 +171,7 @@ int Path_new(const char *pcPath, Path_T *poPResult) {
 
 int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
    struct path *psNew;
+   Alloc_T oAAlloc;
    size_t ulIndex, ulLength, ulSum;
    const char *pcComponent;
    char *pcCopy;
@@ -175,20 +193,24 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
       return NO_SUCH_PATH;
    }
 
-   psNew = calloc(1, sizeof(struct path));
+   /* the prefix comes from the same allocator as oPPath */
+   oAAlloc = oPPath->oAAlloc;
+   psNew = Alloc_calloc(oAAlloc, 1, sizeof(struct path));
    if(psNew == NULL) {
       *poPResult = NULL;
       return MEMORY_ERROR;
    }
+   psNew->oAAlloc = oAAlloc;
 
-   psNew->oDComponents = DynArray_new(ulDepth);
+   psNew->oDComponents = DynArray_newWith(ulDepth, oAAlloc);
    if(psNew->oDComponents == NULL) {
       Path_free(psNew);
       *poPResult = NULL;
       return MEMORY_ERROR;
    }
 
-   pcBuild = calloc(Path_getStrLength(oPPath)+1, sizeof(char));
+   pcBuild = Alloc_calloc(oAAlloc, Path_getStrLength(oPPath)+1,
+                          sizeof(char));
    if(pcBuild == NULL) {
       Path_free(psNew);
       *poPResult = NULL;
@@ -202,9 +224,9 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
       /* deep copy each component to new DynArray */
       pcComponent = Path_getComponent(oPPath, ulIndex);
       ulLength = strlen(pcComponent);
-      pcCopy = calloc(ulLength + 1, sizeof(char));
+      pcCopy = Alloc_calloc(oAAlloc, ulLength + 1, sizeof(char));
       if(pcCopy == NULL) {
-         free(pcBuild);
+         Alloc_free(oAAlloc, pcBuild, Path_getStrLength(oPPath)+1);
          Path_free(psNew);
          *poPResult = NULL;
          return MEMORY_ERROR;
@@ -220,9 +242,10 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult) {
    pcBuild[ulSum-1] = '\0';
 
    /* shrink allocation to fit prefix's pathname string if needed */
-   pcInsert = realloc(pcBuild, ulSum);
+   pcInsert = Alloc_realloc(oAAlloc, pcBuild,
+                            Path_getStrLength(oPPath)+1, ulSum);
    if(pcInsert == NULL) {
-      free(pcBuild);
+      Alloc_free(oAAlloc, pcBuild, Path_getStrLength(oPPath)+1);
       Path_free(psNew);
       *poPResult = NULL;
       return MEMORY_ERROR;
@@ -243,15 +266,24 @@ int Path_dup(Path_T oPPath, Path_T *poPResult) {
 
 void Path_free(Path_T oPPath) {
    if(oPPath != NULL) {
-      free((char *)oPPath->pcPath);
+      Alloc_free(oPPath->oAAlloc, (char *)oPPath->pcPath,
+                 oPPath->ulLength+1);
 
       if(oPPath->oDComponents != NULL) {
          DynArray_map(oPPath->oDComponents,
-                      (void (*)(void*, void*)) Path_freeString, NULL);
+                      (void (*)(void*, void*)) Path_freeString,
+                      oPPath->oAAlloc);
          DynArray_free(oPPath->oDComponents);
       }
+      Alloc_free(oPPath->oAAlloc, (struct path*) oPPath,
+                 sizeof(struct path));
    }
-   free((struct path*) oPPath);
+}
+
+Alloc_T Path_getAlloc(Path_T oPPath) {
+   assert(oPPath != NULL);
+
+   return oPPath->oAAlloc;
 }
 
 const char *Path_getPathname(Path_T oPPath) {
@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "alloc.h"
 
 /* An object representing an absolute path in a tree */
 typedef const struct path * Path_T;
@@ -23,6 +24,14 @@ typedef const struct path * Path_T;
 */
 int Path_new(const char *pcPath, Path_T *poPResult);
 
+/*
+  Like Path_new, but takes the path's memory from oAAlloc (NULL for
+  malloc). Paths made from it by Path_dup and Path_prefix come from
+  oAAlloc as well.
+*/
+int Path_newWith(const char *pcPath, Alloc_T oAAlloc,
+                 Path_T *poPResult);
+
 /*
   Creates a "deep copy" of oPPath, duplicating all its contents.
   Returns an int SUCCESS status and sets *poPResult to be the new path
@@ -46,6 +55,9 @@ int Path_prefix(Path_T oPPath, size_t ulDepth, Path_T *poPResult);
 /* Destroys and frees all memory allocated for oPPath. */
 void Path_free(Path_T oPPath);
 
+/* Returns the allocator oPPath's memory came from (NULL for malloc). */
+Alloc_T Path_getAlloc(Path_T oPPath);
+
 /* Returns the string representation of the absolute path oPPath. */
 const char *Path_getPathname(Path_T oPPath);
 
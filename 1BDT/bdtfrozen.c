@@ -0,0 +1,343 @@
+/*--------------------------------------------------------------------*/
+/* bdtfrozen.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+#include "bdt.h"
+#include "bdtfrozen.h"
+
+/*
+  A directory in a frozen BDT: 16 bytes, so four share a 64-byte cache
+  line. A walk compares only the hashes of components on the way down,
+  and checks the pathname of the directory it ends at once; siblings
+  never share a hash, so the walk has only one way to go.
+*/
+struct bdtFrozenNode {
+   /* Hash of the directory's last component */
+   unsigned int uHash;
+
+   /* Offset of its pathname, a line of the BDT_toString text */
+   unsigned int uPathOff;
+
+   /* Its children's records, or 0 (the root's record) if absent */
+   unsigned int auChildren[2];
+};
+
+/* A frozen BDT */
+struct bdtFrozen {
+   /* The records, the root's first, in van Emde Boas order */
+   struct bdtFrozenNode *psNodes;
+   size_t ulNumNodes;
+
+   /* The BDT_toString text, which holds every pathname */
+   char *pcText;
+
+   /* Seed of the component hash */
+   unsigned long ulSeed;
+};
+
+/* A frozen BDT being built from its text, whose lines are numbered in
+   the order they come, which is pre-order */
+struct frozenBuilder {
+   /* Offset of each line and its number of characters */
+   size_t *pulLineOff;
+   size_t *pulLineLen;
+
+   /* The line numbers of each line's children, 0 if absent */
+   size_t *pulChildren;
+
+   /* The number of levels in the subtree below each line */
+   size_t *pulHeight;
+
+   /* The record each line gets, and how many have been handed out */
+   size_t *pulRecord;
+   size_t ulNextRecord;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the hash under ulSeed of the ulLength characters at pcName:
+   32-bit FNV-1a. */
+static unsigned int BDTFrozen_hash(const char *pcName, size_t ulLength,
+                                   unsigned long ulSeed) {
+   unsigned long ulHash = 2166136261UL ^ ulSeed;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++)
+      ulHash = ((ulHash ^ (unsigned char) pcName[i]) * 16777619UL) &
+               0xffffffffUL;
+   return (unsigned int) ulHash;
+}
+
+/* Returns the hash under ulSeed of the last component of the ulLength
+   characters of pathname pcPath. */
+static unsigned int BDTFrozen_hashLast(const char *pcPath,
+                                       size_t ulLength,
+                                       unsigned long ulSeed) {
+   size_t ulStart = ulLength;
+
+   while(ulStart > 0 && pcPath[ulStart - 1] != '/')
+      ulStart--;
+   return BDTFrozen_hash(pcPath + ulStart, ulLength - ulStart, ulSeed);
+}
+
+/* Hands out records to the subtree of line ulLine in van Emde Boas
+   order over ulLevels levels: the top half of the levels first, then
+   each subtree hanging below them, left to right. */
+static void BDTFrozen_layout(struct frozenBuilder *psBuilder,
+                             size_t ulLine, size_t ulLevels);
+
+/* Lays out, over ulLevels levels each, the subtrees rooted ulDepth
+   levels below line ulLine, left to right. */
+static void BDTFrozen_layoutBelow(struct frozenBuilder *psBuilder,
+                                  size_t ulLine, size_t ulDepth,
+                                  size_t ulLevels) {
+   size_t ulChild, i;
+
+   if(ulDepth == 0) {
+      BDTFrozen_layout(psBuilder, ulLine, ulLevels);
+      return;
+   }
+   for(i = 0; i < 2; i++) {
+      ulChild = psBuilder->pulChildren[2 * ulLine + i];
+      if(ulChild != 0)
+         BDTFrozen_layoutBelow(psBuilder, ulChild, ulDepth - 1, ulLevels);
+   }
+}
+
+static void BDTFrozen_layout(struct frozenBuilder *psBuilder,
+                             size_t ulLine, size_t ulLevels) {
+   size_t ulTop;
+
+   assert(psBuilder != NULL);
+
+   /* Nothing lies deeper than the subtree's own height */
+   if(ulLevels > psBuilder->pulHeight[ulLine])
+      ulLevels = psBuilder->pulHeight[ulLine];
+   if(ulLevels == 1) {
+      psBuilder->pulRecord[ulLine] = psBuilder->ulNextRecord++;
+      return;
+   }
+   ulTop = ulLevels / 2;
+   BDTFrozen_layout(psBuilder, ulLine, ulTop);
+   BDTFrozen_layoutBelow(psBuilder, ulLine, ulTop, ulLevels - ulTop);
+}
+
+/* Splits pcText into psBuilder's lines and links each line to its
+   children. Returns FALSE if a line has a third child or does not
+   hang below the line before it. */
+static boolean BDTFrozen_parse(struct frozenBuilder *psBuilder,
+                               const char *pcText, size_t ulNumLines,
+                               size_t *pulStack) {
+   size_t ulLine, ulOff = 0, ulDepth, ulLastDepth = 0, ulParent, i;
+
+   for(ulLine = 0; ulLine < ulNumLines; ulLine++) {
+      psBuilder->pulLineOff[ulLine] = ulOff;
+      psBuilder->pulLineLen[ulLine] = strcspn(pcText + ulOff, "\n");
+      ulOff += psBuilder->pulLineLen[ulLine] + 1;
+
+      /* Keep on the stack only the line's ancestors */
+      ulDepth = 1;
+      for(i = psBuilder->pulLineOff[ulLine]; i < ulOff - 1; i++)
+         ulDepth += (pcText[i] == '/');
+      if(ulDepth > ulLastDepth + 1 || (ulLine != 0 && ulDepth == 1))
+         return FALSE;
+      ulLastDepth = ulDepth;
+      pulStack[ulDepth - 1] = ulLine;
+      if(ulDepth == 1)
+         continue;
+
+      ulParent = pulStack[ulDepth - 2];
+      if(psBuilder->pulChildren[2 * ulParent] == 0)
+         psBuilder->pulChildren[2 * ulParent] = ulLine;
+      else if(psBuilder->pulChildren[2 * ulParent + 1] == 0)
+         psBuilder->pulChildren[2 * ulParent + 1] = ulLine;
+      else
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/* ================================================================== */
+int BDTFrozen_build(BDTFrozen_T *poBResult) {
+   BDTFrozen_T oBFrozen;
+   struct frozenBuilder sBuilder;
+   struct bdtFrozenNode *psNode;
+   size_t *pulStack;
+   size_t ulNumLines = 0, ulLine, ulFirst, ulSecond, i;
+   unsigned int *puHashes;
+   unsigned long ulSeed;
+   boolean bDistinct;
+   char *pcText;
+   int iStatus = SUCCESS;
+
+   assert(poBResult != NULL);
+
+   *poBResult = NULL;
+   pcText = BDT_toString();
+   if(pcText == NULL)
+      return INITIALIZATION_ERROR;
+   for(i = 0; pcText[i] != '\0'; i++)
+      ulNumLines += (pcText[i] == '\n');
+
+   /* Records hold 32-bit offsets and indices */
+   oBFrozen = malloc(sizeof(struct bdtFrozen));
+   sBuilder.pulLineOff = malloc(ulNumLines * sizeof(size_t) + 1);
+   sBuilder.pulLineLen = malloc(ulNumLines * sizeof(size_t) + 1);
+   sBuilder.pulChildren = calloc(2 * ulNumLines + 1, sizeof(size_t));
+   sBuilder.pulHeight = malloc(ulNumLines * sizeof(size_t) + 1);
+   sBuilder.pulRecord = malloc(ulNumLines * sizeof(size_t) + 1);
+   pulStack = malloc(ulNumLines * sizeof(size_t) + 1);
+   puHashes = malloc(ulNumLines * sizeof(unsigned int) + 1);
+   if(oBFrozen != NULL)
+      oBFrozen->psNodes = malloc(ulNumLines *
+                                 sizeof(struct bdtFrozenNode) + 1);
+   if(oBFrozen == NULL || oBFrozen->psNodes == NULL ||
+      sBuilder.pulLineOff == NULL || sBuilder.pulLineLen == NULL ||
+      sBuilder.pulChildren == NULL || sBuilder.pulHeight == NULL ||
+      sBuilder.pulRecord == NULL || pulStack == NULL ||
+      puHashes == NULL || i >= UINT_MAX)
+      iStatus = MEMORY_ERROR;
+   else if(!BDTFrozen_parse(&sBuilder, pcText, ulNumLines, pulStack))
+      iStatus = INITIALIZATION_ERROR;
+   free(pulStack);
+   if(iStatus != SUCCESS) {
+      if(oBFrozen != NULL)
+         free(oBFrozen->psNodes);
+      free(oBFrozen);
+      free(sBuilder.pulLineOff);
+      free(sBuilder.pulLineLen);
+      free(sBuilder.pulChildren);
+      free(sBuilder.pulHeight);
+      free(sBuilder.pulRecord);
+      free(puHashes);
+      free(pcText);
+      return iStatus;
+   }
+
+   /* Children follow their parents, so heights fill in backwards */
+   for(ulLine = ulNumLines; ulLine > 0; ulLine--) {
+      ulFirst = sBuilder.pulChildren[2 * (ulLine - 1)];
+      ulSecond = sBuilder.pulChildren[2 * (ulLine - 1) + 1];
+      sBuilder.pulHeight[ulLine - 1] = 1;
+      if(ulFirst != 0)
+         sBuilder.pulHeight[ulLine - 1] += sBuilder.pulHeight[ulFirst];
+      if(ulSecond != 0 &&
+         sBuilder.pulHeight[ulSecond] >= sBuilder.pulHeight[ulLine - 1])
+         sBuilder.pulHeight[ulLine - 1] = sBuilder.pulHeight[ulSecond] + 1;
+   }
+   sBuilder.ulNextRecord = 0;
+   if(ulNumLines != 0)
+      BDTFrozen_layout(&sBuilder, 0, sBuilder.pulHeight[0]);
+   assert(sBuilder.ulNextRecord == ulNumLines);
+
+   /* Find a seed under which no two siblings' components collide */
+   for(ulSeed = 0, bDistinct = FALSE; !bDistinct; ulSeed++) {
+      for(ulLine = 0; ulLine < ulNumLines; ulLine++)
+         puHashes[ulLine] = BDTFrozen_hashLast(
+            pcText + sBuilder.pulLineOff[ulLine],
+            sBuilder.pulLineLen[ulLine], ulSeed);
+      bDistinct = TRUE;
+      for(ulLine = 0; ulLine < ulNumLines && bDistinct; ulLine++) {
+         ulSecond = sBuilder.pulChildren[2 * ulLine + 1];
+         if(ulSecond != 0 &&
+            puHashes[sBuilder.pulChildren[2 * ulLine]] ==
+               puHashes[ulSecond])
+            bDistinct = FALSE;
+      }
+   }
+
+   for(ulLine = 0; ulLine < ulNumLines; ulLine++) {
+      psNode = &oBFrozen->psNodes[sBuilder.pulRecord[ulLine]];
+      psNode->uHash = puHashes[ulLine];
+      psNode->uPathOff = (unsigned int) sBuilder.pulLineOff[ulLine];
+      for(i = 0; i < 2; i++) {
+         ulFirst = sBuilder.pulChildren[2 * ulLine + i];
+         psNode->auChildren[i] = (ulFirst == 0) ? 0 :
+            (unsigned int) sBuilder.pulRecord[ulFirst];
+      }
+   }
+
+   free(sBuilder.pulLineOff);
+   free(sBuilder.pulLineLen);
+   free(sBuilder.pulChildren);
+   free(sBuilder.pulHeight);
+   free(sBuilder.pulRecord);
+   free(puHashes);
+
+   oBFrozen->ulNumNodes = ulNumLines;
+   oBFrozen->pcText = pcText;
+   oBFrozen->ulSeed = ulSeed - 1;
+   *poBResult = oBFrozen;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void BDTFrozen_free(BDTFrozen_T oBFrozen) {
+   assert(oBFrozen != NULL);
+
+   free(oBFrozen->psNodes);
+   free(oBFrozen->pcText);
+   free(oBFrozen);
+}
+
+/* ================================================================== */
+boolean BDTFrozen_contains(BDTFrozen_T oBFrozen, const char *pcPath) {
+   const struct bdtFrozenNode *psNodes;
+   const char *pcComponent;
+   const char *pcLine;
+   size_t ulLength, ulNode = 0, ulChild;
+   unsigned int uHash;
+
+   assert(oBFrozen != NULL);
+   assert(pcPath != NULL);
+
+   if(oBFrozen->ulNumNodes == 0)
+      return FALSE;
+   psNodes = oBFrozen->psNodes;
+
+   /* Follow the hashes down, root first */
+   pcComponent = pcPath;
+   ulLength = strcspn(pcComponent, "/");
+   if(BDTFrozen_hash(pcComponent, ulLength, oBFrozen->ulSeed) !=
+      psNodes[0].uHash)
+      return FALSE;
+   while(pcComponent[ulLength] == '/') {
+      pcComponent += ulLength + 1;
+      ulLength = strcspn(pcComponent, "/");
+      uHash = BDTFrozen_hash(pcComponent, ulLength, oBFrozen->ulSeed);
+
+      ulChild = psNodes[ulNode].auChildren[0];
+      if(ulChild == 0)
+         return FALSE;
+      if(psNodes[ulChild].uHash != uHash) {
+         ulChild = psNodes[ulNode].auChildren[1];
+         if(ulChild == 0 || psNodes[ulChild].uHash != uHash)
+            return FALSE;
+      }
+      ulNode = ulChild;
+   }
+
+   /* Then check the one pathname the hashes led to */
+   ulLength = (size_t) (pcComponent + ulLength - pcPath);
+   pcLine = oBFrozen->pcText + psNodes[ulNode].uPathOff;
+   return (boolean) (strncmp(pcLine, pcPath, ulLength) == 0 &&
+                     pcLine[ulLength] == '\n');
+}
+
+/* ================================================================== */
+char *BDTFrozen_toString(BDTFrozen_T oBFrozen) {
+   char *pcResult;
+
+   assert(oBFrozen != NULL);
+
+   pcResult = malloc(strlen(oBFrozen->pcText) + 1);
+   if(pcResult == NULL)
+      return NULL;
+   strcpy(pcResult, oBFrozen->pcText);
+   return pcResult;
+}
@@ -0,0 +1,50 @@
+/*--------------------------------------------------------------------*/
+/* bdtfrozen.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef BDTFROZEN_INCLUDED
+#define BDTFROZEN_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A frozen BDT is a read-only copy of the Binary Directory Tree laid
+  out for lookups: its directories are records in one array, in van
+  Emde Boas order, so that any root-to-leaf walk touches O(log_B n)
+  cache lines for every cache line size B. It is built through the
+  BDT's own interface and does not change when the BDT does.
+*/
+
+/* A BDTFrozen_T is a frozen copy of the BDT */
+typedef struct bdtFrozen *BDTFrozen_T;
+
+/*
+  Freezes the current contents of the BDT, which is left as it was.
+  Returns SUCCESS and sets *poBResult if successful. Otherwise, sets
+  *poBResult to NULL and returns:
+  * INITIALIZATION_ERROR if the BDT is not in an initialized state,
+                         its text could not be allocated, or its text
+                         is not that of a binary tree
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 or the tree is too large for 32-bit offsets
+*/
+int BDTFrozen_build(BDTFrozen_T *poBResult);
+
+/* Frees oBFrozen. */
+void BDTFrozen_free(BDTFrozen_T oBFrozen);
+
+/*
+  Returns TRUE if oBFrozen contains a directory with absolute path
+  pcPath and FALSE if not, as BDT_contains did when it was built.
+*/
+boolean BDTFrozen_contains(BDTFrozen_T oBFrozen, const char *pcPath);
+
+/*
+  Returns a copy of the BDT_toString text of oBFrozen's tree, owned by
+  the caller, or NULL if there is an allocation error.
+*/
+char *BDTFrozen_toString(BDTFrozen_T oBFrozen);
+
+#endif
@@ -0,0 +1,169 @@
+/*--------------------------------------------------------------------*/
+/* bdtfrozen_client.c                                                 */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  bdtfrozen_client checks the frozen BDT against the BDT it was built
+  from.
+
+  Usage: bdtfrozen_client [-r rounds] [-s seed]
+
+  Each round builds a random binary tree of up to MAX_DEPTH levels in
+  the BDT and freezes it. BDTFrozen_toString must give the BDT's text,
+  and BDTFrozen_contains must agree with BDT_contains on every path in
+  the tree and on paths near them: with the last character changed,
+  with a child added, and with the root renamed. Bad paths must not
+  be found. The frozen copy must then keep the paths the BDT loses
+  with a subtree.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bdt.h"
+#include "bdtfrozen.h"
+
+/* Deepest tree built, counting the root */
+enum { MAX_DEPTH = 10 };
+
+/* Longest path built or varied, including its terminator */
+enum { MAX_PATH = 8 * MAX_DEPTH + 8 };
+
+/* Most directories in a tree: a complete one of MAX_DEPTH levels */
+enum { MAX_NODES = (1 << MAX_DEPTH) - 1 };
+
+/* The paths in the current tree, in the order inserted */
+static char aacPaths[MAX_NODES][MAX_PATH];
+static size_t ulNumPaths;
+
+/*--------------------------------------------------------------------*/
+
+/* Inserts pcPath, of ulDepth levels, and below it a random subtree
+   of up to MAX_DEPTH levels in all, recording every path. */
+static void BDTFrozenClient_grow(char *pcPath, size_t ulDepth) {
+   size_t ulLength = strlen(pcPath);
+   int iChild;
+
+   assert(BDT_insert(pcPath) == SUCCESS);
+   assert(ulNumPaths < MAX_NODES);
+   strcpy(aacPaths[ulNumPaths++], pcPath);
+   if(ulDepth == MAX_DEPTH)
+      return;
+
+   /* Siblings differ, but may share prefixes and lengths */
+   for(iChild = 0; iChild < 2; iChild++)
+      if(rand() % 10 < 7) {
+         sprintf(pcPath + ulLength, "/%c%d", iChild == 0 ? 'l' : 'r',
+                 rand() % 100);
+         BDTFrozenClient_grow(pcPath, ulDepth + 1);
+         pcPath[ulLength] = '\0';
+      }
+}
+
+/* Checks that oBFrozen agrees with the BDT on pcPath. */
+static void BDTFrozenClient_agree(BDTFrozen_T oBFrozen,
+                                  const char *pcPath) {
+   assert(BDTFrozen_contains(oBFrozen, pcPath) == BDT_contains(pcPath));
+}
+
+/* Checks that oBFrozen agrees with the BDT on every recorded path and
+   on paths near it, and finds no bad path. */
+static void BDTFrozenClient_check(BDTFrozen_T oBFrozen) {
+   char acPath[MAX_PATH + 4];
+   char *pcString, *pcExpected;
+   size_t ulLength, i;
+
+   pcExpected = BDT_toString();
+   pcString = BDTFrozen_toString(oBFrozen);
+   assert(pcExpected != NULL && pcString != NULL);
+   assert(strcmp(pcString, pcExpected) == 0);
+   free(pcExpected);
+   free(pcString);
+
+   for(i = 0; i < ulNumPaths; i++) {
+      ulLength = strlen(aacPaths[i]);
+      assert(BDTFrozen_contains(oBFrozen, aacPaths[i]));
+
+      strcpy(acPath, aacPaths[i]);
+      acPath[ulLength - 1] ^= 1;
+      BDTFrozenClient_agree(oBFrozen, acPath);
+      strcpy(acPath, aacPaths[i]);
+      strcat(acPath, "/l1");
+      BDTFrozenClient_agree(oBFrozen, acPath);
+      strcpy(acPath, aacPaths[i]);
+      acPath[0] = 'R';
+      BDTFrozenClient_agree(oBFrozen, acPath);
+
+      sprintf(acPath, "/%s", aacPaths[i]);
+      assert(!BDTFrozen_contains(oBFrozen, acPath));
+      sprintf(acPath, "%s/", aacPaths[i]);
+      assert(!BDTFrozen_contains(oBFrozen, acPath));
+      sprintf(acPath, "r//%s", aacPaths[i] + 1);
+      assert(!BDTFrozen_contains(oBFrozen, acPath));
+   }
+   assert(!BDTFrozen_contains(oBFrozen, ""));
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 200, ulSeed = 1, r;
+   BDTFrozen_T oBFrozen;
+   char acPath[MAX_PATH];
+   char *pcString;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   /* Only an initialized BDT freezes; an empty one holds nothing */
+   oBFrozen = (BDTFrozen_T) acPath;
+   assert(BDTFrozen_build(&oBFrozen) == INITIALIZATION_ERROR);
+   assert(oBFrozen == NULL);
+   assert(BDT_init() == SUCCESS);
+   assert(BDTFrozen_build(&oBFrozen) == SUCCESS);
+   assert(!BDTFrozen_contains(oBFrozen, "r"));
+   pcString = BDTFrozen_toString(oBFrozen);
+   assert(pcString != NULL && strcmp(pcString, "") == 0);
+   free(pcString);
+   BDTFrozen_free(oBFrozen);
+
+   for(r = 0; r < ulRounds; r++) {
+      ulNumPaths = 0;
+      strcpy(acPath, "r");
+      BDTFrozenClient_grow(acPath, 1);
+      assert(BDTFrozen_build(&oBFrozen) == SUCCESS);
+      BDTFrozenClient_check(oBFrozen);
+
+      /* The frozen copy keeps what the BDT loses */
+      if(ulNumPaths > 1) {
+         assert(BDT_rm(aacPaths[1]) == SUCCESS);
+         assert(!BDT_contains(aacPaths[1]));
+         assert(BDTFrozen_contains(oBFrozen, aacPaths[1]));
+         assert(BDTFrozen_contains(oBFrozen,
+                                   aacPaths[ulNumPaths - 1]));
+      }
+      BDTFrozen_free(oBFrozen);
+      assert(BDT_destroy() == SUCCESS);
+      assert(BDT_init() == SUCCESS);
+   }
+   assert(BDT_destroy() == SUCCESS);
+
+   printf("%lu frozen trees matched the BDT\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+/*--------------------------------------------------------------------*/
+/* bdtfrozenbench.c                                                   */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  bdtfrozenbench times lookups in the frozen BDT against the BDT it
+  was built from.
+
+  Usage: bdtfrozenbench [-d depth] [-q lookups]
+
+  It inserts a complete binary tree of d levels, names its
+  directories' children "left" and "right" followed by a number,
+  freezes it, and looks up q random directories of it with
+  BDT_contains and then with BDTFrozen_contains, twice each so that
+  the second runs start warm. It reports the seconds the freeze took
+  and the microseconds per lookup of every run. The freeze reads the
+  tree through BDT_toString, which in bdtGood, as in the DT, appends
+  each line with strcat and so takes time quadratic in the size of
+  the tree: past 16 levels or so it dominates the run.
+*/
+
+/* clock_gettime is POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bdt.h"
+#include "bdtfrozen.h"
+
+/* Characters of a level's component: "/right" and up to 3 digits */
+enum { MAX_LEVEL = 10 };
+
+/* Runs of each kind of lookup */
+enum { NUM_RUNS = 2 };
+
+/* The paths in the tree, in the order inserted */
+static char **ppcPaths;
+static size_t ulNumPaths;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the current time in seconds from an arbitrary start. */
+static double BDTFrozenBench_now(void) {
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double) sNow.tv_sec + (double) sNow.tv_nsec / 1e9;
+}
+
+/* Returns the next value of the generator whose state is *pulState. */
+static unsigned long BDTFrozenBench_random(unsigned long *pulState) {
+   *pulState = (*pulState * 1103515245UL + 12345UL) & 0xffffffffUL;
+   return *pulState >> 8;
+}
+
+/* Inserts pcPath, at level ulLevel of ulDepth, and the complete tree
+   below it, recording every path. Returns FALSE if a call fails, TRUE
+   otherwise. */
+static boolean BDTFrozenBench_grow(char *pcPath, size_t ulLevel,
+                                   size_t ulDepth) {
+   size_t ulLength = strlen(pcPath);
+
+   if(BDT_insert(pcPath) != SUCCESS)
+      return FALSE;
+   ppcPaths[ulNumPaths] = malloc(ulLength + 1);
+   if(ppcPaths[ulNumPaths] == NULL)
+      return FALSE;
+   strcpy(ppcPaths[ulNumPaths++], pcPath);
+   if(ulLevel == ulDepth)
+      return TRUE;
+
+   sprintf(pcPath + ulLength, "/left%lu",
+           (unsigned long) ulNumPaths % 1000);
+   if(!BDTFrozenBench_grow(pcPath, ulLevel + 1, ulDepth))
+      return FALSE;
+   sprintf(pcPath + ulLength, "/right%lu",
+           (unsigned long) ulNumPaths % 1000);
+   if(!BDTFrozenBench_grow(pcPath, ulLevel + 1, ulDepth))
+      return FALSE;
+   pcPath[ulLength] = '\0';
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulDepth = 15, ulLookups = 1000000, ulHits = 0, i;
+   size_t *pulQueries;
+   char *pcPath;
+   BDTFrozen_T oBFrozen;
+   unsigned long ulState = 1;
+   double dStart;
+   int iArg, iRun;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-d depth] [-q lookups]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      size_t ulValue = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+
+      if(strcmp(argv[iArg], "-d") == 0)
+         ulDepth = ulValue;
+      else if(strcmp(argv[iArg], "-q") == 0)
+         ulLookups = ulValue;
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   if(ulDepth == 0 || ulDepth > 30 || ulLookups == 0) {
+      fprintf(stderr, "%s: -d must be 1 to 30 and -q positive\n",
+              argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   ppcPaths = malloc((((size_t) 1 << ulDepth) - 1) * sizeof(char *));
+   pcPath = malloc(ulDepth * MAX_LEVEL + 1);
+   pulQueries = malloc(ulLookups * sizeof(size_t));
+   if(ppcPaths == NULL || pcPath == NULL || pulQueries == NULL)
+      return EXIT_FAILURE;
+   strcpy(pcPath, "root");
+   if(BDT_init() != SUCCESS || !BDTFrozenBench_grow(pcPath, 1, ulDepth)) {
+      fprintf(stderr, "%s: building the BDT failed\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(i = 0; i < ulLookups; i++)
+      pulQueries[i] = BDTFrozenBench_random(&ulState) % ulNumPaths;
+
+   dStart = BDTFrozenBench_now();
+   if(BDTFrozen_build(&oBFrozen) != SUCCESS)
+      return EXIT_FAILURE;
+   printf("%lu directories, frozen in %.3f s\n",
+          (unsigned long) ulNumPaths, BDTFrozenBench_now() - dStart);
+
+   for(iRun = 0; iRun < NUM_RUNS; iRun++) {
+      dStart = BDTFrozenBench_now();
+      for(i = 0; i < ulLookups; i++)
+         ulHits += BDT_contains(ppcPaths[pulQueries[i]]);
+      printf("BDT_contains:       %.3f us\n",
+             (BDTFrozenBench_now() - dStart) / (double) ulLookups * 1e6);
+
+      dStart = BDTFrozenBench_now();
+      for(i = 0; i < ulLookups; i++)
+         ulHits += BDTFrozen_contains(oBFrozen, ppcPaths[pulQueries[i]]);
+      printf("BDTFrozen_contains: %.3f us\n",
+             (BDTFrozenBench_now() - dStart) / (double) ulLookups * 1e6);
+   }
+   if(ulHits != 2 * NUM_RUNS * ulLookups) {
+      fprintf(stderr, "%s: %lu lookups missed\n", argv[0],
+              (unsigned long) (2 * NUM_RUNS * ulLookups - ulHits));
+      return EXIT_FAILURE;
+   }
+
+   BDTFrozen_free(oBFrozen);
+   if(BDT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulNumPaths; i++)
+      free(ppcPaths[i]);
+   free(ppcPaths);
+   free(pcPath);
+   free(pulQueries);
+   return EXIT_SUCCESS;
+}
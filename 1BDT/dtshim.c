@@ -0,0 +1,47 @@
+/*--------------------------------------------------------------------*/
+/* dtshim.c                                                           */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  The BDT interface of bdt.h over the Directory Tree of ../2DT, for
+  machines on which the prebuilt bdtGood.o does not link. The DT is
+  pointer-based like bdtGood, but lists siblings in lexicographic
+  order rather than in the order they were inserted; the frozen BDT,
+  rebuilt from the text, does not mind. The DT allows any number of
+  children, so BDT_insert does not refuse a third: callers must
+  insert binary trees only.
+*/
+
+#include "bdt.h"
+#include "dt.h"
+
+/* ================================================================== */
+int BDT_insert(const char *pcPath) {
+   return DT_insert(pcPath);
+}
+
+/* ================================================================== */
+boolean BDT_contains(const char *pcPath) {
+   return DT_contains(pcPath);
+}
+
+/* ================================================================== */
+int BDT_rm(const char *pcPath) {
+   return DT_rm(pcPath);
+}
+
+/* ================================================================== */
+int BDT_init(void) {
+   return DT_init();
+}
+
+/* ================================================================== */
+int BDT_destroy(void) {
+   return DT_destroy();
+}
+
+/* ================================================================== */
+char *BDT_toString(void) {
+   return DT_toString();
+}
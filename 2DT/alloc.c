@@ -0,0 +1 @@
+../0shared/alloc.c
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*--------------------------------------------------------------------*/
+/* chainbench.c                                                       */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  chainbench times the DT on deep runs of single-child directories,
+  and measures the heap they take.
+
+  Usage: chainbench [-n chains] [-d depth]
+
+  It inserts n paths r/cI/l2/l3/.../lD, each of them a run of d - 1
+  directories below the root with one child apiece, then looks up the
+  deepest directory of each with DT_contains. It reports the seconds
+  the inserts took, the microseconds per lookup, and the megabytes of
+  heap in use after the inserts, from mallinfo2. Build it with the
+  checker's assertions off, as its Makefile target does, or the
+  checker's walk of the whole tree dominates every call.
+*/
+
+/* clock_gettime is POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/* mallinfo2 is glibc's, not C90 */
+#include <malloc.h>
+#include "dt.h"
+
+/* Characters of a level's component, "/l" and up to 8 digits */
+enum { MAX_LEVEL = 11 };
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the current time in seconds from an arbitrary start. */
+static double ChainBench_now(void) {
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double) sNow.tv_sec + (double) sNow.tv_nsec / 1e9;
+}
+
+/* Writes into pcPath the deepest path of chain ulChain, ulDepth levels
+   deep counting the root. */
+static void ChainBench_path(char *pcPath, size_t ulChain,
+                            size_t ulDepth) {
+   size_t ulLevel;
+
+   pcPath += sprintf(pcPath, "r/c%lu", (unsigned long) ulChain);
+   for(ulLevel = 3; ulLevel <= ulDepth; ulLevel++)
+      pcPath += sprintf(pcPath, "/l%lu", (unsigned long) ulLevel);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulChains = 1000, ulDepth = 64, ulHits = 0, i;
+   size_t ulHeapBefore, ulHeapAfter;
+   char *pcPath;
+   double dStart, dInsert, dLookup;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-n chains] [-d depth]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      size_t ulValue = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+
+      if(strcmp(argv[iArg], "-n") == 0)
+         ulChains = ulValue;
+      else if(strcmp(argv[iArg], "-d") == 0)
+         ulDepth = ulValue;
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   if(ulChains == 0 || ulDepth < 2) {
+      fprintf(stderr, "%s: -n must be positive and -d at least 2\n",
+              argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   pcPath = malloc(ulDepth * MAX_LEVEL + 1);
+   if(pcPath == NULL)
+      return EXIT_FAILURE;
+
+   ulHeapBefore = mallinfo2().uordblks;
+   if(DT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   dStart = ChainBench_now();
+   for(i = 0; i < ulChains; i++) {
+      ChainBench_path(pcPath, i, ulDepth);
+      if(DT_insert(pcPath) != SUCCESS) {
+         fprintf(stderr, "%s: inserting %s failed\n", argv[0], pcPath);
+         return EXIT_FAILURE;
+      }
+   }
+   dInsert = ChainBench_now() - dStart;
+   ulHeapAfter = mallinfo2().uordblks;
+
+   dStart = ChainBench_now();
+   for(i = 0; i < ulChains; i++) {
+      ChainBench_path(pcPath, i, ulDepth);
+      ulHits += DT_contains(pcPath);
+   }
+   dLookup = ChainBench_now() - dStart;
+   if(ulHits != ulChains) {
+      fprintf(stderr, "%s: %lu of %lu paths not found\n", argv[0],
+              (unsigned long) (ulChains - ulHits),
+              (unsigned long) ulChains);
+      return EXIT_FAILURE;
+   }
+
+   printf("%lu chains of depth %lu\n", (unsigned long) ulChains,
+          (unsigned long) ulDepth);
+   printf("insert %.3f s, lookup %.2f us, heap %.1f MB\n", dInsert,
+          dLookup / (double) ulChains * 1e6,
+          (double) (ulHeapAfter - ulHeapBefore) / 1048576.0);
+
+   if(DT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+   free(pcPath);
+   return EXIT_SUCCESS;
+}
@@ -41,23 +41,26 @@ static size_t ulCount;
 /*
   Traverses the DT starting at the root as far as possible towards
   absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
-  Otherwise, sets *poNFurthest to NULL and returns with status:
+  status, sets *poNFurthest to the chain holding the furthest
+  directory reached (which may be only a prefix of oPPath, or even
+  NULL if the root is NULL) and sets *pulDepth to that directory's
+  depth. Otherwise, sets *poNFurthest to NULL and returns with status:
   * CONFLICTING_PATH if the root's path is not a prefix of oPPath
-  * MEMORY_ERROR if memory could not be allocated to complete request
 */
-static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
-   int iStatus;
-   Path_T oPPrefix = NULL;
+static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest,
+                           size_t *pulDepth) {
+   Path_T oPChain;
    Node_T oNCurr;
-   Node_T oNChild = NULL;
+   Node_T oNChild;
    size_t ulDepth;
+   size_t ulBottom;
    size_t i;
-   size_t ulChildID;
 
    assert(oPPath != NULL);
    assert(poNFurthest != NULL);
+   assert(pulDepth != NULL);
+
+   *pulDepth = 0;
 
    /* root is NULL -> won't find anything */
    if(oNRoot == NULL) {
@@ -65,54 +68,46 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
       return SUCCESS;
    }
 
-   iStatus = Path_prefix(oPPath, 1, &oPPrefix);
-   if(iStatus != SUCCESS) {
-      *poNFurthest = NULL;
-      return iStatus;
-   }
-
-   if(Path_comparePath(Node_getPath(oNRoot), oPPrefix)) {
-      Path_free(oPPrefix);
+   if(strcmp(Path_getComponent(Node_getPath(oNRoot), 0),
+             Path_getComponent(oPPath, 0))) {
       *poNFurthest = NULL;
       return CONFLICTING_PATH;
    }
-   Path_free(oPPrefix);
-   oPPrefix = NULL;
 
+   /* i is the depth reached so far; each chain is matched one
+      component at a time without building its prefixes */
    oNCurr = oNRoot;
    ulDepth = Path_getDepth(oPPath);
-   for(i = 2; i <= ulDepth; i++) {
-      iStatus = Path_prefix(oPPath, i, &oPPrefix);
-      if(iStatus != SUCCESS) {
-         *poNFurthest = NULL;
-         return iStatus;
-      }
-      if(Node_hasChild(oNCurr, oPPrefix, &ulChildID)) {
-         /* go to that child and continue with next prefix */
-         Path_free(oPPrefix);
-         oPPrefix = NULL;
-         iStatus = Node_getChild(oNCurr, ulChildID, &oNChild);
-         if(iStatus != SUCCESS) {
-            *poNFurthest = NULL;
-            return iStatus;
-         }
-         oNCurr = oNChild;
-      }
-      else {
-         /* oNCurr doesn't have child with path oPPrefix:
+   i = 1;
+   for(;;) {
+      oPChain = Node_getPath(oNCurr);
+      ulBottom = Path_getDepth(oPChain);
+      while(i < ulBottom && i < ulDepth &&
+            !strcmp(Path_getComponent(oPChain, i),
+                    Path_getComponent(oPPath, i)))
+         i++;
+      /* stopped partway down oNCurr's chain, or at oPPath itself */
+      if(i < ulBottom || i == ulDepth)
+         break;
+
+      oNChild = Node_findChain(oNCurr, Path_getComponent(oPPath, i));
+      if(oNChild == NULL)
+         /* oNCurr doesn't have child with the next component:
             this is as far as we can go */
          break;
-      }
+      oNCurr = oNChild;
+      i++;
    }
 
-   Path_free(oPPrefix);
    *poNFurthest = oNCurr;
+   *pulDepth = i;
    return SUCCESS;
 }
 
 /*
-  Traverses the DT to find a node with absolute path pcPath. Returns a
-  int SUCCESS status and sets *poNResult to be the node, if found.
+  Traverses the DT to find a directory with absolute path pcPath.
+  Returns a int SUCCESS status and sets *poNResult to be the chain
+  holding the directory and *pulDepth to its depth, if found.
   Otherwise, sets *poNResult to NULL and returns with status:
   * INITIALIZATION_ERROR if the DT is not in an initialized state
   * BAD_PATH if pcPath does not represent a well-formatted path
@@ -120,13 +115,15 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
   * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
   * MEMORY_ERROR if memory could not be allocated to complete request
  */
-static int DT_findNode(const char *pcPath, Node_T *poNResult) {
+static int DT_findNode(const char *pcPath, Node_T *poNResult,
+                       size_t *pulDepth) {
    Path_T oPPath = NULL;
    Node_T oNFound = NULL;
    int iStatus;
 
    assert(pcPath != NULL);
    assert(poNResult != NULL);
+   assert(pulDepth != NULL);
 
    if(!bIsInitialized) {
       *poNResult = NULL;
@@ -139,7 +136,7 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
       return iStatus;
    }
 
-   iStatus = DT_traversePath(oPPath, &oNFound);
+   iStatus = DT_traversePath(oPPath, &oNFound, pulDepth);
    if(iStatus != SUCCESS)
    {
       Path_free(oPPath);
@@ -153,7 +150,7 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
       return NO_SUCH_PATH;
    }
 
-   if(Path_comparePath(Node_getPath(oNFound), oPPath) != 0) {
+   if(*pulDepth != Path_getDepth(oPPath)) {
       Path_free(oPPath);
       *poNResult = NULL;
       return NO_SUCH_PATH;
@@ -169,10 +166,11 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
 int DT_insert(const char *pcPath) {
    int iStatus;
    Path_T oPPath = NULL;
-   Node_T oNFirstNew = NULL;
+   Path_T oPPrefix = NULL;
+   Node_T oNNewRoot = NULL;
    Node_T oNCurr = NULL;
-   size_t ulDepth, ulIndex;
-   size_t ulNewNodes = 0;
+   Node_T oNNew = NULL;
+   size_t ulDepth, ulFound;
 
    assert(pcPath != NULL);
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
@@ -186,74 +184,52 @@ int DT_insert(const char *pcPath) {
       return iStatus;
 
    /* find the closest ancestor of oPPath already in the tree */
-   iStatus= DT_traversePath(oPPath, &oNCurr);
+   iStatus= DT_traversePath(oPPath, &oNCurr, &ulFound);
    if(iStatus != SUCCESS)
    {
       Path_free(oPPath);
       return iStatus;
    }
 
-   /* no ancestor node found, so if root is not NULL,
-      pcPath isn't underneath root. */
-   if(oNCurr == NULL && oNRoot != NULL) {
+   ulDepth = Path_getDepth(oPPath);
+   /* oNCurr holds the node we're trying to insert */
+   if(oNCurr != NULL && ulFound == ulDepth) {
       Path_free(oPPath);
-      return CONFLICTING_PATH;
+      return ALREADY_IN_TREE;
    }
 
-   ulDepth = Path_getDepth(oPPath);
-   if(oNCurr == NULL) /* new root! */
-      ulIndex = 1;
-   else {
-      ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
-
-      /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
-         Path_free(oPPath);
-         return ALREADY_IN_TREE;
+   /* new root! it gets a node of its own */
+   if(oNCurr == NULL) {
+      iStatus = Path_prefix(oPPath, 1, &oPPrefix);
+      if(iStatus == SUCCESS) {
+         iStatus = Node_new(oPPrefix, NULL, &oNNewRoot);
+         Path_free(oPPrefix);
       }
-   }
-
-   /* starting at oNCurr, build rest of the path one level at a time */
-   while(ulIndex <= ulDepth) {
-      Path_T oPPrefix = NULL;
-      Node_T oNNewNode = NULL;
-
-      /* generate a Path_T for this level */
-      iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
       if(iStatus != SUCCESS) {
          Path_free(oPPath);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
-         assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
          return iStatus;
       }
+      oNCurr = oNNewRoot;
+      ulFound = 1;
+   }
 
-      /* insert the new node for this level */
-      iStatus = Node_new(oPPrefix, oNCurr, &oNNewNode);
+   /* the rest of the path hangs from oNCurr as a single chain */
+   if(ulFound < ulDepth) {
+      iStatus = Node_insertChain(oPPath, oNCurr, ulFound, &oNNew);
       if(iStatus != SUCCESS) {
          Path_free(oPPath);
-         Path_free(oPPrefix);
-         if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
+         if(oNNewRoot != NULL)
+            (void) Node_free(oNNewRoot);
          assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
          return iStatus;
       }
-
-      /* set up for next level */
-      Path_free(oPPrefix);
-      oNCurr = oNNewNode;
-      ulNewNodes++;
-      if(oNFirstNew == NULL)
-         oNFirstNew = oNCurr;
-      ulIndex++;
    }
 
    Path_free(oPPath);
    /* update DT state variables to reflect insertion */
    if(oNRoot == NULL)
-      oNRoot = oNFirstNew;
-   ulCount += ulNewNodes;
+      oNRoot = oNNewRoot;
+   ulCount += ulDepth - ulFound + (oNNewRoot != NULL);
 
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
@@ -262,10 +238,11 @@ int DT_insert(const char *pcPath) {
 boolean DT_contains(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
+   size_t ulDepth;
 
    assert(pcPath != NULL);
 
-   iStatus = DT_findNode(pcPath, &oNFound);
+   iStatus = DT_findNode(pcPath, &oNFound, &ulDepth);
    return (boolean) (iStatus == SUCCESS);
 }
 
@@ -273,16 +250,17 @@ boolean DT_contains(const char *pcPath) {
 int DT_rm(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
+   size_t ulDepth;
 
    assert(pcPath != NULL);
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
 
-   iStatus = DT_findNode(pcPath, &oNFound);
+   iStatus = DT_findNode(pcPath, &oNFound, &ulDepth);
 
    if(iStatus != SUCCESS)
        return iStatus;
 
-   ulCount -= Node_free(oNFound);
+   ulCount -= Node_freeLevel(oNFound, ulDepth);
    if(ulCount == 0)
       oNRoot = NULL;
 
@@ -346,6 +324,7 @@ static size_t DT_preOrderTraversal(Node_T n, DynArray_T d, size_t i) {
          Node_T oNChild = NULL;
          iStatus = Node_getChild(n,c, &oNChild);
          assert(iStatus == SUCCESS);
+         (void) iStatus;
          i = DT_preOrderTraversal(oNChild, d, i);
       }
    }
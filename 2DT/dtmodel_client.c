@@ -0,0 +1,212 @@
+/*--------------------------------------------------------------------*/
+/* dtmodel_client.c                                                   */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  dtmodel_client checks the DT against a simple model: the set of
+  paths it should hold.
+
+  Usage: dtmodel_client [-r rounds] [-s seed]
+
+  Each round inserts, removes or looks up a random path below the root
+  r, drawn from a small alphabet and up to MAX_DEPTH levels deep, so
+  that paths share long runs of single-child directories that must
+  be made into chains, split and folded back. Every status and answer
+  must match the model, and every so often DT_toString must list the
+  model's paths exactly. The DT's own checker runs on every call.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dt.h"
+
+/* Deepest path drawn, counting the root */
+enum { MAX_DEPTH = 12 };
+
+/* Longest path drawn, including its terminator */
+enum { MAX_PATH = 3 * MAX_DEPTH + 2 };
+
+/* Rounds between comparisons of DT_toString with the model */
+enum { LIST_EVERY = 50 };
+
+/* Rounds between starting over with an empty DT */
+enum { RESET_EVERY = 3000 };
+
+/* Most paths the model can hold: each round adds at most MAX_DEPTH */
+enum { MAX_PATHS = RESET_EVERY * MAX_DEPTH };
+
+/* The paths the DT should hold, in no particular order */
+static char *apcModel[MAX_PATHS];
+static size_t ulModelCount;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the position of pcPath in the model, or ulModelCount if it
+   is not there. */
+static size_t DTModel_find(const char *pcPath) {
+   size_t i;
+
+   for(i = 0; i < ulModelCount; i++)
+      if(strcmp(apcModel[i], pcPath) == 0)
+         return i;
+   return ulModelCount;
+}
+
+/* Adds pcPath and each of its prefixes to the model, if absent. */
+static void DTModel_add(const char *pcPath) {
+   char acPrefix[MAX_PATH];
+   char *pcSlash;
+
+   strcpy(acPrefix, pcPath);
+   for(;;) {
+      if(DTModel_find(acPrefix) == ulModelCount) {
+         assert(ulModelCount < MAX_PATHS);
+         apcModel[ulModelCount] = malloc(strlen(acPrefix) + 1);
+         assert(apcModel[ulModelCount] != NULL);
+         strcpy(apcModel[ulModelCount], acPrefix);
+         ulModelCount++;
+      }
+      pcSlash = strrchr(acPrefix, '/');
+      if(pcSlash == NULL)
+         break;
+      *pcSlash = '\0';
+   }
+}
+
+/* Removes pcPath and every path below it from the model. */
+static void DTModel_remove(const char *pcPath) {
+   size_t ulLength = strlen(pcPath);
+   size_t i = 0;
+
+   while(i < ulModelCount) {
+      if(strncmp(apcModel[i], pcPath, ulLength) == 0 &&
+         (apcModel[i][ulLength] == '/' || apcModel[i][ulLength] == '\0')) {
+         free(apcModel[i]);
+         apcModel[i] = apcModel[--ulModelCount];
+      }
+      else
+         i++;
+   }
+}
+
+/* Empties the model. */
+static void DTModel_clear(void) {
+   while(ulModelCount != 0)
+      free(apcModel[--ulModelCount]);
+}
+
+/* Compares the paths at pvFirst and pvSecond, for qsort. Since every
+   component character sorts after '/', this is DT_toString's order. */
+static int DTModel_compare(const void *pvFirst, const void *pvSecond) {
+   return strcmp(*(char *const *) pvFirst, *(char *const *) pvSecond);
+}
+
+/* Checks that DT_toString lists exactly the model's paths. */
+static void DTModel_checkList(void) {
+   char *pcString, *pcLine;
+   size_t i;
+
+   qsort(apcModel, ulModelCount, sizeof(char *), DTModel_compare);
+   pcString = DT_toString();
+   assert(pcString != NULL);
+   pcLine = pcString;
+   for(i = 0; i < ulModelCount; i++) {
+      assert(strncmp(pcLine, apcModel[i], strlen(apcModel[i])) == 0);
+      pcLine += strlen(apcModel[i]);
+      assert(*pcLine == '\n');
+      pcLine++;
+   }
+   assert(*pcLine == '\0');
+   free(pcString);
+}
+
+/* Writes into pcPath a random path below r. Components are "a", "b"
+   or "c", sometimes followed by "b", so that siblings are few and
+   runs of single children are long. */
+static void DTModel_randomPath(char *pcPath) {
+   size_t ulDepth = 1 + (size_t) rand() % MAX_DEPTH;
+   size_t i;
+
+   strcpy(pcPath, "r");
+   for(i = 1; i < ulDepth; i++) {
+      pcPath += strlen(pcPath);
+      *pcPath++ = '/';
+      *pcPath++ = (char) ('a' + rand() % 3);
+      if(rand() % 4 == 0)
+         *pcPath++ = 'b';
+      *pcPath = '\0';
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 20000, ulSeed = 1, r;
+   char acPath[MAX_PATH];
+   boolean bInModel;
+   int iArg, iOp;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   assert(DT_init() == SUCCESS);
+   for(r = 0; r < ulRounds; r++) {
+      DTModel_randomPath(acPath);
+      bInModel = (boolean) (DTModel_find(acPath) != ulModelCount);
+      iOp = rand() % 10;
+
+      /* Mostly inserts, so the tree grows deep between resets */
+      if(iOp < 6) {
+         if(bInModel)
+            assert(DT_insert(acPath) == ALREADY_IN_TREE);
+         else {
+            assert(DT_insert(acPath) == SUCCESS);
+            DTModel_add(acPath);
+         }
+      }
+      else if(iOp < 8) {
+         if(!bInModel)
+            assert(DT_rm(acPath) == NO_SUCH_PATH);
+         else {
+            assert(DT_rm(acPath) == SUCCESS);
+            DTModel_remove(acPath);
+         }
+      }
+      else
+         assert(DT_contains(acPath) == bInModel);
+
+      /* Paths off the root conflict, whatever the tree holds */
+      if(r % 7 == 0 && ulModelCount != 0)
+         assert(DT_insert("s/a") == CONFLICTING_PATH);
+
+      if(r % LIST_EVERY == 0)
+         DTModel_checkList();
+      if(r % RESET_EVERY == RESET_EVERY - 1) {
+         assert(DT_destroy() == SUCCESS);
+         assert(DT_init() == SUCCESS);
+         DTModel_clear();
+      }
+   }
+   DTModel_checkList();
+   assert(DT_destroy() == SUCCESS);
+   DTModel_clear();
+
+   printf("%lu rounds matched the model\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -11,7 +11,12 @@
 #include "path.h"
 
 
-/* A Node_T is a node in a Directory Tree */
+/*
+  A Node_T is a node in a Directory Tree. Below the root, each run of
+  directories that have only one child is held by a single node, a
+  chain, that stands for the run's deepest directory; Node_getChild
+  and Node_getParent still step through the run one level at a time.
+*/
 typedef struct node *Node_T;
 
 /*
@@ -28,16 +33,48 @@ typedef struct node *Node_T;
 */
 int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult);
 
+/*
+  Inserts the directories of oPPath below depth ulDepth, hanging them
+  from the level at depth ulDepth of chain oNNode, which must be an
+  ancestor of oPPath with no child on the way to it. oNNode's chain is
+  split after that level if it goes deeper, or simply extended if it
+  is a childless chain below the root. Returns an int SUCCESS status
+  and sets *poNResult to the chain that now stands for oPPath if
+  successful. Otherwise, leaves the tree unchanged, sets *poNResult to
+  NULL and returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Node_insertChain(Path_T oPPath, Node_T oNNode, size_t ulDepth,
+                     Node_T *poNResult);
+
 /*
   Destroys and frees all memory allocated for the subtree rooted at
-  oNNode, i.e., deletes this node and all its descendents. Returns the
-  number of nodes deleted.
+  chain oNNode, i.e., deletes this node and all its descendents.
+  Returns the number of directories deleted.
 */
 size_t Node_free(Node_T oNNode);
 
+/*
+  Deletes the directory at depth ulDepth in chain oNNode and all its
+  descendents. Returns the number of directories deleted.
+*/
+size_t Node_freeLevel(Node_T oNNode, size_t ulDepth);
+
 /* Returns the path object representing oNNode's absolute path. */
 Path_T Node_getPath(Node_T oNNode);
 
+/*
+  Returns the number of directories that oNNode stands for: its own
+  and the single-child directories directly above it in its chain.
+*/
+size_t Node_getSpan(Node_T oNNode);
+
+/*
+  Returns the child chain of chain oNParent whose top directory's last
+  path component is pcComponent, or NULL if there is none.
+*/
+Node_T Node_findChain(Node_T oNParent, const char *pcComponent);
+
 /*
   Returns TRUE if oNParent has a child with path oPPath. Returns
   FALSE if it does not.
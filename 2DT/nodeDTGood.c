@@ -10,17 +10,80 @@
 #include "nodeDT.h"
 #include "checkerDT.h"
 
-/* A node in a DT */
+/*
+  A node in a DT. Apart from the root, a node stands for a chain of
+  ulSpan directories, each the only child of the one above it, and
+  ending at the node's own path. Each upper level of a chain has a
+  view node, so that Node_getChild and Node_getParent can step through
+  the chain a level at a time without allocating. The views form a
+  list from the chain's top level down, and splitting, extending,
+  cutting or merging chains splices these lists rather than rebuilding
+  them.
+*/
 struct node {
    /* the object corresponding to the node's absolute path */
    Path_T oPPath;
-   /* this node's parent */
+   /* this node's parent: for a chain, the node holding the level
+      just above its top level */
    Node_T oNParent;
-   /* the object containing links to this node's children */
+   /* the object containing links to this node's children,
+      or NULL for a view */
    DynArray_T oDChildren;
+   /* the number of levels this node stands for, or 0 for a view */
+   size_t ulSpan;
+   /* for a chain, the views of its top and bottom upper levels, or
+      NULL if ulSpan is 1 */
+   Node_T oNTopView;
+   Node_T oNBottomView;
+   /* for a view, the chain it belongs to and the level just below it,
+      the next view or the chain itself; otherwise NULL */
+   Node_T oNChain;
+   Node_T oNBelow;
 };
 
 
+/*
+  Returns the last component of the top level that oNNode stands for,
+  which orders oNNode among its siblings.
+*/
+static const char *Node_getTopComponent(Node_T oNNode) {
+   size_t ulSpan;
+
+   assert(oNNode != NULL);
+
+   ulSpan = (oNNode->ulSpan == 0) ? 1 : oNNode->ulSpan;
+   return Path_getComponent(oNNode->oPPath,
+                            Path_getDepth(oNNode->oPPath) - ulSpan);
+}
+
+/*
+  Compares the top levels of sibling chains oNFirst and oNSecond.
+  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
+  "greater than" oNSecond, respectively.
+*/
+static int Node_compareSiblings(const Node_T oNFirst,
+                                const Node_T oNSecond) {
+   assert(oNFirst != NULL);
+   assert(oNSecond != NULL);
+
+   return strcmp(Node_getTopComponent(oNFirst),
+                 Node_getTopComponent(oNSecond));
+}
+
+/*
+  Compares the last component of oNFirst's top level with the
+  component pcSecond.
+  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
+  "greater than" pcSecond, respectively.
+*/
+static int Node_compareComponent(const Node_T oNFirst,
+                                 const char *pcSecond) {
+   assert(oNFirst != NULL);
+   assert(pcSecond != NULL);
+
+   return strcmp(Node_getTopComponent(oNFirst), pcSecond);
+}
+
 /*
   Links new child oNChild into oNParent's children array at index
   ulIndex. Returns SUCCESS if the new child was added successfully,
@@ -38,86 +101,290 @@ static int Node_addChild(Node_T oNParent, Node_T oNChild,
 }
 
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
-  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
-  "greater than" pcSecond, respectively.
+  Returns the index of chain oNChild in its parent's children array.
 */
-static int Node_compareString(const Node_T oNFirst,
-                                 const char *pcSecond) {
-   assert(oNFirst != NULL);
-   assert(pcSecond != NULL);
+static size_t Node_indexInParent(Node_T oNChild) {
+   size_t ulIndex = 0;
+   boolean bFound;
 
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   assert(oNChild != NULL);
+   assert(oNChild->oNParent != NULL);
+
+   bFound = DynArray_bsearch(oNChild->oNParent->oDChildren,
+            (char *) Node_getTopComponent(oNChild), &ulIndex,
+            (int (*)(const void*,const void*)) Node_compareComponent);
+   assert(bFound);
+   (void) bFound;
+   return ulIndex;
 }
 
+/*
+  Frees the ulCount views starting at oNView and following the list
+  down, together with their paths.
+*/
+static void Node_freeViews(Node_T oNView, size_t ulCount) {
+   Node_T oNBelow;
+
+   for(; ulCount > 0; ulCount--) {
+      assert(oNView != NULL);
+      assert(oNView->ulSpan == 0);
+      oNBelow = oNView->oNBelow;
+      Path_free(oNView->oPPath);
+      free(oNView);
+      oNView = oNBelow;
+   }
+}
 
 /*
-  Creates a new node with path oPPath and parent oNParent.  Returns an
-  int SUCCESS status and sets *poNResult to be the new node if
-  successful. Otherwise, sets *poNResult to NULL and returns status:
-  * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-  * ALREADY_IN_TREE if oNParent already has a child with this path
+  Creates a list of views for the levels of oPPath at depths ulFrom
+  to ulTo, top first, and stores its top and bottom views in *poNTop
+  and *poNBottom (both NULL if ulFrom > ulTo). The views belong to no
+  chain until Node_adoptViews attaches them to one. Returns SUCCESS,
+  or MEMORY_ERROR (creating nothing) if allocation fails.
 */
-int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
+static int Node_newViews(Path_T oPPath, size_t ulFrom, size_t ulTo,
+                         Node_T *poNTop, Node_T *poNBottom) {
+   Node_T oNView;
+   size_t ulDepth;
+   int iStatus;
+
+   assert(oPPath != NULL);
+   assert(poNTop != NULL);
+   assert(poNBottom != NULL);
+
+   *poNTop = NULL;
+   *poNBottom = NULL;
+   for(ulDepth = ulFrom; ulDepth <= ulTo; ulDepth++) {
+      oNView = calloc(1, sizeof(struct node));
+      if(oNView == NULL) {
+         Node_freeViews(*poNTop, ulDepth - ulFrom);
+         *poNTop = NULL;
+         *poNBottom = NULL;
+         return MEMORY_ERROR;
+      }
+      iStatus = Path_prefix(oPPath, ulDepth, &oNView->oPPath);
+      if(iStatus != SUCCESS) {
+         free(oNView);
+         Node_freeViews(*poNTop, ulDepth - ulFrom);
+         *poNTop = NULL;
+         *poNBottom = NULL;
+         return iStatus;
+      }
+      if(*poNTop == NULL)
+         *poNTop = oNView;
+      else
+         (*poNBottom)->oNBelow = oNView;
+      *poNBottom = oNView;
+   }
+   return SUCCESS;
+}
+
+/*
+  Links the views from oNChain->oNTopView down to oNChain->oNBottomView
+  into oNChain: each view's parent is the level above it, the top
+  view's being the chain's parent, and the bottom view's level below
+  is the chain itself.
+*/
+static void Node_adoptViews(Node_T oNChain) {
+   Node_T oNView;
+   Node_T oNAbove;
+
+   assert(oNChain != NULL);
+   assert(oNChain->ulSpan != 0);
+
+   oNAbove = oNChain->oNParent;
+   oNView = oNChain->oNTopView;
+   while(oNView != NULL) {
+      oNView->oNParent = oNAbove;
+      oNView->oNChain = oNChain;
+      if(oNView == oNChain->oNBottomView) {
+         oNView->oNBelow = oNChain;
+         break;
+      }
+      oNAbove = oNView;
+      oNView = oNView->oNBelow;
+   }
+}
+
+/*
+  Returns the view of chain oNChain's level at depth ulDepth, which
+  must be one of its upper levels.
+*/
+static Node_T Node_getView(Node_T oNChain, size_t ulDepth) {
+   Node_T oNView;
+   size_t ulTop;
+
+   assert(oNChain != NULL);
+   assert(oNChain->ulSpan > 1);
+
+   ulTop = Path_getDepth(oNChain->oPPath) - oNChain->ulSpan + 1;
+   assert(ulDepth >= ulTop && ulDepth < ulTop + oNChain->ulSpan - 1);
+   oNView = oNChain->oNTopView;
+   for(; ulDepth > ulTop; ulDepth--)
+      oNView = oNView->oNBelow;
+   return oNView;
+}
+
+/*
+  Creates an unlinked chain for the ulSpan levels ending at oPPath,
+  with parent oNParent, and the views of its upper levels. Returns an
+  int SUCCESS status and sets *poNResult to the new chain if
+  successful. Otherwise, sets *poNResult to NULL and returns
+  MEMORY_ERROR.
+*/
+static int Node_newChain(Path_T oPPath, size_t ulSpan, Node_T oNParent,
+                         Node_T *poNResult) {
    struct node *psNew;
-   Path_T oPParentPath = NULL;
-   Path_T oPNewPath = NULL;
-   size_t ulParentDepth;
-   size_t ulIndex;
+   size_t ulBottom;
    int iStatus;
 
    assert(oPPath != NULL);
-   assert(oNParent == NULL || CheckerDT_Node_isValid(oNParent));
+   assert(ulSpan > 0);
+   assert(poNResult != NULL);
 
-   /* allocate space for a new node */
    psNew = malloc(sizeof(struct node));
    if(psNew == NULL) {
       *poNResult = NULL;
       return MEMORY_ERROR;
    }
 
-   /* set the new node's path */
-   iStatus = Path_dup(oPPath, &oPNewPath);
+   iStatus = Path_dup(oPPath, &psNew->oPPath);
    if(iStatus != SUCCESS) {
       free(psNew);
       *poNResult = NULL;
       return iStatus;
    }
-   psNew->oPPath = oPNewPath;
 
-   /* validate and set the new node's parent */
-   if(oNParent != NULL) {
-      size_t ulSharedDepth;
+   psNew->oDChildren = DynArray_new(0);
+   if(psNew->oDChildren == NULL) {
+      Path_free(psNew->oPPath);
+      free(psNew);
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   ulBottom = Path_getDepth(oPPath);
+   iStatus = Node_newViews(oPPath, ulBottom - ulSpan + 1, ulBottom - 1,
+                           &psNew->oNTopView, &psNew->oNBottomView);
+   if(iStatus != SUCCESS) {
+      DynArray_free(psNew->oDChildren);
+      Path_free(psNew->oPPath);
+      free(psNew);
+      *poNResult = NULL;
+      return iStatus;
+   }
+
+   psNew->oNParent = oNParent;
+   psNew->ulSpan = ulSpan;
+   psNew->oNChain = NULL;
+   psNew->oNBelow = NULL;
+   Node_adoptViews(psNew);
+
+   *poNResult = psNew;
+   return SUCCESS;
+}
+
+/*
+  Destroys and frees all memory allocated for the subtree rooted at
+  chain oNNode without unlinking it from its parent. Returns the
+  number of levels deleted.
+*/
+static size_t Node_freeSubtree(Node_T oNNode) {
+   size_t ulIndex;
+   size_t ulCount;
+
+   assert(oNNode != NULL);
+   assert(oNNode->ulSpan != 0);
+
+   ulCount = oNNode->ulSpan;
+   for(ulIndex = 0; ulIndex < DynArray_getLength(oNNode->oDChildren);
+       ulIndex++)
+      ulCount += Node_freeSubtree(DynArray_get(oNNode->oDChildren,
+                                               ulIndex));
+   DynArray_free(oNNode->oDChildren);
+
+   Node_freeViews(oNNode->oNTopView, oNNode->ulSpan - 1);
+   Path_free(oNNode->oPPath);
+   free(oNNode);
+   return ulCount;
+}
 
-      oPParentPath = oNParent->oPPath;
-      ulParentDepth = Path_getDepth(oPParentPath);
-      ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
-                                                oPParentPath);
+/*
+  Folds chain oNNode into its only child if oNNode is not the root and
+  has exactly one child left, so that the child's chain takes over
+  oNNode's levels and its place among oNNode's siblings. oNNode itself
+  becomes the view of its level in the child's chain.
+*/
+static void Node_mergeWithChild(Node_T oNNode) {
+   Node_T oNChild;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->oNParent == NULL ||
+      DynArray_getLength(oNNode->oDChildren) != 1)
+      return;
+
+   oNChild = DynArray_get(oNNode->oDChildren, 0);
+   (void) DynArray_set(oNNode->oNParent->oDChildren,
+                       Node_indexInParent(oNNode), oNChild);
+   DynArray_free(oNNode->oDChildren);
+   oNNode->oDChildren = NULL;
+
+   /* oNNode's views, then oNNode, then the child's views */
+   oNNode->oNBelow = (oNChild->oNTopView != NULL) ?
+                     oNChild->oNTopView : oNChild;
+   oNChild->oNTopView = (oNNode->oNTopView != NULL) ?
+                        oNNode->oNTopView : oNNode;
+   if(oNChild->oNBottomView == NULL)
+      oNChild->oNBottomView = oNNode;
+   oNChild->oNParent = oNNode->oNParent;
+   oNChild->ulSpan += oNNode->ulSpan;
+
+   oNNode->ulSpan = 0;
+   oNNode->oNTopView = NULL;
+   oNNode->oNBottomView = NULL;
+   Node_adoptViews(oNChild);
+}
+
+/*
+  Creates a new node with path oPPath and parent oNParent.  Returns an
+  int SUCCESS status and sets *poNResult to be the new node if
+  successful. Otherwise, sets *poNResult to NULL and returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
+  * NO_SUCH_PATH if oPPath is of depth 0
+                 or oNParent's path is not oPPath's direct parent
+                 or oNParent is NULL but oPPath is not of depth 1
+  * ALREADY_IN_TREE if oNParent already has a child with this path
+*/
+int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
+   Node_T oNNew = NULL;
+   size_t ulParentDepth;
+   size_t ulIndex = 0;
+   int iStatus;
+
+   assert(oPPath != NULL);
+   assert(oNParent == NULL || CheckerDT_Node_isValid(oNParent));
+   assert(oNParent == NULL || oNParent->ulSpan != 0);
+
+   /* validate the new node's parent */
+   if(oNParent != NULL) {
+      ulParentDepth = Path_getDepth(oNParent->oPPath);
       /* parent must be an ancestor of child */
-      if(ulSharedDepth < ulParentDepth) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+      if(Path_getSharedPrefixDepth(oPPath, oNParent->oPPath) <
+         ulParentDepth) {
          *poNResult = NULL;
          return CONFLICTING_PATH;
       }
 
       /* parent must be exactly one level up from child */
-      if(Path_getDepth(psNew->oPPath) != ulParentDepth + 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+      if(Path_getDepth(oPPath) != ulParentDepth + 1) {
          *poNResult = NULL;
          return NO_SUCH_PATH;
       }
 
       /* parent must not already have child with this path */
       if(Node_hasChild(oNParent, oPPath, &ulIndex)) {
-         Path_free(psNew->oPPath);
-         free(psNew);
          *poNResult = NULL;
          return ALREADY_IN_TREE;
       }
@@ -125,36 +392,29 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    else {
       /* new node must be root */
       /* can only create one "level" at a time */
-      if(Path_getDepth(psNew->oPPath) != 1) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+      if(Path_getDepth(oPPath) != 1) {
          *poNResult = NULL;
          return NO_SUCH_PATH;
       }
    }
-   psNew->oNParent = oNParent;
 
-   /* initialize the new node */
-   psNew->oDChildren = DynArray_new(0);
-   if(psNew->oDChildren == NULL) {
-      Path_free(psNew->oPPath);
-      free(psNew);
+   iStatus = Node_newChain(oPPath, 1, oNParent, &oNNew);
+   if(iStatus != SUCCESS) {
       *poNResult = NULL;
-      return MEMORY_ERROR;
+      return iStatus;
    }
 
    /* Link into parent's children list */
    if(oNParent != NULL) {
-      iStatus = Node_addChild(oNParent, psNew, ulIndex);
+      iStatus = Node_addChild(oNParent, oNNew, ulIndex);
       if(iStatus != SUCCESS) {
-         Path_free(psNew->oPPath);
-         free(psNew);
+         (void) Node_freeSubtree(oNNew);
          *poNResult = NULL;
          return iStatus;
       }
    }
 
-   *poNResult = psNew;
+   *poNResult = oNNew;
 
    assert(oNParent == NULL || CheckerDT_Node_isValid(oNParent));
    assert(CheckerDT_Node_isValid(*poNResult));
@@ -162,36 +422,205 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    return SUCCESS;
 }
 
+int Node_insertChain(Path_T oPPath, Node_T oNNode, size_t ulDepth,
+                     Node_T *poNResult) {
+   Node_T oNNew = NULL;
+   Node_T oNUpper = NULL;
+   Node_T oNView = NULL;
+   Node_T oNTop = NULL;
+   Node_T oNBottom = NULL;
+   Path_T oPNew = NULL;
+   size_t ulBottom;
+   size_t ulIndex = 0;
+   int iStatus;
+
+   assert(oPPath != NULL);
+   assert(oNNode != NULL);
+   assert(oNNode->ulSpan != 0);
+   assert(poNResult != NULL);
+
+   ulBottom = Path_getDepth(oNNode->oPPath);
+   assert(ulDepth + oNNode->ulSpan > ulBottom && ulDepth <= ulBottom);
+   assert(ulDepth < Path_getDepth(oPPath));
+   assert(Path_getSharedPrefixDepth(oPPath, oNNode->oPPath) ==
+          ulDepth);
+
+   /* a childless chain below the root just grows down to oPPath, its
+      old level becoming a view above the new ones */
+   if(ulDepth == ulBottom && oNNode->oNParent != NULL &&
+      DynArray_getLength(oNNode->oDChildren) == 0) {
+      oNView = calloc(1, sizeof(struct node));
+      if(oNView == NULL) {
+         *poNResult = NULL;
+         return MEMORY_ERROR;
+      }
+      iStatus = Path_dup(oPPath, &oPNew);
+      if(iStatus == SUCCESS) {
+         iStatus = Node_newViews(oPPath, ulBottom + 1,
+                                 Path_getDepth(oPPath) - 1,
+                                 &oNTop, &oNBottom);
+         if(iStatus != SUCCESS)
+            Path_free(oPNew);
+      }
+      if(iStatus != SUCCESS) {
+         free(oNView);
+         *poNResult = NULL;
+         return iStatus;
+      }
+
+      oNView->oPPath = oNNode->oPPath;
+      oNView->oNBelow = oNTop;
+      if(oNNode->oNBottomView != NULL)
+         oNNode->oNBottomView->oNBelow = oNView;
+      else
+         oNNode->oNTopView = oNView;
+      oNNode->oNBottomView = (oNBottom != NULL) ? oNBottom : oNView;
+      oNNode->oPPath = oPNew;
+      oNNode->ulSpan += Path_getDepth(oPPath) - ulBottom;
+      Node_adoptViews(oNNode);
+      *poNResult = oNNode;
+      assert(CheckerDT_Node_isValid(*poNResult));
+      return SUCCESS;
+   }
+
+   /* otherwise the new levels form a chain of their own... */
+   iStatus = Node_newChain(oPPath, Path_getDepth(oPPath) - ulDepth,
+                           oNNode, &oNNew);
+   if(iStatus != SUCCESS) {
+      *poNResult = NULL;
+      return iStatus;
+   }
+
+   if(ulDepth == ulBottom) {
+      (void) DynArray_bsearch(oNNode->oDChildren,
+               (char *) Node_getTopComponent(oNNew), &ulIndex,
+               (int (*)(const void*,const void*)) Node_compareComponent);
+      iStatus = Node_addChild(oNNode, oNNew, ulIndex);
+      if(iStatus != SUCCESS) {
+         (void) Node_freeSubtree(oNNew);
+         *poNResult = NULL;
+         return iStatus;
+      }
+      *poNResult = oNNew;
+      assert(CheckerDT_Node_isValid(oNNode));
+      return SUCCESS;
+   }
+
+   /* ...beside the rest of oNNode's chain, which splits off after
+      level ulDepth */
+   oNUpper = calloc(1, sizeof(struct node));
+   if(oNUpper != NULL)
+      oNUpper->oDChildren = DynArray_new(0);
+   if(oNUpper == NULL || oNUpper->oDChildren == NULL ||
+      !DynArray_add(oNUpper->oDChildren, oNNode) ||
+      !DynArray_add(oNUpper->oDChildren, oNNew)) {
+      if(oNUpper != NULL) {
+         if(oNUpper->oDChildren != NULL)
+            DynArray_free(oNUpper->oDChildren);
+         free(oNUpper);
+      }
+      (void) Node_freeSubtree(oNNew);
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   /* the view of level ulDepth gives the upper chain its path, and
+      the views above it go with it */
+   oNView = Node_getView(oNNode, ulDepth);
+   (void) DynArray_set(oNNode->oNParent->oDChildren,
+                       Node_indexInParent(oNNode), oNUpper);
+   oNUpper->oPPath = oNView->oPPath;
+   oNUpper->oNParent = oNNode->oNParent;
+   oNUpper->ulSpan = ulDepth + oNNode->ulSpan - ulBottom;
+   if(oNView != oNNode->oNTopView) {
+      oNUpper->oNTopView = oNNode->oNTopView;
+      oNUpper->oNBottomView = oNView->oNParent;
+   }
+   if(oNView == oNNode->oNBottomView) {
+      oNNode->oNTopView = NULL;
+      oNNode->oNBottomView = NULL;
+   }
+   else
+      oNNode->oNTopView = oNView->oNBelow;
+   free(oNView);
+
+   oNNode->oNParent = oNUpper;
+   oNNode->ulSpan -= oNUpper->ulSpan;
+   oNNew->oNParent = oNUpper;
+   Node_adoptViews(oNUpper);
+   Node_adoptViews(oNNode);
+   Node_adoptViews(oNNew);
+   if(Node_compareSiblings(oNNew, oNNode) < 0) {
+      (void) DynArray_set(oNUpper->oDChildren, 0, oNNew);
+      (void) DynArray_set(oNUpper->oDChildren, 1, oNNode);
+   }
+
+   *poNResult = oNNew;
+   assert(CheckerDT_Node_isValid(oNUpper));
+   return SUCCESS;
+}
+
 size_t Node_free(Node_T oNNode) {
-   size_t ulIndex;
-   size_t ulCount = 0;
+   Node_T oNParent;
+   size_t ulCount;
 
    assert(oNNode != NULL);
+   assert(oNNode->ulSpan != 0);
    assert(CheckerDT_Node_isValid(oNNode));
 
    /* remove from parent's list */
-   if(oNNode->oNParent != NULL) {
-      if(DynArray_bsearch(
-            oNNode->oNParent->oDChildren,
-            oNNode, &ulIndex,
-            (int (*)(const void *, const void *)) Node_compare)
-        )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  ulIndex);
-   }
+   oNParent = oNNode->oNParent;
+   if(oNParent != NULL)
+      (void) DynArray_removeAt(oNParent->oDChildren,
+                               Node_indexInParent(oNNode));
 
-   /* recursively remove children */
-   while(DynArray_getLength(oNNode->oDChildren) != 0) {
-      ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
-   }
-   DynArray_free(oNNode->oDChildren);
+   ulCount = Node_freeSubtree(oNNode);
+
+   /* a parent left with one child joins that child's chain */
+   if(oNParent != NULL)
+      Node_mergeWithChild(oNParent);
+
+   return ulCount;
+}
 
-   /* remove path */
+size_t Node_freeLevel(Node_T oNNode, size_t ulDepth) {
+   Node_T oNView;
+   size_t ulBottom;
+   size_t ulIndex;
+   size_t ulCount;
+
+   assert(oNNode != NULL);
+   assert(oNNode->ulSpan != 0);
+
+   ulBottom = Path_getDepth(oNNode->oPPath);
+   assert(ulDepth + oNNode->ulSpan > ulBottom && ulDepth <= ulBottom);
+
+   /* removing the top level removes the whole chain */
+   if(ulDepth + oNNode->ulSpan == ulBottom + 1)
+      return Node_free(oNNode);
+
+   /* otherwise the chain is cut short above level ulDepth, the view
+      of the level above becoming its own */
+   ulCount = ulBottom - ulDepth + 1;
+   while((ulIndex = DynArray_getLength(oNNode->oDChildren)) != 0)
+      ulCount += Node_freeSubtree(
+         DynArray_removeAt(oNNode->oDChildren, ulIndex - 1));
+
+   oNView = Node_getView(oNNode, ulDepth - 1);
+   Node_freeViews(oNView->oNBelow, ulBottom - ulDepth);
    Path_free(oNNode->oPPath);
+   oNNode->oPPath = oNView->oPPath;
+   if(oNView == oNNode->oNTopView) {
+      oNNode->oNTopView = NULL;
+      oNNode->oNBottomView = NULL;
+   }
+   else
+      oNNode->oNBottomView = oNView->oNParent;
+   free(oNView);
+   oNNode->ulSpan -= ulBottom - ulDepth + 1;
+   Node_adoptViews(oNNode);
 
-   /* finally, free the struct node */
-   free(oNNode);
-   ulCount++;
+   assert(CheckerDT_Node_isValid(oNNode));
    return ulCount;
 }
 
@@ -201,26 +630,68 @@ Path_T Node_getPath(Node_T oNNode) {
    return oNNode->oPPath;
 }
 
+size_t Node_getSpan(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return (oNNode->ulSpan == 0) ? 1 : oNNode->ulSpan;
+}
+
+Node_T Node_findChain(Node_T oNParent, const char *pcComponent) {
+   size_t ulIndex;
+
+   assert(oNParent != NULL);
+   assert(oNParent->ulSpan != 0);
+   assert(pcComponent != NULL);
+
+   if(DynArray_bsearch(oNParent->oDChildren, (char *) pcComponent,
+            &ulIndex,
+            (int (*)(const void*,const void*)) Node_compareComponent))
+      return DynArray_get(oNParent->oDChildren, ulIndex);
+   return NULL;
+}
+
 boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
                          size_t *pulChildID) {
+   const char *pcComponent;
+   int iCompare;
+
    assert(oNParent != NULL);
    assert(oPPath != NULL);
    assert(pulChildID != NULL);
 
+   /* a child's last component orders it among its siblings */
+   *pulChildID = 0;
+   if(Path_getDepth(oPPath) != Path_getDepth(oNParent->oPPath) + 1)
+      return FALSE;
+   pcComponent = Path_getComponent(oPPath, Path_getDepth(oPPath) - 1);
+
+   /* a view's only child is the next level of its chain */
+   if(oNParent->ulSpan == 0) {
+      iCompare = strcmp(Path_getComponent(oNParent->oNChain->oPPath,
+                           Path_getDepth(oNParent->oPPath)),
+                        pcComponent);
+      if(iCompare < 0)
+         *pulChildID = 1;
+      return (boolean) (iCompare == 0);
+   }
+
    /* *pulChildID is the index into oNParent->oDChildren */
    return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+            (char *) pcComponent, pulChildID,
+            (int (*)(const void*,const void*)) Node_compareComponent);
 }
 
 size_t Node_getNumChildren(Node_T oNParent) {
    assert(oNParent != NULL);
 
+   if(oNParent->ulSpan == 0)
+      return 1;
    return DynArray_getLength(oNParent->oDChildren);
 }
 
 int  Node_getChild(Node_T oNParent, size_t ulChildID,
                    Node_T *poNResult) {
+   Node_T oNChain;
 
    assert(oNParent != NULL);
    assert(poNResult != NULL);
@@ -230,15 +701,26 @@ int  Node_getChild(Node_T oNParent, size_t ulChildID,
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
-   else {
-      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
+
+   /* a view's only child is the next level of its chain */
+   if(oNParent->ulSpan == 0) {
+      *poNResult = oNParent->oNBelow;
       return SUCCESS;
    }
+
+   /* a child chain is entered at its top level */
+   oNChain = DynArray_get(oNParent->oDChildren, ulChildID);
+   *poNResult = (oNChain->oNTopView != NULL) ? oNChain->oNTopView
+                                             : oNChain;
+   return SUCCESS;
 }
 
 Node_T Node_getParent(Node_T oNNode) {
    assert(oNNode != NULL);
 
+   /* the level above a chain's own is its last view */
+   if(oNNode->oNBottomView != NULL)
+      return oNNode->oNBottomView;
    return oNNode->oNParent;
 }
 
@@ -0,0 +1 @@
+../0shared/alloc.h
\ No newline at end of file
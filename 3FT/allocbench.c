@@ -0,0 +1,266 @@
+/*--------------------------------------------------------------------*/
+/* allocbench.c                                                       */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  allocbench compares the FT's size-class pool, with ordinary and
+  with huge pages, and malloc.
+
+  Usage: allocbench [-n files] [-w fanout] [-r rounds]
+
+  For each allocator it builds a tree of n files allocbench/aI/bJ/fK,
+  w to a directory, then looks every file up in random order, removes
+  and reinserts every other file, and destroys the tree, timing each
+  phase. It reports the best of r rounds in nanoseconds per file, and
+  how much the pools took. Where the kernel lets a process count its
+  own data TLB misses (Linux, with perf events and a CPU that exposes
+  them), it reports those of the lookups too, per file, from the round
+  with the fewest.
+*/
+
+/* syscall and perf events are Linux, not C90 */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "a4def.h"
+#include "alloc.h"
+#include "poolalloc.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Phases of a round */
+enum { PHASE_INSERT, PHASE_LOOKUP, PHASE_CHURN, PHASE_DESTROY,
+       NUM_PHASES };
+
+/* Names of the phases, for the report */
+static const char *apcPhases[NUM_PHASES] =
+   { "insert", "lookup", "churn", "destroy" };
+
+/* Allocators compared */
+enum { ALLOC_MALLOC, ALLOC_POOL, ALLOC_HUGE, NUM_ALLOCS };
+
+/* Names of the allocators, for the report */
+static const char *apcAllocs[NUM_ALLOCS] = { "malloc", "pool", "huge" };
+
+/* File descriptor of the data TLB miss counter, or -1 if there is
+   none */
+static int iTlbCounter = -1;
+
+/* Contents of every file; the FT only keeps a pointer to it */
+static char cContents = 'x';
+
+/*--------------------------------------------------------------------*/
+
+/* Opens the data TLB miss counter of the calling thread, stopped, if
+   the kernel provides one. */
+static void AllocBench_openTlbCounter(void) {
+#if defined(__linux__) && defined(SYS_perf_event_open)
+   struct perf_event_attr sAttr;
+
+   memset(&sAttr, 0, sizeof(sAttr));
+   sAttr.type = PERF_TYPE_HW_CACHE;
+   sAttr.size = sizeof(sAttr);
+   sAttr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                  PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+   sAttr.disabled = 1;
+   sAttr.exclude_kernel = 1;
+   sAttr.exclude_hv = 1;
+   iTlbCounter = (int) syscall(SYS_perf_event_open, &sAttr, 0, -1, -1,
+                               0UL);
+#endif
+}
+
+/* Zeroes and starts the data TLB miss counter, if there is one. */
+static void AllocBench_startTlbCounter(void) {
+#if defined(__linux__)
+   if(iTlbCounter >= 0) {
+      (void) ioctl(iTlbCounter, PERF_EVENT_IOC_RESET, 0);
+      (void) ioctl(iTlbCounter, PERF_EVENT_IOC_ENABLE, 0);
+   }
+#endif
+}
+
+/* Stops the data TLB miss counter and returns its count, or -1.0 if
+   there is no counter. */
+static double AllocBench_stopTlbCounter(void) {
+#if defined(__linux__)
+   __u64 ulCount;
+
+   if(iTlbCounter < 0)
+      return -1.0;
+   (void) ioctl(iTlbCounter, PERF_EVENT_IOC_DISABLE, 0);
+   if(read(iTlbCounter, &ulCount, sizeof(ulCount)) !=
+      (ssize_t) sizeof(ulCount))
+      return -1.0;
+   return (double) ulCount;
+#else
+   return -1.0;
+#endif
+}
+
+/*
+  Runs one round on an FT initialized with oAAlloc, over the ulFiles
+  pathnames in ppcPaths, looking them up in the order of pulOrder.
+  Stores each phase's seconds in pdSeconds, and the lookups' data TLB
+  misses (or -1.0 if they cannot be counted) in *pdMisses. Returns
+  FALSE if any FT call fails, TRUE otherwise.
+*/
+static boolean AllocBench_round(Alloc_T oAAlloc, char **ppcPaths,
+                                const size_t *pulOrder, size_t ulFiles,
+                                double *pdSeconds, double *pdMisses) {
+   double dStart;
+   boolean bIsOk = TRUE;
+   size_t i;
+
+   if(FT_initWith(oAAlloc) != SUCCESS)
+      return FALSE;
+
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], &cContents, 1) != SUCCESS)
+         bIsOk = FALSE;
+   pdSeconds[PHASE_INSERT] = Bench_now() - dStart;
+
+   AllocBench_startTlbCounter();
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(!FT_containsFile(ppcPaths[pulOrder[i]]))
+         bIsOk = FALSE;
+   pdSeconds[PHASE_LOOKUP] = Bench_now() - dStart;
+   *pdMisses = AllocBench_stopTlbCounter();
+
+   dStart = Bench_now();
+   for(i = 1; i < ulFiles; i += 2)
+      if(FT_rmFile(ppcPaths[i]) != SUCCESS)
+         bIsOk = FALSE;
+   for(i = 1; i < ulFiles; i += 2)
+      if(FT_insertFile(ppcPaths[i], &cContents, 1) != SUCCESS)
+         bIsOk = FALSE;
+   pdSeconds[PHASE_CHURN] = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   if(FT_destroy() != SUCCESS)
+      bIsOk = FALSE;
+   pdSeconds[PHASE_DESTROY] = Bench_now() - dStart;
+
+   return bIsOk;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 200000, ulFanout = 16, ulRounds = 5;
+   double adBest[NUM_ALLOCS][NUM_PHASES], adSeconds[NUM_PHASES];
+   double adBestMisses[NUM_ALLOCS], dMisses;
+   struct PoolAllocStats sStats;
+   PoolAlloc_T oPool, oHugePool;
+   Alloc_T aoAllocs[NUM_ALLOCS];
+   char **ppcPaths;
+   size_t *pulOrder;
+   unsigned long ulSeed = 217;
+   size_t i, j, ulTmp, ulRound;
+   int iAlloc, iPhase;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'w', "fanout", &ulFanout, FALSE },
+      { 'r', "rounds", &ulRounds, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   /* Generate the pathnames, and a random order to look them up in */
+   ppcPaths = malloc(ulFiles * sizeof(char *));
+   pulOrder = malloc(ulFiles * sizeof(size_t));
+   oPool = PoolAlloc_new();
+   oHugePool = PoolAlloc_newHuge();
+   if(ppcPaths == NULL || pulOrder == NULL || oPool == NULL ||
+      oHugePool == NULL)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      ppcPaths[i] = malloc(BENCH_MAX_PATH);
+      if(ppcPaths[i] == NULL)
+         return EXIT_FAILURE;
+      sprintf(ppcPaths[i], "allocbench/a%lu/b%lu/f%lu",
+              (unsigned long) (i / ulFanout / ulFanout),
+              (unsigned long) (i / ulFanout % ulFanout),
+              (unsigned long) (i % ulFanout));
+      pulOrder[i] = i;
+   }
+   for(i = ulFiles - 1; i > 0; i--) {
+      j = Bench_random(&ulSeed) % (i + 1);
+      ulTmp = pulOrder[i];
+      pulOrder[i] = pulOrder[j];
+      pulOrder[j] = ulTmp;
+   }
+
+   /* Alternate the allocators, so that none always runs first */
+   AllocBench_openTlbCounter();
+   aoAllocs[ALLOC_MALLOC] = NULL;
+   aoAllocs[ALLOC_POOL] = PoolAlloc_getAlloc(oPool);
+   aoAllocs[ALLOC_HUGE] = PoolAlloc_getAlloc(oHugePool);
+   for(ulRound = 0; ulRound < ulRounds; ulRound++) {
+      for(iAlloc = 0; iAlloc < NUM_ALLOCS; iAlloc++) {
+         if(!AllocBench_round(aoAllocs[iAlloc], ppcPaths, pulOrder,
+                              ulFiles, adSeconds, &dMisses)) {
+            fprintf(stderr, "%s: an FT call failed\n", argv[0]);
+            return EXIT_FAILURE;
+         }
+         for(iPhase = 0; iPhase < NUM_PHASES; iPhase++)
+            if(ulRound == 0 ||
+               adSeconds[iPhase] < adBest[iAlloc][iPhase])
+               adBest[iAlloc][iPhase] = adSeconds[iPhase];
+         if(ulRound == 0 || dMisses < adBestMisses[iAlloc])
+            adBestMisses[iAlloc] = dMisses;
+      }
+   }
+
+   printf("%lu files, %lu per directory, best of %lu rounds "
+          "(ns per file)\n", (unsigned long) ulFiles,
+          (unsigned long) ulFanout, (unsigned long) ulRounds);
+   printf("%-8s", "");
+   for(iPhase = 0; iPhase < NUM_PHASES; iPhase++)
+      printf("%10s", apcPhases[iPhase]);
+   printf("%10s\n", "dTLB/lkp");
+   for(iAlloc = 0; iAlloc < NUM_ALLOCS; iAlloc++) {
+      printf("%-8s", apcAllocs[iAlloc]);
+      for(iPhase = 0; iPhase < NUM_PHASES; iPhase++)
+         printf("%10.1f", adBest[iAlloc][iPhase] * 1e9 /
+                (double) ulFiles);
+      if(adBestMisses[iAlloc] < 0)
+         printf("%10s\n", "n/a");
+      else
+         printf("%10.2f\n", adBestMisses[iAlloc] / (double) ulFiles);
+   }
+   PoolAlloc_getStats(oPool, &sStats);
+   printf("pool: %lu slabs, %lu KiB\n", (unsigned long) sStats.ulSlabs,
+          (unsigned long) (sStats.ulSlabBytes / 1024));
+   PoolAlloc_getStats(oHugePool, &sStats);
+   printf("huge: %lu slabs, %lu KiB, %lu on huge pages\n",
+          (unsigned long) sStats.ulSlabs,
+          (unsigned long) (sStats.ulSlabBytes / 1024),
+          (unsigned long) sStats.ulHugeSlabs);
+   if(iTlbCounter < 0)
+      printf("(data TLB misses cannot be counted here)\n");
+   else
+      (void) close(iTlbCounter);
+
+   PoolAlloc_free(oHugePool);
+   PoolAlloc_free(oPool);
+   for(i = 0; i < ulFiles; i++)
+      free(ppcPaths[i]);
+   free(ppcPaths);
+   free(pulOrder);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/*--------------------------------------------------------------------*/
+/* archivebench.c                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  archivebench measures how small FT_archive's archives are and how
+  fast they answer lookups.
+
+  Usage: archivebench [-n files] [-f fanout] [-q lookups]
+
+  It inserts n files archivebench/dI/eJ/fK, spread over f directories
+  of f subdirectories each, and archives the FT. It checks that
+  FTArchive_toString gives the FT_toString text, then reports the
+  bits per node FTArchive_getStats finds for the tree, the labels and
+  the whole archive, and the bytes of the component dictionary. Last
+  it looks up q random files and directories with FTArchive_lookup
+  and with FT_stat, checking every answer, and reports the
+  nanoseconds per lookup of each.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "a4def.h"
+#include "ft.h"
+#include "benchutil.h"
+#include "ftarchive.h"
+
+/* Contents of every file; the FT only keeps a pointer to it */
+static char cContents = 'x';
+
+/*--------------------------------------------------------------------*/
+
+/* Writes into pcPath the path of file ulFile, the files being spread
+   over ulFanout directories of ulFanout subdirectories each; if bDir,
+   the path of its directory instead. */
+static void ArchiveBench_path(char *pcPath, size_t ulFile,
+                              size_t ulFanout, boolean bDir) {
+   pcPath += sprintf(pcPath, "archivebench/d%lu/e%lu",
+                     (unsigned long) (ulFile % ulFanout),
+                     (unsigned long) (ulFile / ulFanout % ulFanout));
+   if(!bDir)
+      sprintf(pcPath, "/f%lu", (unsigned long) ulFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 200000, ulFanout = 32, ulLookups = 200000, i;
+   size_t ulFile, ulSize;
+   char acPath[BENCH_MAX_PATH];
+   char *pcExpected, *pcString;
+   FTArchive_T oAArchive;
+   struct FTArchiveStats sStats;
+   boolean bIsFile, bDir;
+   unsigned long ulState = 1;
+   double dStart, dArchive, dFT, dNodes;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'f', "fanout", &ulFanout, FALSE },
+      { 'q', "lookups", &ulLookups, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      ArchiveBench_path(acPath, i, ulFanout, FALSE);
+      if(FT_insertFile(acPath, &cContents, 1) != SUCCESS) {
+         fprintf(stderr, "%s: inserting %s failed\n", argv[0], acPath);
+         return EXIT_FAILURE;
+      }
+   }
+
+   dStart = Bench_now();
+   if(FT_archive(&oAArchive) != SUCCESS)
+      return EXIT_FAILURE;
+   dArchive = Bench_now() - dStart;
+
+   pcExpected = FT_toString();
+   pcString = FTArchive_toString(oAArchive);
+   if(pcExpected == NULL || pcString == NULL)
+      return EXIT_FAILURE;
+   if(strcmp(pcString, pcExpected) != 0) {
+      fprintf(stderr, "%s: FTArchive_toString differs from "
+              "FT_toString\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   free(pcExpected);
+   free(pcString);
+
+   FTArchive_getStats(oAArchive, &sStats);
+   dNodes = (double) sStats.ulNodes;
+   printf("%lu nodes archived in %.3f s\n",
+          (unsigned long) sStats.ulNodes, dArchive);
+   printf("tree %.2f bits/node, labels %.2f bits/node, "
+          "dictionary %lu bytes\n", (double) sStats.ulTreeBits / dNodes,
+          (double) sStats.ulLabelBits / dNodes,
+          (unsigned long) sStats.ulDictBytes);
+   printf("archive %.2f bits/node, %lu bytes\n",
+          (double) sStats.ulTotalBytes * 8.0 / dNodes,
+          (unsigned long) sStats.ulTotalBytes);
+
+   /* The same random paths each way: a quarter of them directories */
+   dStart = Bench_now();
+   for(i = 0; i < ulLookups; i++) {
+      ulFile = Bench_random(&ulState) % ulFiles;
+      bDir = (boolean) (Bench_random(&ulState) % 4 == 0);
+      ArchiveBench_path(acPath, ulFile, ulFanout, bDir);
+      if(FTArchive_lookup(oAArchive, acPath, &bIsFile) != SUCCESS ||
+         bIsFile == bDir) {
+         fprintf(stderr, "%s: FTArchive_lookup of %s failed\n", argv[0],
+                 acPath);
+         return EXIT_FAILURE;
+      }
+   }
+   dArchive = Bench_now() - dStart;
+
+   ulState = 1;
+   dStart = Bench_now();
+   for(i = 0; i < ulLookups; i++) {
+      ulFile = Bench_random(&ulState) % ulFiles;
+      bDir = (boolean) (Bench_random(&ulState) % 4 == 0);
+      ArchiveBench_path(acPath, ulFile, ulFanout, bDir);
+      if(FT_stat(acPath, &bIsFile, &ulSize) != SUCCESS ||
+         bIsFile == bDir) {
+         fprintf(stderr, "%s: FT_stat of %s failed\n", argv[0], acPath);
+         return EXIT_FAILURE;
+      }
+   }
+   dFT = Bench_now() - dStart;
+   printf("lookup: archive %.0f ns, FT %.0f ns\n",
+          dArchive / (double) ulLookups * 1e9,
+          dFT / (double) ulLookups * 1e9);
+
+   FTArchive_free(oAArchive);
+   if(FT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+   return EXIT_SUCCESS;
+}
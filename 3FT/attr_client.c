@@ -0,0 +1,292 @@
+/*--------------------------------------------------------------------*/
+/* attr_client.c                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  attr_client checks FT_setAttr, FT_getAttr, FT_removeAttr,
+  FT_indexAttr and FT_findByAttr against a table of the attributes
+  set.
+
+  Usage: attr_client [-r rounds] [-s seed]
+
+  Each round works on the 40 paths of up to four levels below r with
+  components "a", "b" and "c", inserting them as files or directories
+  and removing them at random, and setting and removing attributes
+  under three keys. Values are integers and strings, some equal but
+  for their type. Two of the keys are indexed, one from the start and
+  one once the tree has attributes. Every attribute must read back as
+  set, disappear with its node, and survive a detach and graft of a
+  directory above it; set strings must be copies. FT_findByAttr must
+  find exactly the nodes with each value of an indexed key, and fail
+  for the key never indexed.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* The paths worked on: r and its descendants to 3 levels, 3 wide */
+enum { NUM_PATHS = 1 + 3 + 9 + 27 };
+
+/* Longest path, including its terminator */
+enum { MAX_PATH = 8 };
+
+/* Keys used, and the values they take */
+enum { NUM_KEYS = 3, NUM_VALUES = 6 };
+
+/* Calls made in each round, and the call at which the second key is
+   indexed */
+enum { NUM_CALLS = 300, LATE_INDEX = NUM_CALLS / 2 };
+
+/* Longest string value, including its terminator */
+enum { MAX_STRING = 8 };
+
+/* The keys: indexed from the start, indexed late, never indexed */
+static const char *apcKeys[NUM_KEYS] = { "owner", "type", "mtime" };
+
+/* The values set */
+static const struct AttrValue asValues[NUM_VALUES] = {
+   { ATTR_INT, 0, NULL },
+   { ATTR_INT, 1, NULL },
+   { ATTR_INT, -7, NULL },
+   { ATTR_STRING, 0, "1" },
+   { ATTR_STRING, 0, "bob" },
+   { ATTR_STRING, 0, "" }
+};
+
+/* The paths, and the value of each key of each, or -1 if unset */
+static char aacPaths[NUM_PATHS][MAX_PATH];
+static int aaiValues[NUM_PATHS][NUM_KEYS];
+
+/* Whether each key is indexed */
+static boolean abIndexed[NUM_KEYS];
+
+/*--------------------------------------------------------------------*/
+
+/* Counts the path written next in aacPaths, ulDepth levels deep, and
+   appends its descendants, in preorder, which is also the order of
+   strcmp. */
+static void AttrClient_paths(size_t ulDepth) {
+   static size_t ulNumPaths;
+   size_t ulOwn = ulNumPaths++;
+   char acPath[MAX_PATH];
+   size_t ulLength;
+   int iChild;
+
+   if(ulDepth == 4)
+      return;
+   for(iChild = 0; iChild < 3; iChild++) {
+      strcpy(acPath, aacPaths[ulOwn]);
+      ulLength = strlen(acPath);
+      acPath[ulLength] = '/';
+      acPath[ulLength + 1] = (char) ('a' + iChild);
+      acPath[ulLength + 2] = '\0';
+      strcpy(aacPaths[ulNumPaths], acPath);
+      AttrClient_paths(ulDepth + 1);
+   }
+}
+
+/* Returns TRUE if the values at psFirst and psSecond are equal, FALSE
+   otherwise. */
+static boolean AttrClient_equal(const struct AttrValue *psFirst,
+                                const struct AttrValue *psSecond) {
+   if(psFirst->eType != psSecond->eType)
+      return FALSE;
+   if(psFirst->eType == ATTR_INT)
+      return (boolean) (psFirst->lInt == psSecond->lInt);
+   return (boolean) (strcmp(psFirst->pcString, psSecond->pcString) == 0);
+}
+
+/* Compares the pathnames pvFirst and pvSecond. */
+static int AttrClient_compare(const void *pvFirst,
+                              const void *pvSecond) {
+   return strcmp((const char *) pvFirst, (const char *) pvSecond);
+}
+
+/* Forgets the attributes of every path no longer in the FT. */
+static void AttrClient_forget(void) {
+   size_t i, j;
+
+   for(i = 0; i < NUM_PATHS; i++)
+      if(!FT_containsDir(aacPaths[i]) && !FT_containsFile(aacPaths[i]))
+         for(j = 0; j < NUM_KEYS; j++)
+            aaiValues[i][j] = -1;
+}
+
+/* Sets key iKey of path ulPath to value iValue, passing a string
+   value through a buffer that is then overwritten. */
+static void AttrClient_set(size_t ulPath, int iKey, int iValue) {
+   char acString[MAX_STRING];
+   struct AttrValue sValue = asValues[iValue];
+   boolean bExists;
+   int iStatus;
+
+   if(sValue.eType == ATTR_STRING) {
+      strcpy(acString, sValue.pcString);
+      sValue.pcString = acString;
+   }
+   bExists = (boolean) (FT_containsDir(aacPaths[ulPath]) ||
+                        FT_containsFile(aacPaths[ulPath]));
+   iStatus = FT_setAttr(aacPaths[ulPath], apcKeys[iKey], &sValue);
+   memset(acString, '?', sizeof(acString) - 1);
+   acString[sizeof(acString) - 1] = '\0';
+   if(bExists) {
+      assert(iStatus == SUCCESS);
+      aaiValues[ulPath][iKey] = iValue;
+   }
+   else
+      assert(iStatus == NO_SUCH_PATH);
+}
+
+/* Checks every attribute of every path, and FT_findByAttr on every
+   value of every key. */
+static void AttrClient_check(void) {
+   const char *apcExpected[NUM_PATHS];
+   struct AttrValue sValue;
+   DynArray_T oDResult;
+   size_t ulExpected, i;
+   int iKey, iValue;
+
+   for(i = 0; i < NUM_PATHS; i++)
+      for(iKey = 0; iKey < NUM_KEYS; iKey++) {
+         iValue = aaiValues[i][iKey];
+         if(iValue < 0) {
+            assert(FT_getAttr(aacPaths[i], apcKeys[iKey], &sValue) ==
+                   NO_SUCH_PATH);
+            continue;
+         }
+         assert(FT_getAttr(aacPaths[i], apcKeys[iKey], &sValue) ==
+                SUCCESS);
+         assert(AttrClient_equal(&sValue, &asValues[iValue]));
+      }
+
+   for(iKey = 0; iKey < NUM_KEYS; iKey++)
+      for(iValue = 0; iValue < NUM_VALUES; iValue++) {
+         if(!abIndexed[iKey]) {
+            oDResult = (DynArray_T) &ulExpected;
+            assert(FT_findByAttr(apcKeys[iKey], &asValues[iValue],
+                                 &oDResult) == INITIALIZATION_ERROR);
+            assert(oDResult == NULL);
+            continue;
+         }
+
+         /* The same paths, in any order */
+         ulExpected = 0;
+         for(i = 0; i < NUM_PATHS; i++)
+            if(aaiValues[i][iKey] >= 0 &&
+               AttrClient_equal(&asValues[aaiValues[i][iKey]],
+                                &asValues[iValue]))
+               apcExpected[ulExpected++] = aacPaths[i];
+         assert(FT_findByAttr(apcKeys[iKey], &asValues[iValue],
+                              &oDResult) == SUCCESS);
+         assert(DynArray_getLength(oDResult) == ulExpected);
+         DynArray_sort(oDResult, AttrClient_compare);
+         for(i = 0; i < ulExpected; i++)
+            assert(strcmp(DynArray_get(oDResult, i), apcExpected[i]) ==
+                   0);
+         DynArray_free(oDResult);
+      }
+}
+
+/* Makes one random call, or a detach and graft, on path ulPath. */
+static void AttrClient_call(size_t ulPath) {
+   FTSubtree_T oSSubtree;
+   int iKey = rand() % NUM_KEYS;
+   int iStatus;
+
+   switch(rand() % 10) {
+      case 0: case 1: case 2: case 3:
+         AttrClient_set(ulPath, iKey, rand() % NUM_VALUES);
+         break;
+      case 4:
+         iStatus = FT_removeAttr(aacPaths[ulPath], apcKeys[iKey]);
+         assert(iStatus == (aaiValues[ulPath][iKey] < 0 ?
+                            NO_SUCH_PATH : SUCCESS));
+         aaiValues[ulPath][iKey] = -1;
+         break;
+      case 5: case 6:
+         if(rand() % 3 == 0)
+            (void) FT_insertFile(aacPaths[ulPath], NULL, 0);
+         else
+            (void) FT_insertDir(aacPaths[ulPath]);
+         break;
+      case 7:
+         if(FT_containsFile(aacPaths[ulPath]))
+            assert(FT_rmFile(aacPaths[ulPath]) == SUCCESS);
+         else if(ulPath != 0 || rand() % 4 == 0)
+            (void) FT_rmDir(aacPaths[ulPath]);
+         AttrClient_forget();
+         break;
+      case 8:
+         /* Attributes move with their nodes */
+         if(FT_containsDir(aacPaths[ulPath])) {
+            assert(FT_detachSubtree(aacPaths[ulPath], &oSSubtree) ==
+                   SUCCESS);
+            assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) ==
+                   SUCCESS);
+         }
+         break;
+      default:
+         AttrClient_check();
+         break;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 10, ulSeed = 1, r;
+   struct AttrValue sValue;
+   size_t i;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+   strcpy(aacPaths[0], "r");
+   AttrClient_paths(1);
+
+   assert(FT_setAttr("r", "owner", &asValues[0]) == INITIALIZATION_ERROR);
+   assert(FT_getAttr("r", "owner", &sValue) == INITIALIZATION_ERROR);
+   assert(FT_indexAttr("owner") == INITIALIZATION_ERROR);
+   for(r = 0; r < ulRounds; r++) {
+      assert(FT_init() == SUCCESS);
+      memset(aaiValues, -1, sizeof(aaiValues));
+      memset(abIndexed, 0, sizeof(abIndexed));
+      assert(FT_indexAttr(apcKeys[0]) == SUCCESS);
+      abIndexed[0] = TRUE;
+      assert(FT_insertDir("r") == SUCCESS);
+      assert(FT_setAttr("r//a", "owner", &asValues[0]) == BAD_PATH);
+      assert(FT_setAttr("x/a", "owner", &asValues[0]) ==
+             CONFLICTING_PATH);
+
+      for(i = 0; i < NUM_CALLS; i++) {
+         if(i == LATE_INDEX) {
+            assert(FT_indexAttr(apcKeys[1]) == SUCCESS);
+            assert(FT_indexAttr(apcKeys[1]) == SUCCESS);
+            abIndexed[1] = TRUE;
+         }
+         AttrClient_call((size_t) rand() % NUM_PATHS);
+      }
+      AttrClient_check();
+      assert(FT_destroy() == SUCCESS);
+   }
+
+   printf("%lu rounds of attributes matched\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+/*--------------------------------------------------------------------*/
+/* attrindex.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "attrindex.h"
+
+/* The initial number of buckets in the hash table */
+enum { INITIAL_BUCKETS = 64 };
+
+/* One (key, value) -> path record */
+struct attrEntry {
+   /* Hash of the key and value */
+   unsigned long ulHash;
+
+   /* The attribute key */
+   size_t ulKey;
+
+   /* Private copy of the attribute value */
+   enum AttrType eType;
+   long lInt;
+   char *pcString;
+
+   /* Path of the node carrying the attribute */
+   Path_T oPPath;
+
+   /* Next record in the same bucket */
+   struct attrEntry *psNext;
+};
+
+/* A chained hash table of records */
+struct attrIndex {
+   /* Array of bucket chains */
+   struct attrEntry **ppsBuckets;
+
+   /* Number of buckets, always a power of two */
+   size_t ulNumBuckets;
+
+   /* Number of records */
+   size_t ulLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the FNV-1a hash of key ulKey with value *psValue. */
+static unsigned long AttrIndex_hash(size_t ulKey,
+                                    const struct AttrValue *psValue) {
+   unsigned long ulHash = 2166136261UL;
+   unsigned long ulWord;
+   const char *pc;
+   size_t i;
+
+   assert(psValue != NULL);
+
+   ulWord = (unsigned long) ulKey;
+   for(i = 0; i < sizeof(ulWord); i++) {
+      ulHash = (ulHash ^ (ulWord & 0xffUL)) * 16777619UL;
+      ulWord >>= 8;
+   }
+   if(psValue->eType == ATTR_INT) {
+      ulWord = (unsigned long) psValue->lInt;
+      for(i = 0; i < sizeof(ulWord); i++) {
+         ulHash = (ulHash ^ (ulWord & 0xffUL)) * 16777619UL;
+         ulWord >>= 8;
+      }
+   }
+   else
+      for(pc = psValue->pcString; *pc != '\0'; pc++)
+         ulHash = (ulHash ^ (unsigned char) *pc) * 16777619UL;
+   return ulHash;
+}
+
+/* Returns TRUE if psEntry records key ulKey with value *psValue. */
+static boolean AttrIndex_matches(const struct attrEntry *psEntry,
+                                 unsigned long ulHash, size_t ulKey,
+                                 const struct AttrValue *psValue) {
+   assert(psEntry != NULL);
+   assert(psValue != NULL);
+
+   if(psEntry->ulHash != ulHash || psEntry->ulKey != ulKey ||
+      psEntry->eType != psValue->eType)
+      return FALSE;
+   if(psValue->eType == ATTR_INT)
+      return (boolean) (psEntry->lInt == psValue->lInt);
+   return (boolean) (strcmp(psEntry->pcString, psValue->pcString) == 0);
+}
+
+/* Doubles the number of buckets of oAIndex, leaving it unchanged if
+   allocation fails. */
+static void AttrIndex_grow(AttrIndex_T oAIndex) {
+   struct attrEntry **ppsNew;
+   struct attrEntry *psEntry;
+   size_t ulNewNum, i;
+
+   assert(oAIndex != NULL);
+
+   ulNewNum = oAIndex->ulNumBuckets * 2;
+   ppsNew = calloc(ulNewNum, sizeof(struct attrEntry *));
+   if(ppsNew == NULL)
+      return;
+
+   for(i = 0; i < oAIndex->ulNumBuckets; i++) {
+      while((psEntry = oAIndex->ppsBuckets[i]) != NULL) {
+         oAIndex->ppsBuckets[i] = psEntry->psNext;
+         psEntry->psNext = ppsNew[psEntry->ulHash & (ulNewNum - 1)];
+         ppsNew[psEntry->ulHash & (ulNewNum - 1)] = psEntry;
+      }
+   }
+   free(oAIndex->ppsBuckets);
+   oAIndex->ppsBuckets = ppsNew;
+   oAIndex->ulNumBuckets = ulNewNum;
+}
+
+/* ================================================================== */
+AttrIndex_T AttrIndex_new(void) {
+   AttrIndex_T oAIndex;
+
+   oAIndex = malloc(sizeof(struct attrIndex));
+   if(oAIndex == NULL)
+      return NULL;
+   oAIndex->ppsBuckets = calloc(INITIAL_BUCKETS,
+                                sizeof(struct attrEntry *));
+   if(oAIndex->ppsBuckets == NULL) {
+      free(oAIndex);
+      return NULL;
+   }
+   oAIndex->ulNumBuckets = INITIAL_BUCKETS;
+   oAIndex->ulLength = 0;
+   return oAIndex;
+}
+
+/* ================================================================== */
+void AttrIndex_free(AttrIndex_T oAIndex) {
+   struct attrEntry *psEntry;
+   size_t i;
+
+   assert(oAIndex != NULL);
+
+   for(i = 0; i < oAIndex->ulNumBuckets; i++) {
+      while((psEntry = oAIndex->ppsBuckets[i]) != NULL) {
+         oAIndex->ppsBuckets[i] = psEntry->psNext;
+         free(psEntry->pcString);
+         free(psEntry);
+      }
+   }
+   free(oAIndex->ppsBuckets);
+   free(oAIndex);
+}
+
+/* ================================================================== */
+int AttrIndex_insert(AttrIndex_T oAIndex, size_t ulKey,
+                     const struct AttrValue *psValue, Path_T oPPath) {
+   struct attrEntry *psNew;
+   size_t ulBucket;
+
+   assert(oAIndex != NULL);
+   assert(psValue != NULL);
+   assert(oPPath != NULL);
+
+   psNew = malloc(sizeof(struct attrEntry));
+   if(psNew == NULL)
+      return MEMORY_ERROR;
+   psNew->ulHash = AttrIndex_hash(ulKey, psValue);
+   psNew->ulKey = ulKey;
+   psNew->eType = psValue->eType;
+   psNew->lInt = psValue->lInt;
+   psNew->pcString = NULL;
+   if(psValue->eType == ATTR_STRING) {
+      psNew->pcString = malloc(strlen(psValue->pcString) + 1);
+      if(psNew->pcString == NULL) {
+         free(psNew);
+         return MEMORY_ERROR;
+      }
+      strcpy(psNew->pcString, psValue->pcString);
+   }
+   psNew->oPPath = oPPath;
+
+   if(oAIndex->ulLength >= 2 * oAIndex->ulNumBuckets)
+      AttrIndex_grow(oAIndex);
+   ulBucket = psNew->ulHash & (oAIndex->ulNumBuckets - 1);
+   psNew->psNext = oAIndex->ppsBuckets[ulBucket];
+   oAIndex->ppsBuckets[ulBucket] = psNew;
+   oAIndex->ulLength++;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void AttrIndex_remove(AttrIndex_T oAIndex, size_t ulKey,
+                      const struct AttrValue *psValue, Path_T oPPath) {
+   struct attrEntry **ppsLink;
+   struct attrEntry *psEntry;
+   unsigned long ulHash;
+
+   assert(oAIndex != NULL);
+   assert(psValue != NULL);
+   assert(oPPath != NULL);
+
+   ulHash = AttrIndex_hash(ulKey, psValue);
+   ppsLink = &oAIndex->ppsBuckets[ulHash & (oAIndex->ulNumBuckets - 1)];
+   while((psEntry = *ppsLink) != NULL) {
+      if(psEntry->oPPath == oPPath &&
+         AttrIndex_matches(psEntry, ulHash, ulKey, psValue)) {
+         *ppsLink = psEntry->psNext;
+         free(psEntry->pcString);
+         free(psEntry);
+         oAIndex->ulLength--;
+         return;
+      }
+      ppsLink = &psEntry->psNext;
+   }
+}
+
+/* ================================================================== */
+int AttrIndex_lookup(AttrIndex_T oAIndex, size_t ulKey,
+                     const struct AttrValue *psValue,
+                     DynArray_T oDResult) {
+   struct attrEntry *psEntry;
+   unsigned long ulHash;
+
+   assert(oAIndex != NULL);
+   assert(psValue != NULL);
+   assert(oDResult != NULL);
+
+   ulHash = AttrIndex_hash(ulKey, psValue);
+   for(psEntry = oAIndex->ppsBuckets[ulHash &
+                                     (oAIndex->ulNumBuckets - 1)];
+       psEntry != NULL; psEntry = psEntry->psNext)
+      if(AttrIndex_matches(psEntry, ulHash, ulKey, psValue) &&
+         !DynArray_add(oDResult, Path_getPathname(psEntry->oPPath)))
+         return MEMORY_ERROR;
+   return SUCCESS;
+}
@@ -0,0 +1,55 @@
+/*--------------------------------------------------------------------*/
+/* attrindex.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef ATTRINDEX_INCLUDED
+#define ATTRINDEX_INCLUDED
+
+/*
+  An attribute index is a reverse index from (attribute key, value)
+  pairs to the paths of the nodes carrying them, kept in a chained
+  hash table that doubles as it fills.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "dynarray.h"
+#include "path.h"
+#include "attrs.h"
+
+/* An AttrIndex_T maps attribute values to node paths */
+typedef struct attrIndex *AttrIndex_T;
+
+/* Returns a new, empty attribute index, or NULL if insufficient
+   memory is available. */
+AttrIndex_T AttrIndex_new(void);
+
+/* Destroys oAIndex. The paths it refers to are not freed. */
+void AttrIndex_free(AttrIndex_T oAIndex);
+
+/*
+  Records that the node with path oPPath has attribute ulKey with value
+  *psValue. oPPath must outlive the entry. Returns SUCCESS, or
+  MEMORY_ERROR if allocation fails.
+*/
+int AttrIndex_insert(AttrIndex_T oAIndex, size_t ulKey,
+                     const struct AttrValue *psValue, Path_T oPPath);
+
+/*
+  Removes the record that the node with path oPPath has attribute
+  ulKey with value *psValue, if there is one.
+*/
+void AttrIndex_remove(AttrIndex_T oAIndex, size_t ulKey,
+                      const struct AttrValue *psValue, Path_T oPPath);
+
+/*
+  Appends to oDResult the pathname of every node recorded as having
+  attribute ulKey with value *psValue. Returns SUCCESS, or MEMORY_ERROR
+  if oDResult could not grow.
+*/
+int AttrIndex_lookup(AttrIndex_T oAIndex, size_t ulKey,
+                     const struct AttrValue *psValue,
+                     DynArray_T oDResult);
+
+#endif
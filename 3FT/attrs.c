@@ -0,0 +1,305 @@
+/*--------------------------------------------------------------------*/
+/* attrs.c                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "dynarray.h"
+#include "attrs.h"
+
+/* One attribute, packed as tightly as its value allows */
+struct attr {
+   /* Interned key identifier */
+   unsigned int uKey;
+
+   /* An enum AttrType value */
+   unsigned char ucType;
+
+   /* The value itself; strings are owned by the set */
+   union {
+      long lInt;
+      char *pcString;
+   } uValue;
+};
+
+/* An attribute set: a length followed directly by its attributes,
+   sorted by key, in one allocation */
+struct attrs {
+   /* Number of attributes in asAttrs */
+   size_t ulLength;
+
+   /* The attributes; really ulLength of them */
+   struct attr asAttrs[1];
+};
+
+/* A registered key */
+struct keyInfo {
+   /* The key's name */
+   char *pcName;
+
+   /* Whether the key has a reverse index */
+   boolean bIndexed;
+};
+
+/* The key registry: struct keyInfo pointers, indexed by identifier */
+static DynArray_T oDKeys;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the number of bytes an attribute set of ulLength attributes
+   occupies. */
+static size_t Attrs_sizeFor(size_t ulLength) {
+   return sizeof(struct attrs) +
+          (ulLength == 0 ? 0 : ulLength - 1) * sizeof(struct attr);
+}
+
+/* Binary searches oAAttrs for key ulKey. Stores its position, or the
+   position it would have, in *pulIndex. Returns TRUE if found. */
+static boolean Attrs_find(Attrs_T oAAttrs, size_t ulKey,
+                          size_t *pulIndex) {
+   size_t ulLow = 0, ulHigh, ulMid;
+
+   assert(pulIndex != NULL);
+
+   ulHigh = oAAttrs == NULL ? 0 : oAAttrs->ulLength;
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      if(oAAttrs->asAttrs[ulMid].uKey < ulKey)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   *pulIndex = ulLow;
+   return (boolean) (oAAttrs != NULL && ulLow < oAAttrs->ulLength &&
+                     oAAttrs->asAttrs[ulLow].uKey == ulKey);
+}
+
+/* Stores the value of psAttr in *psValue. */
+static void Attrs_unpack(const struct attr *psAttr,
+                         struct AttrValue *psValue) {
+   assert(psAttr != NULL);
+   assert(psValue != NULL);
+
+   psValue->eType = (enum AttrType) psAttr->ucType;
+   psValue->lInt = 0;
+   psValue->pcString = NULL;
+   if(psValue->eType == ATTR_INT)
+      psValue->lInt = psAttr->uValue.lInt;
+   else
+      psValue->pcString = psAttr->uValue.pcString;
+}
+
+/* ================================================================== */
+int Attrs_getKey(const char *pcKey, boolean bCreate, size_t *pulKey) {
+   struct keyInfo *psKey;
+   size_t i;
+
+   assert(pcKey != NULL);
+   assert(pulKey != NULL);
+
+   /* Applications use a handful of keys, so a linear scan suffices */
+   if(oDKeys != NULL) {
+      for(i = 0; i < DynArray_getLength(oDKeys); i++) {
+         psKey = DynArray_get(oDKeys, i);
+         if(strcmp(psKey->pcName, pcKey) == 0) {
+            *pulKey = i;
+            return SUCCESS;
+         }
+      }
+   }
+   if(!bCreate)
+      return NO_SUCH_PATH;
+
+   if(oDKeys == NULL) {
+      oDKeys = DynArray_new(0);
+      if(oDKeys == NULL)
+         return MEMORY_ERROR;
+   }
+   psKey = malloc(sizeof(struct keyInfo));
+   if(psKey == NULL)
+      return MEMORY_ERROR;
+   psKey->pcName = malloc(strlen(pcKey) + 1);
+   if(psKey->pcName == NULL) {
+      free(psKey);
+      return MEMORY_ERROR;
+   }
+   strcpy(psKey->pcName, pcKey);
+   psKey->bIndexed = FALSE;
+   if(!DynArray_add(oDKeys, psKey)) {
+      free(psKey->pcName);
+      free(psKey);
+      return MEMORY_ERROR;
+   }
+
+   *pulKey = DynArray_getLength(oDKeys) - 1;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void Attrs_setIndexed(size_t ulKey, boolean bIndexed) {
+   struct keyInfo *psKey;
+
+   assert(oDKeys != NULL);
+   assert(ulKey < DynArray_getLength(oDKeys));
+
+   psKey = DynArray_get(oDKeys, ulKey);
+   psKey->bIndexed = bIndexed;
+}
+
+/* ================================================================== */
+boolean Attrs_isIndexed(size_t ulKey) {
+   struct keyInfo *psKey;
+
+   if(oDKeys == NULL || ulKey >= DynArray_getLength(oDKeys))
+      return FALSE;
+   psKey = DynArray_get(oDKeys, ulKey);
+   return psKey->bIndexed;
+}
+
+/* ================================================================== */
+void Attrs_clearIndexed(void) {
+   struct keyInfo *psKey;
+   size_t i;
+
+   if(oDKeys == NULL)
+      return;
+   for(i = 0; i < DynArray_getLength(oDKeys); i++) {
+      psKey = DynArray_get(oDKeys, i);
+      psKey->bIndexed = FALSE;
+   }
+}
+
+/* ================================================================== */
+void Attrs_resetKeys(void) {
+   struct keyInfo *psKey;
+   size_t i;
+
+   if(oDKeys == NULL)
+      return;
+   for(i = 0; i < DynArray_getLength(oDKeys); i++) {
+      psKey = DynArray_get(oDKeys, i);
+      free(psKey->pcName);
+      free(psKey);
+   }
+   DynArray_free(oDKeys);
+   oDKeys = NULL;
+}
+
+/* ================================================================== */
+int Attrs_set(Attrs_T *poAAttrs, size_t ulKey,
+              const struct AttrValue *psValue) {
+   Attrs_T oAAttrs;
+   struct attr sNew;
+   size_t ulIndex, ulLength;
+
+   assert(poAAttrs != NULL);
+   assert(psValue != NULL);
+
+   /* Build the new attribute first so that failure changes nothing */
+   sNew.uKey = (unsigned int) ulKey;
+   sNew.ucType = (unsigned char) psValue->eType;
+   if(psValue->eType == ATTR_INT)
+      sNew.uValue.lInt = psValue->lInt;
+   else {
+      assert(psValue->pcString != NULL);
+      sNew.uValue.pcString = malloc(strlen(psValue->pcString) + 1);
+      if(sNew.uValue.pcString == NULL)
+         return MEMORY_ERROR;
+      strcpy(sNew.uValue.pcString, psValue->pcString);
+   }
+
+   oAAttrs = *poAAttrs;
+
+   /* Overwrite an existing attribute in place */
+   if(Attrs_find(oAAttrs, ulKey, &ulIndex)) {
+      if(oAAttrs->asAttrs[ulIndex].ucType == ATTR_STRING)
+         free(oAAttrs->asAttrs[ulIndex].uValue.pcString);
+      oAAttrs->asAttrs[ulIndex] = sNew;
+      return SUCCESS;
+   }
+
+   /* Otherwise grow the set by one and shift the larger keys up */
+   ulLength = oAAttrs == NULL ? 0 : oAAttrs->ulLength;
+   oAAttrs = realloc(oAAttrs, Attrs_sizeFor(ulLength + 1));
+   if(oAAttrs == NULL) {
+      if(sNew.ucType == ATTR_STRING)
+         free(sNew.uValue.pcString);
+      return MEMORY_ERROR;
+   }
+   memmove(&oAAttrs->asAttrs[ulIndex + 1], &oAAttrs->asAttrs[ulIndex],
+           (ulLength - ulIndex) * sizeof(struct attr));
+   oAAttrs->asAttrs[ulIndex] = sNew;
+   oAAttrs->ulLength = ulLength + 1;
+
+   *poAAttrs = oAAttrs;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+boolean Attrs_get(Attrs_T oAAttrs, size_t ulKey,
+                  struct AttrValue *psValue) {
+   size_t ulIndex;
+
+   assert(psValue != NULL);
+
+   if(!Attrs_find(oAAttrs, ulKey, &ulIndex))
+      return FALSE;
+   Attrs_unpack(&oAAttrs->asAttrs[ulIndex], psValue);
+   return TRUE;
+}
+
+/* ================================================================== */
+boolean Attrs_remove(Attrs_T *poAAttrs, size_t ulKey) {
+   Attrs_T oAAttrs;
+   size_t ulIndex;
+
+   assert(poAAttrs != NULL);
+
+   oAAttrs = *poAAttrs;
+   if(!Attrs_find(oAAttrs, ulKey, &ulIndex))
+      return FALSE;
+
+   if(oAAttrs->asAttrs[ulIndex].ucType == ATTR_STRING)
+      free(oAAttrs->asAttrs[ulIndex].uValue.pcString);
+   oAAttrs->ulLength--;
+   memmove(&oAAttrs->asAttrs[ulIndex], &oAAttrs->asAttrs[ulIndex + 1],
+           (oAAttrs->ulLength - ulIndex) * sizeof(struct attr));
+
+   /* An empty set is represented by NULL; otherwise the set is left
+      at its current size, since shrinking it cannot fail usefully */
+   if(oAAttrs->ulLength == 0) {
+      free(oAAttrs);
+      *poAAttrs = NULL;
+   }
+   return TRUE;
+}
+
+/* ================================================================== */
+size_t Attrs_getLength(Attrs_T oAAttrs) {
+   return oAAttrs == NULL ? 0 : oAAttrs->ulLength;
+}
+
+/* ================================================================== */
+void Attrs_getAt(Attrs_T oAAttrs, size_t ulIndex, size_t *pulKey,
+                 struct AttrValue *psValue) {
+   assert(oAAttrs != NULL);
+   assert(ulIndex < oAAttrs->ulLength);
+   assert(pulKey != NULL);
+
+   *pulKey = oAAttrs->asAttrs[ulIndex].uKey;
+   Attrs_unpack(&oAAttrs->asAttrs[ulIndex], psValue);
+}
+
+/* ================================================================== */
+void Attrs_free(Attrs_T oAAttrs) {
+   size_t i;
+
+   if(oAAttrs == NULL)
+      return;
+   for(i = 0; i < oAAttrs->ulLength; i++)
+      if(oAAttrs->asAttrs[i].ucType == ATTR_STRING)
+         free(oAAttrs->asAttrs[i].uValue.pcString);
+   free(oAAttrs);
+}
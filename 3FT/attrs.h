@@ -0,0 +1,98 @@
+/*--------------------------------------------------------------------*/
+/* attrs.h                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef ATTRS_INCLUDED
+#define ATTRS_INCLUDED
+
+/*
+  An attribute set is a compact, typed collection of metadata attached
+  to one tree node: a single allocation holding (key, value) pairs
+  sorted by key. Keys are strings interned once into small integer
+  identifiers, so nodes never store key strings.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+
+/* An Attrs_T is the attribute set of one node (NULL when empty) */
+typedef struct attrs *Attrs_T;
+
+/* Types an attribute value may have */
+enum AttrType { ATTR_INT, ATTR_STRING };
+
+/* A typed attribute value */
+struct AttrValue {
+   /* Which of the fields below holds the value */
+   enum AttrType eType;
+
+   /* The value if eType is ATTR_INT */
+   long lInt;
+
+   /* The value if eType is ATTR_STRING */
+   const char *pcString;
+};
+
+/*
+  Stores in *pulKey the identifier of key pcKey, registering it if
+  bCreate is TRUE and it is not yet known. Returns SUCCESS if an
+  identifier was stored. Otherwise, returns:
+  * NO_SUCH_PATH if pcKey is not registered and bCreate is FALSE
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Attrs_getKey(const char *pcKey, boolean bCreate, size_t *pulKey);
+
+/* Marks key ulKey as having a reverse index (or not, if bIndexed is
+   FALSE). */
+void Attrs_setIndexed(size_t ulKey, boolean bIndexed);
+
+/* Returns TRUE if key ulKey has a reverse index, FALSE if not. */
+boolean Attrs_isIndexed(size_t ulKey);
+
+/* Marks every registered key as having no reverse index. */
+void Attrs_clearIndexed(void);
+
+/* Forgets every registered key. Attribute sets using them must have
+   been freed already. */
+void Attrs_resetKeys(void);
+
+/*
+  Sets attribute ulKey of the set *poAAttrs to the value *psValue
+  (copying string values), reallocating the set as needed and storing
+  its new address in *poAAttrs. Returns SUCCESS, or MEMORY_ERROR (with
+  the set unchanged) if allocation fails.
+*/
+int Attrs_set(Attrs_T *poAAttrs, size_t ulKey,
+              const struct AttrValue *psValue);
+
+/*
+  Stores the value of attribute ulKey of oAAttrs in *psValue. String
+  values remain owned by the set. Returns TRUE if the attribute is
+  present, FALSE if not.
+*/
+boolean Attrs_get(Attrs_T oAAttrs, size_t ulKey,
+                  struct AttrValue *psValue);
+
+/*
+  Removes attribute ulKey from the set *poAAttrs, storing NULL in
+  *poAAttrs if the set becomes empty. Returns TRUE if the attribute was
+  present, FALSE if not.
+*/
+boolean Attrs_remove(Attrs_T *poAAttrs, size_t ulKey);
+
+/* Returns the number of attributes in oAAttrs. */
+size_t Attrs_getLength(Attrs_T oAAttrs);
+
+/*
+  Stores the key and value of the attribute at position ulIndex (in
+  key order) of oAAttrs in *pulKey and *psValue. ulIndex must be less
+  than Attrs_getLength(oAAttrs).
+*/
+void Attrs_getAt(Attrs_T oAAttrs, size_t ulIndex, size_t *pulKey,
+                 struct AttrValue *psValue);
+
+/* Frees oAAttrs, which may be NULL, and the strings it holds. */
+void Attrs_free(Attrs_T oAAttrs);
+
+#endif
@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------*/
+/* benchutil.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "benchutil.h"
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the option of the ulNumOptions at psOptions named by the
+   argument pcArg, or NULL if there is none. */
+static const struct BenchOption *Bench_findOption(
+   const char *pcArg, const struct BenchOption *psOptions,
+   size_t ulNumOptions) {
+   size_t i;
+
+   if(pcArg[0] != '-' || pcArg[1] == '\0' || pcArg[2] != '\0')
+      return NULL;
+   for(i = 0; i < ulNumOptions; i++)
+      if(psOptions[i].cLetter == pcArg[1])
+         return &psOptions[i];
+   return NULL;
+}
+
+/* ================================================================== */
+double Bench_now(void) {
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double) sNow.tv_sec + (double) sNow.tv_nsec / 1e9;
+}
+
+/* ================================================================== */
+unsigned long Bench_random(unsigned long *pulState) {
+   *pulState = (*pulState * 1103515245UL + 12345UL) & 0xffffffffUL;
+   return *pulState >> 8;
+}
+
+/* ================================================================== */
+boolean Bench_parseOptions(int argc, char *argv[],
+                           const struct BenchOption *psOptions,
+                           size_t ulNumOptions) {
+   const struct BenchOption *psOption;
+   size_t ulValue, i;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s", argv[0]);
+      for(i = 0; i < ulNumOptions; i++)
+         fprintf(stderr, " [-%c %s]", psOptions[i].cLetter,
+                 psOptions[i].pcName);
+      fprintf(stderr, "\n");
+      return FALSE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      psOption = Bench_findOption(argv[iArg], psOptions, ulNumOptions);
+      if(psOption == NULL) {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return FALSE;
+      }
+      ulValue = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+      if(ulValue == 0 && !psOption->bZeroOk) {
+         fprintf(stderr, "%s: %s must be positive\n", argv[0],
+                 argv[iArg]);
+         return FALSE;
+      }
+      *psOption->pulValue = ulValue;
+   }
+   return TRUE;
+}
@@ -0,0 +1,51 @@
+/*--------------------------------------------------------------------*/
+/* benchutil.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef BENCHUTIL_INCLUDED
+#define BENCHUTIL_INCLUDED
+
+/*
+  What the *bench programs share: a clock, a random number generator
+  that gives the same numbers everywhere, and the parsing of their
+  options, each a letter and a size, as in "-n 1000".
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+
+/* Largest generated pathname, including its terminator */
+enum { BENCH_MAX_PATH = 80 };
+
+/* One option of a benchmark */
+struct BenchOption {
+   /* The option's letter, as 'n' for "-n" */
+   char cLetter;
+   /* What the value is, for the usage message, as "files" */
+   const char *pcName;
+   /* Where the value goes; left as it is if the option is not given */
+   size_t *pulValue;
+   /* Whether the value may be 0 */
+   boolean bZeroOk;
+};
+
+/* Returns the current time in seconds from an arbitrary start. */
+double Bench_now(void);
+
+/* Returns the next value, from 0 to 2^24 - 1, of the generator whose
+   state is *pulState. Any state will do to start. */
+unsigned long Bench_random(unsigned long *pulState);
+
+/*
+  Parses argv's options into the ulNumOptions options of psOptions.
+  Returns TRUE if successful. Otherwise, prints a message naming
+  argv[0] to stderr and returns FALSE: with the usage if the arguments
+  are not pairs, and naming the option if it is unknown or is given 0
+  but must be positive.
+*/
+boolean Bench_parseOptions(int argc, char *argv[],
+                           const struct BenchOption *psOptions,
+                           size_t ulNumOptions);
+
+#endif
@@ -0,0 +1,360 @@
+/*--------------------------------------------------------------------*/
+/* bulkload.c                                                         */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* Threads and sysconf are POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "path.h"
+#include "nodef.h"
+#include "bulkload.h"
+
+/* Most worker threads used */
+enum { MAX_THREADS = 16 };
+
+/* Fewest entries per thread, unless the caller asks for more threads;
+   below this, threads cost more than they save */
+enum { MIN_SHARE = 16 * 1024 };
+
+/* A run of the manifest to build, by one thread */
+struct bulkTask {
+   /* The entries: psEntries[0..ulCount) */
+   const struct FTLoadEntry *psEntries;
+   size_t ulCount;
+
+   /* The pathname of the manifest's first entry, whose root every
+      run must share */
+   const char *pcFirst;
+
+   /* What was built (a NULL top if nothing was) */
+   struct BulkPart sPart;
+
+   /* The status of the first entry that failed, or SUCCESS */
+   int iStatus;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Stores in *ppcTop the start of pcPath's second component, and
+   returns its length (0 if there is none). */
+static size_t BulkLoad_top(const char *pcPath, const char **ppcTop) {
+   const char *pcEnd;
+
+   assert(pcPath != NULL);
+   assert(ppcTop != NULL);
+
+   *ppcTop = strchr(pcPath, '/');
+   if(*ppcTop == NULL) {
+      *ppcTop = pcPath + strlen(pcPath);
+      return 0;
+   }
+   (*ppcTop)++;
+   pcEnd = strchr(*ppcTop, '/');
+   return pcEnd == NULL ? strlen(*ppcTop) : (size_t) (pcEnd - *ppcTop);
+}
+
+/* Returns whether entry ulIndex of psEntries is under another
+   top-level directory than the entry before it. Entries under one
+   are contiguous in a sorted manifest, so it is a run's first. */
+static boolean BulkLoad_startsRun(const struct FTLoadEntry *psEntries,
+                                  size_t ulIndex) {
+   const char *pcTop, *pcPrevTop;
+   size_t ulLength;
+
+   assert(psEntries != NULL);
+   assert(ulIndex > 0);
+
+   ulLength = BulkLoad_top(psEntries[ulIndex].pcPath, &pcTop);
+   return (boolean) (ulLength != BulkLoad_top(
+                        psEntries[ulIndex - 1].pcPath, &pcPrevTop) ||
+                     strncmp(pcTop, pcPrevTop, ulLength) != 0);
+}
+
+/* Returns whether oPRoot, a path of depth 1, is the first component of
+   pcPath. */
+static boolean BulkLoad_isRoot(Path_T oPRoot, const char *pcPath) {
+   size_t ulLength;
+
+   assert(oPRoot != NULL);
+   assert(pcPath != NULL);
+
+   ulLength = Path_getStrLength(oPRoot);
+   return (boolean) (strncmp(Path_getPathname(oPRoot), pcPath,
+                             ulLength) == 0 &&
+                     (pcPath[ulLength] == '\0' ||
+                      pcPath[ulLength] == '/'));
+}
+
+/*
+  Makes *poNdCurr, a directory of the subtree, the one whose path is
+  oPPath's prefix of depth ulDepth, at least 1, finding or making each
+  directory on the way from their deepest shared ancestor. Returns
+  SUCCESS if successful, leaving *poNdCurr as far as it got otherwise,
+  and returns:
+  * NOT_A_DIRECTORY if a prefix of oPPath is the path of a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int BulkLoad_descend(NodeD_T *poNdCurr, Path_T oPPath,
+                            size_t ulDepth) {
+   NodeD_T oNdCurr, oNdChild = NULL;
+   Path_T oPPrefix = NULL;
+   size_t ulLevel, ulIndex;
+   int iStatus;
+
+   assert(poNdCurr != NULL && *poNdCurr != NULL);
+   assert(oPPath != NULL);
+   assert(ulDepth >= 1);
+
+   /* Climb to the deepest ancestor shared with the previous entry,
+      which in a sorted manifest is usually the parent itself */
+   oNdCurr = *poNdCurr;
+   ulLevel = Path_getSharedPrefixDepth(NodeD_getPath(oNdCurr), oPPath);
+   assert(ulLevel >= 1);
+   if(ulLevel > ulDepth)
+      ulLevel = ulDepth;
+   while(Path_getDepth(NodeD_getPath(oNdCurr)) > ulLevel)
+      oNdCurr = NodeD_getParent(oNdCurr);
+
+   for(ulLevel++; ulLevel <= ulDepth; ulLevel++) {
+      iStatus = Path_prefix(oPPath, ulLevel, &oPPrefix);
+      if(iStatus != SUCCESS) {
+         *poNdCurr = oNdCurr;
+         return iStatus;
+      }
+      if(NodeD_hasDirChild(oNdCurr, oPPrefix, &ulIndex))
+         (void) NodeD_getDirChild(oNdCurr, ulIndex, &oNdChild);
+      else if(NodeD_hasFileChild(oNdCurr, oPPrefix, &ulIndex))
+         iStatus = NOT_A_DIRECTORY;
+      else
+         iStatus = NodeD_new(oPPrefix, oNdCurr, &oNdChild);
+      Path_free(oPPrefix);
+      if(iStatus != SUCCESS) {
+         *poNdCurr = oNdCurr;
+         return iStatus;
+      }
+      oNdCurr = oNdChild;
+   }
+   *poNdCurr = oNdCurr;
+   return SUCCESS;
+}
+
+/*
+  Adds the entry psEntry to psTask's subtree, whose directory of the
+  previous entry is *poNdCurr, and updates *poNdCurr. Returns SUCCESS
+  or the status FT_insertFile or FT_insertDir would give the entry.
+*/
+static int BulkLoad_add(struct bulkTask *psTask,
+                        const struct FTLoadEntry *psEntry,
+                        NodeD_T *poNdCurr) {
+   Path_T oPPath = NULL, oPRoot = NULL;
+   NodeD_T oNdNew = NULL;
+   NodeF_T oNfNew = NULL;
+   void *pvOldContents;
+   size_t ulDepth, ulIndex;
+   int iStatus;
+
+   assert(psTask != NULL);
+   assert(psEntry != NULL);
+   assert(psEntry->pcPath != NULL);
+   assert(poNdCurr != NULL);
+
+   iStatus = Path_newWith(psEntry->pcPath,
+                          PoolAlloc_getAlloc(psTask->sPart.oPool),
+                          &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulDepth = Path_getDepth(oPPath);
+   if(psEntry->bIsFile && ulDepth == 1) {
+      Path_free(oPPath);
+      return CONFLICTING_PATH;
+   }
+
+   /* The first entry makes the root, which may be all it asks for */
+   if(psTask->sPart.oNdTop == NULL) {
+      iStatus = Path_prefix(oPPath, 1, &oPRoot);
+      if(iStatus == SUCCESS && !BulkLoad_isRoot(oPRoot, psTask->pcFirst))
+         iStatus = CONFLICTING_PATH;
+      if(iStatus == SUCCESS)
+         iStatus = NodeD_new(oPRoot, NULL, &psTask->sPart.oNdTop);
+      if(oPRoot != NULL)
+         Path_free(oPRoot);
+      if(iStatus != SUCCESS || ulDepth == 1) {
+         Path_free(oPPath);
+         *poNdCurr = psTask->sPart.oNdTop;
+         return iStatus;
+      }
+      *poNdCurr = psTask->sPart.oNdTop;
+   }
+   else if(Path_getSharedPrefixDepth(NodeD_getPath(*poNdCurr),
+                                     oPPath) == 0) {
+      Path_free(oPPath);
+      return CONFLICTING_PATH;
+   }
+   else if(ulDepth == 1) {
+      Path_free(oPPath);
+      return ALREADY_IN_TREE;
+   }
+
+   iStatus = BulkLoad_descend(poNdCurr, oPPath, ulDepth - 1);
+   if(iStatus != SUCCESS) {
+      Path_free(oPPath);
+      return iStatus;
+   }
+   if(NodeD_hasFileChild(*poNdCurr, oPPath, &ulIndex))
+      iStatus = psEntry->bIsFile ? ALREADY_IN_TREE : NOT_A_DIRECTORY;
+   else if(NodeD_hasDirChild(*poNdCurr, oPPath, &ulIndex))
+      iStatus = ALREADY_IN_TREE;
+   else if(!psEntry->bIsFile) {
+      iStatus = NodeD_new(oPPath, *poNdCurr, &oNdNew);
+      if(iStatus == SUCCESS)
+         *poNdCurr = oNdNew;
+   }
+   else {
+      (void) NodeD_hasFileChild(*poNdCurr, oPPath, &ulIndex);
+      iStatus = NodeF_new(oPPath, &oNfNew);
+      if(iStatus == SUCCESS)
+         iStatus = NodeF_replaceContents(oNfNew, psEntry->pvContents,
+                                         psEntry->ulLength,
+                                         &pvOldContents);
+      if(iStatus == SUCCESS)
+         iStatus = NodeD_addFileChild(*poNdCurr, oNfNew, ulIndex);
+      if(iStatus != SUCCESS && oNfNew != NULL)
+         NodeF_free(oNfNew);
+   }
+   Path_free(oPPath);
+   return iStatus;
+}
+
+/* Builds the run of pvTask, a struct bulkTask, into a subtree in a
+   pool of its own, stopping at the first entry that fails. Returns
+   NULL. */
+static void *BulkLoad_runTask(void *pvTask) {
+   struct bulkTask *psTask = pvTask;
+   NodeD_T oNdCurr = NULL;
+   size_t i;
+
+   assert(psTask != NULL);
+
+   psTask->sPart.oPool = PoolAlloc_new();
+   if(psTask->sPart.oPool == NULL) {
+      psTask->iStatus = MEMORY_ERROR;
+      return NULL;
+   }
+   for(i = 0; i < psTask->ulCount && psTask->iStatus == SUCCESS; i++)
+      psTask->iStatus = BulkLoad_add(psTask, &psTask->psEntries[i],
+                                     &oNdCurr);
+   return NULL;
+}
+
+/* Returns the number of worker threads to build ulCount entries with,
+   given the number ulThreads asked for. */
+static size_t BulkLoad_numThreads(size_t ulCount, size_t ulThreads) {
+   long lProcessors;
+
+   if(ulThreads == 0) {
+      lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+      ulThreads = lProcessors < 1 ? 1 : (size_t) lProcessors;
+      if(ulThreads > ulCount / MIN_SHARE)
+         ulThreads = ulCount / MIN_SHARE;
+   }
+   if(ulThreads > MAX_THREADS)
+      ulThreads = MAX_THREADS;
+   return ulThreads < 1 ? 1 : ulThreads;
+}
+
+/* ================================================================== */
+int BulkLoad_build(const struct FTLoadEntry *psEntries, size_t ulCount,
+                   size_t ulThreads, struct BulkPart **ppsParts,
+                   size_t *pulParts) {
+   struct bulkTask asTasks[MAX_THREADS];
+   pthread_t asThreads[MAX_THREADS];
+   boolean abStarted[MAX_THREADS];
+   struct BulkPart *psParts;
+   size_t ulShare, ulNext, ulEnd, ulParts, t;
+   int iStatus = SUCCESS;
+
+   assert(psEntries != NULL || ulCount == 0);
+   assert(ppsParts != NULL);
+   assert(pulParts != NULL);
+
+   *ppsParts = NULL;
+   *pulParts = 0;
+   ulThreads = BulkLoad_numThreads(ulCount, ulThreads);
+
+   /* Give each task about an equal share of the entries, ending where
+      a run does; a long run leaves later tasks less, or nothing */
+   ulShare = ulCount / ulThreads + 1;
+   ulNext = 0;
+   for(t = 0; t < ulThreads; t++) {
+      ulEnd = ulNext + ulShare;
+      if(t == ulThreads - 1 || ulEnd > ulCount)
+         ulEnd = ulCount;
+      while(ulEnd < ulCount && !BulkLoad_startsRun(psEntries, ulEnd))
+         ulEnd++;
+      asTasks[t].psEntries = psEntries + ulNext;
+      asTasks[t].ulCount = ulEnd - ulNext;
+      asTasks[t].pcFirst = psEntries[0].pcPath;
+      asTasks[t].sPart.oNdTop = NULL;
+      asTasks[t].sPart.oPool = NULL;
+      asTasks[t].iStatus = SUCCESS;
+      ulNext = ulEnd;
+   }
+
+   for(t = 0; t < ulThreads; t++)
+      abStarted[t] = (boolean) (t != 0 && asTasks[t].ulCount != 0 &&
+         pthread_create(&asThreads[t], NULL, BulkLoad_runTask,
+                        &asTasks[t]) == 0);
+   /* The calling thread takes the first task, and any that could not
+      be started */
+   for(t = 0; t < ulThreads; t++)
+      if(!abStarted[t] && asTasks[t].ulCount != 0)
+         (void) BulkLoad_runTask(&asTasks[t]);
+   for(t = 0; t < ulThreads; t++)
+      if(abStarted[t])
+         pthread_join(asThreads[t], NULL);
+
+   ulParts = 0;
+   for(t = 0; t < ulThreads; t++) {
+      if(iStatus == SUCCESS)
+         iStatus = asTasks[t].iStatus;
+      if(asTasks[t].sPart.oNdTop != NULL)
+         ulParts++;
+   }
+   psParts = NULL;
+   if(iStatus == SUCCESS) {
+      psParts = malloc((ulParts == 0 ? 1 : ulParts) *
+                       sizeof(struct BulkPart));
+      if(psParts == NULL)
+         iStatus = MEMORY_ERROR;
+   }
+
+   ulParts = 0;
+   for(t = 0; t < ulThreads; t++) {
+      if(iStatus == SUCCESS && asTasks[t].sPart.oNdTop != NULL)
+         psParts[ulParts++] = asTasks[t].sPart;
+      else if(asTasks[t].sPart.oPool != NULL)
+         BulkLoad_freePart(&asTasks[t].sPart);
+   }
+   if(iStatus != SUCCESS)
+      return iStatus;
+   *ppsParts = psParts;
+   *pulParts = ulParts;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void BulkLoad_freePart(struct BulkPart *psPart) {
+   assert(psPart != NULL);
+
+   /* The nodes go first, since the pool does not hold the child
+      arrays too large for it */
+   if(psPart->oNdTop != NULL)
+      (void) NodeD_free(psPart->oNdTop);
+   PoolAlloc_free(psPart->oPool);
+}
@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/* bulkload.h                                                         */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef BULKLOAD_INCLUDED
+#define BULKLOAD_INCLUDED
+
+/*
+  Bulk building of File Tree nodes from a manifest: a list of entries,
+  each a file with its contents or a directory, sorted by pathname.
+  The list is cut into runs where the top-level directory (the second
+  component) changes, and worker threads build the runs into subtrees
+  of their own, each allocating from a pool of its own, so that the
+  threads share nothing.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "noded.h"
+#include "poolalloc.h"
+
+/* One entry of a manifest */
+struct FTLoadEntry {
+   /* Absolute pathname */
+   const char *pcPath;
+
+   /* TRUE for a file, FALSE for a directory */
+   boolean bIsFile;
+
+   /* The file's contents and their length; unused for a directory */
+   void *pvContents;
+   size_t ulLength;
+};
+
+/* The subtree built from one run of a manifest */
+struct BulkPart {
+   /* Its top, a directory with the path of the root */
+   NodeD_T oNdTop;
+
+   /* The pool every node in it was allocated from */
+   PoolAlloc_T oPool;
+};
+
+/*
+  Builds the ulCount entries of psEntries, sorted by strcmp of their
+  pathnames, on up to ulThreads threads (0 for one per processor, if
+  there are enough entries to share), into subtrees, one per run. Each
+  subtree is what FT_insertFile and FT_insertDir would build from its
+  run in an empty FT. Stores in *ppsParts a new array of the subtrees,
+  in the order of their runs, which the caller must free, and their
+  number in *pulParts. Returns SUCCESS if successful. Otherwise, frees
+  what it built, stores NULL and 0, and returns the status those
+  functions give the first entry that fails, in the first run that
+  has one.
+*/
+int BulkLoad_build(const struct FTLoadEntry *psEntries, size_t ulCount,
+                   size_t ulThreads, struct BulkPart **ppsParts,
+                   size_t *pulParts);
+
+/* Frees psPart's subtree and its pool. */
+void BulkLoad_freePart(struct BulkPart *psPart);
+
+#endif
@@ -0,0 +1,276 @@
+/*--------------------------------------------------------------------*/
+/* cache_client.c                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  cache_client checks FT_enableCache against a model of least recently
+  used eviction.
+
+  Usage: cache_client [-r rounds] [-s seed]
+
+  Each round puts the FT in cache mode with random limits on files and
+  bytes, some rounds with files already in it, and then inserts, reads,
+  replaces and removes files at random, changing the limits halfway.
+  The model stamps every file with the time it was last used. Every
+  file passed to the eviction callback must be in the model, with its
+  length, and least recently used of the files left, apart from the
+  one just used; after every call the FT must hold exactly the model's
+  files, within the limits or down to the one file, and no fewer than
+  the limits allow. Directories left empty by an eviction must go if
+  and only if the round prunes them.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Files worked on, spread over DIRS_A * DIRS_B directories */
+enum { NUM_FILES = 48, DIRS_A = 4, DIRS_B = 3 };
+
+/* Longest path, including its terminator */
+enum { MAX_PATH = 16 };
+
+/* Longest contents */
+enum { MAX_LENGTH = 600 };
+
+/* Calls made in each round; the limits change halfway */
+enum { NUM_CALLS = 2000 };
+
+/* Calls between checks of every file */
+enum { FULL_CHECK = 50 };
+
+/* Whether each file is in the model, its length, and when it was last
+   used, with 0 for files in the FT before cache mode */
+static boolean abPresent[NUM_FILES];
+static size_t aulLengths[NUM_FILES];
+static unsigned long aulUsed[NUM_FILES];
+static unsigned long ulClock;
+
+/* The limits, and whether the round prunes directories */
+static size_t ulMaxFiles, ulMaxBytes;
+static boolean bPrune;
+
+/* Files evicted by the last call, in order */
+static size_t aulEvicted[NUM_FILES];
+static size_t ulEvicted;
+
+/* Whether the last call evicted a file from each directory */
+static boolean aabEvictedFrom[DIRS_A][DIRS_B];
+
+/* Contents of every file, cut to its length */
+static char acContents[MAX_LENGTH];
+
+/*--------------------------------------------------------------------*/
+
+/* Writes into pcPath the path of file ulFile. */
+static void CacheClient_path(size_t ulFile, char *pcPath) {
+   sprintf(pcPath, "r/a%lu/b%lu/f%lu", (unsigned long) ulFile % DIRS_A,
+           (unsigned long) ulFile % DIRS_B, (unsigned long) ulFile);
+}
+
+/* Returns a random length of contents. */
+static size_t CacheClient_randomLength(void) {
+   return (size_t) rand() % (MAX_LENGTH + 1);
+}
+
+/* Stores in *pulFiles and *pulBytes the files in the model and their
+   total length. */
+static void CacheClient_totals(size_t *pulFiles, size_t *pulBytes) {
+   size_t i;
+
+   *pulFiles = *pulBytes = 0;
+   for(i = 0; i < NUM_FILES; i++)
+      if(abPresent[i]) {
+         (*pulFiles)++;
+         *pulBytes += aulLengths[i];
+      }
+}
+
+/* Returns TRUE if ulFiles files of ulBytes bytes pass a limit, FALSE
+   otherwise. */
+static boolean CacheClient_over(size_t ulFiles, size_t ulBytes) {
+   return (boolean) ((ulMaxFiles != 0 && ulFiles > ulMaxFiles) ||
+                     (ulMaxBytes != 0 && ulBytes > ulMaxBytes));
+}
+
+/* Checks the evicted file pcPath of length ulLength against the
+   model, and forgets it. */
+static void CacheClient_evict(const char *pcPath, void *pvContents,
+                              size_t ulLength, void *pvExtra) {
+   unsigned long ulFile;
+   size_t i;
+
+   (void) pvContents;
+   assert(pvExtra == &ulEvicted);
+   assert(sscanf(strrchr(pcPath, '/'), "/f%lu", &ulFile) == 1);
+   assert(ulFile < NUM_FILES && abPresent[ulFile]);
+   assert(aulLengths[ulFile] == ulLength);
+
+   /* Least recently used; the most recent of all always stays */
+   for(i = 0; i < NUM_FILES; i++)
+      assert(!abPresent[i] || aulUsed[i] >= aulUsed[ulFile]);
+   abPresent[ulFile] = FALSE;
+   aabEvictedFrom[ulFile % DIRS_A][ulFile % DIRS_B] = TRUE;
+   aulEvicted[ulEvicted++] = ulFile;
+}
+
+/* Checks the FT against the model after a call: the files it
+   evicted, or every file if bFull, and the directories they were in. */
+static void CacheClient_check(boolean bFull) {
+   char acPath[MAX_PATH];
+   size_t ulFiles, ulBytes, i, j, k;
+   boolean bHas, bEvicted, bChildren;
+
+   for(i = 0; i < (bFull ? NUM_FILES : ulEvicted); i++) {
+      k = bFull ? i : aulEvicted[i];
+      CacheClient_path(k, acPath);
+      assert(FT_containsFile(acPath) == abPresent[k]);
+   }
+
+   /* Within the limits, or down to one file, and no further */
+   CacheClient_totals(&ulFiles, &ulBytes);
+   assert(!CacheClient_over(ulFiles, ulBytes) || ulFiles == 1);
+   if(ulEvicted != 0) {
+      k = aulEvicted[ulEvicted - 1];
+      assert(CacheClient_over(ulFiles + 1, ulBytes + aulLengths[k]));
+   }
+
+   /* Directories the call emptied, and their parents if pruned */
+   for(i = 0; i < DIRS_A; i++) {
+      bEvicted = bChildren = FALSE;
+      for(j = 0; j < DIRS_B; j++)
+         bEvicted = (boolean) (bEvicted || aabEvictedFrom[i][j]);
+      if(!bEvicted)
+         continue;
+      for(j = 0; j < DIRS_B; j++) {
+         bHas = FALSE;
+         for(k = 0; k < NUM_FILES; k++)
+            if(abPresent[k] && k % DIRS_A == i && k % DIRS_B == j)
+               bHas = TRUE;
+         sprintf(acPath, "r/a%lu/b%lu", (unsigned long) i,
+                 (unsigned long) j);
+         if(bHas)
+            assert(FT_containsDir(acPath));
+         else if(aabEvictedFrom[i][j])
+            assert(FT_containsDir(acPath) == !bPrune);
+         bChildren = (boolean) (bChildren || FT_containsDir(acPath));
+      }
+      sprintf(acPath, "r/a%lu", (unsigned long) i);
+      assert(FT_containsDir(acPath) == (!bPrune || bChildren));
+   }
+   assert(FT_containsDir("r"));
+}
+
+/* Draws new limits, and calls FT_enableCache with them. */
+static void CacheClient_limit(void) {
+   ulMaxFiles = rand() % 4 == 0 ? 0 : 1 + (size_t) rand() % 20;
+   ulMaxBytes = rand() % 4 == 0 || ulMaxFiles == 0 ?
+                0 : (size_t) rand() % (10 * MAX_LENGTH);
+   ulEvicted = 0;
+   memset(aabEvictedFrom, 0, sizeof(aabEvictedFrom));
+   assert(FT_enableCache(ulMaxFiles, ulMaxBytes, bPrune,
+                         CacheClient_evict, &ulEvicted) == SUCCESS);
+   CacheClient_check(TRUE);
+}
+
+/* Makes one random call on file ulFile, checking every file if
+   bFull. */
+static void CacheClient_call(size_t ulFile, boolean bFull) {
+   char acPath[MAX_PATH];
+   size_t ulLength;
+
+   CacheClient_path(ulFile, acPath);
+   ulEvicted = 0;
+   memset(aabEvictedFrom, 0, sizeof(aabEvictedFrom));
+   if(!abPresent[ulFile]) {
+      ulLength = CacheClient_randomLength();
+      aulLengths[ulFile] = ulLength;
+      abPresent[ulFile] = TRUE;
+      aulUsed[ulFile] = ++ulClock;
+      assert(FT_insertFile(acPath, acContents, ulLength) == SUCCESS);
+   }
+   else switch(rand() % 3) {
+      case 0:
+         assert(FT_getFileContents(acPath) != NULL);
+         aulUsed[ulFile] = ++ulClock;
+         break;
+      case 1:
+         ulLength = CacheClient_randomLength();
+         aulLengths[ulFile] = ulLength;
+         aulUsed[ulFile] = ++ulClock;
+         assert(FT_replaceFileContents(acPath, acContents, ulLength) !=
+                NULL);
+         break;
+      default:
+         /* Removed, not evicted */
+         abPresent[ulFile] = FALSE;
+         assert(FT_rmFile(acPath) == SUCCESS);
+         break;
+   }
+   assert(FT_containsFile(acPath) == abPresent[ulFile]);
+   CacheClient_check(bFull);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 10, ulSeed = 1, r;
+   char acPath[MAX_PATH];
+   size_t i;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+   memset(acContents, 'x', MAX_LENGTH);
+
+   assert(FT_enableCache(1, 0, FALSE, NULL, NULL) ==
+          INITIALIZATION_ERROR);
+   for(r = 0; r < ulRounds; r++) {
+      assert(FT_init() == SUCCESS);
+      memset(abPresent, 0, sizeof(abPresent));
+      ulClock = 0;
+      bPrune = (boolean) (rand() % 2);
+
+      /* Files already in start out least recently used */
+      if(r % 2 == 1)
+         for(i = 0; i < NUM_FILES; i++)
+            if(rand() % 2 == 0) {
+               CacheClient_path(i, acPath);
+               aulLengths[i] = CacheClient_randomLength();
+               abPresent[i] = TRUE;
+               aulUsed[i] = 0;
+               assert(FT_insertFile(acPath, acContents,
+                                    aulLengths[i]) == SUCCESS);
+            }
+      if(!FT_containsDir("r"))
+         assert(FT_insertDir("r") == SUCCESS);
+      CacheClient_limit();
+
+      for(i = 0; i < NUM_CALLS; i++) {
+         if(i == NUM_CALLS / 2)
+            CacheClient_limit();
+         CacheClient_call((size_t) rand() % NUM_FILES,
+                          (boolean) (i % FULL_CHECK == 0));
+      }
+      assert(FT_destroy() == SUCCESS);
+   }
+
+   printf("%lu rounds of evictions matched\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,543 @@
+/*--------------------------------------------------------------------*/
+/* contentstore.c                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "contentstore.h"
+
+/* Dead spill bytes that must accumulate before compaction is tried */
+enum { MIN_COMPACT_BYTES = 65536 };
+
+/* One file's contents, resident in memory and/or in the spill file */
+struct csEntry {
+   /* Resident copy of the contents, or NULL if spilled */
+   void *pvData;
+
+   /* Size of the contents in bytes */
+   size_t ulLength;
+
+   /* Offset of the spill copy in the spill file, or -1 if none */
+   long lOffset;
+
+   /* Offset of the spill copy in a spill file being compacted */
+   long lNewOffset;
+
+   /* CLOCK reference bit, set on every access */
+   boolean bRef;
+
+   /* Pin generation: the entry is pinned while this equals the
+      store's current generation */
+   unsigned long ulPin;
+
+   /* Neighbors in the circular ring of resident entries */
+   CSEntry_T oCPrevRes;
+   CSEntry_T oCNextRes;
+
+   /* Neighbors in the list of all live entries */
+   CSEntry_T oCPrevAll;
+   CSEntry_T oCNextAll;
+};
+
+/*
+  The content store is an AO with the following state variables:
+*/
+
+/* 1. Flag for being in initialized state (TRUE) or not (FALSE) */
+static boolean bIsInitialized;
+/* 2. Maximum number of content bytes held in memory */
+static size_t ulBudget;
+/* 3. Path and handle of the append-only spill file */
+static char *pcSpillPath;
+static FILE *psSpill;
+/* 4. CLOCK hand into the ring of resident entries (NULL if empty) */
+static CSEntry_T oCHand;
+/* 5. Head of the list of all live entries */
+static CSEntry_T oCAll;
+/* 6. Entry kept alive by the last call to CS_retire */
+static CSEntry_T oCRetired;
+/* 7. Dead bytes in the spill file, awaiting compaction */
+static size_t ulDeadBytes;
+/* 8. Counters reported by CS_getStats */
+static struct CSStats sStats;
+/* 9. Number of entries in the resident ring */
+static size_t ulNumResident;
+/* 10. Current pin generation; entries pinned by CS_pin carry it */
+static unsigned long ulPinGen;
+
+/*--------------------------------------------------------------------*/
+
+/* Links oCEntry into the resident ring just behind the CLOCK hand, so
+   that it is the last entry the hand will reach. */
+static void CS_linkResident(CSEntry_T oCEntry) {
+   assert(oCEntry != NULL);
+
+   if(oCHand == NULL) {
+      oCEntry->oCPrevRes = oCEntry;
+      oCEntry->oCNextRes = oCEntry;
+      oCHand = oCEntry;
+   }
+   else {
+      oCEntry->oCNextRes = oCHand;
+      oCEntry->oCPrevRes = oCHand->oCPrevRes;
+      oCHand->oCPrevRes->oCNextRes = oCEntry;
+      oCHand->oCPrevRes = oCEntry;
+   }
+   ulNumResident++;
+   sStats.ulResidentBytes += oCEntry->ulLength;
+}
+
+/* Unlinks oCEntry from the resident ring, advancing the hand past it
+   if necessary. */
+static void CS_unlinkResident(CSEntry_T oCEntry) {
+   assert(oCEntry != NULL);
+
+   if(oCEntry->oCNextRes == oCEntry)
+      oCHand = NULL;
+   else {
+      if(oCHand == oCEntry)
+         oCHand = oCEntry->oCNextRes;
+      oCEntry->oCPrevRes->oCNextRes = oCEntry->oCNextRes;
+      oCEntry->oCNextRes->oCPrevRes = oCEntry->oCPrevRes;
+   }
+   oCEntry->oCPrevRes = NULL;
+   oCEntry->oCNextRes = NULL;
+   ulNumResident--;
+   sStats.ulResidentBytes -= oCEntry->ulLength;
+}
+
+/* Unlinks oCEntry from the list of all live entries. */
+static void CS_unlinkAll(CSEntry_T oCEntry) {
+   assert(oCEntry != NULL);
+
+   if(oCEntry->oCPrevAll != NULL)
+      oCEntry->oCPrevAll->oCNextAll = oCEntry->oCNextAll;
+   else
+      oCAll = oCEntry->oCNextAll;
+   if(oCEntry->oCNextAll != NULL)
+      oCEntry->oCNextAll->oCPrevAll = oCEntry->oCPrevAll;
+}
+
+/* Copies ulLength bytes at lOffset of the spill file psFile into
+   pvBuf. Returns TRUE if successful, FALSE if not. */
+static boolean CS_readAt(FILE *psFile, long lOffset, void *pvBuf,
+                         size_t ulLength) {
+   assert(psFile != NULL);
+   assert(pvBuf != NULL);
+
+   if(fseek(psFile, lOffset, SEEK_SET) != 0)
+      return FALSE;
+   return (boolean) (fread(pvBuf, 1, ulLength, psFile) == ulLength);
+}
+
+/* Appends ulLength bytes of pvBuf to the spill file psFile, storing
+   where they were written in *plOffset. Returns TRUE if successful,
+   FALSE if not. */
+static boolean CS_append(FILE *psFile, const void *pvBuf,
+                         size_t ulLength, long *plOffset) {
+   assert(psFile != NULL);
+   assert(pvBuf != NULL);
+   assert(plOffset != NULL);
+
+   if(fseek(psFile, 0L, SEEK_END) != 0)
+      return FALSE;
+   *plOffset = ftell(psFile);
+   if(*plOffset < 0)
+      return FALSE;
+   return (boolean) (fwrite(pvBuf, 1, ulLength, psFile) == ulLength);
+}
+
+/*
+  Rewrites the spill file so that it holds only the spill copies of
+  live entries. Leaves the spill file untouched if anything fails.
+*/
+static void CS_compact(void) {
+   char *pcTmpPath;
+   FILE *psNew;
+   CSEntry_T oCCurr;
+   boolean bOk = TRUE;
+
+   pcTmpPath = malloc(strlen(pcSpillPath) + sizeof(".tmp"));
+   if(pcTmpPath == NULL)
+      return;
+   strcpy(pcTmpPath, pcSpillPath);
+   strcat(pcTmpPath, ".tmp");
+
+   psNew = fopen(pcTmpPath, "w+b");
+   if(psNew == NULL) {
+      free(pcTmpPath);
+      return;
+   }
+
+   /* Copy every live spill copy into the new file */
+   for(oCCurr = oCAll; oCCurr != NULL && bOk;
+       oCCurr = oCCurr->oCNextAll) {
+      void *pvBuf;
+      if(oCCurr->lOffset < 0)
+         continue;
+      pvBuf = oCCurr->pvData;
+      if(pvBuf == NULL) {
+         pvBuf = malloc(oCCurr->ulLength);
+         bOk = (boolean) (pvBuf != NULL &&
+                          CS_readAt(psSpill, oCCurr->lOffset, pvBuf,
+                                    oCCurr->ulLength));
+      }
+      if(bOk)
+         bOk = CS_append(psNew, pvBuf, oCCurr->ulLength,
+                         &oCCurr->lNewOffset);
+      if(pvBuf != oCCurr->pvData)
+         free(pvBuf);
+   }
+
+   if(!bOk || rename(pcTmpPath, pcSpillPath) != 0) {
+      (void) fclose(psNew);
+      (void) remove(pcTmpPath);
+      free(pcTmpPath);
+      return;
+   }
+   free(pcTmpPath);
+
+   /* Switch over to the new file */
+   (void) fclose(psSpill);
+   psSpill = psNew;
+   for(oCCurr = oCAll; oCCurr != NULL; oCCurr = oCCurr->oCNextAll)
+      if(oCCurr->lOffset >= 0)
+         oCCurr->lOffset = oCCurr->lNewOffset;
+   ulDeadBytes = 0;
+   sStats.ulCompactions++;
+}
+
+/* Records that the spill copy of oCEntry is no longer needed, and
+   compacts the spill file if it has become mostly dead. */
+static void CS_dropSpillCopy(CSEntry_T oCEntry) {
+   assert(oCEntry != NULL);
+
+   if(oCEntry->lOffset < 0)
+      return;
+   oCEntry->lOffset = -1;
+   sStats.ulSpillBytes -= oCEntry->ulLength;
+   ulDeadBytes += oCEntry->ulLength;
+
+   if(ulDeadBytes >= MIN_COMPACT_BYTES &&
+      ulDeadBytes > sStats.ulSpillBytes)
+      CS_compact();
+}
+
+/* Releases every pin, so that the entries CS_pin returned may be
+   spilled again. */
+static void CS_unpinAll(void) {
+   ulPinGen++;
+}
+
+/*
+  Advances the CLOCK hand to the first unreferenced resident entry
+  other than oCPinned and those pinned by CS_pin, and spills it,
+  clearing reference bits along the way. Returns TRUE if an entry was
+  spilled, or FALSE if there is no entry to spill or writing it out
+  failed.
+*/
+static boolean CS_evictOne(CSEntry_T oCPinned) {
+   CSEntry_T oCVictim;
+   size_t ulSteps;
+
+   /* Two turns of the hand clear every reference bit and then reach
+      every entry that can be spilled */
+   for(ulSteps = 0; oCHand != NULL && ulSteps < 2 * ulNumResident;
+       ulSteps++) {
+      oCVictim = oCHand;
+      if(oCVictim == oCPinned || oCVictim->ulPin == ulPinGen) {
+         oCHand = oCVictim->oCNextRes;
+         continue;
+      }
+      if(oCVictim->bRef) {
+         oCVictim->bRef = FALSE;
+         oCHand = oCVictim->oCNextRes;
+         continue;
+      }
+
+      /* Contents never change once stored, so an existing spill copy
+         is still valid and a clean entry is dropped without I/O */
+      if(oCVictim->lOffset < 0) {
+         if(!CS_append(psSpill, oCVictim->pvData, oCVictim->ulLength,
+                       &oCVictim->lOffset)) {
+            oCVictim->lOffset = -1;
+            return FALSE;
+         }
+         sStats.ulSpills++;
+         sStats.ulSpillBytes += oCVictim->ulLength;
+      }
+      CS_unlinkResident(oCVictim);
+      free(oCVictim->pvData);
+      oCVictim->pvData = NULL;
+      return TRUE;
+   }
+   return FALSE;
+}
+
+/* Spills entries other than oCPinned until ulNeeded more bytes fit
+   within the budget, or nothing more can be spilled. */
+static void CS_makeRoom(size_t ulNeeded, CSEntry_T oCPinned) {
+   while(sStats.ulResidentBytes + ulNeeded > ulBudget &&
+         CS_evictOne(oCPinned))
+      ;
+}
+
+/* Returns ulLength bytes of freshly allocated memory, spilling every
+   other resident entry and retrying if the first attempt fails. */
+static void *CS_alloc(size_t ulLength, CSEntry_T oCPinned) {
+   void *pvBuf;
+
+   pvBuf = malloc(ulLength);
+   if(pvBuf == NULL) {
+      while(CS_evictOne(oCPinned))
+         ;
+      pvBuf = malloc(ulLength);
+   }
+   return pvBuf;
+}
+
+/* ================================================================== */
+int CS_init(size_t ulNewBudget, const char *pcPath) {
+   assert(pcPath != NULL);
+
+   if(bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   pcSpillPath = malloc(strlen(pcPath) + 1);
+   if(pcSpillPath == NULL)
+      return MEMORY_ERROR;
+   strcpy(pcSpillPath, pcPath);
+
+   psSpill = fopen(pcSpillPath, "w+b");
+   if(psSpill == NULL) {
+      free(pcSpillPath);
+      pcSpillPath = NULL;
+      return BAD_PATH;
+   }
+
+   ulBudget = ulNewBudget;
+   oCHand = NULL;
+   oCAll = NULL;
+   oCRetired = NULL;
+   ulDeadBytes = 0;
+   ulNumResident = 0;
+   ulPinGen = 1;
+   memset(&sStats, 0, sizeof(sStats));
+   bIsInitialized = TRUE;
+
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int CS_destroy(void) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   while(oCAll != NULL)
+      CS_free(oCAll);
+   if(oCRetired != NULL) {
+      free(oCRetired->pvData);
+      free(oCRetired);
+      oCRetired = NULL;
+   }
+
+   (void) fclose(psSpill);
+   (void) remove(pcSpillPath);
+   free(pcSpillPath);
+   psSpill = NULL;
+   pcSpillPath = NULL;
+   bIsInitialized = FALSE;
+
+   return SUCCESS;
+}
+
+/* ================================================================== */
+boolean CS_isInitialized(void) {
+   return bIsInitialized;
+}
+
+/* ================================================================== */
+int CS_put(const void *pvContents, size_t ulLength,
+           CSEntry_T *poCResult) {
+   CSEntry_T oCNew;
+
+   assert(bIsInitialized);
+   assert(pvContents != NULL || ulLength == 0);
+   assert(poCResult != NULL);
+
+   CS_unpinAll();
+   oCNew = malloc(sizeof(struct csEntry));
+   if(oCNew == NULL) {
+      *poCResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   /* Make room for the new contents before copying them in */
+   CS_makeRoom(ulLength, NULL);
+   oCNew->pvData = CS_alloc(ulLength == 0 ? 1 : ulLength, NULL);
+   if(oCNew->pvData == NULL) {
+      free(oCNew);
+      *poCResult = NULL;
+      return MEMORY_ERROR;
+   }
+   if(ulLength != 0)
+      memcpy(oCNew->pvData, pvContents, ulLength);
+
+   oCNew->ulLength = ulLength;
+   oCNew->lOffset = -1;
+   oCNew->bRef = TRUE;
+   oCNew->ulPin = 0;
+   CS_linkResident(oCNew);
+
+   oCNew->oCPrevAll = NULL;
+   oCNew->oCNextAll = oCAll;
+   if(oCAll != NULL)
+      oCAll->oCPrevAll = oCNew;
+   oCAll = oCNew;
+
+   *poCResult = oCNew;
+   return SUCCESS;
+}
+
+/* Returns the current time in seconds from an arbitrary start, as
+   elapsed rather than processor time, so that it counts waiting on
+   the spill file. */
+static double CS_now(void) {
+   struct timespec sNow;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double) sNow.tv_sec + (double) sNow.tv_nsec / 1e9;
+}
+
+/* Returns the contents held by oCEntry, faulting them back in if they
+   are not resident, or NULL if that fails. */
+static void *CS_fetch(CSEntry_T oCEntry) {
+   double dStart, dSeconds;
+   void *pvBuf;
+
+   assert(bIsInitialized);
+   assert(oCEntry != NULL);
+
+   oCEntry->bRef = TRUE;
+   if(oCEntry->pvData != NULL) {
+      sStats.ulHits++;
+      return oCEntry->pvData;
+   }
+
+   /* Fault the contents back in, keeping the spill copy so that a
+      later eviction of this entry is free */
+   dStart = CS_now();
+   sStats.ulMisses++;
+   CS_makeRoom(oCEntry->ulLength, oCEntry);
+   pvBuf = CS_alloc(oCEntry->ulLength, oCEntry);
+   if(pvBuf == NULL)
+      return NULL;
+   if(!CS_readAt(psSpill, oCEntry->lOffset, pvBuf, oCEntry->ulLength)) {
+      free(pvBuf);
+      return NULL;
+   }
+   oCEntry->pvData = pvBuf;
+   CS_linkResident(oCEntry);
+   dSeconds = CS_now() - dStart;
+   sStats.dFaultSeconds += dSeconds;
+   if(dSeconds > sStats.dMaxFaultSeconds)
+      sStats.dMaxFaultSeconds = dSeconds;
+
+   return pvBuf;
+}
+
+/* ================================================================== */
+void *CS_get(CSEntry_T oCEntry) {
+   assert(bIsInitialized);
+   assert(oCEntry != NULL);
+
+   CS_unpinAll();
+   return CS_fetch(oCEntry);
+}
+
+/* ================================================================== */
+void *CS_pin(CSEntry_T oCEntry) {
+   void *pvContents;
+
+   assert(bIsInitialized);
+   assert(oCEntry != NULL);
+
+   pvContents = CS_fetch(oCEntry);
+   if(pvContents != NULL)
+      oCEntry->ulPin = ulPinGen;
+   return pvContents;
+}
+
+/* ================================================================== */
+void CS_beginPins(void) {
+   assert(bIsInitialized);
+
+   CS_unpinAll();
+}
+
+/* ================================================================== */
+size_t CS_getLength(CSEntry_T oCEntry) {
+   assert(oCEntry != NULL);
+
+   return oCEntry->ulLength;
+}
+
+/* ================================================================== */
+void CS_free(CSEntry_T oCEntry) {
+   assert(bIsInitialized);
+   assert(oCEntry != NULL);
+
+   if(oCEntry->pvData != NULL) {
+      CS_unlinkResident(oCEntry);
+      free(oCEntry->pvData);
+   }
+   CS_unlinkAll(oCEntry);
+   CS_dropSpillCopy(oCEntry);
+   free(oCEntry);
+}
+
+/* ================================================================== */
+void *CS_retire(CSEntry_T oCEntry) {
+   void *pvContents;
+
+   assert(bIsInitialized);
+   assert(oCEntry != NULL);
+
+   /* Release the previously retired contents */
+   if(oCRetired != NULL) {
+      free(oCRetired->pvData);
+      free(oCRetired);
+      oCRetired = NULL;
+   }
+
+   CS_unpinAll();
+   pvContents = CS_fetch(oCEntry);
+   if(pvContents == NULL) {
+      CS_free(oCEntry);
+      return NULL;
+   }
+
+   /* Detach the entry from the store but keep its memory */
+   CS_unlinkResident(oCEntry);
+   CS_unlinkAll(oCEntry);
+   CS_dropSpillCopy(oCEntry);
+   oCRetired = oCEntry;
+
+   return pvContents;
+}
+
+/* ================================================================== */
+void CS_getStats(struct CSStats *psStats) {
+   assert(psStats != NULL);
+
+   *psStats = sStats;
+   psStats->dMeanFaultSeconds = sStats.ulMisses == 0 ? 0.0 :
+      sStats.dFaultSeconds / (double) sStats.ulMisses;
+}
@@ -0,0 +1,111 @@
+/*--------------------------------------------------------------------*/
+/* contentstore.h                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef CONTENTSTORE_INCLUDED
+#define CONTENTSTORE_INCLUDED
+
+/*
+  The content store is a tiered home for file contents: it keeps a
+  private copy of each file's contents in memory while the total stays
+  within a byte budget, and spills cold contents (chosen by a CLOCK
+  policy) to an append-only spill file, faulting them back in on
+  demand. The spill file is compacted once it holds more dead bytes
+  than live ones.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+
+/* A CSEntry_T is the content store's record of one file's contents */
+typedef struct csEntry *CSEntry_T;
+
+/* Counters describing the behavior of the content store */
+struct CSStats {
+   /* Fetches served from memory */
+   size_t ulHits;
+   /* Fetches that had to fault contents in from the spill file */
+   size_t ulMisses;
+   /* Number of times contents were written out to the spill file */
+   size_t ulSpills;
+   /* Number of times the spill file was compacted */
+   size_t ulCompactions;
+   /* Bytes of contents currently held in memory */
+   size_t ulResidentBytes;
+   /* Bytes of the spill file still referenced by live entries */
+   size_t ulSpillBytes;
+   /* Elapsed time, in seconds, spent faulting contents in: in total,
+      the mean per fault and the longest fault */
+   double dFaultSeconds;
+   double dMeanFaultSeconds;
+   double dMaxFaultSeconds;
+};
+
+/*
+  Sets the content store to an initialized state with an in-memory
+  budget of ulBudget bytes and a spill file at path pcSpillPath, which
+  is created (or truncated). Returns SUCCESS if successful.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the store is already initialized
+  * BAD_PATH if the spill file could not be created
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int CS_init(size_t ulBudget, const char *pcSpillPath);
+
+/*
+  Frees every entry, closes and deletes the spill file, and returns
+  the store to an uninitialized state. Returns INITIALIZATION_ERROR if
+  not initialized, and SUCCESS otherwise.
+*/
+int CS_destroy(void);
+
+/* Returns TRUE if the content store is initialized, FALSE if not. */
+boolean CS_isInitialized(void);
+
+/*
+  Copies ulLength bytes of pvContents into a new entry, spilling cold
+  entries first if needed to respect the budget. Returns SUCCESS and
+  sets *poCResult to the new entry if successful. Otherwise, sets
+  *poCResult to NULL and returns MEMORY_ERROR.
+*/
+int CS_put(const void *pvContents, size_t ulLength,
+           CSEntry_T *poCResult);
+
+/*
+  Returns the contents held by oCEntry, faulting them back in from the
+  spill file if they are not resident, or NULL if that fails. The
+  returned memory is owned by the store and remains valid only until
+  the next call that may spill (CS_put, CS_get, CS_pin or CS_retire).
+  Releases every pin.
+*/
+void *CS_get(CSEntry_T oCEntry);
+
+/*
+  Like CS_get, but pins oCEntry instead of releasing the pins: the
+  returned contents stay resident, and valid, through later calls to
+  CS_pin, until the next call to CS_beginPins, CS_put, CS_get or
+  CS_retire. Pinned contents may take the store over its budget.
+*/
+void *CS_pin(CSEntry_T oCEntry);
+
+/* Releases every pin, ahead of a batch of calls to CS_pin. */
+void CS_beginPins(void);
+
+/* Returns the length in bytes of the contents held by oCEntry. */
+size_t CS_getLength(CSEntry_T oCEntry);
+
+/* Destroys oCEntry, releasing its memory and any spill copy. */
+void CS_free(CSEntry_T oCEntry);
+
+/*
+  Destroys oCEntry like CS_free, but first faults its contents in and
+  keeps them alive until the next call to CS_retire or CS_destroy.
+  Returns those contents, or NULL if they could not be faulted in.
+*/
+void *CS_retire(CSEntry_T oCEntry);
+
+/* Copies the store's current counters into *psStats. */
+void CS_getStats(struct CSStats *psStats);
+
+#endif
@@ -0,0 +1,401 @@
+/*--------------------------------------------------------------------*/
+/* contentstore_client.c                                              */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  contentstore_client checks the content store, on its own and behind
+  FT_setContentBudget.
+
+  Usage: contentstore_client [-r rounds] [-s seed]
+
+  Each round gives a store a random budget and makes random calls on
+  it: puts of random contents well past the budget, gets, frees,
+  retires and batches of pins. Every get must return the bytes put,
+  retired contents must survive the next put, and every pin of a batch
+  must hold its bytes at once. The counters must add up: one hit or
+  miss per fetch, resident bytes within the budget once a put follows
+  any pins, and spill bytes within the bytes stored. A round ends by
+  reading every entry, which must fault in some of them if they do not
+  all fit.
+  It then checks that CLOCK keeps an entry read between every other
+  fault resident, that freeing most spilled entries compacts the spill
+  file without losing the others, and the statuses of CS_init and
+  CS_destroy. Last it stores files in an FT past its budget and checks
+  their contents through FT_getFileContents, FT_replaceFileContents
+  and FT_getFileContentsMulti, along with FT_getContentStats.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contentstore.h"
+#include "ft.h"
+
+/* Calls made on the store in each round */
+enum { NUM_CALLS = 400 };
+
+/* Most entries held at once, and most bytes in any of them */
+enum { MAX_STORED = 64, MAX_LENGTH = 200 };
+
+/* Most entries pinned in one batch */
+enum { MAX_PINS = 8 };
+
+/* Entries and bytes in each for the CLOCK and compaction checks */
+enum { CLOCK_ENTRIES = 8, CLOCK_LENGTH = 100 };
+enum { COMPACT_ENTRIES = 100, COMPACT_FREED = 80, COMPACT_LENGTH = 1024 };
+
+/* Files stored in the FT, and the FT's budget in files */
+enum { NUM_FILES = 50, BUDGET_FILES = 10 };
+
+/* The spill file every store uses */
+static const char *pcSpill = "contentstore_client.spill";
+
+/* One entry of the store and the bytes put in it */
+struct stored {
+   CSEntry_T oCEntry;
+   size_t ulLength;
+   unsigned char aucBytes[MAX_LENGTH];
+};
+
+/* The entries of the current round */
+static struct stored asStored[MAX_STORED];
+static size_t ulNumStored;
+
+/*--------------------------------------------------------------------*/
+
+/* Checks the store's counters against each other, against the ulLive
+   bytes stored and, if bInBudget, against the budget ulBudget, and
+   stores them in *psStats. */
+static void ContentStoreClient_stats(struct CSStats *psStats,
+                                     size_t ulLive, size_t ulBudget,
+                                     boolean bInBudget) {
+   CS_getStats(psStats);
+   assert(psStats->ulResidentBytes <= ulLive);
+   assert(psStats->ulSpillBytes <= ulLive);
+   if(bInBudget)
+      assert(psStats->ulResidentBytes <= ulBudget);
+   assert(psStats->dMaxFaultSeconds <= psStats->dFaultSeconds);
+   if(psStats->ulMisses == 0)
+      assert(psStats->dFaultSeconds == 0.0);
+   else
+      assert(psStats->dMeanFaultSeconds ==
+             psStats->dFaultSeconds / (double) psStats->ulMisses);
+}
+
+/* Checks that the store returns the bytes of *psStored, counting one
+   more fetch in the counters at *psStats. */
+static void ContentStoreClient_get(struct stored *psStored,
+                                   struct CSStats *psStats) {
+   size_t ulFetches = psStats->ulHits + psStats->ulMisses;
+   void *pvContents;
+
+   pvContents = CS_get(psStored->oCEntry);
+   assert(pvContents != NULL);
+   assert(memcmp(pvContents, psStored->aucBytes,
+                 psStored->ulLength) == 0);
+   assert(CS_getLength(psStored->oCEntry) == psStored->ulLength);
+   CS_getStats(psStats);
+   assert(psStats->ulHits + psStats->ulMisses == ulFetches + 1);
+}
+
+/* Puts ulLength random bytes into a new entry. */
+static void ContentStoreClient_put(size_t ulLength) {
+   struct stored *psStored = &asStored[ulNumStored++];
+   size_t i;
+
+   psStored->ulLength = ulLength;
+   for(i = 0; i < ulLength; i++)
+      psStored->aucBytes[i] = (unsigned char) rand();
+   assert(CS_put(psStored->aucBytes, psStored->ulLength,
+                 &psStored->oCEntry) == SUCCESS);
+}
+
+/* Removes entry ulIndex from the model, moving the last into it. */
+static void ContentStoreClient_forget(size_t ulIndex) {
+   asStored[ulIndex] = asStored[--ulNumStored];
+}
+
+/* Returns the bytes held by the entries of the model. */
+static size_t ContentStoreClient_live(void) {
+   size_t ulLive = 0, i;
+
+   for(i = 0; i < ulNumStored; i++)
+      ulLive += asStored[i].ulLength;
+   return ulLive;
+}
+
+/* Pins a random batch of entries and checks all of them at once. */
+static void ContentStoreClient_pins(void) {
+   void *apvContents[MAX_PINS];
+   size_t aulPinned[MAX_PINS];
+   size_t ulPins, i;
+
+   CS_beginPins();
+   ulPins = 1 + (size_t) rand() % MAX_PINS;
+   for(i = 0; i < ulPins; i++) {
+      aulPinned[i] = (size_t) rand() % ulNumStored;
+      apvContents[i] = CS_pin(asStored[aulPinned[i]].oCEntry);
+      assert(apvContents[i] != NULL);
+   }
+   for(i = 0; i < ulPins; i++)
+      assert(memcmp(apvContents[i], asStored[aulPinned[i]].aucBytes,
+                    asStored[aulPinned[i]].ulLength) == 0);
+}
+
+/* Runs one round of random calls on a store. */
+static void ContentStoreClient_round(void) {
+   unsigned char aucRetired[MAX_LENGTH];
+   struct CSStats sStats;
+   size_t ulBudget, ulLength, ulIndex, ulMisses, i;
+   boolean bInBudget = TRUE;
+   void *pvRetired;
+
+   /* Every entry fits on its own, so the budget always holds */
+   ulBudget = MAX_LENGTH + (size_t) rand() % (8 * MAX_LENGTH);
+   assert(CS_init(ulBudget, pcSpill) == SUCCESS);
+   ulNumStored = 0;
+   CS_getStats(&sStats);
+
+   for(i = 0; i < NUM_CALLS; i++) {
+      ulIndex = ulNumStored == 0 ? 0 : (size_t) rand() % ulNumStored;
+      switch(ulNumStored == 0 ? 0 : rand() % 10) {
+         case 0: case 1: case 2: case 3:
+            if(ulNumStored < MAX_STORED) {
+               ContentStoreClient_put((size_t) rand() %
+                                      (MAX_LENGTH + 1));
+               bInBudget = TRUE;
+            }
+            break;
+         case 4: case 5: case 6:
+            ContentStoreClient_get(&asStored[ulIndex], &sStats);
+            break;
+         case 7:
+            CS_free(asStored[ulIndex].oCEntry);
+            ContentStoreClient_forget(ulIndex);
+            break;
+         case 8:
+            /* Retired contents outlive the next put */
+            ulLength = asStored[ulIndex].ulLength;
+            memcpy(aucRetired, asStored[ulIndex].aucBytes, ulLength);
+            pvRetired = CS_retire(asStored[ulIndex].oCEntry);
+            assert(pvRetired != NULL);
+            ContentStoreClient_forget(ulIndex);
+            ContentStoreClient_put(MAX_LENGTH);
+            assert(memcmp(pvRetired, aucRetired, ulLength) == 0);
+            bInBudget = TRUE;
+            break;
+         default:
+            /* Pins may take the store over its budget, until a put
+               makes room again */
+            ContentStoreClient_pins();
+            bInBudget = FALSE;
+            break;
+      }
+      ContentStoreClient_stats(&sStats, ContentStoreClient_live(),
+                               ulBudget, bInBudget);
+   }
+
+   /* Every entry, read back; those that did not fit were spilled */
+   ulMisses = sStats.ulMisses;
+   for(i = 0; i < ulNumStored; i++)
+      ContentStoreClient_get(&asStored[i], &sStats);
+   if(ContentStoreClient_live() > ulBudget) {
+      assert(sStats.ulMisses > ulMisses);
+      assert(sStats.ulSpills > 0);
+   }
+   assert(CS_destroy() == SUCCESS);
+}
+
+/* Checks that CLOCK keeps resident an entry read between every
+   other fault, where FIFO would spill it in turn. */
+static void ContentStoreClient_clock(void) {
+   struct CSStats sStats;
+   size_t ulHits, i;
+
+   assert(CS_init(4 * CLOCK_LENGTH, pcSpill) == SUCCESS);
+   ulNumStored = 0;
+   for(i = 0; i < CLOCK_ENTRIES; i++)
+      ContentStoreClient_put(CLOCK_LENGTH);
+   CS_getStats(&sStats);
+   assert(sStats.ulSpills == CLOCK_ENTRIES - 4);
+
+   ContentStoreClient_get(&asStored[0], &sStats);
+   for(i = 0; i < 10 * CLOCK_ENTRIES; i++) {
+      ContentStoreClient_get(&asStored[1 + i % (CLOCK_ENTRIES - 1)],
+                             &sStats);
+      ulHits = sStats.ulHits;
+      ContentStoreClient_get(&asStored[0], &sStats);
+
+      /* Once the reference bits set by the puts are cleared */
+      if(i >= CLOCK_ENTRIES)
+         assert(sStats.ulHits == ulHits + 1);
+   }
+   assert(sStats.ulMisses > 0);
+   assert(CS_destroy() == SUCCESS);
+}
+
+/* Checks that freeing most spilled entries compacts the spill file,
+   keeping the contents of the others. */
+static void ContentStoreClient_compact(void) {
+   static unsigned char aucBytes[COMPACT_ENTRIES][COMPACT_LENGTH];
+   CSEntry_T aoCEntries[COMPACT_ENTRIES];
+   struct CSStats sStats;
+   unsigned char *pucContents;
+   size_t i;
+
+   assert(CS_init(4 * COMPACT_LENGTH, pcSpill) == SUCCESS);
+   for(i = 0; i < COMPACT_ENTRIES; i++) {
+      memset(aucBytes[i], (int) i, COMPACT_LENGTH);
+      assert(CS_put(aucBytes[i], COMPACT_LENGTH, &aoCEntries[i]) ==
+             SUCCESS);
+   }
+   CS_getStats(&sStats);
+   assert(sStats.ulSpills == COMPACT_ENTRIES - 4);
+   assert(sStats.ulSpillBytes == sStats.ulSpills * COMPACT_LENGTH);
+   assert(sStats.ulResidentBytes == 4 * COMPACT_LENGTH);
+   assert(sStats.ulCompactions == 0);
+
+   for(i = 0; i < COMPACT_FREED; i++)
+      CS_free(aoCEntries[i]);
+   CS_getStats(&sStats);
+   assert(sStats.ulCompactions > 0);
+   assert(sStats.ulSpillBytes ==
+          (COMPACT_ENTRIES - COMPACT_FREED - 4) * COMPACT_LENGTH);
+
+   for(i = COMPACT_FREED; i < COMPACT_ENTRIES; i++) {
+      pucContents = CS_get(aoCEntries[i]);
+      assert(pucContents != NULL);
+      assert(memcmp(pucContents, aucBytes[i], COMPACT_LENGTH) == 0);
+   }
+   assert(CS_destroy() == SUCCESS);
+}
+
+/* Checks the statuses of CS_init and CS_destroy, and that the spill
+   file goes with the store. */
+static void ContentStoreClient_statuses(void) {
+   assert(!CS_isInitialized());
+   assert(CS_destroy() == INITIALIZATION_ERROR);
+   assert(CS_init(0, "contentstore_client.d/no/spill") == BAD_PATH);
+   assert(!CS_isInitialized());
+   assert(CS_init(0, pcSpill) == SUCCESS);
+   assert(CS_isInitialized());
+   assert(CS_init(0, pcSpill) == INITIALIZATION_ERROR);
+   assert(CS_destroy() == SUCCESS);
+   assert(fopen(pcSpill, "rb") == NULL);
+}
+
+/* Checks files stored in the FT past its budget. */
+static void ContentStoreClient_ft(void) {
+   static char aacContents[NUM_FILES][MAX_LENGTH];
+   char aacPaths[NUM_FILES + 1][MAX_LENGTH];
+   const char *apcPaths[NUM_FILES + 1];
+   void *apvContents[NUM_FILES + 1];
+   size_t aulLengths[NUM_FILES + 1];
+   struct CSStats sStats;
+   size_t ulFetches, i;
+   char *pcContents;
+
+   assert(FT_setContentBudget(0, pcSpill) == INITIALIZATION_ERROR);
+   assert(FT_init() == SUCCESS);
+   assert(FT_getContentStats(&sStats) == INITIALIZATION_ERROR);
+   assert(FT_insertDir("r") == SUCCESS);
+   assert(FT_setContentBudget(0, pcSpill) == INITIALIZATION_ERROR);
+   assert(FT_destroy() == SUCCESS);
+
+   assert(FT_init() == SUCCESS);
+   assert(FT_setContentBudget(BUDGET_FILES * MAX_LENGTH, pcSpill) ==
+          SUCCESS);
+   assert(FT_setContentBudget(0, pcSpill) == INITIALIZATION_ERROR);
+
+   /* The store copies the contents in, so the buffers are reused */
+   for(i = 0; i < NUM_FILES; i++) {
+      sprintf(aacPaths[i], "r/d%lu/f%lu", (unsigned long) (i % 7),
+              (unsigned long) i);
+      apcPaths[i] = aacPaths[i];
+      memset(aacContents[i], 'a' + (int) (i % 26), MAX_LENGTH);
+      assert(FT_insertFile(aacPaths[i], aacContents[i], MAX_LENGTH) ==
+             SUCCESS);
+      aacContents[i][0] = '?';
+   }
+   strcpy(aacPaths[NUM_FILES], "r/d0");
+   apcPaths[NUM_FILES] = aacPaths[NUM_FILES];
+   assert(FT_getContentStats(&sStats) == SUCCESS);
+   assert(sStats.ulSpills == NUM_FILES - BUDGET_FILES);
+   assert(sStats.ulResidentBytes == BUDGET_FILES * MAX_LENGTH);
+
+   ulFetches = sStats.ulHits + sStats.ulMisses;
+   for(i = 0; i < NUM_FILES; i++) {
+      pcContents = FT_getFileContents(aacPaths[i]);
+      assert(pcContents != NULL && pcContents != aacContents[i]);
+      assert(pcContents[0] == 'a' + (int) (i % 26));
+      assert(memcmp(pcContents + 1, aacContents[i] + 1,
+                    MAX_LENGTH - 1) == 0);
+   }
+   assert(FT_getContentStats(&sStats) == SUCCESS);
+   assert(sStats.ulHits + sStats.ulMisses == ulFetches + NUM_FILES);
+   assert(sStats.ulMisses >= NUM_FILES - BUDGET_FILES);
+   assert(sStats.ulResidentBytes <= BUDGET_FILES * MAX_LENGTH);
+
+   /* Old contents come back from a replace; removed files go */
+   for(i = 0; i < NUM_FILES; i++) {
+      if(i % 2 == 0) {
+         assert(FT_rmFile(aacPaths[i]) == SUCCESS);
+         continue;
+      }
+      aacContents[i][0] = 'A' + (char) (i % 26);
+      pcContents = FT_replaceFileContents(aacPaths[i], aacContents[i],
+                                          MAX_LENGTH / 2);
+      assert(pcContents != NULL && pcContents[0] == 'a' + (int) (i % 26));
+   }
+
+   /* A multi-get pins its whole batch past the budget */
+   assert(FT_getFileContentsMulti(apcPaths, NUM_FILES + 1, apvContents,
+                                  aulLengths) == SUCCESS);
+   for(i = 0; i < NUM_FILES; i++) {
+      if(i % 2 == 0) {
+         assert(apvContents[i] == NULL && aulLengths[i] == 0);
+         continue;
+      }
+      assert(aulLengths[i] == MAX_LENGTH / 2);
+      assert(memcmp(apvContents[i], aacContents[i], MAX_LENGTH / 2) ==
+             0);
+   }
+   assert(apvContents[NUM_FILES] == NULL);
+   assert(FT_destroy() == SUCCESS);
+   assert(fopen(pcSpill, "rb") == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 200, ulSeed = 1, r;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   ContentStoreClient_statuses();
+   for(r = 0; r < ulRounds; r++)
+      ContentStoreClient_round();
+   ContentStoreClient_clock();
+   ContentStoreClient_compact();
+   ContentStoreClient_ft();
+
+   printf("%lu content stores matched the bytes put\n", ulRounds);
+   return EXIT_SUCCESS;
+}
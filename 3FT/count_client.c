@@ -0,0 +1,229 @@
+/*--------------------------------------------------------------------*/
+/* count_client.c                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  count_client checks FT_count and FT_nth against FT_toString.
+
+  Usage: count_client [-r rounds] [-s seed]
+
+  Each round builds a random tree, then removes random files and
+  directories, detaches a random directory and grafts it back, and
+  inserts more paths, checking the whole tree after every step. The
+  entries below a directory are the lines of FT_toString that follow
+  the directory's own line and extend its path with a '/'. FT_count
+  must count them, files and directories apart, and FT_nth must give
+  each of them by its index, and NO_SUCH_PATH past the last. Paths
+  that are files, missing, bad or off the root must fail with the
+  status their interface lists, leaving the results untouched.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Paths inserted at each building step, of which some fail */
+enum { NUM_INSERTS = 150 };
+
+/* Deepest path drawn, counting the root */
+enum { MAX_DEPTH = 5 };
+
+/* Longest path drawn, including its terminator */
+enum { MAX_PATH = 32 };
+
+/* Most lines of FT_toString: two building steps' worth */
+enum { MAX_LINES = 1 + 2 * NUM_INSERTS * (MAX_DEPTH - 1) };
+
+/* The lines of the FT's FT_toString */
+static char *apcLines[MAX_LINES];
+static size_t ulNumLines;
+
+/*--------------------------------------------------------------------*/
+
+/* Inserts random files and directories below r, up to MAX_DEPTH
+   levels deep, with components of one or two of "a", "b", "." and
+   "-". */
+static void CountClient_build(void) {
+   static const char acChars[] = "ab.-";
+   char acPath[MAX_PATH];
+   size_t ulDepth, i, j;
+   char *pcEnd;
+
+   for(i = 0; i < NUM_INSERTS; i++) {
+      ulDepth = 1 + (size_t) rand() % MAX_DEPTH;
+      strcpy(acPath, "r");
+      pcEnd = acPath + 1;
+      for(j = 1; j < ulDepth; j++) {
+         *pcEnd++ = '/';
+         *pcEnd++ = acChars[rand() % 4];
+         if(rand() % 2 == 0)
+            *pcEnd++ = acChars[rand() % 4];
+      }
+      *pcEnd = '\0';
+      if(rand() % 2 == 0)
+         (void) FT_insertDir(acPath);
+      else
+         (void) FT_insertFile(acPath, NULL, 0);
+   }
+}
+
+/* Splits the FT's FT_toString into apcLines, returning the string,
+   which the caller must free. */
+static char *CountClient_lines(void) {
+   char *pcString, *pcLine;
+
+   pcString = FT_toString();
+   assert(pcString != NULL);
+   ulNumLines = 0;
+   for(pcLine = strtok(pcString, "\n"); pcLine != NULL;
+       pcLine = strtok(NULL, "\n")) {
+      assert(ulNumLines < MAX_LINES);
+      apcLines[ulNumLines++] = pcLine;
+   }
+   return pcString;
+}
+
+/* Checks FT_count and FT_nth on every directory of the FT, and on
+   files and paths that are not directories of it. */
+static void CountClient_check(void) {
+   const char *pcResult, *pcUnset = "unset";
+   size_t ulFiles, ulDirs, ulBelow, ulLength, i, j;
+   size_t ulFoundFiles, ulFoundDirs;
+   boolean bIsFile;
+   char *pcString;
+
+   pcString = CountClient_lines();
+   for(i = 0; i < ulNumLines; i++) {
+      if(FT_containsFile(apcLines[i])) {
+         ulFiles = ulDirs = 7;
+         assert(FT_count(apcLines[i], &ulFiles, &ulDirs) ==
+                NOT_A_DIRECTORY);
+         assert(ulFiles == 7 && ulDirs == 7);
+         assert(FT_nth(apcLines[i], 0, &pcResult, &bIsFile) ==
+                NOT_A_DIRECTORY);
+         continue;
+      }
+
+      /* The lines below the directory's, in order */
+      ulLength = strlen(apcLines[i]);
+      ulFiles = ulDirs = 0;
+      for(ulBelow = 0; i + 1 + ulBelow < ulNumLines; ulBelow++) {
+         if(strncmp(apcLines[i + 1 + ulBelow], apcLines[i],
+                    ulLength) != 0 ||
+            apcLines[i + 1 + ulBelow][ulLength] != '/')
+            break;
+         if(FT_containsFile(apcLines[i + 1 + ulBelow]))
+            ulFiles++;
+         else
+            ulDirs++;
+      }
+
+      assert(FT_count(apcLines[i], &ulFoundFiles, &ulFoundDirs) ==
+             SUCCESS);
+      assert(ulFoundFiles == ulFiles && ulFoundDirs == ulDirs);
+      for(j = 0; j < ulBelow; j++) {
+         assert(FT_nth(apcLines[i], j, &pcResult, &bIsFile) == SUCCESS);
+         assert(strcmp(pcResult, apcLines[i + 1 + j]) == 0);
+         assert(bIsFile == FT_containsFile(pcResult));
+      }
+      pcResult = pcUnset;
+      assert(FT_nth(apcLines[i], ulBelow, &pcResult, &bIsFile) ==
+             NO_SUCH_PATH);
+      assert(pcResult == pcUnset);
+   }
+   free(pcString);
+
+   ulFiles = ulDirs = 7;
+   assert(FT_count("r/zz/a", &ulFiles, &ulDirs) == NO_SUCH_PATH);
+   assert(FT_count("x/a", &ulFiles, &ulDirs) == CONFLICTING_PATH);
+   assert(FT_count("r//a", &ulFiles, &ulDirs) == BAD_PATH);
+   assert(ulFiles == 7 && ulDirs == 7);
+   assert(FT_nth("r/zz/a", 0, &pcResult, &bIsFile) == NO_SUCH_PATH);
+   assert(FT_nth("r/", 0, &pcResult, &bIsFile) == BAD_PATH);
+   assert(pcResult == pcUnset);
+}
+
+/* Removes about one in ulEvery of the FT's entries below the root. */
+static void CountClient_remove(size_t ulEvery) {
+   char *pcString;
+   size_t i;
+
+   pcString = CountClient_lines();
+   for(i = 1; i < ulNumLines; i++)
+      if((size_t) rand() % ulEvery == 0) {
+         if(FT_containsFile(apcLines[i]))
+            (void) FT_rmFile(apcLines[i]);
+         else
+            (void) FT_rmDir(apcLines[i]);
+      }
+   free(pcString);
+}
+
+/* Detaches a random directory below the root, checks the FT without
+   it, and grafts it back. */
+static void CountClient_regraft(void) {
+   char acPath[MAX_PATH];
+   FTSubtree_T oSSubtree;
+   char *pcString;
+   size_t i;
+
+   pcString = CountClient_lines();
+   acPath[0] = '\0';
+   for(i = 1; i < ulNumLines; i++)
+      if(FT_containsDir(apcLines[i]) && rand() % 4 == 0) {
+         strcpy(acPath, apcLines[i]);
+         break;
+      }
+   free(pcString);
+   if(acPath[0] == '\0')
+      return;
+
+   assert(FT_detachSubtree(acPath, &oSSubtree) == SUCCESS);
+   CountClient_check();
+   assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 10, ulSeed = 1, r;
+   size_t ulFiles, ulDirs;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   assert(FT_count("r", &ulFiles, &ulDirs) == INITIALIZATION_ERROR);
+   for(r = 0; r < ulRounds; r++) {
+      assert(FT_init() == SUCCESS);
+      assert(FT_count("r", &ulFiles, &ulDirs) == NO_SUCH_PATH);
+      CountClient_build();
+      CountClient_check();
+      CountClient_remove(7);
+      CountClient_check();
+      CountClient_regraft();
+      CountClient_check();
+      CountClient_build();
+      CountClient_check();
+      assert(FT_destroy() == SUCCESS);
+   }
+
+   printf("%lu trees counted\n", ulRounds);
+   return EXIT_SUCCESS;
+}
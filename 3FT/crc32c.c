@@ -0,0 +1,105 @@
+/*--------------------------------------------------------------------*/
+/* crc32c.c                                                           */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <string.h>
+#include "a4def.h"
+#include "crc32c.h"
+
+/* The polynomial, bit-reversed */
+#define POLYNOMIAL 0x82f63b78UL
+
+/* aaulTable[k][b] is the CRC of byte b followed by k zero bytes */
+static unsigned long aaulTable[8][256];
+
+/* Whether Crc32c_init has run, and whether to use the instruction */
+static boolean bIsReady;
+static boolean bUseHardware;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the inverted CRC ulCrc advanced over the ulLength bytes at
+   pucData, eight at a time through the tables. */
+static unsigned long Crc32c_software(unsigned long ulCrc,
+                                     const unsigned char *pucData,
+                                     size_t ulLength) {
+   while(ulLength >= 8) {
+      ulCrc ^= (unsigned long) pucData[0] |
+               (unsigned long) pucData[1] << 8 |
+               (unsigned long) pucData[2] << 16 |
+               (unsigned long) pucData[3] << 24;
+      ulCrc = aaulTable[7][ulCrc & 0xff] ^
+              aaulTable[6][(ulCrc >> 8) & 0xff] ^
+              aaulTable[5][(ulCrc >> 16) & 0xff] ^
+              aaulTable[4][(ulCrc >> 24) & 0xff] ^
+              aaulTable[3][pucData[4]] ^ aaulTable[2][pucData[5]] ^
+              aaulTable[1][pucData[6]] ^ aaulTable[0][pucData[7]];
+      pucData += 8;
+      ulLength -= 8;
+   }
+   while(ulLength-- > 0)
+      ulCrc = aaulTable[0][(ulCrc ^ *pucData++) & 0xff] ^ (ulCrc >> 8);
+   return ulCrc;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+/* Like Crc32c_software, but with the SSE4.2 crc32 instruction, eight
+   bytes at a time. Only called if the processor supports it. */
+__attribute__((target("sse4.2")))
+static unsigned long Crc32c_hardware(unsigned long ulCrc,
+                                     const unsigned char *pucData,
+                                     size_t ulLength) {
+   unsigned long ulWord;
+
+   while(ulLength >= sizeof(unsigned long)) {
+      memcpy(&ulWord, pucData, sizeof(unsigned long));
+      ulCrc = (unsigned long) __builtin_ia32_crc32di(ulCrc, ulWord);
+      pucData += sizeof(unsigned long);
+      ulLength -= sizeof(unsigned long);
+   }
+   while(ulLength-- > 0)
+      ulCrc = __builtin_ia32_crc32qi((unsigned int) ulCrc, *pucData++);
+   return ulCrc;
+}
+#endif
+
+/* ================================================================== */
+void Crc32c_init(void) {
+   unsigned long ulCrc;
+   int iByte, iBit, iSlice;
+
+   if(bIsReady)
+      return;
+   for(iByte = 0; iByte < 256; iByte++) {
+      ulCrc = (unsigned long) iByte;
+      for(iBit = 0; iBit < 8; iBit++)
+         ulCrc = (ulCrc & 1) ? (ulCrc >> 1) ^ POLYNOMIAL : ulCrc >> 1;
+      aaulTable[0][iByte] = ulCrc;
+   }
+   for(iByte = 0; iByte < 256; iByte++)
+      for(iSlice = 1; iSlice < 8; iSlice++)
+         aaulTable[iSlice][iByte] =
+            aaulTable[0][aaulTable[iSlice - 1][iByte] & 0xff] ^
+            (aaulTable[iSlice - 1][iByte] >> 8);
+
+#if defined(__GNUC__) && defined(__x86_64__)
+   bUseHardware = (boolean) (__builtin_cpu_supports("sse4.2") != 0);
+#endif
+   bIsReady = TRUE;
+}
+
+/* ================================================================== */
+unsigned long Crc32c_compute(unsigned long ulCrc, const void *pvData,
+                             size_t ulLength) {
+   assert(bIsReady);
+   assert(pvData != NULL || ulLength == 0);
+
+   ulCrc ^= 0xffffffffUL;
+#if defined(__GNUC__) && defined(__x86_64__)
+   if(bUseHardware)
+      return Crc32c_hardware(ulCrc, pvData, ulLength) ^ 0xffffffffUL;
+#endif
+   return Crc32c_software(ulCrc, pvData, ulLength) ^ 0xffffffffUL;
+}
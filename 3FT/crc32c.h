@@ -0,0 +1,29 @@
+/*--------------------------------------------------------------------*/
+/* crc32c.h                                                           */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef CRC32C_INCLUDED
+#define CRC32C_INCLUDED
+
+/*
+  CRC-32C (the Castagnoli polynomial, as in iSCSI and ext4), computed
+  with the SSE4.2 crc32 instruction where the processor has it, and
+  otherwise with a portable slice-by-8 table.
+*/
+
+#include <stddef.h>
+
+/* Prepares the tables and chooses the implementation. Must be called,
+   from one thread, before Crc32c_compute; later calls do nothing. */
+void Crc32c_init(void);
+
+/*
+  Returns the CRC-32C of the ulLength bytes at pvData, continuing from
+  ulCrc, the value returned for the bytes before them (0 to start).
+  pvData may be NULL if ulLength is 0.
+*/
+unsigned long Crc32c_compute(unsigned long ulCrc, const void *pvData,
+                             size_t ulLength);
+
+#endif
@@ -0,0 +1,152 @@
+/*--------------------------------------------------------------------*/
+/* dynarray_client.c                                                  */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  dynarray_client checks DynArray_reserve and DynArray_merge on random
+  sorted arrays.
+
+  Usage: dynarray_client [-r rounds] [-s seed]
+
+  Each round merges a random sorted source array into a random sorted
+  destination array, either of which may be empty, with keys drawn
+  so that both hold many equal elements. The result
+  must hold every element, in order, with each source element after
+  the destination elements equal to it, and the source must be empty.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dynarray.h"
+
+/* Most elements in either array of a round */
+enum { MAX_ELEMENTS = 200 };
+
+/* An element: its key and which array it started in */
+struct element {
+   int iKey;
+   int iSource;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the keys of elements pvFirst and pvSecond only, so that
+   elements from the two arrays can be equal. */
+static int DynArrayClient_compare(const void *pvFirst,
+                                  const void *pvSecond) {
+   const struct element *psFirst = pvFirst;
+   const struct element *psSecond = pvSecond;
+
+   return psFirst->iKey - psSecond->iKey;
+}
+
+/* Stores in psElements ulCount elements with sorted random keys, from
+   array iSource, and adds them in order to oDArray. */
+static void DynArrayClient_fill(DynArray_T oDArray,
+                                struct element *psElements,
+                                size_t ulCount, int iSource) {
+   size_t i;
+   int iKey = rand() % 4;
+
+   /* Keys rise by one a third of the time, so many are equal */
+   for(i = 0; i < ulCount; i++) {
+      iKey += rand() % 3 == 0;
+      psElements[i].iKey = iKey;
+      psElements[i].iSource = iSource;
+      assert(DynArray_add(oDArray, &psElements[i]));
+   }
+}
+
+/* Merges ulDest destination and ulSource source elements, checking
+   the result. Reserves room first if bReserve. */
+static void DynArrayClient_round(size_t ulDest, size_t ulSource,
+                                 int bReserve) {
+   struct element asDest[MAX_ELEMENTS], asSource[MAX_ELEMENTS];
+   struct element *psElement, *psPrevious = NULL;
+   DynArray_T oDDest, oDSource;
+   size_t i, ulFromDest = 0, ulFromSource = 0;
+
+   oDDest = DynArray_new(0);
+   oDSource = DynArray_new(0);
+   assert(oDDest != NULL && oDSource != NULL);
+   DynArrayClient_fill(oDDest, asDest, ulDest, 0);
+   DynArrayClient_fill(oDSource, asSource, ulSource, 1);
+
+   if(bReserve)
+      assert(DynArray_reserve(oDDest, ulDest + ulSource));
+   assert(DynArray_merge(oDDest, oDSource, DynArrayClient_compare));
+   assert(DynArray_getLength(oDSource) == 0);
+   assert(DynArray_getLength(oDDest) == ulDest + ulSource);
+
+   for(i = 0; i < ulDest + ulSource; i++) {
+      psElement = DynArray_get(oDDest, i);
+      /* Every element once, each array's in their old order */
+      if(psElement->iSource == 0) {
+         assert(psElement == &asDest[ulFromDest]);
+         ulFromDest++;
+      }
+      else {
+         assert(psElement == &asSource[ulFromSource]);
+         ulFromSource++;
+      }
+      /* Sorted, with source elements after equal dest elements */
+      if(psPrevious != NULL) {
+         assert(psPrevious->iKey <= psElement->iKey);
+         if(psPrevious->iKey == psElement->iKey)
+            assert(psPrevious->iSource <= psElement->iSource);
+      }
+      psPrevious = psElement;
+   }
+   assert(ulFromDest == ulDest && ulFromSource == ulSource);
+
+   /* The emptied source can be merged again */
+   assert(DynArray_merge(oDDest, oDSource, DynArrayClient_compare));
+   assert(DynArray_getLength(oDDest) == ulDest + ulSource);
+
+   DynArray_free(oDDest);
+   DynArray_free(oDSource);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 20000, ulSeed = 1, r;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   /* Empty arrays on either side or both */
+   DynArrayClient_round(0, 0, 0);
+   DynArrayClient_round(0, 10, 0);
+   DynArrayClient_round(10, 0, 1);
+
+   for(r = 0; r < ulRounds; r++) {
+      size_t ulDest = (size_t) rand() % MAX_ELEMENTS;
+      size_t ulSource = (size_t) rand() % MAX_ELEMENTS;
+
+      /* Often a few source elements into many, as the FT merges */
+      if(r % 2 == 0)
+         ulSource %= 8;
+      DynArrayClient_round(ulDest, ulSource, (int) (r % 3 == 0));
+   }
+
+   printf("%lu rounds merged correctly\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*--------------------------------------------------------------------*/
+/* expiry_client.c                                                    */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  expiry_client checks FT_enableExpiry, FT_setExpiry and FT_expire
+  against a table of deadlines.
+
+  Usage: expiry_client [-r rounds] [-s seed]
+
+  Each round enables expiry at a random time and then, step after
+  step, inserts files, sets, moves and clears their deadlines, some
+  already past and some far enough ahead to sit in the timer wheel's
+  upper levels, replaces and removes files, and moves the time forward
+  by a little or, now and then, by a lot, expiring files in batches of
+  random size. Every file passed to the callback must be in the table
+  with a deadline no later than the time; a batch must remove as many
+  files as it reports, and leave no file due unless it was full; the
+  FT must hold exactly the table's files, and keep the directories
+  files expired from.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Files worked on, spread over NUM_DIRS directories */
+enum { NUM_FILES = 200, NUM_DIRS = 7 };
+
+/* Longest path, including its terminator */
+enum { MAX_PATH = 16 };
+
+/* Steps in each round, and the changes made at each */
+enum { NUM_STEPS = 1000, NUM_CHANGES = 5 };
+
+/* Steps between checks of every file, and between large time jumps */
+enum { FULL_CHECK = 20, JUMP = 100 };
+
+/* Whether each file is in the table, and its deadline, or 0 */
+static boolean abPresent[NUM_FILES];
+static unsigned long aulDeadlines[NUM_FILES];
+
+/* The time */
+static unsigned long ulNow;
+
+/* Files expired by the last call, in order */
+static size_t aulExpired[NUM_FILES];
+static size_t ulExpired;
+
+/*--------------------------------------------------------------------*/
+
+/* Writes into pcPath the path of file ulFile. */
+static void ExpiryClient_path(size_t ulFile, char *pcPath) {
+   sprintf(pcPath, "r/d%lu/f%lu", (unsigned long) ulFile % NUM_DIRS,
+           (unsigned long) ulFile);
+}
+
+/* Returns TRUE if file ulFile is due at the time, FALSE otherwise. */
+static boolean ExpiryClient_due(size_t ulFile) {
+   return (boolean) (abPresent[ulFile] && aulDeadlines[ulFile] != 0 &&
+                     aulDeadlines[ulFile] <= ulNow);
+}
+
+/* Checks the expired file pcPath against the table, and forgets
+   it. */
+static void ExpiryClient_expired(const char *pcPath, void *pvContents,
+                                 size_t ulLength, void *pvExtra) {
+   unsigned long ulFile;
+
+   (void) pvContents;
+   (void) ulLength;
+   assert(pvExtra == &ulExpired);
+   assert(sscanf(strrchr(pcPath, '/'), "/f%lu", &ulFile) == 1);
+   assert(ulFile < NUM_FILES && ExpiryClient_due(ulFile));
+   abPresent[ulFile] = FALSE;
+   aulDeadlines[ulFile] = 0;
+   aulExpired[ulExpired++] = ulFile;
+}
+
+/* Returns a random deadline: soon, later, much later, or already
+   past. */
+static unsigned long ExpiryClient_randomDeadline(void) {
+   switch(rand() % 8) {
+      case 0: case 1: case 2:
+         return ulNow + (unsigned long) rand() % 100;
+      case 3: case 4:
+         return ulNow + (unsigned long) rand() % 100000;
+      case 5:
+         return ulNow + (unsigned long) rand() * 64;
+      default:
+         return ulNow - (unsigned long) rand() % 5;
+   }
+}
+
+/* Makes one random change to file ulFile. */
+static void ExpiryClient_change(size_t ulFile) {
+   char acPath[MAX_PATH];
+   unsigned long ulDeadline;
+
+   ExpiryClient_path(ulFile, acPath);
+   if(!abPresent[ulFile]) {
+      assert(FT_insertFile(acPath, NULL, 0) == SUCCESS);
+      abPresent[ulFile] = TRUE;
+      aulDeadlines[ulFile] = 0;
+      return;
+   }
+   switch(rand() % 10) {
+      case 0:
+         assert(FT_setExpiry(acPath, 0) == SUCCESS);
+         aulDeadlines[ulFile] = 0;
+         break;
+      case 1:
+         /* The deadline stays with the file */
+         (void) FT_replaceFileContents(acPath, NULL, 0);
+         break;
+      case 2:
+         assert(FT_rmFile(acPath) == SUCCESS);
+         abPresent[ulFile] = FALSE;
+         aulDeadlines[ulFile] = 0;
+         break;
+      default:
+         ulDeadline = ExpiryClient_randomDeadline();
+         assert(FT_setExpiry(acPath, ulDeadline) == SUCCESS);
+         aulDeadlines[ulFile] = ulDeadline;
+         break;
+   }
+}
+
+/* Moves the time forward at step ulStep, expires a batch of files,
+   and checks the batch. */
+static void ExpiryClient_expire(size_t ulStep) {
+   char acPath[MAX_PATH];
+   size_t ulMaxFiles, ulDue, ulRemoved, i;
+
+   ulNow += (unsigned long) rand() %
+            (ulStep % JUMP == 0 ? 5000000 : 300);
+   ulDue = 0;
+   for(i = 0; i < NUM_FILES; i++)
+      if(ExpiryClient_due(i))
+         ulDue++;
+   ulMaxFiles = rand() % 3 == 0 ? 1 + (size_t) rand() % 4 : 0;
+
+   /* Without a callback, every due file must go */
+   ulExpired = 0;
+   if(ulMaxFiles == 0 && rand() % 4 == 0) {
+      assert(FT_expire(ulNow, 0, NULL, NULL, &ulRemoved) == SUCCESS);
+      assert(ulRemoved == ulDue);
+      for(i = 0; i < NUM_FILES; i++)
+         if(ExpiryClient_due(i)) {
+            abPresent[i] = FALSE;
+            aulDeadlines[i] = 0;
+            aulExpired[ulExpired++] = i;
+         }
+   }
+   else if(rand() % 4 == 0) {
+      assert(FT_expire(ulNow, ulMaxFiles, ExpiryClient_expired,
+                       &ulExpired, NULL) == SUCCESS);
+      ulRemoved = ulExpired;
+   }
+   else
+      assert(FT_expire(ulNow, ulMaxFiles, ExpiryClient_expired,
+                       &ulExpired, &ulRemoved) == SUCCESS);
+   assert(ulRemoved == ulExpired);
+   assert(ulRemoved == (ulMaxFiles != 0 && ulDue > ulMaxFiles ?
+                        ulMaxFiles : ulDue));
+
+   /* Expiry leaves directories in place */
+   for(i = 0; i < ulExpired; i++) {
+      ExpiryClient_path(aulExpired[i], acPath);
+      assert(!FT_containsFile(acPath));
+      *strrchr(acPath, '/') = '\0';
+      assert(FT_containsDir(acPath));
+   }
+}
+
+/* Checks that the FT holds exactly the table's files. */
+static void ExpiryClient_check(void) {
+   char acPath[MAX_PATH];
+   size_t i;
+
+   for(i = 0; i < NUM_FILES; i++) {
+      ExpiryClient_path(i, acPath);
+      assert(FT_containsFile(acPath) == abPresent[i]);
+   }
+}
+
+/* Checks the statuses of calls that must fail, and enables expiry
+   again, which must keep every deadline. */
+static void ExpiryClient_failures(void) {
+   assert(FT_setExpiry("r//f0", 1) == BAD_PATH);
+   assert(FT_setExpiry("x/d0/f0", 1) == CONFLICTING_PATH);
+   assert(FT_setExpiry("r/d0", 1) == NO_SUCH_PATH);
+   assert(FT_setExpiry("r/d0/f1", 1) == NO_SUCH_PATH);
+   assert(FT_enableExpiry(ulNow) == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 10, ulSeed = 1, r;
+   size_t ulRemoved, i, j;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   assert(FT_enableExpiry(0) == INITIALIZATION_ERROR);
+   for(r = 0; r < ulRounds; r++) {
+      assert(FT_init() == SUCCESS);
+      memset(abPresent, 0, sizeof(abPresent));
+      memset(aulDeadlines, 0, sizeof(aulDeadlines));
+
+      /* Deadlines need expiry enabled */
+      assert(FT_insertFile("r/d0/f0", NULL, 0) == SUCCESS);
+      abPresent[0] = TRUE;
+      assert(FT_setExpiry("r/d0/f0", 1) == INITIALIZATION_ERROR);
+      ulRemoved = 1;
+      assert(FT_expire(1, 0, NULL, NULL, &ulRemoved) ==
+             INITIALIZATION_ERROR);
+      assert(ulRemoved == 0);
+
+      ulNow = 1000000 + (unsigned long) rand();
+      assert(FT_enableExpiry(ulNow) == SUCCESS);
+      assert(FT_expire(ulNow, 0, NULL, NULL, &ulRemoved) == SUCCESS);
+      assert(ulRemoved == 0);
+      for(i = 0; i < NUM_STEPS; i++) {
+         if(i == NUM_STEPS / 2)
+            ExpiryClient_failures();
+         for(j = 0; j < NUM_CHANGES; j++)
+            ExpiryClient_change((size_t) rand() % NUM_FILES);
+         ExpiryClient_expire(i);
+         if(i % FULL_CHECK == 0)
+            ExpiryClient_check();
+      }
+      ExpiryClient_check();
+      assert(FT_destroy() == SUCCESS);
+   }
+
+   printf("%lu rounds of deadlines matched\n", ulRounds);
+   return EXIT_SUCCESS;
+}
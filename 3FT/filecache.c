@@ -0,0 +1,172 @@
+/*--------------------------------------------------------------------*/
+/* filecache.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "filecache.h"
+
+/* The cache */
+struct fileCache {
+   /* Ends of the recency list: most and least recently used */
+   NodeF_T oNfNewest;
+   NodeF_T oNfOldest;
+
+   /* Number of nodes on the list and total length of their contents */
+   size_t ulLength;
+   size_t ulBytes;
+
+   /* Capacity; 0 for no limit */
+   size_t ulMaxFiles;
+   size_t ulMaxBytes;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns TRUE if oNfNode is on oFCache's list. */
+static boolean FileCache_contains(FileCache_T oFCache, NodeF_T oNfNode) {
+   struct NodeFLinks *psLinks = NodeF_getLinks(oNfNode);
+
+   return (boolean) (psLinks->oNfOlder != NULL ||
+                     psLinks->oNfNewer != NULL ||
+                     oFCache->oNfNewest == oNfNode);
+}
+
+/* Unlinks oNfNode, which is on oFCache's list. */
+static void FileCache_unlink(FileCache_T oFCache, NodeF_T oNfNode) {
+   struct NodeFLinks *psLinks = NodeF_getLinks(oNfNode);
+
+   if(psLinks->oNfOlder != NULL)
+      NodeF_getLinks(psLinks->oNfOlder)->oNfNewer = psLinks->oNfNewer;
+   else
+      oFCache->oNfOldest = psLinks->oNfNewer;
+   if(psLinks->oNfNewer != NULL)
+      NodeF_getLinks(psLinks->oNfNewer)->oNfOlder = psLinks->oNfOlder;
+   else
+      oFCache->oNfNewest = psLinks->oNfOlder;
+   psLinks->oNfOlder = NULL;
+   psLinks->oNfNewer = NULL;
+}
+
+/* Links oNfNode, which is on no list, at the newest end of oFCache's
+   list. */
+static void FileCache_linkNewest(FileCache_T oFCache, NodeF_T oNfNode) {
+   struct NodeFLinks *psLinks = NodeF_getLinks(oNfNode);
+
+   psLinks->oNfOlder = oFCache->oNfNewest;
+   psLinks->oNfNewer = NULL;
+   if(oFCache->oNfNewest != NULL)
+      NodeF_getLinks(oFCache->oNfNewest)->oNfNewer = oNfNode;
+   else
+      oFCache->oNfOldest = oNfNode;
+   oFCache->oNfNewest = oNfNode;
+}
+
+/* ================================================================== */
+FileCache_T FileCache_new(size_t ulMaxFiles, size_t ulMaxBytes) {
+   FileCache_T oFCache;
+
+   oFCache = malloc(sizeof(struct fileCache));
+   if(oFCache == NULL)
+      return NULL;
+   oFCache->oNfNewest = NULL;
+   oFCache->oNfOldest = NULL;
+   oFCache->ulLength = 0;
+   oFCache->ulBytes = 0;
+   oFCache->ulMaxFiles = ulMaxFiles;
+   oFCache->ulMaxBytes = ulMaxBytes;
+   return oFCache;
+}
+
+/* ================================================================== */
+void FileCache_free(FileCache_T oFCache) {
+   assert(oFCache != NULL);
+
+   free(oFCache);
+}
+
+/* ================================================================== */
+void FileCache_setCapacity(FileCache_T oFCache, size_t ulMaxFiles,
+                           size_t ulMaxBytes) {
+   assert(oFCache != NULL);
+
+   oFCache->ulMaxFiles = ulMaxFiles;
+   oFCache->ulMaxBytes = ulMaxBytes;
+}
+
+/* ================================================================== */
+void FileCache_insert(FileCache_T oFCache, NodeF_T oNfNode) {
+   assert(oFCache != NULL);
+   assert(oNfNode != NULL);
+   assert(!FileCache_contains(oFCache, oNfNode));
+
+   FileCache_linkNewest(oFCache, oNfNode);
+   oFCache->ulLength++;
+   oFCache->ulBytes += NodeF_getLength(oNfNode);
+}
+
+/* ================================================================== */
+void FileCache_remove(FileCache_T oFCache, NodeF_T oNfNode) {
+   assert(oFCache != NULL);
+   assert(oNfNode != NULL);
+
+   if(!FileCache_contains(oFCache, oNfNode))
+      return;
+   FileCache_unlink(oFCache, oNfNode);
+   oFCache->ulLength--;
+   oFCache->ulBytes -= NodeF_getLength(oNfNode);
+}
+
+/* ================================================================== */
+void FileCache_touch(FileCache_T oFCache, NodeF_T oNfNode) {
+   assert(oFCache != NULL);
+   assert(oNfNode != NULL);
+
+   if(oFCache->oNfNewest == oNfNode ||
+      !FileCache_contains(oFCache, oNfNode))
+      return;
+   FileCache_unlink(oFCache, oNfNode);
+   FileCache_linkNewest(oFCache, oNfNode);
+}
+
+/* ================================================================== */
+void FileCache_resize(FileCache_T oFCache, NodeF_T oNfNode,
+                      size_t ulOldLength) {
+   assert(oFCache != NULL);
+   assert(oNfNode != NULL);
+
+   if(!FileCache_contains(oFCache, oNfNode))
+      return;
+   oFCache->ulBytes = oFCache->ulBytes - ulOldLength +
+                      NodeF_getLength(oNfNode);
+   FileCache_touch(oFCache, oNfNode);
+}
+
+/* ================================================================== */
+NodeF_T FileCache_getVictim(FileCache_T oFCache) {
+   assert(oFCache != NULL);
+
+   if(oFCache->oNfOldest == oFCache->oNfNewest)
+      return NULL;
+   if((oFCache->ulMaxFiles != 0 &&
+       oFCache->ulLength > oFCache->ulMaxFiles) ||
+      (oFCache->ulMaxBytes != 0 &&
+       oFCache->ulBytes > oFCache->ulMaxBytes))
+      return oFCache->oNfOldest;
+   return NULL;
+}
+
+/* ================================================================== */
+size_t FileCache_getLength(FileCache_T oFCache) {
+   assert(oFCache != NULL);
+
+   return oFCache->ulLength;
+}
+
+/* ================================================================== */
+size_t FileCache_getBytes(FileCache_T oFCache) {
+   assert(oFCache != NULL);
+
+   return oFCache->ulBytes;
+}
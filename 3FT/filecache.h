@@ -0,0 +1,69 @@
+/*--------------------------------------------------------------------*/
+/* filecache.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef FILECACHE_INCLUDED
+#define FILECACHE_INCLUDED
+
+/*
+  A file cache tracks file nodes from most to least recently used on
+  a doubly-linked list threaded through the nodes themselves, along
+  with their number and total length, and names the least recently
+  used node once either passes a configured capacity. Since the links
+  live in the nodes, no operation allocates or fails.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "nodef.h"
+
+/* A FileCache_T is a recency list of file nodes with a capacity */
+typedef struct fileCache *FileCache_T;
+
+/*
+  Returns a new, empty file cache holding at most ulMaxFiles files of
+  at most ulMaxBytes bytes in total (0 for no limit), or NULL if
+  insufficient memory is available.
+*/
+FileCache_T FileCache_new(size_t ulMaxFiles, size_t ulMaxBytes);
+
+/* Destroys oFCache. The file nodes it refers to are neither freed nor
+   touched, so they may already have been freed. */
+void FileCache_free(FileCache_T oFCache);
+
+/* Changes the capacity of oFCache, as in FileCache_new. */
+void FileCache_setCapacity(FileCache_T oFCache, size_t ulMaxFiles,
+                           size_t ulMaxBytes);
+
+/* Adds oNfNode, not already in oFCache, as the most recently used. */
+void FileCache_insert(FileCache_T oFCache, NodeF_T oNfNode);
+
+/* Removes oNfNode, if present, from oFCache. */
+void FileCache_remove(FileCache_T oFCache, NodeF_T oNfNode);
+
+/* Marks oNfNode, if present, as the most recently used. */
+void FileCache_touch(FileCache_T oFCache, NodeF_T oNfNode);
+
+/*
+  Records that the contents of oNfNode, if present, changed from
+  ulOldLength bytes to their current length, and marks it as the most
+  recently used.
+*/
+void FileCache_resize(FileCache_T oFCache, NodeF_T oNfNode,
+                      size_t ulOldLength);
+
+/*
+  Returns the least recently used file node if oFCache is over its
+  capacity, or NULL if it is within it. The most recently used node is
+  never returned, so a single file larger than the byte limit stays.
+*/
+NodeF_T FileCache_getVictim(FileCache_T oFCache);
+
+/* Returns the number of file nodes in oFCache. */
+size_t FileCache_getLength(FileCache_T oFCache);
+
+/* Returns the total length of the contents of oFCache's file nodes. */
+size_t FileCache_getBytes(FileCache_T oFCache);
+
+#endif
@@ -0,0 +1,320 @@
+/*--------------------------------------------------------------------*/
+/* frozen_client.c                                                    */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  frozen_client checks FT_freeze, FT_writeFrozen and FT_mapFrozen.
+
+  Usage: frozen_client [-f imagefile] [-s seed]
+
+  It builds a random tree and records, for a list of paths, what
+  FT_stat, FT_containsDir, FT_containsFile and FT_getFileContents say
+  of each, along with FT_toString. The list holds paths in the tree,
+  missing paths, bad paths and paths off the root. It then freezes the
+  FT and checks that the frozen image gives the same answers, writes
+  the image to imagefile, maps it back in and checks it again. It also
+  checks an empty tree, and checks that damaged images are refused:
+  short, truncated and mislabelled ones. Images with random bytes
+  overwritten must answer every call without crashing.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Paths inserted into the tree, of which some fail */
+enum { NUM_INSERTS = 2000 };
+
+/* Paths whose answers are compared */
+enum { NUM_PATHS = 3000 };
+
+/* Deepest path drawn, counting the root */
+enum { MAX_DEPTH = 6 };
+
+/* Longest path drawn or listed, including its terminator */
+enum { MAX_PATH = 32 };
+
+/* Copies of the image damaged at random, and bytes damaged in each */
+enum { NUM_DAMAGED = 50, DAMAGED_BYTES = 8 };
+
+/* What the live FT said of one path */
+struct answer {
+   char acPath[MAX_PATH];
+   int iStatus;
+   boolean bIsFile;
+   size_t ulSize;
+   void *pvContents;
+};
+
+/* The paths compared, and the FT_toString of the live tree */
+static struct answer asAnswers[NUM_PATHS];
+static size_t ulNumAnswers;
+static char *pcExpected;
+
+/*--------------------------------------------------------------------*/
+
+/* Writes into pcPath a random path below r, up to MAX_DEPTH levels
+   deep, with components "a" to "d". */
+static void FrozenClient_randomPath(char *pcPath) {
+   size_t ulDepth = 1 + (size_t) rand() % MAX_DEPTH;
+   size_t i;
+
+   strcpy(pcPath, "r");
+   for(i = 1; i < ulDepth; i++)
+      sprintf(pcPath + strlen(pcPath), "/%c", 'a' + rand() % 4);
+}
+
+/* Records the live FT's answers for pcPath in the next answer. */
+static void FrozenClient_record(const char *pcPath) {
+   struct answer *psAnswer = &asAnswers[ulNumAnswers++];
+
+   assert(ulNumAnswers <= NUM_PATHS);
+   strcpy(psAnswer->acPath, pcPath);
+   psAnswer->bIsFile = FALSE;
+   psAnswer->ulSize = 0;
+   psAnswer->iStatus = FT_stat(pcPath, &psAnswer->bIsFile,
+                               &psAnswer->ulSize);
+   psAnswer->pvContents = FT_getFileContents(pcPath);
+}
+
+/* Checks that the FT, frozen, gives every recorded answer. */
+static void FrozenClient_check(void) {
+   struct answer *psAnswer;
+   boolean bIsFile, bFound;
+   size_t ulSize, i;
+   void *pvContents;
+   char *pcString;
+
+   pcString = FT_toString();
+   assert(pcString != NULL);
+   assert(strcmp(pcString, pcExpected) == 0);
+   free(pcString);
+
+   for(i = 0; i < ulNumAnswers; i++) {
+      psAnswer = &asAnswers[i];
+      bIsFile = FALSE;
+      ulSize = 0;
+      assert(FT_stat(psAnswer->acPath, &bIsFile, &ulSize) ==
+             psAnswer->iStatus);
+      bFound = (boolean) (psAnswer->iStatus == SUCCESS);
+      if(bFound) {
+         assert(bIsFile == psAnswer->bIsFile);
+         assert(ulSize == psAnswer->ulSize);
+      }
+      assert(FT_containsFile(psAnswer->acPath) ==
+             (bFound && psAnswer->bIsFile));
+      assert(FT_containsDir(psAnswer->acPath) ==
+             (bFound && !psAnswer->bIsFile));
+
+      /* Contents are copied into the image, so compare bytes */
+      pvContents = FT_getFileContents(psAnswer->acPath);
+      assert((pvContents == NULL) == (psAnswer->pvContents == NULL));
+      if(pvContents != NULL)
+         assert(memcmp(pvContents, psAnswer->pvContents,
+                       psAnswer->ulSize) == 0);
+   }
+}
+
+/* Writes the ulSize bytes at pcImage to the file named pcFile. */
+static void FrozenClient_writeFile(const char *pcFile,
+                                   const char *pcImage, size_t ulSize) {
+   FILE *psFile;
+
+   psFile = fopen(pcFile, "wb");
+   assert(psFile != NULL);
+   assert(fwrite(pcImage, 1, ulSize, psFile) == ulSize);
+   assert(fclose(psFile) == 0);
+}
+
+/* Returns a new copy of the file named pcFile, storing its length in
+   *pulSize. */
+static char *FrozenClient_readFile(const char *pcFile, size_t *pulSize) {
+   FILE *psFile;
+   char *pcImage;
+   long lSize;
+
+   psFile = fopen(pcFile, "rb");
+   assert(psFile != NULL);
+   assert(fseek(psFile, 0, SEEK_END) == 0);
+   lSize = ftell(psFile);
+   assert(lSize > 0);
+   rewind(psFile);
+   pcImage = malloc((size_t) lSize);
+   assert(pcImage != NULL);
+   assert(fread(pcImage, 1, (size_t) lSize, psFile) == (size_t) lSize);
+   assert(fclose(psFile) == 0);
+   *pulSize = (size_t) lSize;
+   return pcImage;
+}
+
+/* Checks that the ulSize bytes at pcImage, written to pcFile, are
+   refused by FT_mapFrozen as not a frozen FT. */
+static void FrozenClient_refuse(const char *pcFile, const char *pcImage,
+                                size_t ulSize) {
+   FrozenClient_writeFile(pcFile, pcImage, ulSize);
+   assert(FT_mapFrozen(pcFile) == INITIALIZATION_ERROR);
+   assert(FT_destroy() == INITIALIZATION_ERROR);
+}
+
+/* Maps the ulSize bytes at pcImage, written to pcFile, with random
+   bytes overwritten, and checks that every call answers with a status
+   its interface allows. */
+static void FrozenClient_damage(const char *pcFile, const char *pcImage,
+                                size_t ulSize) {
+   char *pcDamaged;
+   boolean bIsFile;
+   size_t ulLength, i;
+   void *pvContents;
+   int iStatus;
+
+   pcDamaged = malloc(ulSize);
+   assert(pcDamaged != NULL);
+   memcpy(pcDamaged, pcImage, ulSize);
+   for(i = 0; i < DAMAGED_BYTES; i++)
+      pcDamaged[(size_t) rand() % ulSize] = (char) rand();
+   FrozenClient_writeFile(pcFile, pcDamaged, ulSize);
+   free(pcDamaged);
+
+   if(FT_mapFrozen(pcFile) != SUCCESS)
+      return;
+   free(FT_toString());
+   for(i = 0; i < ulNumAnswers; i++) {
+      iStatus = FT_stat(asAnswers[i].acPath, &bIsFile, &ulLength);
+      assert(iStatus == SUCCESS || iStatus == BAD_PATH ||
+             iStatus == CONFLICTING_PATH || iStatus == NO_SUCH_PATH ||
+             iStatus == INITIALIZATION_ERROR);
+      (void) FT_containsDir(asAnswers[i].acPath);
+      (void) FT_containsFile(asAnswers[i].acPath);
+      pvContents = FT_getFileContents(asAnswers[i].acPath);
+      (void) pvContents;
+   }
+   assert(FT_destroy() == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   const char *pcFile = "frozen_client.img";
+   char *pcBadFile, *pcImage, *pcString;
+   char acPath[MAX_PATH];
+   char *apcContents[NUM_INSERTS];
+   unsigned long ulSeed = 1;
+   size_t ulSize, i;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-f imagefile] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-f") == 0)
+         pcFile = argv[iArg + 1];
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+   pcBadFile = malloc(strlen(pcFile) + sizeof(".bad"));
+   assert(pcBadFile != NULL);
+   strcpy(pcBadFile, pcFile);
+   strcat(pcBadFile, ".bad");
+
+   /* Files and directories at random; some collide and fail. Files
+      may have NULL or empty contents. */
+   assert(FT_init() == SUCCESS);
+   for(i = 0; i < NUM_INSERTS; i++) {
+      apcContents[i] = malloc(16);
+      assert(apcContents[i] != NULL);
+      sprintf(apcContents[i], "contents %lu", (unsigned long) i);
+      FrozenClient_randomPath(acPath);
+      if(rand() % 2 == 0)
+         (void) FT_insertDir(acPath);
+      else if(rand() % 5 == 0)
+         (void) FT_insertFile(acPath, NULL, 0);
+      else
+         (void) FT_insertFile(acPath, apcContents[i],
+                              rand() % 5 == 0 ?
+                              0 : strlen(apcContents[i]) + 1);
+   }
+
+   while(ulNumAnswers < NUM_PATHS - 6) {
+      FrozenClient_randomPath(acPath);
+      FrozenClient_record(acPath);
+   }
+   FrozenClient_record("r");
+   FrozenClient_record("x/a");
+   FrozenClient_record("/r");
+   FrozenClient_record("r/");
+   FrozenClient_record("r//a");
+   FrozenClient_record("");
+   pcExpected = FT_toString();
+   assert(pcExpected != NULL);
+
+   /* Only a frozen FT can be written; a live one cannot map */
+   assert(FT_writeFrozen(pcFile) == INITIALIZATION_ERROR);
+   assert(FT_mapFrozen(pcFile) == INITIALIZATION_ERROR);
+
+   /* Frozen in memory: read-only, with the same answers */
+   assert(FT_freeze() == SUCCESS);
+   assert(FT_freeze() == INITIALIZATION_ERROR);
+   assert(FT_init() == INITIALIZATION_ERROR);
+   assert(FT_insertDir("r/z") == INITIALIZATION_ERROR);
+   assert(FT_rmDir("r") == INITIALIZATION_ERROR);
+   assert(FT_rmFile("r/a") == INITIALIZATION_ERROR);
+   assert(FT_replaceFileContents("r/a", NULL, 0) == NULL);
+   FrozenClient_check();
+   assert(FT_writeFrozen(pcFile) == SUCCESS);
+   assert(FT_destroy() == SUCCESS);
+
+   /* Mapped from the file */
+   assert(FT_mapFrozen(pcFile) == SUCCESS);
+   assert(FT_mapFrozen(pcFile) == INITIALIZATION_ERROR);
+   FrozenClient_check();
+   assert(FT_destroy() == SUCCESS);
+   assert(FT_destroy() == INITIALIZATION_ERROR);
+
+   /* Damaged images: short, truncated and mislabelled are refused;
+      others must at least not crash */
+   assert(FT_mapFrozen(pcBadFile) == NO_SUCH_PATH ||
+          remove(pcBadFile) == 0);
+   pcImage = FrozenClient_readFile(pcFile, &ulSize);
+   FrozenClient_refuse(pcBadFile, pcImage, 8);
+   FrozenClient_refuse(pcBadFile, pcImage, ulSize / 2);
+   pcImage[0] = (char) ~pcImage[0];
+   FrozenClient_refuse(pcBadFile, pcImage, ulSize);
+   pcImage[0] = (char) ~pcImage[0];
+   for(i = 0; i < NUM_DAMAGED; i++)
+      FrozenClient_damage(pcBadFile, pcImage, ulSize);
+   free(pcImage);
+   (void) remove(pcBadFile);
+   assert(FT_mapFrozen(pcBadFile) == NO_SUCH_PATH);
+
+   /* An empty tree freezes, writes and maps too */
+   assert(FT_init() == SUCCESS);
+   assert(FT_freeze() == SUCCESS);
+   assert(FT_writeFrozen(pcFile) == SUCCESS);
+   assert(FT_destroy() == SUCCESS);
+   assert(FT_mapFrozen(pcFile) == SUCCESS);
+   pcString = FT_toString();
+   assert(pcString != NULL && strcmp(pcString, "") == 0);
+   free(pcString);
+   assert(!FT_containsDir("r"));
+   assert(FT_stat("r", &asAnswers[0].bIsFile, &ulSize) == NO_SUCH_PATH);
+   assert(FT_stat("r//a", &asAnswers[0].bIsFile, &ulSize) == BAD_PATH);
+   assert(FT_destroy() == SUCCESS);
+   (void) remove(pcFile);
+
+   for(i = 0; i < NUM_INSERTS; i++)
+      free(apcContents[i]);
+   free(pcExpected);
+   free(pcBadFile);
+   printf("%lu paths matched, frozen, written and mapped\n",
+          (unsigned long) ulNumAnswers);
+   return EXIT_SUCCESS;
+}
@@ -8,18 +8,39 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include "dynarray.h"
 #include "path.h"
 #include "noded.h"
 #include "nodef.h"
+#include "contentstore.h"
+#include "orderiter.h"
+#include "sizeindex.h"
+#include "attrs.h"
+#include "attrindex.h"
+#include "ftshm.h"
+#include "ftfrozen.h"
+#include "ftarchive.h"
+#include "grep.h"
+#include "textindex.h"
+#include "filecache.h"
+#include "timerwheel.h"
+#include "heat.h"
+#include "crc32c.h"
+#include "alloc.h"
+#include "poolalloc.h"
+#include "numa.h"
+#include "ftreplica.h"
+#include "bulkload.h"
+#include "handletable.h"
 #include "ft.h"
 
 /*
   A File Tree is a representation of a hierarchy of directories and
   files: the File Tree is rooted at a directory, directories
   may be internal nodes or leaves, and files are always leaves. It is 
-  represented as an AO with 3 state variables:
+  represented as an AO with 15 state variables:
 */
 
 /* Variables to keep track of FT characteristics: */
@@ -29,6 +50,67 @@ static boolean bIsInitialized;
 static NodeD_T oNRoot;
 /* 3. Counter of number of directories (not including files) in FT */
 static size_t ulDirCount;
+/* 4. Optional secondary index of files by size (NULL if disabled) */
+static SizeIndex_T oSIndex;
+/* 5. Reverse index of indexed attribute keys (NULL if none) */
+static AttrIndex_T oAIndex;
+/* 6. Optional inverted index of file contents (NULL if disabled) */
+static TextIndex_T oTIndex;
+/* 7. Recency list of files in cache mode (NULL if not a cache) */
+static FileCache_T oFCache;
+/* 8. What cache mode does with the files it evicts */
+static struct {
+    /* Called on each evicted file (or NULL) with pvExtra */
+    FTEvictFn pfEvict;
+    void *pvExtra;
+    /* Whether directories left empty are removed too */
+    boolean bPruneDirs;
+} sEvictPolicy;
+/* 9. Files with expiry deadlines (NULL until expiry is enabled) */
+static TimerWheel_T oTWheel;
+/* 10. Whether files carry checksums of their contents */
+static boolean bChecksums;
+/* 11. Pathname of the file FT_scrub last verified (NULL to restart) */
+static char *pcScrubCursor;
+/* 12. Read-only image the FT was frozen into (NULL if not frozen);
+   while it is set bIsInitialized is FALSE, so that only the lookups
+   that check it first answer */
+static FTFrozen_T oFFrozen;
+/* 13. Allocator the nodes and their paths come from (NULL for malloc);
+   only calls that change the tree allocate from it */
+static Alloc_T oAAlloc;
+/* 14. Per-NUMA-node replicas of the top levels (none if ulLevels is 0) */
+static struct {
+    /* Depth of the deepest directories replicated */
+    size_t ulLevels;
+    /* One replica per node, indexed by node */
+    FTReplica_T *poReplicas;
+    size_t ulCount;
+    /* Whether a directory they cover changed since they were built; 
+    lookups ignore them until they are rebuilt */
+    boolean bIsStale;
+} sReplicas;
+/* 15. Files opened by FT_openFile (NULL until the first is) */
+static HandleTable_T oHTable;
+
+/* Subtrees detached and not yet grafted or freed; unlike the state 
+above, this outlives FT_destroy, as do the attribute keys they use */
+static size_t ulDetached;
+
+/* The pool FT_init allocates from (NULL until needed); since detached
+subtrees may hold blocks from it, it too outlives FT_destroy while 
+there are any */
+static PoolAlloc_T oPDefault;
+
+/* The pools FT_load built nodes in (NULL until it first succeeds), 
+kept for as long as oPDefault */
+static DynArray_T oDLoadPools;
+
+/* A directory subtree detached from the FT */
+struct ftSubtree {
+    /* Its top directory, which has no parent */
+    NodeD_T oNdTop;
+};
 
 /* --------------------------------------------------------------------
 
@@ -57,7 +139,7 @@ static int FT_traversePath(Path_T oPPath, NodeD_T *poNFurthest) {
     Path_T oPPrefix = NULL;
     NodeD_T oNCurr;
     NodeD_T oNChild;
-    size_t ulDepth, ulChildID;
+    size_t ulDepth, ulChildID, ulReached;
     size_t i;
 
     assert(oPPath != NULL);
@@ -69,29 +151,47 @@ static int FT_traversePath(Path_T oPPath, NodeD_T *poNFurthest) {
         return SUCCESS;
     }
 
-    /* checking depth of oPPath is valid */
-    iStatus = Path_prefix(oPPath, 1, &oPPrefix);
-    if(iStatus != SUCCESS) {
-        *poNFurthest = NULL;
-        return iStatus;
+    oNCurr = NULL;
+    ulDepth = Path_getDepth(oPPath);
+    i = 2;
+    /* Skip the levels the replica on this thread's node covers; if it
+    has the root, the root's path is a prefix of oPPath */
+    if(sReplicas.ulLevels != 0 && !sReplicas.bIsStale) {
+        oNCurr = FTReplica_deepest(
+                    sReplicas.poReplicas[(size_t) Numa_currentNode() %
+                                         sReplicas.ulCount],
+                    Path_getPathname(oPPath), ulDepth, &ulReached);
+        /* Below its levels the walk goes on; within them, the replica 
+        has already found where it stops */
+        if(oNCurr != NULL)
+            i = ulReached < sReplicas.ulLevels ? ulDepth + 1 :
+                ulReached + 1;
     }
 
-    /* If the root in the given path is not the same as the actual root 
-    of the FT */
-    if(Path_comparePath(NodeD_getPath(oNRoot), oPPrefix)) {
+    if(oNCurr == NULL) {
+        /* checking depth of oPPath is valid */
+        iStatus = Path_prefix(oPPath, 1, &oPPrefix);
+        if(iStatus != SUCCESS) {
+            *poNFurthest = NULL;
+            return iStatus;
+        }
+
+        /* If the root in the given path is not the same as the actual 
+        root of the FT */
+        if(Path_comparePath(NodeD_getPath(oNRoot), oPPrefix)) {
+            Path_free(oPPrefix);
+            *poNFurthest = NULL;
+            return CONFLICTING_PATH;
+        }
         Path_free(oPPrefix);
-        *poNFurthest = NULL;
-        return CONFLICTING_PATH;
+        oPPrefix = NULL;
+        oNCurr = oNRoot;
     }
-    Path_free(oPPrefix);
-    oPPrefix = NULL;
 
-    oNCurr = oNRoot;
-    ulDepth = Path_getDepth(oPPath);
     /* Increment over depths until at closest ancestor DIRECTORY of 
     last node in the path. If the last node is a directory, it will 
     stop there. */
-    for (i = 2; i <= ulDepth; i++) {
+    for (; i <= ulDepth; i++) {
         iStatus = Path_prefix(oPPath, i, &oPPrefix);
         if(iStatus != SUCCESS) {
             *poNFurthest = NULL;
@@ -279,6 +379,360 @@ static int FT_findDir(const char *pcPath, NodeD_T *poNResult) {
     return SUCCESS;
 }
 
+/* --------------------------------------------------------------------
+
+  The FT_markTop, FT_syncReplicas and FT_freeReplicas functions keep 
+  the replicas of the top levels in step with the directories: a 
+  change to a directory they cover marks them stale, and the mutator 
+  that made it rebuilds them before returning.
+*/
+
+/* Marks the replicas stale if a directory of depth ulDepth is about 
+to be, or has just been, added or removed. */
+static void FT_markTop(size_t ulDepth) {
+    if(sReplicas.ulLevels != 0 && ulDepth <= sReplicas.ulLevels)
+        sReplicas.bIsStale = TRUE;
+}
+
+/* Rebuilds stale replicas, each on its own node. If memory runs out 
+they stay stale, and lookups go without them until the next change. */
+static void FT_syncReplicas(void) {
+    size_t n;
+
+    if(!sReplicas.bIsStale)
+        return;
+    for(n = 0; n < sReplicas.ulCount; n++) {
+        if(sReplicas.poReplicas[n] != NULL)
+            FTReplica_free(sReplicas.poReplicas[n]);
+        if(FTReplica_build(oNRoot, sReplicas.ulLevels, (int) n,
+                           &sReplicas.poReplicas[n]) != SUCCESS)
+            return;
+    }
+    sReplicas.bIsStale = FALSE;
+}
+
+/* Frees the replicas, if any, and turns them off. */
+static void FT_freeReplicas(void) {
+    size_t n;
+
+    for(n = 0; n < sReplicas.ulCount; n++)
+        if(sReplicas.poReplicas[n] != NULL)
+            FTReplica_free(sReplicas.poReplicas[n]);
+    free(sReplicas.poReplicas);
+    sReplicas.poReplicas = NULL;
+    sReplicas.ulCount = 0;
+    sReplicas.ulLevels = 0;
+    sReplicas.bIsStale = FALSE;
+}
+
+/* --------------------------------------------------------------------
+
+  The FT_indexFile, FT_unindexFile, FT_reindexFile and 
+  FT_unindexSubtree functions keep the optional secondary indexes in 
+  step with the file nodes of the FT.
+*/
+
+/* Returns the CRC-32C of oNfNode's current contents. */
+static unsigned long FT_checksumFile(NodeF_T oNfNode) {
+    const void *pvContents;
+
+    assert(oNfNode != NULL);
+
+    pvContents = NodeF_getContents(oNfNode);
+    return Crc32c_compute(0, pvContents,
+                          pvContents == NULL ? 0 :
+                          NodeF_getLength(oNfNode));
+}
+
+/*
+  Adds oNfNode to every enabled secondary index, and records its 
+  checksum if checksums are on. Returns SUCCESS, or MEMORY_ERROR 
+  (leaving oNfNode in no index) if allocation fails.
+*/
+static int FT_indexFile(NodeF_T oNfNode) {
+    int iStatus;
+    size_t ulTextId;
+
+    assert(oNfNode != NULL);
+
+    if(oSIndex != NULL) {
+        iStatus = SizeIndex_insert(oSIndex, oNfNode);
+        if(iStatus != SUCCESS)
+            return iStatus;
+    }
+    if(oTIndex != NULL) {
+        iStatus = TextIndex_add(oTIndex, NodeF_getContents(oNfNode),
+                                NodeF_getLength(oNfNode), &ulTextId);
+        if(iStatus != SUCCESS) {
+            if(oSIndex != NULL)
+                (void) SizeIndex_remove(oSIndex, oNfNode,
+                                        NodeF_getLength(oNfNode));
+            return iStatus;
+        }
+        TextIndex_bind(oTIndex, oNfNode, ulTextId);
+    }
+    if(oFCache != NULL)
+        FileCache_insert(oFCache, oNfNode);
+    if(bChecksums)
+        NodeF_setChecksum(oNfNode, FT_checksumFile(oNfNode));
+    return SUCCESS;
+}
+
+/* Removes the indexed attributes in oAAttrs of the node with path 
+oPPath from the attribute index. */
+static void FT_unindexAttrs(Attrs_T oAAttrs, Path_T oPPath) {
+    size_t i, ulKey;
+    struct AttrValue sValue;
+
+    assert(oPPath != NULL);
+
+    if(oAIndex == NULL)
+        return;
+    for(i = 0; i < Attrs_getLength(oAAttrs); i++) {
+        Attrs_getAt(oAAttrs, i, &ulKey, &sValue);
+        if(Attrs_isIndexed(ulKey))
+            AttrIndex_remove(oAIndex, ulKey, &sValue, oPPath);
+    }
+}
+
+/* Removes oNfNode from every enabled secondary index, and closes its 
+handle if it has one. */
+static void FT_unindexFile(NodeF_T oNfNode) {
+    assert(oNfNode != NULL);
+
+    if(oSIndex != NULL)
+        (void) SizeIndex_remove(oSIndex, oNfNode,
+                                NodeF_getLength(oNfNode));
+    if(oTIndex != NULL)
+        TextIndex_remove(oTIndex, oNfNode);
+    if(oFCache != NULL)
+        FileCache_remove(oFCache, oNfNode);
+    if(oTWheel != NULL)
+        TimerWheel_cancel(oTWheel, oNfNode);
+    if(oHTable != NULL)
+        HandleTable_close(oHTable, oNfNode);
+    FT_unindexAttrs(*NodeF_getAttrs(oNfNode), NodeF_getPath(oNfNode));
+}
+
+/* Moves oNfNode within the secondary indexes after its contents, 
+previously of length ulOldLength, were replaced, and records their new 
+checksum. ulTextId is the text index identifier staged for the new 
+contents (unused if the text index is disabled). */
+static void FT_reindexFile(NodeF_T oNfNode, size_t ulOldLength,
+                           size_t ulTextId) {
+    assert(oNfNode != NULL);
+
+    if(oSIndex != NULL)
+        SizeIndex_update(oSIndex, oNfNode, ulOldLength);
+    if(oTIndex != NULL)
+        TextIndex_bind(oTIndex, oNfNode, ulTextId);
+    if(oFCache != NULL)
+        FileCache_resize(oFCache, oNfNode, ulOldLength);
+    if(bChecksums)
+        NodeF_setChecksum(oNfNode, FT_checksumFile(oNfNode));
+}
+
+/*
+  Passes each directory at or below oNdNode to pfVisitDir (unless NULL) 
+  and each file below it to pfVisitFile, both with pvExtra, in the 
+  order of FT_toString. Stops at the first visit that does not return 
+  SUCCESS and returns its status; otherwise returns SUCCESS.
+*/
+static int FT_forEachNode(NodeD_T oNdNode,
+                          int (*pfVisitDir)(NodeD_T, void *),
+                          int (*pfVisitFile)(NodeF_T, void *),
+                          void *pvExtra) {
+    size_t c;
+    int iStatus;
+    NodeF_T oNfChild = NULL;
+    NodeD_T oNdChild = NULL;
+
+    assert(oNdNode != NULL);
+    assert(pfVisitFile != NULL);
+
+    if(pfVisitDir != NULL) {
+        iStatus = pfVisitDir(oNdNode, pvExtra);
+        if(iStatus != SUCCESS)
+            return iStatus;
+    }
+    for(c = 0; c < NodeD_getNumFileChildren(oNdNode); c++) {
+        (void) NodeD_getFileChild(oNdNode, c, &oNfChild);
+        iStatus = pfVisitFile(oNfChild, pvExtra);
+        if(iStatus != SUCCESS)
+            return iStatus;
+    }
+    for(c = 0; c < NodeD_getNumDirChildren(oNdNode); c++) {
+        (void) NodeD_getDirChild(oNdNode, c, &oNdChild);
+        iStatus = FT_forEachNode(oNdChild, pfVisitDir, pfVisitFile,
+                                 pvExtra);
+        if(iStatus != SUCCESS)
+            return iStatus;
+    }
+    return SUCCESS;
+}
+
+/* Passes each file below oNdNode to pfVisit with pvExtra, as 
+FT_forEachNode does. */
+static int FT_forEachFile(NodeD_T oNdNode,
+                          int (*pfVisit)(NodeF_T, void *),
+                          void *pvExtra) {
+    return FT_forEachNode(oNdNode, NULL, pfVisit, pvExtra);
+}
+
+/* Takes directory oNdNode's attributes out of the attribute index. */
+static int FT_unindexDirVisit(NodeD_T oNdNode, void *pvExtra) {
+    (void) pvExtra;
+    FT_unindexAttrs(*NodeD_getAttrs(oNdNode), NodeD_getPath(oNdNode));
+    return SUCCESS;
+}
+
+/* Takes oNfNode out of the secondary indexes. */
+static int FT_unindexFileVisit(NodeF_T oNfNode, void *pvExtra) {
+    (void) pvExtra;
+    FT_unindexFile(oNfNode);
+    return SUCCESS;
+}
+
+/* Removes oNdNode and every node below it from the secondary indexes, 
+and closes their handles, ahead of the subtree being freed or detached. 
+Does nothing if no index is enabled and no file was ever opened. */
+static void FT_unindexSubtree(NodeD_T oNdNode) {
+    assert(oNdNode != NULL);
+
+    if(oSIndex == NULL && oAIndex == NULL && oTIndex == NULL &&
+       oFCache == NULL && oTWheel == NULL && oHTable == NULL)
+        return;
+
+    (void) FT_forEachNode(oNdNode, FT_unindexDirVisit,
+                          FT_unindexFileVisit, NULL);
+}
+
+/*
+  Removes oNfNode from the FT on its own initiative, as cache mode and 
+  expiry do: passes it to pfNotify (if not NULL) with pvExtra, frees it 
+  and, if bPruneDirs, removes the directories below the root that this 
+  leaves empty. Returns SUCCESS, or MEMORY_ERROR (leaving oNfNode in 
+  place) if its parent could not be found for lack of memory.
+*/
+static int FT_dropFile(NodeF_T oNfNode, FTEvictFn pfNotify,
+                       void *pvExtra, boolean bPruneDirs) {
+    int iStatus;
+    size_t ulIndex;
+    NodeD_T oNdParent = NULL;
+    NodeD_T oNdEmpty;
+
+    assert(oNfNode != NULL);
+
+    iStatus = FT_traversePath(NodeF_getPath(oNfNode), &oNdParent);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    (void) NodeD_hasFileChild(oNdParent, NodeF_getPath(oNfNode),
+                              &ulIndex);
+    (void) NodeD_removeFileChild(oNdParent, ulIndex);
+    FT_unindexFile(oNfNode);
+    if(pfNotify != NULL)
+        pfNotify(Path_getPathname(NodeF_getPath(oNfNode)),
+                 NodeF_getContents(oNfNode), NodeF_getLength(oNfNode),
+                 pvExtra);
+    NodeF_free(oNfNode);
+
+    while(bPruneDirs && oNdParent != oNRoot &&
+          NodeD_getNumFileChildren(oNdParent) == 0 &&
+          NodeD_getNumDirChildren(oNdParent) == 0) {
+        oNdEmpty = oNdParent;
+        oNdParent = NodeD_getParent(oNdEmpty);
+        FT_unindexSubtree(oNdEmpty);
+        FT_markTop(Path_getDepth(NodeD_getPath(oNdEmpty)));
+        ulDirCount -= NodeD_free(oNdEmpty);
+    }
+    return SUCCESS;
+}
+
+/* Evicts least recently used files until the FT is within its cache 
+capacity, or memory runs out. Does nothing if not in cache mode. */
+static void FT_evict(void) {
+    NodeF_T oNfVictim;
+
+    if(oFCache == NULL)
+        return;
+    while((oNfVictim = FileCache_getVictim(oFCache)) != NULL)
+        if(FT_dropFile(oNfVictim, sEvictPolicy.pfEvict,
+                       sEvictPolicy.pvExtra,
+                       sEvictPolicy.bPruneDirs) != SUCCESS)
+            return;
+}
+
+/* --------------------------------------------------------------------
+
+  The FT_readFile, FT_replaceFile and FT_removeFile functions act on a 
+  file node already found, whether by its path or by a handle.
+*/
+
+/* Returns the contents of oNfNode, recording the access. */
+static void *FT_readFile(NodeF_T oNfNode) {
+    assert(oNfNode != NULL);
+
+    if(oFCache != NULL)
+        FileCache_touch(oFCache, oNfNode);
+    Heat_bump(NodeF_getHeat(oNfNode));
+    return NodeF_getContents(oNfNode);
+}
+
+/*
+  Replaces the contents of oNfNode with the ulNewLength bytes at 
+  pvNewContents, stores the old contents in *ppvOldContents and, in 
+  cache mode, evicts files until the FT is within its capacity again. 
+  Returns SUCCESS, or MEMORY_ERROR (leaving oNfNode unchanged) if 
+  allocation fails.
+*/
+static int FT_replaceFile(NodeF_T oNfNode, void *pvNewContents,
+                          size_t ulNewLength, void **ppvOldContents) {
+    int iStatus;
+    size_t ulOldLength;
+    size_t ulTextId = 0;
+
+    assert(oNfNode != NULL);
+    assert(ppvOldContents != NULL);
+
+    /* Tokenize the new contents first, so that nothing has changed if 
+    the text index runs out of memory */
+    if(oTIndex != NULL) {
+        iStatus = TextIndex_add(oTIndex, pvNewContents, ulNewLength,
+                                &ulTextId);
+        if(iStatus != SUCCESS)
+            return iStatus;
+    }
+
+    ulOldLength = NodeF_getLength(oNfNode);
+    iStatus = NodeF_replaceContents(oNfNode, pvNewContents, ulNewLength,
+                                    ppvOldContents);
+    if(iStatus != SUCCESS) {
+        if(oTIndex != NULL)
+            TextIndex_discard(oTIndex, ulTextId);
+        return iStatus;
+    }
+    FT_reindexFile(oNfNode, ulOldLength, ulTextId);
+    Heat_bump(NodeF_getHeat(oNfNode));
+    FT_evict();
+    FT_syncReplicas();
+    return SUCCESS;
+}
+
+/* Unlinks oNfNode from its parent directory oNdParent and frees it. */
+static void FT_removeFile(NodeF_T oNfNode, NodeD_T oNdParent) {
+    size_t ulIndex;
+
+    assert(oNfNode != NULL);
+    assert(oNdParent != NULL);
+
+    (void) NodeD_hasFileChild(oNdParent, NodeF_getPath(oNfNode),
+                              &ulIndex);
+    (void) NodeD_removeFileChild(oNdParent, ulIndex);
+    FT_unindexFile(oNfNode);
+    NodeF_free(oNfNode);
+    Heat_bump(NodeD_getHeat(oNdParent));
+}
+
 /* ================================================================== */
 int FT_insertDir(const char *pcPath) {
     int iStatus;
@@ -294,7 +748,7 @@ int FT_insertDir(const char *pcPath) {
         return INITIALIZATION_ERROR;
     
     /* validate pcPath and generate a Path_T for it */
-    iStatus = Path_new(pcPath, &oPPath);
+    iStatus = Path_newWith(pcPath, oAAlloc, &oPPath);
     if(iStatus != SUCCESS)
         return iStatus;
     
@@ -356,6 +810,7 @@ int FT_insertDir(const char *pcPath) {
                 (void) NodeD_free(oNFirstNew);
             return iStatus;
         }
+        FT_markTop(ulIndex);
         /* set up for next level */
         Path_free(oPPrefix);
         oNCurr = oNNewNode;
@@ -370,7 +825,9 @@ int FT_insertDir(const char *pcPath) {
     if(oNRoot == NULL)
         oNRoot = oNFirstNew;
     ulDirCount += ulNewNodes;
+    FT_syncReplicas();
 
+    Heat_bump(NodeD_getHeat(oNCurr));
     return SUCCESS;
 }   
 
@@ -381,10 +838,20 @@ boolean FT_containsDir(const char *pcPath) {
 
     assert(pcPath != NULL);
 
+    if(oFFrozen != NULL) {
+        boolean bIsFile;
+        size_t ulSize;
+        return (boolean) (FTFrozen_stat(oFFrozen, pcPath, &bIsFile,
+                                        &ulSize) == SUCCESS && !bIsFile);
+    }
+
     /* iStatus becomes SUCCESS if the directory is found, therefore is 
     contained in the FT */
     iStatus = FT_findDir(pcPath, &oNFound);
-    return (boolean) (iStatus == SUCCESS);
+    if(iStatus != SUCCESS)
+        return FALSE;
+    Heat_bump(NodeD_getHeat(oNFound));
+    return TRUE;
 }
 
 /* ================================================================== */
@@ -405,10 +872,17 @@ int FT_rmDir(const char *pcPath) {
     if(iStatus != SUCCESS)
         return iStatus;
 
+    /* Removing a directory counts as an access to its parent */
+    if(NodeD_getParent(oNdFound) != NULL)
+        Heat_bump(NodeD_getHeat(NodeD_getParent(oNdFound)));
+
     /* Free the directory (including its children) */
+    FT_unindexSubtree(oNdFound);
+    FT_markTop(Path_getDepth(NodeD_getPath(oNdFound)));
     ulDirCount -= NodeD_free(oNdFound);
     if(ulDirCount == 0)
         oNRoot = NULL;
+    FT_syncReplicas();
 
     return SUCCESS;
 }
@@ -421,6 +895,7 @@ ulLength) {
     NodeD_T oNFirstNew = NULL; /* first new node added */
     NodeD_T oNParent = NULL;
     NodeF_T oNNewFile = NULL; /* file to be added */
+    void *pvOldContents; /* unused, a new file has no old contents */
     size_t ulDepth, ulIndex, ulChildID; 
     size_t ulNewNodes = 0; /* number of new directories */
 
@@ -430,7 +905,7 @@ ulLength) {
         return INITIALIZATION_ERROR;
     
     /* validate pcPath and generate a Path_T for it */
-    iStatus = Path_new(pcPath, &oPPath);
+    iStatus = Path_newWith(pcPath, oAAlloc, &oPPath);
     if(iStatus != SUCCESS)
         return iStatus;
     
@@ -499,6 +974,7 @@ ulLength) {
                 (void) NodeD_free(oNFirstNew);
             return iStatus;
         }
+        FT_markTop(ulIndex);
         /* set up for next level */
         Path_free(oPPrefix);
         oNParent = oNNewNode;
@@ -516,26 +992,47 @@ ulLength) {
             (void) NodeD_free(oNFirstNew);
         return iStatus;
     }
+
+    /* Set the contents of the new node (copied into the content store 
+    if one is in use) before it becomes visible in the tree */
+    iStatus = NodeF_replaceContents(oNNewFile, pvContents, ulLength,
+                                    &pvOldContents);
+    if(iStatus != SUCCESS) {
+        Path_free(oPPath);
+        NodeF_free(oNNewFile);
+        if(oNFirstNew != NULL)
+            (void) NodeD_free(oNFirstNew);
+        return iStatus;
+    }
+
+    /* Enter the new node into the secondary indexes */
+    iStatus = FT_indexFile(oNNewFile);
+    if(iStatus != SUCCESS) {
+        Path_free(oPPath);
+        NodeF_free(oNNewFile);
+        if(oNFirstNew != NULL)
+            (void) NodeD_free(oNFirstNew);
+        return iStatus;
+    }
     
     /* Check if the file is already in the tree as a child of the 
     parent directory, if not add it as a child of the parent directory. 
     ulChildID is generated from NodeD_hasFileChild() */
     if (NodeD_hasFileChild(oNParent, oPPath, &ulChildID)) {
         Path_free(oPPath);
-        free(oNNewFile);
+        FT_unindexFile(oNNewFile);
+        NodeF_free(oNNewFile);
         return ALREADY_IN_TREE;
     }
     iStatus = NodeD_addFileChild(oNParent, oNNewFile, ulChildID);
     if (iStatus != SUCCESS) {
         Path_free(oPPath);
+        FT_unindexFile(oNNewFile);
+        NodeF_free(oNNewFile);
         if(oNFirstNew != NULL)
             (void) NodeD_free(oNFirstNew);
         return iStatus; 
     }
-    
-    /* Set the fields of the new node */
-    (void)NodeF_replaceContents(oNNewFile,pvContents);
-    (void)(NodeF_replaceLength(oNNewFile,ulLength));
 
     Path_free(oPPath);
     /* update DT state variables to reflect insertion */
@@ -545,6 +1042,11 @@ ulLength) {
     counted) */
     ulDirCount += ulNewNodes;
 
+    Heat_bump(NodeF_getHeat(oNNewFile));
+    /* Make room in cache mode; the new file is the most recently used, 
+    so it stays */
+    FT_evict();
+    FT_syncReplicas();
     return SUCCESS;
 }
 
@@ -555,15 +1057,24 @@ boolean FT_containsFile(const char *pcPath) {
 
     assert(pcPath != NULL);
 
+    if(oFFrozen != NULL) {
+        boolean bIsFile;
+        size_t ulSize;
+        return (boolean) (FTFrozen_stat(oFFrozen, pcPath, &bIsFile,
+                                        &ulSize) == SUCCESS && bIsFile);
+    }
+
     /* iStatus == SUCCESS if file can be found */
     iStatus = FT_findFile(pcPath, &oNFound);
-    return (boolean) (iStatus == SUCCESS);
+    if(iStatus != SUCCESS)
+        return FALSE;
+    Heat_bump(NodeF_getHeat(oNFound));
+    return TRUE;
 }
 
 /* ================================================================== */
 int FT_rmFile(const char *pcPath) {
     int iStatus;
-    size_t ulIndex;
     NodeF_T oNFound = NULL;
     NodeD_T oNdParent = NULL;
 
@@ -585,13 +1096,9 @@ int FT_rmFile(const char *pcPath) {
     if (iStatus != SUCCESS) {
         return iStatus;
     }
-    /* Sets right ulIndex */
-    (void)NodeD_hasFileChild(oNdParent, NodeF_getPath(oNFound),
-    &ulIndex);
 
     /* Remove and free the file node */
-    NodeF_free(oNFound);
-    (void)DynArray_removeAt(NodeD_getFileChildren(oNdParent), ulIndex);
+    FT_removeFile(oNFound, oNdParent);
 
     return SUCCESS;
 }
@@ -603,12 +1110,18 @@ void *FT_getFileContents(const char *pcPath) {
 
     assert(pcPath != NULL);
 
+    if(oFFrozen != NULL) {
+        void *pvContents;
+        iStatus = FTFrozen_getFileContents(oFFrozen, pcPath, &pvContents);
+        return (iStatus == SUCCESS) ? pvContents : NULL;
+    }
+
     /* Find the file and set to oNFound so contents can be accessed */
     iStatus = FT_findFile(pcPath, &oNFound);
     if(iStatus != SUCCESS)
         return NULL;
 
-    return NodeF_getContents(oNFound);
+    return FT_readFile(oNFound);
 }
 
 /* ================================================================== */
@@ -616,6 +1129,7 @@ void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
 size_t ulNewLength) {
     int iStatus;
     NodeF_T oNFound = NULL;
+    void *pvOldContents;
 
     assert(pcPath != NULL);
 
@@ -623,9 +1137,12 @@ size_t ulNewLength) {
     iStatus = FT_findFile(pcPath, &oNFound);
     if(iStatus != SUCCESS)
         return NULL;
-    
-    (void)NodeF_replaceLength(oNFound,ulNewLength);
-    return NodeF_replaceContents(oNFound,pvNewContents);
+
+    iStatus = FT_replaceFile(oNFound, pvNewContents, ulNewLength,
+                             &pvOldContents);
+    if(iStatus != SUCCESS)
+        return NULL;
+    return pvOldContents;
 }
 
 /* ================================================================== */
@@ -637,17 +1154,22 @@ int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
 
     assert(pcPath != NULL);
 
+    if(oFFrozen != NULL)
+        return FTFrozen_stat(oFFrozen, pcPath, pbIsFile, pulSize);
+
     /* Check if path can be found as a file AND as a directory */
     iStatusDir = FT_findDir(pcPath, &oNdFound);
     iStatusFile = FT_findFile(pcPath, &oNfFound);
 
     /* Case 1: path found as a directory */
     if (iStatusDir == SUCCESS) {
+        Heat_bump(NodeD_getHeat(oNdFound));
         *pbIsFile = (int) FALSE;
         return iStatusDir;
     }
     /* Case 2: path found as a file */
     else if (iStatusFile == SUCCESS) {
+        Heat_bump(NodeF_getHeat(oNfFound));
         *pbIsFile = (int) TRUE;
         *pulSize = NodeF_getLength(oNfFound);
         return iStatusFile;
@@ -658,80 +1180,2380 @@ int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
     }
 }
 
+/* --------------------------------------------------------------------
+
+  FT_openFile gives out handles to files, and the calls that take one 
+  reach the file through the handle table without walking its path.
+*/
+
+/* Returns the file node *psHandle refers to, storing its parent in 
+*poNdParent, or NULL if the file has left the FT since the handle was 
+given out. */
+static NodeF_T FT_findHandle(const struct FTHandle *psHandle,
+                             NodeD_T *poNdParent) {
+    assert(psHandle != NULL);
+
+    if(oHTable == NULL)
+        return NULL;
+    return HandleTable_lookup(oHTable, psHandle, poNdParent);
+}
+
 /* ================================================================== */
-int FT_init(void) {
-    /* cannot init an already intialized FT */
-    if(bIsInitialized)
+int FT_openFile(const char *pcPath, struct FTHandle *psHandle) {
+    int iStatus;
+    NodeF_T oNfFound = NULL;
+    NodeD_T oNdParent = NULL;
+
+    assert(pcPath != NULL);
+    assert(psHandle != NULL);
+
+    if(!bIsInitialized)
         return INITIALIZATION_ERROR;
 
-    /* Initialize fields */
-    bIsInitialized = TRUE;
-    oNRoot = NULL;
-    ulDirCount = 0;
+    /* pcPath is Path of a dir not a file */
+    if(FT_findDir(pcPath, &oNdParent) == SUCCESS)
+        return NOT_A_FILE;
+
+    iStatus = FT_findFile(pcPath, &oNfFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    iStatus = FT_traversePath(NodeF_getPath(oNfFound), &oNdParent);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    if(oHTable == NULL) {
+        oHTable = HandleTable_new();
+        if(oHTable == NULL)
+            return MEMORY_ERROR;
+    }
+    return HandleTable_open(oHTable, oNfFound, oNdParent, psHandle);
+}
+
+/* ================================================================== */
+int FT_getHandleContents(const struct FTHandle *psHandle,
+                         void **ppvContents) {
+    NodeF_T oNfFound;
+
+    assert(psHandle != NULL);
+    assert(ppvContents != NULL);
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
 
+    oNfFound = FT_findHandle(psHandle, NULL);
+    if(oNfFound == NULL)
+        return NO_SUCH_PATH;
+    *ppvContents = FT_readFile(oNfFound);
     return SUCCESS;
 }
 
 /* ================================================================== */
-int FT_destroy(void) {
-    /* cannot destroy if it doesn't exist */
+int FT_replaceHandleContents(const struct FTHandle *psHandle,
+                             void *pvNewContents, size_t ulNewLength,
+                             void **ppvOldContents) {
+    NodeF_T oNfFound;
+
+    assert(psHandle != NULL);
+    assert(ppvOldContents != NULL);
+
     if(!bIsInitialized)
         return INITIALIZATION_ERROR;
 
-    /* Free from root if it exists (will recursively free everything 
-    else)*/
-    if(oNRoot) {
-        ulDirCount -= NodeD_free(oNRoot);
-        /* uninitialize root */
-        oNRoot = NULL;
-    }
+    oNfFound = FT_findHandle(psHandle, NULL);
+    if(oNfFound == NULL)
+        return NO_SUCH_PATH;
+    return FT_replaceFile(oNfFound, pvNewContents, ulNewLength,
+                          ppvOldContents);
+}
 
-    /* uninitialize FT fields */
-    assert(ulDirCount == 0);
+/* ================================================================== */
+int FT_statHandle(const struct FTHandle *psHandle, size_t *pulSize) {
+    NodeF_T oNfFound;
 
-    bIsInitialized = FALSE;
+    assert(psHandle != NULL);
+    assert(pulSize != NULL);
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
 
+    oNfFound = FT_findHandle(psHandle, NULL);
+    if(oNfFound == NULL)
+        return NO_SUCH_PATH;
+    Heat_bump(NodeF_getHeat(oNfFound));
+    *pulSize = NodeF_getLength(oNfFound);
     return SUCCESS;
 }
 
 /* ================================================================== */
-/*
-  The following auxiliary functions are used for generating the
-  string representation of the FT.
-*/
+int FT_rmHandle(const struct FTHandle *psHandle) {
+    NodeF_T oNfFound;
+    NodeD_T oNdParent = NULL;
 
-/*
-  Performs pre-order traversal of file tree rooted at n,
-  inserting each payload to DynArray_T d beginning at index i.
-  Returns the next unused index in d after the insertion(s).
+    assert(psHandle != NULL);
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    oNfFound = FT_findHandle(psHandle, &oNdParent);
+    if(oNfFound == NULL)
+        return NO_SUCH_PATH;
+    FT_removeFile(oNfFound, oNdParent);
+    return SUCCESS;
+}
+
+/* --------------------------------------------------------------------
+
+  The FT_resolveMulti function and its helpers look up a batch of paths 
+  together: sorted component by component, consecutive paths share 
+  their leading directories, and the lookups below each directory move 
+  only forward through its children.
 */
 
-static size_t FT_preOrderTraversal(NodeD_T n, DynArray_T d, size_t i) {
-    size_t c;
+/* One path of a batch being resolved */
+struct ftLookup {
+    /* The path, or NULL if it is not well-formatted */
+    Path_T oPPath;
+    /* Its position in the caller's batch */
+    size_t ulIndex;
+};
 
-    assert(d != NULL);
+/* What one path of a batch resolved to */
+struct ftResolved {
+    /* SUCCESS, or why the path was not found */
+    int iStatus;
+    /* The directory or file found (the other NULL) */
+    NodeD_T oNdDir;
+    NodeF_T oNfFile;
+};
+
+/* Compares the struct ftLookup at pv1 and pv2 component by component, 
+the order in which a directory's children are kept, with the paths 
+that are not well-formatted first. That is strcmp order with the 
+separator '/' taken to sort before every other character. */
+static int FT_compareLookups(const void *pv1, const void *pv2) {
+    Path_T oPPath1 = ((const struct ftLookup *) pv1)->oPPath;
+    Path_T oPPath2 = ((const struct ftLookup *) pv2)->oPPath;
+    const unsigned char *puc1, *puc2;
+    unsigned int u1, u2;
+
+    if(oPPath1 == NULL || oPPath2 == NULL)
+        return (oPPath1 != NULL) - (oPPath2 != NULL);
+    puc1 = (const unsigned char *) Path_getPathname(oPPath1);
+    puc2 = (const unsigned char *) Path_getPathname(oPPath2);
+    for(; *puc1 != '\0' && *puc1 == *puc2; puc1++, puc2++)
+        ;
+    u1 = *puc1 == '/' ? 1 : *puc1;
+    u2 = *puc2 == '/' ? 1 : *puc2;
+    return (u1 > u2) - (u1 < u2);
+}
 
-    if(n != NULL) {
-        (void) DynArray_set(d, i, n);
-        i++;
-        for(c = 0; c < NodeD_getNumDirChildren(n); c++) {
-            int iStatus;
-            NodeD_T oNdChild = NULL;
-            iStatus = NodeD_getDirChild(n,c, &oNdChild);
-            assert(iStatus == SUCCESS);
-            i = FT_preOrderTraversal(oNdChild, d, i);
-        }
+/* Returns the last component of the path of directory child (if 
+bIsDir) or file child ulAt of oNdParent, which starts ulOffset 
+characters into the pathname. */
+static const char *FT_childName(NodeD_T oNdParent, boolean bIsDir,
+                                size_t ulAt, size_t ulOffset) {
+    NodeD_T oNdChild = NULL;
+    NodeF_T oNfChild = NULL;
+
+    if(bIsDir) {
+        (void) NodeD_getDirChild(oNdParent, ulAt, &oNdChild);
+        return Path_getPathname(NodeD_getPath(oNdChild)) + ulOffset;
     }
-    return i;
+    (void) NodeD_getFileChild(oNdParent, ulAt, &oNfChild);
+    return Path_getPathname(NodeF_getPath(oNfChild)) + ulOffset;
 }
 
 /*
-  Alternate version of strlen that uses pulAcc as an in-out parameter
-  to accumulate a string length, rather than returning the length of
-  oNdNode's path, and also always adds one addition byte to the sum.
-  Also accumulates the lengths of oNdNode's children Paths.
+  Advances *pulPos to the first directory child (if bIsDir) or file 
+  child of oNdParent, at or after *pulPos, whose last component is 
+  not less than pcName, searching with steps that double from *pulPos. 
+  Returns TRUE if that child is named pcName.
 */
-static void FT_strlenAccumulate(NodeD_T oNdNode, size_t *pulAcc) {
+static boolean FT_seekChild(NodeD_T oNdParent, boolean bIsDir,
+                            const char *pcName, size_t *pulPos) {
+    size_t ulLength, ulOffset, ulLo, ulHi, ulStep, ulMid;
+
+    /* Children's last components follow the parent's pathname and a 
+    separator */
+    ulOffset = Path_getStrLength(NodeD_getPath(oNdParent)) + 1;
+    ulLength = bIsDir ? NodeD_getNumDirChildren(oNdParent) :
+                        NodeD_getNumFileChildren(oNdParent);
+
+    /* Gallop to a window that holds the answer, then bisect it */
+    ulLo = *pulPos;
+    ulHi = ulLo;
+    ulStep = 1;
+    while(ulHi < ulLength &&
+          strcmp(FT_childName(oNdParent, bIsDir, ulHi, ulOffset),
+                 pcName) < 0) {
+        ulLo = ulHi + 1;
+        ulHi = ulLo + ulStep;
+        ulStep *= 2;
+    }
+    if(ulHi > ulLength)
+        ulHi = ulLength;
+    while(ulLo < ulHi) {
+        ulMid = ulLo + (ulHi - ulLo) / 2;
+        if(strcmp(FT_childName(oNdParent, bIsDir, ulMid, ulOffset),
+                  pcName) < 0)
+            ulLo = ulMid + 1;
+        else
+            ulHi = ulMid;
+    }
+
+    *pulPos = ulLo;
+    return (boolean) (ulLo < ulLength &&
+        strcmp(FT_childName(oNdParent, bIsDir, ulLo, ulOffset),
+               pcName) == 0);
+}
+
+/*
+  Looks up the ulNumPaths paths in ppcPaths, storing what each 
+  resolved to in the same position of psResults. The paths are sorted 
+  and walked as a merge-join against the tree: each reuses the 
+  directories it shares with the one before, and each directory's 
+  children are searched from where the last search below it stopped. 
+  Returns SUCCESS, or MEMORY_ERROR if the batch could not be set up.
+*/
+static int FT_resolveMulti(const char **ppcPaths, size_t ulNumPaths,
+                           struct ftResolved *psResults) {
+    struct ftLookup *psLookups;
+    NodeD_T *poNdChain = NULL;
+    size_t *pulDirPos = NULL, *pulFilePos = NULL;
+    size_t ulMaxDepth = 0, ulChain = 0, ulDepth, i;
+    Path_T oPPrev = NULL, oPPath;
+    struct ftResolved *psOut;
+    NodeD_T oNdChild = NULL;
+    NodeF_T oNfChild = NULL;
+    int iStatus;
+
+    psLookups = malloc((ulNumPaths == 0 ? 1 : ulNumPaths) *
+                       sizeof(struct ftLookup));
+    if(psLookups == NULL)
+        return MEMORY_ERROR;
+    for(i = 0; i < ulNumPaths; i++) {
+        assert(ppcPaths[i] != NULL);
+        psLookups[i].ulIndex = i;
+        iStatus = Path_new(ppcPaths[i], &psLookups[i].oPPath);
+        psResults[i].iStatus = iStatus;
+        psResults[i].oNdDir = NULL;
+        psResults[i].oNfFile = NULL;
+        if(iStatus == SUCCESS &&
+           Path_getDepth(psLookups[i].oPPath) > ulMaxDepth)
+            ulMaxDepth = Path_getDepth(psLookups[i].oPPath);
+    }
+
+    /* The directory at each depth of the current path, and where the 
+    searches among its children resume */
+    poNdChain = malloc((ulMaxDepth + 1) * sizeof(NodeD_T));
+    pulDirPos = malloc((ulMaxDepth + 1) * sizeof(size_t));
+    pulFilePos = malloc((ulMaxDepth + 1) * sizeof(size_t));
+    if(poNdChain == NULL || pulDirPos == NULL || pulFilePos == NULL) {
+        for(i = 0; i < ulNumPaths; i++)
+            if(psLookups[i].oPPath != NULL)
+                Path_free(psLookups[i].oPPath);
+        free(psLookups);
+        free(poNdChain);
+        free(pulDirPos);
+        free(pulFilePos);
+        return MEMORY_ERROR;
+    }
+    qsort(psLookups, ulNumPaths, sizeof(struct ftLookup),
+          FT_compareLookups);
+
+    for(i = 0; i < ulNumPaths; i++) {
+        oPPath = psLookups[i].oPPath;
+        psOut = &psResults[psLookups[i].ulIndex];
+        if(oPPath == NULL)
+            continue;
+        if(oNRoot == NULL) {
+            psOut->iStatus = NO_SUCH_PATH;
+            continue;
+        }
+        if(strcmp(Path_getComponent(oPPath, 0),
+                  Path_getComponent(NodeD_getPath(oNRoot), 0)) != 0) {
+            psOut->iStatus = CONFLICTING_PATH;
+            continue;
+        }
+
+        /* Keep the directories shared with the previous path */
+        if(oPPrev == NULL) {
+            poNdChain[0] = oNRoot;
+            pulDirPos[0] = 0;
+            pulFilePos[0] = 0;
+            ulChain = 1;
+        }
+        else if(Path_getSharedPrefixDepth(oPPrev, oPPath) < ulChain)
+            ulChain = Path_getSharedPrefixDepth(oPPrev, oPPath);
+        oPPrev = oPPath;
+
+        /* Descend through directories as far as the path allows */
+        ulDepth = Path_getDepth(oPPath);
+        while(ulChain < ulDepth) {
+            if(!FT_seekChild(poNdChain[ulChain - 1], TRUE,
+                             Path_getComponent(oPPath, ulChain),
+                             &pulDirPos[ulChain - 1]))
+                break;
+            (void) NodeD_getDirChild(poNdChain[ulChain - 1],
+                                     pulDirPos[ulChain - 1], &oNdChild);
+            poNdChain[ulChain] = oNdChild;
+            pulDirPos[ulChain] = 0;
+            pulFilePos[ulChain] = 0;
+            ulChain++;
+        }
+
+        if(ulChain == ulDepth) {
+            psOut->oNdDir = poNdChain[ulDepth - 1];
+            continue;
+        }
+        psOut->iStatus = NO_SUCH_PATH;
+        /* Only the last component may name a file */
+        if(ulChain == ulDepth - 1) {
+            if(FT_seekChild(poNdChain[ulChain - 1], FALSE,
+                            Path_getComponent(oPPath, ulChain),
+                            &pulFilePos[ulChain - 1])) {
+                (void) NodeD_getFileChild(poNdChain[ulChain - 1],
+                                          pulFilePos[ulChain - 1],
+                                          &oNfChild);
+                psOut->iStatus = SUCCESS;
+                psOut->oNfFile = oNfChild;
+            }
+        }
+    }
+
+    for(i = 0; i < ulNumPaths; i++)
+        if(psLookups[i].oPPath != NULL)
+            Path_free(psLookups[i].oPPath);
+    free(psLookups);
+    free(poNdChain);
+    free(pulDirPos);
+    free(pulFilePos);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_getFileContentsMulti(const char **ppcPaths, size_t ulNumPaths,
+                            void **ppvContents, size_t *pulLengths) {
+    struct ftResolved *psResults;
+    NodeF_T oNfFile;
+    size_t i;
+
+    assert(ppcPaths != NULL || ulNumPaths == 0);
+    assert(ppvContents != NULL || ulNumPaths == 0);
+
+    for(i = 0; i < ulNumPaths; i++) {
+        ppvContents[i] = NULL;
+        if(pulLengths != NULL)
+            pulLengths[i] = 0;
+    }
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    psResults = malloc((ulNumPaths == 0 ? 1 : ulNumPaths) *
+                       sizeof(struct ftResolved));
+    if(psResults == NULL)
+        return MEMORY_ERROR;
+    if(FT_resolveMulti(ppcPaths, ulNumPaths, psResults) != SUCCESS) {
+        free(psResults);
+        return MEMORY_ERROR;
+    }
+
+    /* Pin the batch's contents so that fetching one does not spill 
+    another */
+    if(CS_isInitialized())
+        CS_beginPins();
+    for(i = 0; i < ulNumPaths; i++) {
+        oNfFile = psResults[i].oNfFile;
+        if(oNfFile == NULL)
+            continue;
+        if(oFCache != NULL)
+            FileCache_touch(oFCache, oNfFile);
+        Heat_bump(NodeF_getHeat(oNfFile));
+        ppvContents[i] = NodeF_pinContents(oNfFile);
+        if(pulLengths != NULL)
+            pulLengths[i] = NodeF_getLength(oNfFile);
+    }
+    free(psResults);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_statMulti(const char **ppcPaths, size_t ulNumPaths,
+                 struct FTStat *psStats) {
+    struct ftResolved *psResults;
+    size_t i;
+
+    assert(ppcPaths != NULL || ulNumPaths == 0);
+    assert(psStats != NULL || ulNumPaths == 0);
+
+    if(!bIsInitialized) {
+        for(i = 0; i < ulNumPaths; i++)
+            psStats[i].iStatus = INITIALIZATION_ERROR;
+        return INITIALIZATION_ERROR;
+    }
+
+    psResults = malloc((ulNumPaths == 0 ? 1 : ulNumPaths) *
+                       sizeof(struct ftResolved));
+    if(psResults == NULL || FT_resolveMulti(ppcPaths, ulNumPaths,
+                                            psResults) != SUCCESS) {
+        free(psResults);
+        for(i = 0; i < ulNumPaths; i++)
+            psStats[i].iStatus = MEMORY_ERROR;
+        return MEMORY_ERROR;
+    }
+
+    for(i = 0; i < ulNumPaths; i++) {
+        psStats[i].iStatus = psResults[i].iStatus;
+        psStats[i].bIsFile = (boolean) (psResults[i].oNfFile != NULL);
+        psStats[i].ulSize = psResults[i].oNfFile != NULL ?
+                            NodeF_getLength(psResults[i].oNfFile) : 0;
+        if(psResults[i].oNfFile != NULL)
+            Heat_bump(NodeF_getHeat(psResults[i].oNfFile));
+        else if(psResults[i].oNdDir != NULL)
+            Heat_bump(NodeD_getHeat(psResults[i].oNdDir));
+    }
+    free(psResults);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_count(const char *pcPath, size_t *pulFiles, size_t *pulDirs) {
+    int iStatus;
+    NodeD_T oNdFound = NULL;
+
+    assert(pcPath != NULL);
+    assert(pulFiles != NULL);
+    assert(pulDirs != NULL);
+
+    /* Counts are kept on every directory, so only the lookup costs */
+    iStatus = FT_findDir(pcPath, &oNdFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    *pulFiles = NodeD_getSubtreeFileCount(oNdFound);
+    *pulDirs = NodeD_getSubtreeDirCount(oNdFound);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_nth(const char *pcPath, size_t ulK, const char **ppcResult,
+           boolean *pbIsFile) {
+    int iStatus;
+    NodeD_T oNdCurr = NULL;
+    NodeD_T oNdChild = NULL;
+    NodeF_T oNfChild = NULL;
+    size_t ulNumFiles, ulNumDirs, ulSize;
+    size_t c;
+
+    assert(pcPath != NULL);
+    assert(ppcResult != NULL);
+    assert(pbIsFile != NULL);
+
+    iStatus = FT_findDir(pcPath, &oNdCurr);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    if(ulK >= NodeD_getSubtreeFileCount(oNdCurr) +
+              NodeD_getSubtreeDirCount(oNdCurr))
+        return NO_SUCH_PATH;
+
+    /* Descend one level per iteration, skipping whole subtrees by 
+    their counts. In canonical order a directory lists its files, then 
+    each directory child followed by that child's own entries. */
+    for(;;) {
+        ulNumFiles = NodeD_getNumFileChildren(oNdCurr);
+        if(ulK < ulNumFiles) {
+            (void) NodeD_getFileChild(oNdCurr, ulK, &oNfChild);
+            *ppcResult = Path_getPathname(NodeF_getPath(oNfChild));
+            *pbIsFile = TRUE;
+            return SUCCESS;
+        }
+        ulK -= ulNumFiles;
+
+        ulNumDirs = NodeD_getNumDirChildren(oNdCurr);
+        for(c = 0; c < ulNumDirs; c++) {
+            (void) NodeD_getDirChild(oNdCurr, c, &oNdChild);
+            ulSize = 1 + NodeD_getSubtreeFileCount(oNdChild) +
+                     NodeD_getSubtreeDirCount(oNdChild);
+            if(ulK < ulSize)
+                break;
+            ulK -= ulSize;
+        }
+        assert(c < ulNumDirs);
+
+        if(ulK == 0) {
+            *ppcResult = Path_getPathname(NodeD_getPath(oNdChild));
+            *pbIsFile = FALSE;
+            return SUCCESS;
+        }
+        ulK--;
+        oNdCurr = oNdChild;
+    }
+}
+
+/* ================================================================== */
+/*
+  Adds oNfNode to the size index. Returns SUCCESS, or MEMORY_ERROR if 
+  allocation fails.
+*/
+static int FT_sizeIndexVisit(NodeF_T oNfNode, void *pvExtra) {
+    (void) pvExtra;
+    return SizeIndex_insert(oSIndex, oNfNode);
+}
+
+/* ================================================================== */
+int FT_enableSizeIndex(void) {
+    int iStatus;
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    if(oSIndex != NULL)
+        return SUCCESS;
+
+    oSIndex = SizeIndex_new();
+    if(oSIndex == NULL)
+        return MEMORY_ERROR;
+
+    /* Index the files already in the tree */
+    if(oNRoot != NULL) {
+        iStatus = FT_forEachFile(oNRoot, FT_sizeIndexVisit, NULL);
+        if(iStatus != SUCCESS) {
+            SizeIndex_free(oSIndex);
+            oSIndex = NULL;
+            return iStatus;
+        }
+    }
+    return SUCCESS;
+}
+
+/*
+  Replaces each file node in oDNodes with its pathname. 
+*/
+static void FT_nodesToPathnames(DynArray_T oDNodes) {
+    size_t i;
+
+    assert(oDNodes != NULL);
+
+    for(i = 0; i < DynArray_getLength(oDNodes); i++)
+        (void) DynArray_set(oDNodes, i, Path_getPathname(
+                   NodeF_getPath(DynArray_get(oDNodes, i))));
+}
+
+/* ================================================================== */
+int FT_topKBySize(size_t ulK, DynArray_T *poDResult) {
+    DynArray_T oDResult;
+
+    assert(poDResult != NULL);
+
+    if(!bIsInitialized || oSIndex == NULL) {
+        *poDResult = NULL;
+        return INITIALIZATION_ERROR;
+    }
+
+    oDResult = DynArray_new(0);
+    if(oDResult == NULL || SizeIndex_topK(oSIndex, ulK, oDResult)
+                           != SUCCESS) {
+        if(oDResult != NULL)
+            DynArray_free(oDResult);
+        *poDResult = NULL;
+        return MEMORY_ERROR;
+    }
+
+    FT_nodesToPathnames(oDResult);
+    *poDResult = oDResult;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_filesInSizeRange(size_t ulMin, size_t ulMax,
+                        DynArray_T *poDResult) {
+    DynArray_T oDResult;
+
+    assert(poDResult != NULL);
+
+    if(!bIsInitialized || oSIndex == NULL) {
+        *poDResult = NULL;
+        return INITIALIZATION_ERROR;
+    }
+
+    oDResult = DynArray_new(0);
+    if(oDResult == NULL || SizeIndex_range(oSIndex, ulMin, ulMax,
+                                           oDResult) != SUCCESS) {
+        if(oDResult != NULL)
+            DynArray_free(oDResult);
+        *poDResult = NULL;
+        return MEMORY_ERROR;
+    }
+
+    FT_nodesToPathnames(oDResult);
+    *poDResult = oDResult;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+/*
+  Finds the file or directory with absolute path pcPath and stores the 
+  address of its attribute set in *ppoAAttrs and its path in *poPPath. 
+  Returns SUCCESS if found, or the status FT_findDir reports otherwise.
+*/
+static int FT_findAttrs(const char *pcPath, Attrs_T **ppoAAttrs,
+                        Path_T *poPPath) {
+    int iStatus;
+    NodeF_T oNfFound = NULL;
+    NodeD_T oNdFound = NULL;
+
+    assert(pcPath != NULL);
+    assert(ppoAAttrs != NULL);
+    assert(poPPath != NULL);
+
+    if(FT_findFile(pcPath, &oNfFound) == SUCCESS) {
+        *ppoAAttrs = NodeF_getAttrs(oNfFound);
+        *poPPath = NodeF_getPath(oNfFound);
+        return SUCCESS;
+    }
+    iStatus = FT_findDir(pcPath, &oNdFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    *ppoAAttrs = NodeD_getAttrs(oNdFound);
+    *poPPath = NodeD_getPath(oNdFound);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_setAttr(const char *pcPath, const char *pcKey,
+               const struct AttrValue *psValue) {
+    int iStatus;
+    Attrs_T *poAAttrs = NULL;
+    Path_T oPPath = NULL;
+    size_t ulKey;
+    boolean bIndexed, bHadOld;
+    struct AttrValue sOld;
+    char *pcOldCopy = NULL;
+
+    assert(pcPath != NULL);
+    assert(pcKey != NULL);
+    assert(psValue != NULL);
+
+    iStatus = FT_findAttrs(pcPath, &poAAttrs, &oPPath);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    iStatus = Attrs_getKey(pcKey, TRUE, &ulKey);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    bIndexed = (boolean) (oAIndex != NULL && Attrs_isIndexed(ulKey));
+    bHadOld = Attrs_get(*poAAttrs, ulKey, &sOld);
+
+    /* Setting the attribute frees an old string value, which is still 
+    needed afterwards to find its index entry */
+    if(bIndexed && bHadOld && sOld.eType == ATTR_STRING) {
+        pcOldCopy = malloc(strlen(sOld.pcString) + 1);
+        if(pcOldCopy == NULL)
+            return MEMORY_ERROR;
+        strcpy(pcOldCopy, sOld.pcString);
+        sOld.pcString = pcOldCopy;
+    }
+
+    /* Index the new value, then store it, undoing on failure */
+    if(bIndexed) {
+        iStatus = AttrIndex_insert(oAIndex, ulKey, psValue, oPPath);
+        if(iStatus != SUCCESS) {
+            free(pcOldCopy);
+            return iStatus;
+        }
+    }
+    iStatus = Attrs_set(poAAttrs, ulKey, psValue);
+    if(iStatus != SUCCESS) {
+        if(bIndexed)
+            AttrIndex_remove(oAIndex, ulKey, psValue, oPPath);
+        free(pcOldCopy);
+        return iStatus;
+    }
+
+    if(bIndexed && bHadOld)
+        AttrIndex_remove(oAIndex, ulKey, &sOld, oPPath);
+    free(pcOldCopy);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_getAttr(const char *pcPath, const char *pcKey,
+               struct AttrValue *psValue) {
+    int iStatus;
+    Attrs_T *poAAttrs = NULL;
+    Path_T oPPath = NULL;
+    size_t ulKey;
+
+    assert(pcPath != NULL);
+    assert(pcKey != NULL);
+    assert(psValue != NULL);
+
+    iStatus = FT_findAttrs(pcPath, &poAAttrs, &oPPath);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    iStatus = Attrs_getKey(pcKey, FALSE, &ulKey);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    if(!Attrs_get(*poAAttrs, ulKey, psValue))
+        return NO_SUCH_PATH;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_removeAttr(const char *pcPath, const char *pcKey) {
+    int iStatus;
+    Attrs_T *poAAttrs = NULL;
+    Path_T oPPath = NULL;
+    size_t ulKey;
+    struct AttrValue sOld;
+
+    assert(pcPath != NULL);
+    assert(pcKey != NULL);
+
+    iStatus = FT_findAttrs(pcPath, &poAAttrs, &oPPath);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    iStatus = Attrs_getKey(pcKey, FALSE, &ulKey);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    if(!Attrs_get(*poAAttrs, ulKey, &sOld))
+        return NO_SUCH_PATH;
+
+    /* Remove the index entry while the old value is still alive */
+    if(oAIndex != NULL && Attrs_isIndexed(ulKey))
+        AttrIndex_remove(oAIndex, ulKey, &sOld, oPPath);
+    (void) Attrs_remove(poAAttrs, ulKey);
+    return SUCCESS;
+}
+
+/* The attribute key FT_indexAttrVisit looks for, and whether it adds 
+or removes its index entries */
+struct FTAttrVisit {
+    size_t ulKey;
+    boolean bAdd;
+};
+
+/*
+  Adds or removes, per psVisit, the attribute index entry for the key 
+  of psVisit in oAAttrs, the attributes of the node at oPPath, if they 
+  carry that key. Returns SUCCESS, or MEMORY_ERROR if adding fails.
+*/
+static int FT_indexAttrVisit(Attrs_T oAAttrs, Path_T oPPath,
+                             struct FTAttrVisit *psVisit) {
+    struct AttrValue sValue;
+
+    if(!Attrs_get(oAAttrs, psVisit->ulKey, &sValue))
+        return SUCCESS;
+    if(!psVisit->bAdd) {
+        AttrIndex_remove(oAIndex, psVisit->ulKey, &sValue, oPPath);
+        return SUCCESS;
+    }
+    if(AttrIndex_insert(oAIndex, psVisit->ulKey, &sValue,
+                        oPPath) != SUCCESS)
+        return MEMORY_ERROR;
+    return SUCCESS;
+}
+
+/* Applies FT_indexAttrVisit with pvVisit to directory oNdNode. */
+static int FT_indexAttrDirVisit(NodeD_T oNdNode, void *pvVisit) {
+    return FT_indexAttrVisit(*NodeD_getAttrs(oNdNode),
+                             NodeD_getPath(oNdNode), pvVisit);
+}
+
+/* Applies FT_indexAttrVisit with pvVisit to file oNfNode. */
+static int FT_indexAttrFileVisit(NodeF_T oNfNode, void *pvVisit) {
+    return FT_indexAttrVisit(*NodeF_getAttrs(oNfNode),
+                             NodeF_getPath(oNfNode), pvVisit);
+}
+
+/* ================================================================== */
+int FT_indexAttr(const char *pcKey) {
+    int iStatus;
+    size_t ulKey;
+    struct FTAttrVisit sVisit;
+
+    assert(pcKey != NULL);
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    iStatus = Attrs_getKey(pcKey, TRUE, &ulKey);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    if(oAIndex != NULL && Attrs_isIndexed(ulKey))
+        return SUCCESS;
+
+    if(oAIndex == NULL) {
+        oAIndex = AttrIndex_new();
+        if(oAIndex == NULL)
+            return MEMORY_ERROR;
+    }
+
+    /* Index the values already in the tree, backing out on failure */
+    if(oNRoot != NULL) {
+        sVisit.ulKey = ulKey;
+        sVisit.bAdd = TRUE;
+        iStatus = FT_forEachNode(oNRoot, FT_indexAttrDirVisit,
+                                 FT_indexAttrFileVisit, &sVisit);
+        if(iStatus != SUCCESS) {
+            sVisit.bAdd = FALSE;
+            (void) FT_forEachNode(oNRoot, FT_indexAttrDirVisit,
+                                  FT_indexAttrFileVisit, &sVisit);
+            return iStatus;
+        }
+    }
+    Attrs_setIndexed(ulKey, TRUE);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_findByAttr(const char *pcKey, const struct AttrValue *psValue,
+                  DynArray_T *poDResult) {
+    DynArray_T oDResult;
+    size_t ulKey;
+
+    assert(pcKey != NULL);
+    assert(psValue != NULL);
+    assert(poDResult != NULL);
+
+    *poDResult = NULL;
+    if(!bIsInitialized || oAIndex == NULL ||
+       Attrs_getKey(pcKey, FALSE, &ulKey) != SUCCESS ||
+       !Attrs_isIndexed(ulKey))
+        return INITIALIZATION_ERROR;
+
+    oDResult = DynArray_new(0);
+    if(oDResult == NULL)
+        return MEMORY_ERROR;
+    if(AttrIndex_lookup(oAIndex, ulKey, psValue, oDResult) != SUCCESS) {
+        DynArray_free(oDResult);
+        return MEMORY_ERROR;
+    }
+    *poDResult = oDResult;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+/*
+  Appends oNfNode to DynArray_T pvFiles. Returns SUCCESS, or 
+  MEMORY_ERROR if it could not grow.
+*/
+static int FT_collectVisit(NodeF_T oNfNode, void *pvFiles) {
+    return DynArray_add(pvFiles, oNfNode) ? SUCCESS : MEMORY_ERROR;
+}
+
+/* ================================================================== */
+int FT_grep(const char *pcPath, const void *pvPattern,
+            size_t ulPatternLength, unsigned int uFlags,
+            struct FTMatch **ppsMatches, size_t *pulCount) {
+    DynArray_T oDFiles;
+    NodeD_T oNdFound = NULL;
+    NodeF_T oNfFound = NULL;
+    int iStatus;
+
+    assert(pcPath != NULL);
+    assert(pvPattern != NULL);
+    assert(ulPatternLength > 0);
+    assert(ppsMatches != NULL);
+    assert(pulCount != NULL);
+
+    *ppsMatches = NULL;
+    *pulCount = 0;
+
+    /* The path may name a directory or a single file */
+    iStatus = FT_findDir(pcPath, &oNdFound);
+    if(iStatus == NOT_A_DIRECTORY)
+        iStatus = FT_findFile(pcPath, &oNfFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    oDFiles = DynArray_new(0);
+    if(oDFiles == NULL)
+        return MEMORY_ERROR;
+    if(oNfFound != NULL)
+        iStatus = DynArray_add(oDFiles, oNfFound) ? SUCCESS : MEMORY_ERROR;
+    else
+        iStatus = FT_forEachFile(oNdFound, FT_collectVisit, oDFiles);
+    if(iStatus == SUCCESS)
+        iStatus = Grep_search(oDFiles, pvPattern, ulPatternLength, uFlags,
+                              ppsMatches, pulCount);
+    DynArray_free(oDFiles);
+    return iStatus;
+}
+
+/* ================================================================== */
+/*
+  Adds oNfNode to the text index. Returns SUCCESS, or MEMORY_ERROR if 
+  allocation fails.
+*/
+static int FT_textIndexVisit(NodeF_T oNfNode, void *pvExtra) {
+    size_t ulTextId;
+    int iStatus;
+
+    (void) pvExtra;
+    iStatus = TextIndex_add(oTIndex, NodeF_getContents(oNfNode),
+                            NodeF_getLength(oNfNode), &ulTextId);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    TextIndex_bind(oTIndex, oNfNode, ulTextId);
+    return SUCCESS;
+}
+
+/*
+  Clears the text index identifier of oNfNode, after a failed 
+  FT_textIndexVisit walk.
+*/
+static int FT_clearTextIdVisit(NodeF_T oNfNode, void *pvExtra) {
+    (void) pvExtra;
+    NodeF_setTextId(oNfNode, 0);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_enableTextIndex(void) {
+    int iStatus;
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    if(oTIndex != NULL)
+        return SUCCESS;
+
+    oTIndex = TextIndex_new();
+    if(oTIndex == NULL)
+        return MEMORY_ERROR;
+
+    /* Index the files already in the tree */
+    if(oNRoot != NULL) {
+        iStatus = FT_forEachFile(oNRoot, FT_textIndexVisit, NULL);
+        if(iStatus != SUCCESS) {
+            (void) FT_forEachFile(oNRoot, FT_clearTextIdVisit, NULL);
+            TextIndex_free(oTIndex);
+            oTIndex = NULL;
+            return iStatus;
+        }
+    }
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_searchText(const char *pcPath, const char **ppcTerms,
+                  size_t ulNumTerms, enum TextMode eMode,
+                  DynArray_T *poDResult) {
+    DynArray_T oDResult;
+    NodeD_T oNdFound = NULL;
+    NodeF_T oNfFile;
+    Path_T oPScope;
+    size_t i, ulKept = 0;
+    int iStatus;
+
+    assert(pcPath != NULL);
+    assert(ppcTerms != NULL || ulNumTerms == 0);
+    assert(poDResult != NULL);
+
+    *poDResult = NULL;
+    if(!bIsInitialized || oTIndex == NULL)
+        return INITIALIZATION_ERROR;
+    iStatus = FT_findDir(pcPath, &oNdFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    oDResult = DynArray_new(0);
+    if(oDResult == NULL)
+        return MEMORY_ERROR;
+    iStatus = TextIndex_query(oTIndex, ppcTerms, ulNumTerms, eMode,
+                              oDResult);
+    if(iStatus != SUCCESS) {
+        DynArray_free(oDResult);
+        return iStatus;
+    }
+
+    /* Keep only the files below the directory, in place */
+    oPScope = NodeD_getPath(oNdFound);
+    for(i = 0; i < DynArray_getLength(oDResult); i++) {
+        oNfFile = DynArray_get(oDResult, i);
+        if(Path_getSharedPrefixDepth(oPScope, NodeF_getPath(oNfFile))
+           == Path_getDepth(oPScope))
+            (void) DynArray_set(oDResult, ulKept++, oNfFile);
+    }
+    while(DynArray_getLength(oDResult) > ulKept)
+        (void) DynArray_removeAt(oDResult,
+                                 DynArray_getLength(oDResult) - 1);
+
+    FT_nodesToPathnames(oDResult);
+    *poDResult = oDResult;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+/*
+  Adds oNfNode to the file cache.
+*/
+static int FT_cacheVisit(NodeF_T oNfNode, void *pvExtra) {
+    (void) pvExtra;
+    FileCache_insert(oFCache, oNfNode);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_enableCache(size_t ulMaxFiles, size_t ulMaxBytes,
+                   boolean bPruneDirs, FTEvictFn pfEvict,
+                   void *pvExtra) {
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    if(oFCache == NULL) {
+        oFCache = FileCache_new(ulMaxFiles, ulMaxBytes);
+        if(oFCache == NULL)
+            return MEMORY_ERROR;
+        /* The files already in the tree start out equally cold, in 
+        the order of FT_toString */
+        if(oNRoot != NULL)
+            (void) FT_forEachFile(oNRoot, FT_cacheVisit, NULL);
+    }
+    else
+        FileCache_setCapacity(oFCache, ulMaxFiles, ulMaxBytes);
+    sEvictPolicy.pfEvict = pfEvict;
+    sEvictPolicy.pvExtra = pvExtra;
+    sEvictPolicy.bPruneDirs = bPruneDirs;
+
+    FT_evict();
+    FT_syncReplicas();
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_enableExpiry(unsigned long ulNow) {
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    if(oTWheel != NULL)
+        return SUCCESS;
+
+    oTWheel = TimerWheel_new(ulNow);
+    if(oTWheel == NULL)
+        return MEMORY_ERROR;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_setExpiry(const char *pcPath, unsigned long ulDeadline) {
+    int iStatus;
+    NodeF_T oNfFound = NULL;
+
+    assert(pcPath != NULL);
+
+    if(!bIsInitialized || oTWheel == NULL)
+        return INITIALIZATION_ERROR;
+
+    iStatus = FT_findFile(pcPath, &oNfFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    if(ulDeadline == 0)
+        TimerWheel_cancel(oTWheel, oNfFound);
+    else
+        TimerWheel_schedule(oTWheel, oNfFound, ulDeadline);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_expire(unsigned long ulNow, size_t ulMaxFiles,
+              FTEvictFn pfExpired, void *pvExtra, size_t *pulRemoved) {
+    int iStatus;
+    size_t ulRemoved = 0;
+    NodeF_T oNfDue;
+
+    if(pulRemoved != NULL)
+        *pulRemoved = 0;
+    if(!bIsInitialized || oTWheel == NULL)
+        return INITIALIZATION_ERROR;
+
+    TimerWheel_advance(oTWheel, ulNow);
+    while(ulMaxFiles == 0 || ulRemoved < ulMaxFiles) {
+        oNfDue = TimerWheel_popDue(oTWheel);
+        if(oNfDue == NULL)
+            break;
+        iStatus = FT_dropFile(oNfDue, pfExpired, pvExtra, FALSE);
+        if(iStatus != SUCCESS) {
+            /* Still due; the next call will retry it */
+            TimerWheel_schedule(oTWheel, oNfDue, ulNow);
+            if(pulRemoved != NULL)
+                *pulRemoved = ulRemoved;
+            return iStatus;
+        }
+        ulRemoved++;
+    }
+    if(pulRemoved != NULL)
+        *pulRemoved = ulRemoved;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_enableHeat(unsigned int uSampleShift) {
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    if(!Heat_isEnabled())
+        Heat_enable(uSampleShift);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_decayHeat(void) {
+    if(!bIsInitialized || !Heat_isEnabled())
+        return INITIALIZATION_ERROR;
+    Heat_decay();
+    return SUCCESS;
+}
+
+/* Returns the sum of ulA and ulB, or ULONG_MAX if it overflows. */
+static unsigned long FT_addHeat(unsigned long ulA, unsigned long ulB) {
+    return ulA > ULONG_MAX - ulB ? ULONG_MAX : ulA + ulB;
+}
+
+/*
+  Returns the heat of the subtree at oNdNode, at depth ulDepth: its 
+  own, its files' and its subdirectories' subtrees'. Appends an entry 
+  for oNdNode, and for each directory below it, at depth ulWanted (any 
+  depth if 0) to psHot, counting them in *pulCount.
+*/
+static unsigned long FT_heatSubtree(NodeD_T oNdNode, size_t ulDepth,
+                                    size_t ulWanted,
+                                    struct FTHeat *psHot,
+                                    size_t *pulCount) {
+    size_t c;
+    unsigned long ulHeat;
+    NodeF_T oNfChild = NULL;
+    NodeD_T oNdChild = NULL;
+
+    assert(oNdNode != NULL);
+
+    ulHeat = Heat_read(NodeD_getHeat(oNdNode));
+    for(c = 0; c < NodeD_getNumFileChildren(oNdNode); c++) {
+        (void) NodeD_getFileChild(oNdNode, c, &oNfChild);
+        ulHeat = FT_addHeat(ulHeat, Heat_read(NodeF_getHeat(oNfChild)));
+    }
+    for(c = 0; c < NodeD_getNumDirChildren(oNdNode); c++) {
+        (void) NodeD_getDirChild(oNdNode, c, &oNdChild);
+        ulHeat = FT_addHeat(ulHeat, FT_heatSubtree(oNdChild, ulDepth + 1,
+                                                   ulWanted, psHot,
+                                                   pulCount));
+    }
+    if(ulWanted == 0 || ulDepth == ulWanted) {
+        psHot[*pulCount].pcPath = Path_getPathname(NodeD_getPath(oNdNode));
+        psHot[*pulCount].ulHeat = ulHeat;
+        (*pulCount)++;
+    }
+    return ulHeat;
+}
+
+/* Orders the struct FTHeat at pv1 and pv2 hottest first, then by 
+pathname. */
+static int FT_compareHeat(const void *pv1, const void *pv2) {
+    const struct FTHeat *psHeat1 = pv1;
+    const struct FTHeat *psHeat2 = pv2;
+
+    if(psHeat1->ulHeat != psHeat2->ulHeat)
+        return psHeat1->ulHeat < psHeat2->ulHeat ? 1 : -1;
+    return strcmp(psHeat1->pcPath, psHeat2->pcPath);
+}
+
+/* ================================================================== */
+int FT_hotSubtrees(size_t ulK, size_t ulDepth, struct FTHeat **ppsHot,
+                   size_t *pulCount) {
+    struct FTHeat *psHot;
+    size_t ulCount = 0;
+
+    assert(ppsHot != NULL);
+    assert(pulCount != NULL);
+
+    *ppsHot = NULL;
+    *pulCount = 0;
+    if(!bIsInitialized || !Heat_isEnabled())
+        return INITIALIZATION_ERROR;
+
+    /* Room for every directory, then ranked and cut to ulK */
+    psHot = malloc((ulDirCount == 0 ? 1 : ulDirCount) *
+                   sizeof(struct FTHeat));
+    if(psHot == NULL)
+        return MEMORY_ERROR;
+    if(oNRoot != NULL)
+        (void) FT_heatSubtree(oNRoot, 1, ulDepth, psHot, &ulCount);
+    qsort(psHot, ulCount, sizeof(struct FTHeat), FT_compareHeat);
+
+    *ppsHot = psHot;
+    *pulCount = ulCount < ulK ? ulCount : ulK;
+    return SUCCESS;
+}
+
+/*
+  Records the checksum of oNfNode.
+*/
+static int FT_checksumVisit(NodeF_T oNfNode, void *pvExtra) {
+    (void) pvExtra;
+    NodeF_setChecksum(oNfNode, FT_checksumFile(oNfNode));
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_enableChecksums(void) {
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+    if(bChecksums)
+        return SUCCESS;
+
+    Crc32c_init();
+    bChecksums = TRUE;
+    if(oNRoot != NULL)
+        (void) FT_forEachFile(oNRoot, FT_checksumVisit, NULL);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_scrub(size_t ulMaxBytes, FTScrubFn pfMismatch, void *pvExtra,
+             size_t *pulMismatches) {
+    OrderIter_T oIIter = NULL;
+    const char *pcPath, *pcLast = NULL;
+    char *pcStart, *pcNewCursor;
+    boolean bIsFile, bWrapped = FALSE;
+    size_t ulBytes = 0, ulMismatches = 0;
+    NodeF_T oNfFile = NULL;
+    int iStatus;
+
+    if(pulMismatches != NULL)
+        *pulMismatches = 0;
+    if(!bIsInitialized || !bChecksums)
+        return INITIALIZATION_ERROR;
+
+    /* Resume just past the last file verified; a pass that started 
+    mid-tree wraps around once, up to where it started */
+    pcStart = pcScrubCursor;
+    iStatus = OrderIter_new(oNRoot, pcStart, &oIIter);
+    while(iStatus == SUCCESS) {
+        iStatus = OrderIter_next(oIIter, &pcPath, &bIsFile);
+        if(iStatus == NO_SUCH_PATH && pcStart != NULL && !bWrapped) {
+            OrderIter_free(oIIter);
+            bWrapped = TRUE;
+            iStatus = OrderIter_new(oNRoot, NULL, &oIIter);
+            continue;
+        }
+        if(iStatus != SUCCESS)
+            break;
+        if(bWrapped && strcmp(pcPath, pcStart) >= 0)
+            break;
+        if(!bIsFile || (!bWrapped && pcStart != NULL &&
+                        strcmp(pcPath, pcStart) == 0))
+            continue;
+
+        iStatus = FT_findFile(pcPath, &oNfFile);
+        if(iStatus != SUCCESS)
+            break;
+        if(FT_checksumFile(oNfFile) != NodeF_getChecksum(oNfFile)) {
+            ulMismatches++;
+            if(pfMismatch != NULL)
+                pfMismatch(pcPath, pvExtra);
+        }
+        pcLast = pcPath;
+        ulBytes += NodeF_getLength(oNfFile);
+        if(ulBytes >= ulMaxBytes)
+            break;
+    }
+
+    /* Running off the end means the next call starts a new pass */
+    if(iStatus == SUCCESS || iStatus == NO_SUCH_PATH) {
+        pcNewCursor = NULL;
+        if(iStatus == SUCCESS && pcLast != NULL) {
+            pcNewCursor = malloc(strlen(pcLast) + 1);
+            if(pcNewCursor == NULL)
+                iStatus = MEMORY_ERROR;
+            else
+                strcpy(pcNewCursor, pcLast);
+        }
+        if(iStatus != MEMORY_ERROR) {
+            free(pcScrubCursor);
+            pcScrubCursor = pcNewCursor;
+            iStatus = SUCCESS;
+        }
+    }
+    if(oIIter != NULL)
+        OrderIter_free(oIIter);
+
+    if(pulMismatches != NULL)
+        *pulMismatches = ulMismatches;
+    return iStatus;
+}
+
+/* --------------------------------------------------------------------
+
+  FT_graft works in two phases: planning, which decides what happens to 
+  each node, allocates everything needed and enters moved nodes into 
+  the indexes, and may fail without changing the FT; then carrying out 
+  the plan, which cannot fail.
+*/
+
+/* What FT_graft does with one node */
+enum graftVerb {
+    /* Move the subtree's node into the FT */
+    GRAFT_MOVE,
+    /* Free the FT's node, replaced by one moved in */
+    GRAFT_REPLACE,
+    /* Free the subtree's node, in favour of the FT's */
+    GRAFT_DROP,
+    /* Free the subtree's directory, its children having been merged */
+    GRAFT_SHELL
+};
+
+/* One node and what FT_graft does with it */
+struct graftAction {
+    enum graftVerb eVerb;
+    boolean bIsDir;
+    void *pvNode;
+};
+
+/* The new children of a directory of the FT */
+struct graftStep {
+    NodeD_T oNdTarget;
+    DynArray_T oDFiles;
+    DynArray_T oDDirs;
+};
+
+/* A graft being planned */
+struct graftPlan {
+    /* How conflicts are settled */
+    enum FTConflict eConflict;
+
+    /* The actions, in a growing array */
+    struct graftAction *psActions;
+    size_t ulActions;
+    size_t ulActionsSize;
+
+    /* The steps, children before parents, in a growing array */
+    struct graftStep *psSteps;
+    size_t ulSteps;
+    size_t ulStepsSize;
+};
+
+/* Returns whether any index, the file cache or checksums need to know 
+about files entering the FT. */
+static boolean FT_tracksFiles(void) {
+    return (boolean) (oSIndex != NULL || oAIndex != NULL ||
+                      oTIndex != NULL || oFCache != NULL || bChecksums);
+}
+
+/* Enters the indexed attributes in oAAttrs of the node with path 
+oPPath into the attribute index. Returns SUCCESS, or MEMORY_ERROR 
+(entering none) if allocation fails. */
+static int FT_indexAttrs(Attrs_T oAAttrs, Path_T oPPath) {
+    size_t i, ulKey;
+    struct AttrValue sValue;
+    int iStatus;
+
+    assert(oPPath != NULL);
+
+    if(oAIndex == NULL)
+        return SUCCESS;
+    for(i = 0; i < Attrs_getLength(oAAttrs); i++) {
+        Attrs_getAt(oAAttrs, i, &ulKey, &sValue);
+        if(!Attrs_isIndexed(ulKey))
+            continue;
+        iStatus = AttrIndex_insert(oAIndex, ulKey, &sValue, oPPath);
+        if(iStatus != SUCCESS) {
+            FT_unindexAttrs(oAAttrs, oPPath);
+            return iStatus;
+        }
+    }
+    return SUCCESS;
+}
+
+/* Enters file oNfNode, arriving from a subtree, into every index. 
+Returns SUCCESS, or MEMORY_ERROR (leaving it in none) if allocation 
+fails. */
+static int FT_indexMovedFile(NodeF_T oNfNode) {
+    int iStatus;
+
+    assert(oNfNode != NULL);
+
+    iStatus = FT_indexFile(oNfNode);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    iStatus = FT_indexAttrs(*NodeF_getAttrs(oNfNode),
+                            NodeF_getPath(oNfNode));
+    if(iStatus != SUCCESS)
+        FT_unindexFile(oNfNode);
+    return iStatus;
+}
+
+/* Enters oNdNode and every node below it, arriving from a subtree, into 
+every index. Returns SUCCESS, or MEMORY_ERROR (leaving them in none) if 
+allocation fails. */
+static int FT_indexSubtree(NodeD_T oNdNode) {
+    size_t c, ulFiles = 0, ulDirs = 0;
+    int iStatus;
+    NodeF_T oNfChild = NULL;
+    NodeD_T oNdChild = NULL;
+
+    assert(oNdNode != NULL);
+
+    iStatus = FT_indexAttrs(*NodeD_getAttrs(oNdNode),
+                            NodeD_getPath(oNdNode));
+    if(iStatus != SUCCESS)
+        return iStatus;
+    for(; ulFiles < NodeD_getNumFileChildren(oNdNode); ulFiles++) {
+        (void) NodeD_getFileChild(oNdNode, ulFiles, &oNfChild);
+        iStatus = FT_indexMovedFile(oNfChild);
+        if(iStatus != SUCCESS)
+            break;
+    }
+    for(; iStatus == SUCCESS &&
+          ulDirs < NodeD_getNumDirChildren(oNdNode); ulDirs++) {
+        (void) NodeD_getDirChild(oNdNode, ulDirs, &oNdChild);
+        iStatus = FT_indexSubtree(oNdChild);
+        if(iStatus != SUCCESS)
+            break;
+    }
+    if(iStatus == SUCCESS)
+        return SUCCESS;
+
+    /* Take out again whatever went in */
+    for(c = 0; c < ulFiles; c++) {
+        (void) NodeD_getFileChild(oNdNode, c, &oNfChild);
+        FT_unindexFile(oNfChild);
+    }
+    for(c = 0; c < ulDirs; c++) {
+        (void) NodeD_getDirChild(oNdNode, c, &oNdChild);
+        FT_unindexSubtree(oNdChild);
+    }
+    FT_unindexAttrs(*NodeD_getAttrs(oNdNode), NodeD_getPath(oNdNode));
+    return iStatus;
+}
+
+/* The callback FT_notifyVisit passes files to, and its argument */
+struct FTNotifyVisit {
+    FTEvictFn pfNotify;
+    void *pvExtra;
+};
+
+/* Passes oNfNode to the callback of struct FTNotifyVisit pvVisit. */
+static int FT_notifyVisit(NodeF_T oNfNode, void *pvVisit) {
+    struct FTNotifyVisit *psVisit = pvVisit;
+
+    psVisit->pfNotify(Path_getPathname(NodeF_getPath(oNfNode)),
+                      NodeF_getContents(oNfNode),
+                      NodeF_getLength(oNfNode), psVisit->pvExtra);
+    return SUCCESS;
+}
+
+/* Passes every file below oNdNode to pfNotify (if not NULL) with 
+pvExtra. */
+static void FT_notifySubtree(NodeD_T oNdNode, FTEvictFn pfNotify,
+                             void *pvExtra) {
+    struct FTNotifyVisit sVisit;
+
+    assert(oNdNode != NULL);
+
+    if(pfNotify == NULL)
+        return;
+    sVisit.pfNotify = pfNotify;
+    sVisit.pvExtra = pvExtra;
+    (void) FT_forEachFile(oNdNode, FT_notifyVisit, &sVisit);
+}
+
+/* Frees file or directory pvNode (per bIsDir) and everything below it, 
+passing its files first to pfNotify (if not NULL) with pvExtra. */
+static void FT_freeNode(void *pvNode, boolean bIsDir, FTEvictFn pfNotify,
+                        void *pvExtra) {
+    assert(pvNode != NULL);
+
+    if(bIsDir) {
+        FT_notifySubtree(pvNode, pfNotify, pvExtra);
+        (void) NodeD_free(pvNode);
+        return;
+    }
+    if(pfNotify != NULL)
+        pfNotify(Path_getPathname(NodeF_getPath(pvNode)),
+                 NodeF_getContents(pvNode), NodeF_getLength(pvNode),
+                 pvExtra);
+    NodeF_free(pvNode);
+}
+
+/* Frees the pool FT_init allocates from, if there is one, once nothing
+allocated from it is left. */
+static void FT_releasePool(void) {
+    size_t i;
+
+    if(oPDefault != NULL) {
+        PoolAlloc_free(oPDefault);
+        oPDefault = NULL;
+    }
+    if(oDLoadPools != NULL) {
+        for(i = 0; i < DynArray_getLength(oDLoadPools); i++)
+            PoolAlloc_free(DynArray_get(oDLoadPools, i));
+        DynArray_free(oDLoadPools);
+        oDLoadPools = NULL;
+    }
+}
+
+/* Returns the path of file or directory pvNode, per bIsDir. */
+static Path_T FT_nodePath(void *pvNode, boolean bIsDir) {
+    assert(pvNode != NULL);
+
+    return bIsDir ? NodeD_getPath(pvNode) : NodeF_getPath(pvNode);
+}
+
+/* Compares directory node pvNode to the pathname pvPathname, for 
+DynArray_bsearch. */
+static int FT_compareDirString(const void *pvNode,
+                               const void *pvPathname) {
+    return Path_compareString(NodeD_getPath((NodeD_T) pvNode),
+                              pvPathname);
+}
+
+/* Returns whether oDNodes, a sorted array of directories (if bIsDir) 
+or files, holds one with path oPPath. */
+static boolean FT_holds(DynArray_T oDNodes, boolean bIsDir,
+                       Path_T oPPath) {
+    size_t ulIndex;
+
+    assert(oDNodes != NULL);
+    assert(oPPath != NULL);
+
+    return (boolean) DynArray_bsearch(oDNodes,
+        (char *) Path_getPathname(oPPath), &ulIndex,
+        bIsDir ? FT_compareDirString :
+        (int (*)(const void *, const void *)) NodeF_compareString);
+}
+
+/* Adds to psPlan the action eVerb on pvNode, a directory if bIsDir. 
+Returns FALSE if the plan could not grow. */
+static boolean FT_planAction(struct graftPlan *psPlan,
+                             enum graftVerb eVerb, boolean bIsDir,
+                             void *pvNode) {
+    struct graftAction *psNew;
+    size_t ulNewSize;
+
+    assert(psPlan != NULL);
+    assert(pvNode != NULL);
+
+    if(psPlan->ulActions == psPlan->ulActionsSize) {
+        ulNewSize = psPlan->ulActionsSize == 0 ? 16 :
+                    2 * psPlan->ulActionsSize;
+        psNew = realloc(psPlan->psActions,
+                        ulNewSize * sizeof(struct graftAction));
+        if(psNew == NULL)
+            return FALSE;
+        psPlan->psActions = psNew;
+        psPlan->ulActionsSize = ulNewSize;
+    }
+    psPlan->psActions[psPlan->ulActions].eVerb = eVerb;
+    psPlan->psActions[psPlan->ulActions].bIsDir = bIsDir;
+    psPlan->psActions[psPlan->ulActions].pvNode = pvNode;
+    psPlan->ulActions++;
+    return TRUE;
+}
+
+/* Adds to psPlan the step giving oNdTarget the children oDFiles and 
+oDDirs. Returns FALSE if the plan could not grow. */
+static boolean FT_planStep(struct graftPlan *psPlan, NodeD_T oNdTarget,
+                           DynArray_T oDFiles, DynArray_T oDDirs) {
+    struct graftStep *psNew;
+    size_t ulNewSize;
+
+    assert(psPlan != NULL);
+    assert(oNdTarget != NULL);
+
+    if(psPlan->ulSteps == psPlan->ulStepsSize) {
+        ulNewSize = psPlan->ulStepsSize == 0 ? 16 :
+                    2 * psPlan->ulStepsSize;
+        psNew = realloc(psPlan->psSteps,
+                        ulNewSize * sizeof(struct graftStep));
+        if(psNew == NULL)
+            return FALSE;
+        psPlan->psSteps = psNew;
+        psPlan->ulStepsSize = ulNewSize;
+    }
+    psPlan->psSteps[psPlan->ulSteps].oNdTarget = oNdTarget;
+    psPlan->psSteps[psPlan->ulSteps].oDFiles = oDFiles;
+    psPlan->psSteps[psPlan->ulSteps].oDDirs = oDDirs;
+    psPlan->ulSteps++;
+    return TRUE;
+}
+
+static int FT_planMerge(struct graftPlan *psPlan, NodeD_T oNdTarget,
+                        DynArray_T oDSrcFiles, DynArray_T oDSrcDirs);
+
+/*
+  Plans the merge of the subtree's directories (if bIsDir) or files 
+  oDSrc into oNdTarget's children of the same kind, appending the 
+  merged children to oDNew. oDSrcOther holds the subtree's children of 
+  the other kind, against which oNdTarget's are checked. Both child 
+  arrays are sorted, so they are walked side by side; a name held with 
+  different kinds on the two sides is found by binary search. Returns 
+  SUCCESS, ALREADY_IN_TREE on a conflict if psPlan fails on them, or 
+  MEMORY_ERROR.
+*/
+static int FT_planChildren(struct graftPlan *psPlan, NodeD_T oNdTarget,
+                           boolean bIsDir, DynArray_T oDSrc,
+                           DynArray_T oDSrcOther, DynArray_T oDNew) {
+    DynArray_T oDOld, oDOldOther;
+    size_t i = 0, j = 0;
+    void *pvSrc, *pvOld;
+    boolean bSrcWins, bIsOk = TRUE;
+    int iCmp, iStatus;
+
+    assert(psPlan != NULL);
+    assert(oNdTarget != NULL);
+
+    bSrcWins = (boolean) (psPlan->eConflict == FT_CONFLICT_REPLACE);
+    NodeD_mergeChildren(oNdTarget);
+    oDOld = bIsDir ? NodeD_getDirChildren(oNdTarget) :
+                     NodeD_getFileChildren(oNdTarget);
+    oDOldOther = bIsDir ? NodeD_getFileChildren(oNdTarget) :
+                          NodeD_getDirChildren(oNdTarget);
+
+    while(bIsOk && (i < DynArray_getLength(oDSrc) ||
+                    j < DynArray_getLength(oDOld))) {
+        pvSrc = i < DynArray_getLength(oDSrc) ?
+                DynArray_get(oDSrc, i) : NULL;
+        pvOld = j < DynArray_getLength(oDOld) ?
+                DynArray_get(oDOld, j) : NULL;
+        if(pvSrc == NULL)
+            iCmp = 1;
+        else if(pvOld == NULL)
+            iCmp = -1;
+        else
+            iCmp = Path_comparePath(FT_nodePath(pvSrc, bIsDir),
+                                    FT_nodePath(pvOld, bIsDir));
+
+        /* Only the FT has this name with this kind */
+        if(iCmp > 0) {
+            j++;
+            if(FT_holds(oDSrcOther, !bIsDir,
+                        FT_nodePath(pvOld, bIsDir))) {
+                if(psPlan->eConflict == FT_CONFLICT_FAIL)
+                    return ALREADY_IN_TREE;
+                if(bSrcWins) {
+                    bIsOk = FT_planAction(psPlan, GRAFT_REPLACE, bIsDir,
+                                          pvOld);
+                    continue;
+                }
+            }
+            bIsOk = DynArray_add(oDNew, pvOld);
+            continue;
+        }
+
+        /* Only the subtree has this name with this kind */
+        i++;
+        if(iCmp < 0) {
+            if(FT_holds(oDOldOther, !bIsDir,
+                        FT_nodePath(pvSrc, bIsDir))) {
+                if(psPlan->eConflict == FT_CONFLICT_FAIL)
+                    return ALREADY_IN_TREE;
+                if(!bSrcWins) {
+                    bIsOk = FT_planAction(psPlan, GRAFT_DROP, bIsDir,
+                                          pvSrc);
+                    continue;
+                }
+            }
+            bIsOk = FT_planAction(psPlan, GRAFT_MOVE, bIsDir, pvSrc) &&
+                    DynArray_add(oDNew, pvSrc);
+            continue;
+        }
+
+        /* Both have it: directories merge, files conflict */
+        j++;
+        if(bIsDir) {
+            NodeD_mergeChildren(pvSrc);
+            iStatus = FT_planMerge(psPlan, pvOld,
+                                   NodeD_getFileChildren(pvSrc),
+                                   NodeD_getDirChildren(pvSrc));
+            if(iStatus != SUCCESS)
+                return iStatus;
+            bIsOk = FT_planAction(psPlan, GRAFT_SHELL, TRUE, pvSrc) &&
+                    DynArray_add(oDNew, pvOld);
+        }
+        else if(psPlan->eConflict == FT_CONFLICT_FAIL)
+            return ALREADY_IN_TREE;
+        else if(bSrcWins)
+            bIsOk = FT_planAction(psPlan, GRAFT_REPLACE, FALSE, pvOld) &&
+                    FT_planAction(psPlan, GRAFT_MOVE, FALSE, pvSrc) &&
+                    DynArray_add(oDNew, pvSrc);
+        else
+            bIsOk = FT_planAction(psPlan, GRAFT_DROP, FALSE, pvSrc) &&
+                    DynArray_add(oDNew, pvOld);
+    }
+    return bIsOk ? SUCCESS : MEMORY_ERROR;
+}
+
+/*
+  Plans the merge of the subtree's files oDSrcFiles and directories 
+  oDSrcDirs into the children of oNdTarget, a directory of the FT, and 
+  of any directory the two share, below. Returns SUCCESS, 
+  ALREADY_IN_TREE on a conflict if psPlan fails on them, or 
+  MEMORY_ERROR.
+*/
+static int FT_planMerge(struct graftPlan *psPlan, NodeD_T oNdTarget,
+                        DynArray_T oDSrcFiles, DynArray_T oDSrcDirs) {
+    DynArray_T oDFiles, oDDirs;
+    int iStatus = MEMORY_ERROR;
+
+    assert(psPlan != NULL);
+    assert(oNdTarget != NULL);
+    assert(oDSrcFiles != NULL);
+    assert(oDSrcDirs != NULL);
+
+    oDFiles = DynArray_new(0);
+    oDDirs = DynArray_new(0);
+    if(oDFiles != NULL && oDDirs != NULL) {
+        iStatus = FT_planChildren(psPlan, oNdTarget, FALSE, oDSrcFiles,
+                                  oDSrcDirs, oDFiles);
+        if(iStatus == SUCCESS)
+            iStatus = FT_planChildren(psPlan, oNdTarget, TRUE, oDSrcDirs,
+                                      oDSrcFiles, oDDirs);
+        /* After the directories below, so children come first */
+        if(iStatus == SUCCESS &&
+           !FT_planStep(psPlan, oNdTarget, oDFiles, oDDirs))
+            iStatus = MEMORY_ERROR;
+    }
+    if(iStatus != SUCCESS) {
+        if(oDFiles != NULL)
+            DynArray_free(oDFiles);
+        if(oDDirs != NULL)
+            DynArray_free(oDDirs);
+    }
+    return iStatus;
+}
+
+/* Enters the nodes psPlan moves into every index. Returns SUCCESS, or 
+MEMORY_ERROR (entering none) if allocation fails. */
+static int FT_indexPlan(struct graftPlan *psPlan) {
+    struct graftAction *psAction;
+    size_t a;
+    int iStatus = SUCCESS;
+
+    assert(psPlan != NULL);
+
+    if(!FT_tracksFiles())
+        return SUCCESS;
+    for(a = 0; a < psPlan->ulActions && iStatus == SUCCESS; a++) {
+        psAction = &psPlan->psActions[a];
+        if(psAction->eVerb != GRAFT_MOVE)
+            continue;
+        iStatus = psAction->bIsDir ?
+                  FT_indexSubtree(psAction->pvNode) :
+                  FT_indexMovedFile(psAction->pvNode);
+    }
+    if(iStatus == SUCCESS)
+        return SUCCESS;
+
+    /* a is one past the action that failed, which undid itself */
+    while(--a > 0) {
+        psAction = &psPlan->psActions[a - 1];
+        if(psAction->eVerb != GRAFT_MOVE)
+            continue;
+        if(psAction->bIsDir)
+            FT_unindexSubtree(psAction->pvNode);
+        else
+            FT_unindexFile(psAction->pvNode);
+    }
+    return iStatus;
+}
+
+/* Frees what psPlan allocated, without carrying it out. */
+static void FT_abandonPlan(struct graftPlan *psPlan) {
+    size_t s;
+
+    assert(psPlan != NULL);
+
+    for(s = 0; s < psPlan->ulSteps; s++) {
+        DynArray_free(psPlan->psSteps[s].oDFiles);
+        DynArray_free(psPlan->psSteps[s].oDDirs);
+    }
+    free(psPlan->psSteps);
+    free(psPlan->psActions);
+}
+
+/* Carries out psPlan, passing files dropped or replaced to pfDropped 
+(if not NULL) with pvExtra, and frees it. Never fails. */
+static void FT_carryOutPlan(struct graftPlan *psPlan,
+                            FTEvictFn pfDropped, void *pvExtra) {
+    struct graftAction *psAction;
+    size_t a, s;
+
+    assert(psPlan != NULL);
+
+    /* Replaced nodes leave while their parents' old arrays, which 
+    still hold them, are in place */
+    for(a = 0; a < psPlan->ulActions; a++) {
+        psAction = &psPlan->psActions[a];
+        if(psAction->eVerb != GRAFT_REPLACE)
+            continue;
+        if(psAction->bIsDir)
+            FT_unindexSubtree(psAction->pvNode);
+        else
+            FT_unindexFile(psAction->pvNode);
+        FT_freeNode(psAction->pvNode, psAction->bIsDir, pfDropped,
+                    pvExtra);
+    }
+    for(s = 0; s < psPlan->ulSteps; s++)
+        NodeD_adoptChildren(psPlan->psSteps[s].oNdTarget,
+                            psPlan->psSteps[s].oDFiles,
+                            psPlan->psSteps[s].oDDirs);
+    /* Dropped nodes still hang from the subtree's directories, so 
+    those go last */
+    for(a = 0; a < psPlan->ulActions; a++) {
+        psAction = &psPlan->psActions[a];
+        if(psAction->eVerb == GRAFT_DROP)
+            FT_freeNode(psAction->pvNode, psAction->bIsDir, pfDropped,
+                        pvExtra);
+    }
+    for(a = 0; a < psPlan->ulActions; a++) {
+        psAction = &psPlan->psActions[a];
+        if(psAction->eVerb == GRAFT_SHELL)
+            NodeD_freeShell(psAction->pvNode);
+    }
+    free(psPlan->psSteps);
+    free(psPlan->psActions);
+}
+
+/* ================================================================== */
+int FT_detachSubtree(const char *pcPath, FTSubtree_T *poSResult) {
+    int iStatus;
+    NodeD_T oNdFound = NULL;
+    FTSubtree_T oSNew;
+
+    assert(pcPath != NULL);
+    assert(poSResult != NULL);
+
+    *poSResult = NULL;
+    if(!bIsInitialized || CS_isInitialized())
+        return INITIALIZATION_ERROR;
+
+    iStatus = FT_findDir(pcPath, &oNdFound);
+    if(iStatus != SUCCESS)
+        return iStatus;
+    oSNew = malloc(sizeof(struct ftSubtree));
+    if(oSNew == NULL)
+        return MEMORY_ERROR;
+
+    /* Detaching a directory counts as an access to its parent */
+    if(NodeD_getParent(oNdFound) != NULL)
+        Heat_bump(NodeD_getHeat(NodeD_getParent(oNdFound)));
+
+    FT_unindexSubtree(oNdFound);
+    FT_markTop(Path_getDepth(NodeD_getPath(oNdFound)));
+    NodeD_detach(oNdFound);
+    ulDirCount -= NodeD_getSubtreeDirCount(oNdFound) + 1;
+    if(oNdFound == oNRoot)
+        oNRoot = NULL;
+    FT_syncReplicas();
+
+    oSNew->oNdTop = oNdFound;
+    ulDetached++;
+    *poSResult = oSNew;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_graft(FTSubtree_T oSSubtree, enum FTConflict eConflict,
+             FTEvictFn pfDropped, void *pvExtra) {
+    struct graftPlan sPlan;
+    NodeD_T oNdTop, oNdTarget = NULL;
+    Path_T oPTop, oPParent = NULL;
+    DynArray_T oDTop = NULL, oDNone = NULL;
+    int iStatus;
+
+    assert(oSSubtree != NULL);
+
+    if(!bIsInitialized || CS_isInitialized())
+        return INITIALIZATION_ERROR;
+
+    oNdTop = oSSubtree->oNdTop;
+    oPTop = NodeD_getPath(oNdTop);
+    /* Every directory the graft adds or frees is at least this deep */
+    FT_markTop(Path_getDepth(oPTop));
+    sPlan.eConflict = eConflict;
+    sPlan.psActions = NULL;
+    sPlan.ulActions = 0;
+    sPlan.ulActionsSize = 0;
+    sPlan.psSteps = NULL;
+    sPlan.ulSteps = 0;
+    sPlan.ulStepsSize = 0;
+
+    if(Path_getDepth(oPTop) == 1) {
+        /* An empty FT takes the subtree as it is */
+        if(oNRoot == NULL) {
+            if(!FT_planAction(&sPlan, GRAFT_MOVE, TRUE, oNdTop))
+                return MEMORY_ERROR;
+            iStatus = FT_indexPlan(&sPlan);
+            FT_abandonPlan(&sPlan);
+            if(iStatus != SUCCESS)
+                return iStatus;
+            oNRoot = oNdTop;
+            oNdTarget = oNRoot;
+        }
+        else if(Path_comparePath(NodeD_getPath(oNRoot), oPTop) != 0)
+            return CONFLICTING_PATH;
+        else {
+            /* Merge the subtree's top into the root */
+            oNdTarget = oNRoot;
+            NodeD_mergeChildren(oNdTop);
+            iStatus = FT_planMerge(&sPlan, oNRoot,
+                                   NodeD_getFileChildren(oNdTop),
+                                   NodeD_getDirChildren(oNdTop));
+            if(iStatus == SUCCESS &&
+               !FT_planAction(&sPlan, GRAFT_SHELL, TRUE, oNdTop))
+                iStatus = MEMORY_ERROR;
+        }
+    }
+    else {
+        /* Find, or make, the directory the top goes in */
+        iStatus = Path_prefix(oPTop, Path_getDepth(oPTop) - 1,
+                              &oPParent);
+        if(iStatus != SUCCESS)
+            return iStatus;
+        iStatus = FT_findDir(Path_getPathname(oPParent), &oNdTarget);
+        if(iStatus == NO_SUCH_PATH) {
+            iStatus = FT_insertDir(Path_getPathname(oPParent));
+            if(iStatus == SUCCESS)
+                iStatus = FT_findDir(Path_getPathname(oPParent),
+                                     &oNdTarget);
+        }
+        Path_free(oPParent);
+        if(iStatus != SUCCESS)
+            return iStatus;
+
+        oDTop = DynArray_new(0);
+        oDNone = DynArray_new(0);
+        if(oDTop == NULL || oDNone == NULL || !DynArray_add(oDTop, oNdTop))
+            iStatus = MEMORY_ERROR;
+        else
+            iStatus = FT_planMerge(&sPlan, oNdTarget, oDNone, oDTop);
+    }
+
+    if(oNdTarget != oNdTop) {
+        if(iStatus == SUCCESS)
+            iStatus = FT_indexPlan(&sPlan);
+        if(oDTop != NULL)
+            DynArray_free(oDTop);
+        if(oDNone != NULL)
+            DynArray_free(oDNone);
+        if(iStatus != SUCCESS) {
+            FT_abandonPlan(&sPlan);
+            return iStatus;
+        }
+        FT_carryOutPlan(&sPlan, pfDropped, pvExtra);
+    }
+
+    ulDirCount = NodeD_getSubtreeDirCount(oNRoot) + 1;
+    free(oSSubtree);
+    ulDetached--;
+    Heat_bump(NodeD_getHeat(oNdTarget));
+    FT_evict();
+    FT_syncReplicas();
+    return SUCCESS;
+}
+
+/* ================================================================== */
+void FT_freeSubtree(FTSubtree_T oSSubtree, FTEvictFn pfDropped,
+                    void *pvExtra) {
+    assert(oSSubtree != NULL);
+
+    FT_freeNode(oSSubtree->oNdTop, TRUE, pfDropped, pvExtra);
+    free(oSSubtree);
+    /* The attribute keys and pool were kept only for detached
+    subtrees */
+    if(--ulDetached == 0 && !bIsInitialized) {
+        Attrs_resetKeys();
+        FT_releasePool();
+    }
+}
+
+/* ================================================================== */
+int FT_load(const struct FTLoadEntry *psEntries, size_t ulCount,
+            size_t ulThreads) {
+    struct BulkPart *psParts;
+    FTSubtree_T oSPart;
+    size_t ulParts, ulKept, p;
+    int iStatus;
+
+    assert(psEntries != NULL || ulCount == 0);
+
+    if(!bIsInitialized || oNRoot != NULL || CS_isInitialized())
+        return INITIALIZATION_ERROR;
+
+    iStatus = BulkLoad_build(psEntries, ulCount, ulThreads, &psParts,
+                             &ulParts);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    /* The pools must last as long as the nodes in them */
+    if(oDLoadPools == NULL)
+        oDLoadPools = DynArray_new(0);
+    ulKept = oDLoadPools == NULL ? 0 : DynArray_getLength(oDLoadPools);
+    for(p = 0; p < ulParts && oDLoadPools != NULL; p++)
+        if(!DynArray_add(oDLoadPools, psParts[p].oPool))
+            break;
+    if(p < ulParts)
+        iStatus = MEMORY_ERROR;
+    p = 0;
+
+    /* The runs share only the root and (rarely) a top-level directory, 
+    so each graft merges little; and since each top-level directory 
+    is in one run but for its own entry, a clash between runs is a file 
+    that a later run puts a directory under */
+    while(p < ulParts && iStatus == SUCCESS) {
+        oSPart = malloc(sizeof(struct ftSubtree));
+        if(oSPart == NULL) {
+            iStatus = MEMORY_ERROR;
+            break;
+        }
+        oSPart->oNdTop = psParts[p].oNdTop;
+        ulDetached++;
+        iStatus = FT_graft(oSPart, FT_CONFLICT_FAIL, NULL, NULL);
+        if(iStatus == SUCCESS)
+            p++;
+        else {
+            free(oSPart);
+            ulDetached--;
+            if(iStatus == ALREADY_IN_TREE)
+                iStatus = NOT_A_DIRECTORY;
+        }
+    }
+    if(iStatus == SUCCESS) {
+        free(psParts);
+        return SUCCESS;
+    }
+
+    /* Free what was grafted, then the rest, and then the pools */
+    if(oNRoot != NULL)
+        (void) FT_rmDir(Path_getPathname(NodeD_getPath(oNRoot)));
+    for(; p < ulParts; p++)
+        (void) NodeD_free(psParts[p].oNdTop);
+    while(oDLoadPools != NULL &&
+          DynArray_getLength(oDLoadPools) > ulKept)
+        (void) DynArray_removeAt(oDLoadPools,
+                                 DynArray_getLength(oDLoadPools) - 1);
+    for(p = 0; p < ulParts; p++)
+        PoolAlloc_free(psParts[p].oPool);
+    free(psParts);
+    return iStatus;
+}
+
+/* ================================================================== */
+int FT_publishShm(FTShm_T oSShm) {
+    assert(oSShm != NULL);
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    return FTShm_publish(oSShm, oNRoot);
+}
+
+/* ================================================================== */
+int FT_freeze(void) {
+    FTFrozen_T oFImage;
+    int iStatus;
+
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    iStatus = FTFrozen_build(oNRoot, &oFImage);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    /* The image holds everything the frozen lookups need */
+    (void) FT_destroy();
+    oFFrozen = oFImage;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_writeFrozen(const char *pcFile) {
+    assert(pcFile != NULL);
+
+    if(oFFrozen == NULL)
+        return INITIALIZATION_ERROR;
+
+    return FTFrozen_write(oFFrozen, pcFile);
+}
+
+/* ================================================================== */
+int FT_mapFrozen(const char *pcFile) {
+    assert(pcFile != NULL);
+
+    if(bIsInitialized || oFFrozen != NULL)
+        return INITIALIZATION_ERROR;
+
+    return FTFrozen_map(pcFile, &oFFrozen);
+}
+
+/* ================================================================== */
+int FT_archive(FTArchive_T *poAResult) {
+    assert(poAResult != NULL);
+
+    if(!bIsInitialized) {
+        *poAResult = NULL;
+        return INITIALIZATION_ERROR;
+    }
+
+    return FTArchive_build(oNRoot, poAResult);
+}
+
+/* ================================================================== */
+int FT_enableReplicas(size_t ulLevels) {
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    FT_freeReplicas();
+    if(ulLevels == 0)
+        return SUCCESS;
+
+    sReplicas.ulCount = (size_t) Numa_nodeCount();
+    sReplicas.poReplicas = calloc(sReplicas.ulCount, sizeof(FTReplica_T));
+    if(sReplicas.poReplicas == NULL) {
+        sReplicas.ulCount = 0;
+        return MEMORY_ERROR;
+    }
+    sReplicas.ulLevels = ulLevels;
+    sReplicas.bIsStale = TRUE;
+    FT_syncReplicas();
+    if(sReplicas.bIsStale) {
+        FT_freeReplicas();
+        return MEMORY_ERROR;
+    }
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_init(void) {
+    if(bIsInitialized || oFFrozen != NULL)
+        return INITIALIZATION_ERROR;
+
+    /* A pool kept for detached subtrees is used again; if a new one
+    cannot be made, the FT falls back on malloc */
+    if(oPDefault == NULL)
+        oPDefault = PoolAlloc_new();
+    return FT_initWith(oPDefault == NULL ? NULL :
+                       PoolAlloc_getAlloc(oPDefault));
+}
+
+/* ================================================================== */
+int FT_initWith(Alloc_T oAAllocator) {
+    /* cannot init an already intialized (or frozen) FT */
+    if(bIsInitialized || oFFrozen != NULL)
+        return INITIALIZATION_ERROR;
+
+    /* Initialize fields */
+    bIsInitialized = TRUE;
+    oNRoot = NULL;
+    ulDirCount = 0;
+    oSIndex = NULL;
+    oAIndex = NULL;
+    oTIndex = NULL;
+    oFCache = NULL;
+    sEvictPolicy.pfEvict = NULL;
+    sEvictPolicy.pvExtra = NULL;
+    sEvictPolicy.bPruneDirs = FALSE;
+    oTWheel = NULL;
+    bChecksums = FALSE;
+    pcScrubCursor = NULL;
+    oAAlloc = oAAllocator;
+    sReplicas.ulLevels = 0;
+    sReplicas.poReplicas = NULL;
+    sReplicas.ulCount = 0;
+    sReplicas.bIsStale = FALSE;
+    oHTable = NULL;
+
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_destroy(void) {
+    /* a frozen FT is just its image */
+    if(oFFrozen != NULL) {
+        FTFrozen_free(oFFrozen);
+        oFFrozen = NULL;
+        return SUCCESS;
+    }
+
+    /* cannot destroy if it doesn't exist */
+    if(!bIsInitialized)
+        return INITIALIZATION_ERROR;
+
+    /* Free from root if it exists (will recursively free everything 
+    else)*/
+    if(oNRoot) {
+        ulDirCount -= NodeD_free(oNRoot);
+        /* uninitialize root */
+        oNRoot = NULL;
+    }
+
+    /* uninitialize FT fields */
+    assert(ulDirCount == 0);
+
+    /* Release the secondary indexes along with the tree */
+    if(oSIndex != NULL) {
+        SizeIndex_free(oSIndex);
+        oSIndex = NULL;
+    }
+    if(oAIndex != NULL) {
+        AttrIndex_free(oAIndex);
+        oAIndex = NULL;
+    }
+    if(oTIndex != NULL) {
+        TextIndex_free(oTIndex);
+        oTIndex = NULL;
+    }
+    if(oFCache != NULL) {
+        FileCache_free(oFCache);
+        oFCache = NULL;
+    }
+    if(oTWheel != NULL) {
+        TimerWheel_free(oTWheel);
+        oTWheel = NULL;
+    }
+    if(oHTable != NULL) {
+        HandleTable_free(oHTable);
+        oHTable = NULL;
+    }
+    Heat_disable();
+    FT_freeReplicas();
+    if(ulDetached == 0) {
+        Attrs_resetKeys();
+        FT_releasePool();
+    }
+    else
+        Attrs_clearIndexed();
+    oAAlloc = NULL;
+    bChecksums = FALSE;
+    free(pcScrubCursor);
+    pcScrubCursor = NULL;
+
+    /* Release the content store along with the tree */
+    if(CS_isInitialized())
+        (void) CS_destroy();
+
+    bIsInitialized = FALSE;
+
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_setContentBudget(size_t ulBudget, const char *pcSpillPath) {
+    assert(pcSpillPath != NULL);
+
+    /* Contents already in the tree are owned by the client, so the 
+    store can only be set up while the tree is empty */
+    if(!bIsInitialized || oNRoot != NULL)
+        return INITIALIZATION_ERROR;
+
+    return CS_init(ulBudget, pcSpillPath);
+}
+
+/* ================================================================== */
+int FT_getContentStats(struct CSStats *psStats) {
+    assert(psStats != NULL);
+
+    if(!bIsInitialized || !CS_isInitialized())
+        return INITIALIZATION_ERROR;
+
+    CS_getStats(psStats);
+    return SUCCESS;
+}
+
+/* ================================================================== */
+int FT_iterNew(const char *pcLo, OrderIter_T *poIResult) {
+    assert(poIResult != NULL);
+
+    if(!bIsInitialized) {
+        *poIResult = NULL;
+        return INITIALIZATION_ERROR;
+    }
+
+    return OrderIter_new(oNRoot, pcLo, poIResult);
+}
+
+/* ================================================================== */
+int FT_iterNext(OrderIter_T oIIter, const char **ppcPath,
+                boolean *pbIsFile) {
+    assert(oIIter != NULL);
+
+    return OrderIter_next(oIIter, ppcPath, pbIsFile);
+}
+
+/* ================================================================== */
+void FT_iterFree(OrderIter_T oIIter) {
+    assert(oIIter != NULL);
+
+    OrderIter_free(oIIter);
+}
+
+/* ================================================================== */
+int FT_scanRange(const char *pcLo, const char *pcHi,
+                 void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                                 void *pvExtra),
+                 void *pvExtra) {
+    OrderIter_T oIIter = NULL;
+    const char *pcPath;
+    boolean bIsFile;
+    int iStatus;
+
+    assert(pfVisit != NULL);
+
+    iStatus = FT_iterNew(pcLo, &oIIter);
+    if(iStatus != SUCCESS)
+        return iStatus;
+
+    /* Entries come out sorted, so stop at the first one past pcHi */
+    while((iStatus = OrderIter_next(oIIter, &pcPath, &bIsFile))
+          == SUCCESS) {
+        if(pcHi != NULL && strcmp(pcPath, pcHi) >= 0)
+            break;
+        (*pfVisit)(pcPath, bIsFile, pvExtra);
+    }
+    OrderIter_free(oIIter);
+
+    if(iStatus == MEMORY_ERROR)
+        return iStatus;
+    return SUCCESS;
+}
+
+/* ================================================================== */
+/*
+  The following auxiliary functions are used for generating the
+  string representation of the FT.
+*/
+
+/*
+  Performs pre-order traversal of file tree rooted at n,
+  inserting each payload to DynArray_T d beginning at index i.
+  Returns the next unused index in d after the insertion(s).
+*/
+
+static size_t FT_preOrderTraversal(NodeD_T n, DynArray_T d, size_t i) {
+    size_t c;
+
+    assert(d != NULL);
+
+    if(n != NULL) {
+        (void) DynArray_set(d, i, n);
+        i++;
+        for(c = 0; c < NodeD_getNumDirChildren(n); c++) {
+            int iStatus;
+            NodeD_T oNdChild = NULL;
+            iStatus = NodeD_getDirChild(n,c, &oNdChild);
+            assert(iStatus == SUCCESS);
+            i = FT_preOrderTraversal(oNdChild, d, i);
+        }
+    }
+    return i;
+}
+
+/*
+  Alternate version of strlen that uses pulAcc as an in-out parameter
+  to accumulate a string length, rather than returning the length of
+  oNdNode's path, and also always adds one addition byte to the sum.
+  Also accumulates the lengths of oNdNode's children Paths.
+*/
+static void FT_strlenAccumulate(NodeD_T oNdNode, size_t *pulAcc) {
     char* pcNodeString;
 
     assert(pulAcc != NULL);
@@ -746,17 +3568,22 @@ static void FT_strlenAccumulate(NodeD_T oNdNode, size_t *pulAcc) {
 
 /*
   Alternate version of strcat that inverts the typical argument
-  order, appending oNdNode's string represenation onto pcAcc, and also 
-  always adds one newline at the end of the concatenated string.
+  order, appending oNdNode's string represenation at *ppcEnd, the end
+  of the accumulated string, and advancing *ppcEnd past it, so that
+  appending never rescans what is already there.
 */
-static void FT_strcatAccumulate(NodeD_T oNdNode, char *pcAcc) {
+static void FT_strcatAccumulate(NodeD_T oNdNode, char **ppcEnd) {
     char* pcNodeString;
+    size_t ulLength;
 
-    assert(pcAcc != NULL);
+    assert(ppcEnd != NULL);
+    assert(*ppcEnd != NULL);
 
     if(oNdNode != NULL) {
         pcNodeString = NodeD_toString(oNdNode);
-        strcat(pcAcc, pcNodeString);
+        ulLength = strlen(pcNodeString);
+        memcpy(*ppcEnd, pcNodeString, ulLength + 1);
+        *ppcEnd += ulLength;
         free(pcNodeString);
     }
 }
@@ -766,7 +3593,12 @@ char *FT_toString(void) {
     DynArray_T nodes;
     size_t totalStrlen = 1;
     char *result = NULL;
-    
+    char *end;
+
+    /* A frozen FT keeps its text */
+    if(oFFrozen != NULL)
+        return FTFrozen_toString(oFFrozen);
+
     /* Make sure FT is initialized */
     if(!bIsInitialized)
         return NULL;
@@ -788,8 +3620,9 @@ char *FT_toString(void) {
     *result = '\0';
 
     /* Accumulate string representations of all nodes */
+    end = result;
     DynArray_map(nodes, (void (*)(void *, void*)) FT_strcatAccumulate,
-    (void *) result);
+    (void *) &end);
     
     DynArray_free(nodes);
 
@@ -14,6 +14,17 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "dynarray.h"
+#include "alloc.h"
+#include "contentstore.h"
+#include "orderiter.h"
+#include "attrs.h"
+#include "ftshm.h"
+#include "grep.h"
+#include "bulkload.h"
+#include "handletable.h"
+#include "textindex.h"
+#include "ftarchive.h"
 
 /*
    Inserts a new directory into the FT with absolute path pcPath.
@@ -92,6 +103,22 @@ int FT_rmFile(const char *pcPath);
 */
 void *FT_getFileContents(const char *pcPath);
 
+/*
+  Like FT_getFileContents for each of the ulNumPaths absolute paths in
+  ppcPaths, resolved together as by FT_statMulti: stores in
+  ppvContents[i] the contents of the file at ppcPaths[i], or NULL if
+  it is not a file in the FT, and, if pulLengths is not NULL, their
+  length (0 if not a file) in pulLengths[i]. With a content store in
+  use, the batch's contents are pinned in memory, so that every
+  pointer stays valid until the next FT call, as with
+  FT_getFileContents. Returns SUCCESS if every path was looked up.
+  Otherwise, leaves every entry NULL and 0 and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_getFileContentsMulti(const char **ppcPaths, size_t ulNumPaths,
+                            void **ppvContents, size_t *pulLengths);
+
 /*
   Replaces current contents of the file with absolute path pcPath with
   the parameter pvNewContents of size ulNewLength bytes.
@@ -119,22 +146,688 @@ void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
 */
 int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize);
 
+/* What FT_statMulti found at one path */
+struct FTStat {
+   /* The status FT_stat would return for the path */
+   int iStatus;
+
+   /* If iStatus is SUCCESS: whether the path is a file, and if so the
+      length of its contents (0 for a directory) */
+   boolean bIsFile;
+   size_t ulSize;
+};
+
+/*
+  Looks up the ulNumPaths absolute paths in ppcPaths as FT_stat does,
+  storing the result for ppcPaths[i] in psStats[i]. The paths are
+  resolved together, in sorted order, so that paths sharing leading
+  directories walk them once and the searches among a directory's
+  children move only forward; batches from one subtree cost far less
+  than separate calls. Returns SUCCESS if every path was looked up
+  (whatever each was found to be). Otherwise, stores the returned
+  status as every path's and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_statMulti(const char **ppcPaths, size_t ulNumPaths,
+                 struct FTStat *psStats);
+
+/*
+  Stores in *psHandle a handle to the file with absolute path pcPath,
+  through which the calls below reach it in constant time, without
+  walking its path. Every handle to a file is the same, and stays
+  valid until the file leaves the FT, by whatever call (including
+  eviction, expiry, detaching and FT_destroy); from then on the calls
+  return NO_SUCH_PATH for it, even if a file with the same path is
+  added again. The FT keeps a slot for each opened file while it is in
+  the tree. Returns SUCCESS if the handle is stored. Otherwise, leaves
+  *psHandle unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_openFile(const char *pcPath, struct FTHandle *psHandle);
+
+/*
+  Like FT_getFileContents for the file *psHandle refers to: stores its
+  contents in *ppvContents. Returns SUCCESS, or leaves *ppvContents
+  unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if the file has left the FT
+*/
+int FT_getHandleContents(const struct FTHandle *psHandle,
+                         void **ppvContents);
+
+/*
+  Like FT_replaceFileContents for the file *psHandle refers to:
+  replaces its contents with the ulNewLength bytes at pvNewContents
+  and stores the old contents in *ppvOldContents. Returns SUCCESS, or
+  leaves the file unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if the file has left the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_replaceHandleContents(const struct FTHandle *psHandle,
+                             void *pvNewContents, size_t ulNewLength,
+                             void **ppvOldContents);
+
+/*
+  Like FT_stat for the file *psHandle refers to: stores the length of
+  its contents in *pulSize. Returns SUCCESS, or leaves *pulSize
+  unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if the file has left the FT
+*/
+int FT_statHandle(const struct FTHandle *psHandle, size_t *pulSize);
+
+/*
+  Like FT_rmFile for the file *psHandle refers to. Its parent is found
+  through the handle, so only the removal from the parent's sorted
+  children costs more than constant time. Returns SUCCESS if removed.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if the file has left the FT
+*/
+int FT_rmHandle(const struct FTHandle *psHandle);
+
+/*
+  Stores in *pulFiles and *pulDirs the number of files and directories
+  below the directory with absolute path pcPath (not counting the
+  directory itself). Runs in time proportional to the depth of pcPath.
+  Returns SUCCESS if the counts are stored. Otherwise, leaves them
+  unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_count(const char *pcPath, size_t *pulFiles, size_t *pulDirs);
+
+/*
+  Finds the entry with 0-based index ulK among the entries below the
+  directory with absolute path pcPath, in the canonical order used by
+  FT_toString (which lists the directory itself first; that entry is
+  not counted here). Stores its pathname, owned by the FT and valid
+  until the FT changes, in *ppcResult and whether it is a file in
+  *pbIsFile. Skips whole subtrees using their counts, so the cost is
+  proportional to the depth of the result times the number of
+  directory children passed over on the way.
+  Returns SUCCESS if the entry is found. Otherwise, leaves *ppcResult
+  and *pbIsFile unchanged and returns:
+  * NO_SUCH_PATH if pcPath does not exist or ulK is not less than the
+                 number of entries below it
+  * any other status FT_count returns for pcPath
+*/
+int FT_nth(const char *pcPath, size_t ulK, const char **ppcResult,
+           boolean *pbIsFile);
+
+/*
+  Enables the secondary index of files by the length of their
+  contents, indexing the files already in the FT. From then on the
+  index is kept current by FT_insertFile, FT_replaceFileContents,
+  FT_rmFile and FT_rmDir, until FT_destroy discards it. Enabling it
+  again has no effect. Returns SUCCESS if the index is enabled.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableSizeIndex(void);
+
+/*
+  Sets *poDResult to a new DynArray_T holding the absolute pathnames
+  (owned by the FT, valid until the FT changes) of the ulK files with
+  the longest contents, longest first, or of every file if there are
+  fewer. The caller must free the DynArray_T with DynArray_free.
+  Returns SUCCESS if successful. Otherwise, sets *poDResult to NULL
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or the size index is not enabled
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_topKBySize(size_t ulK, DynArray_T *poDResult);
+
+/*
+  Like FT_topKBySize, but collects the files whose contents are
+  between ulMin and ulMax bytes long (inclusive), shortest first.
+*/
+int FT_filesInSizeRange(size_t ulMin, size_t ulMax,
+                        DynArray_T *poDResult);
+
+/*
+  Sets the metadata attribute named pcKey of the file or directory with
+  absolute path pcPath to *psValue, an integer or a string (which is
+  copied). Attributes are stored compactly with the node itself, and
+  are discarded when the node is removed.
+  Returns SUCCESS if the attribute is set. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setAttr(const char *pcPath, const char *pcKey,
+               const struct AttrValue *psValue);
+
+/*
+  Stores the metadata attribute named pcKey of the file or directory
+  with absolute path pcPath in *psValue. A string value is owned by
+  the FT and valid until the attribute changes.
+  Returns SUCCESS if the attribute is found. Otherwise, returns
+  NO_SUCH_PATH if the node has no such attribute, or any other status
+  FT_setAttr returns for pcPath.
+*/
+int FT_getAttr(const char *pcPath, const char *pcKey,
+               struct AttrValue *psValue);
+
+/*
+  Removes the metadata attribute named pcKey from the file or directory
+  with absolute path pcPath. Returns the same statuses as FT_getAttr.
+*/
+int FT_removeAttr(const char *pcPath, const char *pcKey);
+
+/*
+  Maintains a reverse hash index on attribute pcKey, covering the
+  values already in the FT, so that FT_findByAttr can answer lookups
+  by value without a scan. Indexing a key again has no effect, and
+  FT_destroy discards every index. Returns SUCCESS if the key is
+  indexed. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_indexAttr(const char *pcKey);
+
+/*
+  Sets *poDResult to a new DynArray_T holding the absolute pathnames
+  (owned by the FT, valid until the FT changes) of every file and
+  directory whose attribute pcKey equals *psValue, in no particular
+  order. The caller must free the DynArray_T with DynArray_free.
+  Returns SUCCESS if successful. Otherwise, sets *poDResult to NULL
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or pcKey is not indexed
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_findByAttr(const char *pcKey, const struct AttrValue *psValue,
+                  DynArray_T *poDResult);
+
+/*
+  Writes an image of the FT into the shared FT oSShm, created by this
+  process with FTShm_create, and makes it the image that reader
+  processes attached with FTShm_attach see. Changes made after the
+  call are not visible to readers until the next call. Returns SUCCESS
+  if published. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if the image does not fit in oSShm's slots
+*/
+int FT_publishShm(FTShm_T oSShm);
+
+/*
+  Freezes the FT into a read-only image in one block: a string pool of
+  every absolute pathname, laid out as the FT_toString text, a minimal
+  perfect hash from each pathname to a record for its directory or
+  file, and a copy of every file's contents. The tree itself is then
+  released as by FT_destroy. While the FT is frozen, FT_containsDir,
+  FT_containsFile, FT_stat and FT_getFileContents find a path with one
+  hash and one comparison, and FT_toString copies the stored text;
+  contents returned by FT_getFileContents lie in the image and must
+  not be modified. Every other function behaves as on an uninitialized
+  FT, and FT_destroy discards the image. Returns SUCCESS if frozen.
+  Otherwise, leaves the FT unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_freeze(void);
+
+/*
+  Writes the frozen FT's image to the file named pcFile, replacing it,
+  for FT_mapFrozen. Returns SUCCESS if written. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not frozen
+  * BAD_PATH if the file could not be written
+*/
+int FT_writeFrozen(const char *pcFile);
+
+/*
+  Puts the FT into the frozen state held in the file named pcFile by
+  FT_writeFrozen, mapping the file in place rather than reading it.
+  Returns SUCCESS if the FT is now frozen. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is initialized or already frozen,
+                         or the file does not hold a frozen FT
+  * NO_SUCH_PATH if there is no such file
+  * BAD_PATH if the file could not be mapped
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_mapFrozen(const char *pcFile);
+
+/*
+  Archives the shape of the FT, without file contents, in the compact
+  form of ftarchive.h: about 2 bits per directory or file for the tree,
+  a small fixed-width label each, and a front-coded dictionary of the
+  distinct path components. Paths can be looked up, directories listed
+  and the FT_toString text rebuilt from the archive alone. The FT is
+  left as it was. Sets *poAResult to the archive, owned by the caller,
+  and returns SUCCESS if archived. Otherwise, sets *poAResult to NULL
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_archive(FTArchive_T *poAResult);
+
+/*
+  Searches the contents of every file at or below absolute path pcPath
+  (a directory or a single file) for the ulPatternLength bytes at
+  pvPattern, which must be at least 1. uFlags is 0 or GREP_FIRST_ONLY
+  to report only the first occurrence in each file. Stores in
+  *ppsMatches a new array of the occurrences, which the caller must
+  free, and their number in *pulCount. Occurrences are ordered as
+  FT_toString orders files, then by offset; their pathnames are owned
+  by the FT and valid until the FT changes. Large searches run on
+  several threads. Returns SUCCESS if the search completes. Otherwise,
+  stores NULL and 0 and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_grep(const char *pcPath, const void *pvPattern,
+            size_t ulPatternLength, unsigned int uFlags,
+            struct FTMatch **ppsMatches, size_t *pulCount);
+
+/*
+  Enables the inverted index of file contents, indexing the files
+  already in the FT. A term is a run of ASCII letters and digits,
+  compared without regard to case. From then on the index is kept
+  current by FT_insertFile, FT_replaceFileContents, FT_rmFile and
+  FT_rmDir, until FT_destroy discards it. Enabling it again has no
+  effect. Returns SUCCESS if the index is enabled. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableTextIndex(void);
+
+/*
+  Sets *poDResult to a new DynArray_T holding the absolute pathnames
+  (owned by the FT, valid until the FT changes) of the files at or
+  below directory pcPath whose contents hold all (eMode TEXT_ALL) or
+  any (TEXT_ANY) of the ulNumTerms terms in ppcTerms, in the order
+  their contents were last set. A query term that is not a single term
+  matches nothing. The caller must free the DynArray_T with
+  DynArray_free.
+  Returns SUCCESS if successful. Otherwise, sets *poDResult to NULL
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or the text index is not enabled
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_searchText(const char *pcPath, const char **ppcTerms,
+                  size_t ulNumTerms, enum TextMode eMode,
+                  DynArray_T *poDResult);
+
+/*
+  A function that cache mode calls on each file it evicts, with the
+  file's absolute pathname, contents and length, and the pvExtra given
+  to FT_enableCache, so that the client can release the contents. The
+  pathname and (if held by the content store) contents are valid only
+  during the call, which must not call back into the FT.
+*/
+typedef void (*FTEvictFn)(const char *pcPath, void *pvContents,
+                          size_t ulLength, void *pvExtra);
+
+/*
+  Puts the FT in cache mode, holding at most ulMaxFiles files of at
+  most ulMaxBytes bytes of contents in total (0 for no limit on
+  either). FT_insertFile and FT_getFileContents mark a file as most
+  recently used, as does FT_replaceFileContents; whenever an insertion
+  or replacement passes a limit, least recently used files are removed
+  (never the file just used), each passed first to pfEvict (if not
+  NULL) along with pvExtra. If bPruneDirs is TRUE, directories other
+  than the root left empty by an eviction are removed as well. Files
+  already in the FT start out least recently used. Calling it again
+  changes the limits and callback and evicts to meet them; cache mode
+  lasts until FT_destroy. Returns SUCCESS if successful. Otherwise,
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableCache(size_t ulMaxFiles, size_t ulMaxBytes,
+                   boolean bPruneDirs, FTEvictFn pfEvict,
+                   void *pvExtra);
+
+/*
+  Enables expiry deadlines on files, with the current time ulNow in
+  whatever units the client uses for deadlines (seconds, say), which
+  must never move backwards. Enabling it again has no effect.
+  Returns SUCCESS if expiry is enabled. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableExpiry(unsigned long ulNow);
+
+/*
+  Sets the expiry deadline of the file with absolute path pcPath to
+  ulDeadline, replacing any it had, or clears it if ulDeadline is 0.
+  The deadline survives FT_replaceFileContents. Costs O(1) beyond
+  finding the file.
+  Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or expiry is not enabled
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if no file with absolute path pcPath exists in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setExpiry(const char *pcPath, unsigned long ulDeadline);
+
+/*
+  Moves the FT's time forward to ulNow and removes files whose deadline
+  is no later than ulNow, at most ulMaxFiles of them (0 for no limit)
+  so that a large backlog can be worked off in batches; the rest stay
+  due for later calls. Each removed file is first passed to pfExpired
+  (if not NULL) along with pvExtra, as cache mode passes evicted files.
+  Does not scan the tree: the cost is in the files removed. If
+  pulRemoved is not NULL, stores the number of files removed there.
+  Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or expiry is not enabled
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_expire(unsigned long ulNow, size_t ulMaxFiles,
+              FTEvictFn pfExpired, void *pvExtra, size_t *pulRemoved);
+
+/*
+  Turns on access heat tracking. From then on lookups and changes
+  through the FT_ functions count as accesses to the file or directory
+  they reach (removals to the parent); one access in 2^uSampleShift is
+  counted, to keep tracking cheap, and scaled back up when reported.
+  Counting is safe under a lock shared by readers. Enabling it again
+  has no effect; tracking lasts until FT_destroy. Returns SUCCESS if
+  successful, or INITIALIZATION_ERROR if the FT is not in an
+  initialized state.
+*/
+int FT_enableHeat(unsigned int uSampleShift);
+
+/*
+  Halves the heat of every file and directory, in O(1), so that heat
+  tracks recent access rates; call it periodically. Returns SUCCESS if
+  successful, or INITIALIZATION_ERROR if the FT is not in an
+  initialized state or heat tracking is off.
+*/
+int FT_decayHeat(void);
+
+/* A directory ranked by FT_hotSubtrees */
+struct FTHeat {
+   /* Absolute pathname of the directory, owned by the FT */
+   const char *pcPath;
+
+   /* Estimated decayed accesses to it and everything below it */
+   unsigned long ulHeat;
+};
+
+/*
+  Ranks the directories at depth ulDepth (the root is at depth 1; 0
+  for every depth, though then each directory ranks at least as high
+  as those below it) by the heat of their whole subtree. Stores in
+  *ppsHot a new array, which the caller must free, of the ulK hottest
+  (or all, if fewer), hottest first, and their number in *pulCount.
+  Pathnames are valid until the FT changes. Returns SUCCESS if
+  successful. Otherwise, stores NULL and 0 and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or heat tracking is off
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_hotSubtrees(size_t ulK, size_t ulDepth, struct FTHeat **ppsHot,
+                   size_t *pulCount);
+
+/*
+  Turns on content checksums: from then on each file records the
+  CRC-32C of its contents whenever they are set, by FT_insertFile or
+  FT_replaceFileContents, and files already in the FT are checksummed
+  now. Enabling it again has no effect; checksums last until
+  FT_destroy. Returns SUCCESS if successful, or INITIALIZATION_ERROR
+  if the FT is not in an initialized state.
+*/
+int FT_enableChecksums(void);
+
+/*
+  A function that FT_scrub calls on each file whose contents no longer
+  match their checksum, with the file's absolute pathname (valid only
+  during the call, which must not call back into the FT) and the
+  pvExtra given to FT_scrub.
+*/
+typedef void (*FTScrubFn)(const char *pcPath, void *pvExtra);
+
+/*
+  Verifies the next files of the FT, in pathname order, against their
+  checksums, passing each that fails to pfMismatch (if not NULL) along
+  with pvExtra. Stops once ulMaxBytes bytes of contents have been read
+  (always verifying at least one file, if there is one) or every file
+  has been verified once, so that repeated calls, from a background
+  thread say, sweep the whole tree a bounded piece at a time. Each call
+  resumes after the last file the previous one verified, wherever the
+  tree has changed since. Contents the client changed in place without
+  FT_replaceFileContents count as mismatches. If pulMismatches is not
+  NULL, stores the number of mismatches found there.
+  Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or checksums are off
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_scrub(size_t ulMaxBytes, FTScrubFn pfMismatch, void *pvExtra,
+             size_t *pulMismatches);
+
+/* A directory subtree taken out of the FT by FT_detachSubtree */
+typedef struct ftSubtree *FTSubtree_T;
+
+/*
+  How FT_graft settles a path held both by the FT and by the subtree
+  grafted into it, unless both hold a directory there, in which case
+  the two directories are merged
+*/
+enum FTConflict {
+   /* Fail with ALREADY_IN_TREE, changing nothing */
+   FT_CONFLICT_FAIL,
+
+   /* Keep the FT's file or directory, dropping the grafted one */
+   FT_CONFLICT_KEEP,
+
+   /* Replace the FT's file or directory with the grafted one */
+   FT_CONFLICT_REPLACE
+};
+
+/*
+  Moves the directory with absolute path pcPath (the root included),
+  and everything below it, out of the FT into a new subtree stored in
+  *poSResult, which keeps its nodes and their pathnames, contents and
+  attributes but leaves every index, the file cache and any expiry
+  deadlines. The subtree outlives FT_destroy, so that trees built one
+  after another in the FT can be combined; it must eventually be given
+  to FT_graft or FT_freeSubtree. Only the nodes below pcPath are
+  visited, and only if an index, cache mode or expiry is enabled.
+  Returns SUCCESS if successful. Otherwise, stores NULL in *poSResult
+  and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or keeps its contents in the content store
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if no directory with absolute path pcPath exists
+  * NOT_A_DIRECTORY if pcPath is the path of a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_detachSubtree(const char *pcPath, FTSubtree_T *poSResult);
+
+/*
+  Moves the nodes of oSSubtree into the FT at the same pathnames,
+  creating any missing directories above its top. Where the FT already
+  has a directory the subtree also has, the two are merged, walking
+  their sorted children side by side, and the FT's directory keeps its
+  attributes; other paths held by both are settled by eConflict. Files
+  and directories are moved, not copied, so the work is in the
+  directories held by both; files that are dropped or replaced are
+  passed first to pfDropped (if not NULL) along with pvExtra, as cache
+  mode passes evicted files. Moved files enter the enabled indexes and
+  the file cache, which may then evict. On success oSSubtree is
+  consumed; otherwise it is left as it was, and the FT too, except for
+  directories created above the subtree's top.
+  Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or keeps its contents in the content store
+  * CONFLICTING_PATH if the root's path is not a prefix of the
+                     subtree's path
+  * NOT_A_DIRECTORY if a proper prefix of the subtree's path is the
+                    path of a file in the FT
+  * ALREADY_IN_TREE if eConflict is FT_CONFLICT_FAIL and some path
+                    is held by both, other than by two directories
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_graft(FTSubtree_T oSSubtree, enum FTConflict eConflict,
+             FTEvictFn pfDropped, void *pvExtra);
+
+/*
+  Frees oSSubtree and every node in it, passing each file first to
+  pfDropped (if not NULL) along with pvExtra, so that the client can
+  release the contents.
+*/
+void FT_freeSubtree(FTSubtree_T oSSubtree, FTEvictFn pfDropped,
+                    void *pvExtra);
+
+/*
+  Inserts the ulCount files and directories of psEntries (see
+  bulkload.h), sorted by strcmp of their pathnames, into the FT, which
+  must be empty, building the same tree as FT_insertFile and
+  FT_insertDir would one entry after another. The entries are cut at
+  changes of top-level directory into runs, which up to ulThreads
+  threads (0 for one per processor, if there are enough entries)
+  build into subtrees at once, each allocating from a pool of its own
+  rather than from the FT's allocator; the subtrees are then grafted
+  under the root. Cache mode may evict files as FT_graft does.
+  Returns SUCCESS if successful. Otherwise, leaves the FT empty and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state, is
+                         not empty, or keeps its contents in the
+                         content store
+  * the status FT_insertFile or FT_insertDir would give an entry that
+    fails
+*/
+int FT_load(const struct FTLoadEntry *psEntries, size_t ulCount,
+            size_t ulThreads);
+
+/*
+  Replicates the directories of the top ulLevels levels of the FT on
+  each NUMA node (see numa.h), so that lookups from a thread find the
+  first ulLevels directories of their path in a hash table in memory
+  local to the thread's node, and in one probe per level, before going
+  on down the tree. The replicas are rebuilt, in time proportional to
+  the directories they cover, by each call that adds or removes one;
+  lookups made while a rebuild has run out of memory go without them.
+  A ulLevels of 0 turns replication off; FT_destroy turns it off too.
+  Returns SUCCESS if successful. Otherwise, leaves replication off and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableReplicas(size_t ulLevels);
+
 /*
   Sets the FT data structure to an initialized state.
-  The data structure is initially empty.
-  Returns INITIALIZATION_ERROR if already initialized,
+  The data structure is initially empty. Its nodes and their paths
+  are allocated from a size-class pool (see poolalloc.h), or from
+  malloc if the pool cannot be made.
+  Returns INITIALIZATION_ERROR if already initialized (or frozen),
   and SUCCESS otherwise.
 */
 int FT_init(void);
 
 /*
-  Removes all contents of the data structure and
+  Like FT_init, but allocates the nodes and their paths from
+  oAAllocator (NULL for malloc), which must stay valid until they are
+  all freed: by FT_destroy, or, for a detached subtree, by
+  FT_freeSubtree or the FT_destroy after it is grafted. Memory handed
+  to the client is always from malloc. Returns the same statuses as
+  FT_init.
+*/
+int FT_initWith(Alloc_T oAAllocator);
+
+/*
+  Removes all contents of the data structure (or its frozen image) and
   returns it to an uninitialized state.
-  Returns INITIALIZATION_ERROR if not already initialized,
+  Returns INITIALIZATION_ERROR if neither initialized nor frozen,
   and SUCCESS otherwise.
 */
 int FT_destroy(void);
 
+/*
+  Switches the FT to tiered content storage: from now on file contents
+  are copied in by FT_insertFile and FT_replaceFileContents and kept in
+  memory up to ulBudget bytes, with cold contents spilled to the file
+  at pcSpillPath and faulted back in by FT_getFileContents. The store
+  is released by FT_destroy. While it is in use, pointers returned by
+  FT_getFileContents and FT_getFileContentsMulti remain valid only
+  until the next FT call, and old contents returned by
+  FT_replaceFileContents only until its next call.
+  Returns SUCCESS if the store is set up. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state,
+                         is not empty, or already has a content store
+  * BAD_PATH if the spill file could not be created
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setContentBudget(size_t ulBudget, const char *pcSpillPath);
+
+/*
+  Stores the content store's hit, miss, spill and latency counters in
+  *psStats. Returns SUCCESS, or INITIALIZATION_ERROR if the FT is not
+  initialized or has no content store.
+*/
+int FT_getContentStats(struct CSStats *psStats);
+
+/*
+  Creates an iterator over the FT's directories and files in plain
+  lexicographic order of their absolute pathnames, starting at the
+  first entry whose pathname is not less than pcLo (or at the first
+  entry if pcLo is NULL). Advance it with FT_iterNext and release it
+  with FT_iterFree; any change to the FT invalidates it.
+  Returns SUCCESS and sets *poIResult if successful. Otherwise, sets
+  *poIResult to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_iterNew(const char *pcLo, OrderIter_T *poIResult);
+
+/*
+  Advances oIIter, storing the next pathname in *ppcPath (owned by the
+  FT) and whether it is a file in *pbIsFile. Returns SUCCESS if an
+  entry was produced, NO_SUCH_PATH if none are left, or MEMORY_ERROR.
+*/
+int FT_iterNext(OrderIter_T oIIter, const char **ppcPath,
+                boolean *pbIsFile);
+
+/* Destroys oIIter and frees all memory allocated for it. */
+void FT_iterFree(OrderIter_T oIIter);
+
+/*
+  Calls (*pfVisit)(pcPath, bIsFile, pvExtra) for every directory and
+  file whose absolute pathname is in the range [pcLo, pcHi), in plain
+  lexicographic order. pcLo may be NULL to start at the first entry
+  and pcHi may be NULL to continue to the last one. Seeks directly to
+  pcLo with a binary search per level rather than scanning from the
+  root. Returns SUCCESS if the whole range was visited. Otherwise,
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_scanRange(const char *pcLo, const char *pcHi,
+                 void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                                 void *pvExtra),
+                 void *pvExtra);
+
 /*
   Returns a string representation of the
   data structure, or NULL if the structure is
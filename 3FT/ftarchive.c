@@ -0,0 +1,1101 @@
+/*--------------------------------------------------------------------*/
+/* ftarchive.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* open, fstat and mmap are POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "path.h"
+#include "image.h"
+#include "nodef.h"
+#include "ftarchive.h"
+
+/* Identifies an archived FT */
+enum { FTARCHIVE_MAGIC = 0x46544152 };
+
+/* Alignment of every region in an archive */
+enum { FTARCHIVE_ALIGN = sizeof(unsigned long) };
+
+/* Bits in a word of a bit string */
+enum { FTARCHIVE_WORD_BITS = CHAR_BIT * sizeof(unsigned long) };
+
+/* Every FTARCHIVE_SAMPLE-th 0 of the LOUDS string has its position
+   stored, so select needs only a short scan */
+enum { FTARCHIVE_SAMPLE = 256 };
+
+/* Components per front-coded block of the dictionary: the first is
+   stored whole, the rest as the length of the prefix they share with
+   the one before (at most UCHAR_MAX) and the rest of the component */
+enum { FTARCHIVE_BLOCK = 16 };
+
+/* Longest component lookups decode without allocating */
+enum { FTARCHIVE_SHORT_COMPONENT = 256 };
+
+/*
+  The start of an archive. Offsets in an archive are from here.
+
+  Nodes are numbered in level order from 0 at the root, the children
+  of each directory in increasing order of their components. Node k
+  contributes one 1 per child and then a 0 to the LOUDS string, so
+  node k's 1s start just after the k-th 0 (counting from 1), and its
+  first child is the node numbered one more than the 1s before them.
+*/
+struct archiveHeader {
+   /* FTARCHIVE_MAGIC */
+   unsigned long ulMagic;
+
+   /* sizeof(unsigned long) where the archive was built */
+   unsigned long ulWordSize;
+
+   /* Bytes in the archive */
+   unsigned long ulSize;
+
+   /* Directories and files archived */
+   unsigned long ulNumNodes;
+
+   /* Offset and length in bits of the LOUDS string; bits after the
+      end of the string up to the end of its last word are 1 */
+   unsigned long ulLoudsOff;
+   unsigned long ulLoudsBits;
+
+   /* Offset and length of the array of positions of every
+      FTARCHIVE_SAMPLE-th 0 of the LOUDS string */
+   unsigned long ulSamplesOff;
+   unsigned long ulNumSamples;
+
+   /* Offset of the bit string with a 1 for each node that is a file */
+   unsigned long ulIsFileOff;
+
+   /* Offset of each node's label, its component's number in the
+      dictionary, packed in ulLabelWidth bits */
+   unsigned long ulLabelsOff;
+   unsigned long ulLabelWidth;
+
+   /* Distinct components in the dictionary and the longest one */
+   unsigned long ulNumLabels;
+   unsigned long ulMaxComponent;
+
+   /* Offset and length of the array of offsets of each dictionary
+      block from the start of the dictionary */
+   unsigned long ulBlocksOff;
+   unsigned long ulNumBlocks;
+
+   /* Offset and length of the dictionary, which ends with a '\0' */
+   unsigned long ulDictOff;
+   unsigned long ulDictLen;
+};
+
+/* An archive */
+struct ftArchive {
+   /* Start of the archive */
+   char *pcBase;
+
+   /* Bytes in the archive */
+   size_t ulSize;
+
+   /* Whether the archive is mapped from a file rather than allocated */
+   boolean bIsMapped;
+
+   /* The header's regions, found once */
+   const struct archiveHeader *psHeader;
+   const unsigned long *pulLouds;
+   const unsigned long *pulSamples;
+   const unsigned long *pulIsFile;
+   const unsigned long *pulLabels;
+   const unsigned long *pulBlocks;
+   const char *pcDict;
+};
+
+/* A node while an archive is built */
+struct archiveNode {
+   /* Its last component, inside its pathname */
+   const char *pcComponent;
+
+   /* The directory, or NULL for a file */
+   NodeD_T oNdDir;
+};
+
+/* Text that grows as it is written */
+struct archiveText {
+   char *pcText;
+   size_t ulLength;
+   size_t ulCapacity;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns ulSize rounded up to a multiple of FTARCHIVE_ALIGN. */
+static size_t FTArchive_align(size_t ulSize) {
+   return (ulSize + FTARCHIVE_ALIGN - 1) / FTARCHIVE_ALIGN *
+          FTARCHIVE_ALIGN;
+}
+
+/* Returns the bytes of the words holding a string of ulBits bits. */
+static size_t FTArchive_wordBytes(size_t ulBits) {
+   return (ulBits + FTARCHIVE_WORD_BITS - 1) / FTARCHIVE_WORD_BITS *
+          sizeof(unsigned long);
+}
+
+/* Returns the number of 1 bits in ulWord. */
+static size_t FTArchive_popcount(unsigned long ulWord) {
+#if defined(__GNUC__)
+   return (size_t) __builtin_popcountl(ulWord);
+#else
+   size_t ulCount = 0;
+
+   while(ulWord != 0) {
+      ulWord &= ulWord - 1;
+      ulCount++;
+   }
+   return ulCount;
+#endif
+}
+
+/* Returns the position of the lowest 1 bit in ulWord, which is not
+   0. */
+static size_t FTArchive_lowestBit(unsigned long ulWord) {
+#if defined(__GNUC__)
+   return (size_t) __builtin_ctzl(ulWord);
+#else
+   size_t ulBit = 0;
+
+   while((ulWord & 1UL) == 0) {
+      ulWord >>= 1;
+      ulBit++;
+   }
+   return ulBit;
+#endif
+}
+
+/* Returns bit ulBit of the bit string pulBits. */
+static boolean FTArchive_getBit(const unsigned long *pulBits,
+                                size_t ulBit) {
+   return (boolean) ((pulBits[ulBit / FTARCHIVE_WORD_BITS] >>
+                      (ulBit % FTARCHIVE_WORD_BITS)) & 1UL);
+}
+
+/* Sets bit ulBit of the bit string pulBits. */
+static void FTArchive_setBit(unsigned long *pulBits, size_t ulBit) {
+   pulBits[ulBit / FTARCHIVE_WORD_BITS] |=
+      1UL << (ulBit % FTARCHIVE_WORD_BITS);
+}
+
+/* Returns a mask of the low ulWidth bits of a word. */
+static unsigned long FTArchive_mask(size_t ulWidth) {
+   return ulWidth == FTARCHIVE_WORD_BITS ? ~0UL : (1UL << ulWidth) - 1;
+}
+
+/* Returns the ulIndex-th field of ulWidth bits packed in pulBits. */
+static unsigned long FTArchive_getField(const unsigned long *pulBits,
+                                        size_t ulIndex, size_t ulWidth) {
+   size_t ulBit = ulIndex * ulWidth;
+   size_t ulWord = ulBit / FTARCHIVE_WORD_BITS;
+   size_t ulShift = ulBit % FTARCHIVE_WORD_BITS;
+   unsigned long ulValue;
+
+   ulValue = pulBits[ulWord] >> ulShift;
+   if(ulShift + ulWidth > FTARCHIVE_WORD_BITS)
+      ulValue |= pulBits[ulWord + 1] << (FTARCHIVE_WORD_BITS - ulShift);
+   return ulValue & FTArchive_mask(ulWidth);
+}
+
+/* Stores ulValue as the ulIndex-th field of ulWidth bits packed in
+   pulBits, which are 0 there. */
+static void FTArchive_setField(unsigned long *pulBits, size_t ulIndex,
+                               size_t ulWidth, unsigned long ulValue) {
+   size_t ulBit = ulIndex * ulWidth;
+   size_t ulWord = ulBit / FTARCHIVE_WORD_BITS;
+   size_t ulShift = ulBit % FTARCHIVE_WORD_BITS;
+
+   pulBits[ulWord] |= ulValue << ulShift;
+   if(ulShift + ulWidth > FTARCHIVE_WORD_BITS)
+      pulBits[ulWord + 1] |= ulValue >> (FTARCHIVE_WORD_BITS - ulShift);
+}
+
+/* Returns the position of the first 0 at or after position ulPos of
+   oAArchive's LOUDS string, which has one. */
+static size_t FTArchive_nextZero(FTArchive_T oAArchive, size_t ulPos) {
+   size_t ulWord = ulPos / FTARCHIVE_WORD_BITS;
+   unsigned long ulZeros;
+
+   ulZeros = ~oAArchive->pulLouds[ulWord] &
+             (~0UL << (ulPos % FTARCHIVE_WORD_BITS));
+   while(ulZeros == 0)
+      ulZeros = ~oAArchive->pulLouds[++ulWord];
+   return ulWord * FTARCHIVE_WORD_BITS + FTArchive_lowestBit(ulZeros);
+}
+
+/* Returns the position of the ulRank-th 0 (counting from 0) of
+   oAArchive's LOUDS string, which has one: the nearest sample before
+   it, then a word at a time. */
+static size_t FTArchive_selectZero(FTArchive_T oAArchive, size_t ulRank) {
+   size_t ulPos, ulWord, ulCount;
+   unsigned long ulZeros;
+
+   ulPos = oAArchive->pulSamples[ulRank / FTARCHIVE_SAMPLE];
+   ulRank %= FTARCHIVE_SAMPLE;
+   ulWord = ulPos / FTARCHIVE_WORD_BITS;
+   ulZeros = ~oAArchive->pulLouds[ulWord] &
+             (~0UL << (ulPos % FTARCHIVE_WORD_BITS));
+   for(;;) {
+      ulCount = FTArchive_popcount(ulZeros);
+      if(ulRank < ulCount)
+         break;
+      ulRank -= ulCount;
+      ulZeros = ~oAArchive->pulLouds[++ulWord];
+   }
+   while(ulRank-- > 0)
+      ulZeros &= ulZeros - 1;
+   return ulWord * FTARCHIVE_WORD_BITS + FTArchive_lowestBit(ulZeros);
+}
+
+/* Stores in *pulFirst the number of the first child of node ulNode of
+   oAArchive and returns how many children it has. */
+static size_t FTArchive_children(FTArchive_T oAArchive, size_t ulNode,
+                                 size_t *pulFirst) {
+   size_t ulStart;
+
+   ulStart = (ulNode == 0) ? 0 :
+             FTArchive_selectZero(oAArchive, ulNode - 1) + 1;
+   *pulFirst = ulStart - ulNode + 1;
+   return FTArchive_nextZero(oAArchive, ulStart) - ulStart;
+}
+
+/* Returns whether node ulNode of oAArchive is a file. */
+static boolean FTArchive_isFile(FTArchive_T oAArchive, size_t ulNode) {
+   return FTArchive_getBit(oAArchive->pulIsFile, ulNode);
+}
+
+/* Returns the label of node ulNode of oAArchive. */
+static size_t FTArchive_label(FTArchive_T oAArchive, size_t ulNode) {
+   return (size_t) FTArchive_getField(oAArchive->pulLabels, ulNode,
+                                      oAArchive->psHeader->ulLabelWidth);
+}
+
+/* Decodes component ulLabel of oAArchive's dictionary into pcBuffer,
+   which holds ulMaxComponent + 1 characters. */
+static void FTArchive_getComponent(FTArchive_T oAArchive, size_t ulLabel,
+                                   char *pcBuffer) {
+   const char *pcEntry;
+   size_t i;
+
+   pcEntry = oAArchive->pcDict +
+             oAArchive->pulBlocks[ulLabel / FTARCHIVE_BLOCK];
+   strcpy(pcBuffer, pcEntry);
+   pcEntry += strlen(pcEntry) + 1;
+   for(i = 0; i < ulLabel % FTARCHIVE_BLOCK; i++) {
+      strcpy(pcBuffer + (unsigned char) pcEntry[0], pcEntry + 1);
+      pcEntry += strlen(pcEntry + 1) + 2;
+   }
+}
+
+/* Compares the string pcEntry to the ulKeyLength characters at pcKey,
+   as strcmp would. */
+static int FTArchive_compare(const char *pcEntry, const char *pcKey,
+                             size_t ulKeyLength) {
+   int iResult;
+
+   iResult = strncmp(pcEntry, pcKey, ulKeyLength);
+   if(iResult != 0)
+      return iResult;
+   return pcEntry[ulKeyLength] != '\0';
+}
+
+/* Stores in *pulLabel the label of the ulLength characters at pcKey,
+   decoding into pcBuffer, which holds ulMaxComponent + 1 characters.
+   Returns FALSE if no node has that component: the last block whose
+   first component is not after it is found by binary search, then
+   decoded in order. */
+static boolean FTArchive_findLabel(FTArchive_T oAArchive,
+                                   const char *pcKey, size_t ulLength,
+                                   char *pcBuffer, size_t *pulLabel) {
+   const struct archiveHeader *psHeader = oAArchive->psHeader;
+   const char *pcEntry;
+   size_t ulLow = 0, ulHigh, ulMid, ulLabel;
+   int iResult;
+
+   if(ulLength > psHeader->ulMaxComponent)
+      return FALSE;
+
+   ulHigh = psHeader->ulNumBlocks;
+   while(ulHigh - ulLow > 1) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      if(FTArchive_compare(oAArchive->pcDict +
+                           oAArchive->pulBlocks[ulMid],
+                           pcKey, ulLength) <= 0)
+         ulLow = ulMid;
+      else
+         ulHigh = ulMid;
+   }
+
+   ulLabel = ulLow * FTARCHIVE_BLOCK;
+   pcEntry = oAArchive->pcDict + oAArchive->pulBlocks[ulLow];
+   strcpy(pcBuffer, pcEntry);
+   pcEntry += strlen(pcEntry) + 1;
+   for(;;) {
+      iResult = FTArchive_compare(pcBuffer, pcKey, ulLength);
+      if(iResult == 0) {
+         *pulLabel = ulLabel;
+         return TRUE;
+      }
+      ulLabel++;
+      if(iResult > 0 || ulLabel % FTARCHIVE_BLOCK == 0 ||
+         ulLabel == psHeader->ulNumLabels)
+         return FALSE;
+      strcpy(pcBuffer + (unsigned char) pcEntry[0], pcEntry + 1);
+      pcEntry += strlen(pcEntry + 1) + 2;
+   }
+}
+
+/* Stores in *pulChild the child of node ulNode of oAArchive with label
+   ulLabel, by binary search of its children, which are in label order.
+   Returns FALSE if there is none. */
+static boolean FTArchive_findChild(FTArchive_T oAArchive, size_t ulNode,
+                                   size_t ulLabel, size_t *pulChild) {
+   size_t ulLow, ulHigh, ulMid, ulMidLabel;
+
+   ulHigh = FTArchive_children(oAArchive, ulNode, &ulLow);
+   ulHigh += ulLow;
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      ulMidLabel = FTArchive_label(oAArchive, ulMid);
+      if(ulMidLabel == ulLabel) {
+         *pulChild = ulMid;
+         return TRUE;
+      }
+      if(ulMidLabel < ulLabel)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   return FALSE;
+}
+
+/* Walks oAArchive from the root along the components of pcPath,
+   decoding into pcBuffer, which holds ulMaxComponent + 1 characters,
+   and stores the node reached in *pulNode. Returns SUCCESS, BAD_PATH,
+   CONFLICTING_PATH or NO_SUCH_PATH. */
+static int FTArchive_find(FTArchive_T oAArchive, const char *pcPath,
+                          char *pcBuffer, size_t *pulNode) {
+   size_t ulNode = 0, ulLength, ulLabel;
+
+   if(!Image_isWellFormed(pcPath))
+      return BAD_PATH;
+   if(oAArchive->psHeader->ulNumNodes == 0)
+      return NO_SUCH_PATH;
+
+   /* The root must be the first component */
+   ulLength = strcspn(pcPath, "/");
+   FTArchive_getComponent(oAArchive, FTArchive_label(oAArchive, 0),
+                          pcBuffer);
+   if(FTArchive_compare(pcBuffer, pcPath, ulLength) != 0)
+      return CONFLICTING_PATH;
+
+   for(pcPath += ulLength; *pcPath == '/'; pcPath += ulLength) {
+      pcPath++;
+      ulLength = strcspn(pcPath, "/");
+      if(FTArchive_isFile(oAArchive, ulNode) ||
+         !FTArchive_findLabel(oAArchive, pcPath, ulLength, pcBuffer,
+                              &ulLabel) ||
+         !FTArchive_findChild(oAArchive, ulNode, ulLabel, &ulNode))
+         return NO_SUCH_PATH;
+   }
+   *pulNode = ulNode;
+   return SUCCESS;
+}
+
+/* Appends the ulLength characters at pcAdd to psText. Returns FALSE if
+   there is an allocation error. */
+static boolean FTArchive_append(struct archiveText *psText,
+                                const char *pcAdd, size_t ulLength) {
+   size_t ulCapacity;
+   char *pcText;
+
+   if(psText->ulLength + ulLength + 1 > psText->ulCapacity) {
+      ulCapacity = 2 * psText->ulCapacity;
+      if(ulCapacity < psText->ulLength + ulLength + 1)
+         ulCapacity = psText->ulLength + ulLength + 1;
+      pcText = realloc(psText->pcText, ulCapacity);
+      if(pcText == NULL)
+         return FALSE;
+      psText->pcText = pcText;
+      psText->ulCapacity = ulCapacity;
+   }
+   memcpy(psText->pcText + psText->ulLength, pcAdd, ulLength);
+   psText->ulLength += ulLength;
+   psText->pcText[psText->ulLength] = '\0';
+   return TRUE;
+}
+
+/* Appends to psText a line for the child with label ulLabel of the
+   directory whose pathname is the ulPathLen characters at pcPath,
+   decoding into pcBuffer. Returns FALSE if there is an allocation
+   error. */
+static boolean FTArchive_appendChild(FTArchive_T oAArchive,
+                                     struct archiveText *psText,
+                                     const char *pcPath, size_t ulPathLen,
+                                     size_t ulLabel, char *pcBuffer) {
+   FTArchive_getComponent(oAArchive, ulLabel, pcBuffer);
+   return (boolean) (FTArchive_append(psText, pcPath, ulPathLen) &&
+                     FTArchive_append(psText, "/", 1) &&
+                     FTArchive_append(psText, pcBuffer,
+                                      strlen(pcBuffer)) &&
+                     FTArchive_append(psText, "\n", 1));
+}
+
+/* Appends to psText a line for each child of directory ulNode of
+   oAArchive, whose pathname is in psPath: its files, then, if
+   bRecurse, the FT_toString text of each subdirectory, and otherwise a
+   line for each subdirectory. Returns FALSE if there is an allocation
+   error. */
+static boolean FTArchive_listChildren(FTArchive_T oAArchive,
+                                      size_t ulNode,
+                                      struct archiveText *psPath,
+                                      struct archiveText *psText,
+                                      boolean bRecurse, char *pcBuffer) {
+   size_t ulFirst, ulNumChildren, ulPathLen, i;
+
+   ulNumChildren = FTArchive_children(oAArchive, ulNode, &ulFirst);
+   for(i = ulFirst; i < ulFirst + ulNumChildren; i++)
+      if(FTArchive_isFile(oAArchive, i) &&
+         !FTArchive_appendChild(oAArchive, psText, psPath->pcText,
+                                psPath->ulLength,
+                                FTArchive_label(oAArchive, i), pcBuffer))
+         return FALSE;
+
+   ulPathLen = psPath->ulLength;
+   for(i = ulFirst; i < ulFirst + ulNumChildren; i++) {
+      if(FTArchive_isFile(oAArchive, i))
+         continue;
+      if(!bRecurse) {
+         if(!FTArchive_appendChild(oAArchive, psText, psPath->pcText,
+                                   ulPathLen,
+                                   FTArchive_label(oAArchive, i),
+                                   pcBuffer))
+            return FALSE;
+         continue;
+      }
+      /* Extend the path by the subdirectory's component, list it and
+         what is below it, then cut the path back */
+      FTArchive_getComponent(oAArchive, FTArchive_label(oAArchive, i),
+                             pcBuffer);
+      if(!FTArchive_append(psPath, "/", 1) ||
+         !FTArchive_append(psPath, pcBuffer, strlen(pcBuffer)) ||
+         !FTArchive_append(psText, psPath->pcText, psPath->ulLength) ||
+         !FTArchive_append(psText, "\n", 1) ||
+         !FTArchive_listChildren(oAArchive, i, psPath, psText, TRUE,
+                                 pcBuffer))
+         return FALSE;
+      psPath->ulLength = ulPathLen;
+      psPath->pcText[ulPathLen] = '\0';
+   }
+   return TRUE;
+}
+
+/* Counts the nodes of the subtree rooted at oNdNode. */
+static size_t FTArchive_count(NodeD_T oNdNode) {
+   NodeD_T oNdChild;
+   size_t ulCount, i;
+
+   assert(oNdNode != NULL);
+
+   ulCount = 1 + NodeD_getNumFileChildren(oNdNode);
+   for(i = 0; i < NodeD_getNumDirChildren(oNdNode); i++) {
+      (void) NodeD_getDirChild(oNdNode, i, &oNdChild);
+      ulCount += FTArchive_count(oNdChild);
+   }
+   return ulCount;
+}
+
+/* Returns the last component of pathname oPPath, inside it. */
+static const char *FTArchive_lastComponent(Path_T oPPath) {
+   const char *pcSlash;
+
+   pcSlash = strrchr(Path_getPathname(oPPath), '/');
+   return pcSlash == NULL ? Path_getPathname(oPPath) : pcSlash + 1;
+}
+
+/* Orders struct archiveNodes by component, for qsort. */
+static int FTArchive_compareNodes(const void *pvFirst,
+                                  const void *pvSecond) {
+   return strcmp(((const struct archiveNode *) pvFirst)->pcComponent,
+                 ((const struct archiveNode *) pvSecond)->pcComponent);
+}
+
+/* Orders pointers to strings by the strings, for qsort and bsearch. */
+static int FTArchive_compareStrings(const void *pvFirst,
+                                    const void *pvSecond) {
+   return strcmp(*(const char *const *) pvFirst,
+                 *(const char *const *) pvSecond);
+}
+
+/* Returns the length of the common prefix of pcFirst and pcSecond. */
+static size_t FTArchive_commonPrefix(const char *pcFirst,
+                                     const char *pcSecond) {
+   size_t ulLength = 0;
+
+   while(pcFirst[ulLength] != '\0' &&
+         pcFirst[ulLength] == pcSecond[ulLength])
+      ulLength++;
+   return ulLength;
+}
+
+/* Returns the bytes ppcComponents[ulIndex] takes in the dictionary. */
+static size_t FTArchive_entryLength(const char **ppcComponents,
+                                    size_t ulIndex, size_t *pulShared) {
+   size_t ulShared = 0;
+
+   if(ulIndex % FTARCHIVE_BLOCK != 0) {
+      ulShared = FTArchive_commonPrefix(ppcComponents[ulIndex - 1],
+                                        ppcComponents[ulIndex]);
+      if(ulShared > UCHAR_MAX)
+         ulShared = UCHAR_MAX;
+   }
+   *pulShared = ulShared;
+   return strlen(ppcComponents[ulIndex]) - ulShared + 1 +
+          (ulIndex % FTARCHIVE_BLOCK != 0);
+}
+
+/* Sets oAArchive's pointers to the regions of its header. */
+static void FTArchive_locate(FTArchive_T oAArchive) {
+   const struct archiveHeader *psHeader;
+
+   psHeader = (const struct archiveHeader *) (void *) oAArchive->pcBase;
+   oAArchive->psHeader = psHeader;
+   oAArchive->pulLouds = (const unsigned long *) (void *)
+                         (oAArchive->pcBase + psHeader->ulLoudsOff);
+   oAArchive->pulSamples = (const unsigned long *) (void *)
+                           (oAArchive->pcBase + psHeader->ulSamplesOff);
+   oAArchive->pulIsFile = (const unsigned long *) (void *)
+                          (oAArchive->pcBase + psHeader->ulIsFileOff);
+   oAArchive->pulLabels = (const unsigned long *) (void *)
+                          (oAArchive->pcBase + psHeader->ulLabelsOff);
+   oAArchive->pulBlocks = (const unsigned long *) (void *)
+                          (oAArchive->pcBase + psHeader->ulBlocksOff);
+   oAArchive->pcDict = oAArchive->pcBase + psHeader->ulDictOff;
+}
+
+/* Returns TRUE if the ulCount elements of ulElemSize bytes at offset
+   ulOff lie within an archive of ulSize bytes and are aligned. */
+static boolean FTArchive_fits(size_t ulSize, unsigned long ulOff,
+                              unsigned long ulCount, size_t ulElemSize) {
+   return (boolean) (ulOff % FTARCHIVE_ALIGN == 0 &&
+                     Image_fits(ulSize, ulOff, ulCount, ulElemSize));
+}
+
+/*
+  Returns TRUE if the mapped archive oAArchive is whole: its regions
+  fit, every node but the root hangs below an earlier one, files have
+  no children, the samples are right, every label names a component,
+  and the dictionary decodes to components of which the longest is
+  ulMaxComponent characters. Lookups then need no checks of their own.
+*/
+static boolean FTArchive_isValid(FTArchive_T oAArchive) {
+   const struct archiveHeader *psHeader;
+   size_t ulSize = oAArchive->ulSize;
+   size_t ulNodes, ulWords, ulZeros = 0, ulOnes = 0, ulPos, ulShared;
+   size_t ulLength, ulLongest, i;
+   const char *pcEntry;
+   const char *pcEnd;
+
+   psHeader = (const struct archiveHeader *) (void *) oAArchive->pcBase;
+   ulNodes = psHeader->ulNumNodes;
+   if(psHeader->ulMagic != FTARCHIVE_MAGIC ||
+      psHeader->ulWordSize != sizeof(unsigned long) ||
+      psHeader->ulSize != ulSize || ulNodes > ulSize ||
+      psHeader->ulLoudsBits != (ulNodes == 0 ? 0 : 2 * ulNodes - 1) ||
+      psHeader->ulNumSamples !=
+         (ulNodes + FTARCHIVE_SAMPLE - 1) / FTARCHIVE_SAMPLE ||
+      psHeader->ulLabelWidth == 0 ||
+      psHeader->ulLabelWidth > FTARCHIVE_WORD_BITS ||
+      psHeader->ulNumBlocks !=
+         (psHeader->ulNumLabels + FTARCHIVE_BLOCK - 1) / FTARCHIVE_BLOCK)
+      return FALSE;
+
+   ulWords = FTArchive_wordBytes(psHeader->ulLoudsBits) /
+             sizeof(unsigned long);
+   if(!FTArchive_fits(ulSize, psHeader->ulLoudsOff, ulWords,
+                      sizeof(unsigned long)) ||
+      !FTArchive_fits(ulSize, psHeader->ulSamplesOff,
+                      psHeader->ulNumSamples, sizeof(unsigned long)) ||
+      !FTArchive_fits(ulSize, psHeader->ulIsFileOff,
+                      FTArchive_wordBytes(ulNodes), 1) ||
+      !FTArchive_fits(ulSize, psHeader->ulLabelsOff,
+                      FTArchive_wordBytes(ulNodes *
+                                          psHeader->ulLabelWidth), 1) ||
+      !FTArchive_fits(ulSize, psHeader->ulBlocksOff,
+                      psHeader->ulNumBlocks, sizeof(unsigned long)) ||
+      !FTArchive_fits(ulSize, psHeader->ulDictOff, psHeader->ulDictLen,
+                      1) ||
+      psHeader->ulDictLen == 0 ||
+      oAArchive->pcBase[psHeader->ulDictOff + psHeader->ulDictLen - 1]
+         != '\0')
+      return FALSE;
+   FTArchive_locate(oAArchive);
+
+   /* The LOUDS string, a bit at a time */
+   for(ulPos = 0; ulPos < ulWords * FTARCHIVE_WORD_BITS; ulPos++) {
+      if(FTArchive_getBit(oAArchive->pulLouds, ulPos)) {
+         /* A 1 gives node ulOnes + 1 to node ulZeros as a child */
+         if(ulPos < psHeader->ulLoudsBits &&
+            (ulOnes + 1 >= ulNodes || ulZeros > ulOnes ||
+             FTArchive_isFile(oAArchive, ulZeros)))
+            return FALSE;
+         ulOnes += (ulPos < psHeader->ulLoudsBits);
+         continue;
+      }
+      if(ulPos >= psHeader->ulLoudsBits || ulZeros >= ulNodes ||
+         (ulZeros % FTARCHIVE_SAMPLE == 0 &&
+          oAArchive->pulSamples[ulZeros / FTARCHIVE_SAMPLE] != ulPos))
+         return FALSE;
+      ulZeros++;
+   }
+   if(ulZeros != ulNodes || (ulNodes != 0 && ulOnes != ulNodes - 1) ||
+      (ulNodes != 0 && FTArchive_isFile(oAArchive, 0)))
+      return FALSE;
+
+   for(i = 0; i < ulNodes; i++)
+      if(FTArchive_label(oAArchive, i) >= psHeader->ulNumLabels)
+         return FALSE;
+
+   /* Each block starts where the last one ended, and no entry reaches
+      past the prefix it shares or ulMaxComponent */
+   pcEntry = oAArchive->pcDict;
+   pcEnd = oAArchive->pcDict + psHeader->ulDictLen - 1;
+   ulLength = 0;
+   ulLongest = 0;
+   for(i = 0; i < psHeader->ulNumLabels; i++) {
+      if(pcEntry >= pcEnd)
+         return FALSE;
+      if(i % FTARCHIVE_BLOCK == 0) {
+         if(oAArchive->pulBlocks[i / FTARCHIVE_BLOCK] !=
+            (unsigned long) (pcEntry - oAArchive->pcDict))
+            return FALSE;
+         ulShared = 0;
+      }
+      else {
+         ulShared = (unsigned char) *pcEntry++;
+         if(ulShared > ulLength)
+            return FALSE;
+      }
+      ulLength = ulShared + strlen(pcEntry);
+      if(ulLength > ulLongest)
+         ulLongest = ulLength;
+      pcEntry += strlen(pcEntry) + 1;
+   }
+   return (boolean) (pcEntry == pcEnd &&
+                     ulLongest == psHeader->ulMaxComponent);
+}
+
+/* ================================================================== */
+int FTArchive_build(NodeD_T oNdRoot, FTArchive_T *poAResult) {
+   FTArchive_T oAArchive;
+   struct archiveHeader *psHeader;
+   struct archiveNode *psNodes;
+   const char **ppcComponents;
+   const char **ppcFound;
+   unsigned long *pulLouds;
+   unsigned long *pulBlocks;
+   NodeF_T oNfChild;
+   NodeD_T oNdChild;
+   char *pcBase;
+   char *pcDict;
+   size_t ulNodes = 0, ulTail, ulLabels = 0, ulMaxComponent = 0;
+   size_t ulWidth = 1, ulDictLen = 1, ulBit = 0, ulZeros = 0;
+   size_t ulLoudsBits, ulNumSamples, ulNumBlocks, ulShared, ulLength;
+   size_t ulSamplesOff, ulIsFileOff, ulLabelsOff, ulBlocksOff;
+   size_t ulLoudsOff, ulDictOff, ulSize, i, j;
+
+   assert(poAResult != NULL);
+
+   *poAResult = NULL;
+   if(oNdRoot != NULL)
+      ulNodes = FTArchive_count(oNdRoot);
+
+   oAArchive = malloc(sizeof(struct ftArchive));
+   psNodes = malloc(ulNodes * sizeof(struct archiveNode) + 1);
+   ppcComponents = malloc(ulNodes * sizeof(const char *) + 1);
+   if(oAArchive == NULL || psNodes == NULL || ppcComponents == NULL) {
+      free(oAArchive);
+      free(psNodes);
+      free(ppcComponents);
+      return MEMORY_ERROR;
+   }
+
+   /* Number the nodes in level order, each directory's children in
+      order of their components */
+   if(oNdRoot != NULL) {
+      psNodes[0].pcComponent =
+         FTArchive_lastComponent(NodeD_getPath(oNdRoot));
+      psNodes[0].oNdDir = oNdRoot;
+   }
+   ulTail = (oNdRoot != NULL);
+   for(i = 0; i < ulTail; i++) {
+      if(psNodes[i].oNdDir == NULL)
+         continue;
+      j = ulTail;
+      for(ulLength = 0;
+          ulLength < NodeD_getNumFileChildren(psNodes[i].oNdDir);
+          ulLength++) {
+         (void) NodeD_getFileChild(psNodes[i].oNdDir, ulLength,
+                                   &oNfChild);
+         psNodes[ulTail].pcComponent =
+            FTArchive_lastComponent(NodeF_getPath(oNfChild));
+         psNodes[ulTail++].oNdDir = NULL;
+      }
+      for(ulLength = 0;
+          ulLength < NodeD_getNumDirChildren(psNodes[i].oNdDir);
+          ulLength++) {
+         (void) NodeD_getDirChild(psNodes[i].oNdDir, ulLength,
+                                  &oNdChild);
+         psNodes[ulTail].pcComponent =
+            FTArchive_lastComponent(NodeD_getPath(oNdChild));
+         psNodes[ulTail++].oNdDir = oNdChild;
+      }
+      qsort(psNodes + j, ulTail - j, sizeof(struct archiveNode),
+            FTArchive_compareNodes);
+   }
+   assert(ulTail == ulNodes);
+
+   /* The dictionary holds the distinct components in order */
+   for(i = 0; i < ulNodes; i++)
+      ppcComponents[i] = psNodes[i].pcComponent;
+   qsort(ppcComponents, ulNodes, sizeof(const char *),
+         FTArchive_compareStrings);
+   for(i = 0; i < ulNodes; i++) {
+      if(ulLabels != 0 &&
+         strcmp(ppcComponents[ulLabels - 1], ppcComponents[i]) == 0)
+         continue;
+      ppcComponents[ulLabels] = ppcComponents[i];
+      ulLength = strlen(ppcComponents[i]);
+      if(ulLength > ulMaxComponent)
+         ulMaxComponent = ulLength;
+      ulDictLen += FTArchive_entryLength(ppcComponents, ulLabels,
+                                         &ulShared);
+      ulLabels++;
+   }
+   while(ulWidth < FTARCHIVE_WORD_BITS && (1UL << ulWidth) < ulLabels)
+      ulWidth++;
+
+   /* Header, LOUDS string, samples, file bits, labels, block offsets,
+      dictionary */
+   ulLoudsBits = (ulNodes == 0) ? 0 : 2 * ulNodes - 1;
+   ulNumSamples = (ulNodes + FTARCHIVE_SAMPLE - 1) / FTARCHIVE_SAMPLE;
+   ulNumBlocks = (ulLabels + FTARCHIVE_BLOCK - 1) / FTARCHIVE_BLOCK;
+   ulLoudsOff = FTArchive_align(sizeof(struct archiveHeader));
+   ulSamplesOff = ulLoudsOff + FTArchive_wordBytes(ulLoudsBits);
+   ulIsFileOff = ulSamplesOff + ulNumSamples * sizeof(unsigned long);
+   ulLabelsOff = ulIsFileOff + FTArchive_wordBytes(ulNodes);
+   ulBlocksOff = ulLabelsOff + FTArchive_wordBytes(ulNodes * ulWidth);
+   ulDictOff = ulBlocksOff + ulNumBlocks * sizeof(unsigned long);
+   ulSize = ulDictOff + FTArchive_align(ulDictLen);
+
+   pcBase = calloc(ulSize, 1);
+   if(pcBase == NULL) {
+      free(oAArchive);
+      free(psNodes);
+      free(ppcComponents);
+      return MEMORY_ERROR;
+   }
+
+   /* Front-code the dictionary */
+   pulBlocks = (unsigned long *) (void *) (pcBase + ulBlocksOff);
+   pcDict = pcBase + ulDictOff;
+   ulLength = 0;
+   for(i = 0; i < ulLabels; i++) {
+      if(i % FTARCHIVE_BLOCK == 0)
+         pulBlocks[i / FTARCHIVE_BLOCK] = ulLength;
+      (void) FTArchive_entryLength(ppcComponents, i, &ulShared);
+      if(i % FTARCHIVE_BLOCK != 0)
+         pcDict[ulLength++] = (char) ulShared;
+      strcpy(pcDict + ulLength, ppcComponents[i] + ulShared);
+      ulLength += strlen(ppcComponents[i] + ulShared) + 1;
+   }
+   assert(ulLength + 1 == ulDictLen);
+
+   /* Write each node's children in unary, its kind and its label */
+   pulLouds = (unsigned long *) (void *) (pcBase + ulLoudsOff);
+   for(i = 0; i < ulNodes; i++) {
+      if(psNodes[i].oNdDir != NULL) {
+         ulLength = NodeD_getNumFileChildren(psNodes[i].oNdDir) +
+                    NodeD_getNumDirChildren(psNodes[i].oNdDir);
+         for(j = 0; j < ulLength; j++)
+            FTArchive_setBit(pulLouds, ulBit++);
+      }
+      else
+         FTArchive_setBit((unsigned long *) (void *)
+                          (pcBase + ulIsFileOff), i);
+      if(ulZeros % FTARCHIVE_SAMPLE == 0)
+         ((unsigned long *) (void *) (pcBase + ulSamplesOff))
+            [ulZeros / FTARCHIVE_SAMPLE] = ulBit;
+      ulZeros++;
+      ulBit++;
+
+      ppcFound = bsearch(&psNodes[i].pcComponent, ppcComponents,
+                         ulLabels, sizeof(const char *),
+                         FTArchive_compareStrings);
+      assert(ppcFound != NULL);
+      FTArchive_setField((unsigned long *) (void *)
+                         (pcBase + ulLabelsOff), i, ulWidth,
+                         (unsigned long) (ppcFound - ppcComponents));
+   }
+   assert(ulBit == ulLoudsBits);
+   for(ulBit = ulLoudsBits;
+       ulBit < FTArchive_wordBytes(ulLoudsBits) * CHAR_BIT; ulBit++)
+      FTArchive_setBit(pulLouds, ulBit);
+   free(psNodes);
+   free(ppcComponents);
+
+   psHeader = (struct archiveHeader *) (void *) pcBase;
+   psHeader->ulMagic = FTARCHIVE_MAGIC;
+   psHeader->ulWordSize = sizeof(unsigned long);
+   psHeader->ulSize = ulSize;
+   psHeader->ulNumNodes = ulNodes;
+   psHeader->ulLoudsOff = ulLoudsOff;
+   psHeader->ulLoudsBits = ulLoudsBits;
+   psHeader->ulSamplesOff = ulSamplesOff;
+   psHeader->ulNumSamples = ulNumSamples;
+   psHeader->ulIsFileOff = ulIsFileOff;
+   psHeader->ulLabelsOff = ulLabelsOff;
+   psHeader->ulLabelWidth = ulWidth;
+   psHeader->ulNumLabels = ulLabels;
+   psHeader->ulMaxComponent = ulMaxComponent;
+   psHeader->ulBlocksOff = ulBlocksOff;
+   psHeader->ulNumBlocks = ulNumBlocks;
+   psHeader->ulDictOff = ulDictOff;
+   psHeader->ulDictLen = ulDictLen;
+
+   oAArchive->pcBase = pcBase;
+   oAArchive->ulSize = ulSize;
+   oAArchive->bIsMapped = FALSE;
+   FTArchive_locate(oAArchive);
+   *poAResult = oAArchive;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTArchive_write(FTArchive_T oAArchive, const char *pcFile) {
+   FILE *psFile;
+   size_t ulWritten;
+
+   assert(oAArchive != NULL);
+   assert(pcFile != NULL);
+
+   psFile = fopen(pcFile, "wb");
+   if(psFile == NULL)
+      return BAD_PATH;
+   ulWritten = fwrite(oAArchive->pcBase, 1, oAArchive->ulSize, psFile);
+   if(fclose(psFile) != 0 || ulWritten != oAArchive->ulSize)
+      return BAD_PATH;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTArchive_map(const char *pcFile, FTArchive_T *poAResult) {
+   FTArchive_T oAArchive;
+   struct stat sStat;
+   size_t ulSize;
+   int iFd;
+   void *pvMap;
+
+   assert(pcFile != NULL);
+   assert(poAResult != NULL);
+
+   *poAResult = NULL;
+   iFd = open(pcFile, O_RDONLY);
+   if(iFd < 0)
+      return errno == ENOENT ? NO_SUCH_PATH : BAD_PATH;
+   if(fstat(iFd, &sStat) != 0) {
+      close(iFd);
+      return BAD_PATH;
+   }
+   ulSize = (size_t) sStat.st_size;
+   if(ulSize < sizeof(struct archiveHeader)) {
+      close(iFd);
+      return INITIALIZATION_ERROR;
+   }
+
+   oAArchive = malloc(sizeof(struct ftArchive));
+   if(oAArchive == NULL) {
+      close(iFd);
+      return MEMORY_ERROR;
+   }
+   pvMap = mmap(NULL, ulSize, PROT_READ, MAP_PRIVATE, iFd, 0);
+   close(iFd);
+   if(pvMap == MAP_FAILED) {
+      free(oAArchive);
+      return BAD_PATH;
+   }
+   oAArchive->pcBase = pvMap;
+   oAArchive->ulSize = ulSize;
+   oAArchive->bIsMapped = TRUE;
+
+   if(!FTArchive_isValid(oAArchive)) {
+      FTArchive_free(oAArchive);
+      return INITIALIZATION_ERROR;
+   }
+
+   *poAResult = oAArchive;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void FTArchive_free(FTArchive_T oAArchive) {
+   assert(oAArchive != NULL);
+
+   if(oAArchive->bIsMapped)
+      (void) munmap(oAArchive->pcBase, oAArchive->ulSize);
+   else
+      free(oAArchive->pcBase);
+   free(oAArchive);
+}
+
+/* ================================================================== */
+int FTArchive_lookup(FTArchive_T oAArchive, const char *pcPath,
+                     boolean *pbIsFile) {
+   char acShort[FTARCHIVE_SHORT_COMPONENT];
+   char *pcBuffer = acShort;
+   size_t ulNode;
+   int iStatus;
+
+   assert(oAArchive != NULL);
+   assert(pcPath != NULL);
+   assert(pbIsFile != NULL);
+
+   /* Most components fit on the stack */
+   if(oAArchive->psHeader->ulMaxComponent >= FTARCHIVE_SHORT_COMPONENT) {
+      pcBuffer = malloc(oAArchive->psHeader->ulMaxComponent + 1);
+      if(pcBuffer == NULL)
+         return MEMORY_ERROR;
+   }
+
+   iStatus = FTArchive_find(oAArchive, pcPath, pcBuffer, &ulNode);
+   if(iStatus == SUCCESS)
+      *pbIsFile = FTArchive_isFile(oAArchive, ulNode);
+
+   if(pcBuffer != acShort)
+      free(pcBuffer);
+   return iStatus;
+}
+
+/* ================================================================== */
+int FTArchive_listDir(FTArchive_T oAArchive, const char *pcPath,
+                      char **ppcResult) {
+   struct archiveText sPath;
+   struct archiveText sText;
+   char *pcBuffer;
+   size_t ulNode;
+   int iStatus;
+
+   assert(oAArchive != NULL);
+   assert(pcPath != NULL);
+   assert(ppcResult != NULL);
+
+   *ppcResult = NULL;
+   pcBuffer = malloc(oAArchive->psHeader->ulMaxComponent + 1);
+   if(pcBuffer == NULL)
+      return MEMORY_ERROR;
+
+   iStatus = FTArchive_find(oAArchive, pcPath, pcBuffer, &ulNode);
+   if(iStatus == SUCCESS && FTArchive_isFile(oAArchive, ulNode))
+      iStatus = NOT_A_DIRECTORY;
+   if(iStatus != SUCCESS) {
+      free(pcBuffer);
+      return iStatus;
+   }
+
+   /* The path found is the one asked for, so it prefixes each line */
+   sPath.pcText = (char *) pcPath;
+   sPath.ulLength = strlen(pcPath);
+   sPath.ulCapacity = 0;
+   sText.pcText = NULL;
+   sText.ulLength = 0;
+   sText.ulCapacity = 0;
+   if(!FTArchive_append(&sText, "", 0) ||
+      !FTArchive_listChildren(oAArchive, ulNode, &sPath, &sText, FALSE,
+                              pcBuffer)) {
+      free(sText.pcText);
+      free(pcBuffer);
+      return MEMORY_ERROR;
+   }
+
+   free(pcBuffer);
+   *ppcResult = sText.pcText;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+char *FTArchive_toString(FTArchive_T oAArchive) {
+   struct archiveText sPath;
+   struct archiveText sText;
+   char *pcBuffer;
+   boolean bOk;
+
+   assert(oAArchive != NULL);
+
+   pcBuffer = malloc(oAArchive->psHeader->ulMaxComponent + 1);
+   if(pcBuffer == NULL)
+      return NULL;
+   sPath.pcText = NULL;
+   sPath.ulLength = 0;
+   sPath.ulCapacity = 0;
+   sText.pcText = NULL;
+   sText.ulLength = 0;
+   sText.ulCapacity = 0;
+
+   /* The root's line, then everything below it in pre-order */
+   bOk = FTArchive_append(&sText, "", 0);
+   if(bOk && oAArchive->psHeader->ulNumNodes != 0) {
+      FTArchive_getComponent(oAArchive, FTArchive_label(oAArchive, 0),
+                             pcBuffer);
+      bOk = (boolean) (FTArchive_append(&sPath, pcBuffer,
+                                        strlen(pcBuffer)) &&
+                       FTArchive_append(&sText, pcBuffer,
+                                        strlen(pcBuffer)) &&
+                       FTArchive_append(&sText, "\n", 1) &&
+                       FTArchive_listChildren(oAArchive, 0, &sPath,
+                                              &sText, TRUE, pcBuffer));
+   }
+
+   free(sPath.pcText);
+   free(pcBuffer);
+   if(!bOk) {
+      free(sText.pcText);
+      return NULL;
+   }
+   return sText.pcText;
+}
+
+/* ================================================================== */
+void FTArchive_getStats(FTArchive_T oAArchive,
+                        struct FTArchiveStats *psStats) {
+   const struct archiveHeader *psHeader;
+
+   assert(oAArchive != NULL);
+   assert(psStats != NULL);
+
+   psHeader = oAArchive->psHeader;
+   psStats->ulNodes = psHeader->ulNumNodes;
+   psStats->ulTreeBits = CHAR_BIT *
+      (FTArchive_wordBytes(psHeader->ulLoudsBits) +
+       psHeader->ulNumSamples * sizeof(unsigned long));
+   psStats->ulLabelBits = CHAR_BIT *
+      (FTArchive_wordBytes(psHeader->ulNumNodes) +
+       FTArchive_wordBytes(psHeader->ulNumNodes *
+                           psHeader->ulLabelWidth));
+   psStats->ulDictBytes = psHeader->ulNumBlocks * sizeof(unsigned long) +
+                          psHeader->ulDictLen;
+   psStats->ulTotalBytes = oAArchive->ulSize;
+}
@@ -0,0 +1,103 @@
+/*--------------------------------------------------------------------*/
+/* ftarchive.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTARCHIVE_INCLUDED
+#define FTARCHIVE_INCLUDED
+
+/*
+  An archived FT is a compact read-only record of the shape of a File
+  Tree: which directories and files it held, without their contents.
+  The tree is stored as a LOUDS bit string (each node's child count in
+  unary, in level order: 2 bits per node) with sampled select support,
+  one bit per node telling files from directories, and a fixed-width
+  label per node naming its last path component in a front-coded
+  dictionary of the distinct components. Pathnames are never stored;
+  lookups walk down from the root, and listings rebuild them.
+
+  An archive is one block addressed by offsets, so it can be written
+  to a file and mapped back in at any address.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "noded.h"
+
+/* An FTArchive_T is an archived tree, built in memory or mapped in */
+typedef struct ftArchive *FTArchive_T;
+
+/* Where the bytes of an archive go */
+struct FTArchiveStats {
+   /* Directories and files archived */
+   size_t ulNodes;
+   /* Bits of the LOUDS string and its select samples */
+   size_t ulTreeBits;
+   /* Bits of the per-node labels and file flags */
+   size_t ulLabelBits;
+   /* Bytes of the component dictionary and its block index */
+   size_t ulDictBytes;
+   /* Bytes of the whole archive */
+   size_t ulTotalBytes;
+};
+
+/*
+  Archives the tree rooted at oNdRoot (NULL for an empty tree).
+  Returns SUCCESS and sets *poAResult if successful. Otherwise, sets
+  *poAResult to NULL and returns MEMORY_ERROR.
+*/
+int FTArchive_build(NodeD_T oNdRoot, FTArchive_T *poAResult);
+
+/*
+  Writes oAArchive to the file named pcFile, replacing it. Returns
+  SUCCESS, or BAD_PATH if the file could not be written.
+*/
+int FTArchive_write(FTArchive_T oAArchive, const char *pcFile);
+
+/*
+  Maps the archive in the file named pcFile for reading. Returns
+  SUCCESS and sets *poAResult if successful. Otherwise, sets
+  *poAResult to NULL and returns:
+  * NO_SUCH_PATH if there is no such file
+  * INITIALIZATION_ERROR if the file is not an archived FT
+  * BAD_PATH if the file could not be mapped
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FTArchive_map(const char *pcFile, FTArchive_T *poAResult);
+
+/* Frees or unmaps oAArchive. */
+void FTArchive_free(FTArchive_T oAArchive);
+
+/*
+  Looks up absolute path pcPath in oAArchive, storing in *pbIsFile
+  whether it was a file. Returns SUCCESS if found. Otherwise, returns:
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath was not in the tree
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FTArchive_lookup(FTArchive_T oAArchive, const char *pcPath,
+                     boolean *pbIsFile);
+
+/*
+  Sets *ppcResult to newly allocated text, owned by the caller, naming
+  the children of the directory with absolute path pcPath one per line
+  in FT_toString order: its files, then its subdirectories. Returns
+  SUCCESS if successful. Otherwise, sets *ppcResult to NULL and returns
+  NOT_A_DIRECTORY if pcPath was a file, or any status FTArchive_lookup
+  returns for pcPath.
+*/
+int FTArchive_listDir(FTArchive_T oAArchive, const char *pcPath,
+                      char **ppcResult);
+
+/*
+  Returns the FT_toString text of the archived tree in newly allocated
+  memory owned by the caller, or NULL if there is an allocation error.
+*/
+char *FTArchive_toString(FTArchive_T oAArchive);
+
+/* Stores how oAArchive's bytes are spent in *psStats. */
+void FTArchive_getStats(FTArchive_T oAArchive,
+                        struct FTArchiveStats *psStats);
+
+#endif
@@ -0,0 +1,1196 @@
+/*--------------------------------------------------------------------*/
+/* ftd.c                                                              */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  ftd serves one File Tree to any number of local clients over a Unix
+  domain socket, speaking the protocol of ftproto.h.
+
+  Usage: ftd socketpath [-t threads] [-b budget] [-s spillpath]
+             [-c scrubrate]
+
+  One thread runs an epoll loop that owns every socket: it accepts
+  connections, splits incoming bytes into request frames, queues them
+  for the worker threads, and writes back the responses the workers
+  leave in each connection's output buffer. Workers execute requests
+  against the FT under a readers-writer lock, so lookups run in
+  parallel and updates run alone. Responses are sent as requests
+  finish, in any order; clients match them by request ID.
+
+  The FT keeps its contents in the content store (ulBudget bytes in
+  memory, the rest spilled to spillpath), so that the server, not the
+  client, owns every byte in the tree.
+
+  With -c, files carry checksums of their contents, and a scrubber
+  thread rereads about scrubrate bytes of contents a second, in short
+  turns under the exclusive lock, reporting on stderr any file whose
+  contents, in memory or in the spill file, have gone bad.
+*/
+
+/* Sockets, threads and epoll are POSIX and Linux, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include "dynarray.h"
+#include "ft.h"
+#include "ftproto.h"
+
+/* Default number of worker threads */
+enum { DEFAULT_THREADS = 4 };
+
+/* Default in-memory budget for file contents, in bytes */
+enum { DEFAULT_BUDGET = 256 * 1024 * 1024 };
+
+/* Requests a connection may have queued or executing before the
+   server stops reading from it */
+enum { MAX_PIPELINE = 1024 };
+
+/* Bytes read from a socket at a time */
+enum { READ_CHUNK = 64 * 1024 };
+
+/* Events fetched per epoll_wait */
+enum { MAX_EVENTS = 64 };
+
+/* Milliseconds between the scrubber's turns */
+enum { SCRUB_INTERVAL = 100 };
+
+/* One client connection */
+struct conn {
+   /* The connected socket */
+   int iFd;
+
+   /* Position in oDConns, the server's list of open connections */
+   size_t ulSlot;
+
+   /* Bytes received but not yet split into frames (loop only) */
+   struct FTBuf sIn;
+
+   /* Events the socket is registered for (loop only) */
+   unsigned int uEvents;
+
+   /* Whether the client has finished sending (loop only) */
+   boolean bReadDone;
+
+   /* Guards the fields below, which workers also use */
+   pthread_mutex_t sLock;
+
+   /* Responses not yet written to the socket */
+   struct FTBuf sOut;
+
+   /* Requests queued or executing */
+   size_t ulPending;
+
+   /* References: the loop's while open, one per job, and one while
+      on the ready list. The connection is freed when they are gone */
+   size_t ulRefs;
+
+   /* Whether the connection is on the ready list */
+   boolean bIsReady;
+
+   /* Whether the loop has closed the socket */
+   boolean bIsClosed;
+
+   /* Next connection on the ready list */
+   struct conn *psNextReady;
+};
+
+/* One request waiting for a worker */
+struct job {
+   /* The connection it came from */
+   struct conn *psConn;
+
+   /* The request's frame body and its length */
+   char *pcBody;
+   size_t ulLength;
+
+   /* Next job in the queue */
+   struct job *psNext;
+};
+
+/* Serializes FT calls: shared for lookups, exclusive for the rest */
+static pthread_rwlock_t sTreeLock;
+
+/* The job queue, from which workers take requests in FIFO order */
+static pthread_mutex_t sQueueLock;
+static pthread_cond_t sQueueCond;
+static struct job *psQueueHead;
+static struct job *psQueueTail;
+static boolean bIsStopping;
+
+/* Wakes the scrubber early when the server stops (with sQueueLock) */
+static pthread_cond_t sScrubCond;
+
+/* Connections with new responses, for the loop to write out */
+static pthread_mutex_t sReadyLock;
+static struct conn *psReadyList;
+
+/* Written to wake the loop: by workers, and by signal handlers */
+static int aiWakePipe[2];
+
+/* Set by SIGINT and SIGTERM */
+static volatile sig_atomic_t iStopSignal;
+
+/* The epoll instance and open connections (loop only) */
+static int iEpollFd;
+static DynArray_T oDConns;
+
+/* Content store settings, reapplied after each FTOP_INIT */
+static size_t ulBudget = DEFAULT_BUDGET;
+static const char *pcSpillPath;
+
+/* Bytes of contents scrubbed per second, or 0 for no checksums */
+static size_t ulScrubRate;
+
+/* Stands in for empty, non-NULL contents, which the content store
+   does not copy. It is never freed, so the FT may keep it. */
+static char cEmptyContents;
+
+/* Distinguish the listening socket and wake pipe in epoll events */
+static char cListenTag, cWakeTag;
+
+/*--------------------------------------------------------------------*/
+
+/* Drops one reference to psConn, freeing it if it was the last.
+   psConn's lock must not be held. */
+static void Ftd_releaseConn(struct conn *psConn) {
+   size_t ulRefs;
+
+   assert(psConn != NULL);
+
+   pthread_mutex_lock(&psConn->sLock);
+   ulRefs = --psConn->ulRefs;
+   pthread_mutex_unlock(&psConn->sLock);
+   if(ulRefs != 0)
+      return;
+
+   FTBuf_free(&psConn->sIn);
+   FTBuf_free(&psConn->sOut);
+   pthread_mutex_destroy(&psConn->sLock);
+   free(psConn);
+}
+
+/* Writes a byte to the wake pipe. Safe in a signal handler. */
+static void Ftd_wake(void) {
+   char c = 0;
+
+   (void) write(aiWakePipe[1], &c, 1);
+}
+
+/* Records that a stop was requested. */
+static void Ftd_onSignal(int iSignal) {
+   (void) iSignal;
+   iStopSignal = 1;
+   Ftd_wake();
+}
+
+/* Replaces the 1-byte status field at ulPos of *psBuf with iStatus. */
+static void Ftd_setStatus(struct FTBuf *psBuf, size_t ulPos, int iStatus) {
+   if(psBuf->bIsValid)
+      psBuf->pcData[ulPos] = (char) iStatus;
+}
+
+/* Returns the contents pointer the FT should store for a blob of
+   ulLength bytes at pcData (NULL for a NULL blob). */
+static void *Ftd_contentsFor(const char *pcData, size_t ulLength) {
+   if(pcData == NULL)
+      return NULL;
+   if(ulLength == 0)
+      return &cEmptyContents;
+   /* Non-empty contents are copied by the content store */
+   return (void *) pcData;
+}
+
+/* Appends the pathnames in oDPaths to *psOut as a paths field. */
+static void Ftd_putPaths(struct FTBuf *psOut, DynArray_T oDPaths) {
+   size_t i;
+
+   FTBuf_putU32(psOut, (unsigned long) DynArray_getLength(oDPaths));
+   for(i = 0; i < DynArray_getLength(oDPaths); i++)
+      FTBuf_putPath(psOut, DynArray_get(oDPaths, i));
+}
+
+/* Frees the ulCount paths in ppcPaths, and ppcPaths. */
+static void Ftd_freePaths(char **ppcPaths, size_t ulCount) {
+   size_t i;
+
+   for(i = 0; i < ulCount; i++)
+      free(ppcPaths[i]);
+   free(ppcPaths);
+}
+
+/* Reads a paths field from *psCursor into a new array of new strings,
+   storing its length in *pulCount. Returns the array, or NULL if the
+   field is malformed or memory cannot be allocated. */
+static char **Ftd_getPaths(struct FTCursor *psCursor, size_t *pulCount) {
+   char **ppcPaths;
+   size_t i, ulCount;
+
+   ulCount = (size_t) FTCursor_getU32(psCursor);
+   /* Each path takes at least its 4-byte length */
+   if(!psCursor->bIsValid || ulCount > psCursor->ulLeft / 4) {
+      psCursor->bIsValid = FALSE;
+      return NULL;
+   }
+   ppcPaths = calloc(ulCount == 0 ? 1 : ulCount, sizeof(char *));
+   if(ppcPaths == NULL)
+      return NULL;
+   for(i = 0; i < ulCount; i++) {
+      ppcPaths[i] = FTCursor_getPath(psCursor);
+      if(ppcPaths[i] == NULL) {
+         Ftd_freePaths(ppcPaths, i);
+         return NULL;
+      }
+   }
+   *pulCount = ulCount;
+   return ppcPaths;
+}
+
+/* Where Ftd_putEntry appends FT_scanRange's entries */
+struct scan {
+   struct FTBuf *psOut;
+   size_t ulCount;
+};
+
+/* Appends the entry pcPath, a file if bIsFile, to the struct scan
+   pvScan. */
+static void Ftd_putEntry(const char *pcPath, boolean bIsFile,
+                         void *pvScan) {
+   struct scan *psScan = pvScan;
+
+   FTBuf_putPath(psScan->psOut, pcPath);
+   FTBuf_putU8(psScan->psOut, bIsFile);
+   psScan->ulCount++;
+}
+
+/* Executes the path operation eOp on pcPath, whose arguments after
+   the path are in *psCursor, appending its results to *psOut. Returns
+   the operation's status. */
+static int Ftd_executePathOp(enum FTOp eOp, const char *pcPath,
+                             struct FTCursor *psCursor,
+                             struct FTBuf *psOut) {
+   const char *pcData;
+   size_t ulLength, ulFiles, ulDirs, ulSize = 0;
+   boolean bIsFile = FALSE;
+   void *pvContents;
+   char *pcKey;
+   struct AttrValue sValue;
+   int iStatus;
+
+   switch(eOp) {
+      case FTOP_CONTAINS_DIR:
+      case FTOP_CONTAINS_FILE:
+         pthread_rwlock_rdlock(&sTreeLock);
+         bIsFile = eOp == FTOP_CONTAINS_DIR ?
+                   FT_containsDir(pcPath) : FT_containsFile(pcPath);
+         pthread_rwlock_unlock(&sTreeLock);
+         FTBuf_putU8(psOut, bIsFile);
+         return SUCCESS;
+
+      case FTOP_STAT:
+         pthread_rwlock_rdlock(&sTreeLock);
+         iStatus = FT_stat(pcPath, &bIsFile, &ulSize);
+         pthread_rwlock_unlock(&sTreeLock);
+         if(iStatus == SUCCESS) {
+            FTBuf_putU8(psOut, bIsFile);
+            FTBuf_putSize(psOut, ulSize);
+         }
+         return iStatus;
+
+      case FTOP_COUNT:
+         pthread_rwlock_rdlock(&sTreeLock);
+         iStatus = FT_count(pcPath, &ulFiles, &ulDirs);
+         pthread_rwlock_unlock(&sTreeLock);
+         if(iStatus == SUCCESS) {
+            FTBuf_putSize(psOut, ulFiles);
+            FTBuf_putSize(psOut, ulDirs);
+         }
+         return iStatus;
+
+      case FTOP_NTH:
+         ulSize = FTCursor_getSize(psCursor);
+         if(!psCursor->bIsValid)
+            return BAD_PATH;
+         pthread_rwlock_rdlock(&sTreeLock);
+         iStatus = FT_nth(pcPath, ulSize, &pcData, &bIsFile);
+         if(iStatus == SUCCESS) {
+            FTBuf_putPath(psOut, pcData);
+            FTBuf_putU8(psOut, bIsFile);
+         }
+         pthread_rwlock_unlock(&sTreeLock);
+         return iStatus;
+
+      case FTOP_SET_ATTR:
+      case FTOP_GET_ATTR:
+      case FTOP_REMOVE_ATTR:
+         pcKey = FTCursor_getPath(psCursor);
+         if(pcKey == NULL)
+            return psCursor->bIsValid ? MEMORY_ERROR : BAD_PATH;
+         if(eOp == FTOP_SET_ATTR &&
+            !FTCursor_getValue(psCursor, &sValue)) {
+            free(pcKey);
+            return psCursor->bIsValid ? MEMORY_ERROR : BAD_PATH;
+         }
+         if(eOp == FTOP_GET_ATTR) {
+            /* A string value belongs to the FT, so it is sent before
+               the lock is released */
+            pthread_rwlock_rdlock(&sTreeLock);
+            iStatus = FT_getAttr(pcPath, pcKey, &sValue);
+            if(iStatus == SUCCESS)
+               FTBuf_putValue(psOut, &sValue);
+            pthread_rwlock_unlock(&sTreeLock);
+            free(pcKey);
+            return iStatus;
+         }
+         pthread_rwlock_wrlock(&sTreeLock);
+         if(eOp == FTOP_SET_ATTR)
+            iStatus = FT_setAttr(pcPath, pcKey, &sValue);
+         else
+            iStatus = FT_removeAttr(pcPath, pcKey);
+         pthread_rwlock_unlock(&sTreeLock);
+         if(eOp == FTOP_SET_ATTR)
+            free((char *) sValue.pcString);
+         free(pcKey);
+         return iStatus;
+
+      case FTOP_INSERT_DIR:
+      case FTOP_RM_DIR:
+      case FTOP_RM_FILE:
+         pthread_rwlock_wrlock(&sTreeLock);
+         if(eOp == FTOP_INSERT_DIR)
+            iStatus = FT_insertDir(pcPath);
+         else if(eOp == FTOP_RM_DIR)
+            iStatus = FT_rmDir(pcPath);
+         else
+            iStatus = FT_rmFile(pcPath);
+         pthread_rwlock_unlock(&sTreeLock);
+         return iStatus;
+
+      case FTOP_INSERT_FILE:
+         if(!FTCursor_getBlob(psCursor, &pcData, &ulLength))
+            return BAD_PATH;
+         pthread_rwlock_wrlock(&sTreeLock);
+         iStatus = FT_insertFile(pcPath, Ftd_contentsFor(pcData, ulLength),
+                                 ulLength);
+         pthread_rwlock_unlock(&sTreeLock);
+         return iStatus;
+
+      /* Reading contents may fault them in from the spill file, which
+         changes the content store, so it needs the lock exclusively.
+         The contents are copied out before the lock is released. */
+      case FTOP_GET_CONTENTS:
+      case FTOP_REPLACE_CONTENTS:
+         pcData = NULL;
+         ulLength = 0;
+         if(eOp == FTOP_REPLACE_CONTENTS &&
+            !FTCursor_getBlob(psCursor, &pcData, &ulLength))
+            return BAD_PATH;
+         pthread_rwlock_wrlock(&sTreeLock);
+         iStatus = FT_stat(pcPath, &bIsFile, &ulSize);
+         if(iStatus == SUCCESS && !bIsFile)
+            iStatus = NOT_A_FILE;
+         if(iStatus == SUCCESS) {
+            if(eOp == FTOP_GET_CONTENTS)
+               pvContents = FT_getFileContents(pcPath);
+            else
+               pvContents = FT_replaceFileContents(pcPath,
+                               Ftd_contentsFor(pcData, ulLength),
+                               ulLength);
+            FTBuf_putBlob(psOut, pvContents, ulSize);
+         }
+         pthread_rwlock_unlock(&sTreeLock);
+         return iStatus;
+
+      default:
+         return BAD_PATH;
+   }
+}
+
+/* Executes the operation eOp, which does not start with a path and
+   whose arguments are in *psCursor, appending its results to *psOut.
+   Returns the operation's status. */
+static int Ftd_executeQueryOp(enum FTOp eOp, struct FTCursor *psCursor,
+                              struct FTBuf *psOut) {
+   DynArray_T oDPaths = NULL;
+   struct AttrValue sValue;
+   struct FTStat *psStats;
+   struct scan sScan;
+   const char *pcData, *pcLo, *pcHi;
+   char *pcKey, *pcBounds[2];
+   char **ppcPaths;
+   size_t ulLength[2], ulMin, ulMax, ulCount = 0, i;
+   size_t *pulLengths;
+   void **ppvContents;
+   int iStatus;
+
+   switch(eOp) {
+      case FTOP_ENABLE_SIZE_INDEX:
+         pthread_rwlock_wrlock(&sTreeLock);
+         iStatus = FT_enableSizeIndex();
+         pthread_rwlock_unlock(&sTreeLock);
+         return iStatus;
+
+      case FTOP_TOP_K_BY_SIZE:
+      case FTOP_FILES_IN_SIZE_RANGE:
+         ulMin = FTCursor_getSize(psCursor);
+         ulMax = eOp == FTOP_TOP_K_BY_SIZE ?
+                 0 : FTCursor_getSize(psCursor);
+         if(!psCursor->bIsValid)
+            return BAD_PATH;
+         /* The pathnames belong to the FT, so they are sent before the
+            lock is released */
+         pthread_rwlock_rdlock(&sTreeLock);
+         if(eOp == FTOP_TOP_K_BY_SIZE)
+            iStatus = FT_topKBySize(ulMin, &oDPaths);
+         else
+            iStatus = FT_filesInSizeRange(ulMin, ulMax, &oDPaths);
+         if(iStatus == SUCCESS)
+            Ftd_putPaths(psOut, oDPaths);
+         pthread_rwlock_unlock(&sTreeLock);
+         if(oDPaths != NULL)
+            DynArray_free(oDPaths);
+         return iStatus;
+
+      case FTOP_INDEX_ATTR:
+      case FTOP_FIND_BY_ATTR:
+         pcKey = FTCursor_getPath(psCursor);
+         if(pcKey == NULL)
+            return psCursor->bIsValid ? MEMORY_ERROR : BAD_PATH;
+         if(eOp == FTOP_INDEX_ATTR) {
+            pthread_rwlock_wrlock(&sTreeLock);
+            iStatus = FT_indexAttr(pcKey);
+            pthread_rwlock_unlock(&sTreeLock);
+            free(pcKey);
+            return iStatus;
+         }
+         if(!FTCursor_getValue(psCursor, &sValue)) {
+            free(pcKey);
+            return psCursor->bIsValid ? MEMORY_ERROR : BAD_PATH;
+         }
+         pthread_rwlock_rdlock(&sTreeLock);
+         iStatus = FT_findByAttr(pcKey, &sValue, &oDPaths);
+         if(iStatus == SUCCESS)
+            Ftd_putPaths(psOut, oDPaths);
+         pthread_rwlock_unlock(&sTreeLock);
+         if(oDPaths != NULL)
+            DynArray_free(oDPaths);
+         free((char *) sValue.pcString);
+         free(pcKey);
+         return iStatus;
+
+      case FTOP_SCAN_RANGE:
+         /* A NULL blob leaves that end of the range open */
+         if(!FTCursor_getBlob(psCursor, &pcLo, &ulLength[0]) ||
+            !FTCursor_getBlob(psCursor, &pcHi, &ulLength[1]))
+            return BAD_PATH;
+         pcBounds[0] = pcBounds[1] = NULL;
+         for(i = 0; i < 2; i++) {
+            pcData = i == 0 ? pcLo : pcHi;
+            if(pcData == NULL)
+               continue;
+            pcBounds[i] = malloc(ulLength[i] + 1);
+            if(pcBounds[i] == NULL) {
+               free(pcBounds[0]);
+               return MEMORY_ERROR;
+            }
+            memcpy(pcBounds[i], pcData, ulLength[i]);
+            pcBounds[i][ulLength[i]] = '\0';
+         }
+         sScan.psOut = psOut;
+         sScan.ulCount = 0;
+         i = psOut->ulLength;
+         FTBuf_putU32(psOut, 0);
+         pthread_rwlock_rdlock(&sTreeLock);
+         iStatus = FT_scanRange(pcBounds[0], pcBounds[1], Ftd_putEntry,
+                                &sScan);
+         pthread_rwlock_unlock(&sTreeLock);
+         FTBuf_setU32(psOut, i, (unsigned long) sScan.ulCount);
+         free(pcBounds[0]);
+         free(pcBounds[1]);
+         return iStatus;
+
+      case FTOP_STAT_MULTI:
+      case FTOP_GET_CONTENTS_MULTI:
+         ppcPaths = Ftd_getPaths(psCursor, &ulCount);
+         if(ppcPaths == NULL)
+            return psCursor->bIsValid ? MEMORY_ERROR : BAD_PATH;
+         psStats = malloc((ulCount == 0 ? 1 : ulCount) *
+                          sizeof(struct FTStat));
+         ppvContents = malloc((ulCount == 0 ? 1 : ulCount) *
+                              sizeof(void *));
+         pulLengths = malloc((ulCount == 0 ? 1 : ulCount) *
+                             sizeof(size_t));
+         if(psStats == NULL || ppvContents == NULL ||
+            pulLengths == NULL) {
+            free(psStats);
+            free(ppvContents);
+            free(pulLengths);
+            Ftd_freePaths(ppcPaths, ulCount);
+            return MEMORY_ERROR;
+         }
+         if(eOp == FTOP_STAT_MULTI) {
+            pthread_rwlock_rdlock(&sTreeLock);
+            iStatus = FT_statMulti((const char **) ppcPaths, ulCount,
+                                   psStats);
+            pthread_rwlock_unlock(&sTreeLock);
+            for(i = 0; iStatus == SUCCESS && i < ulCount; i++) {
+               FTBuf_putU8(psOut, (unsigned int) psStats[i].iStatus);
+               FTBuf_putU8(psOut, psStats[i].bIsFile);
+               FTBuf_putSize(psOut, psStats[i].ulSize);
+            }
+         }
+         else {
+            /* Fetching may fault contents in, hence the exclusive
+               lock, held until they are copied out */
+            pthread_rwlock_wrlock(&sTreeLock);
+            iStatus = FT_getFileContentsMulti((const char **) ppcPaths,
+                                              ulCount, ppvContents,
+                                              pulLengths);
+            for(i = 0; iStatus == SUCCESS && i < ulCount; i++)
+               FTBuf_putBlob(psOut, ppvContents[i], pulLengths[i]);
+            pthread_rwlock_unlock(&sTreeLock);
+         }
+         free(psStats);
+         free(ppvContents);
+         free(pulLengths);
+         Ftd_freePaths(ppcPaths, ulCount);
+         return iStatus;
+
+      default:
+         return BAD_PATH;
+   }
+}
+
+/* Executes the request in the ulLength bytes at pcBody, appending the
+   response frame to *psOut. Returns FALSE if the request is too
+   malformed to answer, TRUE otherwise. */
+static boolean Ftd_execute(const char *pcBody, size_t ulLength,
+                           struct FTBuf *psOut) {
+   struct FTCursor sCursor;
+   unsigned long ulId;
+   unsigned int uOp;
+   size_t ulFrame, ulStatusPos;
+   char *pcPath, *pcString;
+   int iStatus;
+
+   FTCursor_init(&sCursor, pcBody, ulLength);
+   ulId = FTCursor_getU32(&sCursor);
+   uOp = FTCursor_getU8(&sCursor);
+   if(!sCursor.bIsValid)
+      return FALSE;
+
+   ulFrame = FTBuf_beginFrame(psOut);
+   FTBuf_putU32(psOut, ulId);
+   FTBuf_putU8(psOut, uOp);
+   ulStatusPos = psOut->ulLength;
+   FTBuf_putU8(psOut, SUCCESS);
+
+   switch(uOp) {
+      case FTOP_INIT:
+         pthread_rwlock_wrlock(&sTreeLock);
+         iStatus = FT_init();
+         if(iStatus == SUCCESS) {
+            iStatus = FT_setContentBudget(ulBudget, pcSpillPath);
+            if(iStatus == SUCCESS && ulScrubRate != 0)
+               iStatus = FT_enableChecksums();
+            if(iStatus != SUCCESS)
+               (void) FT_destroy();
+         }
+         pthread_rwlock_unlock(&sTreeLock);
+         break;
+
+      case FTOP_DESTROY:
+         pthread_rwlock_wrlock(&sTreeLock);
+         iStatus = FT_destroy();
+         pthread_rwlock_unlock(&sTreeLock);
+         break;
+
+      case FTOP_TO_STRING:
+         pthread_rwlock_rdlock(&sTreeLock);
+         pcString = FT_toString();
+         pthread_rwlock_unlock(&sTreeLock);
+         FTBuf_putBlob(psOut, pcString,
+                       pcString == NULL ? 0 : strlen(pcString));
+         free(pcString);
+         iStatus = SUCCESS;
+         break;
+
+      case FTOP_ENABLE_SIZE_INDEX:
+      case FTOP_TOP_K_BY_SIZE:
+      case FTOP_FILES_IN_SIZE_RANGE:
+      case FTOP_INDEX_ATTR:
+      case FTOP_FIND_BY_ATTR:
+      case FTOP_SCAN_RANGE:
+      case FTOP_STAT_MULTI:
+      case FTOP_GET_CONTENTS_MULTI:
+         iStatus = Ftd_executeQueryOp((enum FTOp) uOp, &sCursor, psOut);
+         break;
+
+      default:
+         pcPath = FTCursor_getPath(&sCursor);
+         if(pcPath == NULL)
+            iStatus = sCursor.bIsValid ? MEMORY_ERROR : BAD_PATH;
+         else
+            iStatus = Ftd_executePathOp((enum FTOp) uOp, pcPath,
+                                        &sCursor, psOut);
+         free(pcPath);
+         break;
+   }
+
+   /* Results are sent only on success, except for the contains checks
+      whose answer is the result */
+   if(iStatus != SUCCESS && psOut->bIsValid)
+      psOut->ulLength = ulStatusPos + 1;
+   Ftd_setStatus(psOut, ulStatusPos, iStatus);
+   FTBuf_endFrame(psOut, ulFrame);
+   return TRUE;
+}
+
+/* Adds psConn to the ready list, if not already on it, and wakes the
+   loop. psConn's lock must be held. */
+static void Ftd_markReady(struct conn *psConn) {
+   if(psConn->bIsReady)
+      return;
+   psConn->bIsReady = TRUE;
+   psConn->ulRefs++;
+   pthread_mutex_lock(&sReadyLock);
+   psConn->psNextReady = psReadyList;
+   psReadyList = psConn;
+   pthread_mutex_unlock(&sReadyLock);
+   Ftd_wake();
+}
+
+/* Runs a worker thread: takes jobs off the queue until the server
+   stops, executes them, and hands the responses to the loop. */
+static void *Ftd_worker(void *pvExtra) {
+   struct FTBuf sReply;
+   struct job *psJob;
+   struct conn *psConn;
+   boolean bIsAnswered;
+
+   (void) pvExtra;
+   FTBuf_init(&sReply);
+   for(;;) {
+      pthread_mutex_lock(&sQueueLock);
+      while(psQueueHead == NULL && !bIsStopping)
+         pthread_cond_wait(&sQueueCond, &sQueueLock);
+      psJob = psQueueHead;
+      if(psJob != NULL) {
+         psQueueHead = psJob->psNext;
+         if(psQueueHead == NULL)
+            psQueueTail = NULL;
+      }
+      pthread_mutex_unlock(&sQueueLock);
+      if(psJob == NULL)
+         break;
+
+      /* Build the response privately, then append it in one step */
+      sReply.ulLength = 0;
+      sReply.bIsValid = TRUE;
+      psConn = psJob->psConn;
+      bIsAnswered = Ftd_execute(psJob->pcBody, psJob->ulLength, &sReply);
+
+      pthread_mutex_lock(&psConn->sLock);
+      psConn->ulPending--;
+      if(!psConn->bIsClosed) {
+         if(bIsAnswered && sReply.bIsValid)
+            FTBuf_putBytes(&psConn->sOut, sReply.pcData, sReply.ulLength);
+         /* A request that cannot be answered ends the connection, as
+            does a response that cannot be buffered */
+         if(!bIsAnswered || !sReply.bIsValid)
+            psConn->sOut.bIsValid = FALSE;
+         Ftd_markReady(psConn);
+      }
+      pthread_mutex_unlock(&psConn->sLock);
+
+      Ftd_releaseConn(psConn);
+      free(psJob->pcBody);
+      free(psJob);
+   }
+   FTBuf_free(&sReply);
+   return NULL;
+}
+
+/* Reports the file with pathname pcPath as corrupt. */
+static void Ftd_onMismatch(const char *pcPath, void *pvExtra) {
+   (void) pvExtra;
+   fprintf(stderr, "ftd: checksum mismatch in %s\n", pcPath);
+}
+
+/* Runs the scrubber thread: every SCRUB_INTERVAL milliseconds until
+   the server stops, verifies the next share of ulScrubRate's bytes. */
+static void *Ftd_scrubber(void *pvExtra) {
+   struct timespec sDeadline;
+   size_t ulShare;
+
+   (void) pvExtra;
+   ulShare = ulScrubRate / (1000 / SCRUB_INTERVAL);
+   pthread_mutex_lock(&sQueueLock);
+   while(!bIsStopping) {
+      (void) clock_gettime(CLOCK_REALTIME, &sDeadline);
+      sDeadline.tv_nsec += SCRUB_INTERVAL * 1000000L;
+      if(sDeadline.tv_nsec >= 1000000000L) {
+         sDeadline.tv_sec++;
+         sDeadline.tv_nsec -= 1000000000L;
+      }
+      if(pthread_cond_timedwait(&sScrubCond, &sQueueLock, &sDeadline)
+         == 0)
+         continue;
+      pthread_mutex_unlock(&sQueueLock);
+
+      /* Checking contents may fault them in, like reading them; an
+         uninitialized tree is simply skipped */
+      pthread_rwlock_wrlock(&sTreeLock);
+      (void) FT_scrub(ulShare, Ftd_onMismatch, NULL, NULL);
+      pthread_rwlock_unlock(&sTreeLock);
+
+      pthread_mutex_lock(&sQueueLock);
+   }
+   pthread_mutex_unlock(&sQueueLock);
+   return NULL;
+}
+
+/* Registers psConn's socket for the events it needs now: input unless
+   its pipeline is full or its client is done sending, and output while
+   responses are waiting. Returns FALSE if epoll fails. */
+static boolean Ftd_updateEvents(struct conn *psConn) {
+   struct epoll_event sEvent;
+   unsigned int uEvents = 0;
+
+   pthread_mutex_lock(&psConn->sLock);
+   if(!psConn->bReadDone && psConn->ulPending < MAX_PIPELINE)
+      uEvents |= EPOLLIN;
+   if(psConn->sOut.ulLength != 0)
+      uEvents |= EPOLLOUT;
+   pthread_mutex_unlock(&psConn->sLock);
+
+   if(uEvents == psConn->uEvents)
+      return TRUE;
+   psConn->uEvents = uEvents;
+   memset(&sEvent, 0, sizeof(sEvent));
+   sEvent.events = uEvents;
+   sEvent.data.ptr = psConn;
+   return (boolean) (epoll_ctl(iEpollFd, EPOLL_CTL_MOD, psConn->iFd,
+                               &sEvent) == 0);
+}
+
+/* Closes psConn's socket and forgets it. Responses still being built
+   for it are discarded by the workers. */
+static void Ftd_closeConn(struct conn *psConn) {
+   struct conn *psMoved;
+   size_t ulLast;
+
+   (void) epoll_ctl(iEpollFd, EPOLL_CTL_DEL, psConn->iFd, NULL);
+   close(psConn->iFd);
+
+   /* Fill psConn's slot with the last connection */
+   ulLast = DynArray_getLength(oDConns) - 1;
+   psMoved = DynArray_removeAt(oDConns, ulLast);
+   if(psMoved != psConn) {
+      (void) DynArray_set(oDConns, psConn->ulSlot, psMoved);
+      psMoved->ulSlot = psConn->ulSlot;
+   }
+
+   pthread_mutex_lock(&psConn->sLock);
+   psConn->bIsClosed = TRUE;
+   pthread_mutex_unlock(&psConn->sLock);
+   Ftd_releaseConn(psConn);
+}
+
+/* Splits psConn's received bytes into requests and queues them, up to
+   its pipeline limit. Returns FALSE if a frame is malformed or memory
+   runs out. */
+static boolean Ftd_queueRequests(struct conn *psConn) {
+   struct job *psJob;
+   size_t ulBody, ulConsumed = 0;
+   boolean bIsValid;
+
+   for(;;) {
+      pthread_mutex_lock(&psConn->sLock);
+      bIsValid = (boolean) (psConn->ulPending < MAX_PIPELINE);
+      pthread_mutex_unlock(&psConn->sLock);
+      if(!bIsValid ||
+         !FTProto_haveFrame(psConn->sIn.pcData + ulConsumed,
+                            psConn->sIn.ulLength - ulConsumed,
+                            &ulBody, &bIsValid))
+         break;
+
+      psJob = malloc(sizeof(struct job));
+      if(psJob == NULL)
+         return FALSE;
+      psJob->pcBody = malloc(ulBody == 0 ? 1 : ulBody);
+      if(psJob->pcBody == NULL) {
+         free(psJob);
+         return FALSE;
+      }
+      memcpy(psJob->pcBody, psConn->sIn.pcData + ulConsumed + 4, ulBody);
+      psJob->ulLength = ulBody;
+      psJob->psConn = psConn;
+      psJob->psNext = NULL;
+      ulConsumed += 4 + ulBody;
+
+      pthread_mutex_lock(&psConn->sLock);
+      psConn->ulPending++;
+      psConn->ulRefs++;
+      pthread_mutex_unlock(&psConn->sLock);
+
+      pthread_mutex_lock(&sQueueLock);
+      if(psQueueTail == NULL)
+         psQueueHead = psJob;
+      else
+         psQueueTail->psNext = psJob;
+      psQueueTail = psJob;
+      pthread_cond_signal(&sQueueCond);
+      pthread_mutex_unlock(&sQueueLock);
+   }
+
+   FTBuf_consume(&psConn->sIn, ulConsumed);
+   return bIsValid;
+}
+
+/* Writes as much of psConn's waiting responses as the socket takes.
+   Returns FALSE if the connection should be closed: on a write error,
+   a lost response, or once a client that is done sending has every
+   response. */
+static boolean Ftd_flush(struct conn *psConn) {
+   ssize_t lWritten;
+   boolean bIsOpen = TRUE;
+
+   pthread_mutex_lock(&psConn->sLock);
+   if(!psConn->sOut.bIsValid)
+      bIsOpen = FALSE;
+   while(bIsOpen && psConn->sOut.ulLength != 0) {
+      lWritten = write(psConn->iFd, psConn->sOut.pcData,
+                       psConn->sOut.ulLength);
+      if(lWritten < 0) {
+         if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            bIsOpen = FALSE;
+         if(errno != EINTR)
+            break;
+         continue;
+      }
+      FTBuf_consume(&psConn->sOut, (size_t) lWritten);
+   }
+   if(psConn->bReadDone && psConn->ulPending == 0 &&
+      psConn->sOut.ulLength == 0)
+      bIsOpen = FALSE;
+   pthread_mutex_unlock(&psConn->sLock);
+   return bIsOpen;
+}
+
+/* Reads what psConn's client has sent and queues the requests in it.
+   Returns FALSE if the connection should be closed. */
+static boolean Ftd_receive(struct conn *psConn) {
+   char acChunk[READ_CHUNK];
+   ssize_t lRead;
+
+   for(;;) {
+      lRead = read(psConn->iFd, acChunk, sizeof(acChunk));
+      if(lRead > 0) {
+         FTBuf_putBytes(&psConn->sIn, acChunk, (size_t) lRead);
+         if(!psConn->sIn.bIsValid)
+            return FALSE;
+         if((size_t) lRead < sizeof(acChunk))
+            break;
+         continue;
+      }
+      if(lRead == 0) {
+         psConn->bReadDone = TRUE;
+         break;
+      }
+      if(errno == EINTR)
+         continue;
+      if(errno == EAGAIN || errno == EWOULDBLOCK)
+         break;
+      return FALSE;
+   }
+   return Ftd_queueRequests(psConn);
+}
+
+/* Handles an event on psConn. */
+static void Ftd_serviceConn(struct conn *psConn, unsigned int uEvents) {
+   boolean bIsOpen = TRUE;
+
+   /* A hung-up client cannot receive responses, so stop at once */
+   if(uEvents & (EPOLLHUP | EPOLLERR)) {
+      Ftd_closeConn(psConn);
+      return;
+   }
+   if(uEvents & EPOLLIN)
+      bIsOpen = Ftd_receive(psConn);
+   if(bIsOpen)
+      bIsOpen = Ftd_queueRequests(psConn) && Ftd_flush(psConn) &&
+                Ftd_updateEvents(psConn);
+   if(!bIsOpen)
+      Ftd_closeConn(psConn);
+}
+
+/* Writes out the responses of every connection on the ready list. */
+static void Ftd_serviceReady(void) {
+   struct conn *psConn, *psNext;
+   char acDrain[256];
+   boolean bIsClosed;
+
+   while(read(aiWakePipe[0], acDrain, sizeof(acDrain)) > 0)
+      ;
+
+   pthread_mutex_lock(&sReadyLock);
+   psConn = psReadyList;
+   psReadyList = NULL;
+   pthread_mutex_unlock(&sReadyLock);
+
+   for(; psConn != NULL; psConn = psNext) {
+      pthread_mutex_lock(&psConn->sLock);
+      psNext = psConn->psNextReady;
+      psConn->bIsReady = FALSE;
+      bIsClosed = psConn->bIsClosed;
+      pthread_mutex_unlock(&psConn->sLock);
+
+      /* A finished job may have made room in the pipeline, so parse
+         any requests held back before flushing */
+      if(!bIsClosed)
+         Ftd_serviceConn(psConn, 0);
+      Ftd_releaseConn(psConn);
+   }
+}
+
+/* Accepts every waiting connection on the listening socket iListenFd. */
+static void Ftd_accept(int iListenFd) {
+   struct epoll_event sEvent;
+   struct conn *psConn;
+   int iFd;
+
+   while((iFd = accept(iListenFd, NULL, NULL)) >= 0) {
+      psConn = malloc(sizeof(struct conn));
+      if(psConn == NULL ||
+         fcntl(iFd, F_SETFL, fcntl(iFd, F_GETFL) | O_NONBLOCK) != 0) {
+         free(psConn);
+         close(iFd);
+         continue;
+      }
+      psConn->iFd = iFd;
+      FTBuf_init(&psConn->sIn);
+      FTBuf_init(&psConn->sOut);
+      psConn->uEvents = EPOLLIN;
+      psConn->bReadDone = FALSE;
+      pthread_mutex_init(&psConn->sLock, NULL);
+      psConn->ulPending = 0;
+      psConn->ulRefs = 1;
+      psConn->bIsReady = FALSE;
+      psConn->bIsClosed = FALSE;
+      psConn->psNextReady = NULL;
+      psConn->ulSlot = DynArray_getLength(oDConns);
+
+      memset(&sEvent, 0, sizeof(sEvent));
+      sEvent.events = EPOLLIN;
+      sEvent.data.ptr = psConn;
+      if(!DynArray_add(oDConns, psConn)) {
+         close(iFd);
+         Ftd_releaseConn(psConn);
+         continue;
+      }
+      if(epoll_ctl(iEpollFd, EPOLL_CTL_ADD, iFd, &sEvent) != 0)
+         Ftd_closeConn(psConn);
+   }
+}
+
+/* Runs the event loop on listening socket iListenFd until a stop is
+   requested. Returns 0 on a clean stop, 1 if epoll fails. */
+static int Ftd_loop(int iListenFd) {
+   struct epoll_event asEvents[MAX_EVENTS];
+   boolean bIsWoken;
+   int iCount, i;
+
+   while(!iStopSignal) {
+      iCount = epoll_wait(iEpollFd, asEvents, MAX_EVENTS, -1);
+      if(iCount < 0) {
+         if(errno == EINTR)
+            continue;
+         perror("ftd: epoll_wait");
+         return 1;
+      }
+      /* Ready connections are serviced after the batch, since doing
+         so may close connections that later events refer to */
+      bIsWoken = FALSE;
+      for(i = 0; i < iCount; i++) {
+         if(asEvents[i].data.ptr == &cListenTag)
+            Ftd_accept(iListenFd);
+         else if(asEvents[i].data.ptr == &cWakeTag)
+            bIsWoken = TRUE;
+         else
+            Ftd_serviceConn(asEvents[i].data.ptr, asEvents[i].events);
+      }
+      if(bIsWoken)
+         Ftd_serviceReady();
+   }
+   return 0;
+}
+
+/* Creates the listening socket at pcSocketPath and the epoll instance
+   watching it and the wake pipe. Returns the socket, or -1 (after
+   printing why) on failure. */
+static int Ftd_listen(const char *pcSocketPath) {
+   struct sockaddr_un sAddr;
+   struct epoll_event sEvent;
+   int iFd;
+
+   if(strlen(pcSocketPath) >= sizeof(sAddr.sun_path)) {
+      fprintf(stderr, "ftd: socket path too long\n");
+      return -1;
+   }
+   memset(&sAddr, 0, sizeof(sAddr));
+   sAddr.sun_family = AF_UNIX;
+   strcpy(sAddr.sun_path, pcSocketPath);
+
+   iFd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if(iFd < 0) {
+      perror("ftd: socket");
+      return -1;
+   }
+   (void) unlink(pcSocketPath);
+   if(bind(iFd, (struct sockaddr *) &sAddr, sizeof(sAddr)) != 0 ||
+      listen(iFd, SOMAXCONN) != 0 ||
+      fcntl(iFd, F_SETFL, fcntl(iFd, F_GETFL) | O_NONBLOCK) != 0) {
+      perror("ftd: bind");
+      close(iFd);
+      return -1;
+   }
+
+   iEpollFd = epoll_create(MAX_EVENTS);
+   if(iEpollFd < 0 || pipe(aiWakePipe) != 0 ||
+      fcntl(aiWakePipe[0], F_SETFL, O_NONBLOCK) != 0 ||
+      fcntl(aiWakePipe[1], F_SETFL, O_NONBLOCK) != 0) {
+      perror("ftd: epoll");
+      close(iFd);
+      return -1;
+   }
+   memset(&sEvent, 0, sizeof(sEvent));
+   sEvent.events = EPOLLIN;
+   sEvent.data.ptr = &cListenTag;
+   (void) epoll_ctl(iEpollFd, EPOLL_CTL_ADD, iFd, &sEvent);
+   sEvent.data.ptr = &cWakeTag;
+   (void) epoll_ctl(iEpollFd, EPOLL_CTL_ADD, aiWakePipe[0], &sEvent);
+   return iFd;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   pthread_t *psThreads;
+   pthread_t sScrubThread;
+   boolean bIsScrubbing = FALSE;
+   struct sigaction sAction;
+   const char *pcSocketPath;
+   char *pcDefaultSpill = NULL;
+   size_t ulThreads = DEFAULT_THREADS, i;
+   int iListenFd, iStatus, iArg;
+
+   if(argc < 2 || argc % 2 != 0) {
+      fprintf(stderr, "Usage: %s socketpath [-t threads] [-b budget] "
+              "[-s spillpath] [-c scrubrate]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   pcSocketPath = argv[1];
+   for(iArg = 2; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-t") == 0)
+         ulThreads = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-b") == 0)
+         ulBudget = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         pcSpillPath = argv[iArg + 1];
+      else if(strcmp(argv[iArg], "-c") == 0)
+         ulScrubRate = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   if(ulThreads == 0)
+      ulThreads = 1;
+   if(pcSpillPath == NULL) {
+      pcDefaultSpill = malloc(strlen(pcSocketPath) + sizeof(".spill"));
+      if(pcDefaultSpill == NULL)
+         return EXIT_FAILURE;
+      strcpy(pcDefaultSpill, pcSocketPath);
+      strcat(pcDefaultSpill, ".spill");
+      pcSpillPath = pcDefaultSpill;
+   }
+
+   /* Serve an empty, initialized tree from the start */
+   if(FT_init() != SUCCESS ||
+      FT_setContentBudget(ulBudget, pcSpillPath) != SUCCESS) {
+      fprintf(stderr, "%s: cannot create spill file %s\n", argv[0],
+              pcSpillPath);
+      return EXIT_FAILURE;
+   }
+   if(ulScrubRate != 0)
+      (void) FT_enableChecksums();
+
+   oDConns = DynArray_new(0);
+   psThreads = malloc(ulThreads * sizeof(pthread_t));
+   iListenFd = Ftd_listen(pcSocketPath);
+   if(oDConns == NULL || psThreads == NULL || iListenFd < 0)
+      return EXIT_FAILURE;
+
+   /* Stop cleanly on SIGINT and SIGTERM; report broken connections as
+      write errors rather than dying */
+   memset(&sAction, 0, sizeof(sAction));
+   sAction.sa_handler = Ftd_onSignal;
+   (void) sigaction(SIGINT, &sAction, NULL);
+   (void) sigaction(SIGTERM, &sAction, NULL);
+   sAction.sa_handler = SIG_IGN;
+   (void) sigaction(SIGPIPE, &sAction, NULL);
+
+   pthread_rwlock_init(&sTreeLock, NULL);
+   pthread_mutex_init(&sQueueLock, NULL);
+   pthread_cond_init(&sQueueCond, NULL);
+   pthread_cond_init(&sScrubCond, NULL);
+   pthread_mutex_init(&sReadyLock, NULL);
+   for(i = 0; i < ulThreads; i++)
+      if(pthread_create(&psThreads[i], NULL, Ftd_worker, NULL) != 0)
+         break;
+   ulThreads = i;
+   if(ulScrubRate != 0)
+      bIsScrubbing = (boolean) (pthread_create(&sScrubThread, NULL,
+                                               Ftd_scrubber, NULL) == 0);
+
+   iStatus = ulThreads == 0 ? 1 : Ftd_loop(iListenFd);
+
+   /* Let the workers finish the queue, then tear everything down */
+   pthread_mutex_lock(&sQueueLock);
+   bIsStopping = TRUE;
+   pthread_cond_broadcast(&sQueueCond);
+   pthread_cond_signal(&sScrubCond);
+   pthread_mutex_unlock(&sQueueLock);
+   for(i = 0; i < ulThreads; i++)
+      pthread_join(psThreads[i], NULL);
+   if(bIsScrubbing)
+      pthread_join(sScrubThread, NULL);
+   Ftd_serviceReady();
+   while(DynArray_getLength(oDConns) != 0)
+      Ftd_closeConn(DynArray_get(oDConns, 0));
+
+   close(iListenFd);
+   (void) unlink(pcSocketPath);
+   close(iEpollFd);
+   close(aiWakePipe[0]);
+   close(aiWakePipe[1]);
+   DynArray_free(oDConns);
+   free(psThreads);
+   (void) FT_destroy();
+   (void) unlink(pcSpillPath);
+   free(pcDefaultSpill);
+   return iStatus == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,659 @@
+/*--------------------------------------------------------------------*/
+/* ftfrozen.c                                                         */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* open, fstat and mmap are POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "path.h"
+#include "image.h"
+#include "nodef.h"
+#include "ftfrozen.h"
+
+/* Identifies an image as a frozen FT */
+enum { FTFROZEN_MAGIC = 0x4654465A };
+
+/* Alignment of every region in an image */
+enum { FTFROZEN_ALIGN = sizeof(unsigned long) };
+
+/* Average number of records sharing a bucket of the perfect hash */
+enum { FTFROZEN_BUCKET_LOAD = 4 };
+
+/* Displacements tried for one bucket before the whole hash is built
+   again under another seed */
+enum { FTFROZEN_MAX_DISPLACE = 1 << 20 };
+
+/* The start of an image. Offsets in an image are from here. */
+struct frozenHeader {
+   /* FTFROZEN_MAGIC */
+   unsigned long ulMagic;
+
+   /* sizeof(unsigned long) where the image was built */
+   unsigned long ulWordSize;
+
+   /* Bytes in the image */
+   unsigned long ulSize;
+
+   /* Seed of the pathname hash */
+   unsigned long ulSeed;
+
+   /* Offset and length of the array of records, one per node, each
+      in the slot the perfect hash gives its pathname */
+   unsigned long ulRecordsOff;
+   unsigned long ulNumRecords;
+
+   /* Offset and length of the array of per-bucket displacements */
+   unsigned long ulDisplaceOff;
+   unsigned long ulNumBuckets;
+
+   /* Offset and length of the string pool, which is the FT_toString
+      text of the tree (NUL-terminated) */
+   unsigned long ulTextOff;
+   unsigned long ulTextLen;
+
+   /* Length of the root's pathname, the pool's first line (0 for an
+      empty tree) */
+   unsigned long ulRootLen;
+};
+
+/* A directory or file in an image */
+struct frozenRecord {
+   /* Offset and length of the pathname (not NUL-terminated) */
+   unsigned long ulPathOff;
+   unsigned long ulPathLen;
+
+   /* 1 for a file, 0 for a directory */
+   unsigned long ulIsFile;
+
+   /* Files: offset and length of the contents; offset 0 for NULL */
+   unsigned long ulContentsOff;
+   unsigned long ulContentsLen;
+};
+
+/* A frozen image */
+struct ftFrozen {
+   /* Start of the image */
+   char *pcBase;
+
+   /* Bytes in the image */
+   size_t ulSize;
+
+   /* Whether the image is mapped from a file rather than allocated */
+   boolean bIsMapped;
+};
+
+/* An image being written, in the order of FT_toString */
+struct frozenBuilder {
+   /* Start of the image */
+   char *pcBase;
+
+   /* Records written so far, in pool order (not yet hashed) */
+   struct frozenRecord *psRecords;
+   size_t ulNumRecords;
+
+   /* Bytes of the string pool and of contents written so far */
+   size_t ulTextLen;
+   size_t ulContentsUsed;
+
+   /* Where the string pool and the contents start */
+   size_t ulTextOff;
+   size_t ulContentsOff;
+};
+
+/* A bucket of the perfect hash while it is built */
+struct frozenBucket {
+   /* The bucket's number and how many records hash to it */
+   size_t ulBucket;
+   size_t ulSize;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns ulSize rounded up to a multiple of FTFROZEN_ALIGN. */
+static size_t FTFrozen_align(size_t ulSize) {
+   return (ulSize + FTFROZEN_ALIGN - 1) / FTFROZEN_ALIGN *
+          FTFROZEN_ALIGN;
+}
+
+/* Returns ulValue with its bits thoroughly mixed. */
+static unsigned long FTFrozen_mix(unsigned long ulValue) {
+   ulValue ^= ulValue >> 30;
+   ulValue *= 0xbf58476d1ce4e5b9UL;
+   ulValue ^= ulValue >> 27;
+   ulValue *= 0x94d049bb133111ebUL;
+   ulValue ^= ulValue >> 31;
+   return ulValue;
+}
+
+/* Returns the hash under ulSeed of the ulLength characters at
+   pcPath: FNV-1a, mixed so every bit depends on every character. */
+static unsigned long FTFrozen_hash(const char *pcPath, size_t ulLength,
+                                   unsigned long ulSeed) {
+   unsigned long ulHash = 0xcbf29ce484222325UL ^ ulSeed;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++)
+      ulHash = (ulHash ^ (unsigned char) pcPath[i]) * 0x100000001b3UL;
+   return FTFrozen_mix(ulHash);
+}
+
+/* Returns the slot of ulNumRecords that a pathname hashing to ulHash
+   takes under displacement ulDisplace. */
+static size_t FTFrozen_slot(unsigned long ulHash, unsigned long ulDisplace,
+                            size_t ulNumRecords) {
+   return (size_t) (FTFrozen_mix(ulHash + ulDisplace *
+                                 0x9e3779b97f4a7c15UL) % ulNumRecords);
+}
+
+/* Counts the records, string pool bytes and contents bytes an image
+   of the subtree rooted at oNdNode needs, adding them to *pulRecords,
+   *pulText and *pulContents. */
+static void FTFrozen_measure(NodeD_T oNdNode, size_t *pulRecords,
+                             size_t *pulText, size_t *pulContents) {
+   NodeF_T oNfChild;
+   NodeD_T oNdChild;
+   size_t i;
+
+   assert(oNdNode != NULL);
+
+   *pulRecords += 1;
+   *pulText += Path_getStrLength(NodeD_getPath(oNdNode)) + 1;
+   for(i = 0; i < NodeD_getNumFileChildren(oNdNode); i++) {
+      (void) NodeD_getFileChild(oNdNode, i, &oNfChild);
+      *pulRecords += 1;
+      *pulText += Path_getStrLength(NodeF_getPath(oNfChild)) + 1;
+      /* Reserve at least one byte so that the offset is never 0 */
+      if(NodeF_getContents(oNfChild) != NULL)
+         *pulContents += FTFrozen_align(NodeF_getLength(oNfChild) == 0 ?
+                                        1 : NodeF_getLength(oNfChild));
+   }
+   for(i = 0; i < NodeD_getNumDirChildren(oNdNode); i++) {
+      (void) NodeD_getDirChild(oNdNode, i, &oNdChild);
+      FTFrozen_measure(oNdChild, pulRecords, pulText, pulContents);
+   }
+}
+
+/* Appends a line for pathname oPPath to psBuilder's string pool and
+   returns a new record for it. */
+static struct frozenRecord *FTFrozen_addRecord(
+      struct frozenBuilder *psBuilder, Path_T oPPath) {
+   struct frozenRecord *psRecord;
+   size_t ulPathLen;
+   char *pcLine;
+
+   assert(psBuilder != NULL);
+   assert(oPPath != NULL);
+
+   ulPathLen = Path_getStrLength(oPPath);
+   pcLine = psBuilder->pcBase + psBuilder->ulTextOff +
+            psBuilder->ulTextLen;
+   memcpy(pcLine, Path_getPathname(oPPath), ulPathLen);
+   pcLine[ulPathLen] = '\n';
+
+   psRecord = &psBuilder->psRecords[psBuilder->ulNumRecords++];
+   psRecord->ulPathOff = psBuilder->ulTextOff + psBuilder->ulTextLen;
+   psRecord->ulPathLen = ulPathLen;
+   psRecord->ulIsFile = 0;
+   psRecord->ulContentsOff = 0;
+   psRecord->ulContentsLen = 0;
+   psBuilder->ulTextLen += ulPathLen + 1;
+   return psRecord;
+}
+
+/* Writes the subtree rooted at oNdNode into psBuilder: the directory,
+   its files, then its subdirectories, as FT_toString lists them. */
+static void FTFrozen_fill(struct frozenBuilder *psBuilder,
+                          NodeD_T oNdNode) {
+   struct frozenRecord *psRecord;
+   NodeF_T oNfChild;
+   NodeD_T oNdChild;
+   void *pvContents;
+   size_t ulLength;
+   size_t i;
+
+   assert(psBuilder != NULL);
+   assert(oNdNode != NULL);
+
+   (void) FTFrozen_addRecord(psBuilder, NodeD_getPath(oNdNode));
+   for(i = 0; i < NodeD_getNumFileChildren(oNdNode); i++) {
+      (void) NodeD_getFileChild(oNdNode, i, &oNfChild);
+      psRecord = FTFrozen_addRecord(psBuilder, NodeF_getPath(oNfChild));
+      psRecord->ulIsFile = 1;
+
+      ulLength = NodeF_getLength(oNfChild);
+      psRecord->ulContentsLen = ulLength;
+      pvContents = NodeF_getContents(oNfChild);
+      if(pvContents != NULL) {
+         psRecord->ulContentsOff = psBuilder->ulContentsOff +
+                                   psBuilder->ulContentsUsed;
+         memcpy(psBuilder->pcBase + psRecord->ulContentsOff, pvContents,
+                ulLength);
+         psBuilder->ulContentsUsed += FTFrozen_align(ulLength == 0 ?
+                                                     1 : ulLength);
+      }
+   }
+   for(i = 0; i < NodeD_getNumDirChildren(oNdNode); i++) {
+      (void) NodeD_getDirChild(oNdNode, i, &oNdChild);
+      FTFrozen_fill(psBuilder, oNdChild);
+   }
+}
+
+/* Orders buckets from largest to smallest, for qsort. */
+static int FTFrozen_compareBuckets(const void *pvFirst,
+                                   const void *pvSecond) {
+   const struct frozenBucket *psFirst = pvFirst;
+   const struct frozenBucket *psSecond = pvSecond;
+
+   if(psFirst->ulSize != psSecond->ulSize)
+      return psFirst->ulSize > psSecond->ulSize ? -1 : 1;
+   return psFirst->ulBucket < psSecond->ulBucket ? -1 :
+          (psFirst->ulBucket > psSecond->ulBucket);
+}
+
+/*
+  Tries to build a minimal perfect hash under ulSeed for the ulNumKeys
+  pathnames hashing to pulHashes, by hash and displace: the pathnames
+  are spread over ulNumBuckets buckets, and each bucket, largest
+  first, gets the smallest displacement that sends all its pathnames
+  to free slots. Stores each bucket's displacement in pulDisplace and
+  each pathname's slot in pulSlots. Returns SUCCESS, MEMORY_ERROR, or
+  NO_SUCH_PATH if some bucket could not be placed under this seed.
+*/
+static int FTFrozen_place(const unsigned long *pulHashes,
+                          size_t ulNumKeys, size_t ulNumBuckets,
+                          unsigned long *pulDisplace, size_t *pulSlots) {
+   struct frozenBucket *psBuckets;
+   size_t *pulStarts;
+   size_t *pulKeys;
+   char *pcTaken;
+   unsigned long ulDisplace;
+   size_t ulBucket, ulKey, ulSlot, i, j;
+   int iStatus = SUCCESS;
+
+   psBuckets = calloc(ulNumBuckets, sizeof(struct frozenBucket));
+   pulStarts = calloc(ulNumBuckets + 1, sizeof(size_t));
+   pulKeys = malloc(ulNumKeys * sizeof(size_t));
+   pcTaken = calloc(ulNumKeys, 1);
+   if(psBuckets == NULL || pulStarts == NULL || pulKeys == NULL ||
+      pcTaken == NULL) {
+      free(psBuckets);
+      free(pulStarts);
+      free(pulKeys);
+      free(pcTaken);
+      return MEMORY_ERROR;
+   }
+
+   /* Group the keys by bucket */
+   for(ulKey = 0; ulKey < ulNumKeys; ulKey++)
+      pulStarts[pulHashes[ulKey] % ulNumBuckets + 1]++;
+   for(ulBucket = 0; ulBucket < ulNumBuckets; ulBucket++) {
+      psBuckets[ulBucket].ulBucket = ulBucket;
+      psBuckets[ulBucket].ulSize = pulStarts[ulBucket + 1];
+      pulStarts[ulBucket + 1] += pulStarts[ulBucket];
+   }
+   for(ulKey = 0; ulKey < ulNumKeys; ulKey++)
+      pulKeys[pulStarts[pulHashes[ulKey] % ulNumBuckets]++] = ulKey;
+   for(ulBucket = ulNumBuckets; ulBucket > 0; ulBucket--)
+      pulStarts[ulBucket] = pulStarts[ulBucket - 1];
+   pulStarts[0] = 0;
+   qsort(psBuckets, ulNumBuckets, sizeof(struct frozenBucket),
+         FTFrozen_compareBuckets);
+
+   for(i = 0; i < ulNumBuckets && psBuckets[i].ulSize != 0; i++) {
+      ulBucket = psBuckets[i].ulBucket;
+      for(ulDisplace = 0; ulDisplace < FTFROZEN_MAX_DISPLACE;
+          ulDisplace++) {
+         /* Claim slots until one is taken, then give them back */
+         for(j = 0; j < psBuckets[i].ulSize; j++) {
+            ulKey = pulKeys[pulStarts[ulBucket] + j];
+            ulSlot = FTFrozen_slot(pulHashes[ulKey], ulDisplace,
+                                   ulNumKeys);
+            if(pcTaken[ulSlot])
+               break;
+            pcTaken[ulSlot] = 1;
+            pulSlots[ulKey] = ulSlot;
+         }
+         if(j == psBuckets[i].ulSize)
+            break;
+         while(j > 0) {
+            j--;
+            pcTaken[pulSlots[pulKeys[pulStarts[ulBucket] + j]]] = 0;
+         }
+      }
+      if(ulDisplace == FTFROZEN_MAX_DISPLACE) {
+         iStatus = NO_SUCH_PATH;
+         break;
+      }
+      pulDisplace[ulBucket] = ulDisplace;
+   }
+
+   free(psBuckets);
+   free(pulStarts);
+   free(pulKeys);
+   free(pcTaken);
+   return iStatus;
+}
+
+/* Looks up pcPath in oFFrozen's image with one hash and one
+   comparison, storing its record in *ppsResult. Returns SUCCESS,
+   BAD_PATH, CONFLICTING_PATH, NO_SUCH_PATH, or INITIALIZATION_ERROR
+   if the record in the way is corrupt. */
+static int FTFrozen_find(FTFrozen_T oFFrozen, const char *pcPath,
+                         const struct frozenRecord **ppsResult) {
+   const struct frozenHeader *psHeader;
+   const struct frozenRecord *psRecord;
+   const char *pcText;
+   unsigned long ulHash;
+   size_t ulLength, ulSlot;
+
+   assert(oFFrozen != NULL);
+   assert(pcPath != NULL);
+   assert(ppsResult != NULL);
+
+   *ppsResult = NULL;
+   if(!Image_isWellFormed(pcPath))
+      return BAD_PATH;
+
+   psHeader = (const struct frozenHeader *) (void *) oFFrozen->pcBase;
+   if(psHeader->ulNumRecords == 0)
+      return NO_SUCH_PATH;
+
+   /* The root must be the first component */
+   pcText = oFFrozen->pcBase + psHeader->ulTextOff;
+   ulLength = strcspn(pcPath, "/");
+   if(ulLength != psHeader->ulRootLen ||
+      memcmp(pcText, pcPath, ulLength) != 0)
+      return CONFLICTING_PATH;
+
+   ulLength += strlen(pcPath + ulLength);
+   ulHash = FTFrozen_hash(pcPath, ulLength, psHeader->ulSeed);
+   ulSlot = FTFrozen_slot(ulHash, ((const unsigned long *) (const void *)
+               (oFFrozen->pcBase + psHeader->ulDisplaceOff))
+               [ulHash % psHeader->ulNumBuckets],
+               psHeader->ulNumRecords);
+   psRecord = (const struct frozenRecord *) (const void *)
+              (oFFrozen->pcBase + psHeader->ulRecordsOff) + ulSlot;
+
+   if(!Image_fits(oFFrozen->ulSize, psRecord->ulPathOff,
+                  psRecord->ulPathLen, 1) ||
+      (psRecord->ulIsFile && psRecord->ulContentsOff != 0 &&
+       !Image_fits(oFFrozen->ulSize, psRecord->ulContentsOff,
+                   psRecord->ulContentsLen, 1)))
+      return INITIALIZATION_ERROR;
+   if(psRecord->ulPathLen != ulLength ||
+      memcmp(oFFrozen->pcBase + psRecord->ulPathOff, pcPath,
+             ulLength) != 0)
+      return NO_SUCH_PATH;
+
+   *ppsResult = psRecord;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTFrozen_build(NodeD_T oNdRoot, FTFrozen_T *poFResult) {
+   FTFrozen_T oFFrozen;
+   struct frozenHeader *psHeader;
+   struct frozenBuilder sBuilder;
+   struct frozenRecord *psRecords;
+   unsigned long *pulHashes;
+   unsigned long *pulDisplace;
+   size_t *pulSlots;
+   size_t ulNumRecords = 0, ulTextLen = 0, ulContentsLen = 0;
+   size_t ulNumBuckets, ulDisplaceOff, ulRecordsOff, ulSize, i;
+   unsigned long ulSeed;
+   int iStatus;
+
+   assert(poFResult != NULL);
+
+   *poFResult = NULL;
+   if(oNdRoot != NULL)
+      FTFrozen_measure(oNdRoot, &ulNumRecords, &ulTextLen,
+                       &ulContentsLen);
+   ulNumBuckets = ulNumRecords / FTFROZEN_BUCKET_LOAD + 1;
+
+   /* Header, displacements, records, string pool, contents */
+   ulDisplaceOff = FTFrozen_align(sizeof(struct frozenHeader));
+   ulRecordsOff = ulDisplaceOff + ulNumBuckets * sizeof(unsigned long);
+   sBuilder.ulTextOff = ulRecordsOff +
+                        ulNumRecords * sizeof(struct frozenRecord);
+   sBuilder.ulContentsOff = sBuilder.ulTextOff +
+                            FTFrozen_align(ulTextLen + 1);
+   ulSize = sBuilder.ulContentsOff + ulContentsLen;
+
+   oFFrozen = malloc(sizeof(struct ftFrozen));
+   sBuilder.pcBase = calloc(ulSize, 1);
+   sBuilder.psRecords = malloc(ulNumRecords *
+                               sizeof(struct frozenRecord) + 1);
+   pulHashes = malloc(ulNumRecords * sizeof(unsigned long) + 1);
+   pulSlots = malloc(ulNumRecords * sizeof(size_t) + 1);
+   if(oFFrozen == NULL || sBuilder.pcBase == NULL ||
+      sBuilder.psRecords == NULL || pulHashes == NULL ||
+      pulSlots == NULL) {
+      free(oFFrozen);
+      free(sBuilder.pcBase);
+      free(sBuilder.psRecords);
+      free(pulHashes);
+      free(pulSlots);
+      return MEMORY_ERROR;
+   }
+
+   /* Lay out the string pool and contents in FT_toString order */
+   sBuilder.ulNumRecords = 0;
+   sBuilder.ulTextLen = 0;
+   sBuilder.ulContentsUsed = 0;
+   if(oNdRoot != NULL)
+      FTFrozen_fill(&sBuilder, oNdRoot);
+   assert(sBuilder.ulNumRecords == ulNumRecords);
+   assert(sBuilder.ulTextLen == ulTextLen);
+
+   /* Hash the pathnames, trying seeds until every bucket places */
+   pulDisplace = (unsigned long *) (void *)
+                 (sBuilder.pcBase + ulDisplaceOff);
+   iStatus = (ulNumRecords == 0) ? SUCCESS : NO_SUCH_PATH;
+   for(ulSeed = 0; iStatus == NO_SUCH_PATH; ulSeed++) {
+      for(i = 0; i < ulNumRecords; i++)
+         pulHashes[i] = FTFrozen_hash(
+            sBuilder.pcBase + sBuilder.psRecords[i].ulPathOff,
+            sBuilder.psRecords[i].ulPathLen, ulSeed);
+      iStatus = FTFrozen_place(pulHashes, ulNumRecords, ulNumBuckets,
+                               pulDisplace, pulSlots);
+   }
+   if(iStatus != SUCCESS) {
+      free(oFFrozen);
+      free(sBuilder.pcBase);
+      free(sBuilder.psRecords);
+      free(pulHashes);
+      free(pulSlots);
+      return iStatus;
+   }
+
+   psRecords = (struct frozenRecord *) (void *)
+               (sBuilder.pcBase + ulRecordsOff);
+   for(i = 0; i < ulNumRecords; i++)
+      psRecords[pulSlots[i]] = sBuilder.psRecords[i];
+   free(sBuilder.psRecords);
+   free(pulHashes);
+   free(pulSlots);
+
+   psHeader = (struct frozenHeader *) (void *) sBuilder.pcBase;
+   psHeader->ulMagic = FTFROZEN_MAGIC;
+   psHeader->ulWordSize = sizeof(unsigned long);
+   psHeader->ulSize = ulSize;
+   psHeader->ulSeed = (ulSeed == 0) ? 0 : ulSeed - 1;
+   psHeader->ulRecordsOff = ulRecordsOff;
+   psHeader->ulNumRecords = ulNumRecords;
+   psHeader->ulDisplaceOff = ulDisplaceOff;
+   psHeader->ulNumBuckets = ulNumBuckets;
+   psHeader->ulTextOff = sBuilder.ulTextOff;
+   psHeader->ulTextLen = ulTextLen;
+   psHeader->ulRootLen = (oNdRoot == NULL) ? 0 :
+                         Path_getStrLength(NodeD_getPath(oNdRoot));
+
+   oFFrozen->pcBase = sBuilder.pcBase;
+   oFFrozen->ulSize = ulSize;
+   oFFrozen->bIsMapped = FALSE;
+   *poFResult = oFFrozen;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTFrozen_write(FTFrozen_T oFFrozen, const char *pcFile) {
+   FILE *psFile;
+   size_t ulWritten;
+
+   assert(oFFrozen != NULL);
+   assert(pcFile != NULL);
+
+   psFile = fopen(pcFile, "wb");
+   if(psFile == NULL)
+      return BAD_PATH;
+   ulWritten = fwrite(oFFrozen->pcBase, 1, oFFrozen->ulSize, psFile);
+   if(fclose(psFile) != 0 || ulWritten != oFFrozen->ulSize)
+      return BAD_PATH;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTFrozen_map(const char *pcFile, FTFrozen_T *poFResult) {
+   FTFrozen_T oFFrozen;
+   const struct frozenHeader *psHeader;
+   struct stat sStat;
+   size_t ulSize;
+   int iFd;
+   void *pvMap;
+
+   assert(pcFile != NULL);
+   assert(poFResult != NULL);
+
+   *poFResult = NULL;
+   iFd = open(pcFile, O_RDONLY);
+   if(iFd < 0)
+      return errno == ENOENT ? NO_SUCH_PATH : BAD_PATH;
+   if(fstat(iFd, &sStat) != 0) {
+      close(iFd);
+      return BAD_PATH;
+   }
+   ulSize = (size_t) sStat.st_size;
+   if(ulSize < sizeof(struct frozenHeader)) {
+      close(iFd);
+      return INITIALIZATION_ERROR;
+   }
+
+   oFFrozen = malloc(sizeof(struct ftFrozen));
+   if(oFFrozen == NULL) {
+      close(iFd);
+      return MEMORY_ERROR;
+   }
+   pvMap = mmap(NULL, ulSize, PROT_READ, MAP_PRIVATE, iFd, 0);
+   close(iFd);
+   if(pvMap == MAP_FAILED) {
+      free(oFFrozen);
+      return BAD_PATH;
+   }
+   oFFrozen->pcBase = pvMap;
+   oFFrozen->ulSize = ulSize;
+   oFFrozen->bIsMapped = TRUE;
+
+   /* The regions the header points at are checked once here; the
+      offsets in records are checked as lookups reach them */
+   psHeader = (const struct frozenHeader *) pvMap;
+   if(psHeader->ulMagic != FTFROZEN_MAGIC ||
+      psHeader->ulWordSize != sizeof(unsigned long) ||
+      psHeader->ulSize != ulSize ||
+      psHeader->ulDisplaceOff % FTFROZEN_ALIGN != 0 ||
+      psHeader->ulRecordsOff % FTFROZEN_ALIGN != 0 ||
+      psHeader->ulNumBuckets == 0 ||
+      !Image_fits(ulSize, psHeader->ulDisplaceOff,
+                  psHeader->ulNumBuckets, sizeof(unsigned long)) ||
+      !Image_fits(ulSize, psHeader->ulRecordsOff,
+                  psHeader->ulNumRecords,
+                  sizeof(struct frozenRecord)) ||
+      !Image_fits(ulSize, psHeader->ulTextOff,
+                  psHeader->ulTextLen + 1, 1) ||
+      psHeader->ulRootLen > psHeader->ulTextLen ||
+      oFFrozen->pcBase[psHeader->ulTextOff + psHeader->ulTextLen]
+         != '\0') {
+      FTFrozen_free(oFFrozen);
+      return INITIALIZATION_ERROR;
+   }
+
+   *poFResult = oFFrozen;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void FTFrozen_free(FTFrozen_T oFFrozen) {
+   assert(oFFrozen != NULL);
+
+   if(oFFrozen->bIsMapped)
+      (void) munmap(oFFrozen->pcBase, oFFrozen->ulSize);
+   else
+      free(oFFrozen->pcBase);
+   free(oFFrozen);
+}
+
+/* ================================================================== */
+int FTFrozen_stat(FTFrozen_T oFFrozen, const char *pcPath,
+                  boolean *pbIsFile, size_t *pulSize) {
+   const struct frozenRecord *psRecord;
+   int iStatus;
+
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   iStatus = FTFrozen_find(oFFrozen, pcPath, &psRecord);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   *pbIsFile = (boolean) (psRecord->ulIsFile != 0);
+   if(*pbIsFile)
+      *pulSize = psRecord->ulContentsLen;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTFrozen_getFileContents(FTFrozen_T oFFrozen, const char *pcPath,
+                             void **ppvResult) {
+   const struct frozenRecord *psRecord;
+   int iStatus;
+
+   assert(ppvResult != NULL);
+
+   *ppvResult = NULL;
+   iStatus = FTFrozen_find(oFFrozen, pcPath, &psRecord);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!psRecord->ulIsFile)
+      return NOT_A_FILE;
+
+   if(psRecord->ulContentsOff != 0)
+      *ppvResult = oFFrozen->pcBase + psRecord->ulContentsOff;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+char *FTFrozen_toString(FTFrozen_T oFFrozen) {
+   const struct frozenHeader *psHeader;
+   char *pcResult;
+
+   assert(oFFrozen != NULL);
+
+   psHeader = (const struct frozenHeader *) (void *) oFFrozen->pcBase;
+   pcResult = malloc(psHeader->ulTextLen + 1);
+   if(pcResult == NULL)
+      return NULL;
+   memcpy(pcResult, oFFrozen->pcBase + psHeader->ulTextOff,
+          psHeader->ulTextLen + 1);
+   return pcResult;
+}
@@ -0,0 +1,77 @@
+/*--------------------------------------------------------------------*/
+/* ftfrozen.h                                                         */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTFROZEN_INCLUDED
+#define FTFROZEN_INCLUDED
+
+/*
+  A frozen FT is a read-only image of a File Tree in one contiguous
+  block: a record per directory and file, placed by a minimal perfect
+  hash of its absolute pathname, one string pool holding every
+  pathname, and the files' contents. The string pool is laid out as
+  the FT_toString text of the tree, so that text comes for free. Every
+  reference in the image is an offset, so it can be written to a file
+  and mapped back in at any address.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "noded.h"
+
+/* An FTFrozen_T is a frozen image, built in memory or mapped in */
+typedef struct ftFrozen *FTFrozen_T;
+
+/*
+  Builds a frozen image of the tree rooted at oNdRoot (NULL for an
+  empty tree), copying in every file's contents. Returns SUCCESS and
+  sets *poFResult if successful. Otherwise, sets *poFResult to NULL
+  and returns MEMORY_ERROR.
+*/
+int FTFrozen_build(NodeD_T oNdRoot, FTFrozen_T *poFResult);
+
+/*
+  Writes oFFrozen's image to the file named pcFile, replacing it.
+  Returns SUCCESS, or BAD_PATH if the file could not be written.
+*/
+int FTFrozen_write(FTFrozen_T oFFrozen, const char *pcFile);
+
+/*
+  Maps the image in the file named pcFile for reading. Returns SUCCESS
+  and sets *poFResult if successful. Otherwise, sets *poFResult to
+  NULL and returns:
+  * NO_SUCH_PATH if there is no such file
+  * INITIALIZATION_ERROR if the file is not a frozen FT
+  * BAD_PATH if the file could not be mapped
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FTFrozen_map(const char *pcFile, FTFrozen_T *poFResult);
+
+/* Frees or unmaps oFFrozen's image and frees oFFrozen. */
+void FTFrozen_free(FTFrozen_T oFFrozen);
+
+/*
+  Behaves like FT_stat on oFFrozen's image. Also returns
+  INITIALIZATION_ERROR if the record found for pcPath is corrupt.
+*/
+int FTFrozen_stat(FTFrozen_T oFFrozen, const char *pcPath,
+                  boolean *pbIsFile, size_t *pulSize);
+
+/*
+  Stores in *ppvResult the contents of the file with absolute path
+  pcPath in oFFrozen's image (NULL if they are NULL); they lie inside
+  the image, which is read-only, and last as long as it does. Returns
+  SUCCESS, NOT_A_FILE if pcPath is a directory, or any status
+  FTFrozen_stat returns for pcPath.
+*/
+int FTFrozen_getFileContents(FTFrozen_T oFFrozen, const char *pcPath,
+                             void **ppvResult);
+
+/*
+  Returns a copy of the FT_toString text of oFFrozen's tree, or NULL
+  if there is an allocation error. The copy is owned by the caller.
+*/
+char *FTFrozen_toString(FTFrozen_T oFFrozen);
+
+#endif
@@ -0,0 +1,453 @@
+/*--------------------------------------------------------------------*/
+/* ftload.c                                                           */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  ftload measures an ftd server's throughput and latency.
+
+  Usage: ftload socketpath [-c conns] [-d depth] [-n requests]
+                           [-f files] [-s size] [-w writepct]
+
+  It first inserts files ftload/dI/fJ (f files of s bytes each) into
+  the server's tree, which must be empty or rooted at ftload. Then
+  each of c connections, on its own thread, issues n requests keeping
+  up to d of them outstanding: w percent replace a random file's
+  contents, and the rest are split between getting contents and
+  stat. It reports requests per second and latency percentiles, and
+  finally removes what it inserted.
+*/
+
+/* Sockets, threads and clock_gettime are POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "a4def.h"
+#include "ftproto.h"
+
+/* Files per directory of the generated tree */
+enum { FILES_PER_DIR = 64 };
+
+/* Bytes read from the socket at a time */
+enum { READ_CHUNK = 64 * 1024 };
+
+/* Largest generated pathname, including its terminator */
+enum { MAX_PATH = 64 };
+
+/* Settings shared by every connection */
+struct loadConfig {
+   /* The server's socket */
+   const char *pcSocketPath;
+
+   /* Requests per connection and how many may be outstanding */
+   size_t ulRequests;
+   size_t ulDepth;
+
+   /* Files in the tree and their size in bytes */
+   size_t ulFiles;
+   size_t ulSize;
+
+   /* Percent of requests that replace contents */
+   unsigned int uWritePct;
+};
+
+/* One connection's run */
+struct loadRun {
+   /* The shared settings */
+   const struct loadConfig *psConfig;
+
+   /* Seed of the connection's private random numbers */
+   unsigned long ulSeed;
+
+   /* When each request was sent, indexed by request ID */
+   double *pdSent;
+
+   /* Latency of each request in seconds, in order of completion */
+   double *pdLatency;
+
+   /* Responses received and those whose status was not SUCCESS */
+   size_t ulDone;
+   size_t ulErrors;
+
+   /* FALSE if the connection failed */
+   boolean bIsOk;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the current time in seconds from an arbitrary start. */
+static double FTLoad_now(void) {
+   struct timespec sNow;
+
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double) sNow.tv_sec + (double) sNow.tv_nsec / 1e9;
+}
+
+/* Returns the next number from the generator whose state is *pulSeed. */
+static unsigned long FTLoad_random(unsigned long *pulSeed) {
+   *pulSeed = *pulSeed * 1103515245UL + 12345UL;
+   return (*pulSeed >> 8) & 0xffffffUL;
+}
+
+/* Stores the pathname of generated file ulFile in pcPath. */
+static void FTLoad_filePath(char *pcPath, size_t ulFile) {
+   sprintf(pcPath, "ftload/d%lu/f%lu",
+           (unsigned long) (ulFile / FILES_PER_DIR),
+           (unsigned long) (ulFile % FILES_PER_DIR));
+}
+
+/* Connects to the server at pcSocketPath. Returns the socket, or -1
+   (after printing why) on failure. */
+static int FTLoad_connect(const char *pcSocketPath) {
+   struct sockaddr_un sAddr;
+   int iFd;
+
+   if(strlen(pcSocketPath) >= sizeof(sAddr.sun_path)) {
+      fprintf(stderr, "ftload: socket path too long\n");
+      return -1;
+   }
+   memset(&sAddr, 0, sizeof(sAddr));
+   sAddr.sun_family = AF_UNIX;
+   strcpy(sAddr.sun_path, pcSocketPath);
+
+   iFd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if(iFd < 0 ||
+      connect(iFd, (struct sockaddr *) &sAddr, sizeof(sAddr)) != 0) {
+      perror("ftload: connect");
+      if(iFd >= 0)
+         close(iFd);
+      return -1;
+   }
+   return iFd;
+}
+
+/* Writes all of *psBuf to iFd and empties it. Returns FALSE on error. */
+static boolean FTLoad_send(int iFd, struct FTBuf *psBuf) {
+   ssize_t lWritten;
+   size_t ulOff = 0;
+
+   if(!psBuf->bIsValid)
+      return FALSE;
+   while(ulOff < psBuf->ulLength) {
+      lWritten = write(iFd, psBuf->pcData + ulOff,
+                       psBuf->ulLength - ulOff);
+      if(lWritten < 0) {
+         if(errno == EINTR)
+            continue;
+         return FALSE;
+      }
+      ulOff += (size_t) lWritten;
+   }
+   psBuf->ulLength = 0;
+   return TRUE;
+}
+
+/* Reads from iFd into *psIn until it holds at least one whole frame.
+   Returns FALSE on error or end of file. */
+static boolean FTLoad_receive(int iFd, struct FTBuf *psIn) {
+   char acChunk[READ_CHUNK];
+   ssize_t lRead;
+   size_t ulBody;
+   boolean bIsValid;
+
+   while(!FTProto_haveFrame(psIn->pcData, psIn->ulLength, &ulBody,
+                            &bIsValid)) {
+      if(!bIsValid)
+         return FALSE;
+      lRead = read(iFd, acChunk, sizeof(acChunk));
+      if(lRead < 0 && errno == EINTR)
+         continue;
+      if(lRead <= 0)
+         return FALSE;
+      FTBuf_putBytes(psIn, acChunk, (size_t) lRead);
+      if(!psIn->bIsValid)
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/* Sends the request with ID ulId, operation eOp and path pcPath (NULL
+   for none) on iFd and waits for its response. Returns the response's
+   status, or -1 if the connection failed. Used only for setup, so it
+   does not pipeline. */
+static int FTLoad_call(int iFd, unsigned long ulId, enum FTOp eOp,
+                       const char *pcPath, const void *pvBlob,
+                       size_t ulBlobLength) {
+   struct FTBuf sBuf;
+   struct FTCursor sCursor;
+   size_t ulFrame, ulBody;
+   boolean bIsValid;
+   int iStatus = -1;
+
+   FTBuf_init(&sBuf);
+   ulFrame = FTBuf_beginFrame(&sBuf);
+   FTBuf_putU32(&sBuf, ulId);
+   FTBuf_putU8(&sBuf, eOp);
+   if(pcPath != NULL)
+      FTBuf_putPath(&sBuf, pcPath);
+   if(eOp == FTOP_INSERT_FILE)
+      FTBuf_putBlob(&sBuf, pvBlob, ulBlobLength);
+   FTBuf_endFrame(&sBuf, ulFrame);
+
+   if(FTLoad_send(iFd, &sBuf) && FTLoad_receive(iFd, &sBuf)) {
+      (void) FTProto_haveFrame(sBuf.pcData, sBuf.ulLength, &ulBody,
+                               &bIsValid);
+      FTCursor_init(&sCursor, sBuf.pcData + 4, ulBody);
+      if(FTCursor_getU32(&sCursor) == ulId) {
+         (void) FTCursor_getU8(&sCursor);
+         iStatus = (int) FTCursor_getU8(&sCursor);
+      }
+   }
+   FTBuf_free(&sBuf);
+   return iStatus;
+}
+
+/* Appends request ulId, chosen at random, to *psOut. */
+static void FTLoad_addRequest(struct loadRun *psRun, unsigned long ulId,
+                              struct FTBuf *psOut, const char *pcFill) {
+   const struct loadConfig *psConfig = psRun->psConfig;
+   char acPath[MAX_PATH];
+   unsigned long ulDice;
+   size_t ulFrame;
+   enum FTOp eOp;
+
+   ulDice = FTLoad_random(&psRun->ulSeed) % 100;
+   if(ulDice < psConfig->uWritePct)
+      eOp = FTOP_REPLACE_CONTENTS;
+   else if(ulDice % 2 == 0)
+      eOp = FTOP_GET_CONTENTS;
+   else
+      eOp = FTOP_STAT;
+   FTLoad_filePath(acPath,
+      (size_t) FTLoad_random(&psRun->ulSeed) % psConfig->ulFiles);
+
+   ulFrame = FTBuf_beginFrame(psOut);
+   FTBuf_putU32(psOut, ulId);
+   FTBuf_putU8(psOut, eOp);
+   FTBuf_putPath(psOut, acPath);
+   if(eOp == FTOP_REPLACE_CONTENTS)
+      FTBuf_putBlob(psOut, pcFill, psConfig->ulSize);
+   FTBuf_endFrame(psOut, ulFrame);
+}
+
+/* Runs one connection's share of the load, as described by the struct
+   loadRun at pvRun. */
+static void *FTLoad_run(void *pvRun) {
+   struct loadRun *psRun = pvRun;
+   const struct loadConfig *psConfig = psRun->psConfig;
+   struct FTBuf sOut, sIn;
+   struct FTCursor sCursor;
+   unsigned long ulId;
+   size_t ulSent = 0, ulBody;
+   boolean bIsValid;
+   char *pcFill;
+   int iFd;
+
+   psRun->bIsOk = FALSE;
+   pcFill = malloc(psConfig->ulSize == 0 ? 1 : psConfig->ulSize);
+   iFd = FTLoad_connect(psConfig->pcSocketPath);
+   if(pcFill == NULL || iFd < 0) {
+      free(pcFill);
+      return NULL;
+   }
+   memset(pcFill, 'w', psConfig->ulSize);
+   FTBuf_init(&sOut);
+   FTBuf_init(&sIn);
+
+   while(psRun->ulDone < psConfig->ulRequests) {
+      /* Top the pipeline up, then send the new requests together */
+      while(ulSent < psConfig->ulRequests &&
+            ulSent - psRun->ulDone < psConfig->ulDepth) {
+         psRun->pdSent[ulSent] = FTLoad_now();
+         FTLoad_addRequest(psRun, (unsigned long) ulSent, &sOut, pcFill);
+         ulSent++;
+      }
+      if(!FTLoad_send(iFd, &sOut) || !FTLoad_receive(iFd, &sIn))
+         break;
+
+      /* Account for every whole response received */
+      while(FTProto_haveFrame(sIn.pcData, sIn.ulLength, &ulBody,
+                              &bIsValid)) {
+         FTCursor_init(&sCursor, sIn.pcData + 4, ulBody);
+         ulId = FTCursor_getU32(&sCursor);
+         (void) FTCursor_getU8(&sCursor);
+         if(FTCursor_getU8(&sCursor) != SUCCESS)
+            psRun->ulErrors++;
+         if(ulId < ulSent)
+            psRun->pdLatency[psRun->ulDone++] =
+               FTLoad_now() - psRun->pdSent[ulId];
+         FTBuf_consume(&sIn, 4 + ulBody);
+      }
+   }
+
+   psRun->bIsOk = (boolean) (psRun->ulDone == psConfig->ulRequests);
+   FTBuf_free(&sOut);
+   FTBuf_free(&sIn);
+   close(iFd);
+   free(pcFill);
+   return NULL;
+}
+
+/* Compares the doubles at pv1 and pv2 for qsort. */
+static int FTLoad_compareDoubles(const void *pv1, const void *pv2) {
+   double d1 = *(const double *) pv1, d2 = *(const double *) pv2;
+
+   return d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+}
+
+/* Inserts (if bInsert is TRUE) or removes the generated tree on iFd.
+   Returns FALSE, after printing why, on failure. */
+static boolean FTLoad_setUp(int iFd, const struct loadConfig *psConfig,
+                            boolean bInsert) {
+   char acPath[MAX_PATH];
+   char *pcFill;
+   size_t i;
+   int iStatus;
+
+   if(!bInsert)
+      return (boolean) (FTLoad_call(iFd, 0, FTOP_RM_DIR, "ftload",
+                                    NULL, 0) == SUCCESS);
+
+   pcFill = malloc(psConfig->ulSize == 0 ? 1 : psConfig->ulSize);
+   if(pcFill == NULL)
+      return FALSE;
+   memset(pcFill, 'i', psConfig->ulSize);
+   for(i = 0; i < psConfig->ulFiles; i++) {
+      FTLoad_filePath(acPath, i);
+      iStatus = FTLoad_call(iFd, (unsigned long) i, FTOP_INSERT_FILE,
+                            acPath, pcFill, psConfig->ulSize);
+      if(iStatus != SUCCESS && iStatus != ALREADY_IN_TREE) {
+         fprintf(stderr, "ftload: cannot insert %s (status %d)\n",
+                 acPath, iStatus);
+         free(pcFill);
+         return FALSE;
+      }
+   }
+   free(pcFill);
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   struct loadConfig sConfig;
+   struct loadRun *psRuns;
+   pthread_t *psThreads;
+   double *pdAll, dStart, dSeconds;
+   size_t ulConns = 4, ulTotal = 0, ulErrors = 0, i;
+   boolean bIsOk = TRUE;
+   int iFd, iArg;
+
+   if(argc < 2 || argc % 2 != 0) {
+      fprintf(stderr, "Usage: %s socketpath [-c conns] [-d depth] "
+              "[-n requests] [-f files] [-s size] [-w writepct]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+   }
+   sConfig.pcSocketPath = argv[1];
+   sConfig.ulDepth = 32;
+   sConfig.ulRequests = 100000;
+   sConfig.ulFiles = 4096;
+   sConfig.ulSize = 1024;
+   sConfig.uWritePct = 10;
+   for(iArg = 2; iArg + 1 < argc; iArg += 2) {
+      size_t ulValue = (size_t) strtoul(argv[iArg + 1], NULL, 10);
+
+      if(strcmp(argv[iArg], "-c") == 0)
+         ulConns = ulValue;
+      else if(strcmp(argv[iArg], "-d") == 0)
+         sConfig.ulDepth = ulValue;
+      else if(strcmp(argv[iArg], "-n") == 0)
+         sConfig.ulRequests = ulValue;
+      else if(strcmp(argv[iArg], "-f") == 0)
+         sConfig.ulFiles = ulValue;
+      else if(strcmp(argv[iArg], "-s") == 0)
+         sConfig.ulSize = ulValue;
+      else if(strcmp(argv[iArg], "-w") == 0)
+         sConfig.uWritePct = (unsigned int) ulValue;
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   if(ulConns == 0 || sConfig.ulDepth == 0 || sConfig.ulFiles == 0) {
+      fprintf(stderr, "%s: -c, -d and -f must be positive\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   iFd = FTLoad_connect(sConfig.pcSocketPath);
+   if(iFd < 0 || !FTLoad_setUp(iFd, &sConfig, TRUE))
+      return EXIT_FAILURE;
+
+   psRuns = calloc(ulConns, sizeof(struct loadRun));
+   psThreads = calloc(ulConns, sizeof(pthread_t));
+   if(psRuns == NULL || psThreads == NULL)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulConns; i++) {
+      psRuns[i].psConfig = &sConfig;
+      psRuns[i].ulSeed = 217 + i;
+      psRuns[i].pdSent = malloc((sConfig.ulRequests + 1) * sizeof(double));
+      psRuns[i].pdLatency = malloc((sConfig.ulRequests + 1) *
+                                   sizeof(double));
+      if(psRuns[i].pdSent == NULL || psRuns[i].pdLatency == NULL)
+         return EXIT_FAILURE;
+   }
+
+   dStart = FTLoad_now();
+   for(i = 0; i < ulConns; i++)
+      if(pthread_create(&psThreads[i], NULL, FTLoad_run, &psRuns[i]) != 0)
+         return EXIT_FAILURE;
+   for(i = 0; i < ulConns; i++)
+      pthread_join(psThreads[i], NULL);
+   dSeconds = FTLoad_now() - dStart;
+
+   /* Pool every latency to compute the percentiles */
+   for(i = 0; i < ulConns; i++) {
+      ulTotal += psRuns[i].ulDone;
+      ulErrors += psRuns[i].ulErrors;
+      if(!psRuns[i].bIsOk)
+         bIsOk = FALSE;
+   }
+   pdAll = malloc((ulTotal + 1) * sizeof(double));
+   if(pdAll == NULL)
+      return EXIT_FAILURE;
+   ulTotal = 0;
+   for(i = 0; i < ulConns; i++) {
+      memcpy(pdAll + ulTotal, psRuns[i].pdLatency,
+             psRuns[i].ulDone * sizeof(double));
+      ulTotal += psRuns[i].ulDone;
+      free(psRuns[i].pdSent);
+      free(psRuns[i].pdLatency);
+   }
+   qsort(pdAll, ulTotal, sizeof(double), FTLoad_compareDoubles);
+
+   printf("%lu requests on %lu connections, depth %lu: %.3f s, "
+          "%.0f requests/s\n", (unsigned long) ulTotal,
+          (unsigned long) ulConns, (unsigned long) sConfig.ulDepth,
+          dSeconds, dSeconds > 0 ? (double) ulTotal / dSeconds : 0.0);
+   if(ulTotal != 0)
+      printf("latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  "
+             "max %.1f\n", pdAll[ulTotal / 2] * 1e6,
+             pdAll[ulTotal * 9 / 10] * 1e6,
+             pdAll[ulTotal * 99 / 100] * 1e6,
+             pdAll[ulTotal * 999 / 1000] * 1e6,
+             pdAll[ulTotal - 1] * 1e6);
+   printf("%lu responses with errors\n", (unsigned long) ulErrors);
+
+   if(!FTLoad_setUp(iFd, &sConfig, FALSE))
+      bIsOk = FALSE;
+   close(iFd);
+   free(pdAll);
+   free(psRuns);
+   free(psThreads);
+   return bIsOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
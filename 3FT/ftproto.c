@@ -0,0 +1,307 @@
+/*--------------------------------------------------------------------*/
+/* ftproto.c                                                          */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "ftproto.h"
+
+/* Smallest allocation of a non-empty buffer */
+enum { MIN_BUF_SIZE = 256 };
+
+/*--------------------------------------------------------------------*/
+
+/* Stores ulValue in the 4 bytes at pcOut, most significant first. */
+static void FTProto_encodeU32(char *pcOut, unsigned long ulValue) {
+   pcOut[0] = (char) ((ulValue >> 24) & 0xff);
+   pcOut[1] = (char) ((ulValue >> 16) & 0xff);
+   pcOut[2] = (char) ((ulValue >> 8) & 0xff);
+   pcOut[3] = (char) (ulValue & 0xff);
+}
+
+/* Returns the value of the 4 bytes at pcIn, most significant first. */
+static unsigned long FTProto_decodeU32(const char *pcIn) {
+   const unsigned char *pucIn = (const unsigned char *) pcIn;
+
+   return ((unsigned long) pucIn[0] << 24) |
+          ((unsigned long) pucIn[1] << 16) |
+          ((unsigned long) pucIn[2] << 8) | (unsigned long) pucIn[3];
+}
+
+/* Returns a pointer to the next ulLength bytes of *psCursor and
+   advances past them, or NULL (marking the cursor invalid) if fewer
+   remain. */
+static const char *FTCursor_take(struct FTCursor *psCursor,
+                                 size_t ulLength) {
+   const char *pcData;
+
+   assert(psCursor != NULL);
+
+   if(!psCursor->bIsValid || ulLength > psCursor->ulLeft) {
+      psCursor->bIsValid = FALSE;
+      return NULL;
+   }
+   pcData = psCursor->pcNext;
+   psCursor->pcNext += ulLength;
+   psCursor->ulLeft -= ulLength;
+   return pcData;
+}
+
+/* ================================================================== */
+void FTBuf_init(struct FTBuf *psBuf) {
+   assert(psBuf != NULL);
+
+   psBuf->pcData = NULL;
+   psBuf->ulLength = 0;
+   psBuf->ulSize = 0;
+   psBuf->bIsValid = TRUE;
+}
+
+/* ================================================================== */
+void FTBuf_free(struct FTBuf *psBuf) {
+   assert(psBuf != NULL);
+
+   free(psBuf->pcData);
+   FTBuf_init(psBuf);
+}
+
+/* ================================================================== */
+void FTBuf_consume(struct FTBuf *psBuf, size_t ulCount) {
+   assert(psBuf != NULL);
+   assert(ulCount <= psBuf->ulLength);
+
+   memmove(psBuf->pcData, psBuf->pcData + ulCount,
+           psBuf->ulLength - ulCount);
+   psBuf->ulLength -= ulCount;
+}
+
+/* ================================================================== */
+void FTBuf_putBytes(struct FTBuf *psBuf, const void *pvData,
+                    size_t ulLength) {
+   char *pcNew;
+   size_t ulNewSize;
+
+   assert(psBuf != NULL);
+   assert(pvData != NULL || ulLength == 0);
+
+   if(!psBuf->bIsValid)
+      return;
+
+   /* Double as needed so that appends take amortized constant time */
+   if(ulLength > psBuf->ulSize - psBuf->ulLength) {
+      ulNewSize = psBuf->ulSize < MIN_BUF_SIZE ?
+                  MIN_BUF_SIZE : psBuf->ulSize;
+      while(ulNewSize - psBuf->ulLength < ulLength)
+         ulNewSize *= 2;
+      pcNew = realloc(psBuf->pcData, ulNewSize);
+      if(pcNew == NULL) {
+         psBuf->bIsValid = FALSE;
+         return;
+      }
+      psBuf->pcData = pcNew;
+      psBuf->ulSize = ulNewSize;
+   }
+   if(ulLength != 0)
+      memcpy(psBuf->pcData + psBuf->ulLength, pvData, ulLength);
+   psBuf->ulLength += ulLength;
+}
+
+/* ================================================================== */
+void FTBuf_putU8(struct FTBuf *psBuf, unsigned int uValue) {
+   char c = (char) (uValue & 0xff);
+
+   FTBuf_putBytes(psBuf, &c, 1);
+}
+
+/* ================================================================== */
+void FTBuf_putU32(struct FTBuf *psBuf, unsigned long ulValue) {
+   char acBytes[4];
+
+   FTProto_encodeU32(acBytes, ulValue);
+   FTBuf_putBytes(psBuf, acBytes, sizeof(acBytes));
+}
+
+/* ================================================================== */
+void FTBuf_putSize(struct FTBuf *psBuf, size_t ulValue) {
+   /* Shift in two steps so that a 32-bit size_t does not overflow */
+   FTBuf_putU32(psBuf, (unsigned long) ((ulValue >> 16) >> 16));
+   FTBuf_putU32(psBuf, (unsigned long) (ulValue & 0xffffffffUL));
+}
+
+/* ================================================================== */
+void FTBuf_putPath(struct FTBuf *psBuf, const char *pcPath) {
+   size_t ulLength;
+
+   assert(pcPath != NULL);
+
+   ulLength = strlen(pcPath);
+   FTBuf_putU32(psBuf, (unsigned long) ulLength);
+   FTBuf_putBytes(psBuf, pcPath, ulLength);
+}
+
+/* ================================================================== */
+void FTBuf_putBlob(struct FTBuf *psBuf, const void *pvData,
+                   size_t ulLength) {
+   if(pvData == NULL) {
+      FTBuf_putU8(psBuf, 0);
+      return;
+   }
+   FTBuf_putU8(psBuf, 1);
+   FTBuf_putU32(psBuf, (unsigned long) ulLength);
+   FTBuf_putBytes(psBuf, pvData, ulLength);
+}
+
+/* ================================================================== */
+void FTBuf_putValue(struct FTBuf *psBuf, const struct AttrValue *psValue) {
+   assert(psValue != NULL);
+
+   FTBuf_putU8(psBuf, (unsigned int) psValue->eType);
+   if(psValue->eType == ATTR_INT)
+      FTBuf_putSize(psBuf, (size_t) psValue->lInt);
+   else
+      FTBuf_putPath(psBuf, psValue->pcString);
+}
+
+/* ================================================================== */
+void FTBuf_setU32(struct FTBuf *psBuf, size_t ulPos,
+                  unsigned long ulValue) {
+   assert(psBuf != NULL);
+
+   if(!psBuf->bIsValid)
+      return;
+   assert(ulPos + 4 <= psBuf->ulLength);
+   FTProto_encodeU32(psBuf->pcData + ulPos, ulValue);
+}
+
+/* ================================================================== */
+size_t FTBuf_beginFrame(struct FTBuf *psBuf) {
+   size_t ulStart;
+
+   assert(psBuf != NULL);
+
+   ulStart = psBuf->ulLength;
+   FTBuf_putU32(psBuf, 0);
+   return ulStart;
+}
+
+/* ================================================================== */
+void FTBuf_endFrame(struct FTBuf *psBuf, size_t ulStart) {
+   assert(psBuf != NULL);
+
+   FTBuf_setU32(psBuf, ulStart,
+                (unsigned long) (psBuf->ulLength - ulStart - 4));
+}
+
+/* ================================================================== */
+boolean FTProto_haveFrame(const char *pcData, size_t ulLength,
+                          size_t *pulBody, boolean *pbIsValid) {
+   unsigned long ulBody;
+
+   assert(pulBody != NULL);
+   assert(pbIsValid != NULL);
+
+   *pbIsValid = TRUE;
+   if(ulLength < 4)
+      return FALSE;
+   ulBody = FTProto_decodeU32(pcData);
+   if(ulBody > FTPROTO_MAX_FRAME) {
+      *pbIsValid = FALSE;
+      return FALSE;
+   }
+   *pulBody = ulBody;
+   return (boolean) (ulLength - 4 >= ulBody);
+}
+
+/* ================================================================== */
+void FTCursor_init(struct FTCursor *psCursor, const char *pcData,
+                   size_t ulLength) {
+   assert(psCursor != NULL);
+
+   psCursor->pcNext = pcData;
+   psCursor->ulLeft = ulLength;
+   psCursor->bIsValid = TRUE;
+}
+
+/* ================================================================== */
+unsigned int FTCursor_getU8(struct FTCursor *psCursor) {
+   const char *pcData;
+
+   pcData = FTCursor_take(psCursor, 1);
+   return pcData == NULL ? 0 : (unsigned int) (unsigned char) *pcData;
+}
+
+/* ================================================================== */
+unsigned long FTCursor_getU32(struct FTCursor *psCursor) {
+   const char *pcData;
+
+   pcData = FTCursor_take(psCursor, 4);
+   return pcData == NULL ? 0 : FTProto_decodeU32(pcData);
+}
+
+/* ================================================================== */
+size_t FTCursor_getSize(struct FTCursor *psCursor) {
+   size_t ulHigh;
+
+   ulHigh = (size_t) FTCursor_getU32(psCursor);
+   return ((ulHigh << 16) << 16) | (size_t) FTCursor_getU32(psCursor);
+}
+
+/* ================================================================== */
+char *FTCursor_getPath(struct FTCursor *psCursor) {
+   const char *pcData;
+   char *pcPath;
+   size_t ulLength;
+
+   ulLength = (size_t) FTCursor_getU32(psCursor);
+   pcData = FTCursor_take(psCursor, ulLength);
+   if(pcData == NULL)
+      return NULL;
+   pcPath = malloc(ulLength + 1);
+   if(pcPath == NULL)
+      return NULL;
+   memcpy(pcPath, pcData, ulLength);
+   pcPath[ulLength] = '\0';
+   return pcPath;
+}
+
+/* ================================================================== */
+boolean FTCursor_getBlob(struct FTCursor *psCursor, const char **ppcData,
+                         size_t *pulLength) {
+   assert(ppcData != NULL);
+   assert(pulLength != NULL);
+
+   *ppcData = NULL;
+   *pulLength = 0;
+   if(FTCursor_getU8(psCursor) == 0)
+      return psCursor->bIsValid;
+
+   *pulLength = (size_t) FTCursor_getU32(psCursor);
+   *ppcData = FTCursor_take(psCursor, *pulLength);
+   return psCursor->bIsValid;
+}
+
+/* ================================================================== */
+boolean FTCursor_getValue(struct FTCursor *psCursor,
+                          struct AttrValue *psValue) {
+   assert(psValue != NULL);
+
+   psValue->pcString = NULL;
+   psValue->lInt = 0;
+   switch(FTCursor_getU8(psCursor)) {
+      case ATTR_INT:
+         psValue->eType = ATTR_INT;
+         psValue->lInt = (long) FTCursor_getSize(psCursor);
+         return psCursor->bIsValid;
+
+      case ATTR_STRING:
+         psValue->eType = ATTR_STRING;
+         psValue->pcString = FTCursor_getPath(psCursor);
+         return (boolean) (psValue->pcString != NULL);
+
+      default:
+         psCursor->bIsValid = FALSE;
+         return FALSE;
+   }
+}
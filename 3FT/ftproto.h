@@ -0,0 +1,181 @@
+/*--------------------------------------------------------------------*/
+/* ftproto.h                                                          */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTPROTO_INCLUDED
+#define FTPROTO_INCLUDED
+
+/*
+  The FT wire protocol, spoken between the ftd server and its clients
+  over a stream socket. Every message is a frame: a 4-byte length of
+  the rest of the frame, then the body. All integers are big-endian.
+
+  A request body is a 4-byte request ID chosen by the client, a 1-byte
+  operation (enum FTOp), and the operation's arguments. A response
+  body is the request's ID and operation, a 1-byte status (an a4def.h
+  status), and the operation's results. Clients may send any number
+  of requests without waiting; responses may arrive in any order and
+  are matched to requests by ID.
+
+  Arguments and results are built from these fields:
+    path:  4-byte length, then that many bytes (no terminator)
+    blob:  1-byte flag (0 for NULL), then, if the flag is 1, a 4-byte
+           length and that many bytes
+    bool:  1 byte, 0 or 1
+    size:  8 bytes
+    value: 1-byte enum AttrType, then a size holding the integer (in
+           two's complement) for ATTR_INT, or a path holding the
+           string for ATTR_STRING
+    paths: 4-byte count, then that many paths
+
+  Attribute keys are sent as paths.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "attrs.h"
+
+/* Operations, with their arguments and results (results are sent
+   only when the status is SUCCESS, except as noted) */
+enum FTOp {
+   FTOP_INIT = 1,           /* ()           -> ()                   */
+   FTOP_DESTROY,            /* ()           -> ()                   */
+   FTOP_INSERT_DIR,         /* (path)       -> ()                   */
+   FTOP_CONTAINS_DIR,       /* (path)       -> (bool), any status   */
+   FTOP_RM_DIR,             /* (path)       -> ()                   */
+   FTOP_INSERT_FILE,        /* (path, blob) -> ()                   */
+   FTOP_CONTAINS_FILE,      /* (path)       -> (bool), any status   */
+   FTOP_RM_FILE,            /* (path)       -> ()                   */
+   FTOP_GET_CONTENTS,       /* (path)       -> (blob)               */
+   FTOP_REPLACE_CONTENTS,   /* (path, blob) -> (old blob)           */
+   FTOP_STAT,               /* (path)       -> (bool isFile, size)  */
+   FTOP_TO_STRING,          /* ()           -> (blob)               */
+   FTOP_COUNT,              /* (path)       -> (size files, size dirs) */
+   FTOP_NTH,                /* (path, size) -> (path, bool isFile)  */
+   FTOP_ENABLE_SIZE_INDEX,  /* ()           -> ()                   */
+   FTOP_TOP_K_BY_SIZE,      /* (size k)     -> (paths)              */
+   FTOP_FILES_IN_SIZE_RANGE,/* (size min, size max) -> (paths)      */
+   FTOP_SET_ATTR,           /* (path, key, value) -> ()             */
+   FTOP_GET_ATTR,           /* (path, key)  -> (value)              */
+   FTOP_REMOVE_ATTR,        /* (path, key)  -> ()                   */
+   FTOP_INDEX_ATTR,         /* (key)        -> ()                   */
+   FTOP_FIND_BY_ATTR,       /* (key, value) -> (paths)              */
+   FTOP_SCAN_RANGE,         /* (blob lo, blob hi) -> (4-byte count,
+                               then a path and bool isFile each)    */
+   FTOP_STAT_MULTI,         /* (paths)      -> (1-byte status, bool
+                               isFile, size for each path)          */
+   FTOP_GET_CONTENTS_MULTI, /* (paths)      -> (blob for each path,
+                               NULL if not a file)                  */
+   FTOP_LIMIT               /* One past the last operation */
+};
+
+/* Frames longer than this are rejected as malformed */
+enum { FTPROTO_MAX_FRAME = 64 * 1024 * 1024 };
+
+/* A growable buffer that frames are encoded into */
+struct FTBuf {
+   /* The bytes, owned by the buffer */
+   char *pcData;
+
+   /* Bytes in use and allocated */
+   size_t ulLength;
+   size_t ulSize;
+
+   /* FALSE once an append failed; later appends are ignored */
+   boolean bIsValid;
+};
+
+/* A read position within a received frame */
+struct FTCursor {
+   /* Next byte to read */
+   const char *pcNext;
+
+   /* Bytes left to read */
+   size_t ulLeft;
+
+   /* FALSE once a read ran past the end; later reads return zeros */
+   boolean bIsValid;
+};
+
+/* Sets *psBuf to an empty buffer. */
+void FTBuf_init(struct FTBuf *psBuf);
+
+/* Frees the memory held by *psBuf and empties it. */
+void FTBuf_free(struct FTBuf *psBuf);
+
+/* Removes the first ulCount bytes of *psBuf. */
+void FTBuf_consume(struct FTBuf *psBuf, size_t ulCount);
+
+/* Appends ulLength bytes at pvData to *psBuf, marking it invalid if
+   memory cannot be allocated. */
+void FTBuf_putBytes(struct FTBuf *psBuf, const void *pvData,
+                    size_t ulLength);
+
+/* Append one field each to *psBuf, as FTBuf_putBytes does. */
+void FTBuf_putU8(struct FTBuf *psBuf, unsigned int uValue);
+void FTBuf_putU32(struct FTBuf *psBuf, unsigned long ulValue);
+void FTBuf_putSize(struct FTBuf *psBuf, size_t ulValue);
+void FTBuf_putPath(struct FTBuf *psBuf, const char *pcPath);
+void FTBuf_putBlob(struct FTBuf *psBuf, const void *pvData,
+                   size_t ulLength);
+
+/* Appends *psValue to *psBuf, as FTBuf_putBytes does. */
+void FTBuf_putValue(struct FTBuf *psBuf, const struct AttrValue *psValue);
+
+/* Stores ulValue in the 4 bytes at ulPos of *psBuf, which must
+   already hold them, unless *psBuf is invalid. */
+void FTBuf_setU32(struct FTBuf *psBuf, size_t ulPos,
+                  unsigned long ulValue);
+
+/* Appends the length word of a new frame to *psBuf and returns its
+   position, to be passed to FTBuf_endFrame once the body is in. */
+size_t FTBuf_beginFrame(struct FTBuf *psBuf);
+
+/* Fills in the length word of the frame begun at ulStart. */
+void FTBuf_endFrame(struct FTBuf *psBuf, size_t ulStart);
+
+/*
+  Examines the ulLength bytes at pcData. Returns TRUE and stores the
+  length of the first frame's body in *pulBody if a whole frame is
+  present; returns FALSE otherwise. Stores in *pbIsValid whether the
+  frame's length is acceptable.
+*/
+boolean FTProto_haveFrame(const char *pcData, size_t ulLength,
+                          size_t *pulBody, boolean *pbIsValid);
+
+/* Sets *psCursor to read the ulLength bytes at pcData. */
+void FTCursor_init(struct FTCursor *psCursor, const char *pcData,
+                   size_t ulLength);
+
+/* Read one field each from *psCursor. */
+unsigned int FTCursor_getU8(struct FTCursor *psCursor);
+unsigned long FTCursor_getU32(struct FTCursor *psCursor);
+size_t FTCursor_getSize(struct FTCursor *psCursor);
+
+/*
+  Reads a path from *psCursor into newly allocated memory, owned by
+  the caller and NUL-terminated, and returns it. Returns NULL if the
+  cursor runs out or memory cannot be allocated.
+*/
+char *FTCursor_getPath(struct FTCursor *psCursor);
+
+/*
+  Reads a blob from *psCursor, storing a pointer to its bytes inside
+  the frame in *ppcData (NULL for a NULL blob) and its length in
+  *pulLength. Returns FALSE if the cursor runs out, TRUE otherwise.
+*/
+boolean FTCursor_getBlob(struct FTCursor *psCursor, const char **ppcData,
+                         size_t *pulLength);
+
+/*
+  Reads a value from *psCursor into *psValue. A string is copied into
+  newly allocated memory, owned by the caller and NUL-terminated.
+  Returns FALSE if the cursor runs out or the type is unknown (both of
+  which mark it invalid) or if memory cannot be allocated, TRUE
+  otherwise.
+*/
+boolean FTCursor_getValue(struct FTCursor *psCursor,
+                          struct AttrValue *psValue);
+
+#endif
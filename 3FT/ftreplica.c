@@ -0,0 +1,209 @@
+/*--------------------------------------------------------------------*/
+/* ftreplica.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+#include "numa.h"
+#include "path.h"
+#include "ftreplica.h"
+
+/* FNV-1a parameters, for hashing pathnames one byte at a time */
+#define FNV_BASIS 2166136261UL
+#define FNV_PRIME 16777619UL
+
+/* One directory; an empty slot has no node */
+struct replicaSlot {
+   /* Hash of the pathname */
+   unsigned long ulHash;
+   /* The directory */
+   NodeD_T oNdNode;
+   /* Where its pathname is among the names, and its length */
+   size_t ulOffset;
+   size_t ulLength;
+};
+
+/* A replica: this header, then its slots, then its names */
+struct ftReplica {
+   /* Bytes of the whole block, to unmap it */
+   size_t ulBytes;
+   /* Slots minus one; the slot count is a power of two */
+   size_t ulMask;
+   /* Depth of the deepest directories replicated */
+   size_t ulLevels;
+   /* The hash table */
+   struct replicaSlot *psSlots;
+   /* The pathnames, one after another without terminators */
+   char *pcNames;
+};
+
+/* What building a replica needs as it walks the tree */
+struct replicaBuilder {
+   /* The replica being filled in */
+   FTReplica_T oRReplica;
+   /* Where the next name goes */
+   size_t ulNextName;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the FNV-1a hash of the ulLength bytes at pcBytes. */
+static unsigned long FTReplica_hash(const char *pcBytes,
+                                    size_t ulLength) {
+   unsigned long ulHash = FNV_BASIS;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++)
+      ulHash = (ulHash ^ (unsigned char) pcBytes[i]) * FNV_PRIME;
+   return ulHash;
+}
+
+/* Adds to *pulDirs and *pulBytes the number of directories in the
+   subtree rooted at oNdNode, at depth ulDepth, down to depth ulLevels,
+   and the length of their pathnames. */
+static void FTReplica_measure(NodeD_T oNdNode, size_t ulDepth,
+                              size_t ulLevels, size_t *pulDirs,
+                              size_t *pulBytes) {
+   NodeD_T oNdChild = NULL;
+   size_t c;
+
+   (*pulDirs)++;
+   *pulBytes += Path_getStrLength(NodeD_getPath(oNdNode));
+   if(ulDepth == ulLevels)
+      return;
+   for(c = 0; c < NodeD_getNumDirChildren(oNdNode); c++) {
+      (void) NodeD_getDirChild(oNdNode, c, &oNdChild);
+      FTReplica_measure(oNdChild, ulDepth + 1, ulLevels, pulDirs,
+                        pulBytes);
+   }
+}
+
+/* Adds the directories of the subtree rooted at oNdNode, at depth
+   ulDepth, down to the replica's depth, to the replica psBuilder is
+   filling in. */
+static void FTReplica_fill(struct replicaBuilder *psBuilder,
+                           NodeD_T oNdNode, size_t ulDepth) {
+   FTReplica_T oRReplica = psBuilder->oRReplica;
+   Path_T oPPath = NodeD_getPath(oNdNode);
+   struct replicaSlot *psSlot;
+   NodeD_T oNdChild = NULL;
+   unsigned long ulHash;
+   size_t ulLength, i, c;
+
+   ulLength = Path_getStrLength(oPPath);
+   ulHash = FTReplica_hash(Path_getPathname(oPPath), ulLength);
+   for(i = ulHash & oRReplica->ulMask;
+       oRReplica->psSlots[i].oNdNode != NULL;
+       i = (i + 1) & oRReplica->ulMask)
+      ;
+   psSlot = &oRReplica->psSlots[i];
+   psSlot->ulHash = ulHash;
+   psSlot->oNdNode = oNdNode;
+   psSlot->ulOffset = psBuilder->ulNextName;
+   psSlot->ulLength = ulLength;
+   memcpy(oRReplica->pcNames + psBuilder->ulNextName,
+          Path_getPathname(oPPath), ulLength);
+   psBuilder->ulNextName += ulLength;
+
+   if(ulDepth == oRReplica->ulLevels)
+      return;
+   for(c = 0; c < NodeD_getNumDirChildren(oNdNode); c++) {
+      (void) NodeD_getDirChild(oNdNode, c, &oNdChild);
+      FTReplica_fill(psBuilder, oNdChild, ulDepth + 1);
+   }
+}
+
+/* ================================================================== */
+int FTReplica_build(NodeD_T oNdRoot, size_t ulLevels, int iNode,
+                    FTReplica_T *poRResult) {
+   struct replicaBuilder sBuilder;
+   FTReplica_T oRReplica;
+   size_t ulDirs = 0, ulNameBytes = 0, ulSlots = 2, ulBytes;
+   size_t ulHeader, ulTable;
+
+   assert(ulLevels > 0);
+   assert(poRResult != NULL);
+
+   *poRResult = NULL;
+   if(oNdRoot != NULL)
+      FTReplica_measure(oNdRoot, 1, ulLevels, &ulDirs, &ulNameBytes);
+
+   /* Keep the table at most half full */
+   while(ulSlots < 2 * ulDirs)
+      ulSlots *= 2;
+   ulHeader = (sizeof(struct ftReplica) + sizeof(struct replicaSlot) - 1)
+              / sizeof(struct replicaSlot) * sizeof(struct replicaSlot);
+   ulTable = ulSlots * sizeof(struct replicaSlot);
+   ulBytes = ulHeader + ulTable + ulNameBytes;
+
+   /* The mapping is zeroed, so every slot starts out empty */
+   oRReplica = Numa_alloc(ulBytes, iNode);
+   if(oRReplica == NULL)
+      return MEMORY_ERROR;
+   oRReplica->ulBytes = ulBytes;
+   oRReplica->ulMask = ulSlots - 1;
+   oRReplica->ulLevels = ulLevels;
+   oRReplica->psSlots = (struct replicaSlot *)
+                        ((char *) oRReplica + ulHeader);
+   oRReplica->pcNames = (char *) oRReplica + ulHeader + ulTable;
+
+   sBuilder.oRReplica = oRReplica;
+   sBuilder.ulNextName = 0;
+   if(oNdRoot != NULL)
+      FTReplica_fill(&sBuilder, oNdRoot, 1);
+   assert(sBuilder.ulNextName == ulNameBytes);
+
+   *poRResult = oRReplica;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void FTReplica_free(FTReplica_T oRReplica) {
+   assert(oRReplica != NULL);
+
+   Numa_free(oRReplica, oRReplica->ulBytes);
+}
+
+/* ================================================================== */
+NodeD_T FTReplica_deepest(FTReplica_T oRReplica, const char *pcPath,
+                          size_t ulMaxDepth, size_t *pulDepth) {
+   const struct replicaSlot *psSlot;
+   NodeD_T oNdFound = NULL;
+   unsigned long ulHash = FNV_BASIS;
+   size_t ulDepth = 0, ulLength, i;
+   const char *pc;
+
+   assert(oRReplica != NULL);
+   assert(pcPath != NULL);
+   assert(pulDepth != NULL);
+
+   if(ulMaxDepth > oRReplica->ulLevels)
+      ulMaxDepth = oRReplica->ulLevels;
+
+   /* At each component's end, the hash covers the prefix before it */
+   for(pc = pcPath; ulDepth < ulMaxDepth; pc++) {
+      if(*pc == '/' || *pc == '\0') {
+         ulDepth++;
+         ulLength = (size_t) (pc - pcPath);
+         for(i = ulHash & oRReplica->ulMask;
+             (psSlot = &oRReplica->psSlots[i])->oNdNode != NULL;
+             i = (i + 1) & oRReplica->ulMask)
+            if(psSlot->ulHash == ulHash &&
+               psSlot->ulLength == ulLength &&
+               memcmp(oRReplica->pcNames + psSlot->ulOffset, pcPath,
+                      ulLength) == 0)
+               break;
+         /* No deeper prefix can be replicated if this one is not */
+         if(psSlot->oNdNode == NULL)
+            break;
+         oNdFound = psSlot->oNdNode;
+         *pulDepth = ulDepth;
+         if(*pc == '\0')
+            break;
+      }
+      ulHash = (ulHash ^ (unsigned char) *pc) * FNV_PRIME;
+   }
+   return oNdFound;
+}
@@ -0,0 +1,49 @@
+/*--------------------------------------------------------------------*/
+/* ftreplica.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTREPLICA_INCLUDED
+#define FTREPLICA_INCLUDED
+
+/*
+  A replica is a read-only copy of the top levels of a File Tree's
+  directories, placed on one NUMA node: an open-addressing hash table
+  from each directory's pathname to its node, with the pathnames
+  alongside, all in one block. A lookup walks down its path hashing
+  each prefix in turn, and so finds the deepest replicated directory
+  on the way while touching only the replica's memory, not the nodes,
+  children arrays and paths of the directories above it. It refers to
+  the tree's directory nodes, so it must be rebuilt whenever any
+  directory in its levels is added or removed.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "noded.h"
+
+/* An FTReplica_T is a replica of the top levels of a tree */
+typedef struct ftReplica *FTReplica_T;
+
+/*
+  Replicates the directories of depth at most ulLevels of the tree
+  rooted at oNdRoot (NULL for an empty tree) on node iNode. Returns
+  SUCCESS and sets *poRResult if successful. Otherwise, sets *poRResult
+  to NULL and returns MEMORY_ERROR.
+*/
+int FTReplica_build(NodeD_T oNdRoot, size_t ulLevels, int iNode,
+                    FTReplica_T *poRResult);
+
+/* Frees oRReplica. */
+void FTReplica_free(FTReplica_T oRReplica);
+
+/*
+  Returns the deepest directory in oRReplica, of depth at most
+  ulMaxDepth, whose pathname is pcPath or a prefix of it ending at a
+  '/', storing its depth in *pulDepth; or NULL, leaving *pulDepth
+  unchanged, if not even the root is.
+*/
+NodeD_T FTReplica_deepest(FTReplica_T oRReplica, const char *pcPath,
+                          size_t ulMaxDepth, size_t *pulDepth);
+
+#endif
@@ -0,0 +1,676 @@
+/*--------------------------------------------------------------------*/
+/* ftshm.c                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* shm_open, ftruncate and mmap are POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "path.h"
+#include "image.h"
+#include "nodef.h"
+#include "ftshm.h"
+
+/* Identifies a segment as a shared FT */
+enum { FTSHM_MAGIC = 0x46545348 };
+
+/* Alignment of every record in an image */
+enum { FTSHM_ALIGN = sizeof(unsigned long) };
+
+/* Internal status: the image changed under a reader */
+enum { FTSHM_TORN = -1 };
+
+/* The start of a segment. Everything else is addressed from here. */
+struct shmHeader {
+   /* FTSHM_MAGIC once the segment is ready */
+   volatile unsigned long ulMagic;
+
+   /* Sequence counter: odd while the writer flips slots */
+   volatile unsigned long ulSeq;
+
+   /* Which slot (0 or 1) holds the published image */
+   volatile unsigned long ulActive;
+
+   /* Bytes in each slot */
+   unsigned long ulSlotSize;
+};
+
+/* The start of an image. Offsets in an image are from here; offset 0
+   is this record, so it doubles as "none". */
+struct shmImage {
+   /* Offset of the root's node record, or 0 for an empty tree */
+   unsigned long ulRootOff;
+
+   /* Bytes of the slot in use */
+   unsigned long ulUsed;
+};
+
+/* A directory or file in an image */
+struct shmNode {
+   /* Offset and length of the absolute pathname (NUL-terminated) */
+   unsigned long ulPathOff;
+   unsigned long ulPathLen;
+
+   /* 1 for a file, 0 for a directory */
+   unsigned long ulIsFile;
+
+   /* Directories: offsets of arrays of child node offsets, sorted by
+      pathname, and their lengths */
+   unsigned long ulFilesOff;
+   unsigned long ulNumFiles;
+   unsigned long ulDirsOff;
+   unsigned long ulNumDirs;
+
+   /* Files: offset and length of the contents; offset 0 for NULL */
+   unsigned long ulContentsOff;
+   unsigned long ulContentsLen;
+};
+
+/* One process's mapping of a segment */
+struct ftShm {
+   /* Start of the mapping */
+   char *pcBase;
+
+   /* Bytes mapped */
+   size_t ulMapSize;
+
+   /* Bytes in each slot */
+   size_t ulSlotSize;
+
+   /* Whether the mapping is writable */
+   boolean bIsWriter;
+};
+
+/* An image being written */
+struct shmBuilder {
+   /* Start of the slot being written */
+   char *pcSlot;
+
+   /* Bytes of the slot in use and available */
+   size_t ulUsed;
+   size_t ulSize;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Orders the memory accesses before the call against those after it,
+   for both the compiler and the processor. */
+static void FTShm_barrier(void) {
+   __sync_synchronize();
+}
+
+/* Returns the number of bytes ahead of the first slot. */
+static size_t FTShm_headerSize(void) {
+   return (sizeof(struct shmHeader) + FTSHM_ALIGN - 1) /
+          FTSHM_ALIGN * FTSHM_ALIGN;
+}
+
+/* Returns the start of slot ulSlot of oSShm. */
+static char *FTShm_slot(FTShm_T oSShm, unsigned long ulSlot) {
+   assert(oSShm != NULL);
+   assert(ulSlot < 2);
+
+   return oSShm->pcBase + FTShm_headerSize() +
+          ulSlot * oSShm->ulSlotSize;
+}
+
+/* Reserves ulSize bytes of psBuilder's slot, storing their offset in
+   *pulOff. Returns FALSE if the slot is full, TRUE otherwise. */
+static boolean FTShm_alloc(struct shmBuilder *psBuilder, size_t ulSize,
+                           unsigned long *pulOff) {
+   size_t ulStart;
+
+   assert(psBuilder != NULL);
+   assert(pulOff != NULL);
+
+   ulStart = (psBuilder->ulUsed + FTSHM_ALIGN - 1) /
+             FTSHM_ALIGN * FTSHM_ALIGN;
+   if(ulStart > psBuilder->ulSize ||
+      ulSize > psBuilder->ulSize - ulStart)
+      return FALSE;
+   psBuilder->ulUsed = ulStart + ulSize;
+   *pulOff = ulStart;
+   return TRUE;
+}
+
+/* Returns the node record at offset ulOff of psBuilder's slot. */
+static struct shmNode *FTShm_builderNode(struct shmBuilder *psBuilder,
+                                         unsigned long ulOff) {
+   return (struct shmNode *) (void *) (psBuilder->pcSlot + ulOff);
+}
+
+/* Writes a node record for pathname oPPath into psBuilder, storing its
+   offset in *pulOff. Returns FALSE if the slot is full. */
+static boolean FTShm_writeNode(struct shmBuilder *psBuilder,
+                               Path_T oPPath, unsigned long *pulOff) {
+   struct shmNode *psNode;
+   unsigned long ulPathOff;
+   size_t ulPathLen;
+
+   assert(oPPath != NULL);
+
+   ulPathLen = Path_getStrLength(oPPath);
+   if(!FTShm_alloc(psBuilder, sizeof(struct shmNode), pulOff) ||
+      !FTShm_alloc(psBuilder, ulPathLen + 1, &ulPathOff))
+      return FALSE;
+   memcpy(psBuilder->pcSlot + ulPathOff, Path_getPathname(oPPath),
+          ulPathLen + 1);
+
+   psNode = FTShm_builderNode(psBuilder, *pulOff);
+   memset(psNode, 0, sizeof(struct shmNode));
+   psNode->ulPathOff = ulPathOff;
+   psNode->ulPathLen = ulPathLen;
+   return TRUE;
+}
+
+/* Writes file oNfNode and its contents into psBuilder, storing the
+   offset of its record in *pulOff. Returns FALSE if the slot is full. */
+static boolean FTShm_writeFile(struct shmBuilder *psBuilder,
+                               NodeF_T oNfNode, unsigned long *pulOff) {
+   struct shmNode *psNode;
+   void *pvContents;
+   unsigned long ulContentsOff = 0;
+   size_t ulLength;
+
+   assert(oNfNode != NULL);
+
+   if(!FTShm_writeNode(psBuilder, NodeF_getPath(oNfNode), pulOff))
+      return FALSE;
+
+   ulLength = NodeF_getLength(oNfNode);
+   pvContents = NodeF_getContents(oNfNode);
+   if(pvContents != NULL) {
+      /* Reserve at least one byte so that the offset is never 0 */
+      if(!FTShm_alloc(psBuilder, ulLength == 0 ? 1 : ulLength,
+                      &ulContentsOff))
+         return FALSE;
+      memcpy(psBuilder->pcSlot + ulContentsOff, pvContents, ulLength);
+   }
+
+   psNode = FTShm_builderNode(psBuilder, *pulOff);
+   psNode->ulIsFile = 1;
+   psNode->ulContentsOff = ulContentsOff;
+   psNode->ulContentsLen = ulLength;
+   return TRUE;
+}
+
+/* Writes the subtree rooted at oNdNode into psBuilder, storing the
+   offset of oNdNode's record in *pulOff. Returns FALSE if the slot is
+   full. */
+static boolean FTShm_writeDir(struct shmBuilder *psBuilder,
+                              NodeD_T oNdNode, unsigned long *pulOff) {
+   unsigned long ulFilesOff, ulDirsOff, ulChildOff;
+   size_t ulNumFiles, ulNumDirs, i;
+   NodeF_T oNfChild;
+   NodeD_T oNdChild;
+   struct shmNode *psNode;
+
+   assert(oNdNode != NULL);
+
+   ulNumFiles = NodeD_getNumFileChildren(oNdNode);
+   ulNumDirs = NodeD_getNumDirChildren(oNdNode);
+   if(!FTShm_writeNode(psBuilder, NodeD_getPath(oNdNode), pulOff) ||
+      !FTShm_alloc(psBuilder, ulNumFiles * sizeof(unsigned long),
+                   &ulFilesOff) ||
+      !FTShm_alloc(psBuilder, ulNumDirs * sizeof(unsigned long),
+                   &ulDirsOff))
+      return FALSE;
+
+   psNode = FTShm_builderNode(psBuilder, *pulOff);
+   psNode->ulFilesOff = ulFilesOff;
+   psNode->ulNumFiles = ulNumFiles;
+   psNode->ulDirsOff = ulDirsOff;
+   psNode->ulNumDirs = ulNumDirs;
+
+   /* Children keep the order of the tree, which is pathname order */
+   for(i = 0; i < ulNumFiles; i++) {
+      (void) NodeD_getFileChild(oNdNode, i, &oNfChild);
+      if(!FTShm_writeFile(psBuilder, oNfChild, &ulChildOff))
+         return FALSE;
+      ((unsigned long *) (void *) (psBuilder->pcSlot + ulFilesOff))[i] =
+         ulChildOff;
+   }
+   for(i = 0; i < ulNumDirs; i++) {
+      (void) NodeD_getDirChild(oNdNode, i, &oNdChild);
+      if(!FTShm_writeDir(psBuilder, oNdChild, &ulChildOff))
+         return FALSE;
+      ((unsigned long *) (void *) (psBuilder->pcSlot + ulDirsOff))[i] =
+         ulChildOff;
+   }
+   return TRUE;
+}
+
+/*
+  Readers must survive an image being rewritten under them, so every
+  offset read from the segment is checked against the slot before it
+  is followed; a check failing means the image changed (FTSHM_TORN).
+*/
+
+/* Returns the node record at offset ulOff of the slot pcSlot of
+   ulSize bytes, or NULL if ulOff cannot hold one. */
+static const struct shmNode *FTShm_node(const char *pcSlot,
+                                        size_t ulSize,
+                                        unsigned long ulOff) {
+   if(ulOff == 0 || ulOff % FTSHM_ALIGN != 0 ||
+      !Image_fits(ulSize, ulOff, 1, sizeof(struct shmNode)))
+      return NULL;
+   return (const struct shmNode *) (const void *) (pcSlot + ulOff);
+}
+
+/* Finds the child of psParent (among its files if bFiles is TRUE, its
+   directories if not) whose pathname is the first ulLength characters
+   of pcPath, storing it in *ppsResult (NULL if none). Returns SUCCESS,
+   or FTSHM_TORN if the image is inconsistent. */
+static int FTShm_findChild(const char *pcSlot, size_t ulSize,
+                           const struct shmNode *psParent,
+                           boolean bFiles, const char *pcPath,
+                           size_t ulLength,
+                           const struct shmNode **ppsResult) {
+   const unsigned long *pulChildren;
+   const struct shmNode *psChild;
+   unsigned long ulArrayOff, ulCount, ulLow, ulHigh, ulMid;
+   size_t ulCommon;
+   int iCompare;
+
+   ulArrayOff = bFiles ? psParent->ulFilesOff : psParent->ulDirsOff;
+   ulCount = bFiles ? psParent->ulNumFiles : psParent->ulNumDirs;
+   *ppsResult = NULL;
+   if(!Image_fits(ulSize, ulArrayOff, ulCount, sizeof(unsigned long)))
+      return FTSHM_TORN;
+   pulChildren = (const unsigned long *) (const void *)
+                 (pcSlot + ulArrayOff);
+
+   ulLow = 0;
+   ulHigh = ulCount;
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      psChild = FTShm_node(pcSlot, ulSize, pulChildren[ulMid]);
+      if(psChild == NULL ||
+         !Image_fits(ulSize, psChild->ulPathOff, psChild->ulPathLen, 1))
+         return FTSHM_TORN;
+
+      ulCommon = psChild->ulPathLen < ulLength ?
+                 psChild->ulPathLen : ulLength;
+      iCompare = memcmp(pcSlot + psChild->ulPathOff, pcPath, ulCommon);
+      if(iCompare == 0 && psChild->ulPathLen != ulLength)
+         iCompare = psChild->ulPathLen < ulLength ? -1 : 1;
+
+      if(iCompare == 0) {
+         *ppsResult = psChild;
+         return SUCCESS;
+      }
+      if(iCompare < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   return SUCCESS;
+}
+
+/* Looks up the well-formatted path pcPath in the image in pcSlot of
+   ulSize bytes, storing its record in *ppsResult. Returns SUCCESS,
+   CONFLICTING_PATH, NO_SUCH_PATH, or FTSHM_TORN. */
+static int FTShm_lookup(const char *pcSlot, size_t ulSize,
+                        const char *pcPath,
+                        const struct shmNode **ppsResult) {
+   const struct shmImage *psImage;
+   const struct shmNode *psNode, *psChild;
+   size_t ulPos, ulEnd;
+   int iStatus;
+
+   *ppsResult = NULL;
+   psImage = (const struct shmImage *) (const void *) pcSlot;
+   if(psImage->ulRootOff == 0)
+      return NO_SUCH_PATH;
+   psNode = FTShm_node(pcSlot, ulSize, psImage->ulRootOff);
+   if(psNode == NULL ||
+      !Image_fits(ulSize, psNode->ulPathOff, psNode->ulPathLen, 1))
+      return FTSHM_TORN;
+
+   /* The root must be the first component */
+   ulEnd = strcspn(pcPath, "/");
+   if(psNode->ulPathLen != ulEnd ||
+      memcmp(pcSlot + psNode->ulPathOff, pcPath, ulEnd) != 0)
+      return CONFLICTING_PATH;
+
+   /* Descend one component at a time; at each level the child sought
+      is named by the prefix of pcPath through that component */
+   for(ulPos = ulEnd; pcPath[ulPos] != '\0'; ulPos = ulEnd) {
+      ulEnd = ulPos + 1 + strcspn(pcPath + ulPos + 1, "/");
+      iStatus = FTShm_findChild(pcSlot, ulSize, psNode, FALSE, pcPath,
+                                ulEnd, &psChild);
+      if(iStatus == SUCCESS && psChild == NULL && pcPath[ulEnd] == '\0')
+         iStatus = FTShm_findChild(pcSlot, ulSize, psNode, TRUE, pcPath,
+                                   ulEnd, &psChild);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      if(psChild == NULL)
+         return NO_SUCH_PATH;
+      psNode = psChild;
+   }
+
+   *ppsResult = psNode;
+   return SUCCESS;
+}
+
+/* Begins a read of oSShm: waits out any slot flip in progress, stores
+   the sequence number to check against in *pulSeq, and returns the
+   start of the published slot. */
+static const char *FTShm_readBegin(FTShm_T oSShm, unsigned long *pulSeq) {
+   struct shmHeader *psHeader;
+   unsigned long ulActive;
+
+   psHeader = (struct shmHeader *) (void *) oSShm->pcBase;
+   do {
+      *pulSeq = psHeader->ulSeq;
+      FTShm_barrier();
+   } while(*pulSeq % 2 != 0);
+   ulActive = psHeader->ulActive;
+   return FTShm_slot(oSShm, ulActive % 2);
+}
+
+/* Ends a read of oSShm begun at sequence number ulSeq. Returns TRUE if
+   no slot flip happened since, so that what was read is valid. */
+static boolean FTShm_readEnd(FTShm_T oSShm, unsigned long ulSeq) {
+   struct shmHeader *psHeader;
+
+   psHeader = (struct shmHeader *) (void *) oSShm->pcBase;
+   FTShm_barrier();
+   return (boolean) (psHeader->ulSeq == ulSeq);
+}
+
+/* Looks up pcPath in the image published in oSShm and copies what the
+   caller needs out of its record into *psResult, retrying until the
+   copy is consistent. If bCopyContents is TRUE, also copies the
+   contents into newly allocated memory stored in *ppvContents.
+   Returns SUCCESS or any status FTShm_stat documents. */
+static int FTShm_read(FTShm_T oSShm, const char *pcPath,
+                      struct shmNode *psResult, boolean bCopyContents,
+                      void **ppvContents) {
+   const struct shmNode *psNode;
+   const char *pcSlot;
+   unsigned long ulSeq;
+   void *pvCopy;
+   int iStatus;
+
+   assert(oSShm != NULL);
+   assert(pcPath != NULL);
+   assert(psResult != NULL);
+
+   if(!Image_isWellFormed(pcPath))
+      return BAD_PATH;
+
+   for(;;) {
+      pvCopy = NULL;
+      pcSlot = FTShm_readBegin(oSShm, &ulSeq);
+      iStatus = FTShm_lookup(pcSlot, oSShm->ulSlotSize, pcPath, &psNode);
+      if(iStatus == SUCCESS) {
+         *psResult = *psNode;
+         if(bCopyContents && psResult->ulIsFile &&
+            psResult->ulContentsOff != 0) {
+            if(!Image_fits(oSShm->ulSlotSize, psResult->ulContentsOff,
+                           psResult->ulContentsLen, 1))
+               iStatus = FTSHM_TORN;
+            else {
+               pvCopy = malloc(psResult->ulContentsLen == 0 ?
+                               1 : psResult->ulContentsLen);
+               if(pvCopy == NULL)
+                  return MEMORY_ERROR;
+               memcpy(pvCopy, pcSlot + psResult->ulContentsOff,
+                      psResult->ulContentsLen);
+            }
+         }
+      }
+      if(FTShm_readEnd(oSShm, ulSeq))
+         break;
+      free(pvCopy);
+   }
+
+   /* A consistent image that fails the checks is not a shared FT */
+   if(iStatus == FTSHM_TORN)
+      return INITIALIZATION_ERROR;
+   if(ppvContents != NULL)
+      *ppvContents = pvCopy;
+   return iStatus;
+}
+
+/* ================================================================== */
+int FTShm_create(const char *pcName, size_t ulSlotSize,
+                 FTShm_T *poSResult) {
+   FTShm_T oSShm;
+   struct shmHeader *psHeader;
+   struct shmImage *psImage;
+   int iFd;
+   void *pvMap;
+
+   assert(pcName != NULL);
+   assert(poSResult != NULL);
+
+   *poSResult = NULL;
+   oSShm = malloc(sizeof(struct ftShm));
+   if(oSShm == NULL)
+      return MEMORY_ERROR;
+
+   /* Round the slots so that every image starts aligned */
+   ulSlotSize = (ulSlotSize < sizeof(struct shmImage) ?
+                 sizeof(struct shmImage) : ulSlotSize);
+   ulSlotSize = (ulSlotSize + FTSHM_ALIGN - 1) / FTSHM_ALIGN *
+                FTSHM_ALIGN;
+   oSShm->ulSlotSize = ulSlotSize;
+   oSShm->ulMapSize = FTShm_headerSize() + 2 * ulSlotSize;
+   oSShm->bIsWriter = TRUE;
+
+   /* Replace an old segment by unlinking it rather than truncating
+      it, so that readers still mapping it keep their pages and can
+      attach to the new one at leisure; O_EXCL then fails rather than
+      share a segment with another writer that won the race */
+   (void) shm_unlink(pcName);
+   iFd = shm_open(pcName, O_RDWR | O_CREAT | O_EXCL, 0644);
+   if(iFd < 0) {
+      free(oSShm);
+      return BAD_PATH;
+   }
+   if(ftruncate(iFd, (off_t) oSShm->ulMapSize) != 0) {
+      close(iFd);
+      (void) shm_unlink(pcName);
+      free(oSShm);
+      return BAD_PATH;
+   }
+   pvMap = mmap(NULL, oSShm->ulMapSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED, iFd, 0);
+   close(iFd);
+   if(pvMap == MAP_FAILED) {
+      (void) shm_unlink(pcName);
+      free(oSShm);
+      return BAD_PATH;
+   }
+   oSShm->pcBase = pvMap;
+
+   /* Publish an empty tree, then mark the segment ready */
+   psHeader = (struct shmHeader *) pvMap;
+   psHeader->ulSeq = 0;
+   psHeader->ulActive = 0;
+   psHeader->ulSlotSize = ulSlotSize;
+   psImage = (struct shmImage *) (void *) FTShm_slot(oSShm, 0);
+   psImage->ulRootOff = 0;
+   psImage->ulUsed = sizeof(struct shmImage);
+   FTShm_barrier();
+   psHeader->ulMagic = FTSHM_MAGIC;
+
+   *poSResult = oSShm;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTShm_attach(const char *pcName, FTShm_T *poSResult) {
+   FTShm_T oSShm;
+   const struct shmHeader *psHeader;
+   struct stat sStat;
+   int iFd;
+   void *pvMap;
+
+   assert(pcName != NULL);
+   assert(poSResult != NULL);
+
+   *poSResult = NULL;
+   iFd = shm_open(pcName, O_RDONLY, 0);
+   if(iFd < 0)
+      return errno == ENOENT ? NO_SUCH_PATH : BAD_PATH;
+   if(fstat(iFd, &sStat) != 0) {
+      close(iFd);
+      return BAD_PATH;
+   }
+   if((size_t) sStat.st_size < FTShm_headerSize()) {
+      close(iFd);
+      return INITIALIZATION_ERROR;
+   }
+
+   oSShm = malloc(sizeof(struct ftShm));
+   if(oSShm == NULL) {
+      close(iFd);
+      return MEMORY_ERROR;
+   }
+   oSShm->ulMapSize = (size_t) sStat.st_size;
+   pvMap = mmap(NULL, oSShm->ulMapSize, PROT_READ, MAP_SHARED, iFd, 0);
+   close(iFd);
+   if(pvMap == MAP_FAILED) {
+      free(oSShm);
+      return BAD_PATH;
+   }
+   oSShm->pcBase = pvMap;
+   oSShm->bIsWriter = FALSE;
+
+   /* The slot size never changes, so it is read once and checked
+      against the size of the mapping */
+   psHeader = (const struct shmHeader *) pvMap;
+   oSShm->ulSlotSize = psHeader->ulSlotSize;
+   if(psHeader->ulMagic != FTSHM_MAGIC ||
+      oSShm->ulSlotSize < sizeof(struct shmImage) ||
+      oSShm->ulSlotSize % FTSHM_ALIGN != 0 ||
+      oSShm->ulSlotSize > (oSShm->ulMapSize - FTShm_headerSize()) / 2) {
+      FTShm_close(oSShm);
+      return INITIALIZATION_ERROR;
+   }
+
+   *poSResult = oSShm;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void FTShm_close(FTShm_T oSShm) {
+   assert(oSShm != NULL);
+
+   (void) munmap(oSShm->pcBase, oSShm->ulMapSize);
+   free(oSShm);
+}
+
+/* ================================================================== */
+int FTShm_unlink(const char *pcName) {
+   assert(pcName != NULL);
+
+   if(shm_unlink(pcName) != 0)
+      return NO_SUCH_PATH;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTShm_publish(FTShm_T oSShm, NodeD_T oNdRoot) {
+   struct shmHeader *psHeader;
+   struct shmBuilder sBuilder;
+   struct shmImage *psImage;
+   unsigned long ulTarget, ulRootOff = 0, ulImageOff;
+
+   assert(oSShm != NULL);
+   assert(oSShm->bIsWriter);
+
+   /* Readers only ever use the active slot, so the other one can be
+      rewritten freely; a reader still on it from before the last flip
+      will see the sequence number moved and retry */
+   psHeader = (struct shmHeader *) (void *) oSShm->pcBase;
+   ulTarget = 1 - psHeader->ulActive;
+   sBuilder.pcSlot = FTShm_slot(oSShm, ulTarget);
+   sBuilder.ulUsed = 0;
+   sBuilder.ulSize = oSShm->ulSlotSize;
+
+   (void) FTShm_alloc(&sBuilder, sizeof(struct shmImage), &ulImageOff);
+   if(oNdRoot != NULL && !FTShm_writeDir(&sBuilder, oNdRoot, &ulRootOff))
+      return MEMORY_ERROR;
+   psImage = (struct shmImage *) (void *) sBuilder.pcSlot;
+   psImage->ulRootOff = ulRootOff;
+   psImage->ulUsed = sBuilder.ulUsed;
+
+   /* Flip under the seqlock */
+   FTShm_barrier();
+   psHeader->ulSeq++;
+   FTShm_barrier();
+   psHeader->ulActive = ulTarget;
+   FTShm_barrier();
+   psHeader->ulSeq++;
+
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int FTShm_stat(FTShm_T oSShm, const char *pcPath, boolean *pbIsFile,
+               size_t *pulSize) {
+   struct shmNode sNode;
+   int iStatus;
+
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   iStatus = FTShm_read(oSShm, pcPath, &sNode, FALSE, NULL);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   *pbIsFile = (boolean) (sNode.ulIsFile != 0);
+   if(*pbIsFile)
+      *pulSize = sNode.ulContentsLen;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+boolean FTShm_containsDir(FTShm_T oSShm, const char *pcPath) {
+   struct shmNode sNode;
+
+   return (boolean) (FTShm_read(oSShm, pcPath, &sNode, FALSE, NULL)
+                     == SUCCESS && !sNode.ulIsFile);
+}
+
+/* ================================================================== */
+boolean FTShm_containsFile(FTShm_T oSShm, const char *pcPath) {
+   struct shmNode sNode;
+
+   return (boolean) (FTShm_read(oSShm, pcPath, &sNode, FALSE, NULL)
+                     == SUCCESS && sNode.ulIsFile);
+}
+
+/* ================================================================== */
+int FTShm_getFileContents(FTShm_T oSShm, const char *pcPath,
+                          void **ppvResult, size_t *pulLength) {
+   struct shmNode sNode;
+   void *pvCopy;
+   int iStatus;
+
+   assert(ppvResult != NULL);
+   assert(pulLength != NULL);
+
+   iStatus = FTShm_read(oSShm, pcPath, &sNode, TRUE, &pvCopy);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!sNode.ulIsFile)
+      return NOT_A_FILE;
+
+   *ppvResult = pvCopy;
+   *pulLength = sNode.ulContentsLen;
+   return SUCCESS;
+}
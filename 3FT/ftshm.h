@@ -0,0 +1,99 @@
+/*--------------------------------------------------------------------*/
+/* ftshm.h                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTSHM_INCLUDED
+#define FTSHM_INCLUDED
+
+/*
+  A shared FT is a POSIX shared-memory segment holding an image of a
+  File Tree (nodes, child arrays, pathnames and contents) in which
+  every reference is an offset rather than a pointer, so any process
+  can map it at any address. One writer process publishes images;
+  any number of reader processes look paths up in place.
+
+  The segment holds two image slots. The writer always builds into
+  the inactive slot and then flips the active one under a sequence
+  counter (a seqlock): readers record the counter, work on the active
+  slot, and retry if the counter moved, so they never block the writer
+  and never act on a half-written image.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "noded.h"
+
+/* An FTShm_T is one process's mapping of a shared FT segment */
+typedef struct ftShm *FTShm_T;
+
+/*
+  Creates (or replaces) the shared-memory segment named pcName (e.g.
+  "/myft") with two image slots of ulSlotSize bytes each and maps it
+  for writing. The segment starts out holding an empty tree. A segment
+  already of that name is unlinked, not reused, so readers that still
+  map it see its last image until they attach again.
+  Returns SUCCESS and sets *poSResult if successful. Otherwise, sets
+  *poSResult to NULL and returns:
+  * BAD_PATH if the segment could not be created or mapped
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FTShm_create(const char *pcName, size_t ulSlotSize,
+                 FTShm_T *poSResult);
+
+/*
+  Maps the existing shared-memory segment named pcName for reading.
+  Returns SUCCESS and sets *poSResult if successful. Otherwise, sets
+  *poSResult to NULL and returns:
+  * NO_SUCH_PATH if there is no such segment
+  * INITIALIZATION_ERROR if the segment is not a shared FT
+  * BAD_PATH if the segment could not be mapped
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FTShm_attach(const char *pcName, FTShm_T *poSResult);
+
+/* Unmaps oSShm and frees the memory allocated for it. The segment
+   itself persists until FTShm_unlink. */
+void FTShm_close(FTShm_T oSShm);
+
+/* Removes the segment named pcName; mappings stay valid until closed.
+   Returns SUCCESS, or NO_SUCH_PATH if there is no such segment. */
+int FTShm_unlink(const char *pcName);
+
+/*
+  Writes an image of the tree rooted at oNdRoot (NULL for an empty
+  tree) into oSShm, which must have been created by this process, and
+  makes it the image readers see. Returns SUCCESS if published, or
+  MEMORY_ERROR if the image does not fit in a slot (in which case the
+  previous image stays visible).
+*/
+int FTShm_publish(FTShm_T oSShm, NodeD_T oNdRoot);
+
+/*
+  Behaves like FT_stat on the image currently published in oSShm.
+  Also returns INITIALIZATION_ERROR if oSShm's segment is not a
+  shared FT.
+*/
+int FTShm_stat(FTShm_T oSShm, const char *pcPath, boolean *pbIsFile,
+               size_t *pulSize);
+
+/* Returns TRUE if the published image holds a directory with absolute
+   path pcPath, FALSE if not or if there is an error while checking. */
+boolean FTShm_containsDir(FTShm_T oSShm, const char *pcPath);
+
+/* Returns TRUE if the published image holds a file with absolute path
+   pcPath, FALSE if not or if there is an error while checking. */
+boolean FTShm_containsFile(FTShm_T oSShm, const char *pcPath);
+
+/*
+  Copies the contents of the file with absolute path pcPath in the
+  published image into newly allocated memory, owned by the caller,
+  storing it in *ppvResult (NULL if the file's contents are NULL) and
+  its length in *pulLength. Returns SUCCESS if successful, NOT_A_FILE
+  if pcPath is a directory, MEMORY_ERROR if the copy cannot be made,
+  or any status FTShm_stat returns for pcPath.
+*/
+int FTShm_getFileContents(FTShm_T oSShm, const char *pcPath,
+                          void **ppvResult, size_t *pulLength);
+
+#endif
@@ -0,0 +1,406 @@
+/*--------------------------------------------------------------------*/
+/* graft_client.c                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  graft_client checks FT_detachSubtree, FT_graft and FT_freeSubtree.
+
+  Usage: graft_client [-r rounds] [-s seed]
+
+  Each round builds a random tree below r and detaches it whole, then
+  builds a second random tree in a fresh FT and grafts the first into
+  it, the rounds taking FT_CONFLICT_FAIL, FT_CONFLICT_KEEP and
+  FT_CONFLICT_REPLACE in turn. The FT's paths, their kinds and their
+  contents must then be those of a model merge of the two trees, and
+  the files passed to pfDropped exactly the files the policy drops.
+  A graft that fails must leave the FT as it was and the subtree
+  whole, which it then shows by grafting into an empty FT or by being
+  freed. Each round ends by detaching a directory below the root and
+  grafting it back, which must change nothing. It also checks the
+  statuses of calls that cannot succeed, and that each leaves the FT
+  and the subtree unchanged.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Paths inserted into each tree, of which some fail */
+enum { NUM_INSERTS = 40 };
+
+/* Deepest path drawn, counting the root */
+enum { MAX_DEPTH = 4 };
+
+/* Longest path drawn, including its terminator */
+enum { MAX_PATH = 32 };
+
+/* Most entries in the merge of two trees: each insertion adds at
+   most MAX_DEPTH - 1 nodes below the shared root */
+enum { MAX_ENTRIES = 1 + 2 * NUM_INSERTS * (MAX_DEPTH - 1) };
+
+/* Indexes into asTrees: the tree grafted, and the FT's tree */
+enum { GRAFTED, TARGET, NUM_TREES };
+
+/* One file or directory of a tree */
+struct entry {
+   char acPath[MAX_PATH];
+   boolean bIsFile;
+   void *pvContents;
+};
+
+/* A tree's entries, sorted by strcmp of their pathnames */
+struct tree {
+   struct entry asEntries[MAX_ENTRIES];
+   size_t ulCount;
+};
+
+/* The two trees before the graft, the model of the FT after it, the
+   FT itself, and the files the model and FT_graft drop */
+static struct tree asTrees[NUM_TREES];
+static struct tree sExpected, sActual, sExpectedDropped, sDropped;
+
+/* Contents of each tree's files, told apart by their addresses */
+static char aacContents[NUM_TREES][NUM_INSERTS];
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the pathnames of the entries at pvFirst and pvSecond. */
+static int GraftClient_compare(const void *pvFirst,
+                               const void *pvSecond) {
+   return strcmp(((const struct entry *) pvFirst)->acPath,
+                 ((const struct entry *) pvSecond)->acPath);
+}
+
+/* Appends an entry for pcPath to *psTree. */
+static void GraftClient_add(struct tree *psTree, const char *pcPath,
+                            boolean bIsFile, void *pvContents) {
+   struct entry *psEntry;
+
+   assert(psTree->ulCount < MAX_ENTRIES);
+   assert(strlen(pcPath) < MAX_PATH);
+   psEntry = &psTree->asEntries[psTree->ulCount++];
+   strcpy(psEntry->acPath, pcPath);
+   psEntry->bIsFile = bIsFile;
+   psEntry->pvContents = pvContents;
+}
+
+/* Returns the entry of *psTree for pcPath, or NULL if none. */
+static struct entry *GraftClient_find(struct tree *psTree,
+                                      const char *pcPath) {
+   struct entry sKey;
+
+   strcpy(sKey.acPath, pcPath);
+   return bsearch(&sKey, psTree->asEntries, psTree->ulCount,
+                  sizeof(struct entry), GraftClient_compare);
+}
+
+/* Visits pcPath for FT_scanRange, appending it to the tree at
+   pvExtra. */
+static void GraftClient_visit(const char *pcPath, boolean bIsFile,
+                              void *pvExtra) {
+   GraftClient_add((struct tree *) pvExtra, pcPath, bIsFile, NULL);
+}
+
+/* Records pcPath as dropped in the tree at pvExtra. */
+static void GraftClient_drop(const char *pcPath, void *pvContents,
+                             size_t ulLength, void *pvExtra) {
+   assert(ulLength == 1);
+   GraftClient_add((struct tree *) pvExtra, pcPath, TRUE, pvContents);
+}
+
+/* Stores the FT's entries and their contents in *psTree. */
+static void GraftClient_snapshot(struct tree *psTree) {
+   struct entry *psEntry;
+   size_t i;
+
+   psTree->ulCount = 0;
+   assert(FT_scanRange(NULL, NULL, GraftClient_visit, psTree) ==
+          SUCCESS);
+   for(i = 0; i < psTree->ulCount; i++) {
+      psEntry = &psTree->asEntries[i];
+      if(psEntry->bIsFile)
+         psEntry->pvContents = FT_getFileContents(psEntry->acPath);
+   }
+}
+
+/* Checks that *psFirst and *psSecond hold the same entries, with the
+   same contents. */
+static void GraftClient_same(struct tree *psFirst,
+                             struct tree *psSecond) {
+   size_t i;
+
+   assert(psFirst->ulCount == psSecond->ulCount);
+   for(i = 0; i < psFirst->ulCount; i++) {
+      assert(strcmp(psFirst->asEntries[i].acPath,
+                    psSecond->asEntries[i].acPath) == 0);
+      assert(psFirst->asEntries[i].bIsFile ==
+             psSecond->asEntries[i].bIsFile);
+      assert(psFirst->asEntries[i].pvContents ==
+             psSecond->asEntries[i].pvContents);
+   }
+}
+
+/* Inserts random files and directories below r into the FT, the files
+   with contents from aacContents[iTree]. Paths are drawn from up to
+   MAX_DEPTH levels with components "a", "b", "c" and "a.b", which
+   sorts between "a"'s children and "b". */
+static void GraftClient_build(int iTree) {
+   static const char *apcNames[] = { "a", "b", "c", "a.b" };
+   char acPath[MAX_PATH];
+   size_t ulDepth, i, j;
+
+   for(i = 0; i < NUM_INSERTS; i++) {
+      ulDepth = 2 + (size_t) rand() % (MAX_DEPTH - 1);
+      strcpy(acPath, "r");
+      for(j = 1; j < ulDepth; j++) {
+         strcat(acPath, "/");
+         strcat(acPath, apcNames[rand() % 4]);
+      }
+      if(rand() % 3 == 0)
+         (void) FT_insertDir(acPath);
+      else
+         (void) FT_insertFile(acPath, &aacContents[iTree][i], 1);
+   }
+}
+
+/* Returns TRUE if both trees hold pcPath and not both as directories,
+   FALSE otherwise. */
+static boolean GraftClient_conflictsAt(const char *pcPath) {
+   struct entry *psGrafted, *psTarget;
+
+   psGrafted = GraftClient_find(&asTrees[GRAFTED], pcPath);
+   psTarget = GraftClient_find(&asTrees[TARGET], pcPath);
+   return (boolean) (psGrafted != NULL && psTarget != NULL &&
+                     (psGrafted->bIsFile || psTarget->bIsFile));
+}
+
+/* Returns TRUE if pcPath or one of its prefixes is a conflict, FALSE
+   otherwise. */
+static boolean GraftClient_underConflict(const char *pcPath) {
+   char acPrefix[MAX_PATH];
+   size_t i;
+
+   strcpy(acPrefix, pcPath);
+   for(i = strlen(acPrefix); i > 0; i--)
+      if(acPrefix[i] == '\0' || acPrefix[i] == '/') {
+         acPrefix[i] = '\0';
+         if(GraftClient_conflictsAt(acPrefix))
+            return TRUE;
+      }
+   return FALSE;
+}
+
+/* Stores in sExpected the FT that grafting asTrees[GRAFTED] into
+   asTrees[TARGET] under eConflict leaves, and in sExpectedDropped the
+   files it drops. Under FT_CONFLICT_FAIL there must be no conflict. */
+static void GraftClient_expect(enum FTConflict eConflict) {
+   struct tree *psWinner, *psLoser;
+   struct entry *psEntry;
+   size_t i;
+
+   if(eConflict == FT_CONFLICT_REPLACE) {
+      psWinner = &asTrees[GRAFTED];
+      psLoser = &asTrees[TARGET];
+   }
+   else {
+      psWinner = &asTrees[TARGET];
+      psLoser = &asTrees[GRAFTED];
+   }
+
+   /* The winner keeps everything; the loser keeps what is not below a
+      conflict, its shared directories being merged */
+   sExpected = *psWinner;
+   sExpectedDropped.ulCount = 0;
+   for(i = 0; i < psLoser->ulCount; i++) {
+      psEntry = &psLoser->asEntries[i];
+      if(GraftClient_underConflict(psEntry->acPath)) {
+         assert(eConflict != FT_CONFLICT_FAIL);
+         if(psEntry->bIsFile)
+            GraftClient_add(&sExpectedDropped, psEntry->acPath, TRUE,
+                            psEntry->pvContents);
+      }
+      else if(GraftClient_find(psWinner, psEntry->acPath) == NULL)
+         GraftClient_add(&sExpected, psEntry->acPath,
+                         psEntry->bIsFile, psEntry->pvContents);
+   }
+   qsort(sExpected.asEntries, sExpected.ulCount, sizeof(struct entry),
+         GraftClient_compare);
+}
+
+/* Checks that the FT's FT_toString is pcExpected. */
+static void GraftClient_unchanged(const char *pcExpected) {
+   char *pcString = FT_toString();
+
+   assert(pcString != NULL);
+   assert(strcmp(pcString, pcExpected) == 0);
+   free(pcString);
+}
+
+/* Runs one round, grafting under eConflict. */
+static void GraftClient_round(enum FTConflict eConflict) {
+   FTSubtree_T oSSubtree;
+   boolean bConflict = FALSE;
+   size_t ulFiles = 0, i;
+   char *pcBefore;
+   int iStatus;
+
+   assert(FT_init() == SUCCESS);
+   GraftClient_build(GRAFTED);
+   GraftClient_snapshot(&asTrees[GRAFTED]);
+   assert(FT_detachSubtree("r", &oSSubtree) == SUCCESS);
+   assert(!FT_containsDir("r"));
+   assert(FT_destroy() == SUCCESS);
+
+   /* The subtree outlives the FT it came from */
+   assert(FT_init() == SUCCESS);
+   GraftClient_build(TARGET);
+   GraftClient_snapshot(&asTrees[TARGET]);
+   for(i = 0; i < asTrees[GRAFTED].ulCount; i++) {
+      if(GraftClient_conflictsAt(asTrees[GRAFTED].asEntries[i].acPath))
+         bConflict = TRUE;
+      ulFiles += asTrees[GRAFTED].asEntries[i].bIsFile;
+   }
+
+   sDropped.ulCount = 0;
+   iStatus = FT_graft(oSSubtree, eConflict, GraftClient_drop,
+                      &sDropped);
+   if(eConflict == FT_CONFLICT_FAIL && bConflict) {
+      /* Nothing moves, and the subtree is whole */
+      assert(iStatus == ALREADY_IN_TREE);
+      assert(sDropped.ulCount == 0);
+      GraftClient_snapshot(&sActual);
+      GraftClient_same(&sActual, &asTrees[TARGET]);
+      assert(FT_destroy() == SUCCESS);
+      assert(FT_init() == SUCCESS);
+      if(rand() % 2 == 0) {
+         assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, GraftClient_drop,
+                         &sDropped) == SUCCESS);
+         assert(sDropped.ulCount == 0);
+         GraftClient_snapshot(&sActual);
+         GraftClient_same(&sActual, &asTrees[GRAFTED]);
+      }
+      else {
+         FT_freeSubtree(oSSubtree, GraftClient_drop, &sDropped);
+         assert(sDropped.ulCount == ulFiles);
+      }
+   }
+   else {
+      assert(iStatus == SUCCESS);
+      GraftClient_expect(eConflict);
+      GraftClient_snapshot(&sActual);
+      GraftClient_same(&sActual, &sExpected);
+      qsort(sDropped.asEntries, sDropped.ulCount, sizeof(struct entry),
+            GraftClient_compare);
+      GraftClient_same(&sDropped, &sExpectedDropped);
+   }
+
+   /* A directory below the root, detached and grafted back */
+   if(FT_containsDir("r/a")) {
+      pcBefore = FT_toString();
+      assert(pcBefore != NULL);
+      assert(FT_detachSubtree("r/a", &oSSubtree) == SUCCESS);
+      assert(!FT_containsDir("r/a"));
+      assert(FT_containsDir("r"));
+      assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) ==
+             SUCCESS);
+      GraftClient_unchanged(pcBefore);
+      free(pcBefore);
+   }
+   assert(FT_destroy() == SUCCESS);
+}
+
+/* Checks the statuses of detaches and grafts that cannot succeed, and
+   that each leaves the FT and the subtree as they were. */
+static void GraftClient_failures(void) {
+   static char cContents = 'x';
+   FTSubtree_T oSSubtree, oSFailed;
+   char *pcBefore;
+
+   assert(FT_detachSubtree("r", &oSFailed) == INITIALIZATION_ERROR);
+   assert(oSFailed == NULL);
+
+   assert(FT_init() == SUCCESS);
+   assert(FT_insertFile("r/a/b/f", &cContents, 1) == SUCCESS);
+   assert(FT_insertDir("r/a/b/d") == SUCCESS);
+   pcBefore = FT_toString();
+   assert(pcBefore != NULL);
+   assert(FT_detachSubtree("r/", &oSFailed) == BAD_PATH);
+   assert(oSFailed == NULL);
+   assert(FT_detachSubtree("x/a", &oSFailed) == CONFLICTING_PATH);
+   assert(FT_detachSubtree("r/q", &oSFailed) == NO_SUCH_PATH);
+   assert(FT_detachSubtree("r/a/b/f", &oSFailed) == NOT_A_DIRECTORY);
+   assert(oSFailed == NULL);
+   assert(FT_detachSubtree("r/a/b", &oSSubtree) == SUCCESS);
+   GraftClient_unchanged("r\nr/a\n");
+
+   /* A file above the subtree's top blocks it, whatever the policy */
+   assert(FT_rmDir("r/a") == SUCCESS);
+   assert(FT_insertFile("r/a", &cContents, 1) == SUCCESS);
+   assert(FT_graft(oSSubtree, FT_CONFLICT_REPLACE, NULL, NULL) ==
+          NOT_A_DIRECTORY);
+   GraftClient_unchanged("r\nr/a\n");
+   assert(FT_destroy() == SUCCESS);
+   assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) ==
+          INITIALIZATION_ERROR);
+
+   assert(FT_init() == SUCCESS);
+   assert(FT_insertDir("x") == SUCCESS);
+   assert(FT_graft(oSSubtree, FT_CONFLICT_KEEP, NULL, NULL) ==
+          CONFLICTING_PATH);
+   GraftClient_unchanged("x\n");
+   assert(FT_destroy() == SUCCESS);
+
+   /* Contents in the content store cannot move between trees */
+   assert(FT_init() == SUCCESS);
+   assert(FT_setContentBudget(64, "graft_client.spill") == SUCCESS);
+   assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) ==
+          INITIALIZATION_ERROR);
+   assert(FT_insertDir("r/a") == SUCCESS);
+   assert(FT_detachSubtree("r/a", &oSFailed) == INITIALIZATION_ERROR);
+   assert(oSFailed == NULL);
+   assert(FT_destroy() == SUCCESS);
+   (void) remove("graft_client.spill");
+
+   /* Still whole after every failure, with the directories above it
+      created again */
+   assert(FT_init() == SUCCESS);
+   assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) ==
+          SUCCESS);
+   GraftClient_unchanged(pcBefore);
+   assert(FT_getFileContents("r/a/b/f") == &cContents);
+   assert(FT_destroy() == SUCCESS);
+   free(pcBefore);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 300, ulSeed = 1, r;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   GraftClient_failures();
+   for(r = 0; r < ulRounds; r++)
+      GraftClient_round((enum FTConflict) (r % 3));
+
+   printf("%lu grafts matched the model\n", ulRounds);
+   return EXIT_SUCCESS;
+}
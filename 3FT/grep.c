@@ -0,0 +1,319 @@
+/*--------------------------------------------------------------------*/
+/* grep.c                                                             */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* Threads and sysconf are POSIX, not C90 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "path.h"
+#include "contentstore.h"
+#include "grep.h"
+
+/* Bytes per chunk, so that large files are shared among threads */
+enum { CHUNK_SIZE = 1024 * 1024 };
+
+/* Below this many bytes in total, threads cost more than they save */
+enum { PARALLEL_THRESHOLD = 4 * 1024 * 1024 };
+
+/* Most worker threads used */
+enum { MAX_THREADS = 16 };
+
+/* Most threads the caller allows, or 0 for no limit */
+static size_t ulMaxThreads;
+
+/* A piece of one file's contents to search */
+struct grepChunk {
+   /* The file and its contents */
+   NodeF_T oNfFile;
+   const char *pcContents;
+   size_t ulLength;
+
+   /* Occurrences starting in [ulStart, ulEnd) belong to this chunk */
+   size_t ulStart;
+   size_t ulEnd;
+};
+
+/* A search over a run of chunks, by one thread */
+struct grepTask {
+   /* The pattern */
+   const char *pcPattern;
+   size_t ulPatternLength;
+   unsigned int uFlags;
+
+   /* The chunks: psChunks[0..ulNumChunks) */
+   const struct grepChunk *psChunks;
+   size_t ulNumChunks;
+
+   /* Occurrences found, in a growing array */
+   struct FTMatch *psMatches;
+   size_t ulCount;
+   size_t ulSize;
+
+   /* FALSE if psMatches could not grow */
+   boolean bIsOk;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Appends an occurrence at ulOffset of oNfFile to psTask's results.
+   Returns FALSE if the results could not grow. */
+static boolean Grep_addMatch(struct grepTask *psTask, NodeF_T oNfFile,
+                             size_t ulOffset) {
+   struct FTMatch *psNew;
+   size_t ulNewSize;
+
+   if(psTask->ulCount == psTask->ulSize) {
+      ulNewSize = psTask->ulSize == 0 ? 16 : 2 * psTask->ulSize;
+      psNew = realloc(psTask->psMatches,
+                      ulNewSize * sizeof(struct FTMatch));
+      if(psNew == NULL)
+         return FALSE;
+      psTask->psMatches = psNew;
+      psTask->ulSize = ulNewSize;
+   }
+   psTask->psMatches[psTask->ulCount].pcPath =
+      Path_getPathname(NodeF_getPath(oNfFile));
+   psTask->psMatches[psTask->ulCount].ulOffset = ulOffset;
+   psTask->ulCount++;
+   return TRUE;
+}
+
+/*
+  Searches psChunk for psTask's pattern, recording each occurrence.
+  memchr (vectorized in the C library) skips to each candidate first
+  byte; a candidate is confirmed by its last byte, then by memcmp.
+  Returns FALSE if the results could not grow.
+*/
+static boolean Grep_searchChunk(struct grepTask *psTask,
+                                const struct grepChunk *psChunk) {
+   const char *pcPattern = psTask->pcPattern;
+   size_t ulPatternLength = psTask->ulPatternLength;
+   const char *pcCursor, *pcLastStart, *pcFound;
+   size_t ulLast;
+
+   if(psChunk->ulLength < ulPatternLength)
+      return TRUE;
+
+   /* Occurrences may start before ulEnd but not run past the file */
+   pcCursor = psChunk->pcContents + psChunk->ulStart;
+   ulLast = psChunk->ulLength - ulPatternLength;
+   if(psChunk->ulEnd - 1 < ulLast)
+      ulLast = psChunk->ulEnd - 1;
+   if(psChunk->ulStart > ulLast)
+      return TRUE;
+   pcLastStart = psChunk->pcContents + ulLast;
+
+   while(pcCursor <= pcLastStart) {
+      pcFound = memchr(pcCursor, pcPattern[0],
+                       (size_t) (pcLastStart - pcCursor) + 1);
+      if(pcFound == NULL)
+         break;
+      if(pcFound[ulPatternLength - 1] ==
+         pcPattern[ulPatternLength - 1] &&
+         memcmp(pcFound, pcPattern, ulPatternLength) == 0) {
+         if(!Grep_addMatch(psTask, psChunk->oNfFile,
+                           (size_t) (pcFound - psChunk->pcContents)))
+            return FALSE;
+         if(psTask->uFlags & GREP_FIRST_ONLY)
+            break;
+      }
+      pcCursor = pcFound + 1;
+   }
+   return TRUE;
+}
+
+/* Searches every chunk of the struct grepTask at pvTask. Runs on a
+   worker thread or on the caller's. */
+static void *Grep_runTask(void *pvTask) {
+   struct grepTask *psTask = pvTask;
+   size_t i;
+
+   for(i = 0; i < psTask->ulNumChunks; i++)
+      if(!Grep_searchChunk(psTask, &psTask->psChunks[i])) {
+         psTask->bIsOk = FALSE;
+         break;
+      }
+   return NULL;
+}
+
+/* Cuts the contents of the file nodes in oDFiles into chunks, storing
+   a new array of them in *ppsChunks, their number in *pulNumChunks,
+   and their total bytes in *pulBytes. Returns FALSE if memory could
+   not be allocated. */
+static boolean Grep_makeChunks(DynArray_T oDFiles,
+                               struct grepChunk **ppsChunks,
+                               size_t *pulNumChunks, size_t *pulBytes) {
+   struct grepChunk *psChunks;
+   NodeF_T oNfFile;
+   size_t ulNum = 0, ulLength, ulStart, i;
+
+   *pulBytes = 0;
+   for(i = 0; i < DynArray_getLength(oDFiles); i++) {
+      oNfFile = DynArray_get(oDFiles, i);
+      ulLength = NodeF_getLength(oNfFile);
+      ulNum += ulLength == 0 ? 0 : (ulLength - 1) / CHUNK_SIZE + 1;
+      *pulBytes += ulLength;
+   }
+
+   psChunks = malloc((ulNum == 0 ? 1 : ulNum) * sizeof(struct grepChunk));
+   if(psChunks == NULL)
+      return FALSE;
+
+   ulNum = 0;
+   for(i = 0; i < DynArray_getLength(oDFiles); i++) {
+      oNfFile = DynArray_get(oDFiles, i);
+      ulLength = NodeF_getLength(oNfFile);
+      for(ulStart = 0; ulStart < ulLength; ulStart += CHUNK_SIZE) {
+         psChunks[ulNum].oNfFile = oNfFile;
+         psChunks[ulNum].pcContents = NULL;
+         psChunks[ulNum].ulLength = ulLength;
+         psChunks[ulNum].ulStart = ulStart;
+         psChunks[ulNum].ulEnd = ulLength - ulStart < CHUNK_SIZE ?
+                                 ulLength : ulStart + CHUNK_SIZE;
+         ulNum++;
+      }
+   }
+
+   *ppsChunks = psChunks;
+   *pulNumChunks = ulNum;
+   return TRUE;
+}
+
+/* Returns the number of worker threads to search ulBytes with. */
+static size_t Grep_numThreads(size_t ulBytes) {
+   long lProcessors;
+
+   if(ulBytes < PARALLEL_THRESHOLD || CS_isInitialized())
+      return 1;
+   lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+   if(lProcessors < 1)
+      return 1;
+   if(lProcessors > MAX_THREADS)
+      lProcessors = MAX_THREADS;
+   if(ulMaxThreads != 0 && (size_t) lProcessors > ulMaxThreads)
+      return ulMaxThreads;
+   return (size_t) lProcessors;
+}
+
+/* ================================================================== */
+int Grep_search(DynArray_T oDFiles, const void *pvPattern,
+                size_t ulPatternLength, unsigned int uFlags,
+                struct FTMatch **ppsMatches, size_t *pulCount) {
+   struct grepTask asTasks[MAX_THREADS];
+   pthread_t asThreads[MAX_THREADS];
+   boolean abStarted[MAX_THREADS];
+   struct grepChunk *psChunks;
+   struct FTMatch *psAll;
+   size_t ulNumChunks, ulBytes, ulThreads, ulNext, ulTotal, t, i;
+   size_t ulShare, ulTaken;
+   const char *pcLastPath;
+   boolean bIsOk = TRUE;
+
+   assert(oDFiles != NULL);
+   assert(pvPattern != NULL);
+   assert(ulPatternLength > 0);
+   assert(ppsMatches != NULL);
+   assert(pulCount != NULL);
+
+   *ppsMatches = NULL;
+   *pulCount = 0;
+   if(!Grep_makeChunks(oDFiles, &psChunks, &ulNumChunks, &ulBytes))
+      return MEMORY_ERROR;
+   ulThreads = Grep_numThreads(ulBytes);
+
+   /* Give each task a contiguous run of chunks of about equal bytes,
+      so that concatenating the results keeps them in order */
+   ulShare = ulBytes / ulThreads + 1;
+   ulNext = 0;
+   for(t = 0; t < ulThreads; t++) {
+      asTasks[t].pcPattern = pvPattern;
+      asTasks[t].ulPatternLength = ulPatternLength;
+      asTasks[t].uFlags = uFlags;
+      asTasks[t].psChunks = psChunks + ulNext;
+      asTasks[t].psMatches = NULL;
+      asTasks[t].ulCount = 0;
+      asTasks[t].ulSize = 0;
+      asTasks[t].bIsOk = TRUE;
+      ulTaken = 0;
+      for(i = ulNext; i < ulNumChunks &&
+                      (t == ulThreads - 1 || ulTaken < ulShare); i++)
+         ulTaken += psChunks[i].ulEnd - psChunks[i].ulStart;
+      asTasks[t].ulNumChunks = i - ulNext;
+      ulNext = i;
+   }
+
+   /* Contents held in the content store are fetched one at a time by
+      the single task, since fetching may evict earlier ones */
+   if(ulThreads == 1) {
+      for(i = 0; i < ulNumChunks; i++)
+         psChunks[i].pcContents = NULL;
+      for(i = 0; i < ulNumChunks && asTasks[0].bIsOk; i++) {
+         psChunks[i].pcContents = NodeF_getContents(psChunks[i].oNfFile);
+         if(psChunks[i].pcContents != NULL &&
+            !Grep_searchChunk(&asTasks[0], &psChunks[i]))
+            asTasks[0].bIsOk = FALSE;
+      }
+   }
+   else {
+      for(i = 0; i < ulNumChunks; i++)
+         psChunks[i].pcContents = NodeF_getContents(psChunks[i].oNfFile);
+      /* Skip chunks of NULL contents by giving them no bytes */
+      for(i = 0; i < ulNumChunks; i++)
+         if(psChunks[i].pcContents == NULL)
+            psChunks[i].ulLength = 0;
+      for(t = 0; t < ulThreads; t++)
+         abStarted[t] = (boolean) (t != 0 &&
+            pthread_create(&asThreads[t], NULL, Grep_runTask,
+                           &asTasks[t]) == 0);
+      /* The calling thread takes the first task, and any that could
+         not be started */
+      for(t = 0; t < ulThreads; t++)
+         if(!abStarted[t])
+            (void) Grep_runTask(&asTasks[t]);
+      for(t = 0; t < ulThreads; t++)
+         if(abStarted[t])
+            pthread_join(asThreads[t], NULL);
+   }
+   free(psChunks);
+
+   /* Concatenate the results; with GREP_FIRST_ONLY, a file cut into
+      several chunks may have a match in each, and only its first is
+      kept */
+   ulTotal = 0;
+   for(t = 0; t < ulThreads; t++) {
+      ulTotal += asTasks[t].ulCount;
+      if(!asTasks[t].bIsOk)
+         bIsOk = FALSE;
+   }
+   psAll = bIsOk ? malloc((ulTotal == 0 ? 1 : ulTotal) *
+                          sizeof(struct FTMatch)) : NULL;
+   ulTotal = 0;
+   pcLastPath = NULL;
+   for(t = 0; t < ulThreads; t++) {
+      for(i = 0; psAll != NULL && i < asTasks[t].ulCount; i++) {
+         if((uFlags & GREP_FIRST_ONLY) &&
+            asTasks[t].psMatches[i].pcPath == pcLastPath)
+            continue;
+         pcLastPath = asTasks[t].psMatches[i].pcPath;
+         psAll[ulTotal++] = asTasks[t].psMatches[i];
+      }
+      free(asTasks[t].psMatches);
+   }
+   if(psAll == NULL)
+      return MEMORY_ERROR;
+
+   *ppsMatches = psAll;
+   *pulCount = ulTotal;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void Grep_setMaxThreads(size_t ulMax) {
+   ulMaxThreads = ulMax;
+}
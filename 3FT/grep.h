@@ -0,0 +1,58 @@
+/*--------------------------------------------------------------------*/
+/* grep.h                                                             */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef GREP_INCLUDED
+#define GREP_INCLUDED
+
+/*
+  Byte-pattern search over the contents of many file nodes at once.
+  Contents are cut into chunks that overlap by the pattern's length
+  less one, so no match is lost at a cut, and the chunks are divided
+  among worker threads.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "dynarray.h"
+#include "nodef.h"
+
+/* One occurrence of a pattern */
+struct FTMatch {
+   /* Absolute pathname of the file, owned by the FT */
+   const char *pcPath;
+
+   /* Offset of the occurrence within the file's contents */
+   size_t ulOffset;
+};
+
+/* Flags for Grep_search and FT_grep */
+enum {
+   /* Report only the first occurrence in each file */
+   GREP_FIRST_ONLY = 1
+};
+
+/*
+  Searches the contents of the file nodes in oDFiles for the
+  ulPatternLength bytes at pvPattern, which must be at least 1, as
+  modified by uFlags. Stores in *ppsMatches a new array, which the
+  caller must free, of the occurrences found (ordered by position of
+  the file in oDFiles, then by offset) and their number in
+  *pulCount. Files with NULL contents never match. Uses worker threads
+  unless the contents are small or held in the content store, which
+  is not safe to read concurrently. Returns SUCCESS, or MEMORY_ERROR
+  (storing NULL and 0) if memory could not be allocated.
+*/
+int Grep_search(DynArray_T oDFiles, const void *pvPattern,
+                size_t ulPatternLength, unsigned int uFlags,
+                struct FTMatch **ppsMatches, size_t *pulCount);
+
+/*
+  Limits the searches that follow to ulMax threads, counting the
+  caller's, or lifts the limit if ulMax is 0. Searches never use more
+  threads than there are processors, nor more than 16.
+*/
+void Grep_setMaxThreads(size_t ulMax);
+
+#endif
@@ -0,0 +1,191 @@
+/*--------------------------------------------------------------------*/
+/* grepbench.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  grepbench times FT_grep on 1, 2, 3 and so on up to t threads.
+
+  Usage: grepbench [-n files] [-s size] [-t threads]
+
+  It inserts n files grepbench/dI/fK of s bytes of random lowercase
+  letters, with the pattern planted about every 64 KB, and searches
+  the whole tree for it, keeping the fastest of three runs at each
+  thread count. It reports the gigabytes searched per second, and
+  checks every run's occurrences against a naive scan of each file at
+  every offset, whose speed it reports too.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "a4def.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Directories the files are spread over */
+enum { NUM_DIRS = 16 };
+
+/* Mean bytes between planted occurrences of the pattern */
+enum { PLANT_GAP = 64 * 1024 };
+
+/* Runs at each thread count, of which the fastest is kept */
+enum { NUM_RUNS = 3 };
+
+/* The pattern searched for */
+static const char acPattern[] = "grepbench";
+
+/*--------------------------------------------------------------------*/
+
+/* Fills the ulSize bytes at pcContents with random lowercase letters,
+   planting the pattern about every PLANT_GAP bytes. */
+static void GrepBench_fill(char *pcContents, size_t ulSize,
+                           unsigned long *pulState) {
+   size_t i;
+
+   for(i = 0; i < ulSize; i++)
+      pcContents[i] = (char) ('a' + Bench_random(pulState) % 26);
+   for(i = 0; i + sizeof(acPattern) - 1 <= ulSize; i += PLANT_GAP) {
+      size_t ulAt = i + Bench_random(pulState) % PLANT_GAP;
+
+      if(ulAt + sizeof(acPattern) - 1 <= ulSize)
+         memcpy(pcContents + ulAt, acPattern, sizeof(acPattern) - 1);
+   }
+}
+
+/* Stores in *ppsMatches a new array of the occurrences of the
+   pattern at every offset of the ulFiles files of ulSize bytes each
+   at ppcContents, named by ppcPaths, and their number in *pulCount.
+   Returns FALSE if memory runs out, TRUE otherwise. */
+static boolean GrepBench_naive(char **ppcPaths, char **ppcContents,
+                               size_t ulFiles, size_t ulSize,
+                               struct FTMatch **ppsMatches,
+                               size_t *pulCount) {
+   size_t ulLength = sizeof(acPattern) - 1;
+   size_t ulCount = 0, ulRoom = 0, i, ulOffset;
+   struct FTMatch *psMatches = NULL, *psNew;
+
+   for(i = 0; i < ulFiles; i++)
+      for(ulOffset = 0; ulOffset + ulLength <= ulSize; ulOffset++) {
+         if(memcmp(ppcContents[i] + ulOffset, acPattern,
+                   ulLength) != 0)
+            continue;
+         if(ulCount == ulRoom) {
+            ulRoom = ulRoom == 0 ? 1024 : 2 * ulRoom;
+            psNew = realloc(psMatches, ulRoom * sizeof(struct FTMatch));
+            if(psNew == NULL) {
+               free(psMatches);
+               return FALSE;
+            }
+            psMatches = psNew;
+         }
+         psMatches[ulCount].pcPath = ppcPaths[i];
+         psMatches[ulCount].ulOffset = ulOffset;
+         ulCount++;
+      }
+   *ppsMatches = psMatches;
+   *pulCount = ulCount;
+   return TRUE;
+}
+
+/* Returns TRUE if the ulCount occurrences at psFound are those at
+   psExpected, in the same order, FALSE otherwise. */
+static boolean GrepBench_same(const struct FTMatch *psFound,
+                              const struct FTMatch *psExpected,
+                              size_t ulCount) {
+   size_t i;
+
+   for(i = 0; i < ulCount; i++)
+      if(psFound[i].ulOffset != psExpected[i].ulOffset ||
+         strcmp(psFound[i].pcPath, psExpected[i].pcPath) != 0)
+         return FALSE;
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 1024, ulSize = 256 * 1024, ulMaxThreads = 8;
+   char **ppcPaths, **ppcContents;
+   struct FTMatch *psExpected, *psMatches;
+   size_t ulExpected, ulCount, ulThreads, i;
+   unsigned long ulState = 1;
+   double dStart, dSeconds, dBest, dGigabytes;
+   int iRun;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 's', "size", &ulSize, FALSE },
+      { 't', "threads", &ulMaxThreads, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   /* Files are numbered in the order FT_grep reports them */
+   ppcPaths = malloc(ulFiles * sizeof(char *));
+   ppcContents = malloc(ulFiles * sizeof(char *));
+   if(ppcPaths == NULL || ppcContents == NULL || FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      ppcPaths[i] = malloc(BENCH_MAX_PATH);
+      ppcContents[i] = malloc(ulSize);
+      if(ppcPaths[i] == NULL || ppcContents[i] == NULL)
+         return EXIT_FAILURE;
+      sprintf(ppcPaths[i], "grepbench/d%02lu/f%07lu",
+              (unsigned long) (i * NUM_DIRS / ulFiles),
+              (unsigned long) i);
+      GrepBench_fill(ppcContents[i], ulSize, &ulState);
+      if(FT_insertFile(ppcPaths[i], ppcContents[i], ulSize) != SUCCESS) {
+         fprintf(stderr, "%s: inserting %s failed\n", argv[0],
+                 ppcPaths[i]);
+         return EXIT_FAILURE;
+      }
+   }
+   dGigabytes = (double) ulFiles * (double) ulSize / 1e9;
+
+   dStart = Bench_now();
+   if(!GrepBench_naive(ppcPaths, ppcContents, ulFiles, ulSize,
+                       &psExpected, &ulExpected))
+      return EXIT_FAILURE;
+   dSeconds = Bench_now() - dStart;
+   printf("%lu files of %lu bytes, %lu occurrences\n",
+          (unsigned long) ulFiles, (unsigned long) ulSize,
+          (unsigned long) ulExpected);
+   printf("naive scan: %.2f GB/s\n", dGigabytes / dSeconds);
+
+   for(ulThreads = 1; ulThreads <= ulMaxThreads; ulThreads++) {
+      Grep_setMaxThreads(ulThreads);
+      dBest = 0.0;
+      for(iRun = 0; iRun < NUM_RUNS; iRun++) {
+         dStart = Bench_now();
+         if(FT_grep("grepbench", acPattern, sizeof(acPattern) - 1, 0,
+                    &psMatches, &ulCount) != SUCCESS)
+            return EXIT_FAILURE;
+         dSeconds = Bench_now() - dStart;
+         if(ulCount != ulExpected ||
+            !GrepBench_same(psMatches, psExpected, ulCount)) {
+            fprintf(stderr, "%s: FT_grep on %lu threads disagrees with "
+                    "the naive scan\n", argv[0],
+                    (unsigned long) ulThreads);
+            return EXIT_FAILURE;
+         }
+         free(psMatches);
+         if(iRun == 0 || dSeconds < dBest)
+            dBest = dSeconds;
+      }
+      printf("%2lu threads: %.2f GB/s\n", (unsigned long) ulThreads,
+             dGigabytes / dBest);
+   }
+
+   if(FT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      free(ppcPaths[i]);
+      free(ppcContents[i]);
+   }
+   free(ppcPaths);
+   free(ppcContents);
+   free(psExpected);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/*--------------------------------------------------------------------*/
+/* handlebench.c                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  handlebench compares reaching files by their paths with reaching
+  them by handles from FT_openFile.
+
+  Usage: handlebench [-n files] [-w fanout] [-l accesses]
+
+  It builds an FT of n files handlebench/aI/bJ/fK, w to a directory,
+  opens every file, and then makes l accesses at random of each kind,
+  stat, read and replace, first by path and then by handle, reporting
+  the nanoseconds per access. Last it removes every file, by path and
+  then, in a second tree, by handle.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "a4def.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Contents of every file; the FT only keeps a pointer to it */
+static char acContents[2] = "xy";
+
+/* The kinds of access timed */
+enum Access { ACCESS_STAT, ACCESS_READ, ACCESS_REPLACE, ACCESS_REMOVE };
+
+/* Their names, indexed by kind */
+static const char *apcAccessNames[] = {
+   "stat", "read", "replace", "remove"
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Inserts the ulFiles files of ppcPaths into a new FT and opens each,
+   storing its handle in psHandles. Returns FALSE if a call fails,
+   TRUE otherwise. */
+static boolean HandleBench_build(char **ppcPaths, size_t ulFiles,
+                                 struct FTHandle *psHandles) {
+   size_t i;
+
+   if(FT_init() != SUCCESS)
+      return FALSE;
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], acContents, 1) != SUCCESS)
+         return FALSE;
+   for(i = 0; i < ulFiles; i++)
+      if(FT_openFile(ppcPaths[i], &psHandles[i]) != SUCCESS)
+         return FALSE;
+   return TRUE;
+}
+
+/* Makes the ulCount accesses of kind eAccess to the files numbered in
+   pulOrder, by path if bByHandle is FALSE and by handle otherwise.
+   Returns the seconds taken, or a negative number if one failed. */
+static double HandleBench_run(enum Access eAccess, boolean bByHandle,
+                              char **ppcPaths,
+                              struct FTHandle *psHandles,
+                              const size_t *pulOrder, size_t ulCount) {
+   double dStart;
+   size_t i, ulSize;
+   void *pvOld;
+   boolean bIsFile;
+   int iStatus = SUCCESS;
+
+   dStart = Bench_now();
+   for(i = 0; i < ulCount && iStatus == SUCCESS; i++) {
+      const char *pcPath = ppcPaths[pulOrder[i]];
+      const struct FTHandle *psHandle = &psHandles[pulOrder[i]];
+
+      switch(eAccess) {
+         case ACCESS_STAT:
+            iStatus = bByHandle ? FT_statHandle(psHandle, &ulSize) :
+                      FT_stat(pcPath, &bIsFile, &ulSize);
+            break;
+         case ACCESS_READ:
+            if(bByHandle)
+               iStatus = FT_getHandleContents(psHandle, &pvOld);
+            else if(FT_getFileContents(pcPath) == NULL)
+               iStatus = NO_SUCH_PATH;
+            break;
+         case ACCESS_REPLACE:
+            if(bByHandle)
+               iStatus = FT_replaceHandleContents(psHandle,
+                                                  acContents + i % 2,
+                                                  1, &pvOld);
+            else if(FT_replaceFileContents(pcPath, acContents + i % 2,
+                                           1) == NULL)
+               iStatus = NO_SUCH_PATH;
+            break;
+         case ACCESS_REMOVE:
+            iStatus = bByHandle ? FT_rmHandle(psHandle) :
+                      FT_rmFile(pcPath);
+            break;
+      }
+   }
+   if(iStatus != SUCCESS)
+      return -1.0;
+   return Bench_now() - dStart;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 1000000, ulFanout = 32, ulAccesses = 1000000;
+   char **ppcPaths;
+   struct FTHandle *psHandles;
+   size_t *pulOrder;
+   size_t i, j, ulSwap;
+   unsigned long ulState = 1;
+   double dPath, dHandle;
+   int iAccess;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'w', "fanout", &ulFanout, FALSE },
+      { 'l', "accesses", &ulAccesses, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   /* Generate the paths, random accesses to them, and a random order
+      in which to remove them all */
+   ppcPaths = malloc(ulFiles * sizeof(char *));
+   psHandles = malloc(ulFiles * sizeof(struct FTHandle));
+   pulOrder = malloc((ulAccesses > ulFiles ? ulAccesses : ulFiles) *
+                     sizeof(size_t));
+   if(ppcPaths == NULL || psHandles == NULL || pulOrder == NULL)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      ppcPaths[i] = malloc(BENCH_MAX_PATH);
+      if(ppcPaths[i] == NULL)
+         return EXIT_FAILURE;
+      sprintf(ppcPaths[i], "handlebench/a%lu/b%lu/f%lu",
+              (unsigned long) (i / ulFanout / ulFanout),
+              (unsigned long) (i / ulFanout % ulFanout),
+              (unsigned long) (i % ulFanout));
+   }
+
+   if(!HandleBench_build(ppcPaths, ulFiles, psHandles)) {
+      fprintf(stderr, "%s: building the FT failed\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   printf("%lu files, %lu files per directory\n",
+          (unsigned long) ulFiles, (unsigned long) ulFanout);
+   printf("%-10s%12s%12s%10s\n", "access", "path ns", "handle ns",
+          "speedup");
+   for(iAccess = ACCESS_STAT; iAccess <= ACCESS_REMOVE; iAccess++) {
+      size_t ulCount = ulAccesses;
+
+      if(iAccess == ACCESS_REMOVE) {
+         /* Every file once, by path, then again in a new tree */
+         ulCount = ulFiles;
+         for(i = 0; i < ulFiles; i++)
+            pulOrder[i] = i;
+         for(i = ulFiles - 1; i > 0; i--) {
+            j = Bench_random(&ulState) % (i + 1);
+            ulSwap = pulOrder[i];
+            pulOrder[i] = pulOrder[j];
+            pulOrder[j] = ulSwap;
+         }
+      }
+      else
+         for(i = 0; i < ulCount; i++)
+            pulOrder[i] = Bench_random(&ulState) % ulFiles;
+
+      dPath = HandleBench_run((enum Access) iAccess, FALSE, ppcPaths,
+                              psHandles, pulOrder, ulCount);
+      if(iAccess == ACCESS_REMOVE &&
+         (FT_destroy() != SUCCESS ||
+          !HandleBench_build(ppcPaths, ulFiles, psHandles)))
+         return EXIT_FAILURE;
+      dHandle = HandleBench_run((enum Access) iAccess, TRUE, ppcPaths,
+                                psHandles, pulOrder, ulCount);
+      if(dPath < 0.0 || dHandle < 0.0) {
+         fprintf(stderr, "%s: a %s failed\n", argv[0],
+                 apcAccessNames[iAccess]);
+         return EXIT_FAILURE;
+      }
+      printf("%-10s%12.1f%12.1f%10.2f\n", apcAccessNames[iAccess],
+             dPath / (double) ulCount * 1e9,
+             dHandle / (double) ulCount * 1e9, dPath / dHandle);
+   }
+   if(FT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+
+   for(i = 0; i < ulFiles; i++)
+      free(ppcPaths[i]);
+   free(ppcPaths);
+   free(psHandles);
+   free(pulOrder);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*--------------------------------------------------------------------*/
+/* handletable.c                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "handletable.h"
+
+/* Number of slots a new table has room for */
+enum { INITIAL_SLOTS = 64 };
+
+/* A slot of the table */
+struct handleSlot {
+   /* The open node and its parent, or NULL if the slot is closed */
+   NodeF_T oNfNode;
+   NodeD_T oNdParent;
+
+   /* Generation stamped into the handles given out for oNfNode */
+   unsigned long ulGeneration;
+
+   /* Next closed slot, or 0, while the slot is closed */
+   size_t ulNextFree;
+};
+
+/* The table */
+struct handleTable {
+   /* The slots, of which ulLength are in use; slot 0 is never used, so
+      that a node's slot number can be 0 when it has none */
+   struct handleSlot *psSlots;
+   size_t ulLength;
+   size_t ulCapacity;
+
+   /* First closed slot, or 0 if there is none */
+   size_t ulFree;
+};
+
+/* Last generation stamped, by any table */
+static unsigned long ulLastGeneration;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns a slot of oHTable for a new node, taking a closed one if
+   possible, or 0 if the table could not grow. */
+static size_t HandleTable_takeSlot(HandleTable_T oHTable) {
+   struct handleSlot *psNew;
+   size_t ulSlot;
+
+   ulSlot = oHTable->ulFree;
+   if(ulSlot != 0) {
+      oHTable->ulFree = oHTable->psSlots[ulSlot].ulNextFree;
+      return ulSlot;
+   }
+
+   if(oHTable->ulLength == oHTable->ulCapacity) {
+      psNew = realloc(oHTable->psSlots, 2 * oHTable->ulCapacity *
+                      sizeof(struct handleSlot));
+      if(psNew == NULL)
+         return 0;
+      oHTable->psSlots = psNew;
+      oHTable->ulCapacity *= 2;
+   }
+   return oHTable->ulLength++;
+}
+
+/* ================================================================== */
+HandleTable_T HandleTable_new(void) {
+   HandleTable_T oHTable;
+
+   oHTable = malloc(sizeof(struct handleTable));
+   if(oHTable == NULL)
+      return NULL;
+   oHTable->psSlots = malloc(INITIAL_SLOTS * sizeof(struct handleSlot));
+   if(oHTable->psSlots == NULL) {
+      free(oHTable);
+      return NULL;
+   }
+   oHTable->psSlots[0].oNfNode = NULL;
+   oHTable->psSlots[0].oNdParent = NULL;
+   oHTable->psSlots[0].ulGeneration = 0;
+   oHTable->psSlots[0].ulNextFree = 0;
+   oHTable->ulLength = 1;
+   oHTable->ulCapacity = INITIAL_SLOTS;
+   oHTable->ulFree = 0;
+   return oHTable;
+}
+
+/* ================================================================== */
+void HandleTable_free(HandleTable_T oHTable) {
+   assert(oHTable != NULL);
+
+   free(oHTable->psSlots);
+   free(oHTable);
+}
+
+/* ================================================================== */
+int HandleTable_open(HandleTable_T oHTable, NodeF_T oNfNode,
+                     NodeD_T oNdParent, struct FTHandle *psHandle) {
+   struct handleSlot *psSlot;
+   size_t ulSlot;
+
+   assert(oHTable != NULL);
+   assert(oNfNode != NULL);
+   assert(oNdParent != NULL);
+   assert(psHandle != NULL);
+
+   ulSlot = NodeF_getHandle(oNfNode);
+   if(ulSlot == 0) {
+      ulSlot = HandleTable_takeSlot(oHTable);
+      if(ulSlot == 0)
+         return MEMORY_ERROR;
+      psSlot = &oHTable->psSlots[ulSlot];
+      psSlot->oNfNode = oNfNode;
+      psSlot->oNdParent = oNdParent;
+      psSlot->ulGeneration = ++ulLastGeneration;
+      psSlot->ulNextFree = 0;
+      NodeF_setHandle(oNfNode, ulSlot);
+   }
+
+   assert(oHTable->psSlots[ulSlot].oNfNode == oNfNode);
+   psHandle->ulSlot = ulSlot;
+   psHandle->ulGeneration = oHTable->psSlots[ulSlot].ulGeneration;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+NodeF_T HandleTable_lookup(HandleTable_T oHTable,
+                           const struct FTHandle *psHandle,
+                           NodeD_T *poNdParent) {
+   struct handleSlot *psSlot;
+
+   assert(oHTable != NULL);
+   assert(psHandle != NULL);
+
+   if(psHandle->ulSlot == 0 || psHandle->ulSlot >= oHTable->ulLength)
+      return NULL;
+   psSlot = &oHTable->psSlots[psHandle->ulSlot];
+   if(psSlot->oNfNode == NULL ||
+      psSlot->ulGeneration != psHandle->ulGeneration)
+      return NULL;
+   if(poNdParent != NULL)
+      *poNdParent = psSlot->oNdParent;
+   return psSlot->oNfNode;
+}
+
+/* ================================================================== */
+void HandleTable_close(HandleTable_T oHTable, NodeF_T oNfNode) {
+   struct handleSlot *psSlot;
+   size_t ulSlot;
+
+   assert(oHTable != NULL);
+   assert(oNfNode != NULL);
+
+   ulSlot = NodeF_getHandle(oNfNode);
+   if(ulSlot == 0)
+      return;
+   psSlot = &oHTable->psSlots[ulSlot];
+   assert(psSlot->oNfNode == oNfNode);
+   psSlot->oNfNode = NULL;
+   psSlot->oNdParent = NULL;
+   psSlot->ulNextFree = oHTable->ulFree;
+   oHTable->ulFree = ulSlot;
+   NodeF_setHandle(oNfNode, 0);
+}
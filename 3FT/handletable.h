@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------*/
+/* handletable.h                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef HANDLETABLE_INCLUDED
+#define HANDLETABLE_INCLUDED
+
+/*
+  A handle table names open file nodes by small handles, so that they
+  can be reached without walking their paths. Each open node has one
+  slot, which records the node, its parent and a generation number
+  stamped into the handles given out for it. Closing a slot clears it,
+  and reusing it stamps a new generation, drawn from a counter shared
+  by every table. A handle to a node that has since been closed
+  therefore fails to look up, even once its slot holds another node or
+  its table has been replaced, instead of leading to freed memory.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "nodef.h"
+#include "noded.h"
+
+/* A handle to an open file */
+struct FTHandle {
+   /* Slot in the handle table */
+   size_t ulSlot;
+
+   /* Generation of the slot when the handle was given out */
+   unsigned long ulGeneration;
+};
+
+/* A HandleTable_T is a table of open file nodes */
+typedef struct handleTable *HandleTable_T;
+
+/* Returns a new, empty handle table, or NULL if insufficient memory is
+   available. */
+HandleTable_T HandleTable_new(void);
+
+/* Destroys oHTable. The nodes it refers to are neither freed nor
+   touched, so they may already have been freed. */
+void HandleTable_free(HandleTable_T oHTable);
+
+/*
+  Stores in *psHandle a handle to oNfNode, whose parent directory is
+  oNdParent, opening a slot for it unless it already has one. Returns
+  SUCCESS, or MEMORY_ERROR if a slot was needed and could not be
+  allocated.
+*/
+int HandleTable_open(HandleTable_T oHTable, NodeF_T oNfNode,
+                     NodeD_T oNdParent, struct FTHandle *psHandle);
+
+/*
+  Returns the node *psHandle was given out for, and stores its parent
+  in *poNdParent (if not NULL), or returns NULL if the node's slot has
+  been closed since.
+*/
+NodeF_T HandleTable_lookup(HandleTable_T oHTable,
+                           const struct FTHandle *psHandle,
+                           NodeD_T *poNdParent);
+
+/* Closes oNfNode's slot, if it has one, so that every handle to it
+   fails from then on. */
+void HandleTable_close(HandleTable_T oHTable, NodeF_T oNfNode);
+
+#endif
@@ -0,0 +1,104 @@
+/*--------------------------------------------------------------------*/
+/* heat.c                                                             */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <assert.h>
+#include <limits.h>
+#include "heat.h"
+
+/* Bits of a heat word holding its epoch, the lower half; the upper
+   half holds its count */
+#define EPOCH_BITS (sizeof(unsigned long) * CHAR_BIT / 2)
+
+/* Mask of a heat word's epoch bits */
+#define EPOCH_MASK ((1UL << EPOCH_BITS) - 1)
+
+/* Largest count a word holds */
+#define MAX_COUNT (ULONG_MAX >> EPOCH_BITS)
+
+/* Largest sampling shift accepted */
+enum { MAX_SAMPLE_SHIFT = 16 };
+
+/* Whether tracking is on */
+static boolean bIsEnabled;
+
+/* One access in 2^uSampleShift is counted */
+static unsigned int uSampleShift;
+
+/* The current epoch */
+static unsigned long ulEpoch;
+
+/* Accesses seen, to choose which are sampled; updated without
+   synchronization, since a lost update only shifts the sample */
+static volatile unsigned long ulTick;
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the count in ulWord, halved once for each epoch since it was
+   last brought up to date. */
+static unsigned long Heat_decayed(unsigned long ulWord) {
+   unsigned long ulCount = ulWord >> EPOCH_BITS;
+   unsigned long ulAge;
+
+   ulAge = (ulEpoch - ulWord) & EPOCH_MASK;
+   if(ulAge >= sizeof(unsigned long) * CHAR_BIT - EPOCH_BITS)
+      return 0;
+   return ulCount >> ulAge;
+}
+
+/* ================================================================== */
+void Heat_enable(unsigned int uShift) {
+   bIsEnabled = TRUE;
+   uSampleShift = uShift > MAX_SAMPLE_SHIFT ? MAX_SAMPLE_SHIFT : uShift;
+   ulEpoch = 0;
+   ulTick = 0;
+}
+
+/* ================================================================== */
+void Heat_disable(void) {
+   bIsEnabled = FALSE;
+}
+
+/* ================================================================== */
+boolean Heat_isEnabled(void) {
+   return bIsEnabled;
+}
+
+/* ================================================================== */
+void Heat_bump(unsigned long *pulWord) {
+   unsigned long ulOld, ulCount;
+
+   assert(pulWord != NULL);
+
+   if(!bIsEnabled)
+      return;
+   if((ulTick++ & ((1UL << uSampleShift) - 1)) != 0)
+      return;
+
+   do {
+      ulOld = *pulWord;
+      ulCount = Heat_decayed(ulOld);
+      if(ulCount < MAX_COUNT)
+         ulCount++;
+   } while(!__sync_bool_compare_and_swap(pulWord, ulOld,
+              (ulCount << EPOCH_BITS) | (ulEpoch & EPOCH_MASK)));
+}
+
+/* ================================================================== */
+unsigned long Heat_read(const unsigned long *pulWord) {
+   unsigned long ulCount;
+
+   assert(pulWord != NULL);
+
+   ulCount = Heat_decayed(*pulWord);
+   if(ulCount > (ULONG_MAX >> uSampleShift))
+      return ULONG_MAX;
+   return ulCount << uSampleShift;
+}
+
+/* ================================================================== */
+void Heat_decay(void) {
+   ulEpoch++;
+}
@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------*/
+/* heat.h                                                             */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef HEAT_INCLUDED
+#define HEAT_INCLUDED
+
+/*
+  Heat tracking keeps a decaying access count in one word per node.
+  Only one access in 2^k is counted, chosen by a shared tick, so that
+  most accesses cost an increment and a test. Decay is lazy: the word
+  holds its count in its upper half and, in its lower half, the
+  number of the epoch it was last brought up to date in, and the count
+  is halved for each epoch since, whenever it is next read or bumped.
+  Heat_decay starts a new epoch in O(1), however many nodes there are.
+  A count is gone after as many epochs as it has bits, and with a
+  64-bit word the epoch number only repeats after 2^32 epochs, so a
+  node left untouched stays cold for over a century of once-a-second
+  decays.
+
+  A bump updates its word with a compare-and-swap, so concurrent
+  bumps under a shared lock are not lost; the shared sampling tick is
+  updated without one, so concurrent accesses only disturb which ones
+  are sampled.
+*/
+
+#include "a4def.h"
+
+/*
+  Turns heat tracking on, counting one access in 2^uSampleShift, and
+  starts at epoch 0. Words bumped before belong to the old epochs and
+  should be zero.
+*/
+void Heat_enable(unsigned int uSampleShift);
+
+/* Turns heat tracking off. */
+void Heat_disable(void);
+
+/* Returns TRUE if heat tracking is on, FALSE if not. */
+boolean Heat_isEnabled(void);
+
+/* Records an access to the node owning the heat word at pulWord, if
+   the access is sampled. Does nothing if tracking is off. */
+void Heat_bump(unsigned long *pulWord);
+
+/*
+  Returns the heat in the word at pulWord as of the current epoch, in
+  estimated accesses (sampled counts scaled back up by 2^k).
+*/
+unsigned long Heat_read(const unsigned long *pulWord);
+
+/* Starts a new epoch, halving every node's heat. */
+void Heat_decay(void);
+
+#endif
@@ -0,0 +1,296 @@
+/*--------------------------------------------------------------------*/
+/* heat_client.c                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  heat_client checks FT_enableHeat, FT_decayHeat and FT_hotSubtrees
+  against a table of access counts.
+
+  Usage: heat_client [-r rounds] [-s seed]
+
+  Each round builds a fixed tree of 13 directories and 21 files,
+  turns on heat tracking, counting every access or one in four, and
+  then reads directories and files at random, in bursts of as many
+  accesses as make one count, decays the heat now and then and, when
+  counting every access, removes and inserts files. The table keeps
+  each node's count, halved at each decay. FT_hotSubtrees at every
+  depth must rank the directories by the table's sums over their
+  subtrees, hottest first and then by pathname. At the end of a round
+  2^16 decays, and more, must leave every directory cold, and a
+  directory accessed after them must be the only warm one.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* The tree: r, three directories below it with a file each, and three
+   directories below each of those with two files each */
+enum { NUM_NODES = 1 + 3 * (2 + 3 * 3) };
+
+/* Deepest directory, counting the root */
+enum { MAX_DEPTH = 3 };
+
+/* Longest path, including its terminator */
+enum { MAX_PATH = 8 };
+
+/* Calls made in each round */
+enum { NUM_CALLS = 1000 };
+
+/* Decays at the end of each round, past 2^16 epochs, where a 16-bit
+   epoch number would wrap around */
+enum { NUM_DECAYS = 70000, WRAP_DECAYS = 65536 };
+
+/* One file or directory of the tree and its count */
+struct node {
+   char acPath[MAX_PATH];
+   size_t ulParent;
+   size_t ulDepth;
+   boolean bIsFile;
+   boolean bPresent;
+   unsigned long ulCount;
+};
+
+/* The tree, in preorder, so that the root comes first */
+static struct node asNodes[NUM_NODES];
+static size_t ulNumNodes;
+
+/* Accesses counted as one, as a shift */
+static unsigned int uShift;
+
+/*--------------------------------------------------------------------*/
+
+/* Adds to asNodes the node pcName below node ulParent, at depth
+   ulDepth, and the nodes below it if it is a directory. */
+static void HeatClient_add(const char *pcName, size_t ulParent,
+                           size_t ulDepth, boolean bIsFile) {
+   size_t ulOwn = ulNumNodes++;
+   char acPath[MAX_PATH], acName[2];
+   int iChild;
+
+   acPath[0] = '\0';
+   if(ulDepth > 1) {
+      strcpy(acPath, asNodes[ulParent].acPath);
+      strcat(acPath, "/");
+   }
+   strcat(acPath, pcName);
+   strcpy(asNodes[ulOwn].acPath, acPath);
+   asNodes[ulOwn].ulParent = ulParent;
+   asNodes[ulOwn].ulDepth = ulDepth;
+   asNodes[ulOwn].bIsFile = bIsFile;
+   if(bIsFile)
+      return;
+
+   if(ulDepth > 1)
+      HeatClient_add("x", ulOwn, ulDepth + 1, TRUE);
+   if(ulDepth == MAX_DEPTH) {
+      HeatClient_add("y", ulOwn, ulDepth + 1, TRUE);
+      return;
+   }
+   acName[1] = '\0';
+   for(iChild = 0; iChild < 3; iChild++) {
+      acName[0] = (char) ('a' + iChild);
+      HeatClient_add(acName, ulOwn, ulDepth + 1, FALSE);
+   }
+}
+
+/* Orders the struct FTHeat at pvFirst and pvSecond hottest first,
+   then by pathname. */
+static int HeatClient_compare(const void *pvFirst,
+                              const void *pvSecond) {
+   const struct FTHeat *psFirst = pvFirst;
+   const struct FTHeat *psSecond = pvSecond;
+
+   if(psFirst->ulHeat != psSecond->ulHeat)
+      return psFirst->ulHeat < psSecond->ulHeat ? 1 : -1;
+   return strcmp(psFirst->pcPath, psSecond->pcPath);
+}
+
+/* Checks FT_hotSubtrees at depth ulDepth, cut to ulK, against the
+   table. */
+static void HeatClient_check(size_t ulK, size_t ulDepth) {
+   struct FTHeat asExpected[NUM_NODES];
+   unsigned long aulSubtree[NUM_NODES];
+   struct FTHeat *psHot;
+   size_t ulExpected, ulCount, i, j;
+
+   /* Each node's count goes to it and every directory above it */
+   memset(aulSubtree, 0, sizeof(aulSubtree));
+   for(i = 0; i < ulNumNodes; i++) {
+      if(!asNodes[i].bPresent)
+         continue;
+      for(j = i; j != 0; j = asNodes[j].ulParent)
+         aulSubtree[j] += asNodes[i].ulCount;
+      aulSubtree[0] += asNodes[i].ulCount;
+   }
+   ulExpected = 0;
+   for(i = 0; i < ulNumNodes; i++)
+      if(!asNodes[i].bIsFile &&
+         (ulDepth == 0 || asNodes[i].ulDepth == ulDepth)) {
+         asExpected[ulExpected].pcPath = asNodes[i].acPath;
+         asExpected[ulExpected].ulHeat = aulSubtree[i] << uShift;
+         ulExpected++;
+      }
+   qsort(asExpected, ulExpected, sizeof(struct FTHeat),
+         HeatClient_compare);
+
+   assert(FT_hotSubtrees(ulK, ulDepth, &psHot, &ulCount) == SUCCESS);
+   assert(ulCount == (ulK < ulExpected ? ulK : ulExpected));
+   for(i = 0; i < ulCount; i++) {
+      assert(strcmp(psHot[i].pcPath, asExpected[i].pcPath) == 0);
+      assert(psHot[i].ulHeat == asExpected[i].ulHeat);
+   }
+   free(psHot);
+}
+
+/* Reads node ulNode in a burst of accesses that makes one count. */
+static void HeatClient_read(size_t ulNode) {
+   size_t i;
+
+   for(i = 0; i < (size_t) 1 << uShift; i++) {
+      if(!asNodes[ulNode].bIsFile)
+         assert(FT_containsDir(asNodes[ulNode].acPath));
+      else if(rand() % 2 == 0)
+         assert(FT_containsFile(asNodes[ulNode].acPath));
+      else
+         (void) FT_getFileContents(asNodes[ulNode].acPath);
+   }
+   asNodes[ulNode].ulCount++;
+}
+
+/* Halves every count. */
+static void HeatClient_decay(void) {
+   size_t i;
+
+   assert(FT_decayHeat() == SUCCESS);
+   for(i = 0; i < ulNumNodes; i++)
+      asNodes[i].ulCount >>= 1;
+}
+
+/* Makes one random call on node ulNode. */
+static void HeatClient_call(size_t ulNode) {
+   struct node *psNode = &asNodes[ulNode];
+
+   switch(rand() % 10) {
+      case 0:
+         HeatClient_decay();
+         break;
+      case 1:
+         HeatClient_check((size_t) rand() % (NUM_NODES + 1),
+                          (size_t) rand() % (MAX_DEPTH + 2));
+         break;
+      case 2:
+         /* Removal counts for the parent, insertion for the file */
+         if(!psNode->bIsFile || uShift != 0)
+            break;
+         if(psNode->bPresent) {
+            assert(FT_rmFile(psNode->acPath) == SUCCESS);
+            psNode->bPresent = FALSE;
+            asNodes[psNode->ulParent].ulCount++;
+         }
+         else {
+            assert(FT_insertFile(psNode->acPath, NULL, 0) == SUCCESS);
+            psNode->bPresent = TRUE;
+            psNode->ulCount = 1;
+         }
+         break;
+      default:
+         if(psNode->bPresent)
+            HeatClient_read(ulNode);
+         break;
+   }
+}
+
+/* Runs one round, counting one access in 2^uShift. */
+static void HeatClient_round(void) {
+   size_t i;
+
+   assert(FT_init() == SUCCESS);
+   for(i = 0; i < ulNumNodes; i++) {
+      if(asNodes[i].bIsFile)
+         assert(FT_insertFile(asNodes[i].acPath, NULL, 0) == SUCCESS);
+      else
+         assert(FT_insertDir(asNodes[i].acPath) == SUCCESS);
+      asNodes[i].bPresent = TRUE;
+      asNodes[i].ulCount = 0;
+   }
+
+   /* Accesses before tracking leave no heat */
+   assert(FT_decayHeat() == INITIALIZATION_ERROR);
+   assert(FT_enableHeat(uShift) == SUCCESS);
+   HeatClient_check(NUM_NODES, 0);
+
+   for(i = 0; i < NUM_CALLS; i++) {
+      /* Enabling again must not change the sampling */
+      if(i == NUM_CALLS / 2)
+         assert(FT_enableHeat(uShift + 1) == SUCCESS);
+      HeatClient_call((size_t) rand() % ulNumNodes);
+   }
+   HeatClient_check(NUM_NODES, 0);
+
+   /* Idle directories stay cold however many epochs pass */
+   for(i = 0; i < ulNumNodes; i++)
+      asNodes[i].ulCount = 0;
+   for(i = 1; i <= NUM_DECAYS; i++) {
+      assert(FT_decayHeat() == SUCCESS);
+      if(i == WRAP_DECAYS || i == NUM_DECAYS)
+         HeatClient_check(NUM_NODES, 0);
+   }
+   for(i = ulNumNodes - 1; asNodes[i].bIsFile; i--)
+      ;
+   HeatClient_read(i);
+   HeatClient_check(NUM_NODES, 0);
+   assert(FT_destroy() == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 20, ulSeed = 1, r;
+   struct FTHeat *psHot = (struct FTHeat *) &ulRounds;
+   size_t ulCount = 1;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+   HeatClient_add("r", 0, 1, FALSE);
+   assert(ulNumNodes == NUM_NODES);
+
+   assert(FT_enableHeat(0) == INITIALIZATION_ERROR);
+   assert(FT_hotSubtrees(1, 0, &psHot, &ulCount) ==
+          INITIALIZATION_ERROR);
+   assert(psHot == NULL && ulCount == 0);
+
+   /* An empty FT has nothing to rank */
+   assert(FT_init() == SUCCESS);
+   assert(FT_enableHeat(0) == SUCCESS);
+   ulCount = 1;
+   assert(FT_hotSubtrees(1, 0, &psHot, &ulCount) == SUCCESS);
+   assert(ulCount == 0);
+   free(psHot);
+   assert(FT_destroy() == SUCCESS);
+
+   for(r = 0; r < ulRounds; r++) {
+      uShift = r % 2 == 0 ? 0 : 2;
+      HeatClient_round();
+   }
+
+   printf("%lu rounds of heat matched\n", ulRounds);
+   return EXIT_SUCCESS;
+}
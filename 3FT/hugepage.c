@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------*/
+/* hugepage.c                                                         */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* mmap and its MAP_ANONYMOUS, MAP_HUGETLB and MADV_HUGEPAGE are not
+   C90, and glibc declares the latter only for the default source */
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <sys/mman.h>
+#include "hugepage.h"
+
+/* ================================================================== */
+void *HugePage_alloc(size_t ulSize, enum HugePageKind *peKind) {
+   char *pcMap, *pcBlock;
+
+   assert(ulSize > 0 && ulSize % HUGE_PAGE_SIZE == 0);
+   assert(peKind != NULL);
+
+#if defined(MAP_HUGETLB)
+   pcMap = mmap(NULL, ulSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+   if(pcMap != MAP_FAILED) {
+      *peKind = HUGEPAGE_RESERVED;
+      return pcMap;
+   }
+#endif
+
+   /* Map a huge page more than needed and trim both ends, so that the
+      block covers whole huge pages the kernel can back */
+   pcMap = mmap(NULL, ulSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(pcMap == MAP_FAILED)
+      return NULL;
+   pcBlock = pcMap + (HUGE_PAGE_SIZE -
+                      (size_t) pcMap % HUGE_PAGE_SIZE) %
+                     HUGE_PAGE_SIZE;
+   if(pcBlock > pcMap)
+      (void) munmap(pcMap, (size_t) (pcBlock - pcMap));
+   (void) munmap(pcBlock + ulSize,
+                 (size_t) (pcMap + HUGE_PAGE_SIZE - pcBlock));
+
+   *peKind = HUGEPAGE_NONE;
+#if defined(MADV_HUGEPAGE)
+   if(madvise(pcBlock, ulSize, MADV_HUGEPAGE) == 0)
+      *peKind = HUGEPAGE_TRANSPARENT;
+#endif
+   return pcBlock;
+}
+
+/* ================================================================== */
+void HugePage_free(void *pvBlock, size_t ulSize) {
+   if(pvBlock != NULL)
+      (void) munmap(pvBlock, ulSize);
+}
@@ -0,0 +1,43 @@
+/*--------------------------------------------------------------------*/
+/* hugepage.h                                                         */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef HUGEPAGE_INCLUDED
+#define HUGEPAGE_INCLUDED
+
+/*
+  The huge page module maps memory in 2 MiB pages, so that a tree
+  spread over it costs one TLB entry per 2 MiB rather than one per
+  4 KiB page. It asks first for pages reserved by the administrator
+  (MAP_HUGETLB, from /proc/sys/vm/nr_hugepages), then for an aligned
+  mapping the kernel is advised to back with transparent huge pages,
+  and failing both, on other systems, maps ordinary pages.
+*/
+
+#include <stddef.h>
+
+/* Bytes in a huge page */
+enum { HUGE_PAGE_SIZE = 2 * 1024 * 1024 };
+
+/* What backs a mapping */
+enum HugePageKind {
+   /* Ordinary pages */
+   HUGEPAGE_NONE,
+   /* Transparent huge pages, where the kernel finds them free */
+   HUGEPAGE_TRANSPARENT,
+   /* Reserved huge pages */
+   HUGEPAGE_RESERVED
+};
+
+/*
+  Returns ulSize bytes of zeroed memory aligned to HUGE_PAGE_SIZE, a
+  multiple of which ulSize must be, and stores what backs it in
+  *peKind. Returns NULL if insufficient memory is available.
+*/
+void *HugePage_alloc(size_t ulSize, enum HugePageKind *peKind);
+
+/* Frees pvBlock, ulSize bytes from HugePage_alloc. */
+void HugePage_free(void *pvBlock, size_t ulSize);
+
+#endif
@@ -0,0 +1,27 @@
+/*--------------------------------------------------------------------*/
+/* image.c                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <string.h>
+#include "image.h"
+
+/* ================================================================== */
+boolean Image_isWellFormed(const char *pcPath) {
+   size_t ulLength;
+
+   ulLength = strlen(pcPath);
+   return (boolean) (ulLength != 0 && pcPath[0] != '/' &&
+                     pcPath[ulLength - 1] != '/' &&
+                     strstr(pcPath, "//") == NULL);
+}
+
+/* ================================================================== */
+boolean Image_fits(size_t ulSize, unsigned long ulOff,
+                   unsigned long ulCount, size_t ulElemSize) {
+   /* With both at most ulSize, the product cannot overflow for the
+      element sizes images use */
+   if(ulOff > ulSize || ulCount > ulSize)
+      return FALSE;
+   return (boolean) (ulCount * ulElemSize <= ulSize - ulOff);
+}
@@ -0,0 +1,35 @@
+/*--------------------------------------------------------------------*/
+/* image.h                                                            */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef IMAGE_INCLUDED
+#define IMAGE_INCLUDED
+
+/*
+  Checks shared by the modules that look paths up in a tree laid out
+  as one block addressed by offsets: frozen FTs, archives and shared
+  images. Such a block may come from a file or another process, so
+  every offset read from it is checked before use, and lookups check
+  their paths without building a Path_T.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  Returns TRUE if pcPath is a well-formatted path: non-empty, without
+  a leading or trailing '/', and without empty components. These are
+  the paths Path_new accepts.
+*/
+boolean Image_isWellFormed(const char *pcPath);
+
+/*
+  Returns TRUE if the ulCount elements of ulElemSize bytes each at
+  offset ulOff lie within a block of ulSize bytes, FALSE otherwise.
+  ulOff and ulCount may be anything read from a damaged block.
+*/
+boolean Image_fits(size_t ulSize, unsigned long ulOff,
+                   unsigned long ulCount, size_t ulElemSize);
+
+#endif
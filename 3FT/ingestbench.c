@@ -0,0 +1,245 @@
+/*--------------------------------------------------------------------*/
+/* ingestbench.c                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  ingestbench times inserting files into a few hot directories in
+  random order.
+
+  Usage: ingestbench [-n files] [-d directories] [-c size] [-b budget]
+
+  It inserts n files ingestbench/dI/fK, spread over d directories, in
+  random order, then looks every file up in another random order, and
+  last lists the FT with FT_toString, which puts every directory's
+  children in order. It reports the nanoseconds per file of the first
+  two phases and the milliseconds of the last.
+
+  With -c, it then inserts the files again with contents of size
+  bytes, into a tree without checksums and into one with them, and
+  reports the nanoseconds per file of each and the difference.
+
+  With -b, it inserts the files again, with contents of size bytes (or
+  64 without -c), into a tree that keeps at most budget bytes of them
+  in memory and spills the rest to ingestbench.spill, and looks every
+  file up in random order. It reports the nanoseconds per file of
+  each, then the content store's hits, misses and spills, and the
+  mean and longest fault in microseconds, from FT_getContentStats.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "a4def.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Contents of every file; the FT only keeps a pointer to it */
+static char cContents = 'x';
+
+/* Length of the contents stored under -b when -c is not given */
+enum { BUDGET_SIZE = 64 };
+
+/*--------------------------------------------------------------------*/
+
+/* Puts the ulCount pointers of ppcPaths in random order, drawn from
+   the generator whose state is *pulState. */
+static void IngestBench_shuffle(char **ppcPaths, size_t ulCount,
+                                unsigned long *pulState) {
+   size_t i, j;
+   char *pcSwap;
+
+   for(i = ulCount - 1; i > 0; i--) {
+      j = Bench_random(pulState) % (i + 1);
+      pcSwap = ppcPaths[i];
+      ppcPaths[i] = ppcPaths[j];
+      ppcPaths[j] = pcSwap;
+   }
+}
+
+/* Inserts the ulFiles files of ppcPaths, each with the ulLength bytes
+   at pvContents, into a new FT, with checksums if bChecksums. Returns
+   the seconds the insertions took, or a negative number if a call
+   fails. */
+static double IngestBench_insert(char **ppcPaths, size_t ulFiles,
+                                 void *pvContents, size_t ulLength,
+                                 boolean bChecksums) {
+   double dStart, dSeconds;
+   size_t i;
+
+   if(FT_init() != SUCCESS)
+      return -1.0;
+   if(bChecksums && FT_enableChecksums() != SUCCESS)
+      return -1.0;
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], pvContents, ulLength) != SUCCESS)
+         return -1.0;
+   dSeconds = Bench_now() - dStart;
+   if(FT_destroy() != SUCCESS)
+      return -1.0;
+   return dSeconds;
+}
+
+/* Inserts the ulFiles files of ppcPaths, each with the ulLength bytes
+   at pcContents, into a new FT with a content budget of ulBudget
+   bytes, then looks them up in another random order drawn from
+   *pulState. Stores the seconds each phase took in *pdInsert and
+   *pdLookup and the content store's counters in *psStats. Returns
+   FALSE if a call fails, TRUE otherwise. */
+static boolean IngestBench_spill(char **ppcPaths, size_t ulFiles,
+                                 char *pcContents, size_t ulLength,
+                                 size_t ulBudget,
+                                 unsigned long *pulState,
+                                 double *pdInsert, double *pdLookup,
+                                 struct CSStats *psStats) {
+   double dStart;
+   char *pcFound;
+   size_t i;
+
+   if(FT_init() != SUCCESS ||
+      FT_setContentBudget(ulBudget, "ingestbench.spill") != SUCCESS)
+      return FALSE;
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], pcContents, ulLength) != SUCCESS)
+         return FALSE;
+   *pdInsert = Bench_now() - dStart;
+
+   IngestBench_shuffle(ppcPaths, ulFiles, pulState);
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++) {
+      pcFound = FT_getFileContents(ppcPaths[i]);
+      if(pcFound == NULL || pcFound[0] != pcContents[0])
+         return FALSE;
+   }
+   *pdLookup = Bench_now() - dStart;
+
+   if(FT_getContentStats(psStats) != SUCCESS)
+      return FALSE;
+   return (boolean) (FT_destroy() == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 1000000, ulDirs = 4, ulChecksumSize = 0;
+   size_t ulBudget = 0, ulLength;
+   char **ppcPaths;
+   char *pcString, *pcChecksummed, *pcSpilled;
+   size_t i;
+   unsigned long ulState = 1;
+   double dStart, dInsert, dLookup, dList, dPlain, dChecksums;
+   struct CSStats sStats;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'd', "directories", &ulDirs, FALSE },
+      { 'c', "size", &ulChecksumSize, TRUE },
+      { 'b', "budget", &ulBudget, TRUE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   ppcPaths = malloc(ulFiles * sizeof(char *));
+   if(ppcPaths == NULL)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      ppcPaths[i] = malloc(BENCH_MAX_PATH);
+      if(ppcPaths[i] == NULL)
+         return EXIT_FAILURE;
+      sprintf(ppcPaths[i], "ingestbench/d%lu/f%lu",
+              (unsigned long) (i % ulDirs), (unsigned long) (i / ulDirs));
+   }
+
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   IngestBench_shuffle(ppcPaths, ulFiles, &ulState);
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], &cContents, 1) != SUCCESS) {
+         fprintf(stderr, "%s: inserting %s failed\n", argv[0],
+                 ppcPaths[i]);
+         return EXIT_FAILURE;
+      }
+   dInsert = Bench_now() - dStart;
+
+   IngestBench_shuffle(ppcPaths, ulFiles, &ulState);
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(FT_getFileContents(ppcPaths[i]) != &cContents) {
+         fprintf(stderr, "%s: %s not found\n", argv[0], ppcPaths[i]);
+         return EXIT_FAILURE;
+      }
+   dLookup = Bench_now() - dStart;
+
+   dStart = Bench_now();
+   pcString = FT_toString();
+   dList = Bench_now() - dStart;
+   if(pcString == NULL)
+      return EXIT_FAILURE;
+   free(pcString);
+   if(FT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+
+   printf("%lu files in %lu directories\n", (unsigned long) ulFiles,
+          (unsigned long) ulDirs);
+   printf("insert %.1f ns/file, lookup %.1f ns/file, list %.1f ms\n",
+          dInsert / (double) ulFiles * 1e9,
+          dLookup / (double) ulFiles * 1e9, dList * 1e3);
+
+   if(ulChecksumSize != 0) {
+      pcChecksummed = malloc(ulChecksumSize);
+      if(pcChecksummed == NULL)
+         return EXIT_FAILURE;
+      memset(pcChecksummed, 'x', ulChecksumSize);
+      dPlain = IngestBench_insert(ppcPaths, ulFiles, pcChecksummed,
+                                  ulChecksumSize, FALSE);
+      dChecksums = IngestBench_insert(ppcPaths, ulFiles, pcChecksummed,
+                                      ulChecksumSize, TRUE);
+      free(pcChecksummed);
+      if(dPlain < 0.0 || dChecksums < 0.0) {
+         fprintf(stderr, "%s: inserting with %lu-byte contents failed\n",
+                 argv[0], (unsigned long) ulChecksumSize);
+         return EXIT_FAILURE;
+      }
+      printf("%lu-byte files: insert %.1f ns/file, with checksums "
+             "%.1f ns/file (%+.1f ns)\n", (unsigned long) ulChecksumSize,
+             dPlain / (double) ulFiles * 1e9,
+             dChecksums / (double) ulFiles * 1e9,
+             (dChecksums - dPlain) / (double) ulFiles * 1e9);
+   }
+
+   if(ulBudget != 0) {
+      ulLength = ulChecksumSize != 0 ? ulChecksumSize : BUDGET_SIZE;
+      pcSpilled = malloc(ulLength);
+      if(pcSpilled == NULL)
+         return EXIT_FAILURE;
+      memset(pcSpilled, 'x', ulLength);
+      if(!IngestBench_spill(ppcPaths, ulFiles, pcSpilled, ulLength,
+                            ulBudget, &ulState, &dInsert, &dLookup,
+                            &sStats)) {
+         fprintf(stderr, "%s: storing %lu-byte contents under a %lu-byte "
+                 "budget failed\n", argv[0], (unsigned long) ulLength,
+                 (unsigned long) ulBudget);
+         return EXIT_FAILURE;
+      }
+      free(pcSpilled);
+      printf("%lu-byte files in %lu bytes: insert %.1f ns/file, "
+             "lookup %.1f ns/file\n", (unsigned long) ulLength,
+             (unsigned long) ulBudget, dInsert / (double) ulFiles * 1e9,
+             dLookup / (double) ulFiles * 1e9);
+      printf("%lu hits, %lu misses, %lu spills; fault mean %.2f us, "
+             "max %.2f us\n", (unsigned long) sStats.ulHits,
+             (unsigned long) sStats.ulMisses,
+             (unsigned long) sStats.ulSpills,
+             sStats.dMeanFaultSeconds * 1e6,
+             sStats.dMaxFaultSeconds * 1e6);
+   }
+
+   for(i = 0; i < ulFiles; i++)
+      free(ppcPaths[i]);
+   free(ppcPaths);
+   return EXIT_SUCCESS;
+}
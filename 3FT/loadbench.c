@@ -0,0 +1,145 @@
+/*--------------------------------------------------------------------*/
+/* loadbench.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  loadbench compares FT_load with inserting a manifest one entry at a
+  time.
+
+  Usage: loadbench [-n files] [-w fanout] [-t threads]
+
+  It makes a sorted manifest of n files loadbench/aI/bJ/fK, w to a
+  directory, with an entry for each directory aI too, and builds the
+  FT from it by FT_insertDir and FT_insertFile, then by FT_load on 1,
+  2, 4 and so on up to t threads. It reports the milliseconds each
+  took, and checks that each built the same tree, by FT_toString.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "a4def.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Contents of every file; the FT only keeps a pointer to it */
+static char cContents = 'x';
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the pathnames of entries pvFirst and pvSecond, for qsort. */
+static int LoadBench_compare(const void *pvFirst, const void *pvSecond) {
+   return strcmp(((const struct FTLoadEntry *) pvFirst)->pcPath,
+                 ((const struct FTLoadEntry *) pvSecond)->pcPath);
+}
+
+/* Inserts the ulCount entries of psEntries one at a time. Returns
+   FALSE if one fails, TRUE otherwise. */
+static boolean LoadBench_serial(const struct FTLoadEntry *psEntries,
+                                size_t ulCount) {
+   size_t i;
+   int iStatus;
+
+   for(i = 0; i < ulCount; i++) {
+      if(psEntries[i].bIsFile)
+         iStatus = FT_insertFile(psEntries[i].pcPath,
+                                 psEntries[i].pvContents,
+                                 psEntries[i].ulLength);
+      else
+         iStatus = FT_insertDir(psEntries[i].pcPath);
+      if(iStatus != SUCCESS)
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 1000000, ulFanout = 32, ulMaxThreads = 8;
+   struct FTLoadEntry *psEntries;
+   size_t ulCount, ulThreads, ulTops, i;
+   char *pcExpected, *pcActual;
+   double dStart, dSerial, dSeconds;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'w', "fanout", &ulFanout, FALSE },
+      { 't', "threads", &ulMaxThreads, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   /* Generate the manifest and sort it */
+   ulTops = (ulFiles - 1) / ulFanout / ulFanout + 1;
+   ulCount = ulFiles + ulTops;
+   psEntries = malloc(ulCount * sizeof(struct FTLoadEntry));
+   if(psEntries == NULL)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulCount; i++) {
+      char *pcPath = malloc(BENCH_MAX_PATH);
+
+      if(pcPath == NULL)
+         return EXIT_FAILURE;
+      if(i < ulFiles)
+         sprintf(pcPath, "loadbench/a%lu/b%lu/f%lu",
+                 (unsigned long) (i / ulFanout / ulFanout),
+                 (unsigned long) (i / ulFanout % ulFanout),
+                 (unsigned long) (i % ulFanout));
+      else
+         sprintf(pcPath, "loadbench/a%lu", (unsigned long) (i - ulFiles));
+      psEntries[i].pcPath = pcPath;
+      psEntries[i].bIsFile = (boolean) (i < ulFiles);
+      psEntries[i].pvContents = i < ulFiles ? &cContents : NULL;
+      psEntries[i].ulLength = i < ulFiles ? 1 : 0;
+   }
+   qsort(psEntries, ulCount, sizeof(struct FTLoadEntry),
+         LoadBench_compare);
+
+   /* One entry at a time, for the time and the tree to match */
+   if(FT_init() != SUCCESS)
+      return EXIT_FAILURE;
+   dStart = Bench_now();
+   if(!LoadBench_serial(psEntries, ulCount)) {
+      fprintf(stderr, "%s: an insertion failed\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   dSerial = Bench_now() - dStart;
+   pcExpected = FT_toString();
+   if(pcExpected == NULL || FT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+
+   printf("%lu entries, %lu files per directory\n",
+          (unsigned long) ulCount, (unsigned long) ulFanout);
+   printf("%-10s%12s%10s\n", "threads", "ms", "speedup");
+   printf("%-10s%12.1f%10.2f\n", "serial", dSerial * 1e3, 1.0);
+   for(ulThreads = 1; ulThreads <= ulMaxThreads; ulThreads *= 2) {
+      if(FT_init() != SUCCESS)
+         return EXIT_FAILURE;
+      dStart = Bench_now();
+      if(FT_load(psEntries, ulCount, ulThreads) != SUCCESS) {
+         fprintf(stderr, "%s: FT_load failed\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+      dSeconds = Bench_now() - dStart;
+      pcActual = FT_toString();
+      if(pcActual == NULL || strcmp(pcActual, pcExpected) != 0) {
+         fprintf(stderr, "%s: FT_load on %lu threads built another "
+                 "tree\n", argv[0], (unsigned long) ulThreads);
+         return EXIT_FAILURE;
+      }
+      free(pcActual);
+      if(FT_destroy() != SUCCESS)
+         return EXIT_FAILURE;
+      printf("%-10lu%12.1f%10.2f\n", (unsigned long) ulThreads,
+             dSeconds * 1e3, dSerial / dSeconds);
+   }
+
+   free(pcExpected);
+   for(i = 0; i < ulCount; i++)
+      free((char *) psEntries[i].pcPath);
+   free(psEntries);
+   return EXIT_SUCCESS;
+}
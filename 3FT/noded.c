@@ -10,6 +10,19 @@
 #include "noded.h"
 #include "nodef.h"
 
+/* Children of one kind added since they were last merged into the 
+sorted children array */
+struct pending {
+    /* the children, sorted like the sorted array (NULL until first 
+    needed) */
+    DynArray_T oDChildren;
+
+    /* for each child, its place in the sorted array, i.e. how many of 
+    the sorted children come before it, with room for ulRoom */
+    size_t *pulPlaces;
+    size_t ulRoom;
+};
+
 /* A directory node in a DT */
 struct nodeD {
     /* the object corresponding to the node's absolute path */
@@ -25,25 +38,236 @@ struct nodeD {
     /* the object containg links to this node's children that are 
     directories */
     DynArray_T oDDirChildren;
+
+    /* children added away from the ends of the arrays above since 
+    they were last merged into them; a child is in one array or the 
+    other */
+    struct pending sFilePending;
+    struct pending sDirPending;
+
+    /* number of files and directories below this node (not counting 
+    the node itself), kept current along the parent chain */
+    size_t ulSubFiles;
+    size_t ulSubDirs;
+
+    /* metadata attributes of the directory (or NULL) */
+    Attrs_T oAAttrs;
+
+    /* access heat of the directory itself, managed by the heat module */
+    unsigned long ulHeat;
 };
 
-/* ================================================================== */
+/* The most children an insertion may shift in a sorted children 
+array; a child that would shift more goes into the pending array */
+enum { SHIFT_MAX = 32 };
+
+/* The comparison functions of the children arrays */
+#define NodeD_compareDirs \
+   ((int (*)(const void *, const void *)) NodeD_compare)
+#define NodeD_compareFiles \
+   ((int (*)(const void *, const void *)) NodeF_compare)
+
+/* Adds lFiles files and lDirs directories to the subtree counts of 
+oNdNode and all of its ancestors. */
+static void NodeD_adjustCounts(NodeD_T oNdNode, long lFiles,
+                               long lDirs) {
+   while(oNdNode != NULL) {
+      oNdNode->ulSubFiles += (size_t) lFiles;
+      oNdNode->ulSubDirs += (size_t) lDirs;
+      oNdNode = oNdNode->oNdParent;
+   }
+}
+
+/* Returns the number of children pending in psPending. */
+static size_t NodeD_getNumPending(const struct pending *psPending) {
+   assert(psPending != NULL);
+
+   if(psPending->oDChildren == NULL)
+      return 0;
+   return DynArray_getLength(psPending->oDChildren);
+}
+
+/*
+  Returns how many of the children pending in psPending come before 
+  position ulPosition in the order of all the children. The position 
+  of the pending child at index j is j plus its place, which grows 
+  with j, so this is a binary search that compares no names.
+*/
+static size_t NodeD_countPendingBefore(const struct pending *psPending,
+                                       size_t ulPosition) {
+   size_t ulLow = 0, ulHigh, ulMid;
+
+   assert(psPending != NULL);
+
+   ulHigh = NodeD_getNumPending(psPending);
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      if(ulMid + psPending->pulPlaces[ulMid] < ulPosition)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   return ulLow;
+}
+
+/*
+  Inserts pvChild at position ulPosition among the children held in 
+  sorted array oDSorted and pending children psPending. A child near 
+  the end of oDSorted goes straight into it; any other goes into 
+  psPending (whose array is created from oAAlloc if NULL), which is 
+  merged into oDSorted once its length squared passes oDSorted's, so 
+  that an insertion in random order moves about the square root of 
+  the number of children rather than half of them. oDSorted is kept 
+  with room for both, so that merging never fails. Returns SUCCESS, or 
+  MEMORY_ERROR (adding nothing) if allocation fails.
+*/
+static int NodeD_insertChild(DynArray_T oDSorted,
+                             struct pending *psPending,
+                             const void *pvChild, size_t ulPosition,
+                             int (*pfCompare)(const void *,
+                                              const void *),
+                             Alloc_T oAAlloc) {
+   size_t ulSorted, ulPending, ulBefore, ulPlace, j;
+   size_t *pulPlaces;
+
+   assert(oDSorted != NULL);
+   assert(psPending != NULL);
+   assert(pvChild != NULL);
+
+   ulSorted = DynArray_getLength(oDSorted);
+   ulPending = NodeD_getNumPending(psPending);
+   assert(ulPosition <= ulSorted + ulPending);
+   ulBefore = NodeD_countPendingBefore(psPending, ulPosition);
+   ulPlace = ulPosition - ulBefore;
+   if(!DynArray_reserve(oDSorted, ulSorted + ulPending + 1))
+      return MEMORY_ERROR;
+
+   /* Near the end, every pending child after the new one moves back a 
+   place */
+   if(ulSorted - ulPlace <= SHIFT_MAX) {
+      if(!DynArray_addAt(oDSorted, ulPlace, pvChild))
+         return MEMORY_ERROR;
+      for(j = ulBefore; j < ulPending; j++)
+         psPending->pulPlaces[j]++;
+      return SUCCESS;
+   }
+
+   if(psPending->oDChildren == NULL) {
+      psPending->oDChildren = DynArray_newWith(0, oAAlloc);
+      if(psPending->oDChildren == NULL)
+         return MEMORY_ERROR;
+   }
+   if(ulPending == psPending->ulRoom) {
+      pulPlaces = Alloc_realloc(oAAlloc, psPending->pulPlaces,
+                                psPending->ulRoom * sizeof(size_t),
+                                (2 * psPending->ulRoom + 1) *
+                                sizeof(size_t));
+      if(pulPlaces == NULL)
+         return MEMORY_ERROR;
+      psPending->pulPlaces = pulPlaces;
+      psPending->ulRoom = 2 * psPending->ulRoom + 1;
+   }
+   if(!DynArray_addAt(psPending->oDChildren, ulBefore, pvChild))
+      return MEMORY_ERROR;
+   memmove(&psPending->pulPlaces[ulBefore + 1],
+           &psPending->pulPlaces[ulBefore],
+           (ulPending - ulBefore) * sizeof(size_t));
+   psPending->pulPlaces[ulBefore] = ulPlace;
+
+   ulPending++;
+   if(ulPending * ulPending > ulSorted)
+      (void) DynArray_merge(oDSorted, psPending->oDChildren,
+                            pfCompare);
+   return SUCCESS;
+}
+
+/* Frees psPending's arrays, which must hold no children, with 
+oAAlloc. */
+static void NodeD_freePending(struct pending *psPending,
+                              Alloc_T oAAlloc) {
+   assert(psPending != NULL);
+   assert(NodeD_getNumPending(psPending) == 0);
+
+   if(psPending->oDChildren != NULL)
+      DynArray_free(psPending->oDChildren);
+   Alloc_free(oAAlloc, psPending->pulPlaces,
+              psPending->ulRoom * sizeof(size_t));
+   psPending->oDChildren = NULL;
+   psPending->pulPlaces = NULL;
+   psPending->ulRoom = 0;
+}
+
+/*
+  Unlinks and returns the child at position ulPosition among the 
+  children held in sorted array oDSorted and pending children 
+  psPending.
+*/
+static void *NodeD_removeChild(DynArray_T oDSorted,
+                               struct pending *psPending,
+                               size_t ulPosition) {
+   size_t ulPending, ulBefore, j;
+
+   assert(oDSorted != NULL);
+   assert(psPending != NULL);
+
+   ulPending = NodeD_getNumPending(psPending);
+   ulBefore = NodeD_countPendingBefore(psPending, ulPosition);
+   if(ulBefore < ulPending &&
+      ulBefore + psPending->pulPlaces[ulBefore] == ulPosition) {
+      memmove(&psPending->pulPlaces[ulBefore],
+              &psPending->pulPlaces[ulBefore + 1],
+              (ulPending - ulBefore - 1) * sizeof(size_t));
+      return DynArray_removeAt(psPending->oDChildren, ulBefore);
+   }
+
+   /* Every pending child after the one removed moves up a place */
+   for(j = ulBefore; j < ulPending; j++)
+      psPending->pulPlaces[j]--;
+   return DynArray_removeAt(oDSorted, ulPosition - ulBefore);
+}
+
 /*
-  Links new directory child oNdChild into oNdParent's directory 
-  children array at index ulIndex. Returns SUCCESS if the new directory 
-  child was added successfully, or  MEMORY_ERROR if allocation fails 
-  adding oNdChild to the directory children array.
+  Returns TRUE if the children held in sorted array oDSorted and 
+  pending children psPending include one named pcPathname, compared by 
+  pfCompare. Stores in *pulPosition its position in the order of all 
+  the children if so, or the position it would take if not.
 */
-static int NodeD_addDirChild(NodeD_T oNdParent, NodeD_T oNdChild,
-                        size_t ulIndex) {
-    assert(oNdParent != NULL);
-    assert(oNdChild != NULL);
+static boolean NodeD_findChild(DynArray_T oDSorted,
+                               const struct pending *psPending,
+                               const char *pcPathname,
+                               int (*pfCompare)(const void *,
+                                                const void *),
+                               size_t *pulPosition) {
+   size_t ulPlace, ulBefore = 0;
+   boolean bFound;
+
+   /* The children before it are those before it in either array */
+   bFound = (boolean) DynArray_bsearch(oDSorted, (char *) pcPathname,
+                                       &ulPlace, pfCompare);
+   if(NodeD_getNumPending(psPending) != 0 &&
+      DynArray_bsearch(psPending->oDChildren, (char *) pcPathname,
+                       &ulBefore, pfCompare))
+      bFound = TRUE;
+   *pulPosition = ulPlace + ulBefore;
+   return bFound;
+}
+
+/* Returns the child at position ulPosition among the children held 
+in sorted array oDSorted and pending children psPending, or NULL if 
+there is none. */
+static void *NodeD_getChild(DynArray_T oDSorted,
+                            const struct pending *psPending,
+                            size_t ulPosition) {
+   size_t ulPending, ulBefore;
 
-   /* insert into directory children array at user-given index */
-    if(DynArray_addAt(oNdParent->oDDirChildren, ulIndex, oNdChild))
-        return SUCCESS;
-    else
-        return MEMORY_ERROR;
+   ulPending = NodeD_getNumPending(psPending);
+   if(ulPosition >= DynArray_getLength(oDSorted) + ulPending)
+      return NULL;
+   ulBefore = NodeD_countPendingBefore(psPending, ulPosition);
+   if(ulBefore < ulPending &&
+      ulBefore + psPending->pulPlaces[ulBefore] == ulPosition)
+      return DynArray_get(psPending->oDChildren, ulBefore);
+   return DynArray_get(oDSorted, ulPosition - ulBefore);
 }
 
 /* Removes and frees all file children from oNdNode. */
@@ -59,9 +283,10 @@ static void NodeD_removeFileChildren(NodeD_T oNdNode){
    numFileChildren2 = NodeD_getNumFileChildren(oNdNode);
    /* Loop thru array of file children and remove/free them */
    while(numFileChildren != 0) {
-      /* free memory and remove from dynarray */
-      NodeF_free(DynArray_get(oNdNode->oDFileChildren,0));
-      (void)DynArray_removeAt(oNdNode->oDFileChildren,0);
+      /* free memory and remove from dynarray, from the end so that
+      nothing shifts */
+      NodeF_free(DynArray_removeAt(oNdNode->oDFileChildren,
+                                   numFileChildren - 1));
 
       /* check that a file child was actually removed*/
       numFileChildren2 -= 1;
@@ -90,6 +315,7 @@ static int NodeD_compareString(const NodeD_T oNdNode1,
 /* ================================================================== */
 int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
    struct nodeD *psdNew;
+   Alloc_T oAAlloc;
    Path_T oPParentPath = NULL;
    Path_T oPNewPath = NULL;
    size_t ulParentDepth;
@@ -99,8 +325,9 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
    assert(oPPath != NULL);
    assert(poNdResult != NULL);
 
-   /* allocate space for a new node */
-   psdNew = malloc(sizeof(struct nodeD));
+   /* allocate space for a new node, from the allocator of its path */
+   oAAlloc = Path_getAlloc(oPPath);
+   psdNew = Alloc_malloc(oAAlloc, sizeof(struct nodeD));
    if(psdNew == NULL) {
       *poNdResult = NULL;
       return MEMORY_ERROR;
@@ -109,7 +336,7 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
    /* set the new node's path */
    iStatus = Path_dup(oPPath, &oPNewPath);
    if(iStatus != SUCCESS) {
-      free(psdNew);
+      Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
       *poNdResult = NULL;
       return iStatus;
    }
@@ -128,7 +355,7 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
       /* parent must be an ancestor of child */
       if(ulSharedDepth < ulParentDepth) {
          Path_free(psdNew->oPPath);
-         free(psdNew);
+         Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
          *poNdResult = NULL;
          return CONFLICTING_PATH;
       }
@@ -136,7 +363,7 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
       /* parent must be exactly one level up from child */
       if(Path_getDepth(psdNew->oPPath) != ulParentDepth + 1) {
          Path_free(psdNew->oPPath);
-         free(psdNew);
+         Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
          *poNdResult = NULL;
          return NO_SUCH_PATH;
       }
@@ -144,7 +371,7 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
       /* parent must not already have child with this path */
       if(NodeD_hasDirChild(oNdParent, oPPath, &ulIndex)) {
          Path_free(psdNew->oPPath);
-         free(psdNew);
+         Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
          *poNdResult = NULL;
          return ALREADY_IN_TREE;
       }
@@ -154,7 +381,7 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
       /* can only create one "level" at a time */
       if(Path_getDepth(psdNew->oPPath) != 1) {
          Path_free(psdNew->oPPath);
-         free(psdNew);
+         Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
          *poNdResult = NULL;
          return NO_SUCH_PATH;
       }
@@ -163,24 +390,36 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
    psdNew->oNdParent = oNdParent;
 
    /* initialize the new node */
-   psdNew->oDFileChildren = DynArray_new(0);
-   psdNew->oDDirChildren = DynArray_new(0);
+   psdNew->ulSubFiles = 0;
+   psdNew->ulSubDirs = 0;
+   psdNew->oAAttrs = NULL;
+   psdNew->ulHeat = 0;
+   psdNew->oDFileChildren = DynArray_newWith(0, oAAlloc);
+   psdNew->oDDirChildren = DynArray_newWith(0, oAAlloc);
+   psdNew->sFilePending.oDChildren = NULL;
+   psdNew->sFilePending.pulPlaces = NULL;
+   psdNew->sFilePending.ulRoom = 0;
+   psdNew->sDirPending = psdNew->sFilePending;
    if(psdNew->oDFileChildren == NULL || psdNew->oDDirChildren == NULL) {
       Path_free(psdNew->oPPath);
-      free(psdNew);
+      Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
       *poNdResult = NULL;
       return MEMORY_ERROR;
    }
 
    /* Link into parent's children list */
    if(oNdParent != NULL) {
-      iStatus = NodeD_addDirChild(oNdParent, psdNew, ulIndex);
+      iStatus = NodeD_insertChild(oNdParent->oDDirChildren,
+                                  &oNdParent->sDirPending, psdNew,
+                                  ulIndex, NodeD_compareDirs,
+                                  Path_getAlloc(oNdParent->oPPath));
       if(iStatus != SUCCESS) {
          Path_free(psdNew->oPPath);
-         free(psdNew);
+         Alloc_free(oAAlloc, psdNew, sizeof(struct nodeD));
          *poNdResult = NULL;
          return iStatus;
       }
+      NodeD_adjustCounts(oNdParent, 0, 1);
    }
 
    *poNdResult = psdNew;
@@ -188,45 +427,124 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult) {
    return SUCCESS;
 }
 
+/* ================================================================== */
+void NodeD_detach(NodeD_T oNdNode) {
+   size_t ulIndex;
+
+   assert(oNdNode != NULL);
+
+   if(oNdNode->oNdParent == NULL)
+      return;
+   if(NodeD_hasDirChild(oNdNode->oNdParent, oNdNode->oPPath, &ulIndex))
+      (void) NodeD_removeChild(oNdNode->oNdParent->oDDirChildren,
+                               &oNdNode->oNdParent->sDirPending,
+                               ulIndex);
+   NodeD_adjustCounts(oNdNode->oNdParent,
+                      -(long) oNdNode->ulSubFiles,
+                      -(long) (oNdNode->ulSubDirs + 1));
+   oNdNode->oNdParent = NULL;
+}
+
+/* ================================================================== */
+void NodeD_adoptChildren(NodeD_T oNdNode, DynArray_T oDFiles,
+                         DynArray_T oDDirs) {
+   NodeD_T oNdChild;
+   size_t ulFiles, ulDirs, i;
+
+   assert(oNdNode != NULL);
+   assert(oDFiles != NULL);
+   assert(oDDirs != NULL);
+
+   NodeD_freePending(&oNdNode->sFilePending,
+                     Path_getAlloc(oNdNode->oPPath));
+   NodeD_freePending(&oNdNode->sDirPending,
+                     Path_getAlloc(oNdNode->oPPath));
+   DynArray_free(oNdNode->oDFileChildren);
+   DynArray_free(oNdNode->oDDirChildren);
+   oNdNode->oDFileChildren = oDFiles;
+   oNdNode->oDDirChildren = oDDirs;
+
+   /* Recount from the children, whose own counts are current */
+   ulFiles = DynArray_getLength(oDFiles);
+   ulDirs = DynArray_getLength(oDDirs);
+   for(i = 0; i < DynArray_getLength(oDDirs); i++) {
+      oNdChild = DynArray_get(oDDirs, i);
+      oNdChild->oNdParent = oNdNode;
+      ulFiles += oNdChild->ulSubFiles;
+      ulDirs += oNdChild->ulSubDirs;
+   }
+   NodeD_adjustCounts(oNdNode->oNdParent,
+                      (long) (ulFiles - oNdNode->ulSubFiles),
+                      (long) (ulDirs - oNdNode->ulSubDirs));
+   oNdNode->ulSubFiles = ulFiles;
+   oNdNode->ulSubDirs = ulDirs;
+}
+
+/* ================================================================== */
+void NodeD_freeShell(NodeD_T oNdNode) {
+   Alloc_T oAAlloc;
+
+   assert(oNdNode != NULL);
+
+   oAAlloc = Path_getAlloc(oNdNode->oPPath);
+   NodeD_freePending(&oNdNode->sFilePending, oAAlloc);
+   NodeD_freePending(&oNdNode->sDirPending, oAAlloc);
+   DynArray_free(oNdNode->oDFileChildren);
+   DynArray_free(oNdNode->oDDirChildren);
+   Attrs_free(oNdNode->oAAttrs);
+   Path_free(oNdNode->oPPath);
+   Alloc_free(oAAlloc, oNdNode, sizeof(struct nodeD));
+}
+
 /* ================================================================== */
 int NodeD_addFileChild(NodeD_T oNdParent, NodeF_T oNfChild, size_t 
 ulIndex) {
+   int iStatus;
+
    assert(oNdParent != NULL);
    assert(oNfChild != NULL);
 
-   if (DynArray_addAt(oNdParent->oDFileChildren, ulIndex, oNfChild))
-      return SUCCESS;
-   else
-      return MEMORY_ERROR;
+   iStatus = NodeD_insertChild(oNdParent->oDFileChildren,
+                               &oNdParent->sFilePending, oNfChild,
+                               ulIndex, NodeD_compareFiles,
+                               Path_getAlloc(oNdParent->oPPath));
+   if(iStatus != SUCCESS)
+      return iStatus;
+   NodeD_adjustCounts(oNdParent, 1, 0);
+   return SUCCESS;
 }
 
 /* ================================================================== */
-size_t NodeD_free(NodeD_T oNdNode) {
+NodeF_T NodeD_removeFileChild(NodeD_T oNdParent, size_t ulIndex) {
+   assert(oNdParent != NULL);
+
+   NodeD_adjustCounts(oNdParent, -1, 0);
+   return NodeD_removeChild(oNdParent->oDFileChildren,
+                            &oNdParent->sFilePending, ulIndex);
+}
+
+/*
+  Frees the subtree rooted at oNdNode without unlinking it from its 
+  parent. Returns the number of directories freed.
+*/
+static size_t NodeD_freeSubtree(NodeD_T oNdNode) {
+   Alloc_T oAAlloc;
    size_t ulIndex;
    size_t ulCount = 0;
 
    assert(oNdNode != NULL);
 
-   /* remove from parent's list */
-   if(oNdNode->oNdParent != NULL) {
-      /* Search for directory in parent's directory children array and 
-      sets index in the array */
-      if(DynArray_bsearch(
-            oNdNode->oNdParent->oDDirChildren,
-            oNdNode, &ulIndex,
-            (int (*)(const void *, const void *)) NodeD_compare)) {
-               /* Remove in the parent's directory children array at 
-               the index found */
-               (void) DynArray_removeAt
-               (oNdNode->oNdParent->oDDirChildren,
-                                  ulIndex);
-            }
-   }
+   oAAlloc = Path_getAlloc(oNdNode->oPPath);
+   NodeD_mergeChildren(oNdNode);
+   NodeD_freePending(&oNdNode->sFilePending, oAAlloc);
+   NodeD_freePending(&oNdNode->sDirPending, oAAlloc);
 
-   /* Recursively remove directory children */
-   while(DynArray_getLength(oNdNode->oDDirChildren) != 0) {
+   /* Recursively free directory children */
+   for(ulIndex = 0; ulIndex < DynArray_getLength(oNdNode->oDDirChildren);
+       ulIndex++) {
       /* Increment counter of directories removed */
-      ulCount += NodeD_free(DynArray_get(oNdNode->oDDirChildren, 0));
+      ulCount += NodeD_freeSubtree(
+                    DynArray_get(oNdNode->oDDirChildren, ulIndex));
    }
    /* free the node's children */
    DynArray_free(oNdNode->oDDirChildren);
@@ -234,15 +552,40 @@ size_t NodeD_free(NodeD_T oNdNode) {
    /* Removes and frees file children (hence no free after) */
    NodeD_removeFileChildren(oNdNode);
 
-   /* remove path */
+   /* remove attributes and path */
+   Attrs_free(oNdNode->oAAttrs);
    Path_free(oNdNode->oPPath);
 
    /* finally, free the struct node */
-   free(oNdNode);
+   Alloc_free(oAAlloc, oNdNode, sizeof(struct nodeD));
    ulCount++;
    return ulCount;
 }
 
+/* ================================================================== */
+size_t NodeD_free(NodeD_T oNdNode) {
+   size_t ulIndex;
+
+   assert(oNdNode != NULL);
+
+   /* remove from parent's list */
+   if(oNdNode->oNdParent != NULL) {
+      /* Search for directory among the parent's directory children 
+      and remove it at the identifier found */
+      if(NodeD_hasDirChild(oNdNode->oNdParent, oNdNode->oPPath,
+                           &ulIndex))
+         (void) NodeD_removeChild(oNdNode->oNdParent->oDDirChildren,
+                                  &oNdNode->oNdParent->sDirPending,
+                                  ulIndex);
+      /* the whole subtree leaves the counts of every ancestor */
+      NodeD_adjustCounts(oNdNode->oNdParent,
+                         -(long) oNdNode->ulSubFiles,
+                         -(long) (oNdNode->ulSubDirs + 1));
+   }
+
+   return NodeD_freeSubtree(oNdNode);
+}
+
 /* ================================================================== */
 Path_T NodeD_getPath(NodeD_T oNdNode) {
    assert(oNdNode != NULL);
@@ -257,12 +600,12 @@ boolean NodeD_hasDirChild(NodeD_T oNdParent, Path_T oPPath,
    assert(oPPath != NULL);
    assert(pulChildID != NULL);
 
-   /* returns results of binary search of directory child array, 
-   *pulChildID is the index into oNdParent->oDDirChildren, gets set by 
-   DynArray_bsearch */
-   return (DynArray_bsearch(oNdParent->oDDirChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) NodeD_compareString));
+   /* returns results of binary searches of the directory child 
+   arrays, sorted then pending; *pulChildID gets set by them */
+   return NodeD_findChild(oNdParent->oDDirChildren,
+            &oNdParent->sDirPending, Path_getPathname(oPPath),
+            (int (*)(const void*,const void*)) NodeD_compareString,
+            pulChildID);
 }
 
 /* ================================================================== */
@@ -272,28 +615,30 @@ boolean NodeD_hasFileChild(NodeD_T oNdParent, Path_T oPPath,
    assert(oPPath != NULL);
    assert(pulChildID != NULL);
 
-   /* returns results of binary search of file child array, *pulChildID 
-   is the index into oNdParent->oDFileChildren, gets set by 
-   DynArray_bsearch */
-   return (DynArray_bsearch(oNdParent->oDFileChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) NodeF_compareString));
+   /* returns results of binary searches of the file child arrays, 
+   sorted then pending; *pulChildID gets set by them */
+   return NodeD_findChild(oNdParent->oDFileChildren,
+            &oNdParent->sFilePending, Path_getPathname(oPPath),
+            (int (*)(const void*,const void*)) NodeF_compareString,
+            pulChildID);
 }
 
 /* ================================================================== */
 size_t NodeD_getNumDirChildren(NodeD_T oNdParent) {
    assert(oNdParent != NULL);
 
-   /* length of file child array */
-   return DynArray_getLength(oNdParent->oDDirChildren);
+   /* lengths of the directory child arrays, sorted and pending */
+   return DynArray_getLength(oNdParent->oDDirChildren) +
+          NodeD_getNumPending(&oNdParent->sDirPending);
 }
 
 /* ================================================================== */
 size_t NodeD_getNumFileChildren(NodeD_T oNdParent) {
    assert(oNdParent != NULL);
 
-   /* length of file child array */
-   return DynArray_getLength(oNdParent->oDFileChildren);
+   /* lengths of the file child arrays, sorted and pending */
+   return DynArray_getLength(oNdParent->oDFileChildren) +
+          NodeD_getNumPending(&oNdParent->sFilePending);
 }
 
 /* ================================================================== */
@@ -303,16 +648,11 @@ int  NodeD_getDirChild(NodeD_T oNdParent, size_t ulChildID,
    assert(oNdParent != NULL);
    assert(poNdResult != NULL);
 
-   /* ulChildID is the index into oNdParent->oDDirChildren */
-   if(ulChildID >= NodeD_getNumDirChildren(oNdParent)) {
-      *poNdResult = NULL;
-      return NO_SUCH_PATH;
-   }
-   else {
-    /* Check where it exists (which array) then store in poNdResult */
-      *poNdResult = DynArray_get(oNdParent->oDDirChildren, ulChildID);
-      return SUCCESS;
-   }
+   /* ulChildID is the position among the directory children in 
+   order, found across the sorted and pending arrays */
+   *poNdResult = NodeD_getChild(oNdParent->oDDirChildren,
+                                &oNdParent->sDirPending, ulChildID);
+   return *poNdResult == NULL ? NO_SUCH_PATH : SUCCESS;
 }
 
 /* ================================================================== */
@@ -322,16 +662,11 @@ int  NodeD_getFileChild(NodeD_T oNdParent, size_t ulChildID,
    assert(oNdParent != NULL);
    assert(poNfResult != NULL);
 
-   /* ulChildID is the index into oNdParent->oDFileChildren */
-   if(ulChildID >= NodeD_getNumFileChildren(oNdParent)) {
-      *poNfResult = NULL;
-      return NO_SUCH_PATH;
-   }
-   else {
-    /* Check where it exists (which array) then store in poNfResult */
-      *poNfResult = DynArray_get(oNdParent->oDFileChildren, ulChildID);
-      return SUCCESS;
-   }
+   /* ulChildID is the position among the file children in order, 
+   found across the sorted and pending arrays */
+   *poNfResult = NodeD_getChild(oNdParent->oDFileChildren,
+                                &oNdParent->sFilePending, ulChildID);
+   return *poNfResult == NULL ? NO_SUCH_PATH : SUCCESS;
 }
 
 /* ================================================================== */
@@ -349,6 +684,20 @@ int NodeD_compare(NodeD_T oNdNode1, NodeD_T oNdNode2) {
    return Path_comparePath(oNdNode1->oPPath, oNdNode2->oPPath);
 }
 
+/* Copies oPPath's pathname and a newline to pcEnd, returning the
+end of the copy. */
+static char *NodeD_appendLine(char *pcEnd, Path_T oPPath) {
+   size_t ulLength;
+
+   assert(pcEnd != NULL);
+   assert(oPPath != NULL);
+
+   ulLength = Path_getStrLength(oPPath);
+   memcpy(pcEnd, Path_getPathname(oPPath), ulLength);
+   pcEnd[ulLength] = '\n';
+   return pcEnd + ulLength + 1;
+}
+
 /* ================================================================== */
 char *NodeD_toString(NodeD_T oNdNode) {
    char *pcResult;  /* Resulting string representation to be returned */
@@ -356,6 +705,7 @@ char *NodeD_toString(NodeD_T oNdNode) {
    size_t i;   /* Index to iterate thru file children */
    size_t numFileChildren; /* Number of file children of directory */
    NodeF_T oNfChild; /* File child of oNdNode*/
+   char *pcEnd; /* End of the text copied into pcResult */
 
    assert(oNdNode != NULL);
 
@@ -364,7 +714,7 @@ char *NodeD_toString(NodeD_T oNdNode) {
    /* Find out how many characters will be in pcResult */
    numFileChildren = NodeD_getNumFileChildren(oNdNode);
    for (i = 0; i < numFileChildren; i++) {
-      oNfChild = DynArray_get(oNdNode->oDFileChildren,i);
+      (void) NodeD_getFileChild(oNdNode, i, &oNfChild);
       totalStrlen += Path_getStrLength(NodeF_getPath(oNfChild)) + 1;
    }
 
@@ -374,27 +724,40 @@ char *NodeD_toString(NodeD_T oNdNode) {
       return NULL;
    }
    
-   *pcResult = '\0';
-
-   /* Concatenate oNdNode directory path name onto pcResult */
-   strcat(pcResult, Path_getPathname(NodeD_getPath(oNdNode)));
-   strcat(pcResult,"\n");
-
-   /* Concatenate child file path names onto pcResult */
+   /* Copy oNdNode directory path name, then child file path names,
+   each onto the end of pcResult, so that the copying is linear in its
+   length rather than quadratic as with strcat */
+   pcEnd = NodeD_appendLine(pcResult, NodeD_getPath(oNdNode));
    for (i = 0; i < numFileChildren; i++) {
-      oNfChild = DynArray_get(oNdNode->oDFileChildren,i);
-      strcat(pcResult, Path_getPathname(NodeF_getPath(oNfChild)));
-      strcat(pcResult,"\n");
+      (void) NodeD_getFileChild(oNdNode, i, &oNfChild);
+      pcEnd = NodeD_appendLine(pcEnd, NodeF_getPath(oNfChild));
    }
+   *pcEnd = '\0';
 
    return pcResult;
 }
 
+/* ================================================================== */
+void NodeD_mergeChildren(NodeD_T oNdNode) {
+   assert(oNdNode != NULL);
+
+   /* NodeD_insertChild left room, so neither merge can fail */
+   if(NodeD_getNumPending(&oNdNode->sFilePending) != 0)
+      (void) DynArray_merge(oNdNode->oDFileChildren,
+                            oNdNode->sFilePending.oDChildren,
+                            NodeD_compareFiles);
+   if(NodeD_getNumPending(&oNdNode->sDirPending) != 0)
+      (void) DynArray_merge(oNdNode->oDDirChildren,
+                            oNdNode->sDirPending.oDChildren,
+                            NodeD_compareDirs);
+}
+
 /* Returns the dynarray object representing the children of oNdNode 
 that are files */
 DynArray_T NodeD_getFileChildren(NodeD_T oNdNode) {
    assert(oNdNode != NULL);
 
+   assert(NodeD_getNumPending(&oNdNode->sFilePending) == 0);
    return oNdNode->oDFileChildren;
 }
 
@@ -403,5 +766,34 @@ that are directories */
 DynArray_T NodeD_getDirChildren(NodeD_T oNdNode) {
    assert(oNdNode != NULL);
 
+   assert(NodeD_getNumPending(&oNdNode->sDirPending) == 0);
    return oNdNode->oDDirChildren;
-}
\ No newline at end of file
+}
+
+/* ================================================================== */
+size_t NodeD_getSubtreeFileCount(NodeD_T oNdNode) {
+   assert(oNdNode != NULL);
+
+   return oNdNode->ulSubFiles;
+}
+
+/* ================================================================== */
+size_t NodeD_getSubtreeDirCount(NodeD_T oNdNode) {
+   assert(oNdNode != NULL);
+
+   return oNdNode->ulSubDirs;
+}
+
+/* ================================================================== */
+Attrs_T *NodeD_getAttrs(NodeD_T oNdNode) {
+   assert(oNdNode != NULL);
+
+   return &oNdNode->oAAttrs;
+}
+
+/* ================================================================== */
+unsigned long *NodeD_getHeat(NodeD_T oNdNode) {
+   assert(oNdNode != NULL);
+
+   return &oNdNode->ulHeat;
+}
@@ -8,11 +8,20 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "dynarray.h"
 #include "path.h"
 #include "nodef.h"
 
 
-/* A NodeD_T is a node in a Directory Tree */
+/*
+  A NodeD_T is a node in a Directory Tree. Its children of each kind
+  are kept in a sorted array and, for those inserted away from its
+  end, a small sorted pending array, merged into the first when it
+  grows past the square root of its length or by NodeD_mergeChildren.
+  Every other call reads the two arrays together without changing
+  them, so that a child's identifier is its position among the
+  children in sorted order.
+*/
 typedef struct nodeD *NodeD_T;
 
 /*
@@ -37,10 +46,43 @@ int NodeD_new(Path_T oPPath, NodeD_T oNdParent, NodeD_T *poNdResult);
 size_t NodeD_free(NodeD_T oNdNode);
 
 /*
-  Links new file child oNfChild into oNdParent's file children array at index ulIndex. Returns SUCCESS if the new directory child was added successfully, or  MEMORY_ERROR if allocation fails adding oNdChild to the directory children array.
+  Unlinks oNdNode, with everything below it, from its parent (if it
+  has one), taking its subtree out of the counts of its ancestors. The
+  subtree is not freed.
+*/
+void NodeD_detach(NodeD_T oNdNode);
+
+/*
+  Replaces oNdNode's children with the file nodes in oDFiles and the
+  directory nodes in oDDirs, arrays sorted like NodeD_compare that
+  oNdNode takes over. Its old arrays are freed, but not the nodes in
+  them, which the caller must have placed or freed. oNdNode becomes the
+  parent of each directory, and the counts of it and its ancestors are
+  brought up to date. Never fails.
+*/
+void NodeD_adoptChildren(NodeD_T oNdNode, DynArray_T oDFiles,
+                         DynArray_T oDDirs);
+
+/*
+  Frees oNdNode alone, after its children have been adopted elsewhere
+  or freed, without unlinking it from its parent.
+*/
+void NodeD_freeShell(NodeD_T oNdNode);
+
+/*
+  Links new file child oNfChild into oNdParent's file children, where
+  ulIndex is the identifier NodeD_hasFileChild just stored for its
+  path. Returns SUCCESS if the new file child was added successfully,
+  or MEMORY_ERROR if allocation fails adding oNfChild to the file
+  children.
 */
 int NodeD_addFileChild(NodeD_T oNdParent, NodeF_T oNfChild, size_t ulIndex);
 
+/*
+  Unlinks and returns the file child of oNdParent with identifier
+  ulIndex, which must be valid. The file node is not freed.
+*/
+NodeF_T NodeD_removeFileChild(NodeD_T oNdParent, size_t ulIndex);
 
 /* Returns the path object representing oNdNode's absolute path. */
 Path_T NodeD_getPath(NodeD_T oNdNode);
@@ -63,7 +105,7 @@ boolean NodeD_hasDirChild(NodeD_T oNdParent, Path_T oPPath,
   If oNdParent has such a child, stores in *pulChildID the child's
   identifier (as used in NodeD_getFileChild). If oNdParent does not have
   such a child, stores in *pulChildID the identifier that such a
-  child _would_ have if inserted.
+  child _would_ have if inserted (as used in NodeD_addFileChild).
 */
 boolean NodeD_hasFileChild(NodeD_T oNdParent, Path_T oPPath,
                          size_t *pulChildID);
@@ -112,10 +154,46 @@ int NodeD_compare(NodeD_T oNdNode1, NodeD_T oNdNode2);
 */
 char *NodeD_toString(NodeD_T oNdNode);
 
-/* Returns the dynarray object representing the children of oNdNode that are files */
+/*
+  Merges the pending children of oNdNode into its sorted arrays, which
+  NodeD_getFileChildren and NodeD_getDirChildren then return whole.
+  Identifiers are unchanged. Never fails.
+*/
+void NodeD_mergeChildren(NodeD_T oNdNode);
+
+/*
+  Returns the dynarray object representing the children of oNdNode
+  that are files, which must have been merged by NodeD_mergeChildren
+  since any was added.
+*/
 DynArray_T NodeD_getFileChildren(NodeD_T oNdNode);
 
-/* Returns the dynarray object representing the children of oNdNode that are directories */
+/*
+  Returns the dynarray object representing the children of oNdNode
+  that are directories, which must have been merged by
+  NodeD_mergeChildren since any was added.
+*/
 DynArray_T NodeD_getDirChildren(NodeD_T oNdNode);
 
+/* Returns the number of files anywhere below oNdNode. */
+size_t NodeD_getSubtreeFileCount(NodeD_T oNdNode);
+
+/*
+  Returns the number of directories anywhere below oNdNode, not
+  counting oNdNode itself.
+*/
+size_t NodeD_getSubtreeDirCount(NodeD_T oNdNode);
+
+/*
+  Returns the address of oNdNode's attribute set (which holds NULL if
+  the node has no attributes), for use with the Attrs_ functions.
+*/
+Attrs_T *NodeD_getAttrs(NodeD_T oNdNode);
+
+/*
+  Returns the address of oNdNode's access heat word, for use with the
+  Heat_ functions.
+*/
+unsigned long *NodeD_getHeat(NodeD_T oNdNode);
+
 #endif
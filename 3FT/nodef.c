@@ -16,14 +16,39 @@ struct nodeF {
    /* Size of file contents in bytes */
    size_t ulLength;
 
-   /* Contents of the file */
+   /* Contents of the file, when owned by the client */
    void *pvContents;
+
+   /* Contents of the file, when held by the content store (or NULL) */
+   CSEntry_T oCEntry;
+
+   /* Metadata attributes of the file (or NULL) */
+   Attrs_T oAAttrs;
+
+   /* Identifier in the text index, or 0 if not indexed */
+   size_t ulTextId;
+
+   /* Neighbours in the file cache's recency list */
+   struct NodeFLinks sLinks;
+
+   /* Expiry deadline and place in the timer wheel */
+   struct NodeFTimer sTimer;
+
+   /* Access heat, managed by the heat module */
+   unsigned long ulHeat;
+
+   /* CRC-32C of the contents when last set, if checksums are on */
+   unsigned long ulChecksum;
+
+   /* Slot in the handle table, or 0 if no handle is open */
+   size_t ulHandle;
 };
 
 /* ================================================================== */
 int NodeF_new(Path_T oPPath, NodeF_T *poNfResult) {
    NodeF_T oNfNew;   /* New file node to be created */
    Path_T oPNewPath; /* New path of new file node */
+   Alloc_T oAAlloc;  /* Allocator of the path, and so of the node */
    int iStatus;
 
    assert(oPPath != NULL);
@@ -36,7 +61,8 @@ int NodeF_new(Path_T oPPath, NodeF_T *poNfResult) {
    }
 
    /* Allocate mem for new node and check for enough mem */
-   oNfNew = (NodeF_T)malloc(sizeof(struct nodeF));
+   oAAlloc = Path_getAlloc(oPPath);
+   oNfNew = (NodeF_T)Alloc_malloc(oAAlloc, sizeof(struct nodeF));
    if(oNfNew == NULL) {
       *poNfResult = NULL;
       return MEMORY_ERROR;
@@ -45,7 +71,7 @@ int NodeF_new(Path_T oPPath, NodeF_T *poNfResult) {
    /* Set the new node's path and check for enough mem */
    iStatus = Path_dup(oPPath, &oPNewPath);
    if(iStatus != SUCCESS) {
-      free(oNfNew);
+      Alloc_free(oAAlloc, oNfNew, sizeof(struct nodeF));
       *poNfResult = NULL;
       return iStatus;
    }
@@ -54,6 +80,18 @@ int NodeF_new(Path_T oPPath, NodeF_T *poNfResult) {
    /* Set initial values of file contents and size*/
    oNfNew->ulLength = 0;
    oNfNew->pvContents = NULL;
+   oNfNew->oCEntry = NULL;
+   oNfNew->oAAttrs = NULL;
+   oNfNew->ulTextId = 0;
+   oNfNew->sLinks.oNfOlder = NULL;
+   oNfNew->sLinks.oNfNewer = NULL;
+   oNfNew->sTimer.ulDeadline = 0;
+   oNfNew->sTimer.uSlot = 0;
+   oNfNew->sTimer.oNfPrev = NULL;
+   oNfNew->sTimer.oNfNext = NULL;
+   oNfNew->ulHeat = 0;
+   oNfNew->ulChecksum = 0;
+   oNfNew->ulHandle = 0;
 
    *poNfResult = oNfNew;
 
@@ -62,12 +100,20 @@ int NodeF_new(Path_T oPPath, NodeF_T *poNfResult) {
 
 /* ================================================================== */
 void NodeF_free(NodeF_T oNfNode) {
+   Alloc_T oAAlloc;
+
    assert(oNfNode != NULL);
 
-   /* Remove path */
+   oAAlloc = Path_getAlloc(oNfNode->oPPath);
+
+   /* Release contents held by the content store */
+   if(oNfNode->oCEntry != NULL)
+      CS_free(oNfNode->oCEntry);
+   /* Remove attributes and path */
+   Attrs_free(oNfNode->oAAttrs);
    Path_free(oNfNode->oPPath);
    /* Free the actual file node */
-   free(oNfNode);
+   Alloc_free(oAAlloc, oNfNode, sizeof(struct nodeF));
 }
 
 /* ================================================================== */
@@ -95,37 +141,56 @@ int NodeF_compareString(const NodeF_T oNfNode1, const char *pcSecond) {
 void *NodeF_getContents(NodeF_T oNfNode) {
    assert(oNfNode != NULL);
 
+   if(oNfNode->oCEntry != NULL)
+      return CS_get(oNfNode->oCEntry);
    return oNfNode->pvContents;
 }
 
 /* ================================================================== */
-size_t NodeF_getLength(NodeF_T oNfNode) {
+void *NodeF_pinContents(NodeF_T oNfNode) {
    assert(oNfNode != NULL);
 
-   return oNfNode->ulLength;
+   if(oNfNode->oCEntry != NULL)
+      return CS_pin(oNfNode->oCEntry);
+   return oNfNode->pvContents;
 }
 
 /* ================================================================== */
-void *NodeF_replaceContents(NodeF_T oNfNode, void* pvNewContents) {
-   void *pvOldContents;
+size_t NodeF_getLength(NodeF_T oNfNode) {
    assert(oNfNode != NULL);
-   /* Record the old contents */
-   pvOldContents = oNfNode->pvContents;
-   /* Set the new contents */
-   oNfNode->pvContents = pvNewContents;
-   return pvOldContents;
+
+   return oNfNode->ulLength;
 }
 
 /* ================================================================== */
-size_t NodeF_replaceLength(NodeF_T oNfNode, size_t ulNewLength) {
-   size_t ulOldLength;
+int NodeF_replaceContents(NodeF_T oNfNode, void *pvNewContents,
+                          size_t ulNewLength, void **ppvOldContents) {
+   CSEntry_T oCNew = NULL;
+   int iStatus;
+
    assert(oNfNode != NULL);
+   assert(ppvOldContents != NULL);
 
-   /* Record the old length */
-   ulOldLength = oNfNode->ulLength;
-   /* Set the new length */
+   /* Copy non-empty contents into the content store, if in use */
+   if(CS_isInitialized() && pvNewContents != NULL && ulNewLength != 0) {
+      iStatus = CS_put(pvNewContents, ulNewLength, &oCNew);
+      if(iStatus != SUCCESS) {
+         *ppvOldContents = NULL;
+         return iStatus;
+      }
+   }
+
+   /* Record the old contents */
+   if(oNfNode->oCEntry != NULL)
+      *ppvOldContents = CS_retire(oNfNode->oCEntry);
+   else
+      *ppvOldContents = oNfNode->pvContents;
+
+   /* Set the new contents and length */
+   oNfNode->oCEntry = oCNew;
+   oNfNode->pvContents = (oCNew == NULL) ? pvNewContents : NULL;
    oNfNode->ulLength = ulNewLength;
-   return ulOldLength;
+   return SUCCESS;
 }
 
 /* ================================================================== */
@@ -141,4 +206,74 @@ char *NodeF_toString(NodeF_T oNfNode) {
    }
    /* Copy path name to copyPath and return the copy */
    return strcpy(copyPath, Path_getPathname(NodeF_getPath(oNfNode)));
-}
\ No newline at end of file
+}
+
+/* ================================================================== */
+Attrs_T *NodeF_getAttrs(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return &oNfNode->oAAttrs;
+}
+
+/* ================================================================== */
+size_t NodeF_getTextId(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return oNfNode->ulTextId;
+}
+
+/* ================================================================== */
+void NodeF_setTextId(NodeF_T oNfNode, size_t ulTextId) {
+   assert(oNfNode != NULL);
+
+   oNfNode->ulTextId = ulTextId;
+}
+
+/* ================================================================== */
+struct NodeFLinks *NodeF_getLinks(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return &oNfNode->sLinks;
+}
+
+/* ================================================================== */
+struct NodeFTimer *NodeF_getTimer(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return &oNfNode->sTimer;
+}
+
+/* ================================================================== */
+unsigned long *NodeF_getHeat(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return &oNfNode->ulHeat;
+}
+
+/* ================================================================== */
+unsigned long NodeF_getChecksum(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return oNfNode->ulChecksum;
+}
+
+/* ================================================================== */
+void NodeF_setChecksum(NodeF_T oNfNode, unsigned long ulChecksum) {
+   assert(oNfNode != NULL);
+
+   oNfNode->ulChecksum = ulChecksum;
+}
+
+/* ================================================================== */
+size_t NodeF_getHandle(NodeF_T oNfNode) {
+   assert(oNfNode != NULL);
+
+   return oNfNode->ulHandle;
+}
+
+/* ================================================================== */
+void NodeF_setHandle(NodeF_T oNfNode, size_t ulHandle) {
+   assert(oNfNode != NULL);
+
+   oNfNode->ulHandle = ulHandle;
+}
@@ -9,11 +9,28 @@
 #include <stddef.h>
 #include "a4def.h"
 #include "path.h"
+#include "contentstore.h"
+#include "attrs.h"
 
 
 /* A NodeF_T is a node in a Directory Tree */
 typedef struct nodeF *NodeF_T;
 
+/* A file node's neighbours in a recency list (NULL at either end) */
+struct NodeFLinks {
+   NodeF_T oNfOlder;
+   NodeF_T oNfNewer;
+};
+
+/* A file node's expiry deadline and its place in a timer wheel, which
+   manages every field; uSlot is 0 while no deadline is set */
+struct NodeFTimer {
+   unsigned long ulDeadline;
+   unsigned int uSlot;
+   NodeF_T oNfPrev;
+   NodeF_T oNfNext;
+};
+
 /*
   Creates a new file node in File Tree, with path oPPath. Returns an 
   int SUCCESS status and sets *poNfResult to be the new node
@@ -46,19 +63,34 @@ int NodeF_compare(NodeF_T oNfNode1, NodeF_T oNfNode2);
 */
 int NodeF_compareString(const NodeF_T oNfNode1, const char *pcSecond);
 
-/* Gets and returns the contents of file node oNfNode. */
+/*
+  Gets and returns the contents of file node oNfNode, faulting them in
+  from the content store if necessary. Returns NULL if they could not
+  be faulted in.
+*/
 void *NodeF_getContents(NodeF_T oNfNode);
 
+/*
+  Like NodeF_getContents, but contents held by the content store are
+  pinned there, staying valid through later calls to
+  NodeF_pinContents until the store's next fetch of another kind.
+*/
+void *NodeF_pinContents(NodeF_T oNfNode);
+
 /* Gets and returns the length of the contents of oNfNode */
 size_t NodeF_getLength(NodeF_T oNfNode);
 
-/* Replaces the current contents of oNfNode with new contents
-  pvNewContents. Returns the old contents. */
-void *NodeF_replaceContents(NodeF_T oNfNode, void* pvNewContents);
-
-/* Replaces the current length of oNfNode with new length ulNewLength.
-  Returns the old length. */
-size_t NodeF_replaceLength(NodeF_T oNfNode, size_t ulNewLength);
+/*
+  Replaces the current contents of oNfNode with pvNewContents of size
+  ulNewLength bytes and stores the old contents in *ppvOldContents.
+  If the content store is initialized, the new contents are copied into
+  it and the old contents are those kept alive by CS_retire.
+  Returns SUCCESS, or MEMORY_ERROR if the new contents could not be
+  stored, in which case oNfNode is unchanged and *ppvOldContents is
+  NULL.
+*/
+int NodeF_replaceContents(NodeF_T oNfNode, void *pvNewContents,
+                          size_t ulNewLength, void **ppvOldContents);
 
 /*
   Returns a string representation for oNfNode, or NULL if
@@ -69,4 +101,49 @@ size_t NodeF_replaceLength(NodeF_T oNfNode, size_t ulNewLength);
 */
 char *NodeF_toString(NodeF_T oNfNode);
 
+/*
+  Returns the address of oNfNode's attribute set (which holds NULL if
+  the node has no attributes), for use with the Attrs_ functions.
+*/
+Attrs_T *NodeF_getAttrs(NodeF_T oNfNode);
+
+/* Returns oNfNode's identifier in the text index, or 0 if it is not
+   indexed. */
+size_t NodeF_getTextId(NodeF_T oNfNode);
+
+/* Sets oNfNode's identifier in the text index to ulTextId. */
+void NodeF_setTextId(NodeF_T oNfNode, size_t ulTextId);
+
+/*
+  Returns the address of oNfNode's recency list links, for use by the
+  file cache.
+*/
+struct NodeFLinks *NodeF_getLinks(NodeF_T oNfNode);
+
+/*
+  Returns the address of oNfNode's expiry record, for use by the timer
+  wheel.
+*/
+struct NodeFTimer *NodeF_getTimer(NodeF_T oNfNode);
+
+/*
+  Returns the address of oNfNode's access heat word, for use with the
+  Heat_ functions.
+*/
+unsigned long *NodeF_getHeat(NodeF_T oNfNode);
+
+/* Returns the checksum recorded for oNfNode's contents, or 0 if none
+   has been. */
+unsigned long NodeF_getChecksum(NodeF_T oNfNode);
+
+/* Records ulChecksum as the checksum of oNfNode's contents. */
+void NodeF_setChecksum(NodeF_T oNfNode, unsigned long ulChecksum);
+
+/* Returns oNfNode's slot in the handle table, or 0 if it has no open
+   handle. */
+size_t NodeF_getHandle(NodeF_T oNfNode);
+
+/* Sets oNfNode's slot in the handle table to ulHandle. */
+void NodeF_setHandle(NodeF_T oNfNode, size_t ulHandle);
+
 #endif
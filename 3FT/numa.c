@@ -0,0 +1,211 @@
+/*--------------------------------------------------------------------*/
+/* numa.c                                                             */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/* sched_getcpu, sched_setaffinity and syscall are GNU extensions, and
+   mmap and pthread_once are POSIX; none are C90 */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#include "numa.h"
+
+/* CPUs and nodes the module can tell apart */
+enum { MAX_CPUS = 4096 };
+enum { MAX_NODES = sizeof(unsigned long) * CHAR_BIT };
+
+/* Longest line read from a /sys file */
+enum { MAX_LINE = 4096 };
+
+/* mbind's mode that prefers a node but falls back to others, from
+   linux/mempolicy.h */
+enum { NUMA_MPOL_PREFERRED = 1 };
+
+/* Number of nodes */
+static int iNodes = 1;
+
+/* The node of each CPU */
+static unsigned char aucCpuNode[MAX_CPUS];
+
+/* Ensures the topology is read once */
+static pthread_once_t sOnce = PTHREAD_ONCE_INIT;
+
+/*--------------------------------------------------------------------*/
+
+/* Reads the first line of the file named pcFile into pcLine, of
+   MAX_LINE bytes. Returns TRUE if successful, FALSE if not. */
+static boolean Numa_readLine(const char *pcFile, char *pcLine) {
+   FILE *psFile;
+   boolean bIsOk;
+
+   psFile = fopen(pcFile, "r");
+   if(psFile == NULL)
+      return FALSE;
+   bIsOk = (boolean) (fgets(pcLine, MAX_LINE, psFile) != NULL);
+   fclose(psFile);
+   return bIsOk;
+}
+
+/*
+  Calls (*pfApply)(n, pvExtra) for each number n in pcList, a list in
+  the form of /sys/devices/system/node/online: numbers and ranges
+  ("0-3,8-11") separated by commas. Returns FALSE if pcList is not in
+  that form, TRUE otherwise.
+*/
+static boolean Numa_forEach(const char *pcList,
+                            void (*pfApply)(long lN, void *pvExtra),
+                            void *pvExtra) {
+   char *pcEnd;
+   long lLo, lHi;
+
+   while(*pcList != '\0' && *pcList != '\n') {
+      lLo = strtol(pcList, &pcEnd, 10);
+      if(pcEnd == pcList || lLo < 0)
+         return FALSE;
+      lHi = lLo;
+      if(*pcEnd == '-') {
+         pcList = pcEnd + 1;
+         lHi = strtol(pcList, &pcEnd, 10);
+         if(pcEnd == pcList || lHi < lLo)
+            return FALSE;
+      }
+      for(; lLo <= lHi; lLo++)
+         (*pfApply)(lLo, pvExtra);
+      pcList = pcEnd;
+      if(*pcList == ',')
+         pcList++;
+   }
+   return TRUE;
+}
+
+/* Raises iNodes to include node lNode. pvExtra is unused. */
+static void Numa_countNode(long lNode, void *pvExtra) {
+   (void) pvExtra;
+   if(lNode < MAX_NODES && lNode + 1 > iNodes)
+      iNodes = (int) lNode + 1;
+}
+
+/* Records that CPU lCpu is on node *(int *) pvExtra. */
+static void Numa_placeCpu(long lCpu, void *pvExtra) {
+   if(lCpu < MAX_CPUS)
+      aucCpuNode[lCpu] = (unsigned char) *(int *) pvExtra;
+}
+
+/* Reads the nodes and their CPUs, leaving one node with every CPU if
+   they cannot be read. */
+static void Numa_readTopology(void) {
+   char acLine[MAX_LINE];
+   char acFile[64];
+   int iNode, i;
+
+   if(!Numa_readLine("/sys/devices/system/node/online", acLine) ||
+      !Numa_forEach(acLine, Numa_countNode, NULL))
+      iNodes = 1;
+   for(iNode = 0; iNode < iNodes && iNodes > 1; iNode++) {
+      sprintf(acFile, "/sys/devices/system/node/node%d/cpulist",
+              iNode);
+      /* A node in the list with no CPUs (memory only) is skipped */
+      if(Numa_readLine(acFile, acLine) &&
+         !Numa_forEach(acLine, Numa_placeCpu, &iNode)) {
+         iNodes = 1;
+         for(i = 0; i < MAX_CPUS; i++)
+            aucCpuNode[i] = 0;
+      }
+   }
+}
+
+/* Reads the topology if no call has yet. */
+static void Numa_init(void) {
+   (void) pthread_once(&sOnce, Numa_readTopology);
+}
+
+/* ================================================================== */
+int Numa_nodeCount(void) {
+   Numa_init();
+   return iNodes;
+}
+
+/* ================================================================== */
+int Numa_currentNode(void) {
+#if defined(__linux__)
+   int iCpu;
+
+   Numa_init();
+   if(iNodes == 1)
+      return 0;
+   iCpu = sched_getcpu();
+   if(iCpu < 0 || iCpu >= MAX_CPUS)
+      return 0;
+   return aucCpuNode[iCpu];
+#else
+   return 0;
+#endif
+}
+
+/* ================================================================== */
+boolean Numa_pinToNode(int iNode) {
+#if defined(__linux__)
+   cpu_set_t sCpus;
+   boolean bAny = FALSE;
+   int iCpu;
+
+   Numa_init();
+   assert(iNode >= 0 && iNode < iNodes);
+
+   CPU_ZERO(&sCpus);
+   for(iCpu = 0; iCpu < MAX_CPUS && iCpu < CPU_SETSIZE; iCpu++)
+      if(aucCpuNode[iCpu] == iNode) {
+         CPU_SET(iCpu, &sCpus);
+         bAny = TRUE;
+      }
+   /* A single node keeps every CPU, rather than only those known */
+   if(!bAny || iNodes == 1)
+      return (boolean) (iNodes == 1);
+   return (boolean) (sched_setaffinity(0, sizeof(sCpus), &sCpus) == 0);
+#else
+   (void) iNode;
+   return FALSE;
+#endif
+}
+
+/* ================================================================== */
+void *Numa_alloc(size_t ulSize, int iNode) {
+   void *pvBlock;
+
+   assert(ulSize > 0);
+
+   Numa_init();
+   assert(iNode >= 0 && iNode < iNodes);
+
+   pvBlock = mmap(NULL, ulSize, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(pvBlock == MAP_FAILED)
+      return NULL;
+#if defined(__linux__) && defined(SYS_mbind)
+   /* Pages are placed when first touched, so the preference set now
+      holds for all of them; if it fails they land where they may */
+   if(iNodes > 1) {
+      unsigned long ulMask = 1UL << iNode;
+
+      (void) syscall(SYS_mbind, pvBlock, ulSize, NUMA_MPOL_PREFERRED,
+                     &ulMask, sizeof(ulMask) * CHAR_BIT, 0);
+   }
+#endif
+   return pvBlock;
+}
+
+/* ================================================================== */
+void Numa_free(void *pvBlock, size_t ulSize) {
+   if(pvBlock != NULL)
+      (void) munmap(pvBlock, ulSize);
+}
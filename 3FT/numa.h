@@ -0,0 +1,47 @@
+/*--------------------------------------------------------------------*/
+/* numa.h                                                             */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef NUMA_INCLUDED
+#define NUMA_INCLUDED
+
+/*
+  The NUMA module tells which memory node the calling thread runs on,
+  pins threads to a node's CPUs, and maps memory preferring a node,
+  as libnuma does, but straight from the Linux system calls and
+  /sys/devices/system/node, so that nothing more need be installed.
+  Where that information or those calls are missing (another system,
+  or a container hiding /sys), the machine is taken to be one node:
+  every thread is on node 0, pinning to it leaves threads where they
+  were, and memory is mapped without preference.
+
+  The topology is read once, by whichever call comes first.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+
+/* Returns the number of memory nodes, at least 1. */
+int Numa_nodeCount(void);
+
+/* Returns the node of the CPU the calling thread is running on, from
+   0 to Numa_nodeCount() - 1. */
+int Numa_currentNode(void);
+
+/* Restricts the calling thread to the CPUs of node iNode (on one node,
+   to any CPU). Returns TRUE if successful, FALSE if not, leaving it
+   where it may run. */
+boolean Numa_pinToNode(int iNode);
+
+/*
+  Returns ulSize bytes of zeroed, page-aligned memory whose pages are
+  placed on node iNode where the kernel can, or NULL if insufficient
+  memory is available.
+*/
+void *Numa_alloc(size_t ulSize, int iNode);
+
+/* Frees pvBlock, ulSize bytes from Numa_alloc. */
+void Numa_free(void *pvBlock, size_t ulSize);
+
+#endif
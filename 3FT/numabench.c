@@ -0,0 +1,136 @@
+/*--------------------------------------------------------------------*/
+/* numabench.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  numabench measures lookups from each NUMA node with and without
+  replicas of the top levels of the tree.
+
+  Usage: numabench [-n files] [-w fanout] [-k levels] [-l lookups]
+
+  It builds a tree of n files numabench/aI/bJ/cK/fL, w to a directory,
+  with its memory on node 0, from a thread pinned there. Then, from a
+  thread pinned to each node in turn, it looks up l random files
+  without replicas and again with the top k levels replicated, and
+  reports nanoseconds per lookup. On a machine with one node (or where
+  pinning is not possible) it still runs, and measures what the
+  replicas save by skipping levels.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "a4def.h"
+#include "numa.h"
+#include "poolalloc.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Contents of every file; the FT only keeps a pointer to it */
+static char cContents = 'x';
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Looks up the ulLookups files of ppcPaths named by pulOrder, and
+  returns the nanoseconds each took on average, or a negative number
+  if one was not found.
+*/
+static double NumaBench_lookups(char **ppcPaths, const size_t *pulOrder,
+                                size_t ulLookups) {
+   double dStart;
+   size_t i;
+
+   dStart = Bench_now();
+   for(i = 0; i < ulLookups; i++)
+      if(!FT_containsFile(ppcPaths[pulOrder[i]]))
+         return -1.0;
+   return (Bench_now() - dStart) * 1e9 / (double) ulLookups;
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 200000, ulFanout = 16, ulLevels = 3;
+   size_t ulLookups = 1000000;
+   double dPlain, dReplicated;
+   PoolAlloc_T oPool;
+   char **ppcPaths;
+   size_t *pulOrder;
+   unsigned long ulSeed = 217;
+   size_t i;
+   int iNode, iNodes;
+   boolean bPinned;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'w', "fanout", &ulFanout, FALSE },
+      { 'k', "levels", &ulLevels, FALSE },
+      { 'l', "lookups", &ulLookups, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   /* Generate the pathnames, and random files to look up */
+   ppcPaths = malloc(ulFiles * sizeof(char *));
+   pulOrder = malloc(ulLookups * sizeof(size_t));
+   if(ppcPaths == NULL || pulOrder == NULL)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      ppcPaths[i] = malloc(BENCH_MAX_PATH);
+      if(ppcPaths[i] == NULL)
+         return EXIT_FAILURE;
+      sprintf(ppcPaths[i], "numabench/a%lu/b%lu/c%lu/f%lu",
+              (unsigned long) (i / ulFanout / ulFanout / ulFanout),
+              (unsigned long) (i / ulFanout / ulFanout % ulFanout),
+              (unsigned long) (i / ulFanout % ulFanout),
+              (unsigned long) (i % ulFanout));
+   }
+   for(i = 0; i < ulLookups; i++)
+      pulOrder[i] = (Bench_random(&ulSeed) << 24 |
+                     Bench_random(&ulSeed)) % ulFiles;
+
+   /* Build the tree on node 0 */
+   iNodes = Numa_nodeCount();
+   bPinned = Numa_pinToNode(0);
+   oPool = PoolAlloc_newOnNode(0);
+   if(oPool == NULL || FT_initWith(PoolAlloc_getAlloc(oPool)) != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], &cContents, 1) != SUCCESS) {
+         fprintf(stderr, "%s: FT_insertFile failed\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+
+   printf("%d node%s, %lu files, %lu per directory, %lu lookups "
+          "(ns per lookup)\n", iNodes, iNodes == 1 ? "" : "s",
+          (unsigned long) ulFiles, (unsigned long) ulFanout,
+          (unsigned long) ulLookups);
+   printf("%-8s%12s%12s\n", "node", "plain", "replicated");
+   for(iNode = 0; iNode < iNodes; iNode++) {
+      bPinned = (boolean) (Numa_pinToNode(iNode) && bPinned);
+      dPlain = NumaBench_lookups(ppcPaths, pulOrder, ulLookups);
+      if(FT_enableReplicas(ulLevels) != SUCCESS) {
+         fprintf(stderr, "%s: FT_enableReplicas failed\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+      dReplicated = NumaBench_lookups(ppcPaths, pulOrder, ulLookups);
+      (void) FT_enableReplicas(0);
+      if(dPlain < 0 || dReplicated < 0) {
+         fprintf(stderr, "%s: a lookup failed\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+      printf("%-8d%12.1f%12.1f\n", iNode, dPlain, dReplicated);
+   }
+   if(!bPinned)
+      printf("(threads could not be pinned; nodes are nominal)\n");
+
+   (void) FT_destroy();
+   PoolAlloc_free(oPool);
+   for(i = 0; i < ulFiles; i++)
+      free(ppcPaths[i]);
+   free(ppcPaths);
+   free(pulOrder);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,449 @@
+/*--------------------------------------------------------------------*/
+/* orderiter.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "dynarray.h"
+#include "orderiter.h"
+
+/*
+  One level of the iteration. Within a directory, three sorted streams
+  are merged: the file children, the directory children (each reported
+  as an entry with key "dir"), and the directory children's subtrees
+  (each entered at key "dir/"). The last stream walks the directory
+  children in pathname order too, but a child that another extends
+  with a character below '/' (as "b.c" extends "b") sorts after it
+  once '/' is appended, so such children are deferred on a stack until
+  the children extending them have been entered.
+*/
+struct iterFrame {
+   /* Directory whose children are merged, or NULL for the level
+      holding only the root */
+   NodeD_T oNdDir;
+
+   /* Next file child to report */
+   size_t ulFile;
+
+   /* Next directory child to report as an entry */
+   size_t ulDir;
+
+   /* Next directory child to consider as a subtree */
+   size_t ulSub;
+
+   /* Length of the iterator's deferred stack below this frame's
+      part */
+   size_t ulDeferred;
+};
+
+/* An iterator is a stack of frames, the innermost on top */
+struct orderIter {
+   /* Root of the tree being iterated */
+   NodeD_T oNdRoot;
+
+   /* Lower bound applied to each new frame, or NULL once an entry not
+      less than it has been reported */
+   char *pcLo;
+
+   /* The frames, ulDepth of them, with room for ulRoom */
+   struct iterFrame *psFrames;
+   size_t ulDepth;
+   size_t ulRoom;
+
+   /* The directories each frame has deferred, each frame's above its
+      parent's; within a frame, each extends the one below it */
+   DynArray_T oDDeferred;
+};
+
+/* Number of frames a new iterator has room for */
+enum { INITIAL_FRAMES = 16 };
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Compares pcA (followed by a '/' if bSlashA) with pcB (followed by a
+  '/' if bSlashB) lexicographically. Returns <0, 0, or >0 if the first
+  is "less than", "equal to", or "greater than" the second.
+*/
+static int OrderIter_compareKeys(const char *pcA, boolean bSlashA,
+                                 const char *pcB, boolean bSlashB) {
+   unsigned char cA, cB;
+
+   assert(pcA != NULL);
+   assert(pcB != NULL);
+
+   for(;;) {
+      cA = (unsigned char) *pcA;
+      cB = (unsigned char) *pcB;
+      if(cA == '\0' && bSlashA) {
+         cA = '/';
+         bSlashA = FALSE;
+         pcA--;
+      }
+      if(cB == '\0' && bSlashB) {
+         cB = '/';
+         bSlashB = FALSE;
+         pcB--;
+      }
+      if(cA != cB || cA == '\0')
+         return (int) cA - (int) cB;
+      pcA++;
+      pcB++;
+   }
+}
+
+/* Returns TRUE if pcName is the first ulPrefixLen characters of
+   pcPrefix followed by a character below '/', FALSE otherwise. */
+static boolean OrderIter_extendsBelowSlash(const char *pcPrefix,
+                                           size_t ulPrefixLen,
+                                           const char *pcName) {
+   assert(pcPrefix != NULL);
+   assert(pcName != NULL);
+
+   return (boolean) (strncmp(pcPrefix, pcName, ulPrefixLen) == 0 &&
+                     pcName[ulPrefixLen] != '\0' &&
+                     (unsigned char) pcName[ulPrefixLen] < '/');
+}
+
+/* Returns the pathname of directory oNdDir. */
+static const char *OrderIter_dirName(NodeD_T oNdDir) {
+   assert(oNdDir != NULL);
+
+   return Path_getPathname(NodeD_getPath(oNdDir));
+}
+
+/* Returns the number of directory children in frame psFrame. */
+static size_t OrderIter_numDirs(struct iterFrame *psFrame,
+                                NodeD_T oNdRoot) {
+   assert(psFrame != NULL);
+
+   if(psFrame->oNdDir == NULL)
+      return oNdRoot == NULL ? 0 : 1;
+   return NodeD_getNumDirChildren(psFrame->oNdDir);
+}
+
+/* Returns the directory child with index ulIndex in frame psFrame. */
+static NodeD_T OrderIter_getDir(struct iterFrame *psFrame,
+                                NodeD_T oNdRoot, size_t ulIndex) {
+   NodeD_T oNdChild = NULL;
+
+   assert(psFrame != NULL);
+
+   if(psFrame->oNdDir == NULL)
+      return oNdRoot;
+   (void) NodeD_getDirChild(psFrame->oNdDir, ulIndex, &oNdChild);
+   return oNdChild;
+}
+
+/* Returns the pathname of the file child with index ulIndex in frame
+   psFrame. */
+static const char *OrderIter_getFileName(struct iterFrame *psFrame,
+                                         size_t ulIndex) {
+   NodeF_T oNfChild = NULL;
+
+   assert(psFrame != NULL);
+   assert(psFrame->oNdDir != NULL);
+
+   (void) NodeD_getFileChild(psFrame->oNdDir, ulIndex, &oNfChild);
+   return Path_getPathname(NodeF_getPath(oNfChild));
+}
+
+/* Returns the index of the first directory child of psFrame whose
+   pathname is not less than the first ulLength characters of pcLo. */
+static size_t OrderIter_findDir(OrderIter_T oIIter,
+                                struct iterFrame *psFrame,
+                                const char *pcLo, size_t ulLength) {
+   size_t ulLow = 0, ulHigh, ulMid;
+
+   assert(oIIter != NULL);
+   assert(psFrame != NULL);
+   assert(pcLo != NULL);
+
+   ulHigh = OrderIter_numDirs(psFrame, oIIter->oNdRoot);
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      if(strncmp(OrderIter_dirName(OrderIter_getDir(
+                    psFrame, oIIter->oNdRoot, ulMid)),
+                 pcLo, ulLength) < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   return ulLow;
+}
+
+/*
+  Positions every stream of psFrame at its first entry not less than
+  pcLo. A subtree whose key is less than pcLo is still entered if pcLo
+  lies inside it, since some of its entries may follow pcLo. Returns
+  SUCCESS, or MEMORY_ERROR if allocation fails.
+*/
+static int OrderIter_seek(OrderIter_T oIIter,
+                          struct iterFrame *psFrame,
+                          const char *pcLo) {
+   size_t ulLow, ulHigh, ulMid, ulLength, ulLoLength;
+   NodeD_T oNdChild;
+
+   assert(oIIter != NULL);
+   assert(psFrame != NULL);
+   assert(pcLo != NULL);
+
+   ulLoLength = strlen(pcLo);
+
+   /* Binary search the file children */
+   ulLow = 0;
+   ulHigh = psFrame->oNdDir == NULL ? 0 :
+            NodeD_getNumFileChildren(psFrame->oNdDir);
+   while(ulLow < ulHigh) {
+      ulMid = ulLow + (ulHigh - ulLow) / 2;
+      if(strcmp(OrderIter_getFileName(psFrame, ulMid), pcLo) < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   psFrame->ulFile = ulLow;
+
+   /* Binary search the directory children as entries; as subtrees,
+      those not less than pcLo come next too */
+   psFrame->ulDir = OrderIter_findDir(oIIter, psFrame, pcLo,
+                                      ulLoLength + 1);
+   psFrame->ulSub = psFrame->ulDir;
+
+   /* A child less than pcLo has its subtree before pcLo, unless pcLo
+      extends its name with a character up to '/'; those children are
+      prefixes of each other, so they are deferred shortest first */
+   for(ulLength = 1; ulLength < ulLoLength; ulLength++) {
+      if((unsigned char) pcLo[ulLength] > '/')
+         continue;
+      ulLow = OrderIter_findDir(oIIter, psFrame, pcLo, ulLength);
+      if(ulLow == psFrame->ulDir)
+         continue;
+      oNdChild = OrderIter_getDir(psFrame, oIIter->oNdRoot, ulLow);
+      if(strncmp(OrderIter_dirName(oNdChild), pcLo, ulLength) != 0 ||
+         OrderIter_dirName(oNdChild)[ulLength] != '\0')
+         continue;
+      if(!DynArray_add(oIIter->oDDeferred, oNdChild))
+         return MEMORY_ERROR;
+   }
+   return SUCCESS;
+}
+
+/*
+  Pushes a new frame for directory oNdDir (NULL for the root level)
+  onto oIIter's stack, positioned at the iterator's lower bound.
+  Returns SUCCESS, or MEMORY_ERROR if allocation fails.
+*/
+static int OrderIter_push(OrderIter_T oIIter, NodeD_T oNdDir) {
+   struct iterFrame *psFrame, *psFrames;
+   int iStatus;
+
+   assert(oIIter != NULL);
+
+   if(oIIter->ulDepth == oIIter->ulRoom) {
+      psFrames = realloc(oIIter->psFrames, 2 * oIIter->ulRoom *
+                         sizeof(struct iterFrame));
+      if(psFrames == NULL)
+         return MEMORY_ERROR;
+      oIIter->psFrames = psFrames;
+      oIIter->ulRoom *= 2;
+   }
+
+   psFrame = &oIIter->psFrames[oIIter->ulDepth];
+   psFrame->oNdDir = oNdDir;
+   psFrame->ulFile = 0;
+   psFrame->ulDir = 0;
+   psFrame->ulSub = 0;
+   psFrame->ulDeferred = DynArray_getLength(oIIter->oDDeferred);
+
+   if(oIIter->pcLo != NULL) {
+      iStatus = OrderIter_seek(oIIter, psFrame, oIIter->pcLo);
+      if(iStatus != SUCCESS) {
+         while(DynArray_getLength(oIIter->oDDeferred) >
+               psFrame->ulDeferred)
+            (void) DynArray_removeAt(oIIter->oDDeferred,
+                        DynArray_getLength(oIIter->oDDeferred) - 1);
+         return iStatus;
+      }
+   }
+   oIIter->ulDepth++;
+   return SUCCESS;
+}
+
+/* Pops the top frame of oIIter's stack. */
+static void OrderIter_pop(OrderIter_T oIIter) {
+   assert(oIIter != NULL);
+   assert(oIIter->ulDepth != 0);
+
+   oIIter->ulDepth--;
+   assert(DynArray_getLength(oIIter->oDDeferred) ==
+          oIIter->psFrames[oIIter->ulDepth].ulDeferred);
+}
+
+/*
+  Stores in *poNdSub the next subtree of psFrame, the top frame of
+  oIIter, to enter, or NULL if there is none, without taking it.
+  Children are deferred until the next one does not extend the last
+  deferred. Returns SUCCESS, or MEMORY_ERROR if allocation fails.
+*/
+static int OrderIter_peekSub(OrderIter_T oIIter,
+                             struct iterFrame *psFrame,
+                             NodeD_T *poNdSub) {
+   NodeD_T oNdTop, oNdNext;
+   size_t ulTop;
+
+   assert(oIIter != NULL);
+   assert(psFrame != NULL);
+   assert(poNdSub != NULL);
+
+   for(;;) {
+      ulTop = DynArray_getLength(oIIter->oDDeferred);
+      oNdTop = ulTop > psFrame->ulDeferred ?
+               DynArray_get(oIIter->oDDeferred, ulTop - 1) : NULL;
+      if(psFrame->ulSub == OrderIter_numDirs(psFrame, oIIter->oNdRoot))
+         break;
+      oNdNext = OrderIter_getDir(psFrame, oIIter->oNdRoot,
+                                 psFrame->ulSub);
+      if(oNdTop != NULL &&
+         !OrderIter_extendsBelowSlash(OrderIter_dirName(oNdTop),
+               strlen(OrderIter_dirName(oNdTop)),
+               OrderIter_dirName(oNdNext)))
+         break;
+      if(!DynArray_add(oIIter->oDDeferred, oNdNext))
+         return MEMORY_ERROR;
+      psFrame->ulSub++;
+   }
+   *poNdSub = oNdTop;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int OrderIter_new(NodeD_T oNdRoot, const char *pcLo,
+                  OrderIter_T *poIResult) {
+   OrderIter_T oINew;
+   int iStatus;
+
+   assert(poIResult != NULL);
+
+   oINew = calloc(1, sizeof(struct orderIter));
+   if(oINew == NULL) {
+      *poIResult = NULL;
+      return MEMORY_ERROR;
+   }
+   oINew->oNdRoot = oNdRoot;
+
+   /* Keep a private copy of the lower bound */
+   if(pcLo != NULL) {
+      oINew->pcLo = malloc(strlen(pcLo) + 1);
+      if(oINew->pcLo == NULL) {
+         free(oINew);
+         *poIResult = NULL;
+         return MEMORY_ERROR;
+      }
+      strcpy(oINew->pcLo, pcLo);
+   }
+
+   oINew->psFrames = malloc(INITIAL_FRAMES * sizeof(struct iterFrame));
+   oINew->ulRoom = INITIAL_FRAMES;
+   oINew->oDDeferred = DynArray_new(0);
+   if(oINew->psFrames == NULL || oINew->oDDeferred == NULL) {
+      OrderIter_free(oINew);
+      *poIResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   /* The outermost level holds only the root */
+   iStatus = OrderIter_push(oINew, NULL);
+   if(iStatus != SUCCESS) {
+      OrderIter_free(oINew);
+      *poIResult = NULL;
+      return iStatus;
+   }
+
+   *poIResult = oINew;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int OrderIter_next(OrderIter_T oIIter, const char **ppcPath,
+                   boolean *pbIsFile) {
+   struct iterFrame *psFrame;
+   const char *pcFile, *pcDir, *pcSub;
+   NodeD_T oNdSub;
+   int iStatus;
+
+   assert(oIIter != NULL);
+   assert(ppcPath != NULL);
+   assert(pbIsFile != NULL);
+
+   while(oIIter->ulDepth != 0) {
+      psFrame = &oIIter->psFrames[oIIter->ulDepth - 1];
+
+      /* Heads of the three streams, NULL once exhausted */
+      pcFile = NULL;
+      if(psFrame->oNdDir != NULL && psFrame->ulFile <
+         NodeD_getNumFileChildren(psFrame->oNdDir))
+         pcFile = OrderIter_getFileName(psFrame, psFrame->ulFile);
+      pcDir = NULL;
+      if(psFrame->ulDir < OrderIter_numDirs(psFrame, oIIter->oNdRoot))
+         pcDir = OrderIter_dirName(OrderIter_getDir(
+                    psFrame, oIIter->oNdRoot, psFrame->ulDir));
+      iStatus = OrderIter_peekSub(oIIter, psFrame, &oNdSub);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      pcSub = oNdSub == NULL ? NULL : OrderIter_dirName(oNdSub);
+
+      /* Directory exhausted: resume its parent */
+      if(pcFile == NULL && pcDir == NULL && pcSub == NULL) {
+         OrderIter_pop(oIIter);
+         continue;
+      }
+
+      /* Enter the subtree if its key precedes both entries */
+      if(pcSub != NULL &&
+         (pcFile == NULL ||
+          OrderIter_compareKeys(pcSub, TRUE, pcFile, FALSE) < 0) &&
+         (pcDir == NULL ||
+          OrderIter_compareKeys(pcSub, TRUE, pcDir, FALSE) < 0)) {
+         (void) DynArray_removeAt(oIIter->oDDeferred,
+                     DynArray_getLength(oIIter->oDDeferred) - 1);
+         iStatus = OrderIter_push(oIIter, oNdSub);
+         if(iStatus != SUCCESS) {
+            /* Leave the subtree to be entered next time */
+            (void) DynArray_add(oIIter->oDDeferred, oNdSub);
+            return iStatus;
+         }
+         continue;
+      }
+
+      /* Otherwise report the smaller of the file and directory heads */
+      if(pcDir == NULL || (pcFile != NULL && strcmp(pcFile, pcDir) < 0)) {
+         psFrame->ulFile++;
+         *ppcPath = pcFile;
+         *pbIsFile = TRUE;
+      }
+      else {
+         psFrame->ulDir++;
+         *ppcPath = pcDir;
+         *pbIsFile = FALSE;
+      }
+
+      /* Every entry from now on follows the bound */
+      free(oIIter->pcLo);
+      oIIter->pcLo = NULL;
+      return SUCCESS;
+   }
+   return NO_SUCH_PATH;
+}
+
+/* ================================================================== */
+void OrderIter_free(OrderIter_T oIIter) {
+   assert(oIIter != NULL);
+
+   if(oIIter->oDDeferred != NULL)
+      DynArray_free(oIIter->oDDeferred);
+   free(oIIter->psFrames);
+   free(oIIter->pcLo);
+   free(oIIter);
+}
@@ -0,0 +1,53 @@
+/*--------------------------------------------------------------------*/
+/* orderiter.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef ORDERITER_INCLUDED
+#define ORDERITER_INCLUDED
+
+/*
+  An ordered iterator visits the directories and files of a tree in
+  plain lexicographic (strcmp) order of their absolute pathnames, which
+  differs from the depth-first FT_toString order whenever a component
+  contains a character that sorts before '/' (e.g. "a/b" < "a/b.c" <
+  "a/b/c"). It merges each directory's file and directory children on
+  the fly and can start at any lower bound without visiting the entries
+  before it.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "noded.h"
+
+/* An OrderIter_T is a position in the ordered sequence of entries */
+typedef struct orderIter *OrderIter_T;
+
+/*
+  Creates an iterator over the tree rooted at oNdRoot (which may be
+  NULL for an empty tree) positioned at the first entry whose pathname
+  is not less than pcLo, or at the first entry if pcLo is NULL.
+  Returns SUCCESS and sets *poIResult to the new iterator if
+  successful. Otherwise, sets *poIResult to NULL and returns
+  MEMORY_ERROR.
+
+  The iterator is invalidated by any change to the tree.
+*/
+int OrderIter_new(NodeD_T oNdRoot, const char *pcLo,
+                  OrderIter_T *poIResult);
+
+/*
+  Advances oIIter, storing the next entry's pathname in *ppcPath and
+  whether it is a file in *pbIsFile. The pathname is owned by the tree.
+  Returns SUCCESS if an entry was produced. Otherwise, leaves *ppcPath
+  and *pbIsFile unchanged and returns:
+  * NO_SUCH_PATH if there are no entries left
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int OrderIter_next(OrderIter_T oIIter, const char **ppcPath,
+                   boolean *pbIsFile);
+
+/* Destroys oIIter and frees all memory allocated for it. */
+void OrderIter_free(OrderIter_T oIIter);
+
+#endif
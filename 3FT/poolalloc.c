@@ -0,0 +1,304 @@
+/*--------------------------------------------------------------------*/
+/* poolalloc.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "a4def.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "poolalloc.h"
+
+/* Bytes in each slab, unless the slabs are huge pages */
+enum { SLAB_SIZE = 64 * 1024 };
+
+/* Spacing of the small classes, and so the alignment of every block */
+enum { GRAIN = 16 };
+
+/* Largest small class; the classes up to it are GRAIN apart */
+enum { SMALL_MAX = 256 };
+
+/* Number of small classes */
+enum { SMALL_CLASSES = SMALL_MAX / GRAIN };
+
+/* Sizes of the classes above SMALL_MAX, each a multiple of GRAIN */
+static const size_t aulLargeSizes[] = { 384, 512, 768, 1024 };
+
+/* Number of classes above SMALL_MAX */
+enum { LARGE_CLASSES =
+          sizeof(aulLargeSizes) / sizeof(aulLargeSizes[0]) };
+
+/* Number of classes */
+enum { NUM_CLASSES = SMALL_CLASSES + LARGE_CLASSES };
+
+/* The start of a slab, linking the pool's slabs; padded to GRAIN so
+   that the blocks after it are aligned */
+union slabHeader {
+   union slabHeader *psNext;
+   char acPad[GRAIN];
+};
+
+/* A free block, linked through its first bytes */
+struct freeBlock {
+   struct freeBlock *psNext;
+};
+
+/* The pool */
+struct poolAlloc {
+   /* The allocator handed out, whose state is the pool itself */
+   struct Alloc sAlloc;
+
+   /* Free blocks of each class */
+   struct freeBlock *apsFree[NUM_CLASSES];
+
+   /* Every slab, newest first */
+   union slabHeader *psSlabs;
+
+   /* The part of the newest slab not yet carved */
+   char *pcNext;
+   char *pcEnd;
+
+   /* Slabs obtained and bytes of slab blocks in use */
+   size_t ulSlabs;
+   size_t ulBytesInUse;
+
+   /* The node the slabs are placed on, or -1 to take them from malloc */
+   int iNode;
+
+   /* Whether the slabs are huge pages, their size, and how many of
+      them are not mapped as ordinary pages */
+   boolean bHuge;
+   size_t ulSlabSize;
+   size_t ulHugeSlabs;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the class of blocks of ulSize bytes, or -1 if they are too
+   large for any class. */
+static int PoolAlloc_classOf(size_t ulSize) {
+   int i;
+
+   if(ulSize <= SMALL_MAX)
+      return ulSize == 0 ? 0 : (int) ((ulSize - 1) / GRAIN);
+   for(i = 0; i < LARGE_CLASSES; i++)
+      if(ulSize <= aulLargeSizes[i])
+         return SMALL_CLASSES + i;
+   return -1;
+}
+
+/* Returns the size of the blocks of class iClass. */
+static size_t PoolAlloc_classSize(int iClass) {
+   assert(iClass >= 0 && iClass < NUM_CLASSES);
+
+   if(iClass < SMALL_CLASSES)
+      return (size_t) (iClass + 1) * GRAIN;
+   return aulLargeSizes[iClass - SMALL_CLASSES];
+}
+
+/* Puts the rest of oPool's newest slab on the free lists, in the
+   largest blocks that fit, so that it is not lost to a new slab. */
+static void PoolAlloc_retireTail(PoolAlloc_T oPool) {
+   struct freeBlock *psBlock;
+   size_t ulLeft;
+   int iClass;
+
+   ulLeft = (size_t) (oPool->pcEnd - oPool->pcNext);
+   iClass = NUM_CLASSES - 1;
+   while(ulLeft >= GRAIN) {
+      while(PoolAlloc_classSize(iClass) > ulLeft)
+         iClass--;
+      psBlock = (struct freeBlock *) oPool->pcNext;
+      psBlock->psNext = oPool->apsFree[iClass];
+      oPool->apsFree[iClass] = psBlock;
+      oPool->pcNext += PoolAlloc_classSize(iClass);
+      ulLeft -= PoolAlloc_classSize(iClass);
+   }
+}
+
+/* Returns a block of class iClass carved from oPool's newest slab,
+   starting a new slab if it is used up, or NULL if a new one is
+   needed and cannot be allocated. */
+static void *PoolAlloc_carve(PoolAlloc_T oPool, int iClass) {
+   size_t ulSize = PoolAlloc_classSize(iClass);
+   union slabHeader *psSlab;
+   enum HugePageKind eKind;
+   void *pvBlock;
+
+   if((size_t) (oPool->pcEnd - oPool->pcNext) < ulSize) {
+      if(oPool->bHuge) {
+         psSlab = HugePage_alloc(oPool->ulSlabSize, &eKind);
+         if(psSlab != NULL && eKind != HUGEPAGE_NONE)
+            oPool->ulHugeSlabs++;
+      }
+      else if(oPool->iNode < 0)
+         psSlab = malloc(oPool->ulSlabSize);
+      else
+         psSlab = Numa_alloc(oPool->ulSlabSize, oPool->iNode);
+      if(psSlab == NULL)
+         return NULL;
+      PoolAlloc_retireTail(oPool);
+      psSlab->psNext = oPool->psSlabs;
+      oPool->psSlabs = psSlab;
+      oPool->ulSlabs++;
+      oPool->pcNext = (char *) (psSlab + 1);
+      oPool->pcEnd = (char *) psSlab + oPool->ulSlabSize;
+   }
+   pvBlock = oPool->pcNext;
+   oPool->pcNext += ulSize;
+   return pvBlock;
+}
+
+/* Returns a block of ulSize bytes from pool pvState, or NULL. */
+static void *PoolAlloc_alloc(void *pvState, size_t ulSize) {
+   PoolAlloc_T oPool = pvState;
+   struct freeBlock *psBlock;
+   int iClass;
+
+   assert(oPool != NULL);
+
+   iClass = PoolAlloc_classOf(ulSize);
+   if(iClass < 0)
+      return malloc(ulSize);
+
+   psBlock = oPool->apsFree[iClass];
+   if(psBlock != NULL)
+      oPool->apsFree[iClass] = psBlock->psNext;
+   else {
+      psBlock = PoolAlloc_carve(oPool, iClass);
+      if(psBlock == NULL)
+         return NULL;
+   }
+   oPool->ulBytesInUse += PoolAlloc_classSize(iClass);
+   return psBlock;
+}
+
+/* Gives pvBlock, of ulSize bytes, back to pool pvState. */
+static void PoolAlloc_release(void *pvState, void *pvBlock,
+                              size_t ulSize) {
+   PoolAlloc_T oPool = pvState;
+   struct freeBlock *psBlock = pvBlock;
+   int iClass;
+
+   assert(oPool != NULL);
+   assert(pvBlock != NULL);
+
+   iClass = PoolAlloc_classOf(ulSize);
+   if(iClass < 0) {
+      free(pvBlock);
+      return;
+   }
+
+   assert(oPool->ulBytesInUse >= PoolAlloc_classSize(iClass));
+   oPool->ulBytesInUse -= PoolAlloc_classSize(iClass);
+   psBlock->psNext = oPool->apsFree[iClass];
+   oPool->apsFree[iClass] = psBlock;
+}
+
+/* Resizes pvBlock, from pool pvState, from ulOldSize to ulNewSize
+   bytes; a block that stays in its class is not moved. */
+static void *PoolAlloc_resize(void *pvState, void *pvBlock,
+                              size_t ulOldSize, size_t ulNewSize) {
+   int iOldClass, iNewClass;
+   void *pvNew;
+
+   if(pvBlock == NULL)
+      return PoolAlloc_alloc(pvState, ulNewSize);
+
+   iOldClass = PoolAlloc_classOf(ulOldSize);
+   iNewClass = PoolAlloc_classOf(ulNewSize);
+   if(iOldClass < 0 && iNewClass < 0)
+      return realloc(pvBlock, ulNewSize);
+   if(iOldClass >= 0 && iOldClass == iNewClass)
+      return pvBlock;
+
+   pvNew = PoolAlloc_alloc(pvState, ulNewSize);
+   if(pvNew == NULL)
+      return NULL;
+   memcpy(pvNew, pvBlock, ulOldSize < ulNewSize ? ulOldSize : ulNewSize);
+   PoolAlloc_release(pvState, pvBlock, ulOldSize);
+   return pvNew;
+}
+
+/* ================================================================== */
+PoolAlloc_T PoolAlloc_new(void) {
+   return PoolAlloc_newOnNode(-1);
+}
+
+/* ================================================================== */
+PoolAlloc_T PoolAlloc_newOnNode(int iNode) {
+   PoolAlloc_T oPool;
+   int i;
+
+   oPool = malloc(sizeof(struct poolAlloc));
+   if(oPool == NULL)
+      return NULL;
+
+   oPool->sAlloc.pfAlloc = PoolAlloc_alloc;
+   oPool->sAlloc.pfRealloc = PoolAlloc_resize;
+   oPool->sAlloc.pfFree = PoolAlloc_release;
+   oPool->sAlloc.pvState = oPool;
+   for(i = 0; i < NUM_CLASSES; i++)
+      oPool->apsFree[i] = NULL;
+   oPool->psSlabs = NULL;
+   oPool->pcNext = NULL;
+   oPool->pcEnd = NULL;
+   oPool->ulSlabs = 0;
+   oPool->ulBytesInUse = 0;
+   oPool->iNode = iNode;
+   oPool->bHuge = FALSE;
+   oPool->ulSlabSize = SLAB_SIZE;
+   oPool->ulHugeSlabs = 0;
+   return oPool;
+}
+
+/* ================================================================== */
+PoolAlloc_T PoolAlloc_newHuge(void) {
+   PoolAlloc_T oPool;
+
+   oPool = PoolAlloc_newOnNode(-1);
+   if(oPool == NULL)
+      return NULL;
+   oPool->bHuge = TRUE;
+   oPool->ulSlabSize = HUGE_PAGE_SIZE;
+   return oPool;
+}
+
+/* ================================================================== */
+void PoolAlloc_free(PoolAlloc_T oPool) {
+   union slabHeader *psSlab, *psNext;
+
+   assert(oPool != NULL);
+
+   for(psSlab = oPool->psSlabs; psSlab != NULL; psSlab = psNext) {
+      psNext = psSlab->psNext;
+      if(oPool->bHuge)
+         HugePage_free(psSlab, oPool->ulSlabSize);
+      else if(oPool->iNode < 0)
+         free(psSlab);
+      else
+         Numa_free(psSlab, oPool->ulSlabSize);
+   }
+   free(oPool);
+}
+
+/* ================================================================== */
+Alloc_T PoolAlloc_getAlloc(PoolAlloc_T oPool) {
+   assert(oPool != NULL);
+
+   return &oPool->sAlloc;
+}
+
+/* ================================================================== */
+void PoolAlloc_getStats(PoolAlloc_T oPool,
+                        struct PoolAllocStats *psStats) {
+   assert(oPool != NULL);
+   assert(psStats != NULL);
+
+   psStats->ulSlabs = oPool->ulSlabs;
+   psStats->ulSlabBytes = oPool->ulSlabs * oPool->ulSlabSize;
+   psStats->ulHugeSlabs = oPool->ulHugeSlabs;
+   psStats->ulBytesInUse = oPool->ulBytesInUse;
+}
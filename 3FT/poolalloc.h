@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------*/
+/* poolalloc.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef POOLALLOC_INCLUDED
+#define POOLALLOC_INCLUDED
+
+/*
+  A pool is a size-class allocator for the many small blocks a tree is
+  made of. Requests are rounded up to a class (multiples of 16 bytes
+  up to 256, then 384, 512, 768 and 1024) and carved from 64 KiB slabs
+  obtained from malloc; freed blocks go on a free list per class, so
+  both alloc and free are a few instructions, and no block carries a
+  header, since the caller gives its size back on free. Larger blocks
+  go to malloc. Slabs are returned only when the pool is freed. Like
+  the File Tree, a pool is not locked: its callers must not use it
+  from two threads at once.
+*/
+
+#include <stddef.h>
+#include "alloc.h"
+
+/* A PoolAlloc_T is a size-class allocator */
+typedef struct poolAlloc *PoolAlloc_T;
+
+/* What a pool holds */
+struct PoolAllocStats {
+   /* Slabs obtained and their total size in bytes */
+   size_t ulSlabs;
+   size_t ulSlabBytes;
+   /* Slabs mapped as reserved huge pages or advised to be transparent
+      ones, if the pool's are huge */
+   size_t ulHugeSlabs;
+   /* Bytes of the slab blocks allocated and not yet freed, counted at
+      their class size */
+   size_t ulBytesInUse;
+};
+
+/* Returns a new, empty pool, or NULL if insufficient memory is
+   available. */
+PoolAlloc_T PoolAlloc_new(void);
+
+/*
+  Returns a new, empty pool whose slabs are placed on NUMA node iNode
+  (see numa.h), or NULL if insufficient memory is available. A tree
+  built on it, with FT_initWith, lives on that node; blocks too large
+  for a class are still taken from malloc.
+*/
+PoolAlloc_T PoolAlloc_newOnNode(int iNode);
+
+/*
+  Returns a new, empty pool whose slabs are 2 MiB huge pages (see
+  hugepage.h), or NULL if insufficient memory is available. A tree
+  built on it, with FT_initWith, has its nodes, paths and child arrays
+  of up to 128 children on few pages, and so misses the TLB less often
+  in lookups; its first slab costs 2 MiB, however small the tree.
+*/
+PoolAlloc_T PoolAlloc_newHuge(void);
+
+/*
+  Frees oPool and all of its slabs, and with them every block carved
+  from them. Blocks too large for a class came from malloc and must
+  already have been freed.
+*/
+void PoolAlloc_free(PoolAlloc_T oPool);
+
+/* Returns the allocator that allocates from oPool, valid until oPool
+   is freed. */
+Alloc_T PoolAlloc_getAlloc(PoolAlloc_T oPool);
+
+/* Stores what oPool holds in *psStats. */
+void PoolAlloc_getStats(PoolAlloc_T oPool,
+                        struct PoolAllocStats *psStats);
+
+#endif
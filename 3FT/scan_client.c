@@ -0,0 +1,242 @@
+/*--------------------------------------------------------------------*/
+/* scan_client.c                                                      */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  scan_client checks FT_iterNew, FT_iterNext and FT_scanRange against
+  a sorted list of the FT's paths.
+
+  Usage: scan_client [-r rounds] [-s seed]
+
+  Each round builds a random tree whose components mix characters
+  that sort before, between and after '/' ("-", ".", "B", "a" and
+  "b"), so that plain lexicographic order differs from the order of
+  FT_toString. The list is FT_toString's lines, sorted by strcmp, with
+  FT_stat's kind for each. Iterators started at random bounds, on
+  paths in the tree, with their last character changed or with a '/'
+  appended, must then give the list from the first path not less than
+  the bound, and FT_scanRange the list between two such bounds, with
+  either of them missing. It also checks empty and uninitialized FTs.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Paths inserted into each tree, of which some fail */
+enum { NUM_INSERTS = 300 };
+
+/* Bounds tried on each tree */
+enum { NUM_QUERIES = 100 };
+
+/* Deepest path drawn, counting the root */
+enum { MAX_DEPTH = 5 };
+
+/* Longest path drawn or bound made, including its terminator */
+enum { MAX_PATH = 32 };
+
+/* One path of the FT and its kind */
+struct entry {
+   const char *pcPath;
+   boolean bIsFile;
+};
+
+/* The FT's paths, sorted by strcmp, and the range being scanned */
+static struct entry asEntries[1 + NUM_INSERTS * (MAX_DEPTH - 1)];
+static size_t ulNumEntries;
+static size_t ulNext, ulEnd;
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the pathnames of the entries at pvFirst and pvSecond. */
+static int ScanClient_compare(const void *pvFirst,
+                              const void *pvSecond) {
+   return strcmp(((const struct entry *) pvFirst)->pcPath,
+                 ((const struct entry *) pvSecond)->pcPath);
+}
+
+/* Writes into pcPath a random path below r, up to MAX_DEPTH levels
+   deep, with components of one or two characters. */
+static void ScanClient_randomPath(char *pcPath) {
+   static const char acChars[] = "-.Bab";
+   size_t ulDepth = 1 + (size_t) rand() % MAX_DEPTH;
+   size_t i;
+   char *pcEnd;
+
+   strcpy(pcPath, "r");
+   pcEnd = pcPath + 1;
+   for(i = 1; i < ulDepth; i++) {
+      *pcEnd++ = '/';
+      *pcEnd++ = acChars[rand() % 5];
+      if(rand() % 2 == 0)
+         *pcEnd++ = acChars[rand() % 5];
+   }
+   *pcEnd = '\0';
+}
+
+/* Stores in acBound a random bound near the listed paths, or NULL in
+   *ppcBound if bMayBeNull and the draw says so. */
+static void ScanClient_randomBound(char *acBound, const char **ppcBound,
+                                   boolean bMayBeNull) {
+   size_t ulLength;
+
+   if(bMayBeNull && rand() % 8 == 0) {
+      *ppcBound = NULL;
+      return;
+   }
+   *ppcBound = acBound;
+   if(ulNumEntries == 0 || rand() % 8 == 0) {
+      ScanClient_randomPath(acBound);
+      return;
+   }
+   strcpy(acBound, asEntries[(size_t) rand() % ulNumEntries].pcPath);
+   ulLength = strlen(acBound);
+   switch(rand() % 4) {
+      case 0:
+         acBound[ulLength - 1] = "-./0Bab"[rand() % 7];
+         break;
+      case 1:
+         strcat(acBound, "/");
+         break;
+      case 2:
+         acBound[ulLength - 1] = '\0';
+         break;
+      default:
+         break;
+   }
+}
+
+/* Returns the index of the first listed path not less than pcBound,
+   or of the end of the list if pcBound is NULL and bEnd, or of its
+   start if pcBound is NULL and not bEnd. */
+static size_t ScanClient_lowerBound(const char *pcBound, boolean bEnd) {
+   size_t i;
+
+   if(pcBound == NULL)
+      return bEnd ? ulNumEntries : 0;
+   for(i = 0; i < ulNumEntries; i++)
+      if(strcmp(asEntries[i].pcPath, pcBound) >= 0)
+         break;
+   return i;
+}
+
+/* Visits pcPath for FT_scanRange, checking it against the next listed
+   path of the range. */
+static void ScanClient_visit(const char *pcPath, boolean bIsFile,
+                             void *pvExtra) {
+   assert(pvExtra == &ulNext);
+   assert(ulNext < ulEnd);
+   assert(strcmp(pcPath, asEntries[ulNext].pcPath) == 0);
+   assert(bIsFile == asEntries[ulNext].bIsFile);
+   ulNext++;
+}
+
+/* Checks an iterator started at pcLo and a scan of [pcLo, pcHi). */
+static void ScanClient_check(const char *pcLo, const char *pcHi) {
+   OrderIter_T oIIter;
+   const char *pcPath;
+   boolean bIsFile;
+   size_t i;
+
+   assert(FT_iterNew(pcLo, &oIIter) == SUCCESS);
+   for(i = ScanClient_lowerBound(pcLo, FALSE); i < ulNumEntries; i++) {
+      assert(FT_iterNext(oIIter, &pcPath, &bIsFile) == SUCCESS);
+      assert(strcmp(pcPath, asEntries[i].pcPath) == 0);
+      assert(bIsFile == asEntries[i].bIsFile);
+   }
+   assert(FT_iterNext(oIIter, &pcPath, &bIsFile) == NO_SUCH_PATH);
+   assert(FT_iterNext(oIIter, &pcPath, &bIsFile) == NO_SUCH_PATH);
+   FT_iterFree(oIIter);
+
+   ulNext = ScanClient_lowerBound(pcLo, FALSE);
+   ulEnd = ScanClient_lowerBound(pcHi, TRUE);
+   if(ulEnd < ulNext)
+      ulEnd = ulNext;
+   assert(FT_scanRange(pcLo, pcHi, ScanClient_visit, &ulNext) ==
+          SUCCESS);
+   assert(ulNext == ulEnd);
+}
+
+/* Runs one round: builds a random tree, lists it and scans it. */
+static void ScanClient_round(void) {
+   char acPath[MAX_PATH], acLo[MAX_PATH + 1], acHi[MAX_PATH + 1];
+   const char *pcLo, *pcHi;
+   char *pcString, *pcLine;
+   size_t ulSize, i;
+
+   assert(FT_init() == SUCCESS);
+   for(i = 0; i < NUM_INSERTS; i++) {
+      ScanClient_randomPath(acPath);
+      if(rand() % 2 == 0)
+         (void) FT_insertDir(acPath);
+      else
+         (void) FT_insertFile(acPath, NULL, 0);
+   }
+
+   pcString = FT_toString();
+   assert(pcString != NULL);
+   ulNumEntries = 0;
+   for(pcLine = strtok(pcString, "\n"); pcLine != NULL;
+       pcLine = strtok(NULL, "\n")) {
+      asEntries[ulNumEntries].pcPath = pcLine;
+      assert(FT_stat(pcLine, &asEntries[ulNumEntries].bIsFile,
+                     &ulSize) == SUCCESS);
+      ulNumEntries++;
+   }
+   qsort(asEntries, ulNumEntries, sizeof(struct entry),
+         ScanClient_compare);
+
+   ScanClient_check(NULL, NULL);
+   for(i = 0; i < NUM_QUERIES; i++) {
+      ScanClient_randomBound(acLo, &pcLo, TRUE);
+      ScanClient_randomBound(acHi, &pcHi, TRUE);
+      ScanClient_check(pcLo, pcHi);
+   }
+   assert(FT_destroy() == SUCCESS);
+   free(pcString);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 100, ulSeed = 1, r;
+   OrderIter_T oIIter;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+
+   /* Nothing to iterate before FT_init; nothing in an empty FT */
+   oIIter = (OrderIter_T) &iArg;
+   assert(FT_iterNew(NULL, &oIIter) == INITIALIZATION_ERROR);
+   assert(oIIter == NULL);
+   assert(FT_scanRange(NULL, NULL, ScanClient_visit, &ulNext) ==
+          INITIALIZATION_ERROR);
+   assert(FT_init() == SUCCESS);
+   ulNumEntries = 0;
+   ScanClient_check(NULL, NULL);
+   ScanClient_check("r", "s");
+   assert(FT_destroy() == SUCCESS);
+
+   for(r = 0; r < ulRounds; r++)
+      ScanClient_round();
+
+   printf("%lu trees scanned in order\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,285 @@
+/*--------------------------------------------------------------------*/
+/* scrub_client.c                                                     */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  scrub_client checks FT_enableChecksums and FT_scrub against a model
+  of the scrub's sweep.
+
+  Usage: scrub_client [-r rounds] [-s seed]
+
+  Each round inserts files whose contents stay in the client's
+  buffers, turns checksums on, and then inserts, replaces and removes
+  files, changes bytes of their contents in place, and scrubs with
+  byte budgets from nothing to unlimited. The model keeps a copy of
+  each file's contents as last set, and the path the sweep stopped
+  at. Each scrub must verify the files that follow it in pathname
+  order, wrapping around once, until the budget is spent, and report
+  exactly those of them whose contents differ from their copy, in that
+  order. Enabling checksums again must not take changed contents as
+  the new ones.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Files worked on, spread over NUM_DIRS directories */
+enum { NUM_FILES = 60, NUM_DIRS = 7 };
+
+/* Longest path, including its terminator */
+enum { MAX_PATH = 16 };
+
+/* Longest contents */
+enum { MAX_LENGTH = 200 };
+
+/* Calls made in each round */
+enum { NUM_CALLS = 600 };
+
+/* Each file's path, contents and copy of the contents as last set */
+static char aacPaths[NUM_FILES][MAX_PATH];
+static char aacContents[NUM_FILES][MAX_LENGTH];
+static char aacSet[NUM_FILES][MAX_LENGTH];
+
+/* Whether each file is in the model, and its length */
+static boolean abPresent[NUM_FILES];
+static size_t aulLengths[NUM_FILES];
+
+/* Whether each directory has been made */
+static boolean abDirs[NUM_DIRS];
+
+/* The files in pathname order */
+static size_t aulOrder[NUM_FILES];
+
+/* The file the sweep stopped at, or NUM_FILES to start a new pass */
+static size_t ulCursor;
+
+/* Mismatches expected from a scrub, in order, and those found */
+static size_t aulExpected[NUM_FILES];
+static size_t ulExpected, ulFound;
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the pathnames of the files at pvFirst and pvSecond. */
+static int ScrubClient_compare(const void *pvFirst,
+                               const void *pvSecond) {
+   return strcmp(aacPaths[*(const size_t *) pvFirst],
+                 aacPaths[*(const size_t *) pvSecond]);
+}
+
+/* Returns TRUE if the contents of file ulFile differ from those last
+   set, FALSE otherwise. */
+static boolean ScrubClient_changed(size_t ulFile) {
+   return (boolean) (memcmp(aacContents[ulFile], aacSet[ulFile],
+                            aulLengths[ulFile]) != 0);
+}
+
+/* Fills file ulFile's buffer with new contents of a random length, and
+   copies them. */
+static void ScrubClient_fill(size_t ulFile) {
+   size_t i;
+
+   aulLengths[ulFile] = (size_t) rand() % (MAX_LENGTH + 1);
+   for(i = 0; i < aulLengths[ulFile]; i++)
+      aacContents[ulFile][i] = (char) rand();
+   memcpy(aacSet[ulFile], aacContents[ulFile], aulLengths[ulFile]);
+}
+
+/* Returns TRUE if some path of the FT, file or directory, is not less
+   than that of file ulFile, FALSE otherwise. */
+static boolean ScrubClient_anyAfter(size_t ulFile) {
+   size_t i;
+
+   for(i = 0; i < NUM_FILES; i++)
+      if(abPresent[i] && strcmp(aacPaths[i], aacPaths[ulFile]) >= 0)
+         return TRUE;
+   for(i = ulFile % NUM_DIRS + 1; i < NUM_DIRS; i++)
+      if(abDirs[i])
+         return TRUE;
+   return FALSE;
+}
+
+/* Runs the model of a scrub with budget ulMaxBytes: fills aulExpected
+   and moves ulCursor. */
+static void ScrubClient_expect(size_t ulMaxBytes) {
+   size_t ulStart = ulCursor, ulLast = NUM_FILES, ulBytes = 0;
+   size_t ulPass, i;
+   int iOrder;
+
+   /* After the cursor, then, if it was set, from the start up to it */
+   ulExpected = 0;
+   for(ulPass = 0; ulPass < (ulStart == NUM_FILES ? 1 : 2); ulPass++)
+      for(i = 0; i < NUM_FILES; i++) {
+         if(!abPresent[aulOrder[i]])
+            continue;
+         if(ulStart != NUM_FILES) {
+            iOrder = strcmp(aacPaths[aulOrder[i]], aacPaths[ulStart]);
+            if((ulPass == 0 && iOrder <= 0) ||
+               (ulPass == 1 && iOrder >= 0))
+               continue;
+         }
+         if(ScrubClient_changed(aulOrder[i]))
+            aulExpected[ulExpected++] = aulOrder[i];
+         ulLast = aulOrder[i];
+         ulBytes += aulLengths[ulLast];
+         if(ulBytes >= ulMaxBytes) {
+            ulCursor = ulLast;
+            return;
+         }
+      }
+
+   /* A sweep that wrapped stops at the first path past its start */
+   if(ulStart != NUM_FILES && ScrubClient_anyAfter(ulStart))
+      ulCursor = ulLast;
+   else
+      ulCursor = NUM_FILES;
+}
+
+/* Checks the mismatched file pcPath against the next expected one. */
+static void ScrubClient_mismatch(const char *pcPath, void *pvExtra) {
+   assert(pvExtra == &ulFound);
+   assert(ulFound < ulExpected);
+   assert(strcmp(pcPath, aacPaths[aulExpected[ulFound]]) == 0);
+   ulFound++;
+}
+
+/* Scrubs with a random budget, and checks the mismatches. */
+static void ScrubClient_scrub(void) {
+   size_t ulMaxBytes, ulMismatches;
+
+   switch(rand() % 4) {
+      case 0:
+         ulMaxBytes = 0;
+         break;
+      case 1:
+         ulMaxBytes = (size_t) -1;
+         break;
+      default:
+         ulMaxBytes = (size_t) rand() % (4 * MAX_LENGTH);
+         break;
+   }
+   ScrubClient_expect(ulMaxBytes);
+   ulFound = 0;
+   if(rand() % 4 == 0) {
+      assert(FT_scrub(ulMaxBytes, NULL, NULL, &ulMismatches) ==
+             SUCCESS);
+      ulFound = ulMismatches;
+   }
+   else if(rand() % 3 == 0)
+      assert(FT_scrub(ulMaxBytes, ScrubClient_mismatch, &ulFound,
+                      NULL) == SUCCESS);
+   else {
+      assert(FT_scrub(ulMaxBytes, ScrubClient_mismatch, &ulFound,
+                      &ulMismatches) == SUCCESS);
+      assert(ulMismatches == ulFound);
+   }
+   assert(ulFound == ulExpected);
+}
+
+/* Makes one random call on file ulFile. */
+static void ScrubClient_call(size_t ulFile) {
+   if(!abPresent[ulFile]) {
+      ScrubClient_fill(ulFile);
+      assert(FT_insertFile(aacPaths[ulFile], aacContents[ulFile],
+                           aulLengths[ulFile]) == SUCCESS);
+      abPresent[ulFile] = TRUE;
+      abDirs[ulFile % NUM_DIRS] = TRUE;
+      return;
+   }
+   switch(rand() % 6) {
+      case 0:
+         /* Changed in place, behind the FT's back */
+         if(aulLengths[ulFile] != 0)
+            aacContents[ulFile][(size_t) rand() % aulLengths[ulFile]] =
+               (char) rand();
+         break;
+      case 1:
+         ScrubClient_fill(ulFile);
+         assert(FT_replaceFileContents(aacPaths[ulFile],
+                                       aacContents[ulFile],
+                                       aulLengths[ulFile]) != NULL);
+         break;
+      case 2:
+         assert(FT_rmFile(aacPaths[ulFile]) == SUCCESS);
+         abPresent[ulFile] = FALSE;
+         break;
+      default:
+         ScrubClient_scrub();
+         break;
+   }
+}
+
+/* Runs one round. */
+static void ScrubClient_round(void) {
+   size_t ulMismatches, i;
+
+   assert(FT_init() == SUCCESS);
+   memset(abPresent, 0, sizeof(abPresent));
+   memset(abDirs, 0, sizeof(abDirs));
+   ulCursor = NUM_FILES;
+
+   /* Contents changed before checksums are on are the ones checked */
+   for(i = 0; i < NUM_FILES; i++)
+      if(rand() % 2 == 0)
+         ScrubClient_call(i);
+   ulMismatches = 1;
+   assert(FT_scrub(0, NULL, NULL, &ulMismatches) ==
+          INITIALIZATION_ERROR);
+   assert(ulMismatches == 0);
+   for(i = 0; i < NUM_FILES; i++)
+      if(abPresent[i] && rand() % 4 == 0 && aulLengths[i] != 0) {
+         aacContents[i][0] = (char) ~aacContents[i][0];
+         memcpy(aacSet[i], aacContents[i], aulLengths[i]);
+      }
+   assert(FT_enableChecksums() == SUCCESS);
+
+   for(i = 0; i < NUM_CALLS; i++) {
+      if(i == NUM_CALLS / 2)
+         assert(FT_enableChecksums() == SUCCESS);
+      ScrubClient_call((size_t) rand() % NUM_FILES);
+   }
+   assert(FT_destroy() == SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 20, ulSeed = 1, r;
+   size_t ulMismatches = 1, i;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+   for(i = 0; i < NUM_FILES; i++) {
+      sprintf(aacPaths[i], "r/d%lu/f%lu", (unsigned long) i % NUM_DIRS,
+              (unsigned long) i);
+      aulOrder[i] = i;
+   }
+   qsort(aulOrder, NUM_FILES, sizeof(size_t), ScrubClient_compare);
+
+   assert(FT_enableChecksums() == INITIALIZATION_ERROR);
+   assert(FT_scrub(0, NULL, NULL, &ulMismatches) ==
+          INITIALIZATION_ERROR);
+   assert(ulMismatches == 0);
+   for(r = 0; r < ulRounds; r++)
+      ScrubClient_round();
+
+   printf("%lu rounds of scrubs matched\n", ulRounds);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+/*--------------------------------------------------------------------*/
+/* sizeindex.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "sizeindex.h"
+
+/*
+  The index is a treap: a binary search tree on (length, node) that is
+  also a heap on random priorities, which keeps its expected depth
+  logarithmic without any rebalancing bookkeeping.
+*/
+struct sizeNode {
+   /* Length the file node is indexed under */
+   size_t ulLength;
+
+   /* The indexed file node */
+   NodeF_T oNfNode;
+
+   /* Random heap priority */
+   unsigned long ulPriority;
+
+   /* Subtrees of smaller and larger keys */
+   struct sizeNode *psLeft;
+   struct sizeNode *psRight;
+};
+
+/* A size index is the root of its treap */
+struct sizeIndex {
+   /* Root of the treap, or NULL if empty */
+   struct sizeNode *psRoot;
+
+   /* Number of indexed file nodes */
+   size_t ulLength;
+
+   /* State of the private generator of priorities */
+   unsigned long ulSeed;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the key (ulLength, oNfNode) with the key of psNode.
+   Returns <0, 0, or >0 if the key is "less than", "equal to", or
+   "greater than" psNode's key, respectively. */
+static int SizeIndex_compare(size_t ulLength, NodeF_T oNfNode,
+                             const struct sizeNode *psNode) {
+   assert(psNode != NULL);
+
+   if(ulLength != psNode->ulLength)
+      return ulLength < psNode->ulLength ? -1 : 1;
+   if(oNfNode != psNode->oNfNode)
+      return (unsigned long) oNfNode < (unsigned long) psNode->oNfNode ?
+             -1 : 1;
+   return 0;
+}
+
+/* Splits the treap psRoot into the keys less than (ulLength, oNfNode),
+   stored in *ppsLess, and the rest, stored in *ppsRest. */
+static void SizeIndex_split(struct sizeNode *psRoot, size_t ulLength,
+                            NodeF_T oNfNode, struct sizeNode **ppsLess,
+                            struct sizeNode **ppsRest) {
+   if(psRoot == NULL) {
+      *ppsLess = NULL;
+      *ppsRest = NULL;
+   }
+   else if(SizeIndex_compare(ulLength, oNfNode, psRoot) > 0) {
+      SizeIndex_split(psRoot->psRight, ulLength, oNfNode,
+                      &psRoot->psRight, ppsRest);
+      *ppsLess = psRoot;
+   }
+   else {
+      SizeIndex_split(psRoot->psLeft, ulLength, oNfNode,
+                      ppsLess, &psRoot->psLeft);
+      *ppsRest = psRoot;
+   }
+}
+
+/* Merges treaps psLess and psMore, where every key of psLess is less
+   than every key of psMore. Returns the root of the result. */
+static struct sizeNode *SizeIndex_merge(struct sizeNode *psLess,
+                                        struct sizeNode *psMore) {
+   if(psLess == NULL)
+      return psMore;
+   if(psMore == NULL)
+      return psLess;
+   if(psLess->ulPriority > psMore->ulPriority) {
+      psLess->psRight = SizeIndex_merge(psLess->psRight, psMore);
+      return psLess;
+   }
+   psMore->psLeft = SizeIndex_merge(psLess, psMore->psLeft);
+   return psMore;
+}
+
+/* Links psNew into the treap psRoot. Returns the new root. */
+static struct sizeNode *SizeIndex_link(struct sizeNode *psRoot,
+                                       struct sizeNode *psNew) {
+   assert(psNew != NULL);
+
+   if(psRoot == NULL)
+      return psNew;
+   if(psNew->ulPriority > psRoot->ulPriority) {
+      SizeIndex_split(psRoot, psNew->ulLength, psNew->oNfNode,
+                      &psNew->psLeft, &psNew->psRight);
+      return psNew;
+   }
+   if(SizeIndex_compare(psNew->ulLength, psNew->oNfNode, psRoot) < 0)
+      psRoot->psLeft = SizeIndex_link(psRoot->psLeft, psNew);
+   else
+      psRoot->psRight = SizeIndex_link(psRoot->psRight, psNew);
+   return psRoot;
+}
+
+/* Unlinks the node with key (ulLength, oNfNode) from the treap psRoot,
+   storing it in *ppsFound (NULL if absent). Returns the new root. */
+static struct sizeNode *SizeIndex_unlink(struct sizeNode *psRoot,
+                                         size_t ulLength,
+                                         NodeF_T oNfNode,
+                                         struct sizeNode **ppsFound) {
+   int iCompare;
+
+   if(psRoot == NULL) {
+      *ppsFound = NULL;
+      return NULL;
+   }
+   iCompare = SizeIndex_compare(ulLength, oNfNode, psRoot);
+   if(iCompare == 0) {
+      *ppsFound = psRoot;
+      return SizeIndex_merge(psRoot->psLeft, psRoot->psRight);
+   }
+   if(iCompare < 0)
+      psRoot->psLeft = SizeIndex_unlink(psRoot->psLeft, ulLength,
+                                        oNfNode, ppsFound);
+   else
+      psRoot->psRight = SizeIndex_unlink(psRoot->psRight, ulLength,
+                                         oNfNode, ppsFound);
+   return psRoot;
+}
+
+/* Frees every node of the treap psRoot. */
+static void SizeIndex_freeNodes(struct sizeNode *psRoot) {
+   if(psRoot == NULL)
+      return;
+   SizeIndex_freeNodes(psRoot->psLeft);
+   SizeIndex_freeNodes(psRoot->psRight);
+   free(psRoot);
+}
+
+/* Appends the file nodes of psRoot to oDResult, largest first, until
+   *pulLeft more have been appended. Returns FALSE if oDResult could
+   not grow, TRUE otherwise. */
+static boolean SizeIndex_collectLargest(struct sizeNode *psRoot,
+                                        size_t *pulLeft,
+                                        DynArray_T oDResult) {
+   if(psRoot == NULL || *pulLeft == 0)
+      return TRUE;
+   if(!SizeIndex_collectLargest(psRoot->psRight, pulLeft, oDResult))
+      return FALSE;
+   if(*pulLeft == 0)
+      return TRUE;
+   if(!DynArray_add(oDResult, psRoot->oNfNode))
+      return FALSE;
+   (*pulLeft)--;
+   return SizeIndex_collectLargest(psRoot->psLeft, pulLeft, oDResult);
+}
+
+/* Appends the file nodes of psRoot with lengths in [ulMin, ulMax] to
+   oDResult, shortest first, descending only into subtrees that may
+   hold such lengths. Returns FALSE if oDResult could not grow, TRUE
+   otherwise. */
+static boolean SizeIndex_collectRange(struct sizeNode *psRoot,
+                                      size_t ulMin, size_t ulMax,
+                                      DynArray_T oDResult) {
+   if(psRoot == NULL)
+      return TRUE;
+   if(psRoot->ulLength >= ulMin &&
+      !SizeIndex_collectRange(psRoot->psLeft, ulMin, ulMax, oDResult))
+      return FALSE;
+   if(psRoot->ulLength >= ulMin && psRoot->ulLength <= ulMax &&
+      !DynArray_add(oDResult, psRoot->oNfNode))
+      return FALSE;
+   if(psRoot->ulLength <= ulMax)
+      return SizeIndex_collectRange(psRoot->psRight, ulMin, ulMax,
+                                    oDResult);
+   return TRUE;
+}
+
+/* Returns the next priority from oSIndex's generator. */
+static unsigned long SizeIndex_nextPriority(SizeIndex_T oSIndex) {
+   assert(oSIndex != NULL);
+
+   oSIndex->ulSeed = oSIndex->ulSeed * 1103515245UL + 12345UL;
+   return (oSIndex->ulSeed >> 8) & 0xffffffUL;
+}
+
+/* ================================================================== */
+SizeIndex_T SizeIndex_new(void) {
+   SizeIndex_T oSIndex;
+
+   oSIndex = malloc(sizeof(struct sizeIndex));
+   if(oSIndex == NULL)
+      return NULL;
+   oSIndex->psRoot = NULL;
+   oSIndex->ulLength = 0;
+   oSIndex->ulSeed = 217;
+   return oSIndex;
+}
+
+/* ================================================================== */
+void SizeIndex_free(SizeIndex_T oSIndex) {
+   assert(oSIndex != NULL);
+
+   SizeIndex_freeNodes(oSIndex->psRoot);
+   free(oSIndex);
+}
+
+/* ================================================================== */
+size_t SizeIndex_getLength(SizeIndex_T oSIndex) {
+   assert(oSIndex != NULL);
+
+   return oSIndex->ulLength;
+}
+
+/* ================================================================== */
+int SizeIndex_insert(SizeIndex_T oSIndex, NodeF_T oNfNode) {
+   struct sizeNode *psNew;
+
+   assert(oSIndex != NULL);
+   assert(oNfNode != NULL);
+
+   psNew = malloc(sizeof(struct sizeNode));
+   if(psNew == NULL)
+      return MEMORY_ERROR;
+   psNew->ulLength = NodeF_getLength(oNfNode);
+   psNew->oNfNode = oNfNode;
+   psNew->ulPriority = SizeIndex_nextPriority(oSIndex);
+   psNew->psLeft = NULL;
+   psNew->psRight = NULL;
+
+   oSIndex->psRoot = SizeIndex_link(oSIndex->psRoot, psNew);
+   oSIndex->ulLength++;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+boolean SizeIndex_remove(SizeIndex_T oSIndex, NodeF_T oNfNode,
+                         size_t ulLength) {
+   struct sizeNode *psFound;
+
+   assert(oSIndex != NULL);
+   assert(oNfNode != NULL);
+
+   oSIndex->psRoot = SizeIndex_unlink(oSIndex->psRoot, ulLength,
+                                      oNfNode, &psFound);
+   if(psFound == NULL)
+      return FALSE;
+   free(psFound);
+   oSIndex->ulLength--;
+   return TRUE;
+}
+
+/* ================================================================== */
+void SizeIndex_update(SizeIndex_T oSIndex, NodeF_T oNfNode,
+                      size_t ulOldLength) {
+   struct sizeNode *psFound;
+
+   assert(oSIndex != NULL);
+   assert(oNfNode != NULL);
+
+   /* Relink the same node under the new key */
+   oSIndex->psRoot = SizeIndex_unlink(oSIndex->psRoot, ulOldLength,
+                                      oNfNode, &psFound);
+   if(psFound == NULL)
+      return;
+   psFound->ulLength = NodeF_getLength(oNfNode);
+   psFound->psLeft = NULL;
+   psFound->psRight = NULL;
+   oSIndex->psRoot = SizeIndex_link(oSIndex->psRoot, psFound);
+}
+
+/* ================================================================== */
+int SizeIndex_topK(SizeIndex_T oSIndex, size_t ulK, DynArray_T oDResult) {
+   assert(oSIndex != NULL);
+   assert(oDResult != NULL);
+
+   if(!SizeIndex_collectLargest(oSIndex->psRoot, &ulK, oDResult))
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
+
+/* ================================================================== */
+int SizeIndex_range(SizeIndex_T oSIndex, size_t ulMin, size_t ulMax,
+                    DynArray_T oDResult) {
+   assert(oSIndex != NULL);
+   assert(oDResult != NULL);
+
+   if(!SizeIndex_collectRange(oSIndex->psRoot, ulMin, ulMax, oDResult))
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
@@ -0,0 +1,69 @@
+/*--------------------------------------------------------------------*/
+/* sizeindex.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef SIZEINDEX_INCLUDED
+#define SIZEINDEX_INCLUDED
+
+/*
+  A size index is a secondary index over file nodes ordered by the
+  length of their contents (ties broken by node identity), supporting
+  largest-first and by-range enumeration in time proportional to
+  log(n) plus the number of results.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "dynarray.h"
+#include "nodef.h"
+
+/* A SizeIndex_T is an ordered collection of file nodes */
+typedef struct sizeIndex *SizeIndex_T;
+
+/* Returns a new, empty size index, or NULL if insufficient memory is
+   available. */
+SizeIndex_T SizeIndex_new(void);
+
+/* Destroys oSIndex. The file nodes it refers to are not freed. */
+void SizeIndex_free(SizeIndex_T oSIndex);
+
+/* Returns the number of file nodes in oSIndex. */
+size_t SizeIndex_getLength(SizeIndex_T oSIndex);
+
+/*
+  Adds oNfNode to oSIndex under its current length. Returns SUCCESS,
+  or MEMORY_ERROR if allocation fails.
+*/
+int SizeIndex_insert(SizeIndex_T oSIndex, NodeF_T oNfNode);
+
+/*
+  Removes oNfNode, which was indexed under length ulLength, from
+  oSIndex. Returns TRUE if it was found, FALSE if not.
+*/
+boolean SizeIndex_remove(SizeIndex_T oSIndex, NodeF_T oNfNode,
+                         size_t ulLength);
+
+/*
+  Moves oNfNode, indexed under ulOldLength, to its current length.
+  Never allocates, so it cannot fail if oNfNode was indexed.
+*/
+void SizeIndex_update(SizeIndex_T oSIndex, NodeF_T oNfNode,
+                      size_t ulOldLength);
+
+/*
+  Appends to oDResult up to ulK of the file nodes with the largest
+  lengths, largest first. Returns SUCCESS, or MEMORY_ERROR if oDResult
+  could not grow.
+*/
+int SizeIndex_topK(SizeIndex_T oSIndex, size_t ulK, DynArray_T oDResult);
+
+/*
+  Appends to oDResult every file node whose length is in the range
+  [ulMin, ulMax], shortest first. Returns SUCCESS, or MEMORY_ERROR if
+  oDResult could not grow.
+*/
+int SizeIndex_range(SizeIndex_T oSIndex, size_t ulMin, size_t ulMax,
+                    DynArray_T oDResult);
+
+#endif
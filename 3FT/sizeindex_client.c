@@ -0,0 +1,274 @@
+/*--------------------------------------------------------------------*/
+/* sizeindex_client.c                                                 */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  sizeindex_client checks FT_topKBySize and FT_filesInSizeRange
+  against the lengths FT_stat gives.
+
+  Usage: sizeindex_client [-r rounds] [-s seed]
+
+  Each round inserts random files of random lengths, many of them
+  equal, enables the size index, and then inserts more, replaces the
+  contents of some files with longer or shorter ones, removes files
+  and directories, and detaches and grafts back a directory, checking
+  the index after every step. The files and their lengths are the
+  lines of FT_toString that FT_stat calls files. FT_topKBySize must
+  give the longest files, longest first, with ties in any order, and
+  FT_filesInSizeRange every file in the range, shortest first.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/* Paths inserted at each building step, of which some fail */
+enum { NUM_INSERTS = 200 };
+
+/* Deepest path drawn, counting the root */
+enum { MAX_DEPTH = 4 };
+
+/* Longest path drawn, including its terminator */
+enum { MAX_PATH = 32 };
+
+/* Longest contents, so that many files share a length */
+enum { MAX_LENGTH = 40 };
+
+/* Queries of each kind made at every check */
+enum { NUM_QUERIES = 20 };
+
+/* Most lines of FT_toString: two building steps' worth */
+enum { MAX_LINES = 1 + 2 * NUM_INSERTS * (MAX_DEPTH - 1) };
+
+/* One file of the FT and its length */
+struct file {
+   const char *pcPath;
+   size_t ulLength;
+};
+
+/* The FT's files, longest first */
+static struct file asFiles[MAX_LINES];
+static size_t ulNumFiles;
+
+/* Contents of every file, cut to its length */
+static char acContents[MAX_LENGTH];
+
+/*--------------------------------------------------------------------*/
+
+/* Compares the files at pvFirst and pvSecond by length, longest
+   first. */
+static int SizeIndexClient_compareLengths(const void *pvFirst,
+                                          const void *pvSecond) {
+   size_t ulFirst = ((const struct file *) pvFirst)->ulLength;
+   size_t ulSecond = ((const struct file *) pvSecond)->ulLength;
+
+   return ulFirst > ulSecond ? -1 : ulFirst < ulSecond;
+}
+
+/* Compares the pathnames pvFirst and pvSecond. */
+static int SizeIndexClient_comparePaths(const void *pvFirst,
+                                        const void *pvSecond) {
+   return strcmp((const char *) pvFirst, (const char *) pvSecond);
+}
+
+/* Returns a random length of contents. */
+static size_t SizeIndexClient_randomLength(void) {
+   return (size_t) rand() % (MAX_LENGTH + 1);
+}
+
+/* Writes into pcPath a random path below r, up to MAX_DEPTH levels
+   deep, with components "a" to "d". */
+static void SizeIndexClient_randomPath(char *pcPath) {
+   size_t ulDepth = 2 + (size_t) rand() % (MAX_DEPTH - 1);
+   size_t i;
+
+   strcpy(pcPath, "r");
+   for(i = 1; i < ulDepth; i++)
+      sprintf(pcPath + strlen(pcPath), "/%c", 'a' + rand() % 4);
+}
+
+/* Inserts random files of random lengths, and some directories. */
+static void SizeIndexClient_build(void) {
+   char acPath[MAX_PATH];
+   size_t i;
+
+   for(i = 0; i < NUM_INSERTS; i++) {
+      SizeIndexClient_randomPath(acPath);
+      if(rand() % 4 == 0)
+         (void) FT_insertDir(acPath);
+      else
+         (void) FT_insertFile(acPath, acContents,
+                              SizeIndexClient_randomLength());
+   }
+}
+
+/* Lists the FT's files in asFiles, longest first, returning the
+   FT_toString they point into, which the caller must free. */
+static char *SizeIndexClient_list(void) {
+   char *pcString, *pcLine;
+   boolean bIsFile;
+   size_t ulLength;
+
+   pcString = FT_toString();
+   assert(pcString != NULL);
+   ulNumFiles = 0;
+   for(pcLine = strtok(pcString, "\n"); pcLine != NULL;
+       pcLine = strtok(NULL, "\n")) {
+      assert(FT_stat(pcLine, &bIsFile, &ulLength) == SUCCESS);
+      if(bIsFile) {
+         asFiles[ulNumFiles].pcPath = pcLine;
+         asFiles[ulNumFiles].ulLength = ulLength;
+         ulNumFiles++;
+      }
+   }
+   qsort(asFiles, ulNumFiles, sizeof(struct file),
+         SizeIndexClient_compareLengths);
+   return pcString;
+}
+
+/* Checks that oDResult holds ulCount distinct files with the lengths
+   of asFiles[ulFirst..ulFirst+ulCount-1], in that order if bLongest
+   or in reverse order if not. Frees oDResult. */
+static void SizeIndexClient_match(DynArray_T oDResult, size_t ulFirst,
+                                  size_t ulCount, boolean bLongest) {
+   const char *pcPath;
+   boolean bIsFile;
+   size_t ulLength, ulExpected, i;
+
+   assert(oDResult != NULL);
+   assert(DynArray_getLength(oDResult) == ulCount);
+   for(i = 0; i < ulCount; i++) {
+      pcPath = DynArray_get(oDResult, i);
+      ulExpected = bLongest ? asFiles[ulFirst + i].ulLength :
+                   asFiles[ulFirst + ulCount - 1 - i].ulLength;
+      assert(FT_stat(pcPath, &bIsFile, &ulLength) == SUCCESS);
+      assert(bIsFile);
+      assert(ulLength == ulExpected);
+   }
+
+   /* Distinct: no path twice */
+   DynArray_sort(oDResult, SizeIndexClient_comparePaths);
+   for(i = 1; i < ulCount; i++)
+      assert(strcmp(DynArray_get(oDResult, i - 1),
+                    DynArray_get(oDResult, i)) != 0);
+   DynArray_free(oDResult);
+}
+
+/* Checks random top-k and range queries against the FT's files. */
+static void SizeIndexClient_check(void) {
+   DynArray_T oDResult;
+   size_t ulK, ulMin, ulMax, ulFirst, ulEnd, i;
+   char *pcString;
+
+   pcString = SizeIndexClient_list();
+   for(i = 0; i < NUM_QUERIES; i++) {
+      ulK = i == 0 ? ulNumFiles + 1 : (size_t) rand() % (ulNumFiles + 2);
+      assert(FT_topKBySize(ulK, &oDResult) == SUCCESS);
+      SizeIndexClient_match(oDResult, 0,
+                            ulK < ulNumFiles ? ulK : ulNumFiles, TRUE);
+
+      /* Ranges may be empty, or hold no file */
+      ulMin = SizeIndexClient_randomLength();
+      ulMax = SizeIndexClient_randomLength();
+      if(i % 4 == 0)
+         ulMax = ulMin;
+      assert(FT_filesInSizeRange(ulMin, ulMax, &oDResult) == SUCCESS);
+      for(ulFirst = 0; ulFirst < ulNumFiles &&
+          asFiles[ulFirst].ulLength > ulMax; ulFirst++)
+         ;
+      for(ulEnd = ulFirst; ulEnd < ulNumFiles &&
+          asFiles[ulEnd].ulLength >= ulMin; ulEnd++)
+         ;
+      SizeIndexClient_match(oDResult, ulFirst, ulEnd - ulFirst, FALSE);
+   }
+   free(pcString);
+}
+
+/* Replaces the contents of about one in ulEvery files with contents
+   of a random length, and removes about one in ulEvery files and
+   directories below the root. */
+static void SizeIndexClient_change(size_t ulEvery) {
+   char *pcString, *pcLine;
+
+   pcString = FT_toString();
+   assert(pcString != NULL);
+   for(pcLine = strtok(pcString, "\n"); pcLine != NULL;
+       pcLine = strtok(NULL, "\n")) {
+      if((size_t) rand() % ulEvery != 0 || strcmp(pcLine, "r") == 0)
+         continue;
+      if(FT_containsFile(pcLine)) {
+         if(rand() % 2 == 0)
+            (void) FT_rmFile(pcLine);
+         else
+            (void) FT_replaceFileContents(pcLine, acContents,
+                                          SizeIndexClient_randomLength());
+      }
+      else
+         (void) FT_rmDir(pcLine);
+   }
+   free(pcString);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   unsigned long ulRounds = 30, ulSeed = 1, r;
+   FTSubtree_T oSSubtree;
+   DynArray_T oDResult;
+   int iArg;
+
+   if(argc % 2 != 1) {
+      fprintf(stderr, "Usage: %s [-r rounds] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for(iArg = 1; iArg + 1 < argc; iArg += 2) {
+      if(strcmp(argv[iArg], "-r") == 0)
+         ulRounds = strtoul(argv[iArg + 1], NULL, 10);
+      else if(strcmp(argv[iArg], "-s") == 0)
+         ulSeed = strtoul(argv[iArg + 1], NULL, 10);
+      else {
+         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[iArg]);
+         return EXIT_FAILURE;
+      }
+   }
+   srand((unsigned) ulSeed);
+   memset(acContents, 'x', MAX_LENGTH);
+
+   assert(FT_enableSizeIndex() == INITIALIZATION_ERROR);
+   for(r = 0; r < ulRounds; r++) {
+      /* Queries need the index, which covers the files already in */
+      assert(FT_init() == SUCCESS);
+      oDResult = (DynArray_T) &iArg;
+      assert(FT_topKBySize(1, &oDResult) == INITIALIZATION_ERROR);
+      assert(oDResult == NULL);
+      assert(FT_filesInSizeRange(0, 1, &oDResult) ==
+             INITIALIZATION_ERROR);
+      SizeIndexClient_build();
+      assert(FT_enableSizeIndex() == SUCCESS);
+      assert(FT_enableSizeIndex() == SUCCESS);
+      SizeIndexClient_check();
+
+      SizeIndexClient_build();
+      SizeIndexClient_check();
+      SizeIndexClient_change(5);
+      SizeIndexClient_check();
+
+      /* Files leave the index with a subtree and come back with it */
+      if(FT_containsDir("r/a")) {
+         assert(FT_detachSubtree("r/a", &oSSubtree) == SUCCESS);
+         SizeIndexClient_check();
+         assert(FT_graft(oSSubtree, FT_CONFLICT_FAIL, NULL, NULL) ==
+                SUCCESS);
+         SizeIndexClient_check();
+      }
+      assert(FT_rmDir("r") == SUCCESS);
+      SizeIndexClient_check();
+      assert(FT_destroy() == SUCCESS);
+   }
+
+   printf("%lu size indexes matched the files\n", ulRounds);
+   return EXIT_SUCCESS;
+}
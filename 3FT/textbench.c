@@ -0,0 +1,257 @@
+/*--------------------------------------------------------------------*/
+/* textbench.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+/*
+  textbench times building the text index and querying it.
+
+  Usage: textbench [-n files] [-w words] [-v vocabulary] [-q queries]
+
+  It makes n files textbench/dI/fK of w words each, drawn from v words
+  with the lower-numbered ones more common. It builds the index both
+  ways: by inserting the files with it enabled, and by enabling it
+  over files already inserted. It reports the megabytes of contents
+  indexed per second each way, against inserting with no index. It
+  then runs q queries of one to three words, alternately TEXT_ALL and
+  TEXT_ANY, reporting their mean, median, 99th percentile and worst
+  latency, and checks the first queries' hits against a naive scan of
+  the contents.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "a4def.h"
+#include "ft.h"
+#include "benchutil.h"
+
+/* Largest generated word, including its terminator */
+enum { MAX_WORD = 16 };
+
+/* Directories the files are spread over */
+enum { NUM_DIRS = 16 };
+
+/* Most words in a query */
+enum { MAX_TERMS = 3 };
+
+/* Queries checked against the naive scan */
+enum { NUM_CHECKED = 20 };
+
+/*--------------------------------------------------------------------*/
+
+/* Writes into pcWord a word of the ulVocabulary, drawn so that word k
+   is more common than word k + 1. */
+static void TextBench_word(char *pcWord, size_t ulVocabulary,
+                           unsigned long *pulState) {
+   size_t ulLimit = 1 + Bench_random(pulState) % ulVocabulary;
+   size_t ulWord = Bench_random(pulState) % ulLimit;
+
+   /* The word's number in base 26, after a letter for every word */
+   *pcWord++ = 'w';
+   do {
+      *pcWord++ = (char) ('a' + ulWord % 26);
+      ulWord /= 26;
+   } while(ulWord != 0);
+   *pcWord = '\0';
+}
+
+/* Returns a new string of ulWords words of the ulVocabulary, separated
+   by spaces, or NULL if memory runs out. */
+static char *TextBench_contents(size_t ulWords, size_t ulVocabulary,
+                                unsigned long *pulState) {
+   char *pcContents, *pcEnd;
+   size_t i;
+
+   pcContents = malloc(ulWords * MAX_WORD + 1);
+   if(pcContents == NULL)
+      return NULL;
+   pcEnd = pcContents;
+   for(i = 0; i < ulWords; i++) {
+      TextBench_word(pcEnd, ulVocabulary, pulState);
+      pcEnd += strlen(pcEnd);
+      *pcEnd++ = ' ';
+   }
+   *pcEnd = '\0';
+   return pcContents;
+}
+
+/* Returns TRUE if the string pcContents holds the word pcWord, bounded
+   on both sides by characters other than letters and digits. */
+static boolean TextBench_holds(const char *pcContents,
+                               const char *pcWord) {
+   size_t ulLength = strlen(pcWord);
+   const char *pcAt = pcContents;
+
+   while((pcAt = strstr(pcAt, pcWord)) != NULL) {
+      if((pcAt == pcContents || !isalnum((unsigned char) pcAt[-1])) &&
+         !isalnum((unsigned char) pcAt[ulLength]))
+         return TRUE;
+      pcAt++;
+   }
+   return FALSE;
+}
+
+/* Returns the number of the ulFiles contents in ppcContents that hold
+   every (if eMode is TEXT_ALL) or any of the ulNumTerms words in
+   ppcTerms. */
+static size_t TextBench_naive(char **ppcContents, size_t ulFiles,
+                              const char **ppcTerms, size_t ulNumTerms,
+                              enum TextMode eMode) {
+   size_t ulHits = 0, i, t, ulHeld;
+
+   for(i = 0; i < ulFiles; i++) {
+      ulHeld = 0;
+      for(t = 0; t < ulNumTerms; t++)
+         ulHeld += TextBench_holds(ppcContents[i], ppcTerms[t]);
+      if(eMode == TEXT_ALL ? ulHeld == ulNumTerms : ulHeld != 0)
+         ulHits++;
+   }
+   return ulHits;
+}
+
+/* Inserts the ulFiles files named by ppcPaths with contents
+   ppcContents into a new FT, enabling the text index before if
+   bBefore and after if bAfter. Stores the seconds the insertions took
+   in *pdInsert and the seconds enabling the index after took in
+   *pdEnable. Returns FALSE if a call fails, TRUE otherwise. */
+static boolean TextBench_build(char **ppcPaths, char **ppcContents,
+                               size_t ulFiles, boolean bBefore,
+                               boolean bAfter, double *pdInsert,
+                               double *pdEnable) {
+   double dStart;
+   size_t i;
+
+   if(FT_init() != SUCCESS)
+      return FALSE;
+   if(bBefore && FT_enableTextIndex() != SUCCESS)
+      return FALSE;
+   dStart = Bench_now();
+   for(i = 0; i < ulFiles; i++)
+      if(FT_insertFile(ppcPaths[i], ppcContents[i],
+                       strlen(ppcContents[i]) + 1) != SUCCESS)
+         return FALSE;
+   *pdInsert = Bench_now() - dStart;
+   dStart = Bench_now();
+   if(bAfter && FT_enableTextIndex() != SUCCESS)
+      return FALSE;
+   *pdEnable = Bench_now() - dStart;
+   return TRUE;
+}
+
+/* Compares the doubles at pvFirst and pvSecond, for qsort. */
+static int TextBench_compare(const void *pvFirst, const void *pvSecond) {
+   double dFirst = *(const double *) pvFirst;
+   double dSecond = *(const double *) pvSecond;
+
+   return (dFirst > dSecond) - (dFirst < dSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char *argv[]) {
+   size_t ulFiles = 20000, ulWords = 200, ulVocabulary = 20000;
+   size_t ulQueries = 2000, ulNumTerms, ulHits = 0, i, t;
+   char **ppcPaths, **ppcContents;
+   char aacTerms[MAX_TERMS][MAX_WORD];
+   const char *apcTerms[MAX_TERMS];
+   enum TextMode eMode;
+   DynArray_T oDResult;
+   double *pdLatencies;
+   double dStart, dPlain, dWith, dBefore, dAfter, dMegabytes;
+   double dTotal = 0.0;
+   unsigned long ulState = 1;
+   struct BenchOption asOptions[] = {
+      { 'n', "files", &ulFiles, FALSE },
+      { 'w', "words", &ulWords, FALSE },
+      { 'v', "vocabulary", &ulVocabulary, FALSE },
+      { 'q', "queries", &ulQueries, FALSE }
+   };
+
+   if(!Bench_parseOptions(argc, argv, asOptions,
+                          sizeof(asOptions) / sizeof(asOptions[0])))
+      return EXIT_FAILURE;
+
+   ppcPaths = malloc(ulFiles * sizeof(char *));
+   ppcContents = malloc(ulFiles * sizeof(char *));
+   pdLatencies = malloc(ulQueries * sizeof(double));
+   if(ppcPaths == NULL || ppcContents == NULL || pdLatencies == NULL)
+      return EXIT_FAILURE;
+   dMegabytes = 0.0;
+   for(i = 0; i < ulFiles; i++) {
+      ppcPaths[i] = malloc(BENCH_MAX_PATH);
+      ppcContents[i] = TextBench_contents(ulWords, ulVocabulary,
+                                          &ulState);
+      if(ppcPaths[i] == NULL || ppcContents[i] == NULL)
+         return EXIT_FAILURE;
+      sprintf(ppcPaths[i], "textbench/d%lu/f%lu",
+              (unsigned long) (i % NUM_DIRS), (unsigned long) i);
+      dMegabytes += (double) strlen(ppcContents[i]) / 1e6;
+   }
+
+   /* Without an index, then indexing as files arrive, then indexing
+      them all at once; the last tree is the one queried */
+   if(!TextBench_build(ppcPaths, ppcContents, ulFiles, FALSE, FALSE,
+                       &dPlain, &dAfter) ||
+      FT_destroy() != SUCCESS ||
+      !TextBench_build(ppcPaths, ppcContents, ulFiles, TRUE, FALSE,
+                       &dWith, &dAfter) ||
+      FT_destroy() != SUCCESS ||
+      !TextBench_build(ppcPaths, ppcContents, ulFiles, FALSE, TRUE,
+                       &dBefore, &dAfter)) {
+      fprintf(stderr, "%s: building the FT failed\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   printf("%lu files, %.1f MB of contents\n", (unsigned long) ulFiles,
+          dMegabytes);
+   printf("insert without index: %.1f MB/s\n", dMegabytes / dPlain);
+   printf("insert with index:    %.1f MB/s\n", dMegabytes / dWith);
+   printf("enable over the tree: %.1f MB/s\n", dMegabytes / dAfter);
+
+   for(i = 0; i < ulQueries; i++) {
+      ulNumTerms = 1 + Bench_random(&ulState) % MAX_TERMS;
+      for(t = 0; t < ulNumTerms; t++) {
+         TextBench_word(aacTerms[t], ulVocabulary, &ulState);
+         apcTerms[t] = aacTerms[t];
+      }
+      eMode = i % 2 == 0 ? TEXT_ALL : TEXT_ANY;
+
+      dStart = Bench_now();
+      if(FT_searchText("textbench", apcTerms, ulNumTerms, eMode,
+                       &oDResult) != SUCCESS)
+         return EXIT_FAILURE;
+      pdLatencies[i] = Bench_now() - dStart;
+      dTotal += pdLatencies[i];
+      ulHits += DynArray_getLength(oDResult);
+
+      if(i < NUM_CHECKED &&
+         DynArray_getLength(oDResult) !=
+         TextBench_naive(ppcContents, ulFiles, apcTerms, ulNumTerms,
+                         eMode)) {
+         fprintf(stderr, "%s: query %lu disagrees with the naive scan\n",
+                 argv[0], (unsigned long) i);
+         return EXIT_FAILURE;
+      }
+      DynArray_free(oDResult);
+   }
+   qsort(pdLatencies, ulQueries, sizeof(double), TextBench_compare);
+   printf("%lu queries, %.1f hits each\n", (unsigned long) ulQueries,
+          (double) ulHits / (double) ulQueries);
+   printf("latency mean %.1f us, p50 %.1f us, p99 %.1f us, "
+          "max %.1f us\n", dTotal / (double) ulQueries * 1e6,
+          pdLatencies[ulQueries / 2] * 1e6,
+          pdLatencies[ulQueries * 99 / 100] * 1e6,
+          pdLatencies[ulQueries - 1] * 1e6);
+
+   if(FT_destroy() != SUCCESS)
+      return EXIT_FAILURE;
+   for(i = 0; i < ulFiles; i++) {
+      free(ppcPaths[i]);
+      free(ppcContents[i]);
+   }
+   free(ppcPaths);
+   free(ppcContents);
+   free(pdLatencies);
+   return EXIT_SUCCESS;
+}
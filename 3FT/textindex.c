@@ -0,0 +1,575 @@
+/*--------------------------------------------------------------------*/
+/* textindex.c                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "textindex.h"
+
+/* The initial number of buckets in the term table */
+enum { INITIAL_BUCKETS = 256 };
+
+/* The initial size of a posting list, in bytes */
+enum { INITIAL_POSTINGS = 8 };
+
+/* Fewest dead identifiers worth a compaction */
+enum { MIN_DEAD_TO_COMPACT = 64 };
+
+/* One term and its posting list */
+struct textTerm {
+   /* Hash of the term */
+   unsigned long ulHash;
+
+   /* The posting list: identifiers in increasing order, each stored
+      as its difference from the one before (the first from 0) in
+      little-endian groups of 7 bits, high bit set on all but the
+      last group */
+   unsigned char *pucPostings;
+
+   /* Bytes of pucPostings in use and allocated */
+   size_t ulBytes;
+   size_t ulSize;
+
+   /* Number of identifiers in the list, and the last one */
+   size_t ulCount;
+   size_t ulLastId;
+
+   /* Next term in the same bucket */
+   struct textTerm *psNext;
+
+   /* The term; really as long as it needs to be */
+   char acTerm[1];
+};
+
+/* The index */
+struct textIndex {
+   /* The term table: an array of bucket chains */
+   struct textTerm **ppsBuckets;
+
+   /* Number of buckets, always a power of two, and of terms */
+   size_t ulNumBuckets;
+   size_t ulNumTerms;
+
+   /* The file node of each identifier: identifier i is at position
+      i - 1, and is dead or unattached if NULL */
+   DynArray_T oDDocs;
+
+   /* Number of dead identifiers in oDDocs */
+   size_t ulDead;
+};
+
+/* A position in a posting list during a query */
+struct textCursor {
+   /* Next byte to decode, and the end of the list */
+   const unsigned char *pucNext;
+   const unsigned char *pucEnd;
+
+   /* The identifier at the position, if not done */
+   size_t ulId;
+
+   /* Whether the list is used up */
+   boolean bIsDone;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns TRUE if c is a character that terms are made of. */
+static boolean TextIndex_isTermChar(char c) {
+   return (boolean) ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                     (c >= '0' && c <= '9'));
+}
+
+/* Returns c lowercased, if it is an ASCII capital. */
+static char TextIndex_lower(char c) {
+   return (c >= 'A' && c <= 'Z') ? (char) (c - 'A' + 'a') : c;
+}
+
+/* Returns the FNV-1a hash of the ulLength characters at pcTerm. */
+static unsigned long TextIndex_hash(const char *pcTerm, size_t ulLength) {
+   unsigned long ulHash = 2166136261UL;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++)
+      ulHash = (ulHash ^ (unsigned char) pcTerm[i]) * 16777619UL;
+   return ulHash;
+}
+
+/* Returns the term of oTIndex spelled by the ulLength characters at
+   pcTerm, whose hash is ulHash, or NULL if there is none. */
+static struct textTerm *TextIndex_find(TextIndex_T oTIndex,
+                                       const char *pcTerm,
+                                       size_t ulLength,
+                                       unsigned long ulHash) {
+   struct textTerm *psTerm;
+
+   psTerm = oTIndex->ppsBuckets[ulHash & (oTIndex->ulNumBuckets - 1)];
+   for(; psTerm != NULL; psTerm = psTerm->psNext)
+      if(psTerm->ulHash == ulHash &&
+         strncmp(psTerm->acTerm, pcTerm, ulLength) == 0 &&
+         psTerm->acTerm[ulLength] == '\0')
+         return psTerm;
+   return NULL;
+}
+
+/* Doubles the number of buckets of oTIndex, leaving it unchanged if
+   allocation fails. */
+static void TextIndex_grow(TextIndex_T oTIndex) {
+   struct textTerm **ppsNew;
+   struct textTerm *psTerm;
+   size_t ulNewNum, i;
+
+   ulNewNum = oTIndex->ulNumBuckets * 2;
+   ppsNew = calloc(ulNewNum, sizeof(struct textTerm *));
+   if(ppsNew == NULL)
+      return;
+
+   for(i = 0; i < oTIndex->ulNumBuckets; i++) {
+      while((psTerm = oTIndex->ppsBuckets[i]) != NULL) {
+         oTIndex->ppsBuckets[i] = psTerm->psNext;
+         psTerm->psNext = ppsNew[psTerm->ulHash & (ulNewNum - 1)];
+         ppsNew[psTerm->ulHash & (ulNewNum - 1)] = psTerm;
+      }
+   }
+   free(oTIndex->ppsBuckets);
+   oTIndex->ppsBuckets = ppsNew;
+   oTIndex->ulNumBuckets = ulNewNum;
+}
+
+/* Returns the term of oTIndex spelled by the ulLength characters at
+   pcTerm, adding it with an empty list if new, or NULL if allocation
+   fails. */
+static struct textTerm *TextIndex_intern(TextIndex_T oTIndex,
+                                         const char *pcTerm,
+                                         size_t ulLength) {
+   struct textTerm *psTerm;
+   unsigned long ulHash;
+   size_t ulBucket;
+
+   ulHash = TextIndex_hash(pcTerm, ulLength);
+   psTerm = TextIndex_find(oTIndex, pcTerm, ulLength, ulHash);
+   if(psTerm != NULL)
+      return psTerm;
+
+   psTerm = malloc(sizeof(struct textTerm) + ulLength);
+   if(psTerm == NULL)
+      return NULL;
+   psTerm->pucPostings = malloc(INITIAL_POSTINGS);
+   if(psTerm->pucPostings == NULL) {
+      free(psTerm);
+      return NULL;
+   }
+   psTerm->ulHash = ulHash;
+   psTerm->ulBytes = 0;
+   psTerm->ulSize = INITIAL_POSTINGS;
+   psTerm->ulCount = 0;
+   psTerm->ulLastId = 0;
+   memcpy(psTerm->acTerm, pcTerm, ulLength);
+   psTerm->acTerm[ulLength] = '\0';
+
+   ulBucket = ulHash & (oTIndex->ulNumBuckets - 1);
+   psTerm->psNext = oTIndex->ppsBuckets[ulBucket];
+   oTIndex->ppsBuckets[ulBucket] = psTerm;
+   oTIndex->ulNumTerms++;
+   if(oTIndex->ulNumTerms > oTIndex->ulNumBuckets)
+      TextIndex_grow(oTIndex);
+   return psTerm;
+}
+
+/* Stores ulValue at pucOut in variable-length form. Returns the number
+   of bytes used, at most sizeof(size_t) * 8 / 7 + 1. */
+static size_t TextIndex_encode(unsigned char *pucOut, size_t ulValue) {
+   size_t ulUsed = 0;
+
+   while(ulValue >= 0x80) {
+      pucOut[ulUsed++] = (unsigned char) ((ulValue & 0x7f) | 0x80);
+      ulValue >>= 7;
+   }
+   pucOut[ulUsed++] = (unsigned char) ulValue;
+   return ulUsed;
+}
+
+/* Decodes a variable-length value at *ppucNext, advancing past it.
+   Returns the value. */
+static size_t TextIndex_decode(const unsigned char **ppucNext) {
+   const unsigned char *puc = *ppucNext;
+   size_t ulValue = 0;
+   unsigned int uShift = 0;
+
+   do {
+      ulValue |= (size_t) (*puc & 0x7f) << uShift;
+      uShift += 7;
+   } while(*puc++ & 0x80);
+   *ppucNext = puc;
+   return ulValue;
+}
+
+/* Appends identifier ulId, which must exceed every identifier in it,
+   to psTerm's list. Returns FALSE if the list could not grow. */
+static boolean TextIndex_append(struct textTerm *psTerm, size_t ulId) {
+   unsigned char aucValue[sizeof(size_t) * 8 / 7 + 1];
+   unsigned char *pucNew;
+   size_t ulUsed, ulNewSize;
+
+   ulUsed = TextIndex_encode(aucValue, ulId - psTerm->ulLastId);
+   if(psTerm->ulSize - psTerm->ulBytes < ulUsed) {
+      ulNewSize = psTerm->ulSize * 2;
+      pucNew = realloc(psTerm->pucPostings, ulNewSize);
+      if(pucNew == NULL)
+         return FALSE;
+      psTerm->pucPostings = pucNew;
+      psTerm->ulSize = ulNewSize;
+   }
+   memcpy(psTerm->pucPostings + psTerm->ulBytes, aucValue, ulUsed);
+   psTerm->ulBytes += ulUsed;
+   psTerm->ulCount++;
+   psTerm->ulLastId = ulId;
+   return TRUE;
+}
+
+/* Unlinks and frees every term of oTIndex whose list is empty. */
+static void TextIndex_dropEmpty(TextIndex_T oTIndex) {
+   struct textTerm **ppsLink, *psTerm;
+   size_t i;
+
+   for(i = 0; i < oTIndex->ulNumBuckets; i++) {
+      ppsLink = &oTIndex->ppsBuckets[i];
+      while((psTerm = *ppsLink) != NULL) {
+         if(psTerm->ulCount != 0) {
+            ppsLink = &psTerm->psNext;
+            continue;
+         }
+         *ppsLink = psTerm->psNext;
+         free(psTerm->pucPostings);
+         free(psTerm);
+         oTIndex->ulNumTerms--;
+      }
+   }
+}
+
+/*
+  If dead identifiers outnumber live ones, renumbers the live ones
+  densely in order and rewrites every list without the dead ones.
+  Renumbering in order never widens a difference, so each list is
+  rewritten in place. Skips the compaction (leaving it for later) if
+  the renumbering table cannot be allocated, so it never fails.
+*/
+static void TextIndex_maybeCompact(TextIndex_T oTIndex) {
+   struct textTerm *psTerm;
+   const unsigned char *pucRead, *pucEnd;
+   size_t *pulNewIds;
+   size_t ulNumDocs, ulLive = 0, ulOldId = 0, ulNewId, ulWritten;
+   size_t ulLastNew, ulCount, i;
+   NodeF_T oNfDoc;
+
+   ulNumDocs = DynArray_getLength(oTIndex->oDDocs);
+   if(oTIndex->ulDead < MIN_DEAD_TO_COMPACT ||
+      oTIndex->ulDead * 2 <= ulNumDocs)
+      return;
+   pulNewIds = malloc(ulNumDocs * sizeof(size_t));
+   if(pulNewIds == NULL)
+      return;
+
+   /* The new identifier of each old one, 0 if dead */
+   for(i = 0; i < ulNumDocs; i++)
+      pulNewIds[i] = DynArray_get(oTIndex->oDDocs, i) == NULL ?
+                     0 : ++ulLive;
+
+   for(i = 0; i < oTIndex->ulNumBuckets; i++) {
+      for(psTerm = oTIndex->ppsBuckets[i]; psTerm != NULL;
+          psTerm = psTerm->psNext) {
+         pucRead = psTerm->pucPostings;
+         pucEnd = pucRead + psTerm->ulBytes;
+         ulOldId = 0;
+         ulLastNew = 0;
+         ulWritten = 0;
+         ulCount = 0;
+         while(pucRead < pucEnd) {
+            ulOldId += TextIndex_decode(&pucRead);
+            ulNewId = pulNewIds[ulOldId - 1];
+            if(ulNewId == 0)
+               continue;
+            ulWritten += TextIndex_encode(psTerm->pucPostings + ulWritten,
+                                          ulNewId - ulLastNew);
+            ulLastNew = ulNewId;
+            ulCount++;
+         }
+         psTerm->ulBytes = ulWritten;
+         psTerm->ulCount = ulCount;
+         psTerm->ulLastId = ulLastNew;
+      }
+   }
+   TextIndex_dropEmpty(oTIndex);
+
+   /* Move the live file nodes down to their new positions */
+   for(i = 0; i < ulNumDocs; i++) {
+      if(pulNewIds[i] == 0)
+         continue;
+      oNfDoc = DynArray_get(oTIndex->oDDocs, i);
+      (void) DynArray_set(oTIndex->oDDocs, pulNewIds[i] - 1, oNfDoc);
+      NodeF_setTextId(oNfDoc, pulNewIds[i]);
+   }
+   while(DynArray_getLength(oTIndex->oDDocs) > ulLive)
+      (void) DynArray_removeAt(oTIndex->oDDocs,
+                               DynArray_getLength(oTIndex->oDDocs) - 1);
+   oTIndex->ulDead = 0;
+   free(pulNewIds);
+}
+
+/* Normalizes the query term pcTerm into acOut (TEXT_MAX_TERM + 1
+   bytes). Returns its length, or 0 if pcTerm is not a single term. */
+static size_t TextIndex_normalize(const char *pcTerm, char *acOut) {
+   size_t ulLength = 0;
+
+   for(; *pcTerm != '\0'; pcTerm++) {
+      if(!TextIndex_isTermChar(*pcTerm))
+         return 0;
+      if(ulLength < TEXT_MAX_TERM)
+         acOut[ulLength++] = TextIndex_lower(*pcTerm);
+   }
+   acOut[ulLength] = '\0';
+   return ulLength;
+}
+
+/* Moves psCursor to its list's next identifier. */
+static void TextIndex_advance(struct textCursor *psCursor) {
+   if(psCursor->pucNext >= psCursor->pucEnd) {
+      psCursor->bIsDone = TRUE;
+      return;
+   }
+   psCursor->ulId += TextIndex_decode(&psCursor->pucNext);
+}
+
+/* Appends the live file node with identifier ulId, if any, to
+   oDResult. Returns FALSE if oDResult could not grow. */
+static boolean TextIndex_emit(TextIndex_T oTIndex, size_t ulId,
+                              DynArray_T oDResult) {
+   NodeF_T oNfDoc;
+
+   oNfDoc = DynArray_get(oTIndex->oDDocs, ulId - 1);
+   if(oNfDoc == NULL)
+      return TRUE;
+   return (boolean) DynArray_add(oDResult, oNfDoc);
+}
+
+/* ================================================================== */
+TextIndex_T TextIndex_new(void) {
+   TextIndex_T oTIndex;
+
+   oTIndex = malloc(sizeof(struct textIndex));
+   if(oTIndex == NULL)
+      return NULL;
+   oTIndex->ppsBuckets = calloc(INITIAL_BUCKETS,
+                                sizeof(struct textTerm *));
+   oTIndex->oDDocs = DynArray_new(0);
+   if(oTIndex->ppsBuckets == NULL || oTIndex->oDDocs == NULL) {
+      free(oTIndex->ppsBuckets);
+      if(oTIndex->oDDocs != NULL)
+         DynArray_free(oTIndex->oDDocs);
+      free(oTIndex);
+      return NULL;
+   }
+   oTIndex->ulNumBuckets = INITIAL_BUCKETS;
+   oTIndex->ulNumTerms = 0;
+   oTIndex->ulDead = 0;
+   return oTIndex;
+}
+
+/* ================================================================== */
+void TextIndex_free(TextIndex_T oTIndex) {
+   struct textTerm *psTerm;
+   size_t i;
+
+   assert(oTIndex != NULL);
+
+   for(i = 0; i < oTIndex->ulNumBuckets; i++) {
+      while((psTerm = oTIndex->ppsBuckets[i]) != NULL) {
+         oTIndex->ppsBuckets[i] = psTerm->psNext;
+         free(psTerm->pucPostings);
+         free(psTerm);
+      }
+   }
+   free(oTIndex->ppsBuckets);
+   DynArray_free(oTIndex->oDDocs);
+   free(oTIndex);
+}
+
+/* ================================================================== */
+int TextIndex_add(TextIndex_T oTIndex, const void *pvContents,
+                  size_t ulLength, size_t *pulId) {
+   const char *pcContents = pvContents;
+   char acTerm[TEXT_MAX_TERM + 1];
+   struct textTerm *psTerm;
+   size_t ulId, ulTermLength, i;
+
+   assert(oTIndex != NULL);
+   assert(pulId != NULL);
+
+   /* Reserve the identifier; it stays NULL, and so is ignored by
+      queries, until bound */
+   if(!DynArray_add(oTIndex->oDDocs, NULL))
+      return MEMORY_ERROR;
+   ulId = DynArray_getLength(oTIndex->oDDocs);
+   *pulId = ulId;
+   if(pcContents == NULL)
+      return SUCCESS;
+
+   /* The identifier is the largest yet, so a list already holding it
+      got it from an earlier occurrence in these contents */
+   i = 0;
+   while(i < ulLength) {
+      if(!TextIndex_isTermChar(pcContents[i])) {
+         i++;
+         continue;
+      }
+      ulTermLength = 0;
+      for(; i < ulLength && TextIndex_isTermChar(pcContents[i]); i++)
+         if(ulTermLength < TEXT_MAX_TERM)
+            acTerm[ulTermLength++] = TextIndex_lower(pcContents[i]);
+
+      psTerm = TextIndex_intern(oTIndex, acTerm, ulTermLength);
+      if(psTerm == NULL ||
+         (psTerm->ulLastId != ulId && !TextIndex_append(psTerm, ulId))) {
+         /* Lists that did get ulId will skip it as dead */
+         oTIndex->ulDead++;
+         return MEMORY_ERROR;
+      }
+   }
+   return SUCCESS;
+}
+
+/* ================================================================== */
+void TextIndex_bind(TextIndex_T oTIndex, NodeF_T oNfNode, size_t ulId) {
+   size_t ulOldId;
+
+   assert(oTIndex != NULL);
+   assert(oNfNode != NULL);
+   assert(ulId >= 1 && ulId <= DynArray_getLength(oTIndex->oDDocs));
+
+   ulOldId = NodeF_getTextId(oNfNode);
+   if(ulOldId != 0) {
+      (void) DynArray_set(oTIndex->oDDocs, ulOldId - 1, NULL);
+      oTIndex->ulDead++;
+   }
+   (void) DynArray_set(oTIndex->oDDocs, ulId - 1, oNfNode);
+   NodeF_setTextId(oNfNode, ulId);
+   TextIndex_maybeCompact(oTIndex);
+}
+
+/* ================================================================== */
+void TextIndex_discard(TextIndex_T oTIndex, size_t ulId) {
+   assert(oTIndex != NULL);
+   assert(ulId >= 1 && ulId <= DynArray_getLength(oTIndex->oDDocs));
+
+   oTIndex->ulDead++;
+   TextIndex_maybeCompact(oTIndex);
+}
+
+/* ================================================================== */
+void TextIndex_remove(TextIndex_T oTIndex, NodeF_T oNfNode) {
+   size_t ulId;
+
+   assert(oTIndex != NULL);
+   assert(oNfNode != NULL);
+
+   ulId = NodeF_getTextId(oNfNode);
+   if(ulId == 0)
+      return;
+   (void) DynArray_set(oTIndex->oDDocs, ulId - 1, NULL);
+   NodeF_setTextId(oNfNode, 0);
+   oTIndex->ulDead++;
+   TextIndex_maybeCompact(oTIndex);
+}
+
+/* ================================================================== */
+int TextIndex_query(TextIndex_T oTIndex, const char **ppcTerms,
+                    size_t ulNumTerms, enum TextMode eMode,
+                    DynArray_T oDResult) {
+   char acTerm[TEXT_MAX_TERM + 1];
+   struct textCursor *psCursors;
+   struct textTerm *psTerm;
+   size_t ulNumCursors = 0, ulLength, ulTarget, i;
+   boolean bIsAll, bIsOk = TRUE;
+
+   assert(oTIndex != NULL);
+   assert(ppcTerms != NULL || ulNumTerms == 0);
+   assert(oDResult != NULL);
+
+   if(ulNumTerms == 0)
+      return SUCCESS;
+   psCursors = malloc(ulNumTerms * sizeof(struct textCursor));
+   if(psCursors == NULL)
+      return MEMORY_ERROR;
+
+   /* Open a cursor on each term's list; under TEXT_ALL, a missing
+      term means no file matches */
+   for(i = 0; i < ulNumTerms; i++) {
+      assert(ppcTerms[i] != NULL);
+      ulLength = TextIndex_normalize(ppcTerms[i], acTerm);
+      psTerm = ulLength == 0 ? NULL :
+               TextIndex_find(oTIndex, acTerm, ulLength,
+                              TextIndex_hash(acTerm, ulLength));
+      if(psTerm == NULL) {
+         if(eMode == TEXT_ALL) {
+            free(psCursors);
+            return SUCCESS;
+         }
+         continue;
+      }
+      psCursors[ulNumCursors].pucNext = psTerm->pucPostings;
+      psCursors[ulNumCursors].pucEnd = psTerm->pucPostings +
+                                       psTerm->ulBytes;
+      psCursors[ulNumCursors].ulId = 0;
+      psCursors[ulNumCursors].bIsDone = FALSE;
+      TextIndex_advance(&psCursors[ulNumCursors]);
+      ulNumCursors++;
+   }
+
+   if(eMode == TEXT_ALL) {
+      /* Leapfrog: advance every list to the largest current
+         identifier until all agree or one runs out */
+      while(bIsOk && ulNumCursors != 0) {
+         ulTarget = 0;
+         for(i = 0; i < ulNumCursors; i++)
+            if(psCursors[i].ulId > ulTarget)
+               ulTarget = psCursors[i].ulId;
+         bIsAll = TRUE;
+         for(i = 0; i < ulNumCursors; i++) {
+            while(!psCursors[i].bIsDone && psCursors[i].ulId < ulTarget)
+               TextIndex_advance(&psCursors[i]);
+            if(psCursors[i].bIsDone)
+               break;
+            if(psCursors[i].ulId != ulTarget)
+               bIsAll = FALSE;
+         }
+         if(i < ulNumCursors)
+            break;
+         if(!bIsAll)
+            continue;
+         bIsOk = TextIndex_emit(oTIndex, ulTarget, oDResult);
+         for(i = 0; i < ulNumCursors; i++)
+            TextIndex_advance(&psCursors[i]);
+      }
+   }
+   else {
+      /* Merge: emit the smallest current identifier, then advance
+         every list at it */
+      while(bIsOk) {
+         ulTarget = 0;
+         for(i = 0; i < ulNumCursors; i++)
+            if(!psCursors[i].bIsDone &&
+               (ulTarget == 0 || psCursors[i].ulId < ulTarget))
+               ulTarget = psCursors[i].ulId;
+         if(ulTarget == 0)
+            break;
+         bIsOk = TextIndex_emit(oTIndex, ulTarget, oDResult);
+         for(i = 0; i < ulNumCursors; i++)
+            if(!psCursors[i].bIsDone && psCursors[i].ulId == ulTarget)
+               TextIndex_advance(&psCursors[i]);
+      }
+   }
+
+   free(psCursors);
+   return bIsOk ? SUCCESS : MEMORY_ERROR;
+}
@@ -0,0 +1,83 @@
+/*--------------------------------------------------------------------*/
+/* textindex.h                                                        */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef TEXTINDEX_INCLUDED
+#define TEXTINDEX_INCLUDED
+
+/*
+  A text index is an inverted index over the contents of file nodes:
+  for each term, the list of the identifiers of the files holding it.
+  A term is a run of ASCII letters and digits, lowercased and cut to
+  TEXT_MAX_TERM characters. Identifiers are handed out in increasing
+  order, so each posting list is kept sorted by appending, and stored
+  as the differences between neighbours in variable-length bytes.
+
+  Removing a file only marks its identifier dead; once dead
+  identifiers outnumber live ones, every list is compacted in place
+  and the live identifiers renumbered densely.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "dynarray.h"
+#include "nodef.h"
+
+/* A TextIndex_T is an inverted index over file contents */
+typedef struct textIndex *TextIndex_T;
+
+/* Longest term indexed; longer runs are cut to this many characters */
+enum { TEXT_MAX_TERM = 32 };
+
+/* Ways a query combines its terms */
+enum TextMode {
+   /* Files holding every term */
+   TEXT_ALL,
+
+   /* Files holding at least one term */
+   TEXT_ANY
+};
+
+/* Returns a new, empty text index, or NULL if insufficient memory is
+   available. */
+TextIndex_T TextIndex_new(void);
+
+/* Destroys oTIndex. The file nodes it refers to keep their (now
+   meaningless) identifiers and are not freed. */
+void TextIndex_free(TextIndex_T oTIndex);
+
+/*
+  Tokenizes the ulLength bytes at pvContents (nothing if NULL) into
+  oTIndex under a new identifier, stored in *pulId, which stays
+  unattached until passed to TextIndex_bind or TextIndex_discard; no
+  other call may come between. Returns SUCCESS, or MEMORY_ERROR (in
+  which case nothing needs undoing) if allocation fails.
+*/
+int TextIndex_add(TextIndex_T oTIndex, const void *pvContents,
+                  size_t ulLength, size_t *pulId);
+
+/*
+  Attaches identifier ulId, from TextIndex_add, to oNfNode, replacing
+  the identifier oNfNode held (if any). Never fails.
+*/
+void TextIndex_bind(TextIndex_T oTIndex, NodeF_T oNfNode, size_t ulId);
+
+/* Abandons identifier ulId, from TextIndex_add. Never fails. */
+void TextIndex_discard(TextIndex_T oTIndex, size_t ulId);
+
+/* Removes oNfNode, if indexed, from oTIndex. Never fails. */
+void TextIndex_remove(TextIndex_T oTIndex, NodeF_T oNfNode);
+
+/*
+  Appends to oDResult, in identifier order, every indexed file node
+  whose contents hold all (eMode TEXT_ALL) or any (TEXT_ANY) of the
+  ulNumTerms terms in ppcTerms. Query terms are normalized like
+  contents; one that is not a single term matches nothing. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int TextIndex_query(TextIndex_T oTIndex, const char **ppcTerms,
+                    size_t ulNumTerms, enum TextMode eMode,
+                    DynArray_T oDResult);
+
+#endif
@@ -0,0 +1,263 @@
+/*--------------------------------------------------------------------*/
+/* timerwheel.c                                                       */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "timerwheel.h"
+
+/* Levels of the wheel, and slots per level (a power of two) */
+enum { LEVELS = 4, SLOT_BITS = 6, SLOTS = 1 << SLOT_BITS };
+
+/* Values of a node's uSlot: no deadline, due, beyond the top level,
+   and the first wheel slot; level l slot s is FIRST_SLOT + l*SLOTS+s */
+enum { NO_SLOT, DUE_SLOT, FAR_SLOT, FIRST_SLOT };
+
+/* Number of lists, one per uSlot value other than NO_SLOT */
+enum { NUM_LISTS = FIRST_SLOT - 1 + LEVELS * SLOTS };
+
+/* A list of nodes, linked through their NodeFTimer records */
+struct timerList {
+   NodeF_T oNfHead;
+   NodeF_T oNfTail;
+};
+
+/* The wheel */
+struct timerWheel {
+   /* Time up to which every deadline has been made due */
+   unsigned long ulNow;
+
+   /* The lists: the one for uSlot u is asLists[u - 1] */
+   struct timerList asLists[NUM_LISTS];
+
+   /* Nodes on each level, on the FAR_SLOT list, and due */
+   size_t aulLevelCounts[LEVELS];
+   size_t ulFarCount;
+   size_t ulDueCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the level of wheel slot uSlot, or LEVELS for FAR_SLOT, or
+   -1 for DUE_SLOT. */
+static int TimerWheel_levelOf(unsigned int uSlot) {
+   if(uSlot == DUE_SLOT)
+      return -1;
+   if(uSlot == FAR_SLOT)
+      return LEVELS;
+   return (int) ((uSlot - FIRST_SLOT) / SLOTS);
+}
+
+/* Adjusts the count of the list for uSlot by iDelta. */
+static void TimerWheel_count(TimerWheel_T oTWheel, unsigned int uSlot,
+                             int iDelta) {
+   int iLevel = TimerWheel_levelOf(uSlot);
+
+   if(iLevel < 0)
+      oTWheel->ulDueCount += (size_t) (long) iDelta;
+   else if(iLevel == LEVELS)
+      oTWheel->ulFarCount += (size_t) (long) iDelta;
+   else
+      oTWheel->aulLevelCounts[iLevel] += (size_t) (long) iDelta;
+}
+
+/* Appends oNfNode, on no list, to the list for uSlot. */
+static void TimerWheel_append(TimerWheel_T oTWheel, NodeF_T oNfNode,
+                              unsigned int uSlot) {
+   struct timerList *psList = &oTWheel->asLists[uSlot - 1];
+   struct NodeFTimer *psTimer = NodeF_getTimer(oNfNode);
+
+   psTimer->uSlot = uSlot;
+   psTimer->oNfPrev = psList->oNfTail;
+   psTimer->oNfNext = NULL;
+   if(psList->oNfTail != NULL)
+      NodeF_getTimer(psList->oNfTail)->oNfNext = oNfNode;
+   else
+      psList->oNfHead = oNfNode;
+   psList->oNfTail = oNfNode;
+   TimerWheel_count(oTWheel, uSlot, 1);
+}
+
+/* Unlinks oNfNode from the list it is on. */
+static void TimerWheel_unlink(TimerWheel_T oTWheel, NodeF_T oNfNode) {
+   struct NodeFTimer *psTimer = NodeF_getTimer(oNfNode);
+   struct timerList *psList = &oTWheel->asLists[psTimer->uSlot - 1];
+
+   if(psTimer->oNfPrev != NULL)
+      NodeF_getTimer(psTimer->oNfPrev)->oNfNext = psTimer->oNfNext;
+   else
+      psList->oNfHead = psTimer->oNfNext;
+   if(psTimer->oNfNext != NULL)
+      NodeF_getTimer(psTimer->oNfNext)->oNfPrev = psTimer->oNfPrev;
+   else
+      psList->oNfTail = psTimer->oNfPrev;
+   TimerWheel_count(oTWheel, psTimer->uSlot, -1);
+   psTimer->uSlot = NO_SLOT;
+   psTimer->oNfPrev = NULL;
+   psTimer->oNfNext = NULL;
+}
+
+/*
+  Puts oNfNode, on no list, on the list for its deadline: due if it
+  has passed, else the lowest level whose next SLOTS slots (counting
+  from the one after the current one) reach it, else FAR_SLOT.
+*/
+static void TimerWheel_place(TimerWheel_T oTWheel, NodeF_T oNfNode) {
+   unsigned long ulDeadline = NodeF_getTimer(oNfNode)->ulDeadline;
+   unsigned int uShift;
+   int iLevel;
+
+   if(ulDeadline <= oTWheel->ulNow) {
+      TimerWheel_append(oTWheel, oNfNode, DUE_SLOT);
+      return;
+   }
+   for(iLevel = 0; iLevel < LEVELS; iLevel++) {
+      uShift = (unsigned int) iLevel * SLOT_BITS;
+      if((ulDeadline >> uShift) - (oTWheel->ulNow >> uShift) <= SLOTS) {
+         TimerWheel_append(oTWheel, oNfNode, FIRST_SLOT +
+            (unsigned int) iLevel * SLOTS +
+            (unsigned int) ((ulDeadline >> uShift) & (SLOTS - 1)));
+         return;
+      }
+   }
+   TimerWheel_append(oTWheel, oNfNode, FAR_SLOT);
+}
+
+/* Re-places every node on the list for uSlot against the wheel's
+   current time. */
+static void TimerWheel_cascade(TimerWheel_T oTWheel, unsigned int uSlot) {
+   struct timerList *psList = &oTWheel->asLists[uSlot - 1];
+   NodeF_T oNfNode, oNfNext;
+
+   oNfNode = psList->oNfHead;
+   psList->oNfHead = NULL;
+   psList->oNfTail = NULL;
+   for(; oNfNode != NULL; oNfNode = oNfNext) {
+      oNfNext = NodeF_getTimer(oNfNode)->oNfNext;
+      TimerWheel_count(oTWheel, uSlot, -1);
+      TimerWheel_place(oTWheel, oNfNode);
+   }
+}
+
+/* Processes tick ulTick, which is after the wheel's time: cascades the
+   slots that start at it, from the top level down, then makes the
+   nodes of its level 0 slot due. */
+static void TimerWheel_tick(TimerWheel_T oTWheel, unsigned long ulTick) {
+   unsigned int uShift;
+   int iLevel;
+
+   oTWheel->ulNow = ulTick - 1;
+   if((ulTick & ((1UL << (LEVELS * SLOT_BITS)) - 1)) == 0)
+      TimerWheel_cascade(oTWheel, FAR_SLOT);
+   for(iLevel = LEVELS - 1; iLevel >= 1; iLevel--) {
+      uShift = (unsigned int) iLevel * SLOT_BITS;
+      if((ulTick & ((1UL << uShift) - 1)) == 0)
+         TimerWheel_cascade(oTWheel, FIRST_SLOT +
+            (unsigned int) iLevel * SLOTS +
+            (unsigned int) ((ulTick >> uShift) & (SLOTS - 1)));
+   }
+   oTWheel->ulNow = ulTick;
+   TimerWheel_cascade(oTWheel, FIRST_SLOT +
+                      (unsigned int) (ulTick & (SLOTS - 1)));
+}
+
+/* ================================================================== */
+TimerWheel_T TimerWheel_new(unsigned long ulNow) {
+   TimerWheel_T oTWheel;
+   size_t i;
+
+   oTWheel = malloc(sizeof(struct timerWheel));
+   if(oTWheel == NULL)
+      return NULL;
+   oTWheel->ulNow = ulNow;
+   for(i = 0; i < NUM_LISTS; i++) {
+      oTWheel->asLists[i].oNfHead = NULL;
+      oTWheel->asLists[i].oNfTail = NULL;
+   }
+   for(i = 0; i < LEVELS; i++)
+      oTWheel->aulLevelCounts[i] = 0;
+   oTWheel->ulFarCount = 0;
+   oTWheel->ulDueCount = 0;
+   return oTWheel;
+}
+
+/* ================================================================== */
+void TimerWheel_free(TimerWheel_T oTWheel) {
+   assert(oTWheel != NULL);
+
+   free(oTWheel);
+}
+
+/* ================================================================== */
+void TimerWheel_schedule(TimerWheel_T oTWheel, NodeF_T oNfNode,
+                         unsigned long ulDeadline) {
+   assert(oTWheel != NULL);
+   assert(oNfNode != NULL);
+
+   TimerWheel_cancel(oTWheel, oNfNode);
+   NodeF_getTimer(oNfNode)->ulDeadline = ulDeadline;
+   TimerWheel_place(oTWheel, oNfNode);
+}
+
+/* ================================================================== */
+void TimerWheel_cancel(TimerWheel_T oTWheel, NodeF_T oNfNode) {
+   assert(oTWheel != NULL);
+   assert(oNfNode != NULL);
+
+   if(NodeF_getTimer(oNfNode)->uSlot != NO_SLOT)
+      TimerWheel_unlink(oTWheel, oNfNode);
+   NodeF_getTimer(oNfNode)->ulDeadline = 0;
+}
+
+/* ================================================================== */
+void TimerWheel_advance(TimerWheel_T oTWheel, unsigned long ulNow) {
+   unsigned long ulSpan, ulNext;
+   int iLevel;
+
+   assert(oTWheel != NULL);
+
+   while(oTWheel->ulNow < ulNow) {
+      /* With the lower levels empty, nothing happens before the next
+         slot boundary of the lowest occupied level */
+      for(iLevel = 0; iLevel < LEVELS; iLevel++)
+         if(oTWheel->aulLevelCounts[iLevel] != 0)
+            break;
+      if(iLevel == LEVELS && oTWheel->ulFarCount == 0) {
+         oTWheel->ulNow = ulNow;
+         break;
+      }
+      ulSpan = 1UL << ((unsigned int) iLevel * SLOT_BITS);
+      ulNext = (oTWheel->ulNow | (ulSpan - 1)) + 1;
+      if(ulNext == 0 || ulNext > ulNow) {
+         oTWheel->ulNow = ulNow;
+         break;
+      }
+      TimerWheel_tick(oTWheel, ulNext);
+   }
+}
+
+/* ================================================================== */
+NodeF_T TimerWheel_popDue(TimerWheel_T oTWheel) {
+   NodeF_T oNfNode;
+
+   assert(oTWheel != NULL);
+
+   oNfNode = oTWheel->asLists[DUE_SLOT - 1].oNfHead;
+   if(oNfNode != NULL)
+      TimerWheel_cancel(oTWheel, oNfNode);
+   return oNfNode;
+}
+
+/* ================================================================== */
+size_t TimerWheel_getLength(TimerWheel_T oTWheel) {
+   size_t ulLength;
+   int iLevel;
+
+   assert(oTWheel != NULL);
+
+   ulLength = oTWheel->ulFarCount + oTWheel->ulDueCount;
+   for(iLevel = 0; iLevel < LEVELS; iLevel++)
+      ulLength += oTWheel->aulLevelCounts[iLevel];
+   return ulLength;
+}
@@ -0,0 +1,62 @@
+/*--------------------------------------------------------------------*/
+/* timerwheel.h                                                       */
+/* Author: Will Huang and George Tziampazis                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef TIMERWHEEL_INCLUDED
+#define TIMERWHEEL_INCLUDED
+
+/*
+  A timer wheel holds file nodes until their deadlines, in a client's
+  units of time (seconds, say), which only move forward. It has four
+  levels of 64 slots, each slot spanning 64 times the time of a slot
+  of the level below, and a list of nodes due further out than the
+  top level reaches. A node sits in the lowest level whose reach
+  covers its deadline, and is moved down (cascaded) as time reaches
+  its slot, so setting, clearing and expiring a deadline each cost
+  O(1), apart from the occasional cascade. The nodes are linked
+  through their own NodeFTimer records, so nothing allocates or fails
+  once the wheel exists.
+*/
+
+#include <stddef.h>
+#include "a4def.h"
+#include "nodef.h"
+
+/* A TimerWheel_T holds file nodes by deadline */
+typedef struct timerWheel *TimerWheel_T;
+
+/* Returns a new, empty timer wheel whose time is ulNow, or NULL if
+   insufficient memory is available. */
+TimerWheel_T TimerWheel_new(unsigned long ulNow);
+
+/* Destroys oTWheel. The file nodes it refers to are neither freed nor
+   touched, so they may already have been freed. */
+void TimerWheel_free(TimerWheel_T oTWheel);
+
+/*
+  Gives oNfNode the deadline ulDeadline, replacing any it had. A
+  deadline no later than the wheel's time makes the node due at once.
+*/
+void TimerWheel_schedule(TimerWheel_T oTWheel, NodeF_T oNfNode,
+                         unsigned long ulDeadline);
+
+/* Clears oNfNode's deadline, if it has one. */
+void TimerWheel_cancel(TimerWheel_T oTWheel, NodeF_T oNfNode);
+
+/*
+  Moves oTWheel's time forward to ulNow (not back), making every node
+  whose deadline is no later than ulNow due. Skips spans with nothing
+  to cascade, so its cost depends on the nodes moved rather than on
+  how far time moves.
+*/
+void TimerWheel_advance(TimerWheel_T oTWheel, unsigned long ulNow);
+
+/* Clears the deadline of a due node and returns it, or returns NULL
+   if no node is due. Nodes are returned in the order they fell due. */
+NodeF_T TimerWheel_popDue(TimerWheel_T oTWheel);
+
+/* Returns the number of nodes in oTWheel, due or not. */
+size_t TimerWheel_getLength(TimerWheel_T oTWheel);
+
+#endif